@@ -123,6 +123,15 @@ void CameraTest::Setup() {
       log_telem_.Create("Camera/Pos/Y", -10, -10000, 10, 10000, true).value();
   t_camera_z_ =
       log_telem_.Create("Camera/Pos/Z", -10, -10000, 10, 10000, true).value();
+  t_cull_tested_ =
+      log_telem_.Create("Camera/Culling/Tested", 0, 0, 1000, 100000, true)
+          .value();
+  t_cull_visible_ =
+      log_telem_.Create("Camera/Culling/Visible", 0, 0, 1000, 100000, true)
+          .value();
+  t_cull_percent_ =
+      log_telem_.Create("Camera/Culling/Culled %", 0, 0, 100, 100, true)
+          .value();
   //  cube_ = _3D::Model(renderer_, fs_, "cube");
   //  cube_.Move(kCubePosition);
   //  cube_.Scale(kCubeScale);
@@ -179,6 +188,12 @@ void CameraTest::Render() {
   camera_.view_ = view;
   camera_.projection_ = projection;
   renderer_.EnableDepthTesting();
+
+  const auto& cull_stats = camera_.GetCullStats();
+  t_cull_tested_.Add(static_cast<double>(cull_stats.tested));
+  t_cull_visible_.Add(static_cast<double>(cull_stats.visible));
+  t_cull_percent_.Add(cull_stats.CulledPercent());
+  camera_.ResetCullStats();
 }
 
 void CameraTest::Tick() {}
@@ -81,6 +81,9 @@ class CameraTest final : public game_engine::GameCore<CameraTest> {
   logging::TelemetryChannelHandle t_camera_x_{};
   logging::TelemetryChannelHandle t_camera_y_{};
   logging::TelemetryChannelHandle t_camera_z_{};
+  logging::TelemetryChannelHandle t_cull_tested_{};
+  logging::TelemetryChannelHandle t_cull_visible_{};
+  logging::TelemetryChannelHandle t_cull_percent_{};
 
   _3D::Camera camera_;
   //  _3D::Skybox skybox_;
@@ -0,0 +1,190 @@
+/******************************************************************************
+ * BakedFont.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "2D/BakedFont.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+#include <utility>
+
+namespace game_engine::_2D {
+
+namespace {
+
+template <typename T>
+T Read(const std::string_view data, const std::size_t offset) {
+  T value;
+  std::memcpy(&value, data.data() + offset, sizeof(T));
+  return value;
+}
+
+template <typename T>
+void Append(std::string& data, const T& value) {
+  data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+}  // namespace
+
+std::optional<BakedFont> BakedFont::Open(const std::string_view data) {
+  if (data.size() < sizeof(BakedFontHeader)) {
+    return std::nullopt;
+  }
+  BakedFont font;
+  font.header_ = Read<BakedFontHeader>(data, 0);
+  font.data_ = data;
+  const BakedFontHeader& header = font.header_;
+  if (header.magic != kMagic || header.version != kVersion ||
+      header.page_width <= 0 || header.page_height <= 0 ||
+      header.cell_size <= 0 || header.baked_page_count > header.page_count ||
+      header.baked_height < 0 || header.baked_height > header.page_height ||
+      header.mip_levels < 1 || header.mip_levels > 16) {
+    return std::nullopt;
+  }
+  const std::int32_t level_mask = (1 << (header.mip_levels - 1)) - 1;
+  if ((header.page_width & level_mask) != 0 ||
+      (header.page_height & level_mask) != 0 ||
+      (header.baked_height & level_mask) != 0) {
+    return std::nullopt;
+  }
+  if (data.size() != font.PixelsOffset() + font.GetPixelBytes()) {
+    return std::nullopt;
+  }
+  return font;
+}
+
+std::string BakedFont::Write(BakedFontHeader header,
+                             std::vector<BakedGlyph> glyphs,
+                             std::vector<BakedKerning> kerning,
+                             const std::uint8_t* pixels) {
+  std::sort(glyphs.begin(), glyphs.end(),
+            [](const BakedGlyph& a, const BakedGlyph& b) {
+              return a.code_point < b.code_point;
+            });
+  std::sort(kerning.begin(), kerning.end(),
+            [](const BakedKerning& a, const BakedKerning& b) {
+              return std::tie(a.left, a.right) < std::tie(b.left, b.right);
+            });
+  header.magic = kMagic;
+  header.version = kVersion;
+  header.glyph_count = static_cast<std::uint32_t>(glyphs.size());
+  header.kerning_count = static_cast<std::uint32_t>(kerning.size());
+
+  std::string data;
+  Append(data, header);
+  for (const BakedGlyph& glyph : glyphs) {
+    Append(data, glyph);
+  }
+  for (const BakedKerning& pair : kerning) {
+    Append(data, pair);
+  }
+  data.append(reinterpret_cast<const char*>(pixels), PixelBytes(header));
+  return data;
+}
+
+BakedGlyph BakedFont::GetGlyph(const std::size_t index) const {
+  return Read<BakedGlyph>(data_, GlyphsOffset() + index * sizeof(BakedGlyph));
+}
+
+std::optional<BakedGlyph> BakedFont::FindGlyph(
+    const char32_t code_point) const {
+  std::size_t first = 0;
+  std::size_t last = GetGlyphCount();
+  while (first < last) {
+    const std::size_t middle = first + (last - first) / 2;
+    const BakedGlyph glyph = GetGlyph(middle);
+    if (glyph.code_point == code_point) {
+      return glyph;
+    } else if (glyph.code_point < code_point) {
+      first = middle + 1;
+    } else {
+      last = middle;
+    }
+  }
+  return std::nullopt;
+}
+
+float BakedFont::GetKerning(const char32_t left, const char32_t right) const {
+  const std::pair<std::uint32_t, std::uint32_t> key(left, right);
+  std::size_t first = 0;
+  std::size_t last = header_.kerning_count;
+  while (first < last) {
+    const std::size_t middle = first + (last - first) / 2;
+    const BakedKerning pair = GetKerningPair(middle);
+    const auto middle_key = std::make_pair(pair.left, pair.right);
+    if (middle_key == key) {
+      return pair.offset;
+    } else if (middle_key < key) {
+      first = middle + 1;
+    } else {
+      last = middle;
+    }
+  }
+  return 0.0f;
+}
+
+const std::uint8_t* BakedFont::GetPixels(const int level) const {
+  std::size_t offset = PixelsOffset();
+  for (int i = 0; i < level; i++) {
+    offset += LevelBytes(header_, i);
+  }
+  return reinterpret_cast<const std::uint8_t*>(data_.data() + offset);
+}
+
+std::size_t BakedFont::GetPageBytes(const int level) const {
+  return static_cast<std::size_t>(header_.page_width >> level) *
+         static_cast<std::size_t>(header_.page_height >> level);
+}
+
+std::size_t BakedFont::PixelBytes(const BakedFontHeader& header) {
+  std::size_t bytes = 0;
+  for (int level = 0; level < header.mip_levels; level++) {
+    bytes += LevelBytes(header, level);
+  }
+  return bytes;
+}
+
+std::size_t BakedFont::LevelBytes(const BakedFontHeader& header,
+                                  const int level) {
+  if (header.baked_page_count == 0) {
+    return 0;
+  }
+  const std::size_t width =
+      static_cast<std::size_t>(header.page_width >> level);
+  return width * static_cast<std::size_t>(header.page_height >> level) *
+             (header.baked_page_count - 1) +
+         width * static_cast<std::size_t>(header.baked_height >> level);
+}
+
+std::size_t BakedFont::GlyphsOffset() { return sizeof(BakedFontHeader); }
+
+std::size_t BakedFont::KerningOffset() const {
+  return GlyphsOffset() + sizeof(BakedGlyph) * header_.glyph_count;
+}
+
+std::size_t BakedFont::PixelsOffset() const {
+  return KerningOffset() + sizeof(BakedKerning) * header_.kerning_count;
+}
+
+BakedKerning BakedFont::GetKerningPair(const std::size_t index) const {
+  return Read<BakedKerning>(data_,
+                            KerningOffset() + index * sizeof(BakedKerning));
+}
+
+} /* namespace game_engine::_2D */
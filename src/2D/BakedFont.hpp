@@ -0,0 +1,173 @@
+/******************************************************************************
+ * BakedFont.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_2D_BAKEDFONT_HPP_
+#define SRC_2D_BAKEDFONT_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace game_engine::_2D {
+
+/**
+ * @brief Parameters a font was baked with.  Sizes are in texels unless
+ *        stated otherwise.
+ */
+struct BakedFontHeader {
+  std::array<char, 4> magic{};
+  std::uint32_t version = 0;
+  /**
+   * @brief Height of text drawn with a scale of 1, in pixels
+   */
+  std::uint32_t pixel_size = 0;
+  /**
+   * @brief Distance field texels per em
+   */
+  std::uint32_t field_size = 0;
+  std::int32_t spread = 0;
+  std::int32_t supersample = 0;
+  std::int32_t page_width = 0;
+  std::int32_t page_height = 0;
+  std::int32_t cell_size = 0;
+  /**
+   * @brief Mip levels stored for every layer, level 0 included.  The page
+   *        size and baked_height halve evenly at every level.
+   */
+  std::int32_t mip_levels = 1;
+  /**
+   * @brief Layers of the GlyphAtlas the glyphs were placed in, including
+   *        those left empty for glyphs loaded at runtime
+   */
+  std::uint32_t page_count = 0;
+  /**
+   * @brief Layers stored in the file, the others are empty
+   */
+  std::uint32_t baked_page_count = 0;
+  /**
+   * @brief Rows of the last stored layer.  Only the rows holding glyphs are
+   *        stored, the rest of the layer is empty.
+   */
+  std::int32_t baked_height = 0;
+  std::uint32_t glyph_count = 0;
+  std::uint32_t kerning_count = 0;
+};
+
+/**
+ * @brief Metrics of a baked glyph.  Sizes are in pixels of text drawn with
+ *        a scale of 1.
+ */
+struct BakedGlyph {
+  std::uint32_t code_point = 0;
+  /**
+   * @brief GlyphAtlas cell of the distance field, or -1 if nothing is drawn
+   */
+  std::int32_t slot = -1;
+  std::array<std::int32_t, 2> field_size{};
+  std::array<float, 2> size{};
+  std::array<float, 2> bearing{};
+  float advance = 0.0f;
+};
+
+/**
+ * @brief Pen adjustment between two glyphs, in pixels of text drawn with a
+ *        scale of 1
+ */
+struct BakedKerning {
+  std::uint32_t left = 0;
+  std::uint32_t right = 0;
+  float offset = 0.0f;
+};
+
+/**
+ * @brief Read-only view of a font baked by the FontBaker tool
+ *
+ * The file is the header, the glyphs sorted by code point, the kerning pairs
+ * sorted by left then right code point, then the baked atlas layers as 8-bit
+ * distance fields, every layer of level 0 followed by every layer of each
+ * smaller mip level.  Nothing is copied out of it up front: glyphs and kerning
+ * pairs are binary searched in place and the layers can be uploaded straight
+ * from the data, so an embedded font is ready as soon as it is opened.
+ * Records are read with memcpy since embedded data has no alignment
+ * guarantee.  All fields are little endian.
+ */
+class BakedFont {
+ public:
+  static constexpr std::array<char, 4> kMagic{'G', 'E', 'F', 'N'};
+  static constexpr std::uint32_t kVersion = 2;
+
+  BakedFont() = default;
+
+  /**
+   * @brief View a baked font
+   * @param data Contents of the file.  Must outlive the view.
+   * @return Returns std::nullopt if data is not a baked font of this version
+   */
+  static std::optional<BakedFont> Open(const std::string_view data);
+  /**
+   * @brief Serialize a font.  The magic, version and counts of the header
+   *        are filled in, and the glyphs and kerning pairs are sorted.
+   * @param pixels header.mip_levels levels of header.baked_page_count layers
+   *               of header.page_width by header.page_height texels, halved
+   *               at every level, of which the last layer only needs
+   *               header.baked_height rows, also halved
+   * @return Returns the contents of the file
+   */
+  static std::string Write(BakedFontHeader header,
+                           std::vector<BakedGlyph> glyphs,
+                           std::vector<BakedKerning> kerning,
+                           const std::uint8_t* pixels);
+
+  const BakedFontHeader& GetHeader() const { return header_; }
+  std::size_t GetGlyphCount() const { return header_.glyph_count; }
+  BakedGlyph GetGlyph(const std::size_t index) const;
+  std::optional<BakedGlyph> FindGlyph(const char32_t code_point) const;
+  /**
+   * @return Returns the adjustment to add to the pen position between two
+   *         glyphs, 0 if the pair has none
+   */
+  float GetKerning(const char32_t left, const char32_t right) const;
+  /**
+   * @brief Baked atlas layers of a mip level, one after the other.  The last
+   *        one is header.baked_height >> level rows high.
+   */
+  const std::uint8_t* GetPixels(const int level = 0) const;
+  std::size_t GetPageBytes(const int level = 0) const;
+  std::size_t GetPixelBytes() const { return PixelBytes(header_); }
+
+ protected:
+  BakedFontHeader header_{};
+  std::string_view data_{};
+
+  static std::size_t PixelBytes(const BakedFontHeader& header);
+  static std::size_t LevelBytes(const BakedFontHeader& header,
+                                const int level);
+  static std::size_t GlyphsOffset();
+  std::size_t KerningOffset() const;
+  std::size_t PixelsOffset() const;
+  BakedKerning GetKerningPair(const std::size_t index) const;
+};
+
+} /* namespace game_engine::_2D */
+
+#endif /* SRC_2D_BAKEDFONT_HPP_ */
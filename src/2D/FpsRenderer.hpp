@@ -43,6 +43,7 @@ class FpsRenderer {
       text_.RenderTextRelativeToTopRight(renderer, fps_str_, 80, 50, 1.0f,
                                          text_color);
     }
+    text_.Flush(renderer);
   }
   void CalculateFps();
   void CalculateFrameTime();
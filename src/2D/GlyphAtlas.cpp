@@ -0,0 +1,126 @@
+/******************************************************************************
+ * GlyphAtlas.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "2D/GlyphAtlas.hpp"
+
+#include <algorithm>
+
+#include "3D/MipmapGenerator.hpp"
+
+namespace game_engine::_2D {
+
+GlyphAtlas::GlyphAtlas(const glm::ivec2 page_size, const int cell_size,
+                       const int page_count)
+    : page_size_(page_size), cell_size_(cell_size), page_count_(page_count) {
+  cells_ = page_size_ / cell_size_;
+  slots_.resize(static_cast<std::size_t>(cells_.x) * cells_.y * page_count_);
+  Clear();
+}
+
+std::optional<int> GlyphAtlas::Find(const char32_t code_point) const {
+  const auto it = resident_.find(code_point);
+  if (it == resident_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+std::optional<GlyphAtlas::Allocation> GlyphAtlas::Allocate(
+    const char32_t code_point, const bool pinned) {
+  Allocation allocation;
+  if (const auto resident = Find(code_point)) {
+    allocation.slot = *resident;
+  } else if (!free_.empty()) {
+    allocation.slot = free_.back();
+    free_.pop_back();
+  } else {
+    // Least recently used cell that no quad of this frame can reference
+    int victim = -1;
+    for (int i = 0; i < GetSlotCount(); i++) {
+      const Slot& slot = slots_[i];
+      if (slot.pinned || slot.last_used >= frame_) {
+        continue;
+      }
+      if (victim < 0 || slot.last_used < slots_[victim].last_used) {
+        victim = i;
+      }
+    }
+    if (victim < 0) {
+      return std::nullopt;
+    }
+    allocation.slot = victim;
+    allocation.evicted = slots_[victim].code_point;
+    resident_.erase(slots_[victim].code_point);
+    evictions_++;
+  }
+
+  Slot& slot = slots_[allocation.slot];
+  slot.code_point = code_point;
+  slot.last_used = frame_;
+  slot.used = true;
+  slot.pinned = slot.pinned || pinned;
+  resident_[code_point] = allocation.slot;
+  return allocation;
+}
+
+bool GlyphAtlas::Place(const char32_t code_point, const int slot,
+                       const bool pinned) {
+  const auto free = std::find(free_.begin(), free_.end(), slot);
+  if (free == free_.end() || Find(code_point)) {
+    return false;
+  }
+  free_.erase(free);
+  slots_[slot] = Slot{code_point, frame_, true, pinned};
+  resident_[code_point] = slot;
+  return true;
+}
+
+int GlyphAtlas::GetMipLevels() const {
+  int levels = 1;
+  while (cell_size_ > 0 && ((cell_size_ >> (levels - 1)) & 1) == 0) {
+    levels++;
+  }
+  return std::min(levels, _3D::MipmapGenerator::LevelCount(page_size_));
+}
+
+void GlyphAtlas::Clear() {
+  resident_.clear();
+  free_.clear();
+  for (int i = GetSlotCount() - 1; i >= 0; i--) {
+    slots_[i] = Slot{};
+    free_.push_back(i);
+  }
+}
+
+_3D::TextureRegion GlyphAtlas::GetRegion(const int slot,
+                                         const glm::ivec2 size) const {
+  const int per_page = cells_.x * cells_.y;
+  const int cell = slot % per_page;
+  _3D::TextureRegion region;
+  region.layer = slot / per_page;
+  region.position =
+      glm::ivec2(cell % cells_.x, cell / cells_.x) * cell_size_;
+  region.size = size;
+  region.uv_min = glm::vec2(region.position) / glm::vec2(page_size_);
+  region.uv_max =
+      glm::vec2(region.position + size) / glm::vec2(page_size_);
+  return region;
+}
+
+} /* namespace game_engine::_2D */
@@ -0,0 +1,138 @@
+/******************************************************************************
+ * GlyphAtlas.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_2D_GLYPHATLAS_HPP_
+#define SRC_2D_GLYPHATLAS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "3D/TextureAtlas.hpp"
+
+namespace game_engine::_2D {
+
+/**
+ * @brief Glyph cache over fixed-size cells in the layers of a texture array
+ *
+ * Unlike TextureAtlas, cells can be given back, so the atlas holds a bounded
+ * working set of an unbounded character set.  When every cell is taken, the
+ * glyph used least recently is evicted, never one that is pinned or was used
+ * in the current frame since quads already queued this frame may still
+ * reference it.
+ */
+class GlyphAtlas {
+ public:
+  GlyphAtlas() = default;
+  /**
+   * @param page_size Size of each layer in texels
+   * @param cell_size Size of each cell in texels, the largest glyph image
+   * @param page_count Number of layers
+   */
+  GlyphAtlas(const glm::ivec2 page_size, const int cell_size,
+             const int page_count);
+
+  struct Allocation {
+    int slot = 0;
+    /**
+     * @brief Glyph that was evicted to make room, if any
+     */
+    std::optional<char32_t> evicted{};
+  };
+
+  /**
+   * @brief Find the cell of a resident glyph
+   */
+  std::optional<int> Find(const char32_t code_point) const;
+  /**
+   * @brief Reserve a cell for a glyph and mark it used this frame
+   * @param pinned Never evict the glyph
+   * @return Returns the cell, or std::nullopt if every cell is pinned or used
+   *         this frame
+   */
+  std::optional<Allocation> Allocate(const char32_t code_point,
+                                     const bool pinned = false);
+  /**
+   * @brief Put a glyph in a given free cell, to restore a layout made by
+   *        another atlas with the same geometry
+   * @return Returns false if the cell does not exist or is taken
+   */
+  bool Place(const char32_t code_point, const int slot,
+             const bool pinned = false);
+  /**
+   * @brief Mark a cell as used this frame
+   */
+  void Touch(const int slot) { slots_[slot].last_used = frame_; }
+  void NextFrame() { frame_++; }
+  /**
+   * @brief Evict every glyph, pinned ones included
+   */
+  void Clear();
+
+  /**
+   * @brief Region of an image of a given size placed at the top left of a
+   *        cell
+   */
+  _3D::TextureRegion GetRegion(const int slot, const glm::ivec2 size) const;
+  /**
+   * @brief Number of mip levels, level 0 included, over which every cell
+   *        still starts and ends on a texel, so filtering a level never mixes
+   *        two glyphs
+   */
+  int GetMipLevels() const;
+
+  glm::ivec2 GetPageSize() const { return page_size_; }
+  int GetCellSize() const { return cell_size_; }
+  int GetPageCount() const { return page_count_; }
+  int GetSlotCount() const { return static_cast<int>(slots_.size()); }
+  std::size_t GetResidentCount() const { return resident_.size(); }
+  std::uint64_t GetEvictionCount() const { return evictions_; }
+
+ protected:
+  struct Slot {
+    char32_t code_point = 0;
+    std::uint64_t last_used = 0;
+    bool used = false;
+    bool pinned = false;
+  };
+
+  glm::ivec2 page_size_{0, 0};
+  int cell_size_ = 0;
+  int page_count_ = 0;
+  /**
+   * @brief Cells per row and per layer
+   */
+  glm::ivec2 cells_{0, 0};
+  std::uint64_t frame_ = 1;
+  std::uint64_t evictions_ = 0;
+  std::vector<Slot> slots_{};
+  /**
+   * @brief Unused cells, the lowest index last
+   */
+  std::vector<int> free_{};
+  std::unordered_map<char32_t, int> resident_{};
+};
+
+} /* namespace game_engine::_2D */
+
+#endif /* SRC_2D_GLYPHATLAS_HPP_ */
@@ -0,0 +1,191 @@
+/******************************************************************************
+ * GlyphRasterizer.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "2D/GlyphRasterizer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+#include "Util/ParallelFor.hpp"
+
+namespace game_engine::_2D {
+
+namespace {
+
+constexpr int kMinGlyphsPerThread = 8;
+
+}  // namespace
+
+bool GlyphRasterizer::Start(const std::string& font_path,
+                            const unsigned int pixel_size,
+                            const unsigned int field_size,
+                            const SdfOptions& options) {
+  Stop();
+  if (FT_Init_FreeType(&library_) != 0) {
+    log_.Error("Freetype:  Could not init FreeType Library");
+    library_ = nullptr;
+    return false;
+  }
+  if (FT_New_Face(library_, font_path.c_str(), 0, &face_) != 0) {
+    log_.Error("Freetype: Failed to load font");
+    FT_Done_FreeType(library_);
+    library_ = nullptr;
+    face_ = nullptr;
+    return false;
+  }
+  pixel_size_ = pixel_size;
+  options_ = options;
+  render_size_ = field_size * static_cast<unsigned int>(options.supersample);
+  FT_Set_Pixel_Sizes(face_, 0, render_size_);
+
+  stop_ = false;
+  busy_ = false;
+  worker_ = std::thread(&GlyphRasterizer::Run, this);
+  return true;
+}
+
+void GlyphRasterizer::Stop() {
+  if (worker_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    worker_.join();
+  }
+  pending_.clear();
+  done_.clear();
+  if (face_ != nullptr) {
+    FT_Done_Face(face_);
+    face_ = nullptr;
+  }
+  if (library_ != nullptr) {
+    FT_Done_FreeType(library_);
+    library_ = nullptr;
+  }
+}
+
+void GlyphRasterizer::Request(const char32_t code_point) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.push_back(code_point);
+  }
+  wake_.notify_one();
+}
+
+std::vector<RasterizedGlyph> GlyphRasterizer::Collect() {
+  std::vector<RasterizedGlyph> glyphs;
+  std::lock_guard<std::mutex> lock(mutex_);
+  glyphs.swap(done_);
+  return glyphs;
+}
+
+void GlyphRasterizer::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [this] {
+    return stop_ || !worker_.joinable() || (pending_.empty() && !busy_);
+  });
+}
+
+void GlyphRasterizer::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    wake_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+    if (stop_) {
+      break;
+    }
+    std::vector<char32_t> batch;
+    batch.swap(pending_);
+    busy_ = true;
+    lock.unlock();
+
+    std::vector<RasterizedGlyph> glyphs = Rasterize(batch);
+
+    lock.lock();
+    std::move(glyphs.begin(), glyphs.end(), std::back_inserter(done_));
+    busy_ = false;
+    idle_.notify_all();
+  }
+  idle_.notify_all();
+}
+
+std::vector<RasterizedGlyph> GlyphRasterizer::Rasterize(
+    const std::vector<char32_t>& code_points) {
+  // FreeType is not thread safe, so only the distance fields are generated in
+  // parallel
+  std::vector<RasterizedGlyph> glyphs(code_points.size());
+  std::vector<std::vector<std::uint8_t>> coverage(code_points.size());
+  std::vector<glm::ivec2> sizes(code_points.size());
+  std::vector<glm::ivec2> bearings(code_points.size());
+
+  // Metrics of the rasterization in pixels of text drawn with a scale of 1
+  const float to_text =
+      static_cast<float>(pixel_size_) / static_cast<float>(render_size_);
+  const float padding =
+      static_cast<float>(options_.spread * options_.supersample);
+  for (std::size_t i = 0; i < code_points.size(); i++) {
+    RasterizedGlyph& glyph = glyphs[i];
+    glyph.code_point = code_points[i];
+    const FT_UInt index = glyph.code_point == kFallback
+                              ? 0
+                              : FT_Get_Char_Index(face_, glyph.code_point);
+    if (index == 0 && glyph.code_point != kFallback) {
+      continue;
+    }
+    if (FT_Load_Glyph(face_, index, FT_LOAD_RENDER) != 0) {
+      log_.Error("Freetype: Failed to load Glyph");
+      continue;
+    }
+    glyph.found = true;
+
+    const FT_Bitmap& bitmap = face_->glyph->bitmap;
+    sizes[i] = glm::ivec2(bitmap.width, bitmap.rows);
+    bearings[i] =
+        glm::ivec2(face_->glyph->bitmap_left, face_->glyph->bitmap_top);
+    glyph.advance =
+        static_cast<float>(face_->glyph->advance.x) / 64.0f * to_text;
+    coverage[i].resize(static_cast<std::size_t>(sizes[i].x) * sizes[i].y);
+    for (int y = 0; y < sizes[i].y; y++) {
+      std::copy_n(bitmap.buffer + y * bitmap.pitch, sizes[i].x,
+                  coverage[i].begin() + y * sizes[i].x);
+    }
+  }
+
+  const auto generate = [&](const int begin, const int end) {
+    for (int i = begin; i < end; i++) {
+      RasterizedGlyph& glyph = glyphs[i];
+      if (sizes[i].x <= 0 || sizes[i].y <= 0) {
+        continue;
+      }
+      glyph.field = SdfGenerator::Generate(sizes[i], coverage[i].data(), 0,
+                                           options_);
+      glyph.size = glm::vec2(glyph.field.size) *
+                   static_cast<float>(options_.supersample) * to_text;
+      glyph.bearing =
+          (glm::vec2(bearings[i]) + glm::vec2(-padding, padding)) * to_text;
+    }
+  };
+  util::ParallelFor(static_cast<int>(glyphs.size()), 0, kMinGlyphsPerThread,
+                    generate);
+  return glyphs;
+}
+
+} /* namespace game_engine::_2D */
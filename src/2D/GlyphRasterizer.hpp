@@ -0,0 +1,129 @@
+/******************************************************************************
+ * GlyphRasterizer.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_2D_GLYPHRASTERIZER_HPP_
+#define SRC_2D_GLYPHRASTERIZER_HPP_
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "LoggerV2/Log.hpp"
+
+#include "2D/SdfGenerator.hpp"
+
+namespace game_engine::_2D {
+
+/**
+ * @brief Distance field and metrics of one glyph.  Sizes are in pixels of
+ *        text drawn with a scale of 1.
+ */
+struct RasterizedGlyph {
+  char32_t code_point = 0;
+  /**
+   * @brief False if the font has no glyph for the code point
+   */
+  bool found = false;
+  glm::vec2 size{0.0f, 0.0f};     // Size of the quad, padding included
+  glm::vec2 bearing{0.0f, 0.0f};  // Offset from baseline to left/top of quad
+  float advance = 0.0f;           // Offset to advance to next glyph
+  SdfBitmap field{};
+};
+
+/**
+ * @brief Rasterizes glyphs into distance fields on a worker thread
+ *
+ * The worker owns the FreeType face.  Requested code points are rasterized in
+ * batches, and the distance fields of a batch are generated in parallel, so
+ * the thread that draws never waits on FreeType.
+ */
+class GlyphRasterizer {
+ public:
+  /**
+   * @brief Stands for the font's missing glyph.  One past the last code
+   *        point, so it never appears in decoded text.
+   */
+  static constexpr char32_t kFallback = 0x110000;
+
+  GlyphRasterizer() = default;
+  ~GlyphRasterizer() { Stop(); }
+  GlyphRasterizer(const GlyphRasterizer&) = delete;
+  GlyphRasterizer& operator=(const GlyphRasterizer&) = delete;
+
+  /**
+   * @brief Open a font and start the worker
+   * @param pixel_size Height of text drawn with a scale of 1
+   * @param field_size Distance field texels per em
+   * @return Returns false if the font could not be loaded
+   */
+  bool Start(const std::string& font_path, const unsigned int pixel_size,
+             const unsigned int field_size, const SdfOptions& options);
+  /**
+   * @brief Stop the worker and close the font.  Pending requests are dropped.
+   */
+  void Stop();
+  bool IsRunning() const { return worker_.joinable(); }
+
+  /**
+   * @brief Queue a code point to be rasterized
+   */
+  void Request(const char32_t code_point);
+  /**
+   * @brief Take every glyph finished since the last call
+   */
+  std::vector<RasterizedGlyph> Collect();
+  /**
+   * @brief Block until every queued code point has been rasterized
+   */
+  void Wait();
+
+ protected:
+  void Run();
+  std::vector<RasterizedGlyph> Rasterize(
+      const std::vector<char32_t>& code_points);
+
+  FT_Library library_ = nullptr;
+  FT_Face face_ = nullptr;
+  unsigned int pixel_size_ = 0;
+  unsigned int render_size_ = 0;
+  SdfOptions options_{};
+
+  std::thread worker_{};
+  std::mutex mutex_{};
+  std::condition_variable wake_{};
+  std::condition_variable idle_{};
+  bool stop_ = false;
+  bool busy_ = false;
+  std::vector<char32_t> pending_{};
+  std::vector<RasterizedGlyph> done_{};
+
+ private:
+  logging::Log log_ = logging::Log("main");
+};
+
+} /* namespace game_engine::_2D */
+
+#endif /* SRC_2D_GLYPHRASTERIZER_HPP_ */
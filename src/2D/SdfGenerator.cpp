@@ -0,0 +1,147 @@
+/******************************************************************************
+ * SdfGenerator.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "2D/SdfGenerator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace game_engine::_2D {
+
+namespace {
+
+constexpr float kFar = 1e20f;
+
+}  // namespace
+
+SdfBitmap SdfGenerator::Generate(const glm::ivec2 size,
+                                 const std::uint8_t* coverage,
+                                 const std::size_t row_stride,
+                                 const SdfOptions& options) {
+  const int supersample = std::max(options.supersample, 1);
+  const int spread = std::max(options.spread, 1);
+  const std::size_t stride =
+      row_stride != 0 ? row_stride : static_cast<std::size_t>(size.x);
+
+  SdfBitmap result;
+  result.size = (size + glm::ivec2(supersample - 1)) / supersample +
+                glm::ivec2(2 * spread);
+  // The shape padded by the spread, and on the right and bottom up to a
+  // whole output texel
+  const int padding = spread * supersample;
+  const glm::ivec2 grid_size = result.size * supersample;
+
+  std::vector<float> outside(static_cast<std::size_t>(grid_size.x) *
+                             grid_size.y);
+  std::vector<float> inside(outside.size());
+  for (int y = 0; y < grid_size.y; y++) {
+    for (int x = 0; x < grid_size.x; x++) {
+      const int sx = x - padding;
+      const int sy = y - padding;
+      const bool in = sx >= 0 && sy >= 0 && sx < size.x && sy < size.y &&
+                      coverage[sy * stride + sx] >= 128;
+      const std::size_t i = static_cast<std::size_t>(y) * grid_size.x + x;
+      outside[i] = in ? 0.0f : kFar;
+      inside[i] = in ? kFar : 0.0f;
+    }
+  }
+  Transform2D(outside, grid_size);
+  Transform2D(inside, grid_size);
+
+  // Average the signed distance over each block of input pixels.  The edge
+  // lies half a pixel between an inside and an outside pixel.
+  const float scale = 0.5f / static_cast<float>(spread * supersample);
+  const float block = static_cast<float>(supersample * supersample);
+  result.pixels.resize(static_cast<std::size_t>(result.size.x) *
+                       result.size.y);
+  for (int y = 0; y < result.size.y; y++) {
+    for (int x = 0; x < result.size.x; x++) {
+      float sum = 0.0f;
+      for (int by = 0; by < supersample; by++) {
+        const std::size_t row =
+            static_cast<std::size_t>(y * supersample + by) * grid_size.x;
+        for (int bx = 0; bx < supersample; bx++) {
+          const std::size_t i = row + x * supersample + bx;
+          sum += outside[i] > 0.0f ? std::sqrt(outside[i]) - 0.5f
+                                   : 0.5f - std::sqrt(inside[i]);
+        }
+      }
+      const float value = std::clamp(0.5f - sum / block * scale, 0.0f, 1.0f);
+      result.pixels[static_cast<std::size_t>(y) * result.size.x + x] =
+          static_cast<std::uint8_t>(value * 255.0f + 0.5f);
+    }
+  }
+  return result;
+}
+
+void SdfGenerator::Transform2D(std::vector<float>& grid,
+                               const glm::ivec2 size) {
+  std::vector<float> scratch(3 * static_cast<std::size_t>(
+                                     std::max(size.x, size.y)) +
+                             1);
+  for (int x = 0; x < size.x; x++) {
+    Transform1D(grid.data() + x, size.y, size.x, scratch);
+  }
+  for (int y = 0; y < size.y; y++) {
+    Transform1D(grid.data() + static_cast<std::size_t>(y) * size.x, size.x, 1,
+                scratch);
+  }
+}
+
+void SdfGenerator::Transform1D(float* f, const int n, const int stride,
+                               std::vector<float>& scratch) {
+  // Lower envelope of the parabolas rooted at each element
+  float* values = scratch.data();
+  float* roots = values + n;
+  float* bounds = roots + n;
+  for (int q = 0; q < n; q++) {
+    values[q] = f[q * stride];
+  }
+  int k = 0;
+  roots[0] = 0.0f;
+  bounds[0] = -kFar;
+  bounds[1] = kFar;
+  // Where the parabola of q overtakes the envelope segment j
+  const auto intersection = [values, roots](const int q, const int j) {
+    const float r = roots[j];
+    return ((values[q] + q * q) - (values[static_cast<int>(r)] + r * r)) /
+           (2.0f * q - 2.0f * r);
+  };
+  for (int q = 1; q < n; q++) {
+    float s = intersection(q, k);
+    while (s <= bounds[k]) {
+      k--;
+      s = intersection(q, k);
+    }
+    k++;
+    roots[k] = static_cast<float>(q);
+    bounds[k] = s;
+    bounds[k + 1] = kFar;
+  }
+  k = 0;
+  for (int q = 0; q < n; q++) {
+    while (bounds[k + 1] < q) {
+      k++;
+    }
+    const float r = roots[k];
+    f[q * stride] = (q - r) * (q - r) + values[static_cast<int>(r)];
+  }
+}
+
+} /* namespace game_engine::_2D */
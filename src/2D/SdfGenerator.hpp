@@ -0,0 +1,98 @@
+/******************************************************************************
+ * SdfGenerator.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_2D_SDFGENERATOR_HPP_
+#define SRC_2D_SDFGENERATOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace game_engine::_2D {
+
+/**
+ * @brief Options for turning a coverage bitmap into a signed distance field
+ */
+struct SdfOptions {
+  /**
+   * @brief Distance in output texels mapped to the full 0 to 255 range on
+   *        each side of the edge.  Also the padding added around the shape.
+   */
+  int spread = 4;
+  /**
+   * @brief Input pixels per output texel in each direction.  Rasterizing
+   *        large and reducing keeps thin features and corners accurate.
+   */
+  int supersample = 4;
+};
+
+/**
+ * @brief A single channel distance field, 128 on the edge and larger inside
+ */
+struct SdfBitmap {
+  glm::ivec2 size{0, 0};
+  std::vector<std::uint8_t> pixels{};
+};
+
+/**
+ * @brief Generates signed distance fields from coverage bitmaps
+ *
+ * Distances are exact Euclidean distances to the nearest pixel on the other
+ * side of the edge, found with the separable transform of Felzenszwalb and
+ * Huttenlocher, so the cost is linear in the number of pixels.  The field
+ * can be sampled at any scale and thresholded at 0.5 for a sharp edge, which
+ * is how text is drawn from one small glyph atlas.  Each call is independent,
+ * so glyphs can be generated on worker threads.
+ */
+class SdfGenerator {
+ public:
+  /**
+   * @brief Generate the distance field of a shape
+   * @param size Size of the coverage bitmap
+   * @param coverage Coverage of each pixel, inside from 128
+   * @param row_stride Bytes between the start of two rows.  0 means tightly
+   *                   packed.
+   * @return Returns a field of ceil(size / supersample) + 2 * spread texels
+   */
+  static SdfBitmap Generate(const glm::ivec2 size,
+                            const std::uint8_t* coverage,
+                            const std::size_t row_stride,
+                            const SdfOptions& options);
+
+ protected:
+  /**
+   * @brief Squared distance transform of a single row or column in place
+   * @param f Squared distances, with a large value for pixels far away
+   * @param stride Distance between two elements of f
+   * @param scratch At least 3 * n + 1 floats of working memory
+   */
+  static void Transform1D(float* f, const int n, const int stride,
+                          std::vector<float>& scratch);
+  /**
+   * @brief Replace every pixel with the squared distance to the nearest pixel
+   *        that was 0
+   */
+  static void Transform2D(std::vector<float>& grid, const glm::ivec2 size);
+};
+
+} /* namespace game_engine::_2D */
+
+#endif /* SRC_2D_SDFGENERATOR_HPP_ */
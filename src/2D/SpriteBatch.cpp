@@ -0,0 +1,150 @@
+/******************************************************************************
+ * SpriteBatch.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "2D/SpriteBatch.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace game_engine::_2D {
+
+namespace {
+
+/**
+ * @brief Sort key ordering sprites by layer and then texture.  The sign bit
+ *        of the layer is flipped so negative layers sort first.
+ */
+std::uint64_t SortKey(const int layer, const unsigned int texture) {
+  const std::uint32_t biased_layer =
+      static_cast<std::uint32_t>(layer) ^ 0x80000000u;
+  return (static_cast<std::uint64_t>(biased_layer) << 32) | texture;
+}
+
+}  // namespace
+
+void SpriteBatch::Begin() {
+  instances_.clear();
+  entries_.clear();
+  sorted_.clear();
+  draws_.clear();
+}
+
+void SpriteBatch::Draw(const Sprite& sprite) {
+  SpriteInstance instance;
+  instance.position_size = glm::vec4(sprite.position, sprite.size);
+  instance.uv_rect = glm::vec4(sprite.uv_min, sprite.uv_max);
+  instance.color = PackColor(sprite.color);
+  instance.rotation = sprite.rotation;
+  instance.texture_layer = static_cast<std::uint32_t>(sprite.texture_layer);
+  entries_.push_back(
+      SortEntry{SortKey(sprite.layer, sprite.texture),
+                static_cast<std::uint32_t>(instances_.size())});
+  instances_.push_back(instance);
+}
+
+void SpriteBatch::Draw(const std::vector<SpriteInstance>& instances,
+                       const glm::vec2 offset, const std::uint32_t color,
+                       const int layer, const unsigned int texture) {
+  const std::uint64_t key = SortKey(layer, texture);
+  const glm::vec4 translation(offset, 0.0f, 0.0f);
+  for (const SpriteInstance& source : instances) {
+    SpriteInstance instance = source;
+    instance.position_size += translation;
+    instance.color = color;
+    entries_.push_back(
+        SortEntry{key, static_cast<std::uint32_t>(instances_.size())});
+    instances_.push_back(instance);
+  }
+}
+
+void SpriteBatch::End() {
+  Sort();
+
+  draws_.clear();
+  for (std::size_t i = 0; i < entries_.size(); i++) {
+    const unsigned int texture =
+        static_cast<unsigned int>(entries_[i].key & 0xFFFFFFFFu);
+    if (draws_.empty() || draws_.back().texture != texture) {
+      draws_.push_back(SpriteDraw{texture, static_cast<std::uint32_t>(i), 0});
+    }
+    draws_.back().count++;
+  }
+}
+
+void SpriteBatch::Reserve(const std::size_t sprites) {
+  instances_.reserve(sprites);
+  entries_.reserve(sprites);
+  scratch_.reserve(sprites);
+  sorted_.reserve(sprites);
+}
+
+std::uint32_t SpriteBatch::PackColor(const glm::vec4& color) {
+  std::uint32_t packed = 0;
+  for (int i = 0; i < 4; i++) {
+    const float channel = std::clamp(color[i], 0.0f, 1.0f);
+    packed |= static_cast<std::uint32_t>(channel * 255.0f + 0.5f) << (i * 8);
+  }
+  return packed;
+}
+
+void SpriteBatch::Sort() {
+  const std::size_t count = entries_.size();
+  if (std::is_sorted(entries_.begin(), entries_.end(),
+                     [](const SortEntry& a, const SortEntry& b) {
+                       return a.key < b.key;
+                     })) {
+    // Common when everything shares a layer and an atlas
+    sorted_ = instances_;
+    return;
+  }
+
+  // Least significant digit radix sort, which is stable.  Bytes every key
+  // agrees on are skipped, so usually only a few of the eight passes run.
+  std::uint64_t differing = 0;
+  for (const SortEntry& entry : entries_) {
+    differing |= entry.key ^ entries_.front().key;
+  }
+  scratch_.resize(count);
+  for (int shift = 0; shift < 64; shift += 8) {
+    if (((differing >> shift) & 0xFF) == 0) {
+      continue;
+    }
+    std::array<std::size_t, 256> offsets{};
+    for (const SortEntry& entry : entries_) {
+      offsets[(entry.key >> shift) & 0xFF]++;
+    }
+    std::size_t total = 0;
+    for (std::size_t& offset : offsets) {
+      const std::size_t bucket = offset;
+      offset = total;
+      total += bucket;
+    }
+    for (const SortEntry& entry : entries_) {
+      scratch_[offsets[(entry.key >> shift) & 0xFF]++] = entry;
+    }
+    entries_.swap(scratch_);
+  }
+
+  sorted_.resize(count);
+  for (std::size_t i = 0; i < count; i++) {
+    sorted_[i] = instances_[entries_[i].index];
+  }
+}
+
+} /* namespace game_engine::_2D */
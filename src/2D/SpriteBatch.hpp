@@ -0,0 +1,180 @@
+/******************************************************************************
+ * SpriteBatch.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_2D_SPRITEBATCH_HPP_
+#define SRC_2D_SPRITEBATCH_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "3D/TextureAtlas.hpp"
+
+namespace game_engine::_2D {
+
+/**
+ * @brief A textured quad submitted to a SpriteBatch
+ */
+struct Sprite {
+  /**
+   * @brief Position of the center of the sprite
+   */
+  glm::vec2 position{0.0f, 0.0f};
+  glm::vec2 size{1.0f, 1.0f};
+  /**
+   * @brief Texture coordinates of the top left and bottom right corners
+   */
+  glm::vec2 uv_min{0.0f, 0.0f};
+  glm::vec2 uv_max{1.0f, 1.0f};
+  /**
+   * @brief Multiplied with the texture, stored with 8 bits per channel
+   */
+  glm::vec4 color{1.0f, 1.0f, 1.0f, 1.0f};
+  /**
+   * @brief Counter-clockwise rotation about the center, in radians
+   */
+  float rotation = 0.0f;
+  /**
+   * @brief Sprites on higher layers are drawn over lower ones.  Sprites on
+   *        the same layer are drawn in the order they were submitted.
+   */
+  int layer = 0;
+  /**
+   * @brief Texture array, as returned by CreateTextureArray or
+   *        TextureAtlas::Upload
+   */
+  unsigned int texture = 0;
+  int texture_layer = 0;
+
+  /**
+   * @brief Show an image packed into a TextureAtlas
+   */
+  void SetRegion(const _3D::TextureRegion& region) {
+    uv_min = region.uv_min;
+    uv_max = region.uv_max;
+    texture_layer = region.layer;
+  }
+};
+
+/**
+ * @brief Layout of a sprite in the streamed vertex buffer, one per instance
+ */
+struct SpriteInstance {
+  /**
+   * @brief Position in xy and size in zw
+   */
+  glm::vec4 position_size{0.0f};
+  /**
+   * @brief uv_min in xy and uv_max in zw
+   */
+  glm::vec4 uv_rect{0.0f};
+  /**
+   * @brief RGBA with 8 bits per channel, red in the lowest byte
+   */
+  std::uint32_t color = 0;
+  float rotation = 0.0f;
+  std::uint32_t texture_layer = 0;
+  std::uint32_t padding = 0;
+};
+static_assert(sizeof(SpriteInstance) == 48,
+              "SpriteInstance must match the attributes of sprite.vs.glsl");
+
+/**
+ * @brief A run of consecutive instances sharing a texture, drawn with a
+ *        single instanced draw
+ */
+struct SpriteDraw {
+  unsigned int texture = 0;
+  std::uint32_t first = 0;
+  std::uint32_t count = 0;
+};
+
+/**
+ * @brief Collects sprites for a frame and turns them into as few draws as
+ *        possible
+ *
+ * Draw only appends the compact GPU form of a sprite.  End sorts the sprites
+ * by layer and then texture with a stable radix sort, keeping submission
+ * order within a layer, and merges neighbours using the same texture into a
+ * single SpriteDraw.  Packing images into a TextureAtlas lets a whole layer,
+ * or a whole frame, share one texture and so one draw.  Renderer::DrawSprites
+ * streams the instances to the GPU in one upload.
+ */
+class SpriteBatch {
+ public:
+  /**
+   * @brief Drop the sprites of the previous frame, keeping their memory
+   */
+  void Begin();
+  void Draw(const Sprite& sprite);
+  /**
+   * @brief Append sprites already in their GPU form, such as a cached text
+   *        layout
+   * @param offset Added to the position of every instance
+   * @param color Packed color replacing the color of every instance
+   */
+  void Draw(const std::vector<SpriteInstance>& instances,
+            const glm::vec2 offset, const std::uint32_t color,
+            const int layer, const unsigned int texture);
+  /**
+   * @brief Sort the sprites and build the draws
+   */
+  void End();
+
+  void Reserve(const std::size_t sprites);
+
+  /**
+   * @brief Sprites in draw order, valid after End
+   */
+  const std::vector<SpriteInstance>& GetInstances() const { return sorted_; }
+  /**
+   * @brief Draws covering GetInstances, valid after End
+   */
+  const std::vector<SpriteDraw>& GetDraws() const { return draws_; }
+  std::size_t GetSpriteCount() const { return instances_.size(); }
+
+  /**
+   * @brief Convert a color to RGBA with 8 bits per channel, red in the
+   *        lowest byte
+   */
+  static std::uint32_t PackColor(const glm::vec4& color);
+
+ protected:
+  struct SortEntry {
+    /**
+     * @brief Layer in the upper 32 bits and texture in the lower 32 bits
+     */
+    std::uint64_t key;
+    std::uint32_t index;
+  };
+
+  void Sort();
+
+  std::vector<SpriteInstance> instances_{};
+  std::vector<SortEntry> entries_{};
+  std::vector<SortEntry> scratch_{};
+  std::vector<SpriteInstance> sorted_{};
+  std::vector<SpriteDraw> draws_{};
+};
+
+} /* namespace game_engine::_2D */
+
+#endif /* SRC_2D_SPRITEBATCH_HPP_ */
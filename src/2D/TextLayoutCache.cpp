@@ -0,0 +1,92 @@
+/******************************************************************************
+ * TextLayoutCache.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "2D/TextLayoutCache.hpp"
+
+#include <utility>
+
+#include "Util/Hash.hpp"
+
+namespace game_engine::_2D {
+
+std::uint64_t TextLayoutCache::Key(const std::string_view text,
+                                   const std::uint64_t font,
+                                   const float scale) {
+  return util::Hasher().Add(text).Add(font).Add(scale).Get();
+}
+
+const TextLayout* TextLayoutCache::Find(const std::string_view text,
+                                        const std::uint64_t font,
+                                        const float scale) {
+  const auto it = index_.find(Key(text, font, scale));
+  if (it == index_.end() || it->second->text != text ||
+      it->second->font != font || it->second->scale != scale) {
+    misses_++;
+    return nullptr;
+  }
+  hits_++;
+  it->second->last_used = frame_;
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return &entries_.front().layout;
+}
+
+const TextLayout& TextLayoutCache::Insert(const std::string_view text,
+                                          const std::uint64_t font,
+                                          const float scale,
+                                          TextLayout layout) {
+  const std::uint64_t key = Key(text, font, scale);
+  const auto it = index_.find(key);
+  if (it != index_.end()) {
+    // Same key, either a refresh or a hash collision.  Either way the new
+    // layout replaces the old one.
+    entries_.erase(it->second);
+    index_.erase(it);
+  }
+  while (!entries_.empty() && entries_.size() >= capacity_) {
+    index_.erase(entries_.back().key);
+    entries_.pop_back();
+  }
+
+  Entry entry;
+  entry.key = key;
+  entry.text = std::string(text);
+  entry.font = font;
+  entry.scale = scale;
+  entry.last_used = frame_;
+  entry.layout = std::move(layout);
+  entries_.push_front(std::move(entry));
+  index_[key] = entries_.begin();
+  return entries_.front().layout;
+}
+
+void TextLayoutCache::NextFrame() {
+  frame_++;
+  while (!entries_.empty() &&
+         frame_ - entries_.back().last_used > max_idle_frames_) {
+    index_.erase(entries_.back().key);
+    entries_.pop_back();
+  }
+}
+
+void TextLayoutCache::Clear() {
+  entries_.clear();
+  index_.clear();
+}
+
+} /* namespace game_engine::_2D */
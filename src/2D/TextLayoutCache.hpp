@@ -0,0 +1,126 @@
+/******************************************************************************
+ * TextLayoutCache.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_2D_TEXTLAYOUTCACHE_HPP_
+#define SRC_2D_TEXTLAYOUTCACHE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "2D/SpriteBatch.hpp"
+
+namespace game_engine::_2D {
+
+/**
+ * @brief Glyph quads of a string, positioned relative to the start of its
+ *        baseline
+ */
+struct TextLayout {
+  std::vector<SpriteInstance> glyphs{};
+  /**
+   * @brief Distance from the start of the baseline to the pen position
+   *        after the last glyph
+   */
+  float advance = 0.0f;
+  /**
+   * @brief Glyph atlas cells the glyphs sample from, so a cached layout can
+   *        keep its glyphs resident
+   */
+  std::vector<int> slots{};
+};
+
+/**
+ * @brief Least recently used cache of text layouts
+ *
+ * Layouts are keyed by the hash of the string, the font and the scale, and
+ * also keep the string itself so a hash collision is a miss rather than the
+ * wrong text.  Once full, the least recently used layout is evicted.  NextFrame
+ * should be called once per frame; layouts not used for max_idle_frames
+ * frames are dropped, so text that stopped changing is kept while text that
+ * changes every frame does not fill the cache for long.
+ */
+class TextLayoutCache {
+ public:
+  /**
+   * @param capacity Maximum number of layouts
+   * @param max_idle_frames Frames a layout is kept without being used
+   */
+  explicit TextLayoutCache(const std::size_t capacity = 512,
+                           const std::uint32_t max_idle_frames = 300)
+      : capacity_(capacity), max_idle_frames_(max_idle_frames) {}
+
+  /**
+   * @brief Look up a layout and mark it as used this frame
+   * @return Returns the layout, or nullptr if it is not cached.  Valid until
+   *         the next Insert, NextFrame or Clear.
+   */
+  const TextLayout* Find(const std::string_view text, const std::uint64_t font,
+                         const float scale);
+  /**
+   * @brief Cache a layout, evicting the least recently used one if full
+   * @return Returns the cached layout, valid like the result of Find
+   */
+  const TextLayout& Insert(const std::string_view text,
+                           const std::uint64_t font, const float scale,
+                           TextLayout layout);
+
+  /**
+   * @brief Start a new frame and drop layouts that have been idle too long
+   */
+  void NextFrame();
+  void Clear();
+
+  std::size_t GetSize() const { return entries_.size(); }
+  std::size_t GetCapacity() const { return capacity_; }
+  std::uint64_t GetHits() const { return hits_; }
+  std::uint64_t GetMisses() const { return misses_; }
+
+ protected:
+  struct Entry {
+    std::uint64_t key = 0;
+    std::string text{};
+    std::uint64_t font = 0;
+    float scale = 0.0f;
+    std::uint64_t last_used = 0;
+    TextLayout layout{};
+  };
+
+  static std::uint64_t Key(const std::string_view text,
+                           const std::uint64_t font, const float scale);
+
+  std::size_t capacity_;
+  std::uint32_t max_idle_frames_;
+  std::uint64_t frame_ = 0;
+  std::uint64_t hits_ = 0;
+  std::uint64_t misses_ = 0;
+  /**
+   * @brief Most recently used first
+   */
+  std::list<Entry> entries_{};
+  std::unordered_map<std::uint64_t, std::list<Entry>::iterator> index_{};
+};
+
+} /* namespace game_engine::_2D */
+
+#endif /* SRC_2D_TEXTLAYOUTCACHE_HPP_ */
@@ -0,0 +1,232 @@
+/******************************************************************************
+ * TextRenderer.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "2D/TextRenderer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <cmrc/cmrc.hpp>
+
+#include "2D/SdfGenerator.hpp"
+#include "Util/Hash.hpp"
+#include "Util/Utf8.hpp"
+
+CMRC_DECLARE(_2D);
+
+namespace game_engine::_2D {
+
+namespace {
+
+constexpr std::string_view kFontResource = "default.font";
+
+}  // namespace
+
+void TextRenderer::LoadFont() {
+  const cmrc::embedded_filesystem fs = cmrc::_2D::get_filesystem();
+  const cmrc::file file = fs.open(std::string(kFontResource));
+  const auto font =
+      BakedFont::Open(std::string_view(file.begin(), file.size()));
+  if (!font) {
+    log_.Error("Embedded font {} is not a valid baked font.", kFontResource);
+    throw EXIT_FAILURE;
+  }
+  font_file_ = *font;
+  const BakedFontHeader& header = font_file_.GetHeader();
+  font_ = util::Hasher().Add(kFontResource).Add(header.pixel_size).Get();
+  atlas_ = GlyphAtlas(glm::ivec2(header.page_width, header.page_height),
+                      header.cell_size, static_cast<int>(header.page_count));
+  if (header.mip_levels > atlas_.GetMipLevels()) {
+    log_.Error("Embedded font {} has mip levels that mix glyph cells.",
+               kFontResource);
+    throw EXIT_FAILURE;
+  }
+  layouts_.Clear();
+  glyphs_.clear();
+  requested_.clear();
+  rasterizer_->Stop();
+
+  for (std::size_t i = 0; i < font_file_.GetGlyphCount(); i++) {
+    const BakedGlyph baked = font_file_.GetGlyph(i);
+    const char32_t code_point = baked.code_point;
+    Character character{};
+    character.size = glm::vec2(baked.size[0], baked.size[1]);
+    character.bearing = glm::vec2(baked.bearing[0], baked.bearing[1]);
+    character.advance = baked.advance;
+    if (baked.slot >= 0) {
+      if (!atlas_.Place(code_point, baked.slot, true)) {
+        log_.Error("Embedded font {} has an invalid cell for U+{:04X}.",
+                   kFontResource, baked.code_point);
+        throw EXIT_FAILURE;
+      }
+      character.slot = baked.slot;
+      character.region = atlas_.GetRegion(
+          baked.slot, glm::ivec2(baked.field_size[0], baked.field_size[1]));
+    }
+    glyphs_[code_point] = character;
+  }
+  const auto fallback = glyphs_.find(GlyphRasterizer::kFallback);
+  fallback_ = fallback == glyphs_.end() ? Character{} : fallback->second;
+  log_.Debug("Loaded {} baked glyphs and {} kerning pairs.",
+             font_file_.GetGlyphCount(), header.kerning_count);
+}
+
+bool TextRenderer::EnableGlyphPaging(const std::string& font_path) {
+  const BakedFontHeader& header = font_file_.GetHeader();
+  const SdfOptions options{header.spread, header.supersample};
+  if (!rasterizer_->Start(font_path, header.pixel_size, header.field_size,
+                          options)) {
+    return false;
+  }
+  // Code points drawn so far as the fallback can now be loaded
+  for (auto it = glyphs_.begin(); it != glyphs_.end();) {
+    if (!font_file_.FindGlyph(it->first)) {
+      it = glyphs_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  layouts_.Clear();
+  return true;
+}
+
+std::optional<int> TextRenderer::AddGlyph(const RasterizedGlyph& glyph) {
+  requested_.erase(glyph.code_point);
+  if (!glyph.found) {
+    glyphs_[glyph.code_point] = fallback_;
+    return std::nullopt;
+  }
+
+  Character character{};
+  character.size = glyph.size;
+  character.bearing = glyph.bearing;
+  character.advance = glyph.advance;
+  const int cell_size = atlas_.GetCellSize();
+  if (glyph.field.size.x > cell_size || glyph.field.size.y > cell_size) {
+    log_.Warning("Glyph U+{:04X} does not fit in a glyph atlas cell.",
+                 static_cast<std::uint32_t>(glyph.code_point));
+    glyphs_[glyph.code_point] = fallback_;
+    return std::nullopt;
+  }
+  if (glyph.field.pixels.empty()) {
+    glyphs_[glyph.code_point] = character;
+    return std::nullopt;
+  }
+
+  const auto allocation = atlas_.Allocate(glyph.code_point);
+  if (!allocation) {
+    // Every cell is in use this frame, so the glyph is requested again the
+    // next time it is laid out
+    return std::nullopt;
+  }
+  if (allocation->evicted) {
+    glyphs_.erase(*allocation->evicted);
+  }
+  character.slot = allocation->slot;
+  character.region = atlas_.GetRegion(allocation->slot, glyph.field.size);
+  glyphs_[glyph.code_point] = character;
+  return allocation->slot;
+}
+
+std::vector<TextRenderer::GlyphUpload> TextRenderer::AddLoadedGlyphs() {
+  std::vector<RasterizedGlyph> glyphs = rasterizer_->Collect();
+  std::vector<GlyphUpload> uploads;
+  // Cells are too small to be worth splitting across threads
+  _3D::MipmapOptions options;
+  options.max_levels = font_file_.GetHeader().mip_levels;
+  options.max_threads = 1;
+  const _3D::MipmapGenerator generator(options);
+  for (RasterizedGlyph& glyph : glyphs) {
+    const auto slot = AddGlyph(glyph);
+    if (!slot) {
+      continue;
+    }
+    // The whole cell is written so nothing of an evicted glyph is left to
+    // bleed into the new one through filtering
+    const _3D::TextureRegion cell =
+        atlas_.GetRegion(*slot, glm::ivec2(atlas_.GetCellSize()));
+    std::vector<std::uint8_t> pixels(static_cast<std::size_t>(cell.size.x) *
+                                     cell.size.y);
+    const SdfBitmap& field = glyph.field;
+    for (int y = 0; y < field.size.y; y++) {
+      std::copy_n(field.pixels.data() + y * field.size.x, field.size.x,
+                  pixels.data() + y * cell.size.x);
+    }
+    uploads.push_back(GlyphUpload{
+        glm::ivec3(cell.position.x, cell.position.y, cell.layer),
+        generator.Generate(cell.size, 1, pixels.data())});
+  }
+  if (!glyphs.empty()) {
+    // Cached layouts may show the fallback in place of the new glyphs, or
+    // sample cells that were just given to other glyphs
+    layouts_.Clear();
+  }
+  return uploads;
+}
+
+const TextRenderer::Character& TextRenderer::GetCharacter(
+    const char32_t code_point) {
+  const auto it = glyphs_.find(code_point);
+  if (it != glyphs_.end()) {
+    return it->second;
+  }
+  if (!rasterizer_->IsRunning()) {
+    return glyphs_.emplace(code_point, fallback_).first->second;
+  }
+  if (requested_.insert(code_point).second) {
+    rasterizer_->Request(code_point);
+  }
+  return fallback_;
+}
+
+TextLayout TextRenderer::Layout(const std::string& text, const float scale) {
+  TextLayout layout;
+  layout.glyphs.reserve(text.size());
+  float x = 0.0f;
+  std::size_t offset = 0;
+  char32_t previous = 0;
+  while (offset < text.size()) {
+    const char32_t code_point = util::DecodeUtf8(text, offset);
+    const Character& ch = GetCharacter(code_point);
+    x += font_file_.GetKerning(previous, code_point) * scale;
+    previous = code_point;
+
+    const float xpos = x + ch.bearing.x * scale;
+    const float ypos = -(ch.size.y - ch.bearing.y) * scale;
+    const float w = ch.size.x * scale;
+    const float h = ch.size.y * scale;
+    if (ch.slot >= 0) {
+      SpriteInstance glyph;
+      glyph.position_size = glm::vec4(xpos + w * 0.5f, ypos + h * 0.5f, w, h);
+      glyph.uv_rect = glm::vec4(ch.region.uv_min, ch.region.uv_max);
+      glyph.texture_layer = static_cast<std::uint32_t>(ch.region.layer);
+      layout.glyphs.push_back(glyph);
+      layout.slots.push_back(ch.slot);
+    }
+    x += ch.advance * scale;
+  }
+  layout.advance = x;
+  return layout;
+}
+
+} /* namespace game_engine::_2D */
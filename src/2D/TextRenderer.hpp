@@ -22,29 +22,67 @@
 
 #include <GL/glew.h>
 #include <SDL2/SDL.h>
-#include <ft2build.h>
-#include FT_FREETYPE_H
 
-#include <map>
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include <glm/glm.hpp>
 
 #include "LoggerV2/Log.hpp"
 
-#include "3D/Texture.hpp"
+#include "2D/BakedFont.hpp"
+#include "2D/GlyphAtlas.hpp"
+#include "2D/GlyphRasterizer.hpp"
+#include "2D/SpriteBatch.hpp"
+#include "2D/TextLayoutCache.hpp"
+#include "3D/MipmapGenerator.hpp"
+#include "3D/TextureAtlas.hpp"
 #include "Renderer.hpp"
-#include "Util/Singleton.hpp"
-#include "Vertex.hpp"
 
 namespace game_engine::_2D {
 
+/**
+ * @brief Draws UTF-8 text from a single glyph atlas
+ *
+ * Glyphs are signed distance fields, so text stays sharp at any scale
+ * without rasterizing the font again.  Init opens a BakedFont embedded at
+ * build time by the FontBaker tool and uploads its atlas layers directly, so
+ * startup touches neither FreeType nor the font files installed on the
+ * machine.  The baked glyphs are pinned in a GlyphAtlas; any other code point
+ * is drawn as the font's missing glyph unless EnableGlyphPaging was called,
+ * in which case a GlyphRasterizer loads it on a worker thread and the next
+ * Flush uploads it into a free cell, evicting the glyph used least recently
+ * if the atlas is full.
+ *
+ * RenderText only appends a quad per glyph to a SpriteBatch, and Flush draws
+ * all the text queued since the last Flush with one upload and one draw,
+ * however many strings it holds.  The glyph quads of each string are cached
+ * in a TextLayoutCache, so text that does not change is copied into the batch
+ * without being laid out again.
+ */
 class TextRenderer {
  public:
   template <typename Renderer>
   void Init(Renderer& renderer);
-
+  /**
+   * @brief Load glyphs missing from the embedded font from a font file on
+   *        demand.  Must be called after Init.
+   * @param font_path The font the embedded one was baked from
+   * @return Returns false if the font could not be loaded
+   */
+  bool EnableGlyphPaging(const std::string& font_path);
+
+  /**
+   * @brief Queue a UTF-8 string, drawn by the next Flush
+   * @param x Left of the first glyph, in pixels from the left of the window
+   * @param y Baseline, in pixels from the bottom of the window
+   */
   template <typename Renderer>
   void RenderText(const Renderer& renderer, const std::string text,
                   const float x, const float y, const float scale,
@@ -56,34 +94,104 @@ class TextRenderer {
                                     const float y, const float scale,
                                     const glm::vec3 color);
 
+  /**
+   * @brief Upload the glyphs rasterized since the last Flush, then draw the
+   *        queued text over the current framebuffer
+   */
+  template <typename Renderer>
+  void Flush(const Renderer& renderer);
+
+  const TextLayoutCache& GetLayoutCache() const { return layouts_; }
+  const GlyphAtlas& GetGlyphAtlas() const { return atlas_; }
+
   void swap(TextRenderer& other) noexcept {
     using std::swap;
-    swap(other.characters_, characters_);
+    swap(other.glyphs_, glyphs_);
+    swap(other.fallback_, fallback_);
+    swap(other.requested_, requested_);
     swap(other.valid_, valid_);
-    swap(other.handle_, handle_);
+    swap(other.font_file_, font_file_);
+    swap(other.atlas_, atlas_);
+    swap(other.texture_, texture_);
+    swap(other.rasterizer_, rasterizer_);
+    swap(other.batch_, batch_);
+    swap(other.layouts_, layouts_);
+    swap(other.font_, font_);
   }
 
   struct Character {
-    _3D::Texture texture;  // Glyph texture
-    glm::ivec2 size;       // Size of glyph
-    glm::ivec2 bearing;    // Offset from baseline to left/top of glyph
-    FT_Pos advance;        // Offset to advance to next glyph
+    _3D::TextureRegion region;  // Location of the glyph in the atlas
+    glm::vec2 size;             // Size of the quad, padding included
+    glm::vec2 bearing;          // Offset from baseline to left/top of quad
+    float advance;              // Offset to advance to next glyph
+    int slot = -1;              // Atlas cell, or -1 if nothing is drawn
 
     void swap(Character& other) noexcept {
       using std::swap;
-      swap(other.texture, texture);
+      swap(other.region, region);
       swap(other.size, size);
       swap(other.bearing, bearing);
       swap(other.advance, advance);
+      swap(other.slot, slot);
     }
   };
 
  protected:
+  /**
+   * @brief Distance field waiting to be copied into the atlas texture
+   */
+  struct GlyphUpload {
+    /**
+     * @brief Position of the cell in level 0, and its layer
+     */
+    glm::ivec3 offset{0, 0, 0};
+    _3D::MipChain mip_chain{};
+  };
+
   bool valid_ = false;
-  VboHandle handle_;
+  BakedFont font_file_{};
+  GlyphAtlas atlas_{};
+  unsigned int texture_ = 0;
+  std::unique_ptr<GlyphRasterizer> rasterizer_ =
+      std::make_unique<GlyphRasterizer>();
+  SpriteBatch batch_{};
+  TextLayoutCache layouts_{};
+  /**
+   * @brief Identifies the loaded font and size in layout cache keys
+   */
+  std::uint64_t font_ = 0;
+
+  /**
+   * @brief Open the embedded font and place its glyphs in the atlas
+   */
+  void LoadFont();
+  /**
+   * @brief Record a paged in glyph and reserve its atlas cell
+   * @return Returns the cell its distance field must be copied to, if any
+   */
+  std::optional<int> AddGlyph(const RasterizedGlyph& glyph);
+  /**
+   * @brief Add the glyphs the rasterizer finished since the last call
+   */
+  std::vector<GlyphUpload> AddLoadedGlyphs();
+  /**
+   * @brief Look up a glyph, requesting it if it is not loaded yet and glyph
+   *        paging is enabled
+   * @return Returns the glyph, or the fallback until it is loaded
+   */
+  const Character& GetCharacter(const char32_t code_point);
+  /**
+   * @brief Position the glyph quads of a string relative to its origin
+   */
+  TextLayout Layout(const std::string& text, const float scale);
 
  private:
-  std::map<char, Character> characters_;
+  std::unordered_map<char32_t, Character> glyphs_{};
+  Character fallback_{};
+  /**
+   * @brief Code points queued on the rasterizer and not collected yet
+   */
+  std::unordered_set<char32_t> requested_{};
   logging::Log log_ = logging::Log("main");
 };
 
@@ -20,85 +20,44 @@
 #ifndef SRC_2D_TEXTRENDERER_TPP_
 #define SRC_2D_TEXTRENDERER_TPP_
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 
 #include "LoggerV2/Log.hpp"
 
+#include "2D/BakedFont.hpp"
 #include "2D/TextRenderer.hpp"
 #include "Renderer.hpp"
-#include "Vertex.hpp"
 
 namespace game_engine::_2D {
 
 template <typename Renderer>
 void TextRenderer::Init(Renderer& renderer) {
-  FT_Library ft;
-  FT_Face face;
-
-  if (FT_Init_FreeType(&ft) != 0) {
-    log_.Error("Freetype:  Could not init FreeType Library");
-    throw EXIT_FAILURE;
-  }
-
-  if (FT_New_Face(ft, "/usr/share/fonts/truetype/msttcorefonts/arial.ttf", 0,
-                  &face) != 0) {
-    log_.Error("Freetype: Failed to load font");
-    throw EXIT_FAILURE;
-  }
-  FT_Set_Pixel_Sizes(face, 0, 48);
-  if (FT_Load_Char(face, 'X', FT_LOAD_RENDER) != 0) {
-    log_.Error("Freetype: Failed to load Glyph");
-    throw EXIT_FAILURE;
-  }
-
-  renderer.DisableByteAlignementRestriction();
-
-  for (uint8_t c = 0; c < 128; c++) {
-    // Load character glyph
-    if (FT_Load_Char(face, c, FT_LOAD_RENDER) != 0) {
-      log_.Error("Freetype: Failed to load Glyph");
-      continue;
+  LoadFont();
+  const BakedFontHeader& header = font_file_.GetHeader();
+  const _3D::PixelFormat format{GL_RED, GL_RED};
+  const glm::ivec2 page_size = atlas_.GetPageSize();
+  texture_ = renderer.CreateTextureArray(
+      ShaderPrograms::TEXT, format,
+      glm::ivec3(page_size.x, page_size.y, atlas_.GetPageCount()),
+      header.mip_levels, _3D::TextureWrap::CLAMP);
+  // Straight from the embedded font, without an intermediate copy
+  for (int level = 0; level < header.mip_levels; level++) {
+    const std::uint8_t* pixels = font_file_.GetPixels(level);
+    for (std::uint32_t layer = 0; layer < header.baked_page_count; layer++) {
+      const bool last = layer + 1 == header.baked_page_count;
+      const int rows = last ? header.baked_height : page_size.y;
+      renderer.UpdateTextureArray(
+          texture_, format, glm::ivec3(0, 0, layer),
+          glm::ivec2(page_size.x >> level, rows >> level),
+          pixels + font_file_.GetPageBytes(level) * layer, level);
     }
-
-    FT_Bitmap bitmap = face->glyph->bitmap;
-
-    // Generate texture
-    _3D::Texture texture;
-    texture.LoadTextureFromMemory(
-        renderer, glm::ivec2(bitmap.width, bitmap.rows),
-        _3D::PixelFormat{GL_RED, GL_RED}, bitmap.buffer, ShaderPrograms::TEXT,
-        _3D::TextureType::DIFFUSE);
-
-    // Now store character for later use
-    Character character = {
-        texture,
-        glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-        glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-        face->glyph->advance.x};
-    characters_.insert(std::pair<GLchar, Character>(c, character));
   }
-  renderer.DisableByteAlignementRestriction();
-
-  FT_Done_Face(face);
-  FT_Done_FreeType(ft);
-
-  // Update VBO for each character
-  const std::vector<Vertex> vertices = {
-      Vertex(glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, 0.0f),
-             glm::vec2(1.0f, 1.0f)),  // top right
-      Vertex(glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, 0.0f),
-             glm::vec2(1.0f, 0.0f)),  // bottom right
-      Vertex(glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, 0.0f),
-             glm::vec2(0.0f, 0.0f)),  // bottom left
-      Vertex(glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, 0.0f),
-             glm::vec2(0.0f, 1.0f))  // top left
-  };
-  const std::vector<GLuint> indices = {0, 1, 3, 1, 2, 3};
-
-  handle_ = renderer.GenerateVbo(ShaderPrograms::TEXT, vertices, indices);
   valid_ = true;
 }
 
@@ -112,65 +71,53 @@ void TextRenderer::RenderTextRelativeToTopRight(const Renderer& renderer,
   RenderText(renderer, text, size.x - x, size.y - y, scale, color);
 }
 template <typename Renderer>
-void TextRenderer::RenderText(const Renderer& renderer, const std::string text,
-                              const float _x, const float _y, const float scale,
+void TextRenderer::RenderText([[maybe_unused]] const Renderer& renderer,
+                              const std::string text, const float x,
+                              const float y, const float scale,
                               const glm::vec3 color) {
-  float x = _x;
-  float y = _y;
-  renderer.UseShader(ShaderPrograms::TEXT);
-  renderer.EnableBlending();
   if (!valid_) {
     log_.Error("Text renderer not valid!");
     return;
   }
 
-  glm::ivec2 size = renderer.GetWindowSize();
-
-  glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(size.x), 0.0f,
-                                    static_cast<float>(size.y));
-  renderer.SetMatrices(ShaderPrograms::TEXT, glm::mat4(1), glm::mat4(1),
-                       projection);
-
-  // Activate corresponding render state
-  renderer.SetColor(ShaderPrograms::TEXT, glm::vec4(color, 1.0));
-  // Iterate through all characters
-  for (std::string::const_iterator c = text.cbegin(); c != text.cend(); c++) {
-    Character ch = characters_[*c];
-
-    float xpos = x + ch.bearing.x * scale;
-    float ypos = y - (ch.size.y - ch.bearing.y) * scale;
-
-    float w = ch.size.x * scale;
-    float h = ch.size.y * scale;
-    std::vector<Vertex> vertices = {
-        Vertex(glm::vec3(xpos + w, ypos, 1.0f), glm::vec3(0.0f, 0.0f, 0.0f),
-               glm::vec2(1.0f, 1.0f)),  // top right
-        Vertex(glm::vec3(xpos + w, ypos + h, 1.0f), glm::vec3(0.0f, 0.0f, 0.0f),
-               glm::vec2(1.0f, 0.0f)),  // bottom right
-        Vertex(glm::vec3(xpos, ypos + h, 1.0f), glm::vec3(0.0f, 0.0f, 0.0f),
-               glm::vec2(0.0f, 0.0f)),  // bottom left
-        Vertex(glm::vec3(xpos, ypos, 1.0f), glm::vec3(0.0f, 0.0f, 0.0f),
-               glm::vec2(0.0f, 1.0f))  // top left
-    };
-    const std::vector<GLuint> indices = {0, 1, 3, 1, 2, 3};
-    // Render glyph texture over quad
-    renderer.BindTexture(ShaderPrograms::TEXT, "texture_diffuse0", ch.texture,
-                         0);
-    //		renderer.setSwizzleMask(GL_RED, GL_RED, GL_RED, GL_ONE);
-    // Update content of VBO memory
-    handle_ = renderer.UpdateVbo(handle_, vertices, indices);
+  const TextLayout* layout = layouts_.Find(text, font_, scale);
+  if (layout == nullptr) {
+    layout = &layouts_.Insert(text, font_, scale, Layout(text, scale));
+  }
+  for (const int slot : layout->slots) {
+    atlas_.Touch(slot);
+  }
+  batch_.Draw(layout->glyphs, glm::vec2(x, y),
+              SpriteBatch::PackColor(glm::vec4(color, 1.0f)), 0, texture_);
+}
 
-    // Render quad
-    renderer.Render(handle_, _3D::Primitive::TRIANGLES);
-    // Now advance cursors for next glyph (note that advance is number of 1/64
-    // pixels)
-    x += (ch.advance >> 6) *
-         scale;  // Bitshift by 6 to get value in pixels (2^6 = 64)
+template <typename Renderer>
+void TextRenderer::Flush(const Renderer& renderer) {
+  if (!valid_) {
+    return;
+  }
+  for (const GlyphUpload& upload : AddLoadedGlyphs()) {
+    const std::vector<_3D::MipLevel>& levels = upload.mip_chain.levels;
+    for (std::size_t level = 0; level < levels.size(); level++) {
+      const glm::ivec3 offset(upload.offset.x >> level,
+                              upload.offset.y >> level, upload.offset.z);
+      renderer.UpdateTextureArray(texture_, _3D::PixelFormat{GL_RED, GL_RED},
+                                  offset, levels[level].size,
+                                  levels[level].pixels.data(),
+                                  static_cast<int>(level));
+    }
   }
-  renderer.DisableBlending();
 
-  //	renderer.setSwizzleMask(GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA);
-  renderer.UseShader(ShaderPrograms::DEFAULT);
+  batch_.End();
+  if (batch_.GetSpriteCount() > 0) {
+    const glm::ivec2 size = renderer.GetWindowSize();
+    const glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(size.x),
+                                            0.0f, static_cast<float>(size.y));
+    renderer.DrawSprites(batch_, projection, ShaderPrograms::TEXT);
+  }
+  batch_.Begin();
+  layouts_.NextFrame();
+  atlas_.NextFrame();
 }
 
 } /* namespace game_engine::_2D */
@@ -0,0 +1,281 @@
+/******************************************************************************
+ * AabbTree.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/AabbTree.hpp"
+
+#include <algorithm>
+
+namespace game_engine::_3D {
+
+AabbTree::ProxyId AabbTree::CreateProxy(const Aabb& box,
+                                        const std::uint32_t user_data) {
+  const ProxyId proxy = AllocateNode();
+  nodes_[proxy].box = Fatten(box, glm::vec3(0.0f));
+  nodes_[proxy].user_data = user_data;
+  nodes_[proxy].height = 0;
+  InsertLeaf(proxy);
+  proxy_count_++;
+  return proxy;
+}
+
+void AabbTree::DestroyProxy(const ProxyId proxy) {
+  RemoveLeaf(proxy);
+  FreeNode(proxy);
+  proxy_count_--;
+}
+
+bool AabbTree::MoveProxy(const ProxyId proxy, const Aabb& box,
+                         const glm::vec3 displacement) {
+  if (nodes_[proxy].box.Contains(box)) {
+    return false;
+  }
+  RemoveLeaf(proxy);
+  nodes_[proxy].box = Fatten(box, displacement);
+  InsertLeaf(proxy);
+  return true;
+}
+
+void AabbTree::Clear() {
+  nodes_.clear();
+  root_ = kNullProxy;
+  free_list_ = kNullProxy;
+  proxy_count_ = 0;
+}
+
+int AabbTree::GetHeight() const {
+  return root_ == kNullProxy ? 0 : nodes_[root_].height;
+}
+
+std::optional<AabbTree::ProxyId> AabbTree::Nearest(
+    const glm::vec3 point, const float max_distance) const {
+  return Nearest(point, max_distance, [this, point](const ProxyId proxy) {
+    return nodes_[proxy].box.DistanceSquared(point);
+  });
+}
+
+bool AabbTree::Validate() const {
+  if (root_ != kNullProxy && nodes_[root_].parent != kNullProxy) {
+    return false;
+  }
+  std::size_t free_count = 0;
+  for (ProxyId i = free_list_; i != kNullProxy; i = nodes_[i].parent) {
+    free_count++;
+  }
+  const std::size_t node_count = nodes_.size() - free_count;
+  // A tree with n leaves has n - 1 internal nodes
+  if (node_count != (proxy_count_ == 0 ? 0 : 2 * proxy_count_ - 1)) {
+    return false;
+  }
+  return root_ == kNullProxy || ValidateNode(root_);
+}
+
+bool AabbTree::ValidateNode(const ProxyId node) const {
+  const Node& n = nodes_[node];
+  if (n.IsLeaf()) {
+    return n.child2 == kNullProxy && n.height == 0;
+  }
+  const Node& child1 = nodes_[n.child1];
+  const Node& child2 = nodes_[n.child2];
+  if (child1.parent != node || child2.parent != node) {
+    return false;
+  }
+  if (n.height != 1 + std::max(child1.height, child2.height)) {
+    return false;
+  }
+  if (!n.box.Contains(child1.box) || !n.box.Contains(child2.box)) {
+    return false;
+  }
+  return ValidateNode(n.child1) && ValidateNode(n.child2);
+}
+
+AabbTree::ProxyId AabbTree::AllocateNode() {
+  if (free_list_ == kNullProxy) {
+    nodes_.emplace_back();
+    return static_cast<ProxyId>(nodes_.size() - 1);
+  }
+  const ProxyId node = free_list_;
+  free_list_ = nodes_[node].parent;
+  nodes_[node] = Node{};
+  return node;
+}
+
+void AabbTree::FreeNode(const ProxyId node) {
+  nodes_[node] = Node{};
+  nodes_[node].parent = free_list_;
+  free_list_ = node;
+}
+
+Aabb AabbTree::Fatten(const Aabb& box, const glm::vec3 displacement) const {
+  Aabb fat = box;
+  fat.min -= glm::vec3(options_.margin);
+  fat.max += glm::vec3(options_.margin);
+  const glm::vec3 stretch = displacement * options_.displacement_multiplier;
+  fat.min += glm::min(stretch, glm::vec3(0.0f));
+  fat.max += glm::max(stretch, glm::vec3(0.0f));
+  return fat;
+}
+
+void AabbTree::InsertLeaf(const ProxyId leaf) {
+  if (root_ == kNullProxy) {
+    root_ = leaf;
+    nodes_[leaf].parent = kNullProxy;
+    return;
+  }
+
+  // Walk down choosing the child that grows the total surface area least
+  const Aabb leaf_box = nodes_[leaf].box;
+  ProxyId index = root_;
+  while (!nodes_[index].IsLeaf()) {
+    const Node& node = nodes_[index];
+    const float area = node.box.SurfaceArea();
+    const float combined_area = Aabb::Union(node.box, leaf_box).SurfaceArea();
+    // Cost of pairing the leaf with this node
+    const float cost = 2.0f * combined_area;
+    // Cost pushed down to the children by growing this node
+    const float inheritance_cost = 2.0f * (combined_area - area);
+
+    const auto descend_cost = [&](const ProxyId child) {
+      const Node& c = nodes_[child];
+      const float grown = Aabb::Union(c.box, leaf_box).SurfaceArea();
+      return (c.IsLeaf() ? grown : grown - c.box.SurfaceArea()) +
+             inheritance_cost;
+    };
+    const float cost1 = descend_cost(node.child1);
+    const float cost2 = descend_cost(node.child2);
+    if (cost < cost1 && cost < cost2) {
+      break;
+    }
+    index = cost1 < cost2 ? node.child1 : node.child2;
+  }
+  const ProxyId sibling = index;
+
+  const ProxyId old_parent = nodes_[sibling].parent;
+  const ProxyId new_parent = AllocateNode();
+  nodes_[new_parent].parent = old_parent;
+  nodes_[new_parent].box = Aabb::Union(leaf_box, nodes_[sibling].box);
+  nodes_[new_parent].height = nodes_[sibling].height + 1;
+  nodes_[new_parent].child1 = sibling;
+  nodes_[new_parent].child2 = leaf;
+  nodes_[sibling].parent = new_parent;
+  nodes_[leaf].parent = new_parent;
+  if (old_parent == kNullProxy) {
+    root_ = new_parent;
+  } else if (nodes_[old_parent].child1 == sibling) {
+    nodes_[old_parent].child1 = new_parent;
+  } else {
+    nodes_[old_parent].child2 = new_parent;
+  }
+
+  Refit(nodes_[leaf].parent);
+}
+
+void AabbTree::RemoveLeaf(const ProxyId leaf) {
+  if (leaf == root_) {
+    root_ = kNullProxy;
+    return;
+  }
+
+  const ProxyId parent = nodes_[leaf].parent;
+  const ProxyId grand_parent = nodes_[parent].parent;
+  const ProxyId sibling = nodes_[parent].child1 == leaf
+                              ? nodes_[parent].child2
+                              : nodes_[parent].child1;
+  FreeNode(parent);
+  nodes_[sibling].parent = grand_parent;
+  if (grand_parent == kNullProxy) {
+    root_ = sibling;
+    return;
+  }
+  if (nodes_[grand_parent].child1 == parent) {
+    nodes_[grand_parent].child1 = sibling;
+  } else {
+    nodes_[grand_parent].child2 = sibling;
+  }
+  Refit(grand_parent);
+}
+
+void AabbTree::Refit(ProxyId node) {
+  while (node != kNullProxy) {
+    node = Balance(node);
+    Node& n = nodes_[node];
+    n.height = 1 + std::max(nodes_[n.child1].height, nodes_[n.child2].height);
+    n.box = Aabb::Union(nodes_[n.child1].box, nodes_[n.child2].box);
+    node = n.parent;
+  }
+}
+
+AabbTree::ProxyId AabbTree::Balance(const ProxyId a) {
+  Node& node_a = nodes_[a];
+  if (node_a.IsLeaf() || node_a.height < 2) {
+    return a;
+  }
+  const ProxyId b = node_a.child1;
+  const ProxyId c = node_a.child2;
+  Node& node_b = nodes_[b];
+  Node& node_c = nodes_[c];
+  const std::int32_t balance = node_c.height - node_b.height;
+
+  // Rotates the taller child up to take the place of a.  "up" is the child
+  // being promoted, "other" the sibling staying under a.
+  const auto rotate = [&](const ProxyId up, Node& node_up, Node& node_other,
+                          ProxyId& a_slot) {
+    const ProxyId f = node_up.child1;
+    const ProxyId g = node_up.child2;
+    Node& node_f = nodes_[f];
+    Node& node_g = nodes_[g];
+
+    node_up.child1 = a;
+    node_up.parent = node_a.parent;
+    node_a.parent = up;
+    if (node_up.parent == kNullProxy) {
+      root_ = up;
+    } else if (nodes_[node_up.parent].child1 == a) {
+      nodes_[node_up.parent].child1 = up;
+    } else {
+      nodes_[node_up.parent].child2 = up;
+    }
+
+    // Keep the taller grandchild under the promoted node
+    const bool keep_f = node_f.height > node_g.height;
+    const ProxyId kept = keep_f ? f : g;
+    const ProxyId moved = keep_f ? g : f;
+    Node& node_kept = keep_f ? node_f : node_g;
+    Node& node_moved = keep_f ? node_g : node_f;
+    node_up.child2 = kept;
+    a_slot = moved;
+    node_moved.parent = a;
+    node_a.box = Aabb::Union(node_other.box, node_moved.box);
+    node_up.box = Aabb::Union(node_a.box, node_kept.box);
+    node_a.height = 1 + std::max(node_other.height, node_moved.height);
+    node_up.height = 1 + std::max(node_a.height, node_kept.height);
+  };
+
+  if (balance > 1) {
+    rotate(c, node_c, node_b, node_a.child2);
+    return c;
+  }
+  if (balance < -1) {
+    rotate(b, node_b, node_c, node_a.child1);
+    return b;
+  }
+  return a;
+}
+
+} /* namespace game_engine::_3D */
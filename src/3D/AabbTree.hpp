@@ -0,0 +1,234 @@
+/******************************************************************************
+ * AabbTree.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_3D_AABBTREE_HPP_
+#define SRC_3D_AABBTREE_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "3D/BoundingVolume.hpp"
+#include "3D/Frustum.hpp"
+
+namespace game_engine::_3D {
+
+/**
+ * @brief Options controlling how loosely proxies are fitted
+ */
+struct AabbTreeOptions {
+  /**
+   * @brief Distance every proxy box is grown by on each side
+   */
+  float margin = 0.1f;
+  /**
+   * @brief Boxes are also stretched along the last displacement times this,
+   *        so objects moving steadily are reinserted less often
+   */
+  float displacement_multiplier = 4.0f;
+};
+
+/**
+ * @brief Stack used by tree traversals
+ *
+ * Holds enough entries for any balanced tree inline, so queries do not touch
+ * the heap; a degenerate tree spills into a vector.
+ */
+template <typename T>
+class TraversalStack {
+ public:
+  void Push(const T& value) {
+    if (size_ < inline_.size()) {
+      inline_[size_] = value;
+    } else {
+      overflow_.push_back(value);
+    }
+    size_++;
+  }
+  T Pop() {
+    size_--;
+    if (size_ < inline_.size()) {
+      return inline_[size_];
+    }
+    T value = overflow_.back();
+    overflow_.pop_back();
+    return value;
+  }
+  bool Empty() const { return size_ == 0; }
+
+ protected:
+  std::array<T, 256> inline_;
+  std::vector<T> overflow_{};
+  std::size_t size_ = 0;
+};
+
+/**
+ * @brief Dynamic bounding volume hierarchy
+ *
+ * Each proxy is a leaf holding a fattened box and a user value.  Moving a
+ * proxy only touches the tree when its new box escapes the fat one, in which
+ * case the leaf is removed and reinserted using the surface area heuristic.
+ * Internal nodes are kept balanced with tree rotations, so queries visit
+ * O(log n) nodes.  Nodes live in a pool indexed by proxy id and freed nodes
+ * are recycled, so steady state updates and queries do not allocate.
+ */
+class AabbTree {
+ public:
+  using ProxyId = std::int32_t;
+  static constexpr ProxyId kNullProxy = -1;
+
+  AabbTree() = default;
+  explicit AabbTree(const AabbTreeOptions& options) : options_(options) {}
+
+  /**
+   * @brief Add a proxy
+   * @param box Tight bounds of the object
+   * @param user_data Value handed back by queries
+   * @return Returns the id of the new proxy
+   */
+  ProxyId CreateProxy(const Aabb& box, const std::uint32_t user_data);
+  void DestroyProxy(const ProxyId proxy);
+  /**
+   * @brief Update the bounds of a proxy
+   * @param box New tight bounds of the object
+   * @param displacement How far the object moved since the last update
+   * @return Returns true if the proxy had to be reinserted
+   */
+  bool MoveProxy(const ProxyId proxy, const Aabb& box,
+                 const glm::vec3 displacement = glm::vec3(0.0f));
+  void Clear();
+
+  std::uint32_t GetUserData(const ProxyId proxy) const {
+    return nodes_[proxy].user_data;
+  }
+  const Aabb& GetFatAabb(const ProxyId proxy) const {
+    return nodes_[proxy].box;
+  }
+  std::size_t GetProxyCount() const { return proxy_count_; }
+  /**
+   * @brief Height of the tree, 0 for a single leaf
+   */
+  int GetHeight() const;
+
+  /**
+   * @brief Report every proxy whose fat box overlaps a box
+   * @param callback Called as bool(ProxyId); return false to stop
+   */
+  template <typename Callback>
+  void Query(const Aabb& box, Callback&& callback) const;
+  /**
+   * @brief Report every proxy whose fat box overlaps a sphere
+   * @param callback Called as bool(ProxyId); return false to stop
+   */
+  template <typename Callback>
+  void Query(const BoundingSphere& sphere, Callback&& callback) const;
+  /**
+   * @brief Report every proxy whose fat box intersects a frustum
+   *
+   * Subtrees entirely inside the frustum are reported without testing planes.
+   * @param callback Called as bool(ProxyId); return false to stop
+   */
+  template <typename Callback>
+  void Query(const Frustum& frustum, Callback&& callback) const;
+  /**
+   * @brief Report proxies whose fat box is hit by a ray, nearest subtrees
+   *        first
+   * @param callback Called as float(ProxyId, const Ray&) with the ray clipped
+   *                 so far.  Return the distance of a hit to clip the ray to
+   *                 it, ray.max_distance to keep going, or 0 to stop.
+   */
+  template <typename Callback>
+  void RayCast(const Ray& ray, Callback&& callback) const;
+  /**
+   * @brief Find the proxy nearest to a point
+   * @param distance_squared Called as float(ProxyId) to compute the exact
+   *                         squared distance to an object
+   * @return Returns the nearest proxy within max_distance, if any
+   */
+  template <typename DistanceFunction>
+  std::optional<ProxyId> Nearest(const glm::vec3 point,
+                                 const float max_distance,
+                                 DistanceFunction&& distance_squared) const;
+  /**
+   * @brief Find the proxy whose fat box is nearest to a point
+   */
+  std::optional<ProxyId> Nearest(const glm::vec3 point,
+                                 const float max_distance) const;
+
+  /**
+   * @brief Check parent links, heights and that every box encloses its
+   *        children
+   */
+  bool Validate() const;
+
+  void swap(AabbTree& other) noexcept {
+    using std::swap;
+    swap(other.nodes_, nodes_);
+    swap(other.root_, root_);
+    swap(other.free_list_, free_list_);
+    swap(other.proxy_count_, proxy_count_);
+    swap(other.options_, options_);
+  }
+
+ protected:
+  struct Node {
+    Aabb box{};
+    std::uint32_t user_data = 0;
+    /**
+     * @brief Parent of a node in the tree, next node of a free one
+     */
+    ProxyId parent = kNullProxy;
+    ProxyId child1 = kNullProxy;
+    ProxyId child2 = kNullProxy;
+    /**
+     * @brief 0 for leaves, -1 for free nodes
+     */
+    std::int32_t height = -1;
+
+    bool IsLeaf() const { return child1 == kNullProxy; }
+  };
+
+  ProxyId AllocateNode();
+  void FreeNode(const ProxyId node);
+  void InsertLeaf(const ProxyId leaf);
+  void RemoveLeaf(const ProxyId leaf);
+  ProxyId Balance(const ProxyId node);
+  void Refit(ProxyId node);
+  Aabb Fatten(const Aabb& box, const glm::vec3 displacement) const;
+  bool ValidateNode(const ProxyId node) const;
+
+  std::vector<Node> nodes_{};
+  ProxyId root_ = kNullProxy;
+  ProxyId free_list_ = kNullProxy;
+  std::size_t proxy_count_ = 0;
+  AabbTreeOptions options_{};
+};
+
+inline void swap(AabbTree& a, AabbTree& b) noexcept { a.swap(b); }
+
+} /* namespace game_engine::_3D */
+
+#include "3D/AabbTree.tpp"
+
+#endif /* SRC_3D_AABBTREE_HPP_ */
@@ -0,0 +1,200 @@
+/******************************************************************************
+ * AabbTree.tpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_3D_AABBTREE_TPP_
+#define SRC_3D_AABBTREE_TPP_
+
+#include <glm/glm.hpp>
+
+#include "3D/AabbTree.hpp"
+
+namespace game_engine::_3D {
+
+template <typename Callback>
+void AabbTree::Query(const Aabb& box, Callback&& callback) const {
+  TraversalStack<ProxyId> stack;
+  stack.Push(root_);
+  while (!stack.Empty()) {
+    const ProxyId id = stack.Pop();
+    if (id == kNullProxy) {
+      continue;
+    }
+    const Node& node = nodes_[id];
+    if (!node.box.Overlaps(box)) {
+      continue;
+    }
+    if (node.IsLeaf()) {
+      if (!callback(id)) {
+        return;
+      }
+    } else {
+      stack.Push(node.child1);
+      stack.Push(node.child2);
+    }
+  }
+}
+
+template <typename Callback>
+void AabbTree::Query(const BoundingSphere& sphere, Callback&& callback) const {
+  TraversalStack<ProxyId> stack;
+  stack.Push(root_);
+  while (!stack.Empty()) {
+    const ProxyId id = stack.Pop();
+    if (id == kNullProxy) {
+      continue;
+    }
+    const Node& node = nodes_[id];
+    if (!sphere.Overlaps(node.box)) {
+      continue;
+    }
+    if (node.IsLeaf()) {
+      if (!callback(id)) {
+        return;
+      }
+    } else {
+      stack.Push(node.child1);
+      stack.Push(node.child2);
+    }
+  }
+}
+
+template <typename Callback>
+void AabbTree::Query(const Frustum& frustum, Callback&& callback) const {
+  // The sign bit of an entry marks a subtree already known to be inside
+  constexpr std::uint32_t kInside = 0x80000000u;
+  TraversalStack<std::uint32_t> stack;
+  if (root_ != kNullProxy) {
+    stack.Push(static_cast<std::uint32_t>(root_));
+  }
+  while (!stack.Empty()) {
+    const std::uint32_t entry = stack.Pop();
+    const ProxyId id = static_cast<ProxyId>(entry & ~kInside);
+    const Node& node = nodes_[id];
+    std::uint32_t inside = entry & kInside;
+    if (inside == 0) {
+      const Containment containment = frustum.Classify(node.box);
+      if (containment == Containment::OUTSIDE) {
+        continue;
+      }
+      if (containment == Containment::INSIDE) {
+        inside = kInside;
+      }
+    }
+    if (node.IsLeaf()) {
+      if (!callback(id)) {
+        return;
+      }
+    } else {
+      stack.Push(static_cast<std::uint32_t>(node.child1) | inside);
+      stack.Push(static_cast<std::uint32_t>(node.child2) | inside);
+    }
+  }
+}
+
+template <typename Callback>
+void AabbTree::RayCast(const Ray& ray, Callback&& callback) const {
+  Ray clipped = ray;
+  const glm::vec3 inverse_direction = 1.0f / ray.direction;
+  TraversalStack<ProxyId> stack;
+  stack.Push(root_);
+  while (!stack.Empty()) {
+    const ProxyId id = stack.Pop();
+    if (id == kNullProxy) {
+      continue;
+    }
+    const Node& node = nodes_[id];
+    float distance = 0.0f;
+    if (!clipped.Intersects(node.box, inverse_direction, &distance)) {
+      continue;
+    }
+    if (node.IsLeaf()) {
+      const float result = callback(id, static_cast<const Ray&>(clipped));
+      if (result <= 0.0f) {
+        return;
+      }
+      if (result < clipped.max_distance) {
+        clipped.max_distance = result;
+      }
+      continue;
+    }
+    // Visit the nearer child first so hits clip the ray as early as possible
+    float distance1 = 0.0f;
+    float distance2 = 0.0f;
+    const bool hit1 = clipped.Intersects(nodes_[node.child1].box,
+                                         inverse_direction, &distance1);
+    const bool hit2 = clipped.Intersects(nodes_[node.child2].box,
+                                         inverse_direction, &distance2);
+    if (hit1 && hit2) {
+      if (distance1 <= distance2) {
+        stack.Push(node.child2);
+        stack.Push(node.child1);
+      } else {
+        stack.Push(node.child1);
+        stack.Push(node.child2);
+      }
+    } else if (hit1) {
+      stack.Push(node.child1);
+    } else if (hit2) {
+      stack.Push(node.child2);
+    }
+  }
+}
+
+template <typename DistanceFunction>
+std::optional<AabbTree::ProxyId> AabbTree::Nearest(
+    const glm::vec3 point, const float max_distance,
+    DistanceFunction&& distance_squared) const {
+  std::optional<ProxyId> best{};
+  float best_distance = max_distance * max_distance;
+  TraversalStack<ProxyId> stack;
+  stack.Push(root_);
+  while (!stack.Empty()) {
+    const ProxyId id = stack.Pop();
+    if (id == kNullProxy) {
+      continue;
+    }
+    const Node& node = nodes_[id];
+    if (node.box.DistanceSquared(point) > best_distance) {
+      continue;
+    }
+    if (node.IsLeaf()) {
+      const float distance = distance_squared(id);
+      if (distance <= best_distance) {
+        best_distance = distance;
+        best = id;
+      }
+      continue;
+    }
+    // Push the farther child first so the nearer one shrinks the bound first
+    const float distance1 = nodes_[node.child1].box.DistanceSquared(point);
+    const float distance2 = nodes_[node.child2].box.DistanceSquared(point);
+    if (distance1 <= distance2) {
+      stack.Push(node.child2);
+      stack.Push(node.child1);
+    } else {
+      stack.Push(node.child1);
+      stack.Push(node.child2);
+    }
+  }
+  return best;
+}
+
+} /* namespace game_engine::_3D */
+
+#endif /* SRC_3D_AABBTREE_TPP_ */
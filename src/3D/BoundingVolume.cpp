@@ -0,0 +1,138 @@
+/******************************************************************************
+ * BoundingVolume.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/BoundingVolume.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace game_engine::_3D {
+
+Aabb Aabb::FromVertices(const std::vector<Vertex>& vertices) {
+  Aabb box;
+  for (const auto& vertex : vertices) {
+    box.Expand(vertex.position);
+  }
+  return box;
+}
+
+void Aabb::Expand(const glm::vec3 point) {
+  min = glm::min(min, point);
+  max = glm::max(max, point);
+}
+
+void Aabb::Expand(const Aabb& other) {
+  if (other.IsEmpty()) {
+    return;
+  }
+  min = glm::min(min, other.min);
+  max = glm::max(max, other.max);
+}
+
+Aabb Aabb::Transform(const glm::mat4& matrix) const {
+  if (IsEmpty()) {
+    return *this;
+  }
+  // Arvo's method: the new half extents are the old ones multiplied by the
+  // absolute value of the rotation/scale part of the matrix.
+  const glm::vec3 center = Center();
+  const glm::vec3 extents = Extents();
+  const glm::vec3 new_center = glm::vec3(matrix * glm::vec4(center, 1.0f));
+  glm::vec3 new_extents(0.0f);
+  for (int column = 0; column < 3; column++) {
+    new_extents += glm::abs(glm::vec3(matrix[column])) * extents[column];
+  }
+  Aabb result;
+  result.min = new_center - new_extents;
+  result.max = new_center + new_extents;
+  return result;
+}
+
+std::ostream& operator<<(std::ostream& os, const Aabb& box) {
+  return os << "Aabb {\n"
+            << "glm::vec3 min = " << box.min << "\n"
+            << "glm::vec3 max = " << box.max << "\n"
+            << "}";
+}
+
+BoundingSphere BoundingSphere::FromVertices(const std::vector<Vertex>& vertices,
+                                            const Aabb& bounds) {
+  BoundingSphere sphere;
+  if (bounds.IsEmpty()) {
+    return sphere;
+  }
+  sphere.center = bounds.Center();
+  float radius_squared = 0.0f;
+  for (const auto& vertex : vertices) {
+    const glm::vec3 offset = vertex.position - sphere.center;
+    radius_squared = std::max(radius_squared, glm::dot(offset, offset));
+  }
+  sphere.radius = std::sqrt(radius_squared);
+  return sphere;
+}
+
+BoundingSphere BoundingSphere::Transform(const glm::mat4& matrix) const {
+  BoundingSphere result;
+  result.center = glm::vec3(matrix * glm::vec4(center, 1.0f));
+  const float scale = std::max({glm::length(glm::vec3(matrix[0])),
+                                glm::length(glm::vec3(matrix[1])),
+                                glm::length(glm::vec3(matrix[2]))});
+  result.radius = radius * scale;
+  return result;
+}
+
+std::ostream& operator<<(std::ostream& os, const BoundingSphere& sphere) {
+  return os << "BoundingSphere {\n"
+            << "glm::vec3 center = " << sphere.center << "\n"
+            << "float radius = " << sphere.radius << "\n"
+            << "}";
+}
+
+bool Ray::Intersects(const Aabb& box, const glm::vec3 inverse_direction,
+                     float* distance) const {
+  float t_min = 0.0f;
+  float t_max = max_distance;
+  for (int axis = 0; axis < 3; axis++) {
+    float t0 = (box.min[axis] - origin[axis]) * inverse_direction[axis];
+    float t1 = (box.max[axis] - origin[axis]) * inverse_direction[axis];
+    if (t0 > t1) {
+      std::swap(t0, t1);
+    }
+    // Written so that NaN from a zero direction inside the slab is ignored
+    t_min = t0 > t_min ? t0 : t_min;
+    t_max = t1 < t_max ? t1 : t_max;
+    if (t_min > t_max) {
+      return false;
+    }
+  }
+  *distance = t_min;
+  return true;
+}
+
+std::ostream& operator<<(std::ostream& os, const Ray& ray) {
+  return os << "Ray {\n"
+            << "glm::vec3 origin = " << ray.origin << "\n"
+            << "glm::vec3 direction = " << ray.direction << "\n"
+            << "float max_distance = " << ray.max_distance << "\n"
+            << "}";
+}
+
+} /* namespace game_engine::_3D */
@@ -0,0 +1,159 @@
+/******************************************************************************
+ * BoundingVolume.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_3D_BOUNDINGVOLUME_HPP_
+#define SRC_3D_BOUNDINGVOLUME_HPP_
+
+#include <limits>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Vertex.hpp"
+
+namespace game_engine::_3D {
+
+/**
+ * @brief Axis aligned bounding box
+ *
+ * A default constructed box is empty (min > max) so that it can be grown with
+ * Expand.
+ */
+struct Aabb {
+  glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+  glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+
+  static Aabb FromVertices(const std::vector<Vertex>& vertices);
+
+  bool IsEmpty() const {
+    return min.x > max.x || min.y > max.y || min.z > max.z;
+  }
+  glm::vec3 Center() const { return (min + max) * 0.5f; }
+  glm::vec3 Extents() const { return (max - min) * 0.5f; }
+
+  void Expand(const glm::vec3 point);
+  void Expand(const Aabb& other);
+
+  static Aabb Union(const Aabb& a, const Aabb& b) {
+    Aabb box;
+    box.min = glm::min(a.min, b.min);
+    box.max = glm::max(a.max, b.max);
+    return box;
+  }
+  bool Contains(const Aabb& other) const {
+    return min.x <= other.min.x && min.y <= other.min.y &&
+           min.z <= other.min.z && other.max.x <= max.x &&
+           other.max.y <= max.y && other.max.z <= max.z;
+  }
+  bool Overlaps(const Aabb& other) const {
+    return min.x <= other.max.x && other.min.x <= max.x &&
+           min.y <= other.max.y && other.min.y <= max.y &&
+           min.z <= other.max.z && other.min.z <= max.z;
+  }
+  /**
+   * @brief Squared distance from a point to the box, 0 if it is inside
+   */
+  float DistanceSquared(const glm::vec3 point) const {
+    const glm::vec3 offset =
+        glm::max(glm::max(min - point, point - max), glm::vec3(0.0f));
+    return glm::dot(offset, offset);
+  }
+  float SurfaceArea() const {
+    const glm::vec3 size = max - min;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+  }
+
+  /**
+   * @brief Transform the box and return the box that encloses the result
+   * @param matrix Affine transform, normally Transformations::model_
+   */
+  Aabb Transform(const glm::mat4& matrix) const;
+
+  void swap(Aabb& other) noexcept {
+    using std::swap;
+    swap(other.min, min);
+    swap(other.max, max);
+  }
+};
+
+inline void swap(Aabb& a, Aabb& b) noexcept { a.swap(b); }
+std::ostream& operator<<(std::ostream& os, const Aabb& box);
+
+/**
+ * @brief Bounding sphere
+ */
+struct BoundingSphere {
+  glm::vec3 center = glm::vec3(0.0f);
+  float radius = 0.0f;
+
+  /**
+   * @brief Sphere centered on the box that encloses every vertex
+   */
+  static BoundingSphere FromVertices(const std::vector<Vertex>& vertices,
+                                     const Aabb& bounds);
+
+  bool Overlaps(const Aabb& box) const {
+    return box.DistanceSquared(center) <= radius * radius;
+  }
+
+  /**
+   * @brief Transform the sphere, scaling the radius by the largest axis scale
+   * @param matrix Affine transform, normally Transformations::model_
+   */
+  BoundingSphere Transform(const glm::mat4& matrix) const;
+
+  void swap(BoundingSphere& other) noexcept {
+    using std::swap;
+    swap(other.center, center);
+    swap(other.radius, radius);
+  }
+};
+
+inline void swap(BoundingSphere& a, BoundingSphere& b) noexcept { a.swap(b); }
+std::ostream& operator<<(std::ostream& os, const BoundingSphere& sphere);
+
+/**
+ * @brief Ray segment from origin along direction, up to max_distance
+ *
+ * direction does not need to be normalized; distances are measured in
+ * multiples of it.
+ */
+struct Ray {
+  glm::vec3 origin = glm::vec3(0.0f);
+  glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+  float max_distance = std::numeric_limits<float>::max();
+
+  /**
+   * @brief Slab test against a box
+   * @param box Box to test
+   * @param inverse_direction 1 / direction, computed once per query
+   * @param distance Set to the distance at which the ray enters the box, or 0
+   *                 if the origin is inside it
+   */
+  bool Intersects(const Aabb& box, const glm::vec3 inverse_direction,
+                  float* distance) const;
+};
+
+std::ostream& operator<<(std::ostream& os, const Ray& ray);
+
+} /* namespace game_engine::_3D */
+
+#endif /* SRC_3D_BOUNDINGVOLUME_HPP_ */
@@ -73,4 +73,17 @@ void Camera::UpdateProjection(glm::ivec2 size) {
       glm::radians(fov_),
       static_cast<float>(size.x) / static_cast<float>(size.y), 0.1f, 100.0f);
 }
+float Camera::ProjectedSize(const Aabb& box) const {
+  if (box.IsEmpty()) {
+    return 0.0f;
+  }
+  const float radius = glm::length(box.Extents());
+  const float distance = glm::distance(box.Center(), camera_pos_);
+  if (distance <= radius) {
+    return 1.0f;
+  }
+  // projection_[1][1] is cot(fov / 2), so this is the projected diameter over
+  // the screen height
+  return radius * projection_[1][1] / distance;
+}
 } /* namespace game_engine::_3D */
@@ -27,6 +27,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "3D/Cube.hpp"
+#include "3D/Frustum.hpp"
 #include "3D/Model.hpp"
 #include "3D/Skybox.hpp"
 
@@ -43,6 +44,21 @@ class Camera {
   void UpdateView();
   void UpdateProjection(glm::ivec2 size);
 
+  /**
+   * @brief The frustum of the current view_ and projection_
+   */
+  Frustum GetFrustum() const { return Frustum(view_, projection_); }
+  /**
+   * @brief Meshes tested and drawn by DrawModel since the last ResetCullStats
+   */
+  const CullStats& GetCullStats() const { return cull_stats_; }
+  void ResetCullStats() { cull_stats_.Reset(); }
+  /**
+   * @brief Projected height of a world space box as a fraction of the screen
+   *        height, 1 or more if the camera is inside it
+   */
+  float ProjectedSize(const Aabb& box) const;
+
   template <typename Renderer>
   void DrawModel(const Renderer& renderer, Model& model,
                  ShaderPrograms shaders = ShaderPrograms::DEFAULT);
@@ -68,6 +84,15 @@ class Camera {
   glm::mat4 projection_ = glm::mat4(1.0f);
 
   bool valid_ = false;
+  /**
+   * @brief Skip meshes of models outside the view frustum
+   */
+  bool culling_enabled_ = true;
+  CullStats cull_stats_{};
+  /**
+   * @brief Select the LOD of models by their projected size
+   */
+  bool lod_enabled_ = true;
 
   void swap(Camera& other) noexcept {
     using std::swap;
@@ -82,6 +107,9 @@ class Camera {
     swap(other.camera_up_, camera_up_);
     swap(other.view_, view_);
     swap(other.projection_, projection_);
+    swap(other.culling_enabled_, culling_enabled_);
+    swap(other.cull_stats_, cull_stats_);
+    swap(other.lod_enabled_, lod_enabled_);
   }
 };
 
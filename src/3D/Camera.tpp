@@ -28,7 +28,14 @@ template <typename Renderer>
 void Camera::DrawModel(const Renderer& renderer, Model& model,
                        ShaderPrograms shaders) {
   renderer.SetMatrices(shaders, model.model_, view_, projection_);
-  model.Draw(renderer, shaders);
+  if (lod_enabled_) {
+    model.SelectLod(ProjectedSize(model.GetBounds()));
+  }
+  if (culling_enabled_) {
+    model.Draw(renderer, shaders, GetFrustum(), &cull_stats_);
+  } else {
+    model.Draw(renderer, shaders);
+  }
 }
 
 template <typename Renderer>
@@ -0,0 +1,399 @@
+/******************************************************************************
+ * FrameGraph.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/FrameGraph.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace game_engine::_3D {
+
+std::ostream& operator<<(std::ostream& os, const FrameResourceUsage usage) {
+  switch (usage) {
+    case FrameResourceUsage::COLOR_ATTACHMENT:
+      return os << "FrameResourceUsage::COLOR_ATTACHMENT";
+    case FrameResourceUsage::DEPTH_ATTACHMENT:
+      return os << "FrameResourceUsage::DEPTH_ATTACHMENT";
+    case FrameResourceUsage::SAMPLED:
+      return os << "FrameResourceUsage::SAMPLED";
+    case FrameResourceUsage::STORAGE:
+      return os << "FrameResourceUsage::STORAGE";
+    case FrameResourceUsage::VERTEX_BUFFER:
+      return os << "FrameResourceUsage::VERTEX_BUFFER";
+    case FrameResourceUsage::INDEX_BUFFER:
+      return os << "FrameResourceUsage::INDEX_BUFFER";
+    case FrameResourceUsage::INDIRECT_BUFFER:
+      return os << "FrameResourceUsage::INDIRECT_BUFFER";
+    case FrameResourceUsage::UNIFORM_BUFFER:
+      return os << "FrameResourceUsage::UNIFORM_BUFFER";
+    case FrameResourceUsage::COPY:
+      return os << "FrameResourceUsage::COPY";
+  }
+  return os;
+}
+
+FrameResourceId FrameGraphBuilder::CreateTexture(
+    const std::string& name, const TransientTextureDesc& desc) {
+  FrameGraph::Resource resource;
+  resource.name = name;
+  resource.texture = true;
+  resource.texture_desc = desc;
+  return graph_->AddResource(std::move(resource));
+}
+
+FrameResourceId FrameGraphBuilder::CreateBuffer(
+    const std::string& name, const TransientBufferDesc& desc) {
+  FrameGraph::Resource resource;
+  resource.name = name;
+  resource.texture = false;
+  resource.buffer_desc = desc;
+  return graph_->AddResource(std::move(resource));
+}
+
+FrameResourceId FrameGraphBuilder::Read(const FrameResourceId resource,
+                                        const FrameResourceUsage usage) {
+  graph_->AddAccess(pass_, resource, usage, false);
+  return resource;
+}
+
+FrameResourceId FrameGraphBuilder::Write(const FrameResourceId resource,
+                                         const FrameResourceUsage usage) {
+  graph_->AddAccess(pass_, resource, usage, true);
+  return resource;
+}
+
+void FrameGraphBuilder::SetClear(const glm::vec4 color) {
+  graph_->passes_[pass_].clear = true;
+  graph_->passes_[pass_].clear_color = color;
+}
+
+void FrameGraphBuilder::SetSideEffect() {
+  graph_->passes_[pass_].side_effect = true;
+}
+
+unsigned int FrameGraphResources::GetTexture(
+    const FrameResourceId resource) const {
+  return graph_->resources_.at(resource).id;
+}
+
+unsigned int FrameGraphResources::GetBuffer(
+    const FrameResourceId resource) const {
+  return graph_->resources_.at(resource).id;
+}
+
+const TransientTextureDesc& FrameGraphResources::GetTextureDesc(
+    const FrameResourceId resource) const {
+  return graph_->resources_.at(resource).texture_desc;
+}
+
+const TransientBufferDesc& FrameGraphResources::GetBufferDesc(
+    const FrameResourceId resource) const {
+  return graph_->resources_.at(resource).buffer_desc;
+}
+
+void FrameGraph::AddPass(const std::string& name, const SetupFunction& setup,
+                         ExecuteFunction execute) {
+  Pass pass;
+  pass.name = name;
+  pass.execute = std::move(execute);
+  passes_.push_back(std::move(pass));
+  compiled_ = false;
+  FrameGraphBuilder builder(this, passes_.size() - 1);
+  setup(builder);
+}
+
+FrameResourceId FrameGraph::ImportTexture(const std::string& name,
+                                          const unsigned int id,
+                                          const TransientTextureDesc& desc) {
+  Resource resource;
+  resource.name = name;
+  resource.texture = true;
+  resource.imported = true;
+  resource.texture_desc = desc;
+  resource.id = id;
+  return AddResource(std::move(resource));
+}
+
+FrameResourceId FrameGraph::ImportBackbuffer(const std::string& name,
+                                             const glm::ivec2 size) {
+  Resource resource;
+  resource.name = name;
+  resource.texture = true;
+  resource.imported = true;
+  resource.backbuffer = true;
+  resource.texture_desc.size = size;
+  return AddResource(std::move(resource));
+}
+
+FrameResourceId FrameGraph::ImportRenderTarget(const std::string& name,
+                                               const unsigned int target,
+                                               const RenderTargetDesc& desc) {
+  Resource resource;
+  resource.name = name;
+  resource.texture = true;
+  resource.imported = true;
+  resource.render_target = target;
+  resource.texture_desc.size = desc.size;
+  resource.texture_desc.format = desc.color_format;
+  return AddResource(std::move(resource));
+}
+
+FrameResourceId FrameGraph::ImportBuffer(const std::string& name,
+                                         const unsigned int id,
+                                         const TransientBufferDesc& desc) {
+  Resource resource;
+  resource.name = name;
+  resource.texture = false;
+  resource.imported = true;
+  resource.buffer_desc = desc;
+  resource.id = id;
+  return AddResource(std::move(resource));
+}
+
+void FrameGraph::MarkOutput(const FrameResourceId resource) {
+  resources_.at(resource).output = true;
+  compiled_ = false;
+}
+
+FrameResourceId FrameGraph::AddResource(Resource resource) {
+  resources_.push_back(std::move(resource));
+  compiled_ = false;
+  return static_cast<FrameResourceId>(resources_.size() - 1);
+}
+
+void FrameGraph::AddAccess(const std::size_t pass,
+                           const FrameResourceId resource,
+                           const FrameResourceUsage usage, const bool write) {
+  if (resource >= resources_.size()) {
+    throw std::out_of_range("Pass " + passes_[pass].name +
+                            " accesses an unknown frame graph resource");
+  }
+  passes_[pass].accesses.push_back(Access{resource, usage, write});
+}
+
+void FrameGraph::Compile() {
+  CullPasses();
+  AssignAllocations();
+  BuildTargetsAndBarriers();
+  compiled_ = true;
+}
+
+void FrameGraph::Reset() {
+  passes_.clear();
+  resources_.clear();
+  allocations_.clear();
+  compiled_ = false;
+}
+
+std::size_t FrameGraph::GetCulledPassCount() const {
+  return static_cast<std::size_t>(
+      std::count_if(passes_.begin(), passes_.end(),
+                    [](const Pass& pass) { return pass.culled; }));
+}
+
+bool FrameGraph::IsPassCulled(const std::size_t pass) const {
+  return passes_.at(pass).culled;
+}
+
+void FrameGraph::CullPasses() {
+  // Walk backwards from what must be produced, keeping each pass that writes
+  // something a kept pass or the outside world needs
+  std::vector<bool> needed(resources_.size(), false);
+  for (std::size_t r = 0; r < resources_.size(); r++) {
+    needed[r] = resources_[r].output || resources_[r].imported;
+  }
+  for (std::size_t p = passes_.size(); p-- > 0;) {
+    Pass& pass = passes_[p];
+    bool live = pass.side_effect;
+    for (const auto& access : pass.accesses) {
+      live |= access.write && needed[access.resource];
+    }
+    pass.culled = !live;
+    if (!live) {
+      continue;
+    }
+    for (const auto& access : pass.accesses) {
+      if (!access.write) {
+        needed[access.resource] = true;
+      }
+    }
+  }
+}
+
+void FrameGraph::AssignAllocations() {
+  allocations_.clear();
+  for (auto& resource : resources_) {
+    resource.first_pass = std::numeric_limits<std::size_t>::max();
+    resource.last_pass = 0;
+    resource.allocation = std::numeric_limits<std::size_t>::max();
+  }
+  for (std::size_t p = 0; p < passes_.size(); p++) {
+    if (passes_[p].culled) {
+      continue;
+    }
+    for (const auto& access : passes_[p].accesses) {
+      Resource& resource = resources_[access.resource];
+      resource.first_pass = std::min(resource.first_pass, p);
+      resource.last_pass = std::max(resource.last_pass, p);
+    }
+  }
+
+  std::vector<FrameResourceId> transient;
+  for (FrameResourceId r = 0; r < resources_.size(); r++) {
+    const Resource& resource = resources_[r];
+    if (!resource.imported &&
+        resource.first_pass != std::numeric_limits<std::size_t>::max()) {
+      transient.push_back(r);
+    }
+  }
+  std::stable_sort(transient.begin(), transient.end(),
+                   [this](const FrameResourceId a, const FrameResourceId b) {
+                     return resources_[a].first_pass <
+                            resources_[b].first_pass;
+                   });
+
+  // Greedy interval packing: reuse any allocation whose last user finished
+  // before this resource's first user
+  for (const auto r : transient) {
+    Resource& resource = resources_[r];
+    std::size_t best = std::numeric_limits<std::size_t>::max();
+    for (std::size_t a = 0; a < allocations_.size(); a++) {
+      const Allocation& allocation = allocations_[a];
+      if (allocation.texture != resource.texture ||
+          allocation.last_pass >= resource.first_pass) {
+        continue;
+      }
+      if (resource.texture) {
+        if (allocation.texture_desc == resource.texture_desc) {
+          best = a;
+          break;
+        }
+      } else if (best == std::numeric_limits<std::size_t>::max() ||
+                 allocation.buffer_desc.size >
+                     allocations_[best].buffer_desc.size) {
+        best = a;
+      }
+    }
+    if (best == std::numeric_limits<std::size_t>::max()) {
+      Allocation allocation;
+      allocation.texture = resource.texture;
+      allocation.texture_desc = resource.texture_desc;
+      allocations_.push_back(allocation);
+      best = allocations_.size() - 1;
+    }
+    Allocation& allocation = allocations_[best];
+    allocation.buffer_desc.size =
+        std::max(allocation.buffer_desc.size, resource.buffer_desc.size);
+    allocation.last_pass = resource.last_pass;
+    resource.allocation = best;
+  }
+}
+
+void FrameGraph::BuildTargetsAndBarriers() {
+  // Per resource, the last write and the usages that read it since
+  struct History {
+    bool written = false;
+    FrameResourceUsage write_usage = FrameResourceUsage::COLOR_ATTACHMENT;
+    std::uint32_t read_usages = 0;
+    FrameResourceUsage last_read = FrameResourceUsage::COLOR_ATTACHMENT;
+  };
+  std::vector<History> history(resources_.size());
+
+  for (auto& pass : passes_) {
+    pass.barriers.clear();
+    pass.targets = FramePassTargets{};
+    pass.bind_targets = false;
+    if (pass.culled) {
+      continue;
+    }
+    for (const auto& access : pass.accesses) {
+      History& h = history[access.resource];
+      const std::uint32_t bit = 1u << static_cast<std::uint32_t>(access.usage);
+      FrameBarrier barrier;
+      barrier.resource = access.resource;
+      barrier.texture = resources_[access.resource].texture;
+      barrier.after = access.usage;
+      bool needed = false;
+      if (!access.write) {
+        // Each usage only has to wait for the last write once
+        needed = h.written && (h.read_usages & bit) == 0;
+        barrier.before = h.write_usage;
+        barrier.before_write = true;
+        h.read_usages |= bit;
+        h.last_read = access.usage;
+      } else {
+        if (h.read_usages != 0) {
+          needed = true;
+          barrier.before = h.last_read;
+        } else if (h.written) {
+          needed = h.write_usage != access.usage ||
+                   access.usage == FrameResourceUsage::STORAGE;
+          barrier.before = h.write_usage;
+          barrier.before_write = true;
+        }
+        h.written = true;
+        h.write_usage = access.usage;
+        h.read_usages = 0;
+      }
+      if (needed) {
+        pass.barriers.push_back(barrier);
+      }
+
+      if (!access.write ||
+          (access.usage != FrameResourceUsage::COLOR_ATTACHMENT &&
+           access.usage != FrameResourceUsage::DEPTH_ATTACHMENT)) {
+        continue;
+      }
+      const Resource& resource = resources_[access.resource];
+      pass.bind_targets = true;
+      pass.targets.backbuffer |= resource.backbuffer;
+      if (resource.render_target != 0) {
+        pass.targets.render_target = resource.render_target;
+      }
+      if (pass.targets.size == glm::ivec2(0, 0)) {
+        pass.targets.size = resource.texture_desc.size;
+      }
+    }
+    pass.targets.clear = pass.clear;
+    pass.targets.clear_color = pass.clear_color;
+  }
+}
+
+std::size_t FrameGraph::FindPooled(const Allocation& allocation) const {
+  std::size_t best = std::numeric_limits<std::size_t>::max();
+  for (std::size_t i = 0; i < pool_.size(); i++) {
+    const Pooled& pooled = pool_[i];
+    if (pooled.in_use || pooled.texture != allocation.texture) {
+      continue;
+    }
+    if (allocation.texture) {
+      if (pooled.texture_desc == allocation.texture_desc) {
+        return i;
+      }
+    } else if (pooled.buffer_desc.size >= allocation.buffer_desc.size &&
+               (best == std::numeric_limits<std::size_t>::max() ||
+                pooled.buffer_desc.size < pool_[best].buffer_desc.size)) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+} /* namespace game_engine::_3D */
@@ -0,0 +1,368 @@
+/******************************************************************************
+ * FrameGraph.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_3D_FRAMEGRAPH_HPP_
+#define SRC_3D_FRAMEGRAPH_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "3D/PixelFormat.hpp"
+#include "3D/RenderTarget.hpp"
+
+namespace game_engine::_3D {
+
+/**
+ * @brief Handle of a texture or buffer declared in a FrameGraph
+ */
+using FrameResourceId = std::uint32_t;
+inline constexpr FrameResourceId kNullFrameResource =
+    std::numeric_limits<FrameResourceId>::max();
+
+/**
+ * @brief How a pass accesses a resource
+ */
+enum class FrameResourceUsage : std::uint8_t {
+  COLOR_ATTACHMENT,
+  DEPTH_ATTACHMENT,
+  SAMPLED,
+  STORAGE,
+  VERTEX_BUFFER,
+  INDEX_BUFFER,
+  INDIRECT_BUFFER,
+  UNIFORM_BUFFER,
+  COPY
+};
+std::ostream& operator<<(std::ostream& os, const FrameResourceUsage usage);
+
+struct TransientTextureDesc {
+  glm::ivec2 size{0, 0};
+  PixelFormat format{};
+};
+
+inline bool operator==(const TransientTextureDesc& a,
+                       const TransientTextureDesc& b) {
+  return a.size == b.size && a.format.i_format == b.format.i_format &&
+         a.format.e_format == b.format.e_format;
+}
+inline bool operator!=(const TransientTextureDesc& a,
+                       const TransientTextureDesc& b) {
+  return !(a == b);
+}
+
+struct TransientBufferDesc {
+  std::size_t size = 0;
+};
+
+/**
+ * @brief A change in how a resource is used between two passes, which the
+ *        backend may need to synchronize
+ */
+struct FrameBarrier {
+  FrameResourceId resource = kNullFrameResource;
+  bool texture = true;
+  /**
+   * @brief Backend handle of the resource
+   */
+  unsigned int id = 0;
+  FrameResourceUsage before = FrameResourceUsage::COLOR_ATTACHMENT;
+  FrameResourceUsage after = FrameResourceUsage::COLOR_ATTACHMENT;
+  /**
+   * @brief Whether the previous access wrote to the resource
+   */
+  bool before_write = false;
+};
+
+/**
+ * @brief Attachments a pass renders to, bound by the backend before the
+ *        pass runs
+ */
+struct FramePassTargets {
+  /**
+   * @brief Backend handles of the color attachments, in declaration order
+   */
+  std::vector<unsigned int> colors{};
+  unsigned int depth = 0;
+  bool has_depth = false;
+  /**
+   * @brief Render to the window instead of the attachments
+   */
+  bool backbuffer = false;
+  /**
+   * @brief Render target created with CreateRenderTarget to render to
+   *        instead of the attachments, 0 for none
+   */
+  unsigned int render_target = 0;
+  glm::ivec2 size{0, 0};
+  bool clear = false;
+  glm::vec4 clear_color{0.0f, 0.0f, 0.0f, 1.0f};
+};
+
+struct FramePassTiming {
+  std::string name{};
+  double cpu_ms = 0.0;
+  /**
+   * @brief GPU time of the pass from the most recent frame whose results are
+   *        available, negative if none are yet
+   */
+  double gpu_ms = -1.0;
+};
+
+class FrameGraph;
+
+/**
+ * @brief Declares the resources a pass creates, reads and writes
+ */
+class FrameGraphBuilder {
+ public:
+  FrameResourceId CreateTexture(const std::string& name,
+                                const TransientTextureDesc& desc);
+  FrameResourceId CreateBuffer(const std::string& name,
+                               const TransientBufferDesc& desc);
+  FrameResourceId Read(const FrameResourceId resource,
+                       const FrameResourceUsage usage);
+  FrameResourceId Write(const FrameResourceId resource,
+                        const FrameResourceUsage usage);
+  /**
+   * @brief Clear the pass's attachments before it runs
+   */
+  void SetClear(const glm::vec4 color);
+  /**
+   * @brief Never cull the pass, even if nothing reads what it writes
+   */
+  void SetSideEffect();
+
+ protected:
+  FrameGraphBuilder(FrameGraph* graph, const std::size_t pass)
+      : graph_(graph), pass_(pass) {}
+
+  FrameGraph* graph_;
+  std::size_t pass_;
+
+  friend class FrameGraph;
+};
+
+/**
+ * @brief Backend handles of the resources of a pass while it runs
+ */
+class FrameGraphResources {
+ public:
+  unsigned int GetTexture(const FrameResourceId resource) const;
+  unsigned int GetBuffer(const FrameResourceId resource) const;
+  const TransientTextureDesc& GetTextureDesc(
+      const FrameResourceId resource) const;
+  const TransientBufferDesc& GetBufferDesc(
+      const FrameResourceId resource) const;
+
+ protected:
+  explicit FrameGraphResources(const FrameGraph* graph) : graph_(graph) {}
+
+  const FrameGraph* graph_;
+
+  friend class FrameGraph;
+};
+
+/**
+ * @brief Schedules the render passes of a frame
+ *
+ * Each frame, passes are added in execution order with a setup function that
+ * declares the transient textures and buffers they create, read and write,
+ * and an execute function that records their work.  Compile then:
+ *
+ * - culls passes that contribute nothing to an output, an imported resource
+ *   or a pass with side effects,
+ * - computes the lifetime of each transient resource and assigns resources
+ *   whose lifetimes do not overlap to the same backend allocation,
+ * - derives the attachments to bind and the barriers needed before each
+ *   pass.
+ *
+ * Execute runs the remaining passes on a backend and times each one.
+ * Allocations are pooled across frames and released after going unused for
+ * kPoolFrames frames.  The graph itself has no dependency on a rendering
+ * API; the backend must provide:
+ *
+ *     unsigned int CreateTransientTexture(const TransientTextureDesc&)
+ *     void DestroyTransientTexture(unsigned int)
+ *     unsigned int CreateTransientBuffer(const TransientBufferDesc&)
+ *     void DestroyTransientBuffer(unsigned int)
+ *     void BindFrameTargets(const FramePassTargets&)
+ *     unsigned int GetRenderTargetTexture(unsigned int)
+ *     void ResolveRenderTarget(unsigned int)
+ *     void InsertFrameBarrier(const FrameBarrier&)
+ *     void BeginPassTimer(const std::string&)
+ *     void EndPassTimer(const std::string&)
+ *     double GetPassGpuTime(const std::string&)
+ */
+class FrameGraph {
+ public:
+  using SetupFunction = std::function<void(FrameGraphBuilder&)>;
+  using ExecuteFunction = std::function<void(const FrameGraphResources&)>;
+
+  static constexpr std::uint32_t kPoolFrames = 3;
+
+  /**
+   * @brief Add a pass, calling setup immediately to declare its resources
+   */
+  void AddPass(const std::string& name, const SetupFunction& setup,
+               ExecuteFunction execute);
+
+  /**
+   * @brief Use a texture owned outside the graph.  Passes writing it are
+   *        never culled.
+   */
+  FrameResourceId ImportTexture(const std::string& name, const unsigned int id,
+                                const TransientTextureDesc& desc);
+  /**
+   * @brief The window's default framebuffer
+   */
+  FrameResourceId ImportBackbuffer(const std::string& name,
+                                   const glm::ivec2 size);
+  /**
+   * @brief A render target created with the backend's CreateRenderTarget.
+   *        Passes writing it render through its own framebuffer, which is
+   *        resolved after each of them, and passes reading it sample its
+   *        color texture.
+   */
+  FrameResourceId ImportRenderTarget(const std::string& name,
+                                     const unsigned int target,
+                                     const RenderTargetDesc& desc);
+  FrameResourceId ImportBuffer(const std::string& name, const unsigned int id,
+                               const TransientBufferDesc& desc);
+  /**
+   * @brief Keep the passes producing a transient resource
+   */
+  void MarkOutput(const FrameResourceId resource);
+
+  void Compile();
+  template <typename Backend>
+  void Execute(Backend& backend);
+  /**
+   * @brief Forget this frame's passes and resources, keeping the pool
+   */
+  void Reset();
+  /**
+   * @brief Destroy every pooled allocation
+   */
+  template <typename Backend>
+  void ReleasePool(Backend& backend);
+
+  const std::vector<FramePassTiming>& GetTimings() const { return timings_; }
+  std::size_t GetPassCount() const { return passes_.size(); }
+  std::size_t GetCulledPassCount() const;
+  bool IsPassCulled(const std::size_t pass) const;
+  /**
+   * @brief Number of allocations the transient resources were packed into
+   */
+  std::size_t GetAllocationCount() const { return allocations_.size(); }
+  std::size_t GetPooledCount() const { return pool_.size(); }
+
+ protected:
+  struct Access {
+    FrameResourceId resource;
+    FrameResourceUsage usage;
+    bool write;
+  };
+
+  struct Pass {
+    std::string name{};
+    ExecuteFunction execute{};
+    std::vector<Access> accesses{};
+    bool side_effect = false;
+    bool clear = false;
+    glm::vec4 clear_color{0.0f, 0.0f, 0.0f, 1.0f};
+    bool culled = false;
+    FramePassTargets targets{};
+    bool bind_targets = false;
+    std::vector<FrameBarrier> barriers{};
+  };
+
+  struct Resource {
+    std::string name{};
+    bool texture = true;
+    bool imported = false;
+    bool backbuffer = false;
+    unsigned int render_target = 0;
+    bool output = false;
+    TransientTextureDesc texture_desc{};
+    TransientBufferDesc buffer_desc{};
+    /**
+     * @brief Backend handle, set on import or when allocated
+     */
+    unsigned int id = 0;
+    std::size_t first_pass = std::numeric_limits<std::size_t>::max();
+    std::size_t last_pass = 0;
+    std::size_t allocation = std::numeric_limits<std::size_t>::max();
+  };
+
+  /**
+   * @brief One backend allocation shared by transient resources with
+   *        disjoint lifetimes
+   */
+  struct Allocation {
+    bool texture = true;
+    TransientTextureDesc texture_desc{};
+    TransientBufferDesc buffer_desc{};
+    std::size_t last_pass = 0;
+    std::size_t pooled = std::numeric_limits<std::size_t>::max();
+  };
+
+  struct Pooled {
+    bool texture = true;
+    TransientTextureDesc texture_desc{};
+    TransientBufferDesc buffer_desc{};
+    unsigned int id = 0;
+    std::uint32_t unused_frames = 0;
+    bool in_use = false;
+  };
+
+  FrameResourceId AddResource(Resource resource);
+  void AddAccess(const std::size_t pass, const FrameResourceId resource,
+                 const FrameResourceUsage usage, const bool write);
+  void CullPasses();
+  void AssignAllocations();
+  void BuildTargetsAndBarriers();
+  /**
+   * @brief Find a pooled allocation matching an allocation, if any
+   */
+  std::size_t FindPooled(const Allocation& allocation) const;
+
+  std::vector<Pass> passes_{};
+  std::vector<Resource> resources_{};
+  std::vector<Allocation> allocations_{};
+  std::vector<Pooled> pool_{};
+  std::vector<FramePassTiming> timings_{};
+  bool compiled_ = false;
+
+  friend class FrameGraphBuilder;
+  friend class FrameGraphResources;
+};
+
+} /* namespace game_engine::_3D */
+
+#include "3D/FrameGraph.tpp"
+
+#endif /* SRC_3D_FRAMEGRAPH_HPP_ */
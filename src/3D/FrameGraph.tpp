@@ -0,0 +1,143 @@
+/******************************************************************************
+ * FrameGraph.tpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_3D_FRAMEGRAPH_TPP_
+#define SRC_3D_FRAMEGRAPH_TPP_
+
+#include <chrono>
+
+#include "3D/FrameGraph.hpp"
+
+namespace game_engine::_3D {
+
+template <typename Backend>
+void FrameGraph::Execute(Backend& backend) {
+  if (!compiled_) {
+    Compile();
+  }
+
+  // Back every allocation with a pooled backend resource
+  for (auto& pooled : pool_) {
+    pooled.in_use = false;
+  }
+  for (auto& allocation : allocations_) {
+    std::size_t index = FindPooled(allocation);
+    if (index == std::numeric_limits<std::size_t>::max()) {
+      Pooled pooled;
+      pooled.texture = allocation.texture;
+      pooled.texture_desc = allocation.texture_desc;
+      pooled.buffer_desc = allocation.buffer_desc;
+      pooled.id = allocation.texture
+                      ? backend.CreateTransientTexture(allocation.texture_desc)
+                      : backend.CreateTransientBuffer(allocation.buffer_desc);
+      pool_.push_back(pooled);
+      index = pool_.size() - 1;
+    }
+    pool_[index].in_use = true;
+    pool_[index].unused_frames = 0;
+    allocation.pooled = index;
+  }
+  for (auto& resource : resources_) {
+    if (resource.render_target != 0) {
+      resource.id = backend.GetRenderTargetTexture(resource.render_target);
+    } else if (!resource.imported &&
+               resource.allocation !=
+                   std::numeric_limits<std::size_t>::max()) {
+      resource.id = pool_[allocations_[resource.allocation].pooled].id;
+    }
+  }
+
+  timings_.clear();
+  const FrameGraphResources resources(this);
+  for (auto& pass : passes_) {
+    if (pass.culled) {
+      continue;
+    }
+    for (auto& barrier : pass.barriers) {
+      barrier.id = resources_[barrier.resource].id;
+      backend.InsertFrameBarrier(barrier);
+    }
+    if (pass.bind_targets) {
+      pass.targets.colors.clear();
+      pass.targets.has_depth = false;
+      for (const auto& access : pass.accesses) {
+        const Resource& resource = resources_[access.resource];
+        if (!access.write || resource.backbuffer ||
+            resource.render_target != 0) {
+          continue;
+        }
+        if (access.usage == FrameResourceUsage::COLOR_ATTACHMENT) {
+          pass.targets.colors.push_back(resource.id);
+        } else if (access.usage == FrameResourceUsage::DEPTH_ATTACHMENT) {
+          pass.targets.depth = resource.id;
+          pass.targets.has_depth = true;
+        }
+      }
+      backend.BindFrameTargets(pass.targets);
+    }
+
+    backend.BeginPassTimer(pass.name);
+    const auto start = std::chrono::steady_clock::now();
+    if (pass.execute) {
+      pass.execute(resources);
+    }
+    const auto end = std::chrono::steady_clock::now();
+    backend.EndPassTimer(pass.name);
+    if (pass.bind_targets && pass.targets.render_target != 0) {
+      backend.ResolveRenderTarget(pass.targets.render_target);
+    }
+
+    FramePassTiming timing;
+    timing.name = pass.name;
+    timing.cpu_ms =
+        std::chrono::duration<double, std::milli>(end - start).count();
+    timing.gpu_ms = backend.GetPassGpuTime(pass.name);
+    timings_.push_back(timing);
+  }
+
+  // Age out allocations no recent frame has needed
+  for (std::size_t i = pool_.size(); i-- > 0;) {
+    Pooled& pooled = pool_[i];
+    if (pooled.in_use || ++pooled.unused_frames <= kPoolFrames) {
+      continue;
+    }
+    if (pooled.texture) {
+      backend.DestroyTransientTexture(pooled.id);
+    } else {
+      backend.DestroyTransientBuffer(pooled.id);
+    }
+    pool_.erase(pool_.begin() + static_cast<std::ptrdiff_t>(i));
+  }
+}
+
+template <typename Backend>
+void FrameGraph::ReleasePool(Backend& backend) {
+  for (const auto& pooled : pool_) {
+    if (pooled.texture) {
+      backend.DestroyTransientTexture(pooled.id);
+    } else {
+      backend.DestroyTransientBuffer(pooled.id);
+    }
+  }
+  pool_.clear();
+}
+
+} /* namespace game_engine::_3D */
+
+#endif /* SRC_3D_FRAMEGRAPH_TPP_ */
@@ -0,0 +1,300 @@
+/******************************************************************************
+ * Frustum.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/Frustum.hpp"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <cmath>
+#include <limits>
+
+#include "Util/CpuFeatures.hpp"
+
+namespace game_engine::_3D {
+
+void FrustumCullBatch::Add(const Aabb& box) {
+  if (box.IsEmpty()) {
+    // NaN fails every plane comparison, so empty boxes are always culled
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    center_x_.push_back(nan);
+    center_y_.push_back(nan);
+    center_z_.push_back(nan);
+    extent_x_.push_back(0.0f);
+    extent_y_.push_back(0.0f);
+    extent_z_.push_back(0.0f);
+    return;
+  }
+  const glm::vec3 center = box.Center();
+  const glm::vec3 extents = box.Extents();
+  center_x_.push_back(center.x);
+  center_y_.push_back(center.y);
+  center_z_.push_back(center.z);
+  extent_x_.push_back(extents.x);
+  extent_y_.push_back(extents.y);
+  extent_z_.push_back(extents.z);
+}
+
+void FrustumCullBatch::Clear() {
+  center_x_.clear();
+  center_y_.clear();
+  center_z_.clear();
+  extent_x_.clear();
+  extent_y_.clear();
+  extent_z_.clear();
+}
+
+void FrustumCullBatch::Reserve(const std::size_t count) {
+  center_x_.reserve(count);
+  center_y_.reserve(count);
+  center_z_.reserve(count);
+  extent_x_.reserve(count);
+  extent_y_.reserve(count);
+  extent_z_.reserve(count);
+}
+
+std::ostream& operator<<(std::ostream& os, const CullStats& stats) {
+  return os << "CullStats {\n"
+            << "std::uint64_t tested = " << stats.tested << "\n"
+            << "std::uint64_t visible = " << stats.visible << "\n"
+            << "}";
+}
+
+std::ostream& operator<<(std::ostream& os, const Containment containment) {
+  switch (containment) {
+    case Containment::OUTSIDE:
+      return os << "Containment::OUTSIDE";
+    case Containment::INTERSECTS:
+      return os << "Containment::INTERSECTS";
+    case Containment::INSIDE:
+      return os << "Containment::INSIDE";
+  }
+  return os;
+}
+
+Frustum::Frustum(const glm::mat4& view, const glm::mat4& projection)
+    : Frustum(projection * view) {}
+
+Frustum::Frustum(const glm::mat4& m) {
+  // glm matrices are column major, so row i is (m[0][i], m[1][i], ...)
+  const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+  const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+  const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+  const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+  planes_[LEFT] = row3 + row0;
+  planes_[RIGHT] = row3 - row0;
+  planes_[BOTTOM] = row3 + row1;
+  planes_[TOP] = row3 - row1;
+  planes_[Z_NEAR] = row3 + row2;
+  planes_[Z_FAR] = row3 - row2;
+  for (auto& plane : planes_) {
+    const float length = glm::length(glm::vec3(plane));
+    if (length > 0.0f) {
+      plane /= length;
+    }
+  }
+}
+
+bool Frustum::Intersects(const Aabb& box) const {
+  if (box.IsEmpty()) {
+    return false;
+  }
+  const glm::vec3 center = box.Center();
+  const glm::vec3 extents = box.Extents();
+  for (const auto& plane : planes_) {
+    const glm::vec3 normal(plane);
+    const float distance = glm::dot(normal, center) + plane.w;
+    const float radius = glm::dot(glm::abs(normal), extents);
+    if (distance + radius < 0.0f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Containment Frustum::Classify(const Aabb& box) const {
+  if (box.IsEmpty()) {
+    return Containment::OUTSIDE;
+  }
+  const glm::vec3 center = box.Center();
+  const glm::vec3 extents = box.Extents();
+  Containment result = Containment::INSIDE;
+  for (const auto& plane : planes_) {
+    const glm::vec3 normal(plane);
+    const float distance = glm::dot(normal, center) + plane.w;
+    const float radius = glm::dot(glm::abs(normal), extents);
+    if (distance + radius < 0.0f) {
+      return Containment::OUTSIDE;
+    }
+    if (distance - radius < 0.0f) {
+      result = Containment::INTERSECTS;
+    }
+  }
+  return result;
+}
+
+bool Frustum::Intersects(const BoundingSphere& sphere) const {
+  for (const auto& plane : planes_) {
+    if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius) {
+      return false;
+    }
+  }
+  return true;
+}
+
+namespace {
+
+/**
+ * @brief Returns true if the box is at least partially inside every plane
+ */
+inline bool CullOne(const std::array<glm::vec4, Frustum::COUNT>& planes,
+                    const float* cx, const float* cy, const float* cz,
+                    const float* ex, const float* ey, const float* ez,
+                    const std::size_t i) {
+  for (const auto& p : planes) {
+    const float distance = p.x * cx[i] + p.y * cy[i] + p.z * cz[i] + p.w;
+    const float radius = std::abs(p.x) * ex[i] + std::abs(p.y) * ey[i] +
+                         std::abs(p.z) * ez[i];
+    // Written so that NaN, used for empty boxes, is culled like the SIMD paths
+    if (!(distance + radius >= 0.0f)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+#if defined(__SSE2__)
+/**
+ * @brief Cull eight boxes at a time.  Built for AVX2 whatever the build
+ *        flags, so it may only be called if util::HasAvx2().
+ * @return Returns the index of the first box left for the narrower paths
+ */
+__attribute__((target("avx2"))) std::size_t CullAvx2(
+    const std::array<glm::vec4, Frustum::COUNT>& planes, const float* cx,
+    const float* cy, const float* cz, const float* ex, const float* ey,
+    const float* ez, const std::size_t count,
+    std::vector<std::uint32_t>* visible) {
+  const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+  const __m256 zero = _mm256_setzero_ps();
+  __m256 p[Frustum::COUNT][7];
+  for (std::size_t j = 0; j < Frustum::COUNT; j++) {
+    p[j][0] = _mm256_set1_ps(planes[j].x);
+    p[j][1] = _mm256_set1_ps(planes[j].y);
+    p[j][2] = _mm256_set1_ps(planes[j].z);
+    p[j][3] = _mm256_set1_ps(planes[j].w);
+    p[j][4] = _mm256_andnot_ps(sign_mask, p[j][0]);
+    p[j][5] = _mm256_andnot_ps(sign_mask, p[j][1]);
+    p[j][6] = _mm256_andnot_ps(sign_mask, p[j][2]);
+  }
+  std::size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m256 x = _mm256_loadu_ps(cx + i);
+    const __m256 y = _mm256_loadu_ps(cy + i);
+    const __m256 z = _mm256_loadu_ps(cz + i);
+    const __m256 hx = _mm256_loadu_ps(ex + i);
+    const __m256 hy = _mm256_loadu_ps(ey + i);
+    const __m256 hz = _mm256_loadu_ps(ez + i);
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (std::size_t j = 0; j < Frustum::COUNT; j++) {
+      __m256 d = _mm256_add_ps(_mm256_mul_ps(p[j][0], x), p[j][3]);
+      d = _mm256_add_ps(d, _mm256_mul_ps(p[j][1], y));
+      d = _mm256_add_ps(d, _mm256_mul_ps(p[j][2], z));
+      d = _mm256_add_ps(d, _mm256_mul_ps(p[j][4], hx));
+      d = _mm256_add_ps(d, _mm256_mul_ps(p[j][5], hy));
+      d = _mm256_add_ps(d, _mm256_mul_ps(p[j][6], hz));
+      inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, zero, _CMP_GE_OQ));
+    }
+    unsigned int mask = static_cast<unsigned int>(_mm256_movemask_ps(inside));
+    while (mask != 0) {
+      visible->push_back(static_cast<std::uint32_t>(i) +
+                         static_cast<std::uint32_t>(__builtin_ctz(mask)));
+      mask &= mask - 1;
+    }
+  }
+  return i;
+}
+#endif
+
+}  // namespace
+
+void Frustum::Cull(const FrustumCullBatch& batch,
+                   std::vector<std::uint32_t>* visible) const {
+  visible->clear();
+  const std::size_t count = batch.Size();
+  const float* cx = batch.center_x_.data();
+  const float* cy = batch.center_y_.data();
+  const float* cz = batch.center_z_.data();
+  const float* ex = batch.extent_x_.data();
+  const float* ey = batch.extent_y_.data();
+  const float* ez = batch.extent_z_.data();
+  std::size_t i = 0;
+
+#if defined(__SSE2__)
+  if (util::HasAvx2()) {
+    i = CullAvx2(planes_, cx, cy, cz, ex, ey, ez, count, visible);
+  }
+  {
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 p[COUNT][7];
+    for (std::size_t j = 0; j < COUNT; j++) {
+      p[j][0] = _mm_set1_ps(planes_[j].x);
+      p[j][1] = _mm_set1_ps(planes_[j].y);
+      p[j][2] = _mm_set1_ps(planes_[j].z);
+      p[j][3] = _mm_set1_ps(planes_[j].w);
+      p[j][4] = _mm_andnot_ps(sign_mask, p[j][0]);
+      p[j][5] = _mm_andnot_ps(sign_mask, p[j][1]);
+      p[j][6] = _mm_andnot_ps(sign_mask, p[j][2]);
+    }
+    for (; i + 4 <= count; i += 4) {
+      const __m128 x = _mm_loadu_ps(cx + i);
+      const __m128 y = _mm_loadu_ps(cy + i);
+      const __m128 z = _mm_loadu_ps(cz + i);
+      const __m128 hx = _mm_loadu_ps(ex + i);
+      const __m128 hy = _mm_loadu_ps(ey + i);
+      const __m128 hz = _mm_loadu_ps(ez + i);
+      __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+      for (std::size_t j = 0; j < COUNT; j++) {
+        __m128 d = _mm_add_ps(_mm_mul_ps(p[j][0], x), p[j][3]);
+        d = _mm_add_ps(d, _mm_mul_ps(p[j][1], y));
+        d = _mm_add_ps(d, _mm_mul_ps(p[j][2], z));
+        d = _mm_add_ps(d, _mm_mul_ps(p[j][4], hx));
+        d = _mm_add_ps(d, _mm_mul_ps(p[j][5], hy));
+        d = _mm_add_ps(d, _mm_mul_ps(p[j][6], hz));
+        inside = _mm_and_ps(inside, _mm_cmpge_ps(d, zero));
+      }
+      unsigned int mask = static_cast<unsigned int>(_mm_movemask_ps(inside));
+      while (mask != 0) {
+        visible->push_back(static_cast<std::uint32_t>(i) +
+                           static_cast<std::uint32_t>(__builtin_ctz(mask)));
+        mask &= mask - 1;
+      }
+    }
+  }
+#endif
+  for (; i < count; i++) {
+    if (CullOne(planes_, cx, cy, cz, ex, ey, ez, i)) {
+      visible->push_back(static_cast<std::uint32_t>(i));
+    }
+  }
+}
+
+} /* namespace game_engine::_3D */
@@ -0,0 +1,150 @@
+/******************************************************************************
+ * Frustum.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_3D_FRUSTUM_HPP_
+#define SRC_3D_FRUSTUM_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "3D/BoundingVolume.hpp"
+
+namespace game_engine::_3D {
+
+/**
+ * @brief Structure of arrays holding the world space boxes of many objects
+ *
+ * Boxes are stored as centers and half extents, one array per component, so
+ * the culler can test eight of them per instruction.
+ */
+class FrustumCullBatch {
+ public:
+  void Add(const Aabb& box);
+  void Clear();
+  void Reserve(const std::size_t count);
+  std::size_t Size() const { return center_x_.size(); }
+
+  void swap(FrustumCullBatch& other) noexcept {
+    using std::swap;
+    swap(other.center_x_, center_x_);
+    swap(other.center_y_, center_y_);
+    swap(other.center_z_, center_z_);
+    swap(other.extent_x_, extent_x_);
+    swap(other.extent_y_, extent_y_);
+    swap(other.extent_z_, extent_z_);
+  }
+
+ protected:
+  std::vector<float> center_x_{};
+  std::vector<float> center_y_{};
+  std::vector<float> center_z_{};
+  std::vector<float> extent_x_{};
+  std::vector<float> extent_y_{};
+  std::vector<float> extent_z_{};
+
+  friend class Frustum;
+};
+
+inline void swap(FrustumCullBatch& a, FrustumCullBatch& b) noexcept {
+  a.swap(b);
+}
+
+/**
+ * @brief Counters describing how much work culling saved
+ */
+struct CullStats {
+  std::uint64_t tested = 0;
+  std::uint64_t visible = 0;
+
+  std::uint64_t Culled() const { return tested - visible; }
+  /**
+   * @brief Percentage of tested objects that were culled
+   */
+  double CulledPercent() const {
+    return tested == 0 ? 0.0
+                       : 100.0 * static_cast<double>(Culled()) /
+                             static_cast<double>(tested);
+  }
+  void Reset() { *this = CullStats{}; }
+};
+
+std::ostream& operator<<(std::ostream& os, const CullStats& stats);
+
+/**
+ * @brief Result of classifying a volume against a frustum
+ */
+enum class Containment : std::uint8_t { OUTSIDE, INTERSECTS, INSIDE };
+std::ostream& operator<<(std::ostream& os, const Containment containment);
+
+/**
+ * @brief The six clip planes of a camera, in world space
+ *
+ * Planes point inwards and are normalized, so the signed distance of a point
+ * is dot(plane.xyz, point) + plane.w.
+ */
+class Frustum {
+ public:
+  enum Plane : std::uint8_t { LEFT, RIGHT, BOTTOM, TOP, Z_NEAR, Z_FAR, COUNT };
+
+  Frustum() = default;
+  /**
+   * @brief Extract the planes of projection * view (Gribb & Hartmann)
+   */
+  Frustum(const glm::mat4& view, const glm::mat4& projection);
+  explicit Frustum(const glm::mat4& view_projection);
+
+  bool Intersects(const Aabb& box) const;
+  bool Intersects(const BoundingSphere& sphere) const;
+  /**
+   * @brief Like Intersects, but also reports boxes entirely inside, whose
+   *        contents need no further testing
+   */
+  Containment Classify(const Aabb& box) const;
+
+  /**
+   * @brief Test every box of a batch against the frustum
+   * @param batch The boxes to test
+   * @param visible Cleared and filled with the indices of every box that
+   *                intersects the frustum, in increasing order
+   */
+  void Cull(const FrustumCullBatch& batch,
+            std::vector<std::uint32_t>* visible) const;
+
+  const glm::vec4& GetPlane(const Plane plane) const { return planes_[plane]; }
+
+  void swap(Frustum& other) noexcept {
+    using std::swap;
+    swap(other.planes_, planes_);
+  }
+
+ protected:
+  std::array<glm::vec4, COUNT> planes_{};
+};
+
+inline void swap(Frustum& a, Frustum& b) noexcept { a.swap(b); }
+
+} /* namespace game_engine::_3D */
+
+#endif /* SRC_3D_FRUSTUM_HPP_ */
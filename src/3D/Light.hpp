@@ -0,0 +1,81 @@
+/******************************************************************************
+ * Light.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_3D_LIGHT_HPP_
+#define SRC_3D_LIGHT_HPP_
+
+#include <cstdint>
+#include <ostream>
+
+#include <glm/glm.hpp>
+
+namespace game_engine::_3D {
+
+enum class LightType : std::uint8_t { POINT, SPOT };
+
+inline std::ostream& operator<<(std::ostream& os, const LightType type) {
+  switch (type) {
+    case LightType::POINT:
+      return os << "LightType::POINT";
+    case LightType::SPOT:
+      return os << "LightType::SPOT";
+  }
+  return os;
+}
+
+/**
+ * @brief A dynamic point or spot light in world space
+ *
+ * Lights fall off smoothly to zero at range, so a light only affects the
+ * clusters its bounding volume touches.
+ */
+struct Light {
+  LightType type = LightType::POINT;
+  glm::vec3 position = glm::vec3(0.0f);
+  float range = 1.0f;
+  glm::vec3 color = glm::vec3(1.0f);
+  float intensity = 1.0f;
+  /**
+   * @brief Direction the cone of a spot light points in
+   */
+  glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+  /**
+   * @brief Half angles in radians of the full intensity and outer edge of the
+   *        cone of a spot light
+   */
+  float inner_angle = 0.4f;
+  float outer_angle = 0.5f;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const Light& l) {
+  return os << "Light {\n"
+            << "LightType type = " << l.type << "\n"
+            << "glm::vec3 position = " << l.position << "\n"
+            << "float range = " << l.range << "\n"
+            << "glm::vec3 color = " << l.color << "\n"
+            << "float intensity = " << l.intensity << "\n"
+            << "glm::vec3 direction = " << l.direction << "\n"
+            << "float inner_angle = " << l.inner_angle << "\n"
+            << "float outer_angle = " << l.outer_angle << "\n"
+            << "}";
+}
+
+} /* namespace game_engine::_3D */
+
+#endif /* SRC_3D_LIGHT_HPP_ */
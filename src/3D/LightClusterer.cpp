@@ -0,0 +1,321 @@
+/******************************************************************************
+ * LightClusterer.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/LightClusterer.hpp"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "Util/ParallelFor.hpp"
+
+namespace game_engine::_3D {
+
+namespace {
+
+constexpr int kMinSlicesPerThread = 2;
+constexpr float kQuarterPi = 0.78539816f;
+
+/**
+ * @brief Lights overlapping the depth range of one slice, split by component
+ *        and padded to a multiple of four with spheres that never overlap
+ */
+struct SliceCandidates {
+  std::vector<float> x{};
+  std::vector<float> y{};
+  std::vector<float> z{};
+  std::vector<float> radius_sq{};
+  std::vector<std::uint32_t> light{};
+
+  void Clear() {
+    x.clear();
+    y.clear();
+    z.clear();
+    radius_sq.clear();
+    light.clear();
+  }
+  void Push(const float px, const float py, const float pz, const float r2,
+            const std::uint32_t index) {
+    x.push_back(px);
+    y.push_back(py);
+    z.push_back(pz);
+    radius_sq.push_back(r2);
+    light.push_back(index);
+  }
+  void Pad() {
+    while (x.size() % 4 != 0) {
+      Push(0.0f, 0.0f, 0.0f, -1.0f, 0);
+    }
+  }
+};
+
+/**
+ * @brief Append the candidates whose sphere overlaps a box
+ */
+void TestCluster(const SliceCandidates& candidates, const Aabb& box,
+                 std::vector<std::uint32_t>* out) {
+  const std::size_t count = candidates.x.size();
+#if defined(__SSE2__)
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 min_x = _mm_set1_ps(box.min.x);
+  const __m128 min_y = _mm_set1_ps(box.min.y);
+  const __m128 min_z = _mm_set1_ps(box.min.z);
+  const __m128 max_x = _mm_set1_ps(box.max.x);
+  const __m128 max_y = _mm_set1_ps(box.max.y);
+  const __m128 max_z = _mm_set1_ps(box.max.z);
+  for (std::size_t i = 0; i < count; i += 4) {
+    const __m128 cx = _mm_loadu_ps(&candidates.x[i]);
+    const __m128 cy = _mm_loadu_ps(&candidates.y[i]);
+    const __m128 cz = _mm_loadu_ps(&candidates.z[i]);
+    /*  Distance from the sphere center to the box along each axis  */
+    const __m128 dx = _mm_max_ps(
+        _mm_max_ps(_mm_sub_ps(min_x, cx), _mm_sub_ps(cx, max_x)), zero);
+    const __m128 dy = _mm_max_ps(
+        _mm_max_ps(_mm_sub_ps(min_y, cy), _mm_sub_ps(cy, max_y)), zero);
+    const __m128 dz = _mm_max_ps(
+        _mm_max_ps(_mm_sub_ps(min_z, cz), _mm_sub_ps(cz, max_z)), zero);
+    const __m128 dist_sq =
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                   _mm_mul_ps(dz, dz));
+    int mask = _mm_movemask_ps(
+        _mm_cmple_ps(dist_sq, _mm_loadu_ps(&candidates.radius_sq[i])));
+    while (mask != 0) {
+      const int lane = __builtin_ctz(static_cast<unsigned int>(mask));
+      out->push_back(candidates.light[i + lane]);
+      mask &= mask - 1;
+    }
+  }
+#else
+  for (std::size_t i = 0; i < count; i++) {
+    const glm::vec3 center(candidates.x[i], candidates.y[i], candidates.z[i]);
+    const glm::vec3 d =
+        glm::max(glm::max(box.min - center, center - box.max), glm::vec3(0.0f));
+    if (glm::dot(d, d) <= candidates.radius_sq[i]) {
+      out->push_back(candidates.light[i]);
+    }
+  }
+#endif
+}
+
+}  // namespace
+
+std::ostream& operator<<(std::ostream& os, const LightClusterStats& stats) {
+  return os << "LightClusterStats {\n"
+            << "std::size_t lights = " << stats.lights << "\n"
+            << "std::size_t visible_lights = " << stats.visible_lights << "\n"
+            << "std::size_t indices = " << stats.indices << "\n"
+            << "std::uint32_t max_cluster_lights = "
+            << stats.max_cluster_lights << "\n"
+            << "double bin_ms = " << stats.bin_ms << "\n"
+            << "}";
+}
+
+const LightClusterData& LightClusterer::Build(const std::vector<Light>& lights,
+                                              const glm::mat4& view,
+                                              const glm::mat4& projection) {
+  const auto start = std::chrono::steady_clock::now();
+  const glm::ivec3 grid = glm::max(options_.grid, glm::ivec3(1));
+  options_.grid = grid;
+
+  /*  Recover the clip planes of a symmetric OpenGL perspective projection  */
+  const float near = projection[3][2] / (projection[2][2] - 1.0f);
+  const float far = projection[3][2] / (projection[2][2] + 1.0f);
+  tan_half_fov_ = glm::vec2(1.0f / projection[0][0], 1.0f / projection[1][1]);
+
+  const float log_ratio = std::log(far / near);
+  data_.grid = grid;
+  data_.near = near;
+  data_.far = far;
+  data_.depth_scale_bias =
+      glm::vec2(static_cast<float>(grid.z) / log_ratio,
+                -static_cast<float>(grid.z) * std::log(near) / log_ratio);
+
+  data_.lights.clear();
+  sphere_x_.clear();
+  sphere_y_.clear();
+  sphere_z_.clear();
+  sphere_radius_sq_.clear();
+  for (const Light& light : lights) {
+    const glm::vec3 position(view * glm::vec4(light.position, 1.0f));
+    glm::vec3 direction(0.0f);
+    glm::vec3 center = position;
+    float radius = light.range;
+    GpuLight gpu;
+    gpu.cone = glm::vec4(-1.0f, 1.0f, 0.0f, 0.0f);
+    if (light.type == LightType::SPOT) {
+      direction = glm::normalize(
+          glm::vec3(view * glm::vec4(light.direction, 0.0f)));
+      /*  Smallest sphere around the cone of the spot light  */
+      const float outer = std::min(light.outer_angle, 2.0f * kQuarterPi);
+      if (outer > kQuarterPi) {
+        center = position + direction * (std::cos(outer) * light.range);
+        radius = std::sin(outer) * light.range;
+      } else {
+        radius = light.range / (2.0f * std::cos(outer));
+        center = position + direction * radius;
+      }
+      const float cos_outer = std::cos(outer);
+      const float cos_inner = std::cos(std::min(light.inner_angle, outer));
+      gpu.cone = glm::vec4(cos_outer,
+                           1.0f / std::max(cos_inner - cos_outer, 1e-4f),
+                           0.0f, 0.0f);
+    }
+    const float depth = -center.z;
+    if (depth + radius < near || depth - radius > far) {
+      continue;
+    }
+    gpu.position_range = glm::vec4(position, light.range);
+    gpu.color_intensity = glm::vec4(light.color, light.intensity);
+    gpu.direction_type =
+        glm::vec4(direction, light.type == LightType::SPOT ? 1.0f : 0.0f);
+    data_.lights.push_back(gpu);
+    sphere_x_.push_back(center.x);
+    sphere_y_.push_back(center.y);
+    sphere_z_.push_back(center.z);
+    sphere_radius_sq_.push_back(radius * radius);
+  }
+
+  const std::size_t slice_size = static_cast<std::size_t>(grid.x * grid.y);
+  data_.clusters.assign(slice_size * static_cast<std::size_t>(grid.z),
+                        LightCluster{});
+  std::vector<std::vector<std::uint32_t>> slice_indices(
+      static_cast<std::size_t>(grid.z));
+  util::ParallelFor(grid.z, options_.max_threads, kMinSlicesPerThread,
+                    [&](const int begin, const int end) {
+                      BinSlices(begin, end, &slice_indices);
+                    });
+
+  /*  Slices were filled with offsets relative to their own index list  */
+  data_.indices.clear();
+  stats_.max_cluster_lights = 0;
+  for (int z = 0; z < grid.z; z++) {
+    const auto base = static_cast<std::uint32_t>(data_.indices.size());
+    const auto& indices = slice_indices[static_cast<std::size_t>(z)];
+    data_.indices.insert(data_.indices.end(), indices.begin(), indices.end());
+    for (std::size_t i = 0; i < slice_size; i++) {
+      LightCluster& cluster =
+          data_.clusters[static_cast<std::size_t>(z) * slice_size + i];
+      cluster.offset += base;
+      stats_.max_cluster_lights =
+          std::max(stats_.max_cluster_lights, cluster.count);
+    }
+  }
+
+  stats_.lights = lights.size();
+  stats_.visible_lights = data_.lights.size();
+  stats_.indices = data_.indices.size();
+  stats_.bin_ms = std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+  return data_;
+}
+
+Aabb LightClusterer::GetClusterBounds(const glm::ivec3 cluster) const {
+  const glm::ivec3 grid = options_.grid;
+  const float ratio = data_.far / data_.near;
+  const float d0 = data_.near * std::pow(ratio, static_cast<float>(cluster.z) /
+                                                    static_cast<float>(grid.z));
+  const float d1 =
+      data_.near * std::pow(ratio, static_cast<float>(cluster.z + 1) /
+                                       static_cast<float>(grid.z));
+  /*  Tile edges in normalized device coordinates, scaled to unit depth  */
+  const glm::vec2 lo =
+      (glm::vec2(cluster.x, cluster.y) * 2.0f / glm::vec2(grid.x, grid.y) -
+       1.0f) *
+      tan_half_fov_;
+  const glm::vec2 hi = (glm::vec2(cluster.x + 1, cluster.y + 1) * 2.0f /
+                            glm::vec2(grid.x, grid.y) -
+                        1.0f) *
+                       tan_half_fov_;
+  Aabb box;
+  box.min = glm::vec3(std::min(lo.x * d0, lo.x * d1),
+                      std::min(lo.y * d0, lo.y * d1), -d1);
+  box.max = glm::vec3(std::max(hi.x * d0, hi.x * d1),
+                      std::max(hi.y * d0, hi.y * d1), -d0);
+  return box;
+}
+
+void LightClusterer::BinSlices(
+    const int begin, const int end,
+    std::vector<std::vector<std::uint32_t>>* slice_indices) {
+  const glm::ivec3 grid = options_.grid;
+  const auto max_lights =
+      static_cast<std::size_t>(std::max(options_.max_lights_per_cluster, 0));
+  SliceCandidates candidates;
+  for (int z = begin; z < end; z++) {
+    const Aabb slice_box = GetClusterBounds(glm::ivec3(0, 0, z));
+    const float d0 = -slice_box.max.z;
+    const float d1 = -slice_box.min.z;
+
+    candidates.Clear();
+    for (std::size_t i = 0; i < sphere_x_.size(); i++) {
+      const float depth = -sphere_z_[i];
+      const float radius = std::sqrt(sphere_radius_sq_[i]);
+      if (depth + radius >= d0 && depth - radius <= d1) {
+        candidates.Push(sphere_x_[i], sphere_y_[i], sphere_z_[i],
+                        sphere_radius_sq_[i], static_cast<std::uint32_t>(i));
+      }
+    }
+    candidates.Pad();
+
+    auto& indices = (*slice_indices)[static_cast<std::size_t>(z)];
+    indices.clear();
+    for (int y = 0; y < grid.y; y++) {
+      for (int x = 0; x < grid.x; x++) {
+        const glm::ivec3 cell(x, y, z);
+        const Aabb box = GetClusterBounds(cell);
+        const std::size_t first = indices.size();
+        TestCluster(candidates, box, &indices);
+
+        if (indices.size() - first > max_lights) {
+          /*  Keep the lights nearest to the cluster  */
+          const glm::vec3 center = box.Center();
+          const auto distance = [&](const std::uint32_t light) {
+            const glm::vec3 d =
+                glm::vec3(sphere_x_[light], sphere_y_[light],
+                          sphere_z_[light]) -
+                center;
+            return glm::dot(d, d);
+          };
+          const auto cluster_begin =
+              indices.begin() + static_cast<std::ptrdiff_t>(first);
+          std::nth_element(cluster_begin,
+                           cluster_begin +
+                               static_cast<std::ptrdiff_t>(max_lights),
+                           indices.end(),
+                           [&](const std::uint32_t a, const std::uint32_t b) {
+                             return distance(a) < distance(b);
+                           });
+          indices.resize(first + max_lights);
+        }
+
+        LightCluster& cluster = data_.clusters[ClusterIndex(cell)];
+        cluster.offset = static_cast<std::uint32_t>(first);
+        cluster.count = static_cast<std::uint32_t>(indices.size() - first);
+      }
+    }
+  }
+}
+
+} /* namespace game_engine::_3D */
@@ -0,0 +1,221 @@
+/******************************************************************************
+ * LightClusterer.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_3D_LIGHTCLUSTERER_HPP_
+#define SRC_3D_LIGHTCLUSTERER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "3D/BoundingVolume.hpp"
+#include "3D/Light.hpp"
+
+namespace game_engine::_3D {
+
+/**
+ * @brief Options controlling the cluster grid
+ */
+struct LightClusterOptions {
+  /**
+   * @brief Clusters across the screen in x and y, and depth slices in z
+   */
+  glm::ivec3 grid{16, 9, 24};
+  /**
+   * @brief Lights kept per cluster, bounding the work of each fragment.  The
+   *        nearest lights are kept when a cluster overflows.
+   */
+  int max_lights_per_cluster = 128;
+  /**
+   * @brief Maximum number of binning threads.  0 uses every hardware thread.
+   */
+  unsigned int max_threads = 0;
+};
+
+/**
+ * @brief A light as the shader sees it, in view space with std430 layout
+ */
+struct GpuLight {
+  /**
+   * @brief xyz is the position, w the range
+   */
+  glm::vec4 position_range{0.0f};
+  /**
+   * @brief rgb is the color, a the intensity
+   */
+  glm::vec4 color_intensity{0.0f};
+  /**
+   * @brief xyz is the spot direction, w is 0 for point and 1 for spot lights
+   */
+  glm::vec4 direction_type{0.0f};
+  /**
+   * @brief x is the cosine of the outer angle, y the reciprocal of the
+   *        cosine difference between the inner and outer angles
+   */
+  glm::vec4 cone{0.0f};
+};
+static_assert(sizeof(GpuLight) == 64, "GpuLight must match the std430 layout");
+
+/**
+ * @brief Range of the index list holding the lights of a cluster
+ */
+struct LightCluster {
+  std::uint32_t offset = 0;
+  std::uint32_t count = 0;
+};
+
+struct LightClusterStats {
+  std::size_t lights = 0;
+  /**
+   * @brief Lights overlapping the view volume
+   */
+  std::size_t visible_lights = 0;
+  std::size_t indices = 0;
+  std::uint32_t max_cluster_lights = 0;
+  double bin_ms = 0.0;
+};
+
+std::ostream& operator<<(std::ostream& os, const LightClusterStats& stats);
+
+/**
+ * @brief Everything the lit shader needs to find the lights of a fragment
+ *
+ * The cluster of a fragment is its tile on screen and the depth slice of its
+ * view space depth d, floor(log(d) * depth_scale_bias.x + depth_scale_bias.y).
+ * Clusters are stored x fastest, then y, then z.
+ */
+struct LightClusterData {
+  glm::ivec3 grid{0, 0, 0};
+  float near = 0.0f;
+  float far = 0.0f;
+  glm::vec2 depth_scale_bias{0.0f, 0.0f};
+  std::vector<GpuLight> lights{};
+  std::vector<LightCluster> clusters{};
+  std::vector<std::uint32_t> indices{};
+
+  void swap(LightClusterData& other) noexcept {
+    using std::swap;
+    swap(other.grid, grid);
+    swap(other.near, near);
+    swap(other.far, far);
+    swap(other.depth_scale_bias, depth_scale_bias);
+    swap(other.lights, lights);
+    swap(other.clusters, clusters);
+    swap(other.indices, indices);
+  }
+};
+
+inline void swap(LightClusterData& a, LightClusterData& b) noexcept {
+  a.swap(b);
+}
+
+/**
+ * @brief Bins lights into a clustered view frustum for forward shading
+ *
+ * The frustum is split into screen tiles and exponentially spaced depth
+ * slices, and the view space bounds of every cluster are tested against the
+ * bounding sphere of every light.  Depth slices are spread across worker
+ * threads, and the inner loop tests four lights at a time against a cluster
+ * with SIMD.  Each slice first keeps only the lights overlapping its depth
+ * range, so the cost grows with the lights near each slice rather than with
+ * every light times every cluster.
+ *
+ * The projection must be a symmetric perspective projection, like the one
+ * built by Camera.
+ */
+class LightClusterer {
+ public:
+  LightClusterer() = default;
+  explicit LightClusterer(const LightClusterOptions& options)
+      : options_(options) {}
+
+  /**
+   * @brief Bin lights for a view
+   * @param lights Lights in world space
+   * @param view Matrix mapping world space to view space
+   * @param projection Perspective projection of the view
+   * @return Returns the binned lights, valid until the next Build
+   */
+  const LightClusterData& Build(const std::vector<Light>& lights,
+                                const glm::mat4& view,
+                                const glm::mat4& projection);
+
+  /**
+   * @brief View space bounds of a cluster as of the last Build
+   */
+  Aabb GetClusterBounds(const glm::ivec3 cluster) const;
+  /**
+   * @brief Index of a cluster in LightClusterData::clusters
+   */
+  std::size_t ClusterIndex(const glm::ivec3 cluster) const {
+    return static_cast<std::size_t>(
+        (cluster.z * options_.grid.y + cluster.y) * options_.grid.x +
+        cluster.x);
+  }
+
+  const LightClusterData& GetData() const { return data_; }
+  const LightClusterStats& GetStats() const { return stats_; }
+  const LightClusterOptions& GetOptions() const { return options_; }
+
+  void swap(LightClusterer& other) noexcept {
+    using std::swap;
+    swap(other.options_, options_);
+    swap(other.data_, data_);
+    swap(other.stats_, stats_);
+    swap(other.tan_half_fov_, tan_half_fov_);
+    swap(other.sphere_x_, sphere_x_);
+    swap(other.sphere_y_, sphere_y_);
+    swap(other.sphere_z_, sphere_z_);
+    swap(other.sphere_radius_sq_, sphere_radius_sq_);
+  }
+
+ protected:
+  /**
+   * @brief Bin the lights of the depth slices [begin, end)
+   */
+  void BinSlices(const int begin, const int end,
+                 std::vector<std::vector<std::uint32_t>>* slice_indices);
+
+  LightClusterOptions options_{};
+  LightClusterData data_{};
+  LightClusterStats stats_{};
+  /**
+   * @brief Half extents of the view volume at unit depth
+   */
+  glm::vec2 tan_half_fov_{1.0f, 1.0f};
+
+  /**
+   * @brief Bounding spheres of the visible lights in view space, split by
+   *        component
+   */
+  std::vector<float> sphere_x_{};
+  std::vector<float> sphere_y_{};
+  std::vector<float> sphere_z_{};
+  std::vector<float> sphere_radius_sq_{};
+};
+
+inline void swap(LightClusterer& a, LightClusterer& b) noexcept { a.swap(b); }
+
+} /* namespace game_engine::_3D */
+
+#endif /* SRC_3D_LIGHTCLUSTERER_HPP_ */
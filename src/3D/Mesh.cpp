@@ -20,6 +20,11 @@
 
 #include "3D/Mesh.hpp"
 
+#include <cstdint>
+#include <vector>
+
+#include "3D/MeshOptimizer.hpp"
+
 #include "LoggerV2/Log.hpp"
 
 namespace game_engine::_3D {
@@ -53,6 +58,64 @@ Mesh::Mesh(const std::vector<Vertex>& vertices,
         break;
     }
   }
+  UpdateBounds();
+}
+
+void Mesh::UpdateBounds() {
+  bounds_ = Aabb::FromVertices(vertices_);
+  sphere_ = BoundingSphere::FromVertices(vertices_, bounds_);
+}
+
+void Mesh::GenerateLods(const MeshLodOptions& options) {
+  lod_indices_.clear();
+  lods_.clear();
+  lod_ = 0;
+  if (!options.enabled || mode_ != Primitive::TRIANGLES) {
+    return;
+  }
+
+  std::vector<std::vector<std::uint32_t>> lods =
+      MeshSimplifier::GenerateLods(vertices_, indices_, options);
+  if (lods.empty()) {
+    return;
+  }
+  lods_.push_back(MeshLod{0, indices_.size(), 1.0f});
+  for (std::size_t i = 0; i < lods.size(); i++) {
+    const float screen_size = i < options.screen_sizes.size()
+                                  ? options.screen_sizes[i]
+                                  : lods_.back().screen_size * 0.5f;
+    lods_.push_back(MeshLod{indices_.size() + lod_indices_.size(),
+                            lods[i].size(), screen_size});
+    // Collapses leave the triangles in their original order
+    MeshOptimizer::OptimizeVertexCache(&lods[i], vertices_.size());
+    lod_indices_.insert(lod_indices_.end(), lods[i].begin(), lods[i].end());
+  }
+  log_.Debug("Generated {} LODs, {} -> {} indices", lods.size(),
+             indices_.size(), lods.back().size());
+}
+
+void Mesh::SelectLod(const float screen_size, const float hysteresis) {
+  if (lods_.empty()) {
+    return;
+  }
+  // Only switch once the size is clearly past a threshold, so a mesh sitting
+  // right at one does not alternate between LODs every frame
+  while (lod_ + 1 < lods_.size() &&
+         screen_size < lods_[lod_ + 1].screen_size * (1.0f - hysteresis)) {
+    lod_++;
+  }
+  while (lod_ > 0 &&
+         screen_size > lods_[lod_].screen_size * (1.0f + hysteresis)) {
+    lod_--;
+  }
+}
+
+std::ostream& operator<<(std::ostream& os, const MeshLod& lod) {
+  return os << "MeshLod {\n"
+            << "std::size_t first_index = " << lod.first_index << "\n"
+            << "std::size_t index_count = " << lod.index_count << "\n"
+            << "float screen_size = " << lod.screen_size << "\n"
+            << "}";
 }
 
 std::ostream& operator<<(std::ostream& os, const Mesh& m) {
@@ -78,6 +141,14 @@ std::ostream& operator<<(std::ostream& os, const Mesh& m) {
     os << "\"" << i << "\", " << std::endl;
   }
   os << "Primitive mode = " << m.mode_ << std::endl;
+  os << "Aabb bounds = " << m.bounds_ << std::endl;
+  os << "BoundingSphere sphere = " << m.sphere_ << std::endl;
+  os << "std::vector<MeshLod> lods = [ " << std::endl;
+  for (auto& i : m.lods_) {
+    os << i << ", " << std::endl;
+  }
+  os << "]" << std::endl;
+  os << "std::size_t lod = " << m.lod_ << std::endl;
   os << "}";
   return os;
 }
@@ -22,11 +22,14 @@
 
 #define GLM_ENABLE_EXPERIMENTAL
 
+#include <cstddef>
 #include <utility>
 #include <vector>
 
 #include <GL/glew.h>
 
+#include "3D/BoundingVolume.hpp"
+#include "3D/MeshSimplifier.hpp"
 #include "3D/Primitive.hpp"
 #include "3D/Texture.hpp"
 #include "Renderer.hpp"
@@ -35,6 +38,20 @@
 
 namespace game_engine::_3D {
 
+/**
+ * @brief A range of a mesh's index buffer drawn at one level of detail
+ */
+struct MeshLod {
+  std::size_t first_index = 0;
+  std::size_t index_count = 0;
+  /**
+   * @brief Fraction of the screen height below which this LOD is used
+   */
+  float screen_size = 1.0f;
+};
+
+std::ostream& operator<<(std::ostream& os, const MeshLod& lod);
+
 class Mesh {
  public:
   Mesh() noexcept = default;
@@ -53,6 +70,36 @@ class Mesh {
   template <typename Renderer>
   void Draw(const Renderer& renderer, const ShaderPrograms shaders) const;
 
+  /**
+   * @brief Recompute the bounding volumes from vertices_
+   *
+   * Called by the constructor; call it again after editing vertices_.
+   */
+  void UpdateBounds();
+  /**
+   * @brief Bounds of the mesh in model space
+   */
+  const Aabb& GetBounds() const { return bounds_; }
+  const BoundingSphere& GetBoundingSphere() const { return sphere_; }
+
+  /**
+   * @brief Simplify indices_ into a chain of coarser LODs
+   *
+   * Must be called before Init.  The LODs share vertices_ and are appended to
+   * the same index buffer, so switching LOD only changes the drawn range.
+   */
+  void GenerateLods(const MeshLodOptions& options);
+  /**
+   * @brief Pick the LOD drawn by Draw
+   * @param screen_size Projected size of the mesh as a fraction of the screen
+   *                    height
+   * @param hysteresis Relative margin that must be crossed before switching
+   *                   away from the current LOD
+   */
+  void SelectLod(const float screen_size, const float hysteresis);
+  std::size_t GetLod() const { return lod_; }
+  std::size_t GetLodCount() const { return lods_.empty() ? 1 : lods_.size(); }
+
   void swap(Mesh& other) noexcept {
     using std::swap;
     swap(other.vertices_, vertices_);
@@ -61,6 +108,11 @@ class Mesh {
     swap(other.handle_, handle_);
     swap(other.texture_strings_, texture_strings_);
     swap(other.mode_, mode_);
+    swap(other.bounds_, bounds_);
+    swap(other.sphere_, sphere_);
+    swap(other.lod_indices_, lod_indices_);
+    swap(other.lods_, lods_);
+    swap(other.lod_, lod_);
   }
 
  public:
@@ -73,6 +125,17 @@ class Mesh {
   VboHandle handle_{};
   std::vector<std::string> texture_strings_{};
   Primitive mode_{Primitive::TRIANGLES};
+  Aabb bounds_{};
+  BoundingSphere sphere_{};
+  /**
+   * @brief Indices of every LOD after LOD 0, uploaded after indices_
+   */
+  std::vector<GLuint> lod_indices_{};
+  /**
+   * @brief Index ranges of each LOD, empty if no LODs were generated
+   */
+  std::vector<MeshLod> lods_{};
+  std::size_t lod_ = 0;
 
   friend std::ostream& operator<<(std::ostream& os, const Mesh& m);
 
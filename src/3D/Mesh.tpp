@@ -27,7 +27,15 @@ namespace game_engine::_3D {
 template <typename Renderer>
 void Mesh::Init(Renderer& renderer, const ShaderPrograms shaders) {
   // TODO Decouple from rendering logic
-  handle_ = renderer.GenerateVbo(shaders, vertices_, indices_);
+  if (lod_indices_.empty()) {
+    handle_ = renderer.GenerateVbo(shaders, vertices_, indices_);
+    return;
+  }
+  std::vector<GLuint> indices;
+  indices.reserve(indices_.size() + lod_indices_.size());
+  indices.insert(indices.end(), indices_.begin(), indices_.end());
+  indices.insert(indices.end(), lod_indices_.begin(), lod_indices_.end());
+  handle_ = renderer.GenerateVbo(shaders, vertices_, indices);
 }
 
 template <typename Renderer>
@@ -37,7 +45,12 @@ void Mesh::Draw(const Renderer& renderer, const ShaderPrograms shaders) const {
   }
 
   // draw mesh
-  renderer.Render(handle_, mode_);
+  if (lods_.empty()) {
+    renderer.Render(handle_, mode_);
+  } else {
+    const MeshLod& lod = lods_[lod_];
+    renderer.Render(handle_, mode_, lod.first_index, lod.index_count);
+  }
   //  log_.CAPTURE(handle_.uuid_);
 }
 
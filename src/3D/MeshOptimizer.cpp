@@ -0,0 +1,297 @@
+/******************************************************************************
+ * MeshOptimizer.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+#include <glm/glm.hpp>
+
+namespace game_engine::_3D {
+
+namespace {
+
+constexpr std::uint32_t kInvalid = ~0u;
+
+/**
+ * @brief Triangles using each vertex, in compressed row form
+ */
+struct VertexTriangles {
+  std::vector<std::uint32_t> offsets{};
+  std::vector<std::uint32_t> triangles{};
+
+  VertexTriangles(const std::vector<std::uint32_t>& indices,
+                  const std::size_t vertex_count)
+      : offsets(vertex_count + 1, 0), triangles(indices.size()) {
+    for (const auto index : indices) {
+      offsets[index + 1]++;
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<std::uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (std::size_t i = 0; i < indices.size(); i++) {
+      triangles[fill[indices[i]]++] = static_cast<std::uint32_t>(i / 3);
+    }
+  }
+
+  std::uint32_t Count(const std::uint32_t vertex) const {
+    return offsets[vertex + 1] - offsets[vertex];
+  }
+};
+
+}  // namespace
+
+std::ostream& operator<<(std::ostream& os, const VertexCacheStats& stats) {
+  return os << "VertexCacheStats {\n"
+            << "std::size_t vertices_transformed = "
+            << stats.vertices_transformed << "\n"
+            << "float acmr = " << stats.acmr << "\n"
+            << "float atvr = " << stats.atvr << "\n"
+            << "}";
+}
+
+std::pair<VertexCacheStats, VertexCacheStats> MeshOptimizer::Optimize(
+    std::vector<Vertex>* vertices, std::vector<std::uint32_t>* indices) {
+  const VertexCacheStats before =
+      AnalyzeVertexCache(*indices, vertices->size());
+  std::vector<std::uint32_t> clusters;
+  OptimizeVertexCache(indices, vertices->size(), &clusters);
+  OptimizeOverdraw(indices, *vertices, clusters);
+  OptimizeVertexFetch(vertices, indices);
+  return {before, AnalyzeVertexCache(*indices, vertices->size())};
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<std::uint32_t>* indices,
+                                        const std::size_t vertex_count,
+                                        std::vector<std::uint32_t>* clusters,
+                                        const std::size_t cache_size) {
+  if (clusters) {
+    clusters->clear();
+  }
+  const std::size_t triangle_count = indices->size() / 3;
+  if (triangle_count == 0) {
+    return;
+  }
+  const std::vector<std::uint32_t>& input = *indices;
+  const VertexTriangles adjacency(input, vertex_count);
+
+  std::vector<std::uint32_t> live(vertex_count);
+  for (std::uint32_t v = 0; v < vertex_count; v++) {
+    live[v] = adjacency.Count(v);
+  }
+  // Timestamps start far enough in the past that every vertex is a miss
+  std::vector<std::size_t> cache_time(vertex_count, 0);
+  std::size_t time = cache_size + 1;
+  std::vector<bool> emitted(triangle_count, false);
+  std::vector<std::uint32_t> dead_end;
+  std::vector<std::uint32_t> candidates;
+  std::vector<std::uint32_t> output;
+  output.reserve(indices->size());
+
+  std::uint32_t cursor = 0;
+  // Next vertex with triangles left, from the dead end stack or else in input
+  // order.  Either one starts a new cluster.
+  const auto skip_dead_end = [&]() -> std::uint32_t {
+    while (!dead_end.empty()) {
+      const std::uint32_t v = dead_end.back();
+      dead_end.pop_back();
+      if (live[v] > 0) {
+        return v;
+      }
+    }
+    while (cursor < vertex_count) {
+      if (live[cursor] > 0) {
+        return cursor;
+      }
+      cursor++;
+    }
+    return kInvalid;
+  };
+
+  std::uint32_t fanning = skip_dead_end();
+  bool cold = true;
+  while (fanning != kInvalid) {
+    if (cold && clusters) {
+      clusters->push_back(static_cast<std::uint32_t>(output.size()));
+    }
+    candidates.clear();
+    for (std::uint32_t i = adjacency.offsets[fanning];
+         i < adjacency.offsets[fanning + 1]; i++) {
+      const std::uint32_t t = adjacency.triangles[i];
+      if (emitted[t]) {
+        continue;
+      }
+      emitted[t] = true;
+      for (int k = 0; k < 3; k++) {
+        const std::uint32_t v = input[t * 3 + k];
+        output.push_back(v);
+        dead_end.push_back(v);
+        candidates.push_back(v);
+        live[v]--;
+        if (time - cache_time[v] > cache_size) {
+          cache_time[v] = time++;
+        }
+      }
+    }
+
+    // Prefer the candidate that entered the cache earliest but will still be
+    // in it after emitting all of its remaining triangles
+    std::uint32_t next = kInvalid;
+    std::size_t best = 0;
+    for (const auto v : candidates) {
+      if (live[v] == 0) {
+        continue;
+      }
+      std::size_t priority = 0;
+      if (time - cache_time[v] + 2 * live[v] <= cache_size) {
+        priority = time - cache_time[v];
+      }
+      if (next == kInvalid || priority > best) {
+        best = priority;
+        next = v;
+      }
+    }
+    cold = next == kInvalid;
+    fanning = cold ? skip_dead_end() : next;
+  }
+  indices->swap(output);
+}
+
+void MeshOptimizer::OptimizeOverdraw(
+    std::vector<std::uint32_t>* indices, const std::vector<Vertex>& vertices,
+    const std::vector<std::uint32_t>& clusters) {
+  if (clusters.size() < 2) {
+    return;
+  }
+  const std::vector<std::uint32_t>& input = *indices;
+
+  struct Cluster {
+    std::uint32_t begin;
+    std::uint32_t end;
+    float sort_key;
+  };
+  std::vector<Cluster> sorted;
+  sorted.reserve(clusters.size());
+
+  glm::vec3 mesh_centroid(0.0f);
+  float mesh_area = 0.0f;
+  std::vector<glm::vec3> centroids(clusters.size(), glm::vec3(0.0f));
+  std::vector<glm::vec3> normals(clusters.size(), glm::vec3(0.0f));
+  for (std::size_t c = 0; c < clusters.size(); c++) {
+    const std::uint32_t begin = clusters[c];
+    const std::uint32_t end = c + 1 < clusters.size()
+                                  ? clusters[c + 1]
+                                  : static_cast<std::uint32_t>(input.size());
+    float area = 0.0f;
+    for (std::uint32_t i = begin; i < end; i += 3) {
+      const glm::vec3 p0 = vertices[input[i]].position;
+      const glm::vec3 p1 = vertices[input[i + 1]].position;
+      const glm::vec3 p2 = vertices[input[i + 2]].position;
+      const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+      const float triangle_area = glm::length(normal);
+      centroids[c] += (p0 + p1 + p2) * (triangle_area / 3.0f);
+      normals[c] += normal;
+      area += triangle_area;
+    }
+    mesh_centroid += centroids[c];
+    mesh_area += area;
+    if (area > 0.0f) {
+      centroids[c] /= area;
+    }
+    sorted.push_back(Cluster{begin, end, 0.0f});
+  }
+  if (mesh_area > 0.0f) {
+    mesh_centroid /= mesh_area;
+  }
+
+  // Clusters far out along their own normal are on the outside of the mesh
+  for (std::size_t c = 0; c < sorted.size(); c++) {
+    const float length = glm::length(normals[c]);
+    if (length > 0.0f) {
+      sorted[c].sort_key =
+          glm::dot(centroids[c] - mesh_centroid, normals[c] / length);
+    }
+  }
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const Cluster& a, const Cluster& b) {
+                     return a.sort_key > b.sort_key;
+                   });
+
+  std::vector<std::uint32_t> output;
+  output.reserve(input.size());
+  for (const auto& cluster : sorted) {
+    output.insert(output.end(), input.begin() + cluster.begin,
+                  input.begin() + cluster.end);
+  }
+  indices->swap(output);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>* vertices,
+                                        std::vector<std::uint32_t>* indices) {
+  std::vector<std::uint32_t> remap(vertices->size(), kInvalid);
+  std::uint32_t next = 0;
+  for (auto& index : *indices) {
+    if (remap[index] == kInvalid) {
+      remap[index] = next++;
+    }
+    index = remap[index];
+  }
+  for (auto& target : remap) {
+    if (target == kInvalid) {
+      target = next++;
+    }
+  }
+
+  std::vector<Vertex> output(vertices->size());
+  for (std::size_t i = 0; i < vertices->size(); i++) {
+    output[remap[i]] = (*vertices)[i];
+  }
+  vertices->swap(output);
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(
+    const std::vector<std::uint32_t>& indices, const std::size_t vertex_count,
+    const std::size_t cache_size) {
+  VertexCacheStats stats;
+  if (indices.empty()) {
+    return stats;
+  }
+  std::vector<std::size_t> cache_time(vertex_count, 0);
+  std::vector<bool> referenced(vertex_count, false);
+  std::size_t time = cache_size + 1;
+  std::size_t unique = 0;
+  for (const auto index : indices) {
+    if (time - cache_time[index] > cache_size) {
+      cache_time[index] = time++;
+      stats.vertices_transformed++;
+    }
+    if (!referenced[index]) {
+      referenced[index] = true;
+      unique++;
+    }
+  }
+  stats.acmr = static_cast<float>(stats.vertices_transformed) /
+               static_cast<float>(indices.size() / 3);
+  stats.atvr = static_cast<float>(stats.vertices_transformed) /
+               static_cast<float>(unique);
+  return stats;
+}
+
+} /* namespace game_engine::_3D */
@@ -0,0 +1,109 @@
+/******************************************************************************
+ * MeshOptimizer.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_3D_MESHOPTIMIZER_HPP_
+#define SRC_3D_MESHOPTIMIZER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "Vertex.hpp"
+
+namespace game_engine::_3D {
+
+/**
+ * @brief Efficiency of an index buffer on a FIFO post-transform vertex cache
+ */
+struct VertexCacheStats {
+  std::size_t vertices_transformed = 0;
+  /**
+   * @brief Average cache miss ratio, vertices transformed per triangle.
+   *        0.5 is the ideal for a large regular grid, 3 the worst case.
+   */
+  float acmr = 0.0f;
+  /**
+   * @brief Average transform to vertex ratio, vertices transformed per
+   *        vertex referenced.  1 is ideal.
+   */
+  float atvr = 0.0f;
+};
+
+std::ostream& operator<<(std::ostream& os, const VertexCacheStats& stats);
+
+/**
+ * @brief Reorders indexed triangle lists to render faster without changing
+ *        what they look like
+ *
+ * Meant to run once at import, in the order OptimizeVertexCache,
+ * OptimizeOverdraw, OptimizeVertexFetch.  Optimize runs all three.
+ */
+class MeshOptimizer {
+ public:
+  static constexpr std::size_t kCacheSize = 16;
+
+  /**
+   * @brief Run every pass on a triangle list
+   * @return Returns the cache efficiency before and after
+   */
+  static std::pair<VertexCacheStats, VertexCacheStats> Optimize(
+      std::vector<Vertex>* vertices, std::vector<std::uint32_t>* indices);
+
+  /**
+   * @brief Reorder triangles for the post-transform vertex cache using
+   *        Tipsify (Sander, Nehab & Barczak 2007)
+   * @param clusters If not null, set to the first index of each run of
+   *                 triangles that starts from a cold cache.  Reordering
+   *                 these runs does not hurt the cache much, which is what
+   *                 OptimizeOverdraw relies on.
+   */
+  static void OptimizeVertexCache(
+      std::vector<std::uint32_t>* indices, const std::size_t vertex_count,
+      std::vector<std::uint32_t>* clusters = nullptr,
+      const std::size_t cache_size = kCacheSize);
+
+  /**
+   * @brief Sort clusters of triangles so those facing away from the center
+   *        of the mesh are drawn first and occlude the rest from most views
+   * @param clusters First index of each cluster, as from OptimizeVertexCache
+   */
+  static void OptimizeOverdraw(std::vector<std::uint32_t>* indices,
+                               const std::vector<Vertex>& vertices,
+                               const std::vector<std::uint32_t>& clusters);
+
+  /**
+   * @brief Reorder vertices in the order they are first used, updating the
+   *        indices.  Unreferenced vertices are moved to the end.
+   */
+  static void OptimizeVertexFetch(std::vector<Vertex>* vertices,
+                                  std::vector<std::uint32_t>* indices);
+
+  /**
+   * @brief Simulate a FIFO vertex cache over a triangle list
+   */
+  static VertexCacheStats AnalyzeVertexCache(
+      const std::vector<std::uint32_t>& indices, const std::size_t vertex_count,
+      const std::size_t cache_size = kCacheSize);
+};
+
+} /* namespace game_engine::_3D */
+
+#endif /* SRC_3D_MESHOPTIMIZER_HPP_ */
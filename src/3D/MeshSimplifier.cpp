@@ -0,0 +1,567 @@
+/******************************************************************************
+ * MeshSimplifier.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <glm/glm.hpp>
+
+namespace game_engine::_3D {
+
+namespace {
+
+/**
+ * @brief How a vertex position may be collapsed
+ */
+enum class VertexKind : std::uint8_t {
+  MANIFOLD,  // Interior vertex with a single set of attributes
+  BORDER,    // On exactly one open boundary loop
+  SEAM,      // Two sets of attributes meeting along a seam
+  LOCKED     // Anything more complex, never moved
+};
+
+constexpr double kBorderWeight = 10.0;
+/**
+ * @brief Smallest cosine allowed between a triangle's normal before and after
+ *        a collapse
+ */
+constexpr float kFlipThreshold = 0.25f;
+constexpr std::uint32_t kInvalid = ~0u;
+
+/**
+ * @brief Symmetric 4x4 quadric, normalized by the total weight of its planes
+ */
+struct Quadric {
+  double a00 = 0.0, a11 = 0.0, a22 = 0.0;
+  double a01 = 0.0, a02 = 0.0, a12 = 0.0;
+  double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+  double c = 0.0;
+  double weight = 0.0;
+
+  void AddPlane(const glm::vec3 n, const float d, const double w) {
+    a00 += w * n.x * n.x;
+    a11 += w * n.y * n.y;
+    a22 += w * n.z * n.z;
+    a01 += w * n.x * n.y;
+    a02 += w * n.x * n.z;
+    a12 += w * n.y * n.z;
+    b0 += w * n.x * d;
+    b1 += w * n.y * d;
+    b2 += w * n.z * d;
+    c += w * d * d;
+    weight += w;
+  }
+
+  Quadric& operator+=(const Quadric& o) {
+    a00 += o.a00;
+    a11 += o.a11;
+    a22 += o.a22;
+    a01 += o.a01;
+    a02 += o.a02;
+    a12 += o.a12;
+    b0 += o.b0;
+    b1 += o.b1;
+    b2 += o.b2;
+    c += o.c;
+    weight += o.weight;
+    return *this;
+  }
+
+  /**
+   * @brief Weighted mean squared distance from a point to the planes
+   */
+  double Error(const glm::vec3 p) const {
+    if (weight <= 0.0) {
+      return 0.0;
+    }
+    const double x = p.x;
+    const double y = p.y;
+    const double z = p.z;
+    const double error = a00 * x * x + a11 * y * y + a22 * z * z +
+                         2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+                         2.0 * (b0 * x + b1 * y + b2 * z) + c;
+    return std::max(0.0, error) / weight;
+  }
+};
+
+struct PositionHash {
+  std::size_t operator()(const glm::vec3& p) const {
+    std::uint32_t bits[3];
+    std::memcpy(bits, &p, sizeof(bits));
+    return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^
+           (bits[2] * 83492791u);
+  }
+};
+
+struct PositionEqual {
+  bool operator()(const glm::vec3& a, const glm::vec3& b) const {
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+  }
+};
+
+inline std::uint64_t EdgeKey(const std::uint32_t a, const std::uint32_t b) {
+  return (static_cast<std::uint64_t>(a) << 32) | b;
+}
+
+struct Collapse {
+  std::uint32_t from;
+  std::uint32_t to;
+  float cost;
+};
+
+/**
+ * @brief Working state of one Simplify call
+ *
+ * "Position" indices are the first vertex with a given position; every other
+ * vertex sharing it is a wedge linked through wedge_.
+ */
+class Simplifier {
+ public:
+  Simplifier(const std::vector<Vertex>& vertices,
+             const std::vector<std::uint32_t>& indices)
+      : vertices_(vertices),
+        indices_(indices),
+        remap_(vertices.size()),
+        wedge_(vertices.size()),
+        kind_(vertices.size(), VertexKind::MANIFOLD),
+        border_next_(vertices.size(), kInvalid),
+        border_prev_(vertices.size(), kInvalid),
+        quadrics_(vertices.size()),
+        collapse_remap_(vertices.size()) {
+    BuildPositionRemap();
+    RemoveDegenerateTriangles();
+    ClassifyVertices();
+    ComputeQuadrics();
+    for (std::uint32_t i = 0; i < collapse_remap_.size(); i++) {
+      collapse_remap_[i] = i;
+    }
+  }
+
+  std::vector<std::uint32_t> Run(const std::size_t target_index_count,
+                                 const float max_error, float* result_error) {
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(std::numeric_limits<float>::lowest());
+    for (const auto index : indices_) {
+      min = glm::min(min, vertices_[index].position);
+      max = glm::max(max, vertices_[index].position);
+    }
+    const float extent = std::max({max.x - min.x, max.y - min.y, max.z - min.z,
+                                   std::numeric_limits<float>::min()});
+    const double error_limit = static_cast<double>(max_error) * extent *
+                               static_cast<double>(max_error) * extent;
+    double error_reached = 0.0;
+
+    while (indices_.size() > target_index_count) {
+      BuildAdjacency();
+      std::vector<Collapse> collapses = GatherCollapses();
+      std::sort(collapses.begin(), collapses.end(),
+                [](const Collapse& a, const Collapse& b) {
+                  return a.cost < b.cost;
+                });
+
+      const std::size_t triangles_to_remove =
+          (indices_.size() - target_index_count + 2) / 3;
+      std::size_t removed = 0;
+      std::size_t applied = 0;
+      std::fill(locked_.begin(), locked_.end(), false);
+      for (const auto& collapse : collapses) {
+        if (collapse.cost > error_limit || removed >= triangles_to_remove) {
+          break;
+        }
+        if (locked_[collapse.from] || locked_[collapse.to]) {
+          continue;
+        }
+        const std::size_t collapsed = Apply(collapse);
+        if (collapsed == 0) {
+          continue;
+        }
+        removed += collapsed;
+        applied++;
+        error_reached =
+            std::max(error_reached, static_cast<double>(collapse.cost));
+      }
+      if (applied == 0) {
+        break;
+      }
+      RemapIndices();
+    }
+
+    if (result_error) {
+      *result_error = static_cast<float>(std::sqrt(error_reached) / extent);
+    }
+    return indices_;
+  }
+
+ protected:
+  void BuildPositionRemap() {
+    std::unordered_map<glm::vec3, std::uint32_t, PositionHash, PositionEqual>
+        positions;
+    positions.reserve(vertices_.size());
+    for (std::uint32_t i = 0; i < vertices_.size(); i++) {
+      const auto it = positions.emplace(vertices_[i].position, i).first;
+      const std::uint32_t position = it->second;
+      remap_[i] = position;
+      wedge_[i] = i;
+      if (position != i) {
+        // Insert into the ring of wedges of this position
+        wedge_[i] = wedge_[position];
+        wedge_[position] = i;
+      }
+    }
+  }
+
+  void RemoveDegenerateTriangles() {
+    std::size_t write = 0;
+    for (std::size_t i = 0; i + 2 < indices_.size(); i += 3) {
+      const std::uint32_t a = remap_[indices_[i]];
+      const std::uint32_t b = remap_[indices_[i + 1]];
+      const std::uint32_t c = remap_[indices_[i + 2]];
+      if (a == b || b == c || c == a) {
+        continue;
+      }
+      indices_[write++] = indices_[i];
+      indices_[write++] = indices_[i + 1];
+      indices_[write++] = indices_[i + 2];
+    }
+    indices_.resize(write);
+  }
+
+  std::size_t WedgeCount(const std::uint32_t position) const {
+    std::size_t count = 1;
+    for (std::uint32_t w = wedge_[position]; w != position; w = wedge_[w]) {
+      count++;
+    }
+    return count;
+  }
+
+  void ClassifyVertices() {
+    std::unordered_set<std::uint64_t> position_edges;
+    position_edges.reserve(indices_.size());
+    for (std::size_t i = 0; i < indices_.size(); i += 3) {
+      for (int k = 0; k < 3; k++) {
+        position_edges.insert(EdgeKey(remap_[indices_[i + k]],
+                                      remap_[indices_[i + (k + 1) % 3]]));
+      }
+    }
+
+    std::vector<std::uint8_t> border_out(vertices_.size(), 0);
+    std::vector<std::uint8_t> border_in(vertices_.size(), 0);
+    for (std::size_t i = 0; i < indices_.size(); i += 3) {
+      for (int k = 0; k < 3; k++) {
+        const std::uint32_t a = remap_[indices_[i + k]];
+        const std::uint32_t b = remap_[indices_[i + (k + 1) % 3]];
+        if (position_edges.count(EdgeKey(b, a)) == 0) {
+          border_out[a] = static_cast<std::uint8_t>(
+              std::min(border_out[a] + 1, 255));
+          border_in[b] =
+              static_cast<std::uint8_t>(std::min(border_in[b] + 1, 255));
+          border_next_[a] = b;
+          border_prev_[b] = a;
+        }
+      }
+    }
+
+    for (std::uint32_t i = 0; i < vertices_.size(); i++) {
+      if (remap_[i] != i) {
+        continue;
+      }
+      const std::size_t wedges = WedgeCount(i);
+      VertexKind kind = VertexKind::LOCKED;
+      if (border_out[i] == 0 && border_in[i] == 0) {
+        if (wedges == 1) {
+          kind = VertexKind::MANIFOLD;
+        } else if (wedges == 2) {
+          kind = VertexKind::SEAM;
+        }
+      } else if (wedges == 1 && border_out[i] == 1 && border_in[i] == 1) {
+        kind = VertexKind::BORDER;
+      }
+      kind_[i] = kind;
+    }
+  }
+
+  void ComputeQuadrics() {
+    std::unordered_set<std::uint64_t> attribute_edges;
+    attribute_edges.reserve(indices_.size());
+    for (std::size_t i = 0; i < indices_.size(); i += 3) {
+      for (int k = 0; k < 3; k++) {
+        attribute_edges.insert(
+            EdgeKey(indices_[i + k], indices_[i + (k + 1) % 3]));
+      }
+    }
+
+    for (std::size_t i = 0; i < indices_.size(); i += 3) {
+      const std::uint32_t r[3] = {remap_[indices_[i]], remap_[indices_[i + 1]],
+                                  remap_[indices_[i + 2]]};
+      const glm::vec3 p0 = vertices_[r[0]].position;
+      const glm::vec3 p1 = vertices_[r[1]].position;
+      const glm::vec3 p2 = vertices_[r[2]].position;
+      glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+      const float area2 = glm::length(normal);
+      if (area2 == 0.0f) {
+        continue;
+      }
+      normal /= area2;
+      const float d = -glm::dot(normal, p0);
+      for (int k = 0; k < 3; k++) {
+        quadrics_[r[k]].AddPlane(normal, d, 0.5 * area2);
+      }
+
+      // Planes perpendicular to border and seam edges keep them in place
+      for (int k = 0; k < 3; k++) {
+        const std::uint32_t a = indices_[i + k];
+        const std::uint32_t b = indices_[i + (k + 1) % 3];
+        if (attribute_edges.count(EdgeKey(b, a)) != 0) {
+          continue;
+        }
+        const glm::vec3 pa = vertices_[a].position;
+        const glm::vec3 edge = vertices_[b].position - pa;
+        const glm::vec3 perpendicular = glm::cross(edge, normal);
+        const float length = glm::length(perpendicular);
+        if (length == 0.0f) {
+          continue;
+        }
+        const glm::vec3 n = perpendicular / length;
+        const double weight = kBorderWeight * glm::dot(edge, edge);
+        quadrics_[remap_[a]].AddPlane(n, -glm::dot(n, pa), weight);
+        quadrics_[remap_[b]].AddPlane(n, -glm::dot(n, pa), weight);
+      }
+    }
+  }
+
+  /**
+   * @brief Triangles around each position, as offsets into adjacency_
+   */
+  void BuildAdjacency() {
+    adjacency_offsets_.assign(vertices_.size() + 1, 0);
+    for (const auto index : indices_) {
+      adjacency_offsets_[remap_[index] + 1]++;
+    }
+    for (std::size_t i = 1; i < adjacency_offsets_.size(); i++) {
+      adjacency_offsets_[i] += adjacency_offsets_[i - 1];
+    }
+    adjacency_.resize(indices_.size());
+    std::vector<std::uint32_t> fill(adjacency_offsets_.begin(),
+                                    adjacency_offsets_.end() - 1);
+    for (std::size_t i = 0; i < indices_.size(); i++) {
+      adjacency_[fill[remap_[indices_[i]]]++] =
+          static_cast<std::uint32_t>(i / 3);
+    }
+    locked_.assign(vertices_.size(), false);
+  }
+
+  bool CanCollapse(const std::uint32_t from, const std::uint32_t to) const {
+    switch (kind_[from]) {
+      case VertexKind::MANIFOLD:
+        return true;
+      case VertexKind::BORDER:
+        return kind_[to] == VertexKind::BORDER &&
+               (border_next_[from] == to || border_prev_[from] == to);
+      case VertexKind::SEAM:
+        return kind_[to] == VertexKind::SEAM;
+      case VertexKind::LOCKED:
+        return false;
+    }
+    return false;
+  }
+
+  std::vector<Collapse> GatherCollapses() const {
+    std::vector<Collapse> collapses;
+    collapses.reserve(indices_.size());
+    for (std::size_t i = 0; i < indices_.size(); i += 3) {
+      for (int k = 0; k < 3; k++) {
+        const std::uint32_t a = remap_[indices_[i + k]];
+        const std::uint32_t b = remap_[indices_[i + (k + 1) % 3]];
+        // Each interior edge is seen from both of its triangles, so only one
+        // direction is considered per triangle edge
+        if (CanCollapse(a, b)) {
+          collapses.push_back(Collapse{
+              a, b,
+              static_cast<float>(quadrics_[a].Error(vertices_[b].position))});
+        }
+      }
+    }
+    return collapses;
+  }
+
+  /**
+   * @brief Collapse a position onto another if it keeps the mesh valid
+   * @return Returns the number of triangles removed, 0 if rejected
+   */
+  std::size_t Apply(const Collapse& collapse) {
+    const std::uint32_t from = collapse.from;
+    const std::uint32_t to = collapse.to;
+    const std::uint32_t begin = adjacency_offsets_[from];
+    const std::uint32_t end = adjacency_offsets_[from + 1];
+    const glm::vec3 target = vertices_[to].position;
+
+    // Reject collapses that flip or fold any remaining triangle
+    std::size_t removed = 0;
+    for (std::uint32_t t = begin; t < end; t++) {
+      const std::size_t tri = static_cast<std::size_t>(adjacency_[t]) * 3;
+      glm::vec3 p[3];
+      bool touches_target = false;
+      int moved = -1;
+      for (int k = 0; k < 3; k++) {
+        const std::uint32_t r = remap_[indices_[tri + k]];
+        p[k] = vertices_[r].position;
+        touches_target |= r == to;
+        if (r == from) {
+          moved = k;
+        }
+      }
+      if (touches_target) {
+        removed++;
+        continue;
+      }
+      const glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+      p[moved] = target;
+      const glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+      const float lengths = glm::length(before) * glm::length(after);
+      if (!(glm::dot(before, after) > kFlipThreshold * lengths)) {
+        return 0;
+      }
+    }
+    if (removed == 0) {
+      return 0;
+    }
+
+    // Each wedge of the collapsed position moves onto the wedge of the target
+    // it shares a triangle with, which keeps both sides of a seam intact
+    std::uint32_t mapped_first = kInvalid;
+    std::uint32_t wedge = from;
+    do {
+      std::uint32_t mapped = kInvalid;
+      for (std::uint32_t t = begin; t < end && mapped == kInvalid; t++) {
+        const std::size_t tri = static_cast<std::size_t>(adjacency_[t]) * 3;
+        bool has_wedge = false;
+        std::uint32_t candidate = kInvalid;
+        for (int k = 0; k < 3; k++) {
+          has_wedge |= indices_[tri + k] == wedge;
+          if (remap_[indices_[tri + k]] == to) {
+            candidate = indices_[tri + k];
+          }
+        }
+        if (has_wedge) {
+          mapped = candidate;
+        }
+      }
+      if (mapped == kInvalid || mapped == mapped_first) {
+        // Restore any wedge already remapped
+        for (std::uint32_t w = from; w != wedge; w = wedge_[w]) {
+          collapse_remap_[w] = w;
+        }
+        return 0;
+      }
+      if (mapped_first == kInvalid) {
+        mapped_first = mapped;
+      }
+      collapse_remap_[wedge] = mapped;
+      wedge = wedge_[wedge];
+    } while (wedge != from);
+
+    quadrics_[to] += quadrics_[from];
+    if (kind_[from] == VertexKind::BORDER) {
+      if (border_next_[from] == to) {
+        border_prev_[to] = border_prev_[from];
+        border_next_[border_prev_[from]] = to;
+      } else {
+        border_next_[to] = border_next_[from];
+        border_prev_[border_next_[from]] = to;
+      }
+    }
+    // Lock the one-ring so no other collapse this pass sees stale triangles
+    for (std::uint32_t t = begin; t < end; t++) {
+      const std::size_t tri = static_cast<std::size_t>(adjacency_[t]) * 3;
+      for (int k = 0; k < 3; k++) {
+        locked_[remap_[indices_[tri + k]]] = true;
+      }
+    }
+    return removed;
+  }
+
+  void RemapIndices() {
+    for (auto& index : indices_) {
+      index = collapse_remap_[index];
+    }
+    RemoveDegenerateTriangles();
+  }
+
+  const std::vector<Vertex>& vertices_;
+  std::vector<std::uint32_t> indices_;
+  std::vector<std::uint32_t> remap_;
+  std::vector<std::uint32_t> wedge_;
+  std::vector<VertexKind> kind_;
+  std::vector<std::uint32_t> border_next_;
+  std::vector<std::uint32_t> border_prev_;
+  std::vector<Quadric> quadrics_;
+  std::vector<std::uint32_t> collapse_remap_;
+  std::vector<std::uint32_t> adjacency_offsets_{};
+  std::vector<std::uint32_t> adjacency_{};
+  std::vector<bool> locked_{};
+};
+
+}  // namespace
+
+std::vector<std::uint32_t> MeshSimplifier::Simplify(
+    const std::vector<Vertex>& vertices,
+    const std::vector<std::uint32_t>& indices,
+    const std::size_t target_index_count, const float max_error,
+    float* result_error) {
+  if (result_error) {
+    *result_error = 0.0f;
+  }
+  if (indices.size() <= target_index_count || indices.size() < 3) {
+    return indices;
+  }
+  Simplifier simplifier(vertices, indices);
+  return simplifier.Run(target_index_count, max_error, result_error);
+}
+
+std::vector<std::vector<std::uint32_t>> MeshSimplifier::GenerateLods(
+    const std::vector<Vertex>& vertices,
+    const std::vector<std::uint32_t>& indices,
+    const MeshLodOptions& options) {
+  std::vector<std::vector<std::uint32_t>> lods;
+  const std::vector<std::uint32_t>* previous = &indices;
+  for (const float ratio : options.ratios) {
+    const std::size_t target =
+        static_cast<std::size_t>(static_cast<float>(indices.size() / 3) *
+                                 ratio) *
+        3;
+    std::vector<std::uint32_t> lod =
+        Simplify(vertices, *previous, target, options.max_error);
+    // Not worth a draw range of its own
+    if (lod.empty() || lod.size() * 10 > previous->size() * 9) {
+      break;
+    }
+    lods.push_back(std::move(lod));
+    previous = &lods.back();
+  }
+  return lods;
+}
+
+} /* namespace game_engine::_3D */
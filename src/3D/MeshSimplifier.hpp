@@ -0,0 +1,105 @@
+/******************************************************************************
+ * MeshSimplifier.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_3D_MESHSIMPLIFIER_HPP_
+#define SRC_3D_MESHSIMPLIFIER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Vertex.hpp"
+
+namespace game_engine::_3D {
+
+/**
+ * @brief Options controlling the LOD chain generated for each mesh
+ */
+struct MeshLodOptions {
+  /**
+   * @brief Generate LODs at all
+   */
+  bool enabled = true;
+  /**
+   * @brief Fraction of the original triangles kept by each LOD after LOD 0
+   */
+  std::vector<float> ratios{0.5f, 0.25f, 0.1f};
+  /**
+   * @brief Fraction of the screen height below which each LOD after LOD 0 is
+   *        used.  One entry per ratio.
+   */
+  std::vector<float> screen_sizes{0.5f, 0.25f, 0.1f};
+  /**
+   * @brief Largest error allowed, relative to the size of the mesh
+   */
+  float max_error = 0.05f;
+  /**
+   * @brief Relative margin around each screen size that must be crossed
+   *        before switching LOD, so objects near a threshold do not flicker
+   */
+  float hysteresis = 0.1f;
+};
+
+/**
+ * @brief Quadric error metric mesh simplifier
+ *
+ * Repeatedly collapses the edge whose removal adds the least quadric error
+ * (Garland & Heckbert) by moving one vertex onto the other.  Vertices are
+ * never moved or merged, so the result is a new index buffer over the
+ * original vertex buffer and every LOD can share it.
+ *
+ * Vertices sharing a position but not their other attributes form a seam.
+ * Seam vertices only collapse along the seam, both sides at once, and open
+ * borders only along the border, so UV seams, hard normals and outlines are
+ * preserved.  Collapses that would flip or fold a triangle are rejected.
+ * The simplifier has no dependency on a rendering API so it can also be used
+ * by offline asset tooling.
+ */
+class MeshSimplifier {
+ public:
+  /**
+   * @brief Simplify an indexed triangle list
+   * @param vertices Vertex buffer
+   * @param indices Three indices per triangle
+   * @param target_index_count Stop once at most this many indices remain
+   * @param max_error Stop before exceeding this error, relative to the size
+   *                  of the mesh
+   * @param result_error If not null, set to the relative error reached
+   * @return Returns the simplified index buffer
+   */
+  static std::vector<std::uint32_t> Simplify(
+      const std::vector<Vertex>& vertices,
+      const std::vector<std::uint32_t>& indices,
+      const std::size_t target_index_count, const float max_error,
+      float* result_error = nullptr);
+
+  /**
+   * @brief Generate a chain of LODs, each simplified from the previous one
+   * @return Returns one index buffer per ratio in options, stopping early once
+   *         a LOD can not be reduced meaningfully
+   */
+  static std::vector<std::vector<std::uint32_t>> GenerateLods(
+      const std::vector<Vertex>& vertices,
+      const std::vector<std::uint32_t>& indices,
+      const MeshLodOptions& options);
+};
+
+} /* namespace game_engine::_3D */
+
+#endif /* SRC_3D_MESHSIMPLIFIER_HPP_ */
@@ -0,0 +1,486 @@
+/******************************************************************************
+ * MipmapGenerator.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/MipmapGenerator.hpp"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "Util/CpuFeatures.hpp"
+#include "Util/ParallelFor.hpp"
+
+namespace game_engine::_3D {
+
+namespace {
+
+constexpr int kKaiserRadius = 4;
+constexpr float kKaiserAlpha = 4.0f;
+constexpr int kMinRowsPerThread = 16;
+constexpr std::size_t kEncodeLutSize = 16384;
+
+/**
+ * @brief Split the rows of a level across worker threads
+ */
+void ParallelForRows(const int rows, const unsigned int max_threads,
+                     const std::function<void(int, int)>& fn) {
+  util::ParallelFor(rows, max_threads, kMinRowsPerThread, fn);
+}
+
+/**
+ * @brief Float RGBA image used as the working format between levels
+ */
+struct FloatImage {
+  glm::ivec2 size{0, 0};
+  std::vector<float> data{};
+
+  float* Row(const int y) { return &data[static_cast<std::size_t>(y) * size.x * 4]; }
+  const float* Row(const int y) const {
+    return &data[static_cast<std::size_t>(y) * size.x * 4];
+  }
+};
+
+/**
+ * @brief Filter taps contributing to one destination texel along one axis
+ */
+struct Taps {
+  int first = 0;
+  std::vector<float> weights{};
+};
+
+const std::array<float, 256>& SrgbDecodeLut() {
+  static const std::array<float, 256> lut = [] {
+    std::array<float, 256> l{};
+    for (std::size_t i = 0; i < l.size(); i++) {
+      const float c = static_cast<float>(i) / 255.0f;
+      l[i] = (c <= 0.04045f) ? c / 12.92f
+                             : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+    return l;
+  }();
+  return lut;
+}
+
+const std::vector<std::uint8_t>& SrgbEncodeLut() {
+  static const std::vector<std::uint8_t> lut = [] {
+    std::vector<std::uint8_t> l(kEncodeLutSize);
+    for (std::size_t i = 0; i < l.size(); i++) {
+      const float c = static_cast<float>(i) / (kEncodeLutSize - 1);
+      const float s = (c <= 0.0031308f)
+                          ? c * 12.92f
+                          : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+      l[i] = static_cast<std::uint8_t>(std::lround(s * 255.0f));
+    }
+    return l;
+  }();
+  return lut;
+}
+
+inline std::uint8_t EncodeLinear(const float value) {
+  return static_cast<std::uint8_t>(
+      std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+}
+inline std::uint8_t EncodeSrgb(const float value) {
+  const float c = std::clamp(value, 0.0f, 1.0f);
+  return SrgbEncodeLut()[static_cast<std::size_t>(
+      std::lround(c * (kEncodeLutSize - 1)))];
+}
+
+float BesselI0(const float x) {
+  // Power series, converges quickly for the arguments used by the window
+  float sum = 1.0f;
+  float term = 1.0f;
+  const float half_x_sq = (x * x) / 4.0f;
+  for (int k = 1; k < 32; k++) {
+    term *= half_x_sq / static_cast<float>(k * k);
+    sum += term;
+    if (term < sum * 1e-7f) {
+      break;
+    }
+  }
+  return sum;
+}
+
+float Sinc(const float x) {
+  if (std::abs(x) < 1e-6f) {
+    return 1.0f;
+  }
+  const float px = static_cast<float>(M_PI) * x;
+  return std::sin(px) / px;
+}
+
+float KaiserWeight(const float distance, const float scale) {
+  const float t = distance / (kKaiserRadius * scale);
+  if (std::abs(t) >= 1.0f) {
+    return 0.0f;
+  }
+  const float window = BesselI0(kKaiserAlpha * std::sqrt(1.0f - t * t)) /
+                       BesselI0(kKaiserAlpha);
+  return Sinc(distance / scale) * window;
+}
+
+/**
+ * @brief Compute the Kaiser-windowed sinc taps for one axis
+ */
+std::vector<Taps> ComputeKaiserTaps(const int src_size, const int dst_size) {
+  const float scale =
+      static_cast<float>(src_size) / static_cast<float>(dst_size);
+  const int radius = static_cast<int>(std::ceil(kKaiserRadius * scale));
+  std::vector<Taps> taps(dst_size);
+  for (int x = 0; x < dst_size; x++) {
+    const float center = (static_cast<float>(x) + 0.5f) * scale - 0.5f;
+    Taps& t = taps[x];
+    t.first = static_cast<int>(std::floor(center)) - radius + 1;
+    float total = 0.0f;
+    for (int i = 0; i < 2 * radius; i++) {
+      const float w =
+          KaiserWeight(static_cast<float>(t.first + i) - center, scale);
+      t.weights.push_back(w);
+      total += w;
+    }
+    for (auto& w : t.weights) {
+      w /= total;
+    }
+  }
+  return taps;
+}
+
+inline void Accumulate(float* dst, const float* src, const float weight) {
+#if defined(__SSE2__)
+  _mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst),
+                                _mm_mul_ps(_mm_loadu_ps(src),
+                                           _mm_set1_ps(weight))));
+#else
+  for (int c = 0; c < 4; c++) {
+    dst[c] += src[c] * weight;
+  }
+#endif
+}
+
+/**
+ * @brief Average a 2x2 block of RGBA texels
+ */
+inline void Box2x2(float* dst, const float* a0, const float* a1,
+                   const float* b0, const float* b1) {
+#if defined(__SSE2__)
+  const __m128 total =
+      _mm_add_ps(_mm_add_ps(_mm_loadu_ps(a0), _mm_loadu_ps(a1)),
+                 _mm_add_ps(_mm_loadu_ps(b0), _mm_loadu_ps(b1)));
+  _mm_storeu_ps(dst, _mm_mul_ps(total, _mm_set1_ps(0.25f)));
+#else
+  for (int c = 0; c < 4; c++) {
+    dst[c] = (a0[c] + a1[c] + b0[c] + b1[c]) * 0.25f;
+  }
+#endif
+}
+
+#if defined(__SSE2__)
+/**
+ * @brief Average the 2x2 blocks under a row of destination texels, two
+ *        texels at a time.  Built for AVX2 whatever the build flags, so it may
+ *        only be called if util::HasAvx2().
+ * @return Returns the first texel left for Box2x2, where the blocks reach
+ *         past the edge of the source
+ */
+__attribute__((target("avx2"))) int BoxRowAvx2(float* dst, const float* row0,
+                                               const float* row1,
+                                               const int dst_width,
+                                               const int src_width) {
+  const __m256 quarter = _mm256_set1_ps(0.25f);
+  int x = 0;
+  for (; x + 2 <= dst_width && 2 * x + 4 <= src_width; x += 2) {
+    // Texels 0 and 1 of the four source columns in each register
+    const __m256 left = _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8),
+                                      _mm256_loadu_ps(row1 + x * 8));
+    const __m256 right = _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8 + 8),
+                                       _mm256_loadu_ps(row1 + x * 8 + 8));
+    const __m256 even = _mm256_permute2f128_ps(left, right, 0x20);
+    const __m256 odd = _mm256_permute2f128_ps(left, right, 0x31);
+    _mm256_storeu_ps(dst + x * 4,
+                     _mm256_mul_ps(_mm256_add_ps(even, odd), quarter));
+  }
+  return x;
+}
+
+/**
+ * @brief Add a weighted row of texels to another, two texels at a time.
+ *        Built for AVX2 whatever the build flags, so it may only be called
+ *        if util::HasAvx2().
+ * @return Returns the first texel left for Accumulate
+ */
+__attribute__((target("avx2"))) int AccumulateRowAvx2(float* dst,
+                                                      const float* src,
+                                                      const float weight,
+                                                      const int width) {
+  const __m256 w = _mm256_set1_ps(weight);
+  int x = 0;
+  for (; x + 2 <= width; x += 2) {
+    _mm256_storeu_ps(dst + x * 4,
+                     _mm256_add_ps(_mm256_loadu_ps(dst + x * 4),
+                                   _mm256_mul_ps(_mm256_loadu_ps(src + x * 4),
+                                                 w)));
+  }
+  return x;
+}
+#endif
+
+FloatImage DownsampleBox(const FloatImage& src, const glm::ivec2 dst_size,
+                         const unsigned int max_threads) {
+  FloatImage dst{dst_size,
+                 std::vector<float>(static_cast<std::size_t>(dst_size.x) *
+                                    dst_size.y * 4)};
+  const bool has_avx2 = util::HasAvx2();
+  ParallelForRows(dst_size.y, max_threads, [&](const int begin, const int end) {
+    for (int y = begin; y < end; y++) {
+      const float* row0 = src.Row(std::min(2 * y, src.size.y - 1));
+      const float* row1 = src.Row(std::min(2 * y + 1, src.size.y - 1));
+      float* out = dst.Row(y);
+      int x = 0;
+#if defined(__SSE2__)
+      if (has_avx2) {
+        x = BoxRowAvx2(out, row0, row1, dst_size.x, src.size.x);
+      }
+#endif
+      for (; x < dst_size.x; x++) {
+        const int x0 = std::min(2 * x, src.size.x - 1) * 4;
+        const int x1 = std::min(2 * x + 1, src.size.x - 1) * 4;
+        Box2x2(out + x * 4, row0 + x0, row0 + x1, row1 + x0, row1 + x1);
+      }
+    }
+  });
+  return dst;
+}
+
+FloatImage DownsampleKaiser(const FloatImage& src, const glm::ivec2 dst_size,
+                            const unsigned int max_threads) {
+  const std::vector<Taps> taps_x = ComputeKaiserTaps(src.size.x, dst_size.x);
+  const std::vector<Taps> taps_y = ComputeKaiserTaps(src.size.y, dst_size.y);
+
+  // Horizontal pass: src.size.y rows of dst_size.x texels
+  FloatImage tmp{glm::ivec2(dst_size.x, src.size.y),
+                 std::vector<float>(static_cast<std::size_t>(dst_size.x) *
+                                    src.size.y * 4)};
+  ParallelForRows(src.size.y, max_threads, [&](const int begin, const int end) {
+    for (int y = begin; y < end; y++) {
+      const float* in = src.Row(y);
+      float* out = tmp.Row(y);
+      for (int x = 0; x < dst_size.x; x++) {
+        const Taps& t = taps_x[x];
+        for (std::size_t i = 0; i < t.weights.size(); i++) {
+          const int sx = std::clamp(t.first + static_cast<int>(i), 0,
+                                    src.size.x - 1);
+          Accumulate(out + x * 4, in + sx * 4, t.weights[i]);
+        }
+      }
+    }
+  });
+
+  // Vertical pass
+  FloatImage dst{dst_size,
+                 std::vector<float>(static_cast<std::size_t>(dst_size.x) *
+                                    dst_size.y * 4)};
+  const bool has_avx2 = util::HasAvx2();
+  ParallelForRows(dst_size.y, max_threads, [&](const int begin, const int end) {
+    for (int y = begin; y < end; y++) {
+      const Taps& t = taps_y[y];
+      float* out = dst.Row(y);
+      for (std::size_t i = 0; i < t.weights.size(); i++) {
+        const int sy =
+            std::clamp(t.first + static_cast<int>(i), 0, src.size.y - 1);
+        const float* in = tmp.Row(sy);
+        int x = 0;
+#if defined(__SSE2__)
+        if (has_avx2) {
+          x = AccumulateRowAvx2(out, in, t.weights[i], dst_size.x);
+        }
+#endif
+        for (; x < dst_size.x; x++) {
+          Accumulate(out + x * 4, in + x * 4, t.weights[i]);
+        }
+      }
+    }
+  });
+  return dst;
+}
+
+FloatImage Decode(const glm::ivec2 size, const int channels,
+                  const std::uint8_t* pixels, const std::size_t row_stride,
+                  const bool srgb) {
+  const auto& lut = SrgbDecodeLut();
+  FloatImage image{size, std::vector<float>(
+                             static_cast<std::size_t>(size.x) * size.y * 4)};
+  for (int y = 0; y < size.y; y++) {
+    const std::uint8_t* in = pixels + y * row_stride;
+    float* out = image.Row(y);
+    for (int x = 0; x < size.x; x++) {
+      for (int c = 0; c < 4; c++) {
+        float value = (c == 3) ? 1.0f : 0.0f;
+        if (c < channels) {
+          const std::uint8_t raw = in[x * channels + c];
+          value = (srgb && c < 3) ? lut[raw] : raw / 255.0f;
+        }
+        out[x * 4 + c] = value;
+      }
+    }
+  }
+  return image;
+}
+
+float AlphaCoverage(const FloatImage& image, const float cutoff,
+                    const float scale) {
+  std::size_t passing = 0;
+  const std::size_t texels = image.data.size() / 4;
+  for (std::size_t i = 0; i < texels; i++) {
+    if (image.data[i * 4 + 3] * scale >= cutoff) {
+      passing++;
+    }
+  }
+  return static_cast<float>(passing) / static_cast<float>(texels);
+}
+
+/**
+ * @brief Find the alpha scale that makes a level's coverage match the target
+ */
+float FindAlphaScale(const FloatImage& image, const float cutoff,
+                     const float target_coverage) {
+  float low = 0.0f;
+  float high = 1.0f;
+  float threshold = cutoff;
+  for (int i = 0; i < 12; i++) {
+    threshold = (low + high) * 0.5f;
+    if (AlphaCoverage(image, threshold, 1.0f) > target_coverage) {
+      low = threshold;
+    } else {
+      high = threshold;
+    }
+  }
+  return (threshold > 0.0f) ? cutoff / threshold : 1.0f;
+}
+
+MipLevel Encode(const FloatImage& image, const int channels, const bool srgb,
+                const float alpha_scale) {
+  MipLevel level;
+  level.size = image.size;
+  level.pixels.resize(static_cast<std::size_t>(image.size.x) * image.size.y *
+                      channels);
+  const std::size_t texels = image.data.size() / 4;
+  for (std::size_t i = 0; i < texels; i++) {
+    const float* in = &image.data[i * 4];
+    std::uint8_t* out = &level.pixels[i * channels];
+    for (int c = 0; c < channels; c++) {
+      if (c == 3) {
+        out[c] = EncodeLinear(in[c] * alpha_scale);
+      } else {
+        out[c] = srgb ? EncodeSrgb(in[c]) : EncodeLinear(in[c]);
+      }
+    }
+  }
+  return level;
+}
+
+}  // namespace
+
+int MipmapGenerator::LevelCount(const glm::ivec2 size) {
+  int levels = 1;
+  int largest = std::max(size.x, size.y);
+  while (largest > 1) {
+    largest /= 2;
+    levels++;
+  }
+  return levels;
+}
+
+MipChain MipmapGenerator::Generate(const glm::ivec2 size, const int channels,
+                                   const std::uint8_t* pixels,
+                                   const std::size_t row_stride) const {
+  MipChain chain;
+  chain.channels = std::clamp(channels, 1, 4);
+  if (size.x <= 0 || size.y <= 0 || pixels == nullptr) {
+    return chain;
+  }
+  const std::size_t stride =
+      (row_stride != 0) ? row_stride
+                        : static_cast<std::size_t>(size.x) * chain.channels;
+  const bool has_alpha = (chain.channels == 4);
+  const bool preserve_coverage = options_.preserve_alpha_coverage && has_alpha;
+
+  const int level_count =
+      (options_.max_levels > 0)
+          ? std::min(LevelCount(size), options_.max_levels)
+          : LevelCount(size);
+  chain.levels.reserve(level_count);
+
+  // Level 0 is copied as is, only repacked if the source had padding
+  MipLevel base;
+  base.size = size;
+  base.pixels.resize(static_cast<std::size_t>(size.x) * size.y *
+                     chain.channels);
+  for (int y = 0; y < size.y; y++) {
+    std::memcpy(&base.pixels[static_cast<std::size_t>(y) * size.x *
+                             chain.channels],
+                pixels + y * stride,
+                static_cast<std::size_t>(size.x) * chain.channels);
+  }
+  chain.levels.push_back(std::move(base));
+
+  FloatImage current = Decode(size, chain.channels, pixels, stride,
+                              options_.srgb);
+  const float target_coverage =
+      preserve_coverage
+          ? AlphaCoverage(current, options_.alpha_cutoff, 1.0f)
+          : 0.0f;
+
+  for (int level = 1; level < level_count; level++) {
+    const glm::ivec2 next_size(std::max(1, current.size.x / 2),
+                               std::max(1, current.size.y / 2));
+    FloatImage next =
+        (options_.filter == MipFilter::KAISER)
+            ? DownsampleKaiser(current, next_size, options_.max_threads)
+            : DownsampleBox(current, next_size, options_.max_threads);
+
+    const float alpha_scale =
+        preserve_coverage
+            ? FindAlphaScale(next, options_.alpha_cutoff, target_coverage)
+            : 1.0f;
+    chain.levels.push_back(
+        Encode(next, chain.channels, options_.srgb, alpha_scale));
+    current = std::move(next);
+  }
+  return chain;
+}
+
+std::ostream& operator<<(std::ostream& os, const MipFilter filter) {
+  switch (filter) {
+    case MipFilter::BOX:
+      return os << "MipFilter::BOX";
+    case MipFilter::KAISER:
+      return os << "MipFilter::KAISER";
+  }
+  return os;
+}
+
+} /* namespace game_engine::_3D */
@@ -0,0 +1,141 @@
+/******************************************************************************
+ * MipmapGenerator.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_3D_MIPMAPGENERATOR_HPP_
+#define SRC_3D_MIPMAPGENERATOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace game_engine::_3D {
+
+/**
+ * @brief Reconstruction filter used when downsampling a mip level
+ */
+enum class MipFilter : std::uint8_t { BOX, KAISER };
+std::ostream& operator<<(std::ostream& os, const MipFilter filter);
+
+/**
+ * @brief Options controlling how a mip chain is generated
+ */
+struct MipmapOptions {
+  /**
+   * @brief Filter used to produce each level from the previous one
+   */
+  MipFilter filter = MipFilter::BOX;
+  /**
+   * @brief Treat the color channels as sRGB encoded and filter in linear space
+   */
+  bool srgb = false;
+  /**
+   * @brief Rescale alpha in each level so the fraction of texels passing
+   *        alpha_cutoff matches the base level
+   */
+  bool preserve_alpha_coverage = false;
+  float alpha_cutoff = 0.5f;
+  /**
+   * @brief Maximum number of worker threads.  0 uses every hardware thread.
+   */
+  unsigned int max_threads = 0;
+  /**
+   * @brief Maximum number of levels, the base level included.  0 generates
+   *        every level down to 1x1.
+   */
+  int max_levels = 0;
+};
+
+/**
+ * @brief A single level of a mip chain, tightly packed 8 bits per channel
+ */
+struct MipLevel {
+  glm::ivec2 size{0, 0};
+  std::vector<std::uint8_t> pixels{};
+
+  void swap(MipLevel& other) noexcept {
+    using std::swap;
+    swap(other.size, size);
+    swap(other.pixels, pixels);
+  }
+};
+
+inline void swap(MipLevel& a, MipLevel& b) noexcept { a.swap(b); }
+
+/**
+ * @brief A complete mip chain, level 0 first, ready to be uploaded level by
+ *        level
+ */
+struct MipChain {
+  int channels = 4;
+  std::vector<MipLevel> levels{};
+
+  void swap(MipChain& other) noexcept {
+    using std::swap;
+    swap(other.channels, channels);
+    swap(other.levels, levels);
+  }
+};
+
+inline void swap(MipChain& a, MipChain& b) noexcept { a.swap(b); }
+
+/**
+ * @brief Generates mip chains on the CPU
+ *
+ * Levels are filtered from the previous level in 32-bit float RGBA using SIMD
+ * kernels, with the rows of each level split across worker threads.  The
+ * generator has no dependency on a rendering API so it can also be used by
+ * offline asset tooling.
+ */
+class MipmapGenerator {
+ public:
+  MipmapGenerator() = default;
+  explicit MipmapGenerator(const MipmapOptions& options) : options_(options) {}
+
+  /**
+   * @brief Generate a mip chain down to 1x1, or to options.max_levels levels
+   * @param size Size of the base level
+   * @param channels Number of 8-bit channels per pixel (1 to 4)
+   * @param pixels Pixel data of the base level
+   * @param row_stride Bytes between the start of two rows.  0 means tightly
+   *                   packed.
+   * @return Returns the generated mip chain, including a copy of the base level
+   */
+  MipChain Generate(const glm::ivec2 size, const int channels,
+                    const std::uint8_t* pixels,
+                    const std::size_t row_stride = 0) const;
+
+  /**
+   * @brief Number of levels in a full mip chain for a given base size
+   */
+  static int LevelCount(const glm::ivec2 size);
+
+  const MipmapOptions& GetOptions() const { return options_; }
+  void SetOptions(const MipmapOptions& options) { options_ = options; }
+
+ protected:
+  MipmapOptions options_{};
+};
+
+} /* namespace game_engine::_3D */
+
+#endif /* SRC_3D_MIPMAPGENERATOR_HPP_ */
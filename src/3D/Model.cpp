@@ -32,6 +32,33 @@ namespace game_engine::_3D {
 
 std::vector<Texture> Model::textures_loaded_;
 
+const Aabb& Model::GetBounds() {
+  UpdateBounds();
+  return bounds_;
+}
+
+void Model::UpdateBounds() {
+  if (bounds_model_ == model_ && bounds_mesh_count_ == meshes_.size()) {
+    return;
+  }
+  cull_batch_.Clear();
+  cull_batch_.Reserve(meshes_.size());
+  bounds_ = Aabb{};
+  for (const auto& mesh : meshes_) {
+    const Aabb box = mesh.GetBounds().Transform(model_);
+    cull_batch_.Add(box);
+    bounds_.Expand(box);
+  }
+  bounds_model_ = model_;
+  bounds_mesh_count_ = meshes_.size();
+}
+
+void Model::SelectLod(const float screen_size) {
+  for (auto& mesh : meshes_) {
+    mesh.SelectLod(screen_size, lod_options_.hysteresis);
+  }
+}
+
 std::ostream& operator<<(std::ostream& os, Model m) {
   os << "Model {" << std::endl;
 
@@ -21,6 +21,7 @@
 #define SRC_3D_MODEL_HPP_
 
 #define GLM_ENABLE_EXPERIMENTAL
+#include <cstdint>
 #include <vector>
 
 #include <GL/glew.h>
@@ -31,7 +32,11 @@
 
 #include "LoggerV2/Log.hpp"
 
+#include "3D/BoundingVolume.hpp"
+#include "3D/Frustum.hpp"
 #include "3D/Mesh.hpp"
+#include "3D/MeshOptimizer.hpp"
+#include "3D/MeshSimplifier.hpp"
 #include "3D/Texture.hpp"
 #include "3D/Transformations.hpp"
 #include "Vertex.hpp"
@@ -51,7 +56,8 @@ class Model : public Transformations {
 
   template <typename Renderer>
   Model(Renderer& renderer, const cmrc::embedded_filesystem& fs,
-        const std::string& path, const bool gamma = false);
+        const std::string& path, const bool gamma = false,
+        const MeshLodOptions& lod_options = MeshLodOptions());
 
   template <typename Renderer>
   void LoadModel(Renderer& renderer, const cmrc::embedded_filesystem& fs,
@@ -61,7 +67,34 @@ class Model : public Transformations {
   void Draw(const Renderer& renderer,
             const ShaderPrograms shaders = ShaderPrograms::DEFAULT);
 
+  /**
+   * @brief Draw only the meshes whose world space bounds intersect a frustum
+   * @param frustum Frustum to cull against
+   * @param stats If not null, incremented with the meshes tested and drawn
+   */
+  template <typename Renderer>
+  void Draw(const Renderer& renderer, const ShaderPrograms shaders,
+            const Frustum& frustum, CullStats* stats = nullptr);
+
+  /**
+   * @brief World space box enclosing every mesh, transformed by model_
+   */
+  const Aabb& GetBounds();
+
+  /**
+   * @brief Pick the LOD of every mesh from the projected size of the model
+   * @param screen_size Projected size as a fraction of the screen height
+   */
+  void SelectLod(const float screen_size);
+  const MeshLodOptions& GetLodOptions() const { return lod_options_; }
+  const std::vector<Mesh>& GetMeshes() const { return meshes_; }
+
  protected:
+  /**
+   * @brief Rebuild the world space bounds if model_ or the meshes changed
+   */
+  void UpdateBounds();
+
   /*  Functions   */
   template <typename Renderer>
   void ProcessNode(Renderer& renderer, aiNode* node, const aiScene* scene);
@@ -83,6 +116,16 @@ class Model : public Transformations {
   std::string directory_{};
   std::string folder_{};
   bool gamma_correction_{};
+  /**
+   * @brief LODs generated for each mesh as it is loaded
+   */
+  MeshLodOptions lod_options_{};
+
+  FrustumCullBatch cull_batch_{};
+  std::vector<std::uint32_t> visible_meshes_{};
+  Aabb bounds_{};
+  glm::mat4 bounds_model_ = glm::mat4(0.0f);
+  std::size_t bounds_mesh_count_ = 0;
 
   friend class Cube;
   friend std::ostream& operator<<(std::ostream& os, Model m);
@@ -124,8 +124,9 @@ inline void ProcessVertexTangents(const aiMesh* mesh, Vertex* vertex,
 
 template <typename Renderer>
 Model::Model(Renderer& renderer, const cmrc::embedded_filesystem& fs,
-             const std::string& path, const bool gamma)
-    : gamma_correction_(gamma) {
+             const std::string& path, const bool gamma,
+             const MeshLodOptions& lod_options)
+    : gamma_correction_(gamma), lod_options_(lod_options) {
   LoadModel(renderer, fs, path);
 }
 
@@ -247,8 +248,18 @@ Mesh Model::ProcessMesh(Renderer& renderer, aiMesh* mesh,
       mode = Primitive::TRIANGLES;
       break;
   }
+  if (mode == Primitive::TRIANGLES && !indices.empty()) {
+    const auto [before, after] = MeshOptimizer::Optimize(&vertices, &indices);
+    log_.Debug("Optimized mesh {}: ACMR {} -> {}, ATVR {} -> {}",
+               mesh->mName.C_Str(), before.acmr, after.acmr, before.atvr,
+               after.atvr);
+  }
+
   // return a mesh object created from the extracted mesh data
   Mesh _mesh(vertices, indices, textures, mode);
+  if (lod_options_.enabled) {
+    _mesh.GenerateLods(lod_options_);
+  }
   _mesh.Init(renderer, ShaderPrograms::DEFAULT);
   //	mesh_.setupMesh(renderer);
   return _mesh;
@@ -300,6 +311,26 @@ void Model::Draw(const Renderer& renderer, const ShaderPrograms shaders) {
   }
 }
 
+template <typename Renderer>
+void Model::Draw(const Renderer& renderer, const ShaderPrograms shaders,
+                 const Frustum& frustum, CullStats* stats) {
+  UpdateBounds();
+  if (stats) {
+    stats->tested += meshes_.size();
+  }
+  // Reject the whole model before testing its meshes
+  if (!frustum.Intersects(bounds_)) {
+    return;
+  }
+  frustum.Cull(cull_batch_, &visible_meshes_);
+  if (stats) {
+    stats->visible += visible_meshes_.size();
+  }
+  for (const auto i : visible_meshes_) {
+    meshes_[i].Draw(renderer, shaders);
+  }
+}
+
 } /* namespace game_engine::_3D */
 
 #endif /* SRC_3D_MODEL_TPP_ */
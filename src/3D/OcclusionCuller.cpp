@@ -0,0 +1,435 @@
+/******************************************************************************
+ * OcclusionCuller.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/OcclusionCuller.hpp"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include "Util/CpuFeatures.hpp"
+#include "Util/ParallelFor.hpp"
+
+namespace game_engine::_3D {
+
+namespace {
+
+constexpr int kMinRowsPerThread = 8;
+/**
+ * @brief Largest screen rectangle, in texels of the chosen level, tested
+ *        against the pyramid along each axis
+ */
+constexpr int kMaxTestTexels = 4;
+
+/**
+ * @brief Corners of a box, indexed by bit 0 = x, bit 1 = y, bit 2 = z
+ */
+std::array<glm::vec3, 8> Corners(const Aabb& box) {
+  std::array<glm::vec3, 8> corners{};
+  for (int i = 0; i < 8; i++) {
+    corners[i] = glm::vec3((i & 1) ? box.max.x : box.min.x,
+                           (i & 2) ? box.max.y : box.min.y,
+                           (i & 4) ? box.max.z : box.min.z);
+  }
+  return corners;
+}
+
+/**
+ * @brief Counter-clockwise, outward facing triangles of a box built from
+ *        Corners
+ */
+constexpr std::array<std::uint32_t, 36> kBoxIndices = {
+    0, 4, 6, 0, 6, 2, 1, 3, 7, 1, 7, 5, 0, 1, 5, 0, 5, 4,
+    2, 6, 7, 2, 7, 3, 0, 2, 3, 0, 3, 1, 4, 5, 7, 4, 7, 6};
+
+/**
+ * @brief Edge function E(x, y) = a * x + b * y + c, positive inside a
+ *        counter-clockwise triangle
+ */
+struct Edge {
+  float a;
+  float b;
+  float c;
+
+  Edge(const glm::vec3& from, const glm::vec3& to)
+      : a(from.y - to.y),
+        b(to.x - from.x),
+        c(-(a * from.x + b * from.y)) {}
+};
+
+#if defined(__SSE2__)
+/**
+ * @brief Rasterize a span of a row eight pixels at a time.  Built for AVX2
+ *        whatever the build flags, so it may only be called if
+ *        util::HasAvx2().
+ * @param a Slope along x of each edge function
+ * @param r Value of each edge function at x = 0 on this row
+ * @return Returns the first pixel left for the scalar loop
+ */
+__attribute__((target("avx2"))) int RasterizeSpanAvx2(
+    float* row, const int x0, const int x1, const std::array<float, 3>& a,
+    const std::array<float, 3>& r, const float za, const float rz) {
+  const __m256 lane =
+      _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.0f);
+  int x = x0 & ~7;
+  for (; x <= x1; x += 8) {
+    const __m256 px =
+        _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), lane);
+    const __m256 w0 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(a[0]), px),
+                                    _mm256_set1_ps(r[0]));
+    const __m256 w1 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(a[1]), px),
+                                    _mm256_set1_ps(r[1]));
+    const __m256 w2 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(a[2]), px),
+                                    _mm256_set1_ps(r[2]));
+    const __m256 inside =
+        _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(w0, zero, _CMP_GE_OQ),
+                                    _mm256_cmp_ps(w1, zero, _CMP_GE_OQ)),
+                      _mm256_cmp_ps(w2, zero, _CMP_GE_OQ));
+    if (_mm256_movemask_ps(inside) == 0) {
+      continue;
+    }
+    __m256 z = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(za), px),
+                             _mm256_set1_ps(rz));
+    z = _mm256_max_ps(zero, _mm256_min_ps(one, z));
+    const __m256 old = _mm256_loadu_ps(row + x);
+    const __m256 nearer = _mm256_min_ps(old, z);
+    _mm256_storeu_ps(row + x, _mm256_blendv_ps(old, nearer, inside));
+  }
+  return x;
+}
+#endif
+
+}  // namespace
+
+OcclusionCuller::OcclusionCuller(const OcclusionCullerOptions& options)
+    : options_(options) {
+  size_.x = std::max(8, (options_.resolution.x + 7) / 8 * 8);
+  size_.y = std::max(1, options_.resolution.y);
+  glm::ivec2 size = size_;
+  for (;;) {
+    levels_.push_back(Level{
+        size, std::vector<float>(static_cast<std::size_t>(size.x) * size.y,
+                                 1.0f)});
+    if (size.x == 1 && size.y == 1) {
+      break;
+    }
+    size = glm::ivec2(std::max(1, (size.x + 1) / 2),
+                      std::max(1, (size.y + 1) / 2));
+  }
+}
+
+OcclusionCuller::~OcclusionCuller() { Wait(); }
+
+void OcclusionCuller::BeginFrame(const glm::mat4& view_projection) {
+  Wait();
+  view_projection_ = view_projection;
+  triangles_.clear();
+}
+
+void OcclusionCuller::AddOccluder(const std::vector<glm::vec3>& positions,
+                                  const std::vector<std::uint32_t>& indices,
+                                  const glm::mat4& model) {
+  Wait();
+  const glm::mat4 model_view_projection = view_projection_ * model;
+  clip_positions_.resize(positions.size());
+  for (std::size_t i = 0; i < positions.size(); i++) {
+    clip_positions_[i] = model_view_projection * glm::vec4(positions[i], 1.0f);
+  }
+  for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+    ClipAndAdd(clip_positions_[indices[i]], clip_positions_[indices[i + 1]],
+               clip_positions_[indices[i + 2]]);
+  }
+}
+
+void OcclusionCuller::AddOccluder(const Aabb& box) {
+  if (box.IsEmpty()) {
+    return;
+  }
+  const auto corners = Corners(box);
+  const std::vector<glm::vec3> positions(corners.begin(), corners.end());
+  const std::vector<std::uint32_t> indices(kBoxIndices.begin(),
+                                           kBoxIndices.end());
+  AddOccluder(positions, indices);
+}
+
+void OcclusionCuller::ClipAndAdd(const glm::vec4& a, const glm::vec4& b,
+                                 const glm::vec4& c) {
+  // Clip against the near plane, z + w >= 0.  Far and side planes are handled
+  // by clamping while rasterizing.
+  const std::array<glm::vec4, 3> in = {a, b, c};
+  std::array<glm::vec4, 4> out{};
+  int count = 0;
+  for (int i = 0; i < 3; i++) {
+    const glm::vec4& p = in[i];
+    const glm::vec4& q = in[(i + 1) % 3];
+    const float dp = p.z + p.w;
+    const float dq = q.z + q.w;
+    if (dp >= 0.0f) {
+      out[count++] = p;
+    }
+    if ((dp >= 0.0f) != (dq >= 0.0f)) {
+      const float t = dp / (dp - dq);
+      out[count++] = p + (q - p) * t;
+    }
+  }
+  for (int i = 2; i < count; i++) {
+    AddScreenTriangle(out[0], out[i - 1], out[i]);
+  }
+}
+
+void OcclusionCuller::AddScreenTriangle(const glm::vec4& a, const glm::vec4& b,
+                                        const glm::vec4& c) {
+  const glm::vec2 scale(static_cast<float>(size_.x) * 0.5f,
+                        static_cast<float>(size_.y) * 0.5f);
+  const auto to_screen = [&scale](const glm::vec4& p) {
+    const float inverse_w = 1.0f / p.w;
+    return glm::vec3((p.x * inverse_w + 1.0f) * scale.x,
+                     (p.y * inverse_w + 1.0f) * scale.y,
+                     p.z * inverse_w * 0.5f + 0.5f);
+  };
+  Triangle triangle{to_screen(a), to_screen(b), to_screen(c)};
+  const float area =
+      (triangle.v1.x - triangle.v0.x) * (triangle.v2.y - triangle.v0.y) -
+      (triangle.v1.y - triangle.v0.y) * (triangle.v2.x - triangle.v0.x);
+  if (!(area > 0.0f) && (options_.cull_back_faces || !(area < 0.0f))) {
+    return;
+  }
+  if (area < 0.0f) {
+    std::swap(triangle.v1, triangle.v2);
+  }
+  const float min_x = std::min({triangle.v0.x, triangle.v1.x, triangle.v2.x});
+  const float max_x = std::max({triangle.v0.x, triangle.v1.x, triangle.v2.x});
+  const float min_y = std::min({triangle.v0.y, triangle.v1.y, triangle.v2.y});
+  const float max_y = std::max({triangle.v0.y, triangle.v1.y, triangle.v2.y});
+  if (max_x < 0.0f || max_y < 0.0f || min_x >= static_cast<float>(size_.x) ||
+      min_y >= static_cast<float>(size_.y)) {
+    return;
+  }
+  triangles_.push_back(triangle);
+}
+
+void OcclusionCuller::Rasterize() {
+  auto& depth = levels_[0].depth;
+  std::fill(depth.begin(), depth.end(), 1.0f);
+  util::ParallelFor(size_.y, options_.max_threads, kMinRowsPerThread,
+                    [this](const int begin, const int end) {
+                      RasterizeRows(begin, end);
+                    });
+  BuildPyramid();
+}
+
+void OcclusionCuller::RasterizeAsync() {
+  Wait();
+  job_ = std::async(std::launch::async, [this]() { Rasterize(); });
+}
+
+void OcclusionCuller::Wait() const {
+  if (job_.valid()) {
+    job_.get();
+  }
+}
+
+void OcclusionCuller::RasterizeRows(const int begin, const int end) {
+  float* depth = levels_[0].depth.data();
+#if defined(__SSE2__)
+  const bool has_avx2 = util::HasAvx2();
+#endif
+  for (const auto& t : triangles_) {
+    // Pixels whose centers may lie inside the triangle
+    const int x0 = std::max(
+        0, static_cast<int>(std::floor(std::min({t.v0.x, t.v1.x, t.v2.x}))));
+    const int x1 = std::min(
+        size_.x - 1,
+        static_cast<int>(std::floor(std::max({t.v0.x, t.v1.x, t.v2.x}))));
+    const int y0 = std::max(
+        begin,
+        static_cast<int>(std::floor(std::min({t.v0.y, t.v1.y, t.v2.y}))));
+    const int y1 = std::min(
+        end - 1,
+        static_cast<int>(std::floor(std::max({t.v0.y, t.v1.y, t.v2.y}))));
+    if (x0 > x1 || y0 > y1) {
+      continue;
+    }
+
+    const Edge e0(t.v1, t.v2);
+    const Edge e1(t.v2, t.v0);
+    const Edge e2(t.v0, t.v1);
+    // Depth is affine in screen space: interpolate it with the barycentric
+    // weights E_i / (E_0 + E_1 + E_2).  The sum is twice the area and, as the
+    // x and y terms cancel out, equal to the sum of the constants.
+    const float inverse_area = 1.0f / (e0.c + e1.c + e2.c);
+    const float za =
+        (e0.a * t.v0.z + e1.a * t.v1.z + e2.a * t.v2.z) * inverse_area;
+    const float zb =
+        (e0.b * t.v0.z + e1.b * t.v1.z + e2.b * t.v2.z) * inverse_area;
+    const float zc =
+        (e0.c * t.v0.z + e1.c * t.v1.z + e2.c * t.v2.z) * inverse_area;
+
+    for (int y = y0; y <= y1; y++) {
+      const float py = static_cast<float>(y) + 0.5f;
+      float* row = depth + static_cast<std::size_t>(y) * size_.x;
+      // Row constant parts of each function
+      const float r0 = e0.b * py + e0.c;
+      const float r1 = e1.b * py + e1.c;
+      const float r2 = e2.b * py + e2.c;
+      const float rz = zb * py + zc;
+      int x = x0;
+#if defined(__SSE2__)
+      if (has_avx2) {
+        x = RasterizeSpanAvx2(row, x0, x1, {e0.a, e1.a, e2.a}, {r0, r1, r2},
+                              za, rz);
+      } else {
+        const __m128 lane = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        for (x = x0 & ~3; x <= x1; x += 4) {
+          const __m128 px =
+              _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lane);
+          const __m128 w0 =
+              _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e0.a), px), _mm_set1_ps(r0));
+          const __m128 w1 =
+              _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e1.a), px), _mm_set1_ps(r1));
+          const __m128 w2 =
+              _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e2.a), px), _mm_set1_ps(r2));
+          const __m128 inside =
+              _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(w0, zero),
+                                    _mm_cmpge_ps(w1, zero)),
+                         _mm_cmpge_ps(w2, zero));
+          if (_mm_movemask_ps(inside) == 0) {
+            continue;
+          }
+          __m128 z =
+              _mm_add_ps(_mm_mul_ps(_mm_set1_ps(za), px), _mm_set1_ps(rz));
+          z = _mm_max_ps(zero, _mm_min_ps(one, z));
+          const __m128 old = _mm_loadu_ps(row + x);
+          const __m128 nearer = _mm_min_ps(old, z);
+          _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer),
+                                           _mm_andnot_ps(inside, old)));
+        }
+      }
+#endif
+      for (; x <= x1; x++) {
+        const float px = static_cast<float>(x) + 0.5f;
+        if (e0.a * px + r0 >= 0.0f && e1.a * px + r1 >= 0.0f &&
+            e2.a * px + r2 >= 0.0f) {
+          const float z = std::clamp(za * px + rz, 0.0f, 1.0f);
+          row[x] = std::min(row[x], z);
+        }
+      }
+    }
+  }
+}
+
+void OcclusionCuller::BuildPyramid() {
+  for (std::size_t i = 1; i < levels_.size(); i++) {
+    const Level& src = levels_[i - 1];
+    Level& dst = levels_[i];
+    for (int y = 0; y < dst.size.y; y++) {
+      const int sy0 = 2 * y;
+      const int sy1 = std::min(2 * y + 1, src.size.y - 1);
+      for (int x = 0; x < dst.size.x; x++) {
+        const int sx0 = 2 * x;
+        const int sx1 = std::min(2 * x + 1, src.size.x - 1);
+        dst.depth[y * dst.size.x + x] =
+            std::max({src.depth[sy0 * src.size.x + sx0],
+                      src.depth[sy0 * src.size.x + sx1],
+                      src.depth[sy1 * src.size.x + sx0],
+                      src.depth[sy1 * src.size.x + sx1]});
+      }
+    }
+  }
+}
+
+bool OcclusionCuller::IsVisible(const Aabb& box) const {
+  Wait();
+  if (box.IsEmpty()) {
+    return false;
+  }
+  glm::vec2 min_screen(std::numeric_limits<float>::max());
+  glm::vec2 max_screen(std::numeric_limits<float>::lowest());
+  float nearest = 1.0f;
+  for (const auto& corner : Corners(box)) {
+    const glm::vec4 clip = view_projection_ * glm::vec4(corner, 1.0f);
+    if (clip.z < -clip.w || clip.w <= 0.0f) {
+      // Crosses the near plane, too close to tell
+      return true;
+    }
+    const float inverse_w = 1.0f / clip.w;
+    const glm::vec2 screen(
+        (clip.x * inverse_w + 1.0f) * 0.5f * static_cast<float>(size_.x),
+        (clip.y * inverse_w + 1.0f) * 0.5f * static_cast<float>(size_.y));
+    min_screen = glm::min(min_screen, screen);
+    max_screen = glm::max(max_screen, screen);
+    nearest = std::min(nearest, clip.z * inverse_w * 0.5f + 0.5f);
+  }
+  if (max_screen.x < 0.0f || max_screen.y < 0.0f ||
+      min_screen.x >= static_cast<float>(size_.x) ||
+      min_screen.y >= static_cast<float>(size_.y)) {
+    return false;
+  }
+  int x0 = std::max(0, static_cast<int>(std::floor(min_screen.x)));
+  int y0 = std::max(0, static_cast<int>(std::floor(min_screen.y)));
+  int x1 = std::min(size_.x - 1, static_cast<int>(std::floor(max_screen.x)));
+  int y1 = std::min(size_.y - 1, static_cast<int>(std::floor(max_screen.y)));
+
+  // Pick the finest level where the rectangle covers only a few texels
+  std::size_t level = 0;
+  while (level + 1 < levels_.size() &&
+         ((x1 - x0) >= kMaxTestTexels || (y1 - y0) >= kMaxTestTexels)) {
+    x0 >>= 1;
+    y0 >>= 1;
+    x1 >>= 1;
+    y1 >>= 1;
+    level++;
+  }
+  const Level& hi_z = levels_[level];
+  for (int y = y0; y <= y1; y++) {
+    for (int x = x0; x <= x1; x++) {
+      if (hi_z.depth[y * hi_z.size.x + x] >= nearest) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void OcclusionCuller::Cull(const std::vector<Aabb>& boxes,
+                           std::vector<std::uint32_t>* visible) const {
+  visible->clear();
+  for (std::size_t i = 0; i < boxes.size(); i++) {
+    if (IsVisible(boxes[i])) {
+      visible->push_back(static_cast<std::uint32_t>(i));
+    }
+  }
+}
+
+const std::vector<float>& OcclusionCuller::GetDepth() const {
+  Wait();
+  return levels_[0].depth;
+}
+
+} /* namespace game_engine::_3D */
@@ -0,0 +1,157 @@
+/******************************************************************************
+ * OcclusionCuller.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_3D_OCCLUSIONCULLER_HPP_
+#define SRC_3D_OCCLUSIONCULLER_HPP_
+
+#include <cstdint>
+#include <future>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "3D/BoundingVolume.hpp"
+
+namespace game_engine::_3D {
+
+/**
+ * @brief Options controlling the software depth buffer
+ */
+struct OcclusionCullerOptions {
+  /**
+   * @brief Size of the depth buffer.  The width is rounded up to a multiple
+   *        of 8.
+   */
+  glm::ivec2 resolution{256, 128};
+  /**
+   * @brief Skip occluder triangles facing away from the camera
+   */
+  bool cull_back_faces = true;
+  /**
+   * @brief Maximum number of rasterizer threads.  0 uses every hardware
+   *        thread.
+   */
+  unsigned int max_threads = 0;
+};
+
+/**
+ * @brief Software hierarchical-Z occlusion culler
+ *
+ * Each frame a small set of occluders (low poly proxies, chunk hulls, ...) is
+ * rasterized into a low resolution depth buffer, which is then reduced into a
+ * pyramid holding the farthest depth of each block.  A candidate box is
+ * occluded if its nearest depth lies behind every texel of the pyramid level
+ * its screen rectangle covers.
+ *
+ * The rasterizer splits the buffer into bands of rows handled by worker
+ * threads and uses SIMD for the inner loop.  Depth is combined with min, so
+ * the result does not depend on thread count or scheduling and can be tested
+ * deterministically.  Rasterization can run asynchronously while the
+ * simulation updates; tests wait for it to finish.
+ */
+class OcclusionCuller {
+ public:
+  OcclusionCuller() : OcclusionCuller(OcclusionCullerOptions{}) {}
+  explicit OcclusionCuller(const OcclusionCullerOptions& options);
+  OcclusionCuller(const OcclusionCuller&) = delete;
+  OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+  ~OcclusionCuller();
+
+  /**
+   * @brief Start a new frame, dropping the occluders of the previous one
+   * @param view_projection Matrix mapping world space to clip space
+   */
+  void BeginFrame(const glm::mat4& view_projection);
+  /**
+   * @brief Queue an indexed triangle mesh as an occluder
+   * @param positions Vertex positions in model space
+   * @param indices Three indices per triangle
+   * @param model Matrix mapping the positions to world space
+   */
+  void AddOccluder(const std::vector<glm::vec3>& positions,
+                   const std::vector<std::uint32_t>& indices,
+                   const glm::mat4& model = glm::mat4(1.0f));
+  /**
+   * @brief Queue a box as an occluder, e.g. the solid interior of a chunk
+   */
+  void AddOccluder(const Aabb& box);
+
+  /**
+   * @brief Rasterize the queued occluders and build the pyramid
+   */
+  void Rasterize();
+  /**
+   * @brief Run Rasterize on a worker thread.  Tests wait for it.
+   */
+  void RasterizeAsync();
+  /**
+   * @brief Block until an asynchronous Rasterize has finished
+   */
+  void Wait() const;
+
+  /**
+   * @brief Test a world space box against the occluders
+   * @return Returns false only if the box is certainly hidden
+   */
+  bool IsVisible(const Aabb& box) const;
+  /**
+   * @brief Test many boxes
+   * @param visible Cleared and filled with the indices of the visible boxes
+   */
+  void Cull(const std::vector<Aabb>& boxes,
+            std::vector<std::uint32_t>* visible) const;
+
+  glm::ivec2 GetResolution() const { return size_; }
+  /**
+   * @brief Depth buffer, row major from the bottom row, 0 at the near plane
+   *        and 1 at the far plane
+   */
+  const std::vector<float>& GetDepth() const;
+  int GetLevelCount() const { return static_cast<int>(levels_.size()); }
+
+ protected:
+  struct Triangle {
+    glm::vec3 v0;
+    glm::vec3 v1;
+    glm::vec3 v2;
+  };
+  struct Level {
+    glm::ivec2 size{0, 0};
+    std::vector<float> depth{};
+  };
+
+  void ClipAndAdd(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+  void AddScreenTriangle(const glm::vec4& a, const glm::vec4& b,
+                         const glm::vec4& c);
+  void RasterizeRows(const int begin, const int end);
+  void BuildPyramid();
+
+  OcclusionCullerOptions options_{};
+  glm::ivec2 size_{0, 0};
+  glm::mat4 view_projection_ = glm::mat4(1.0f);
+  std::vector<glm::vec4> clip_positions_{};
+  std::vector<Triangle> triangles_{};
+  std::vector<Level> levels_{};
+  mutable std::future<void> job_{};
+};
+
+} /* namespace game_engine::_3D */
+
+#endif /* SRC_3D_OCCLUSIONCULLER_HPP_ */
@@ -20,6 +20,8 @@
 #ifndef SRC_3D_PIXELFORMAT_HPP_
 #define SRC_3D_PIXELFORMAT_HPP_
 
+#include <cstdint>
+
 namespace game_engine::_3D {
 
 using InternalFormat = int;
@@ -30,6 +32,11 @@ struct PixelFormat {
   Format e_format;
 };
 
+/**
+ * @brief What sampling outside of the [0, 1] texture coordinate range reads
+ */
+enum class TextureWrap : std::uint8_t { CLAMP, REPEAT };
+
 } /* namespace game_engine::_3D */
 
 #endif /* SRC_3D_PIXELFORMAT_HPP_ */
@@ -0,0 +1,79 @@
+/******************************************************************************
+ * RenderTarget.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_3D_RENDERTARGET_HPP_
+#define SRC_3D_RENDERTARGET_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "3D/PixelFormat.hpp"
+
+namespace game_engine::_3D {
+
+/**
+ * @brief Description of an offscreen render target
+ */
+struct RenderTargetDesc {
+  glm::ivec2 size{0, 0};
+  /**
+   * @brief Format of the color attachment
+   */
+  PixelFormat color_format{};
+  /**
+   * @brief Give the target a depth and stencil attachment
+   */
+  bool depth = true;
+  /**
+   * @brief Samples per pixel.  Above 1 the target is multisampled and
+   *        resolved into a single sampled texture before being sampled or
+   *        read back.
+   */
+  int samples = 1;
+};
+
+/**
+ * @brief Pixels read back from a render target, 8-bit RGBA with the top row
+ *        first
+ */
+struct ReadbackResult {
+  glm::ivec2 size{0, 0};
+  std::vector<std::uint8_t> pixels{};
+};
+
+/**
+ * @brief Called once the pixels of an asynchronous readback are available
+ */
+using ReadbackCallback = std::function<void(const ReadbackResult&)>;
+
+inline std::ostream& operator<<(std::ostream& os, const RenderTargetDesc& d) {
+  return os << "RenderTargetDesc {\n"
+            << "glm::ivec2 size = " << d.size << "\n"
+            << "bool depth = " << d.depth << "\n"
+            << "int samples = " << d.samples << "\n"
+            << "}";
+}
+
+} /* namespace game_engine::_3D */
+
+#endif /* SRC_3D_RENDERTARGET_HPP_ */
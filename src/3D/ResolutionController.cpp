@@ -0,0 +1,126 @@
+/******************************************************************************
+ * ResolutionController.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/ResolutionController.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace game_engine::_3D {
+
+namespace {
+
+/**
+ * @brief Largest change of the scene area in one update, as a fraction of
+ *        the window's
+ */
+constexpr double kMaxAreaChange = 0.25;
+
+}  // namespace
+
+std::ostream& operator<<(std::ostream& os, const UpscaleFilter filter) {
+  switch (filter) {
+    case UpscaleFilter::BILINEAR:
+      return os << "UpscaleFilter::BILINEAR";
+    case UpscaleFilter::SHARPEN:
+      return os << "UpscaleFilter::SHARPEN";
+  }
+  return os;
+}
+
+float ResolutionController::Update(const double cpu_ms, const double gpu_ms) {
+  if (hold_frames_ > 0) {
+    hold_frames_--;
+    return GetScale();
+  }
+  const double measured = gpu_ms >= 0.0 ? gpu_ms : cpu_ms;
+  if (filtered_ms_ < 0.0) {
+    filtered_ms_ = measured;
+  } else {
+    filtered_ms_ += options_.smoothing * (measured - filtered_ms_);
+  }
+
+  /*  Positive when there is time to spare.  Far over budget the frame is
+   *  simply too slow, and letting the error shrink as the scene does would
+   *  read as the scale overshooting.  */
+  double error = std::clamp(
+      (options_.target_ms - filtered_ms_) / std::max(options_.target_ms, 1e-3),
+      -1.0, 1.0);
+  if (error > 0.0 && error < options_.tolerance) {
+    error = 0.0;
+  }
+  /*  Each update changes the area rather than setting it, so clamping the
+   *  area is all the anti-windup needed  */
+  const double delta =
+      options_.kp * (error - previous_error_) + options_.ki * error +
+      options_.kd * (error - 2.0 * previous_error_ + older_error_);
+  older_error_ = previous_error_;
+  previous_error_ = error;
+
+  const double min_area =
+      static_cast<double>(options_.min_scale) * options_.min_scale;
+  const double max_area =
+      static_cast<double>(options_.max_scale) * options_.max_scale;
+  const double area =
+      std::clamp(static_cast<double>(scale_) * scale_ +
+                     std::clamp(delta, -kMaxAreaChange, kMaxAreaChange),
+                 min_area, max_area);
+  scale_ = static_cast<float>(std::sqrt(area));
+
+  const bool bound = scale_ <= options_.min_scale ||
+                     scale_ >= options_.max_scale;
+  if (std::abs(scale_ - level_) >= options_.step || bound) {
+    float level = scale_;
+    if (options_.step > 0.0f) {
+      level = std::round(level / options_.step) * options_.step;
+    }
+    level = std::clamp(level, options_.min_scale, options_.max_scale);
+    if (level != level_) {
+      level_ = level;
+      // Restart the average from the first time measured at the new scale
+      hold_frames_ = std::max(options_.latency_frames, 0);
+      filtered_ms_ = -1.0;
+    }
+  }
+  return GetScale();
+}
+
+float ResolutionController::GetScale() const {
+  return options_.enabled ? level_ : 1.0f;
+}
+
+glm::ivec2 ResolutionController::ScaledSize(const glm::ivec2 size) const {
+  const float scale = GetScale();
+  return glm::max(
+      glm::ivec2(static_cast<int>(std::lround(size.x * scale)),
+                 static_cast<int>(std::lround(size.y * scale))),
+      glm::ivec2(1));
+}
+
+void ResolutionController::Reset() {
+  scale_ = options_.max_scale;
+  level_ = options_.max_scale;
+  filtered_ms_ = -1.0;
+  previous_error_ = 0.0;
+  older_error_ = 0.0;
+  hold_frames_ = 0;
+}
+
+} /* namespace game_engine::_3D */
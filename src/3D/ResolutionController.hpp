@@ -0,0 +1,154 @@
+/******************************************************************************
+ * ResolutionController.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_3D_RESOLUTIONCONTROLLER_HPP_
+#define SRC_3D_RESOLUTIONCONTROLLER_HPP_
+
+#include <cstdint>
+#include <ostream>
+
+#include <glm/glm.hpp>
+
+namespace game_engine::_3D {
+
+/**
+ * @brief Filter used to stretch the scaled scene over the window
+ */
+enum class UpscaleFilter : std::uint8_t { BILINEAR, SHARPEN };
+std::ostream& operator<<(std::ostream& os, const UpscaleFilter filter);
+
+/**
+ * @brief Options controlling dynamic resolution
+ */
+struct DynamicResolutionOptions {
+  bool enabled = false;
+  /**
+   * @brief Frame time to hold, a little under the refresh interval so
+   *        spikes do not miss vsync
+   */
+  double target_ms = 15.0;
+  /**
+   * @brief Bounds of the scale applied to both axes of the scene
+   */
+  float min_scale = 0.5f;
+  float max_scale = 1.0f;
+  /**
+   * @brief Gains of the controller, applied to the frame time error as a
+   *        fraction of target_ms to give the scene area as a fraction of
+   *        the window's
+   */
+  float kp = 0.1f;
+  float ki = 0.05f;
+  float kd = 0.02f;
+  /**
+   * @brief Weight of the newest measurement in the running average the
+   *        controller acts on
+   */
+  float smoothing = 0.25f;
+  /**
+   * @brief Granularity of the scale, so small corrections do not change the
+   *        image every frame
+   */
+  float step = 0.05f;
+  /**
+   * @brief Fraction of target_ms a frame may finish early without the scale
+   *        growing.  Neighbouring steps differ by up to a fifth in cost, so
+   *        anything smaller leaves no step to settle on and the scale keeps
+   *        toggling between the two around the target.
+   */
+  float tolerance = 0.2f;
+  /**
+   * @brief Frames between drawing a frame and its time reaching Update, as
+   *        GPU timer queries are read back frames late.  The scale is held
+   *        this long after each change so the controller never acts on
+   *        times of frames drawn at the old scale.
+   */
+  int latency_frames = 3;
+  UpscaleFilter filter = UpscaleFilter::BILINEAR;
+  /**
+   * @brief Strength of UpscaleFilter::SHARPEN, from 0 to 1
+   */
+  float sharpness = 0.5f;
+};
+
+/**
+ * @brief Chooses the render scale of the scene from measured frame times
+ *
+ * A PID controller, in incremental form, drives the frame time towards
+ * target_ms.  The cost of a frame grows with the number of pixels, so the
+ * controller's output is the area of the scene rather than its width.  GPU
+ * time is used when the backend can measure it, since shrinking the scene
+ * does not help a frame bound by the CPU, and CPU time otherwise.
+ */
+class ResolutionController {
+ public:
+  ResolutionController() = default;
+  explicit ResolutionController(const DynamicResolutionOptions& options)
+      : options_(options),
+        scale_(options.max_scale),
+        level_(options.max_scale) {}
+
+  /**
+   * @brief Feed the times of the last frame
+   * @param cpu_ms CPU time of the frame
+   * @param gpu_ms GPU time of the frame, negative if unknown
+   * @return Returns the scale of the next frame
+   */
+  float Update(const double cpu_ms, const double gpu_ms);
+  /**
+   * @brief Scale of the next frame, a multiple of options.step
+   */
+  float GetScale() const;
+  /**
+   * @brief Size of the scene for a given window size
+   */
+  glm::ivec2 ScaledSize(const glm::ivec2 size) const;
+  /**
+   * @brief Return to full scale and forget past measurements
+   */
+  void Reset();
+
+  bool IsEnabled() const { return options_.enabled; }
+  const DynamicResolutionOptions& GetOptions() const { return options_; }
+  void SetOptions(const DynamicResolutionOptions& options) {
+    options_ = options;
+    Reset();
+  }
+
+ protected:
+  DynamicResolutionOptions options_{};
+  float scale_ = 1.0f;
+  /**
+   * @brief Scale drawn at, which only follows scale_ once it is a whole step
+   *        away.  Rounding alone lets the controller's response to each
+   *        change carry it straight back over the rounding threshold.
+   */
+  float level_ = 1.0f;
+  double filtered_ms_ = -1.0;
+  double previous_error_ = 0.0;
+  double older_error_ = 0.0;
+  /**
+   * @brief Updates left before the measurements reflect the current scale
+   */
+  int hold_frames_ = 0;
+};
+
+} /* namespace game_engine::_3D */
+
+#endif /* SRC_3D_RESOLUTIONCONTROLLER_HPP_ */
@@ -0,0 +1,127 @@
+/******************************************************************************
+ * Scene.cpp
+ * Copyright (C) 2019  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/Scene.hpp"
+
+
+namespace game_engine::_3D {
+
+Scene::ObjectId Scene::Add(Model model) {
+  ObjectId id = 0;
+  if (free_objects_.empty()) {
+    id = static_cast<ObjectId>(objects_.size());
+    objects_.emplace_back();
+  } else {
+    id = free_objects_.back();
+    free_objects_.pop_back();
+  }
+  Object& object = objects_[id];
+  object.model = std::move(model);
+  object.bounds = object.model.GetBounds();
+  object.version = object.model.GetVersion();
+  object.proxy = tree_.CreateProxy(object.bounds, id);
+  return id;
+}
+
+std::size_t Scene::StaticSize() const {
+  std::size_t meshes = static_instances_;
+  for (const Model& model : pending_static_) {
+    meshes += model.GetMeshes().size();
+  }
+  return meshes;
+}
+
+void Scene::Remove(const ObjectId id) {
+  Object& object = objects_[id];
+  tree_.DestroyProxy(object.proxy);
+  object = Object{};
+  free_objects_.push_back(id);
+}
+
+Model& Scene::GetModel(const ObjectId id) {
+  Object& object = objects_[id];
+  if (!object.dirty) {
+    object.dirty = true;
+    dirty_objects_.push_back(id);
+  }
+  return object.model;
+}
+
+std::size_t Scene::Update() {
+  std::size_t reinserted = 0;
+  for (const ObjectId id : dirty_objects_) {
+    // Removed objects, and objects removed and added again since they were
+    // queued, are no longer marked
+    Object& object = objects_[id];
+    if (!object.dirty) {
+      continue;
+    }
+    object.dirty = false;
+    if (object.proxy == AabbTree::kNullProxy ||
+        object.version == object.model.GetVersion()) {
+      continue;
+    }
+    const Aabb bounds = object.model.GetBounds();
+    const glm::vec3 displacement = bounds.Center() - object.bounds.Center();
+    object.bounds = bounds;
+    object.version = object.model.GetVersion();
+    if (tree_.MoveProxy(object.proxy, bounds, displacement)) {
+      reinserted++;
+    }
+  }
+  dirty_objects_.clear();
+  return reinserted;
+}
+
+std::optional<Scene::ObjectId> Scene::RayCast(const Ray& ray,
+                                              float* distance) const {
+  const glm::vec3 inverse_direction = 1.0f / ray.direction;
+  std::optional<ObjectId> hit{};
+  float hit_distance = ray.max_distance;
+  tree_.RayCast(ray, [&](const AabbTree::ProxyId proxy, const Ray& clipped) {
+    const ObjectId id = tree_.GetUserData(proxy);
+    float t = 0.0f;
+    if (!clipped.Intersects(objects_[id].bounds, inverse_direction, &t)) {
+      return clipped.max_distance;
+    }
+    hit = id;
+    hit_distance = t;
+    return t;
+  });
+  if (hit && distance) {
+    *distance = hit_distance;
+  }
+  return hit;
+}
+
+std::optional<Scene::ObjectId> Scene::Nearest(const glm::vec3 point,
+                                              const float max_distance) const {
+  const auto proxy = tree_.Nearest(
+      point, max_distance, [this, point](const AabbTree::ProxyId proxy) {
+        return objects_[tree_.GetUserData(proxy)].bounds.DistanceSquared(
+            point);
+      });
+  if (!proxy) {
+    return std::nullopt;
+  }
+  return tree_.GetUserData(*proxy);
+}
+
+} /* namespace game_engine::_3D */
@@ -20,24 +20,190 @@
 #ifndef SRC_3D_SCENE_HPP_
 #define SRC_3D_SCENE_HPP_
 
+#include <cstdint>
+#include <optional>
+#include <utility>
 #include <vector>
 
+#include "3D/AabbTree.hpp"
+#include "3D/BoundingVolume.hpp"
 #include "3D/Camera.hpp"
+#include "3D/Frustum.hpp"
+#include "3D/Light.hpp"
+#include "3D/LightClusterer.hpp"
 #include "3D/Mesh.hpp"
 #include "3D/Model.hpp"
+#include "3D/OcclusionCuller.hpp"
 
 namespace game_engine::_3D {
 
+/**
+ * @brief Container for the models of a scene
+ *
+ * Every model is a proxy in an AabbTree keyed by its world space bounds, so
+ * drawing, picking and proximity queries only visit the objects near the
+ * query instead of scanning the whole scene.  Models fetched for writing
+ * with GetModel are queued for a refit, which Update performs and Draw runs
+ * itself, so only the models that may have moved are visited.
+ */
 class Scene {
  public:
+  using ObjectId = std::uint32_t;
+
+  Scene() = default;
+  explicit Scene(const AabbTreeOptions& options) : tree_(options) {}
+
+  /**
+   * @brief Add a model to the scene
+   * @return Returns the id used to refer to the model
+   */
+  ObjectId Add(Model model);
+  void Remove(const ObjectId id);
+  bool Contains(const ObjectId id) const {
+    return id < objects_.size() && objects_[id].proxy != AabbTree::kNullProxy;
+  }
+  /**
+   * @brief Access a model to move it.  Its bounds are refit at the next
+   *        Update.
+   */
+  Model& GetModel(const ObjectId id);
+  const Model& GetModel(const ObjectId id) const { return objects_[id].model; }
+  /**
+   * @brief World space bounds of a model as of the last Update
+   */
+  const Aabb& GetBounds(const ObjectId id) const {
+    return objects_[id].bounds;
+  }
+  std::size_t Size() const { return tree_.GetProxyCount(); }
+
+  /**
+   * @brief Add a model that never moves to the renderer's static instances
+   *
+   * Static models bypass the tree and are uploaded by the next Draw, which
+   * then culls and draws them with Renderer::DrawStaticInstances, on the GPU
+   * with the GL renderer.  They are drawn untextured with
+   * ShaderPrograms::INDIRECT.  The instances belong to the renderer, so every
+   * scene drawn with it shows them.
+   */
+  void AddStatic(const Model& model) { pending_static_.push_back(model); }
+  /**
+   * @brief Number of static meshes added, including those not uploaded yet
+   */
+  std::size_t StaticSize() const;
+
+  /**
+   * @brief Also skip models hidden behind the occluders of a culler
+   *
+   * The caller owns the culler and fills it each frame, typically rasterizing
+   * asynchronously while the simulation ticks.  nullptr disables occlusion
+   * culling.
+   */
+  void SetOcclusionCuller(const OcclusionCuller* culler) {
+    occlusion_culler_ = culler;
+  }
+
+  Camera& GetCamera() { return camera_; }
+  const Camera& GetCamera() const { return camera_; }
+
+  /**
+   * @brief Dynamic lights of the scene, binned into clusters by Draw.  With
+   *        no lights the scene is drawn unlit.
+   */
+  std::vector<Light>& GetLights() { return lights_; }
+  const std::vector<Light>& GetLights() const { return lights_; }
+  void SetAmbientLight(const glm::vec3 ambient) { ambient_light_ = ambient; }
+  /**
+   * @brief Statistics of the light binning of the last Draw
+   */
+  const LightClusterStats& GetLightClusterStats() const {
+    return light_clusterer_.GetStats();
+  }
+
+  /**
+   * @brief Refit the tree around models fetched with GetModel whose transform
+   *        changed since
+   * @return Returns the number of models that had to be reinserted
+   */
+  std::size_t Update();
+
+  /**
+   * @brief Draw every model whose bounds intersect the camera's frustum, lit
+   *        by the scene's lights
+   */
   template <typename Renderer>
-  void Draw(Renderer renderer);
+  void Draw(const Renderer& renderer,
+            const ShaderPrograms shaders = ShaderPrograms::DEFAULT);
+
+  /**
+   * @brief Report every model overlapping a volume
+   * @param callback Called as bool(ObjectId); return false to stop
+   */
+  template <typename Callback>
+  void Query(const Aabb& box, Callback&& callback) const;
+  template <typename Callback>
+  void Query(const BoundingSphere& sphere, Callback&& callback) const;
+  template <typename Callback>
+  void Query(const Frustum& frustum, Callback&& callback) const;
+
+  /**
+   * @brief Find the model whose bounds a ray hits first
+   * @param distance If not null, set to the distance of the hit
+   */
+  std::optional<ObjectId> RayCast(const Ray& ray,
+                                  float* distance = nullptr) const;
+  /**
+   * @brief Find the model whose bounds are nearest to a point
+   */
+  std::optional<ObjectId> Nearest(const glm::vec3 point,
+                                  const float max_distance) const;
+
+  void swap(Scene& other) noexcept {
+    using std::swap;
+    swap(other.objects_, objects_);
+    swap(other.free_objects_, free_objects_);
+    swap(other.dirty_objects_, dirty_objects_);
+    swap(other.tree_, tree_);
+    swap(other.camera_, camera_);
+    swap(other.visible_, visible_);
+    swap(other.occlusion_culler_, occlusion_culler_);
+    swap(other.lights_, lights_);
+    swap(other.ambient_light_, ambient_light_);
+    swap(other.light_clusterer_, light_clusterer_);
+    swap(other.pending_static_, pending_static_);
+    swap(other.static_instances_, static_instances_);
+  }
 
  protected:
-  std::vector<Model> models_;
-  Camera camera_;
+  struct Object {
+    Model model{};
+    Aabb bounds{};
+    AabbTree::ProxyId proxy = AabbTree::kNullProxy;
+    std::uint32_t version = 0;
+    /**
+     * @brief Queued in dirty_objects_
+     */
+    bool dirty = false;
+  };
+
+  std::vector<Object> objects_{};
+  std::vector<ObjectId> free_objects_{};
+  std::vector<ObjectId> dirty_objects_{};
+  AabbTree tree_{};
+  Camera camera_{};
+  std::vector<ObjectId> visible_{};
+  const OcclusionCuller* occlusion_culler_ = nullptr;
+  std::vector<Light> lights_{};
+  glm::vec3 ambient_light_ = glm::vec3(0.1f);
+  LightClusterer light_clusterer_{};
+  /**
+   * @brief Static models waiting for Draw to hand them to the renderer
+   */
+  std::vector<Model> pending_static_{};
+  std::size_t static_instances_ = 0;
 };
 
+inline void swap(Scene& a, Scene& b) noexcept { a.swap(b); }
+
 } /* namespace game_engine::_3D */
 
 #include "3D/Scene.tpp"
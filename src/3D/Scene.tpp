@@ -24,13 +24,77 @@
 
 namespace game_engine::_3D {
 
-template <typename RealRenderer, typename RealWindowManager>
-void Scene::Draw(Renderer<RealRenderer, RealWindowManager>& renderer) {
-  for (auto& model : models_) {
-    camera_.DrawModel(renderer, model);
+template <typename Renderer>
+void Scene::Draw(const Renderer& renderer, const ShaderPrograms shaders) {
+  Update();
+  for (const Model& model : pending_static_) {
+    for (const Mesh& mesh : model.GetMeshes()) {
+      renderer.AddStaticInstance(
+          renderer.AddStaticMesh(mesh.vertices_, mesh.indices_),
+          model.model_);
+      static_instances_++;
+    }
   }
+  pending_static_.clear();
+
+  if (lights_.empty()) {
+    renderer.DisableLights(shaders);
+    if (static_instances_ != 0) {
+      renderer.DisableLights(ShaderPrograms::INDIRECT);
+    }
+  } else {
+    const LightClusterData& clusters =
+        light_clusterer_.Build(lights_, camera_.view_, camera_.projection_);
+    renderer.UploadLightClusters(shaders, clusters, ambient_light_);
+    if (static_instances_ != 0) {
+      renderer.UploadLightClusters(ShaderPrograms::INDIRECT, clusters,
+                                   ambient_light_);
+    }
+  }
+  const Frustum frustum = camera_.GetFrustum();
+  visible_.clear();
+  Query(frustum, [this](const ObjectId id) {
+    if (!occlusion_culler_ ||
+        occlusion_culler_->IsVisible(objects_[id].bounds)) {
+      visible_.push_back(id);
+    }
+    return true;
+  });
+  for (const auto id : visible_) {
+    camera_.DrawModel(renderer, objects_[id].model, shaders);
+  }
+  if (static_instances_ != 0) {
+    renderer.DrawStaticInstances(camera_.view_, camera_.projection_);
+  }
+}
+
+template <typename Callback>
+void Scene::Query(const Aabb& box, Callback&& callback) const {
+  tree_.Query(box, [this, &box, &callback](const AabbTree::ProxyId proxy) {
+    const ObjectId id = tree_.GetUserData(proxy);
+    return !objects_[id].bounds.Overlaps(box) || callback(id);
+  });
+}
+
+template <typename Callback>
+void Scene::Query(const BoundingSphere& sphere, Callback&& callback) const {
+  tree_.Query(sphere,
+              [this, &sphere, &callback](const AabbTree::ProxyId proxy) {
+                const ObjectId id = tree_.GetUserData(proxy);
+                return !sphere.Overlaps(objects_[id].bounds) || callback(id);
+              });
+}
+
+template <typename Callback>
+void Scene::Query(const Frustum& frustum, Callback&& callback) const {
+  tree_.Query(frustum,
+              [this, &frustum, &callback](const AabbTree::ProxyId proxy) {
+                const ObjectId id = tree_.GetUserData(proxy);
+                return !frustum.Intersects(objects_[id].bounds) ||
+                       callback(id);
+              });
 }
 
-}  // namespace game_engine::_3D
+} /* namespace game_engine::_3D */
 
 #endif /* SRC_3D_SCENE_TPP_ */
@@ -20,8 +20,12 @@
 #ifndef SRC_3D_TEXTURE_TPP_
 #define SRC_3D_TEXTURE_TPP_
 
+#include <cstddef>
+#include <cstdint>
+
 #include <glm/glm.hpp>
 
+#include "3D/MipmapGenerator.hpp"
 #include "3D/Texture.hpp"
 
 namespace game_engine::_3D {
@@ -73,8 +77,21 @@ GLuint Texture::LoadTexture(const Renderer& renderer, const cmrc::file file,
 
   PixelFormat format = DeterminePixelFormat(surface->format);
 
-  LoadTextureFromMemory(renderer, size, format, surface->pixels, shader_program,
-                        type);
+  if (path_ == "") {
+    path_ = "N/A";
+  }
+  type_ = type;
+
+  // Build the mip chain on the CPU rather than with glGenerateMipmap, which
+  // runs on the CPU anyway with software drivers and only box filters
+  MipmapOptions options;
+  options.filter = MipFilter::KAISER;
+  options.srgb = (type == TextureType::DIFFUSE);
+  const MipChain mip_chain = MipmapGenerator(options).Generate(
+      size, surface->format->BytesPerPixel,
+      static_cast<const std::uint8_t*>(surface->pixels),
+      static_cast<std::size_t>(surface->pitch));
+  id_ = renderer.CreateTexture(shader_program, format, mip_chain);
 
   // Free SDL surface
   SDL_FreeSurface(surface);
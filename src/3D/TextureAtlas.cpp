@@ -0,0 +1,232 @@
+/******************************************************************************
+ * TextureAtlas.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/TextureAtlas.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace game_engine::_3D {
+
+std::optional<glm::ivec2> SkylinePacker::Pack(const glm::ivec2 size) {
+  if (size.x <= 0 || size.y <= 0) {
+    return glm::ivec2(0, 0);
+  }
+
+  std::size_t best_index = skyline_.size();
+  int best_top = std::numeric_limits<int>::max();
+  int best_x = std::numeric_limits<int>::max();
+  for (std::size_t i = 0; i < skyline_.size(); i++) {
+    const int y = FitAt(i, size);
+    if (y < 0) {
+      continue;
+    }
+    const int top = y + size.y;
+    if (top < best_top || (top == best_top && skyline_[i].x < best_x)) {
+      best_index = i;
+      best_top = top;
+      best_x = skyline_[i].x;
+    }
+  }
+  if (best_index == skyline_.size()) {
+    return std::nullopt;
+  }
+
+  const glm::ivec2 position(skyline_[best_index].x, best_top - size.y);
+  skyline_.insert(skyline_.begin() + best_index,
+                  Node{position.x, best_top, size.x});
+
+  // Trim the segments now covered by the new one
+  for (std::size_t i = best_index + 1; i < skyline_.size();) {
+    const Node& prev = skyline_[i - 1];
+    Node& node = skyline_[i];
+    const int overlap = prev.x + prev.width - node.x;
+    if (overlap <= 0) {
+      break;
+    }
+    node.x += overlap;
+    node.width -= overlap;
+    if (node.width > 0) {
+      break;
+    }
+    skyline_.erase(skyline_.begin() + i);
+  }
+  Merge();
+
+  used_area_ += static_cast<std::size_t>(size.x) * size.y;
+  return position;
+}
+
+void SkylinePacker::Reset(const glm::ivec2 size) {
+  size_ = size;
+  skyline_.clear();
+  skyline_.push_back(Node{0, 0, size.x});
+  used_area_ = 0;
+}
+
+float SkylinePacker::GetOccupancy() const {
+  const std::size_t area = static_cast<std::size_t>(size_.x) * size_.y;
+  if (area == 0) {
+    return 0.0f;
+  }
+  return static_cast<float>(used_area_) / static_cast<float>(area);
+}
+
+int SkylinePacker::FitAt(const std::size_t index, const glm::ivec2 size) const {
+  if (skyline_[index].x + size.x > size_.x) {
+    return -1;
+  }
+  int y = 0;
+  int remaining = size.x;
+  for (std::size_t i = index; remaining > 0 && i < skyline_.size(); i++) {
+    y = std::max(y, skyline_[i].y);
+    if (y + size.y > size_.y) {
+      return -1;
+    }
+    remaining -= skyline_[i].width;
+  }
+  return y;
+}
+
+void SkylinePacker::Merge() {
+  for (std::size_t i = 1; i < skyline_.size();) {
+    if (skyline_[i - 1].y == skyline_[i].y) {
+      skyline_[i - 1].width += skyline_[i].width;
+      skyline_.erase(skyline_.begin() + i);
+    } else {
+      i++;
+    }
+  }
+}
+
+TextureAtlas::TextureAtlas(const glm::ivec2 page_size, const int channels,
+                           const int padding)
+    : page_size_(page_size),
+      channels_(std::clamp(channels, 1, 4)),
+      padding_(std::max(0, padding)) {}
+
+std::optional<TextureRegion> TextureAtlas::Add(const glm::ivec2 size,
+                                               const std::uint8_t* pixels,
+                                               const std::size_t row_stride) {
+  const glm::ivec2 padded = size + glm::ivec2(2 * padding_);
+  if (padded.x > page_size_.x || padded.y > page_size_.y) {
+    log_.Error("Image of {}x{} does not fit in a {}x{} atlas page.", size.x,
+               size.y, page_size_.x, page_size_.y);
+    return std::nullopt;
+  }
+
+  TextureRegion region;
+  region.size = size;
+  if (size.x <= 0 || size.y <= 0) {
+    region.uv_min = region.uv_max = glm::vec2(0.0f);
+    return region;
+  }
+
+  std::optional<glm::ivec2> position;
+  for (std::size_t page = 0; page < pages_.size() && !position; page++) {
+    position = pages_[page].Pack(padded);
+    region.layer = static_cast<int>(page);
+  }
+  if (!position) {
+    AddPage();
+    region.layer = GetLayerCount() - 1;
+    position = pages_.back().Pack(padded);
+  }
+
+  region.position = *position + glm::ivec2(padding_);
+  region.uv_min = glm::vec2(region.position) / glm::vec2(page_size_);
+  region.uv_max = glm::vec2(region.position + size) / glm::vec2(page_size_);
+  Blit(region, pixels,
+       (row_stride != 0) ? row_stride
+                         : static_cast<std::size_t>(size.x) * channels_);
+  return region;
+}
+
+int TextureAtlas::GetMipLevels() const {
+  // Level n shrinks the padding by 2^n
+  int levels = 1;
+  while ((padding_ >> levels) > 0) {
+    levels++;
+  }
+  return std::min(levels, MipmapGenerator::LevelCount(page_size_));
+}
+
+void TextureAtlas::Clear() {
+  pages_.clear();
+  pixels_.clear();
+}
+
+void TextureAtlas::AddPage() {
+  pages_.emplace_back(page_size_);
+  pixels_.resize(pixels_.size() + static_cast<std::size_t>(page_size_.x) *
+                                      page_size_.y * channels_,
+                 0);
+}
+
+void TextureAtlas::Blit(const TextureRegion& region,
+                        const std::uint8_t* pixels,
+                        const std::size_t row_stride) {
+  const std::size_t texel = static_cast<std::size_t>(channels_);
+  const std::size_t page_row = static_cast<std::size_t>(page_size_.x) * texel;
+  std::uint8_t* page = &pixels_[static_cast<std::size_t>(region.layer) *
+                                page_row * page_size_.y];
+
+  // Rows in the padding repeat the nearest edge row, and columns in the
+  // padding repeat the nearest edge texel
+  for (int y = -padding_; y < region.size.y + padding_; y++) {
+    const int src_y = std::clamp(y, 0, region.size.y - 1);
+    const std::uint8_t* src = pixels + src_y * row_stride;
+    std::uint8_t* dst = page + (region.position.y + y) * page_row +
+                        region.position.x * texel;
+    std::memcpy(dst, src, region.size.x * texel);
+    for (int x = 1; x <= padding_; x++) {
+      std::memcpy(dst - x * texel, src, texel);
+      std::memcpy(dst + (region.size.x - 1 + x) * texel,
+                  src + (region.size.x - 1) * texel, texel);
+    }
+  }
+}
+
+TextureRegion TextureArrayBuilder::AddLayer(const std::uint8_t* pixels) {
+  const std::size_t layer_size =
+      static_cast<std::size_t>(tile_size_.x) * tile_size_.y * channels_;
+  pixels_.insert(pixels_.end(), pixels, pixels + layer_size);
+
+  TextureRegion region;
+  region.layer = layers_++;
+  region.size = tile_size_;
+  return region;
+}
+
+std::ostream& operator<<(std::ostream& os, const TextureRegion& region) {
+  return os << "TextureRegion {\n"
+            << "int layer = " << region.layer << "\n"
+            << "glm::ivec2 position = (" << region.position.x << ", "
+            << region.position.y << ")\n"
+            << "glm::ivec2 size = (" << region.size.x << ", " << region.size.y
+            << ")\n"
+            << "glm::vec2 uv_min = (" << region.uv_min.x << ", "
+            << region.uv_min.y << ")\n"
+            << "glm::vec2 uv_max = (" << region.uv_max.x << ", "
+            << region.uv_max.y << ")\n}";
+}
+
+} /* namespace game_engine::_3D */
@@ -0,0 +1,261 @@
+/******************************************************************************
+ * TextureAtlas.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_3D_TEXTUREATLAS_HPP_
+#define SRC_3D_TEXTUREATLAS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "LoggerV2/Log.hpp"
+
+#include "3D/MipmapGenerator.hpp"
+#include "3D/PixelFormat.hpp"
+#include "ShaderPrograms.hpp"
+
+namespace game_engine::_3D {
+
+/**
+ * @brief Location of a sub-image inside a texture array
+ *
+ * Materials reference a region rather than a texture id, so everything packed
+ * into the same array can be drawn with a single bind.
+ */
+struct TextureRegion {
+  /**
+   * @brief Layer of the texture array holding the image
+   */
+  int layer = 0;
+  /**
+   * @brief Position and size of the image on its layer, in texels
+   */
+  glm::ivec2 position{0, 0};
+  glm::ivec2 size{0, 0};
+  /**
+   * @brief Normalized texture coordinates of the image corners
+   */
+  glm::vec2 uv_min{0.0f, 0.0f};
+  glm::vec2 uv_max{1.0f, 1.0f};
+
+  void swap(TextureRegion& other) noexcept {
+    using std::swap;
+    swap(other.layer, layer);
+    swap(other.position, position);
+    swap(other.size, size);
+    swap(other.uv_min, uv_min);
+    swap(other.uv_max, uv_max);
+  }
+};
+
+std::ostream& operator<<(std::ostream& os, const TextureRegion& region);
+
+inline void swap(TextureRegion& a, TextureRegion& b) noexcept { a.swap(b); }
+
+/**
+ * @brief Bottom-left skyline rectangle packer
+ *
+ * Tracks the top edge of everything packed so far as a list of horizontal
+ * segments and places each new rectangle where its top ends up lowest.
+ */
+class SkylinePacker {
+ public:
+  SkylinePacker() = default;
+  explicit SkylinePacker(const glm::ivec2 size) { Reset(size); }
+
+  /**
+   * @brief Find space for a rectangle
+   * @param size Size of the rectangle
+   * @return Returns the position of the rectangle, or std::nullopt if it does
+   *         not fit
+   */
+  std::optional<glm::ivec2> Pack(const glm::ivec2 size);
+
+  /**
+   * @brief Forget every packed rectangle
+   */
+  void Reset(const glm::ivec2 size);
+
+  glm::ivec2 GetSize() const { return size_; }
+  /**
+   * @brief Fraction of the area covered by packed rectangles
+   */
+  float GetOccupancy() const;
+
+ protected:
+  struct Node {
+    int x;
+    int y;
+    int width;
+  };
+
+  /**
+   * @brief Height the rectangle would be placed at if its left edge were on
+   *        node index, or -1 if it does not fit there
+   */
+  int FitAt(const std::size_t index, const glm::ivec2 size) const;
+  void Merge();
+
+  glm::ivec2 size_{0, 0};
+  std::vector<Node> skyline_{};
+  std::size_t used_area_ = 0;
+};
+
+/**
+ * @brief Packs images of arbitrary size into the layers of a texture array
+ *
+ * Each layer is a skyline packed page.  When an image no longer fits on any
+ * page a new layer is started.  Images are padded by extruding their border
+ * texels so filtering does not bleed between neighbours.  Mip levels stop
+ * before the padding shrinks below a texel, so a padding of 1 gives no mip
+ * levels at all and every doubling of the padding adds one.
+ */
+class TextureAtlas {
+ public:
+  /**
+   * @brief Padding used when none is given.  Keeps three mip levels, level 0
+   *        included, at the cost of 8 texels of every packed dimension.
+   *        Atlases that are only ever magnified can pass 1 to pack tighter.
+   */
+  static constexpr int kDefaultPadding = 4;
+
+  TextureAtlas() = default;
+  /**
+   * @param page_size Size of each layer in texels
+   * @param channels Number of 8-bit channels per texel (1 to 4)
+   * @param padding Texels of padding around each image.  Bounds the mip
+   *                levels, see GetMipLevels().
+   */
+  TextureAtlas(const glm::ivec2 page_size, const int channels,
+               const int padding = kDefaultPadding);
+
+  /**
+   * @brief Copy an image into the atlas
+   * @param size Size of the image
+   * @param pixels Pixel data, with the same channel count as the atlas
+   * @param row_stride Bytes between the start of two rows.  0 means tightly
+   *                   packed.
+   * @return Returns where the image was placed, or std::nullopt if it is
+   *         larger than a page
+   */
+  std::optional<TextureRegion> Add(const glm::ivec2 size,
+                                   const std::uint8_t* pixels,
+                                   const std::size_t row_stride = 0);
+
+  /**
+   * @brief Upload every layer as a clamped GL_TEXTURE_2D_ARRAY, with mip
+   *        levels generated on the CPU
+   * @param options Options of the mip levels.  max_levels is lowered to
+   *                GetMipLevels() if it is larger.
+   * @return Returns the id of the texture array
+   */
+  template <typename Renderer>
+  unsigned int Upload(const Renderer& renderer,
+                      const ShaderPrograms shader_program,
+                      const PixelFormat format,
+                      MipmapOptions options = MipmapOptions());
+
+  /**
+   * @brief Number of mip levels, level 0 included, that keep at least a
+   *        texel of padding around every image
+   */
+  int GetMipLevels() const;
+
+  /**
+   * @brief Drop every image and layer, keeping the configuration
+   */
+  void Clear();
+
+  glm::ivec2 GetPageSize() const { return page_size_; }
+  int GetChannels() const { return channels_; }
+  int GetLayerCount() const { return static_cast<int>(pages_.size()); }
+  unsigned int GetId() const { return id_; }
+  /**
+   * @brief Pixels of every layer, one after the other
+   */
+  const std::vector<std::uint8_t>& GetPixels() const { return pixels_; }
+
+ protected:
+  void AddPage();
+  void Blit(const TextureRegion& region, const std::uint8_t* pixels,
+            const std::size_t row_stride);
+
+  glm::ivec2 page_size_{0, 0};
+  int channels_ = 4;
+  int padding_ = kDefaultPadding;
+  std::vector<SkylinePacker> pages_{};
+  std::vector<std::uint8_t> pixels_{};
+  unsigned int id_ = 0;
+
+  logging::Log log_ = logging::Log("main");
+};
+
+/**
+ * @brief Collects same-sized tiles as the layers of a texture array
+ *
+ * Meant for block faces and other tiles that repeat across their whole
+ * surface, which an atlas cannot do without wrapping into neighbours.
+ */
+class TextureArrayBuilder {
+ public:
+  TextureArrayBuilder() = default;
+  TextureArrayBuilder(const glm::ivec2 tile_size, const int channels)
+      : tile_size_(tile_size), channels_(channels) {}
+
+  /**
+   * @brief Append a tile as a new layer
+   * @param pixels Tightly packed tile of tile_size texels
+   * @return Returns the region covering the whole new layer
+   */
+  TextureRegion AddLayer(const std::uint8_t* pixels);
+
+  /**
+   * @brief Upload every layer as a repeating GL_TEXTURE_2D_ARRAY, with mip
+   *        levels generated on the CPU
+   * @param options Options of the mip levels
+   * @return Returns the id of the texture array
+   */
+  template <typename Renderer>
+  unsigned int Upload(const Renderer& renderer,
+                      const ShaderPrograms shader_program,
+                      const PixelFormat format,
+                      const MipmapOptions& options = MipmapOptions());
+
+  glm::ivec2 GetTileSize() const { return tile_size_; }
+  int GetLayerCount() const { return layers_; }
+  unsigned int GetId() const { return id_; }
+
+ protected:
+  glm::ivec2 tile_size_{0, 0};
+  int channels_ = 4;
+  int layers_ = 0;
+  std::vector<std::uint8_t> pixels_{};
+  unsigned int id_ = 0;
+};
+
+} /* namespace game_engine::_3D */
+
+#include "3D/TextureAtlas.tpp"
+
+#endif /* SRC_3D_TEXTUREATLAS_HPP_ */
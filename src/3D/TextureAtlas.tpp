@@ -0,0 +1,78 @@
+/******************************************************************************
+ * TextureAtlas.tpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_3D_TEXTUREATLAS_TPP_
+#define SRC_3D_TEXTUREATLAS_TPP_
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "3D/TextureAtlas.hpp"
+
+namespace game_engine::_3D {
+
+template <typename Renderer>
+unsigned int TextureAtlas::Upload(const Renderer& renderer,
+                                  const ShaderPrograms shader_program,
+                                  const PixelFormat format,
+                                  MipmapOptions options) {
+  const int mip_levels = GetMipLevels();
+  if (options.max_levels <= 0 || options.max_levels > mip_levels) {
+    options.max_levels = mip_levels;
+  }
+  log_.Debug("Uploading {} atlas layers of {}x{} with {} mip levels.",
+             pages_.size(), page_size_.x, page_size_.y, options.max_levels);
+  const MipmapGenerator generator(options);
+  const std::size_t page_bytes = static_cast<std::size_t>(page_size_.x) *
+                                 page_size_.y * channels_;
+  std::vector<MipChain> layers;
+  layers.reserve(pages_.size());
+  for (std::size_t layer = 0; layer < pages_.size(); layer++) {
+    layers.push_back(generator.Generate(page_size_, channels_,
+                                        pixels_.data() + page_bytes * layer));
+  }
+  id_ = renderer.CreateTextureArray(shader_program, format, layers,
+                                    TextureWrap::CLAMP);
+  return id_;
+}
+
+template <typename Renderer>
+unsigned int TextureArrayBuilder::Upload(const Renderer& renderer,
+                                         const ShaderPrograms shader_program,
+                                         const PixelFormat format,
+                                         const MipmapOptions& options) {
+  const MipmapGenerator generator(options);
+  const std::size_t tile_bytes = static_cast<std::size_t>(tile_size_.x) *
+                                 tile_size_.y * channels_;
+  std::vector<MipChain> layers;
+  layers.reserve(layers_);
+  for (int layer = 0; layer < layers_; layer++) {
+    layers.push_back(generator.Generate(tile_size_, channels_,
+                                        pixels_.data() + tile_bytes * layer));
+  }
+  id_ = renderer.CreateTextureArray(shader_program, format, layers,
+                                    TextureWrap::REPEAT);
+  return id_;
+}
+
+} /* namespace game_engine::_3D */
+
+#endif /* SRC_3D_TEXTUREATLAS_TPP_ */
@@ -27,6 +27,7 @@ namespace game_engine::_3D {
 void Transformations::Rotate(const glm::vec3 delta) {
   model_ *= glm::orientate4(delta);
   rotation_ += delta;
+  version_++;
 }
 void Transformations::Rotate(const float delta_a, const float delta_b,
                              const float delta_c) {
@@ -60,6 +61,7 @@ void Transformations::RotateTo(const glm::vec3 rot) {
   model_ *= glm::orientate4(rotation_);
   model_ = glm::translate(model_, position_);
   model_ = glm::scale(model_, scaling_);
+  version_++;
 }
 void Transformations::RotateTo(const float rot_a, const float rot_b,
                                const float rot_c) {
@@ -90,6 +92,7 @@ void Transformations::RotateBCTo(const float rot_b, const float rot_c) {
 void Transformations::Move(const glm::vec3 delta) {
   model_ = glm::translate(model_, delta);
   position_ += delta;
+  version_++;
 }
 void Transformations::Move(const float delta_x, const float delta_y,
                            const float delta_z) {
@@ -123,6 +126,7 @@ void Transformations::MoveTo(const glm::vec3 pos) {
   model_ *= glm::orientate4(rotation_);
   model_ = glm::translate(model_, position_);
   model_ = glm::scale(model_, scaling_);
+  version_++;
 }
 void Transformations::MoveTo(const float pos_x, const float pos_y,
                              const float pos_z) {
@@ -181,6 +185,7 @@ void Transformations::ScaleXYZ(const float Scale_x, const float Scale_y,
                                const float Scale_z) {
   model_ = glm::scale(model_, glm::vec3(Scale_x, Scale_y, Scale_z));
   scaling_ *= glm::vec3(Scale_x, Scale_y, Scale_z);
+  version_++;
 }
 
 void Transformations::ScaleTo(const float Scale) {
@@ -223,6 +228,7 @@ void Transformations::ScaleXYZTo(const float Scale_x, const float Scale_y,
   model_ *= glm::orientate4(rotation_);
   model_ = glm::translate(model_, position_);
   model_ = glm::scale(model_, scaling_);
+  version_++;
 }
 
 } /* namespace game_engine::_3D */
@@ -21,6 +21,9 @@
 #define SRC_3D_TRANSFORMATIONS_HPP_
 
 #define GLM_ENABLE_EXPERIMENTAL
+#include <cstdint>
+#include <utility>
+
 #include <glm/glm.hpp>
 
 namespace game_engine::_3D {
@@ -102,6 +105,16 @@ class Transformations {
   void ScaleXYZTo(const float scale_x, const float scale_y,
                   const float scale_z);
 
+  /**
+   * @brief Mark the transform as changed after writing model_ directly
+   */
+  void Touch() { version_++; }
+  /**
+   * @brief Incremented by every change to the transform, so owners can
+   *        cheaply tell whether model_ moved since they last looked
+   */
+  std::uint32_t GetVersion() const { return version_; }
+
  public:
   glm::mat4 model_ = glm::mat4(1.0f);
 
@@ -109,12 +122,18 @@ class Transformations {
   glm::vec3 scaling_;
   glm::vec3 position_;
 
+ protected:
+  std::uint32_t version_ = 0;
+
+ public:
+
   void swap(Transformations& other) noexcept {
     using std::swap;
     swap(other.model_, model_);
     swap(other.rotation_, rotation_);
     swap(other.scaling_, scaling_);
     swap(other.position_, position_);
+    swap(other.version_, version_);
   }
 };
 
@@ -20,7 +20,12 @@
 
 #include "GL/GLRenderer.hpp"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -178,6 +183,10 @@ void GLRenderer::Init(const std::string program_name) {
                              SDL_WINDOW_RESIZABLE | SDL_WINDOW_OPENGL));
   SDL_GL_CreateContext(GetWindow());
   EnableVSync();
+  InitContext();
+}
+
+void GLRenderer::InitContext() {
   /* Extension wrangler initialising */
   glewExperimental = GL_TRUE;
   const GLenum glew_status = glewInit();
@@ -200,10 +209,19 @@ void GLRenderer::Init(const std::string program_name) {
   log_p->module = module;
   glDebugMessageCallback(GlLogCallback, log_p);
 
+  program_cache_.Init();
+  Shader::EnableParallelCompile();
+
+  // Every program is submitted before any of them is waited on, so the
+  // driver can compile them concurrently
+
   default_shader_ = SetupShader("default.vs.glsl", "default.fs.glsl");
   cube_shader_ = SetupShader("cube.vs.glsl", "cube.fs.glsl");
   skybox_shader_ = SetupShader("skybox.vs.glsl", "skybox.fs.glsl");
-  text_shader_ = SetupShader("text.vs.glsl", "text.fs.glsl");
+  text_shader_ = SetupShader("sprite.vs.glsl", "text.fs.glsl");
+  upscale_shader_ = SetupShader("upscale.vs.glsl", "upscale.fs.glsl");
+  indirect_shader_ = SetupShader("indirect.vs.glsl", "default.fs.glsl");
+  sprite_shader_ = SetupShader("sprite.vs.glsl", "sprite.fs.glsl");
 
   UseShader(ShaderPrograms::DEFAULT);
 }
@@ -229,7 +247,7 @@ void GLRenderer::Render(const VboHandle vbo_handle,
   // draw mesh
   if (vbo.n_indices_ != 0) {
     glDrawElements(static_cast<GLenum>(Convert(mode)), vbo.n_indices_,
-                   GL_UNSIGNED_INT, 0);
+                   vbo.index_type_, 0);
   } else {
     glDrawArrays(static_cast<GLenum>(Convert(mode)), 0, vbo.n_vertices_);
   }
@@ -237,6 +255,29 @@ void GLRenderer::Render(const VboHandle vbo_handle,
   log_.CAPTURE(vbo_handle.uuid_);
 }
 
+void GLRenderer::Render(const VboHandle vbo_handle, const _3D::Primitive mode,
+                        const std::size_t first_index,
+                        const std::size_t index_count) const {
+  const auto it = vbos_.find(vbo_handle);
+  if (it == vbos_.end()) {
+    log_.Error("VBO_handle {} not in map!", vbo_handle);
+    return;
+  }
+  Vbo vbo = it->second;
+  if (first_index + index_count > vbo.n_indices_) {
+    log_.Error("Index range {}+{} out of bounds of VBO_handle {}!",
+               first_index, index_count, vbo_handle);
+    return;
+  }
+
+  GetShader(vbo.shaders_)->Use();
+  vbo.Bind();
+  glDrawElements(
+      static_cast<GLenum>(Convert(mode)), static_cast<GLsizei>(index_count),
+      vbo.index_type_,
+      reinterpret_cast<const void*>(vbo.IndexOffset(first_index)));
+}
+
 VboHandle GLRenderer::GenerateVbo(const ShaderPrograms shader_program,
                                   const std::vector<Vertex>& vertices,
                                   const std::vector<GLuint>& indices) {
@@ -272,6 +313,10 @@ void GLRenderer::SetMatrices(const ShaderPrograms shader_program,
   GetShader(shader_program)->SetMat4("model", model);
   GetShader(shader_program)->SetMat4("view", view);
   GetShader(shader_program)->SetMat4("projection", projection);
+  // Once per draw rather than once per vertex in the shader
+  GetShader(shader_program)
+      ->SetMat3("normal_matrix",
+                glm::transpose(glm::inverse(glm::mat3(view * model))));
 }
 void GLRenderer::BindTexture(const ShaderPrograms shader_program,
                              const std::string& name,
@@ -285,6 +330,15 @@ void GLRenderer::BindTexture(const ShaderPrograms shader_program,
   GetShader(shader_program)->SetInt(name, texture_unit);
   glBindTexture(GL_TEXTURE_2D, texture.id_);
 }
+void GLRenderer::BindTextureArray(const ShaderPrograms shader_program,
+                                  const std::string& name,
+                                  const unsigned int id,
+                                  const GLuint texture_unit) const {
+  UseShader(shader_program);
+  glActiveTexture(GL_TEXTURE0 + texture_unit);
+  GetShader(shader_program)->SetInt(name, texture_unit);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+}
 void GLRenderer::BindCubemap(const ShaderPrograms shader_program,
                              const std::string& name,
                              const _3D::Cubemap& cube_map,
@@ -326,6 +380,99 @@ unsigned int GLRenderer::CreateTexture(const ShaderPrograms shader_program,
   glGenerateMipmap(GL_TEXTURE_2D);
   return id;
 }
+unsigned int GLRenderer::CreateTexture(const ShaderPrograms shader_program,
+                                       const _3D::PixelFormat format,
+                                       const _3D::MipChain& mip_chain) const {
+  UseShader(shader_program);
+
+  unsigned int id;
+  glGenTextures(1, &id);
+  glBindTexture(GL_TEXTURE_2D, id);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+                  static_cast<GLint>(mip_chain.levels.size()) - 1);
+
+  // Levels are tightly packed, which breaks the default 4 byte row alignment
+  // for 1 and 3 channel textures
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  for (std::size_t level = 0; level < mip_chain.levels.size(); level++) {
+    const _3D::MipLevel& mip = mip_chain.levels[level];
+    glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), format.i_format,
+                 mip.size.x, mip.size.y, 0, format.e_format, GL_UNSIGNED_BYTE,
+                 mip.pixels.data());
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  return id;
+}
+unsigned int GLRenderer::CreateTextureArray(const ShaderPrograms shader_program,
+                                            const _3D::PixelFormat format,
+                                            const glm::ivec3 size,
+                                            const int mip_levels,
+                                            const _3D::TextureWrap wrap) const {
+  UseShader(shader_program);
+
+  unsigned int id;
+  glGenTextures(1, &id);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+  const GLint gl_wrap =
+      (wrap == _3D::TextureWrap::REPEAT) ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, gl_wrap);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, gl_wrap);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+                  (mip_levels > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL,
+                  std::max(mip_levels, 1) - 1);
+
+  for (int level = 0; level < std::max(mip_levels, 1); level++) {
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, level, format.i_format,
+                 std::max(1, size.x >> level), std::max(1, size.y >> level),
+                 size.z, 0, format.e_format, GL_UNSIGNED_BYTE, nullptr);
+  }
+  return id;
+}
+unsigned int GLRenderer::CreateTextureArray(
+    const ShaderPrograms shader_program, const _3D::PixelFormat format,
+    const std::vector<_3D::MipChain>& layers,
+    const _3D::TextureWrap wrap) const {
+  if (layers.empty() || layers.front().levels.empty()) {
+    log_.Error("Cannot create a texture array without layers.");
+    return 0;
+  }
+  const _3D::MipChain& first = layers.front();
+  const unsigned int id = CreateTextureArray(
+      shader_program, format,
+      glm::ivec3(first.levels.front().size, static_cast<int>(layers.size())),
+      static_cast<int>(first.levels.size()), wrap);
+  for (std::size_t layer = 0; layer < layers.size(); layer++) {
+    const std::vector<_3D::MipLevel>& levels = layers[layer].levels;
+    for (std::size_t level = 0; level < levels.size(); level++) {
+      UpdateTextureArray(id, format,
+                         glm::ivec3(0, 0, static_cast<int>(layer)),
+                         levels[level].size, levels[level].pixels.data(),
+                         static_cast<int>(level));
+    }
+  }
+  return id;
+}
+void GLRenderer::UpdateTextureArray(const unsigned int id,
+                                    const _3D::PixelFormat format,
+                                    const glm::ivec3 offset,
+                                    const glm::ivec2 size, const void* pixels,
+                                    const int level) const {
+  glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, offset.x, offset.y, offset.z,
+                  size.x, size.y, 1, format.e_format, GL_UNSIGNED_BYTE,
+                  pixels);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
 unsigned int GLRenderer::CreateCubemap(
     const ShaderPrograms shader_program, const _3D::PixelFormat format,
     const glm::ivec2 size, const _3D::CubemapBuffers& buffers) const {
@@ -380,10 +527,242 @@ void GLRenderer::Clear(const glm::vec4 color) const {
   glClearColor(color.r, color.g, color.b, color.a);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
-void GLRenderer::Swap() const { SDL_GL_SwapWindow(window_); }
+void GLRenderer::Swap() const {
+  for (_3D::ReadbackCallback& callback : window_readbacks_) {
+    readbacks_.Request(0, GetWindowSize(), std::move(callback));
+  }
+  window_readbacks_.clear();
+  SDL_GL_SwapWindow(window_);
+  if (!pending_programs_.empty()) {
+    PollShaders();
+  }
+  if (readbacks_.GetPendingCount() > 0) {
+    PollReadbacks();
+  }
+}
+
+unsigned int GLRenderer::CreateRenderTarget(
+    const _3D::RenderTargetDesc& desc) {
+  RenderTarget target{};
+  target.Init(desc);
+  const unsigned int handle = next_render_target_++;
+  log_.Trace("render target {} = {}x{}, {} samples", handle, desc.size.x,
+             desc.size.y, desc.samples);
+  render_targets_.emplace(handle, target);
+  return handle;
+}
+
+void GLRenderer::DestroyRenderTarget(const unsigned int target) {
+  auto it = render_targets_.find(target);
+  if (it == render_targets_.end()) {
+    return;
+  }
+  /*  Readbacks copy into their own buffers, so they may still be pending  */
+  it->second.Destroy();
+  render_targets_.erase(it);
+}
+
+void GLRenderer::BindRenderTarget(const unsigned int target) const {
+  if (target == 0) {
+    const glm::ivec2 size = GetWindowSize();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, size.x, size.y);
+    return;
+  }
+  render_targets_.at(target).Bind();
+}
+
+void GLRenderer::ResolveRenderTarget(const unsigned int target) const {
+  render_targets_.at(target).Resolve();
+}
+
+unsigned int GLRenderer::GetRenderTargetTexture(
+    const unsigned int target) const {
+  return render_targets_.at(target).color_texture_;
+}
+
+void GLRenderer::ReadRenderTargetAsync(const unsigned int target,
+                                       _3D::ReadbackCallback callback) const {
+  if (target == 0) {
+    window_readbacks_.push_back(std::move(callback));
+    return;
+  }
+  const RenderTarget& render_target = render_targets_.at(target);
+  render_target.Resolve();
+  readbacks_.Request(render_target.GetResolveFramebuffer(),
+                     render_target.desc_.size, std::move(callback));
+}
+
+std::size_t GLRenderer::PollReadbacks() const { return readbacks_.Poll(); }
+
+void GLRenderer::FinishReadbacks() const { readbacks_.Finish(); }
+
+unsigned int GLRenderer::CreateTransientTexture(
+    const _3D::TransientTextureDesc& desc) const {
+  GLuint id;
+  glCreateTextures(GL_TEXTURE_2D, 1, &id);
+  glTextureParameteri(id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTextureParameteri(id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTextureStorage2D(id, 1, static_cast<GLenum>(desc.format.i_format),
+                     desc.size.x, desc.size.y);
+  return id;
+}
+void GLRenderer::DestroyTransientTexture(const unsigned int id) const {
+  // Framebuffers referencing the texture can never be bound again
+  for (auto it = framebuffers_.begin(); it != framebuffers_.end();) {
+    if (std::find(it->first.begin(), it->first.end(), id) != it->first.end()) {
+      glDeleteFramebuffers(1, &it->second);
+      it = framebuffers_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  glDeleteTextures(1, &id);
+}
+unsigned int GLRenderer::CreateTransientBuffer(
+    const _3D::TransientBufferDesc& desc) const {
+  GLuint id;
+  glCreateBuffers(1, &id);
+  glNamedBufferStorage(id, static_cast<GLsizeiptr>(desc.size), nullptr,
+                       GL_DYNAMIC_STORAGE_BIT);
+  return id;
+}
+void GLRenderer::DestroyTransientBuffer(const unsigned int id) const {
+  glDeleteBuffers(1, &id);
+}
+void GLRenderer::BindFrameTargets(const _3D::FramePassTargets& targets) const {
+  bool depth = targets.backbuffer || targets.has_depth;
+  if (targets.backbuffer) {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  } else if (targets.render_target != 0) {
+    const RenderTarget& render_target =
+        render_targets_.at(targets.render_target);
+    render_target.Bind();
+    depth = render_target.desc_.depth;
+  } else {
+    std::vector<unsigned int> key = targets.colors;
+    key.push_back(targets.has_depth ? targets.depth : 0);
+    auto it = framebuffers_.find(key);
+    if (it == framebuffers_.end()) {
+      GLuint fbo;
+      glCreateFramebuffers(1, &fbo);
+      std::vector<GLenum> draw_buffers;
+      for (std::size_t i = 0; i < targets.colors.size(); i++) {
+        const GLenum attachment = GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(i);
+        glNamedFramebufferTexture(fbo, attachment, targets.colors[i], 0);
+        draw_buffers.push_back(attachment);
+      }
+      if (targets.has_depth) {
+        GLint stencil_bits = 0;
+        glGetTextureLevelParameteriv(targets.depth, 0,
+                                     GL_TEXTURE_STENCIL_SIZE, &stencil_bits);
+        glNamedFramebufferTexture(fbo,
+                                  stencil_bits > 0
+                                      ? GL_DEPTH_STENCIL_ATTACHMENT
+                                      : GL_DEPTH_ATTACHMENT,
+                                  targets.depth, 0);
+      }
+      if (draw_buffers.empty()) {
+        glNamedFramebufferDrawBuffer(fbo, GL_NONE);
+      } else {
+        glNamedFramebufferDrawBuffers(
+            fbo, static_cast<GLsizei>(draw_buffers.size()),
+            draw_buffers.data());
+      }
+      const GLenum status = glCheckNamedFramebufferStatus(fbo, GL_FRAMEBUFFER);
+      if (status != GL_FRAMEBUFFER_COMPLETE) {
+        log_.Error("Frame graph framebuffer incomplete: {}", status);
+      }
+      it = framebuffers_.emplace(key, fbo).first;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, it->second);
+  }
+  if (targets.size.x > 0 && targets.size.y > 0) {
+    glViewport(0, 0, targets.size.x, targets.size.y);
+  }
+  if (targets.clear) {
+    glClearColor(targets.clear_color.r, targets.clear_color.g,
+                 targets.clear_color.b, targets.clear_color.a);
+    GLbitfield mask = targets.backbuffer || targets.render_target != 0 ||
+                              !targets.colors.empty()
+                          ? GL_COLOR_BUFFER_BIT
+                          : 0;
+    if (depth) {
+      mask |= GL_DEPTH_BUFFER_BIT;
+    }
+    glClear(mask);
+  }
+}
+void GLRenderer::InsertFrameBarrier(const _3D::FrameBarrier& barrier) const {
+  // GL orders everything except incoherent shader writes itself
+  if (!barrier.before_write ||
+      barrier.before != _3D::FrameResourceUsage::STORAGE) {
+    return;
+  }
+  GLbitfield bits = 0;
+  switch (barrier.after) {
+    case _3D::FrameResourceUsage::COLOR_ATTACHMENT:
+    case _3D::FrameResourceUsage::DEPTH_ATTACHMENT:
+      bits = GL_FRAMEBUFFER_BARRIER_BIT;
+      break;
+    case _3D::FrameResourceUsage::SAMPLED:
+      bits = GL_TEXTURE_FETCH_BARRIER_BIT;
+      break;
+    case _3D::FrameResourceUsage::STORAGE:
+      bits = barrier.texture ? GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+                             : GL_SHADER_STORAGE_BARRIER_BIT;
+      break;
+    case _3D::FrameResourceUsage::VERTEX_BUFFER:
+      bits = GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT;
+      break;
+    case _3D::FrameResourceUsage::INDEX_BUFFER:
+      bits = GL_ELEMENT_ARRAY_BARRIER_BIT;
+      break;
+    case _3D::FrameResourceUsage::INDIRECT_BUFFER:
+      bits = GL_COMMAND_BARRIER_BIT;
+      break;
+    case _3D::FrameResourceUsage::UNIFORM_BUFFER:
+      bits = GL_UNIFORM_BARRIER_BIT;
+      break;
+    case _3D::FrameResourceUsage::COPY:
+      bits = barrier.texture ? GL_TEXTURE_UPDATE_BARRIER_BIT
+                             : GL_BUFFER_UPDATE_BARRIER_BIT;
+      break;
+  }
+  glMemoryBarrier(bits);
+}
+void GLRenderer::BeginPassTimer(const std::string& name) const {
+  PassTimer& timer = pass_timers_[name];
+  if (timer.queries[0] == 0) {
+    glGenQueries(kPassTimerLatency, timer.queries);
+  }
+  // Read the query about to be reused, which was issued kPassTimerLatency
+  // frames ago and should be done without stalling
+  const GLuint query = timer.queries[timer.frame % kPassTimerLatency];
+  if (timer.frame >= kPassTimerLatency) {
+    GLint available = 0;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available) {
+      GLuint64 ns = 0;
+      glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+      timer.gpu_ms = static_cast<double>(ns) / 1e6;
+    }
+  }
+  glBeginQuery(GL_TIME_ELAPSED, query);
+}
+void GLRenderer::EndPassTimer(const std::string& name) const {
+  glEndQuery(GL_TIME_ELAPSED);
+  pass_timers_[name].frame++;
+}
+double GLRenderer::GetPassGpuTime(const std::string& name) const {
+  const auto it = pass_timers_.find(name);
+  return it == pass_timers_.end() ? -1.0 : it->second.gpu_ms;
+}
 
 ShaderProgram* GLRenderer::SetupShader(const std::string& vertex,
-                                       const std::string& fragment) const {
+                                       const std::string& fragment) {
   ShaderProgram* shader = new ShaderProgram();
 
   shader->Init();
@@ -396,25 +775,89 @@ ShaderProgram* GLRenderer::SetupShader(const std::string& vertex,
   const std::string fragment_source(fragment_file.begin(),
                                     fragment_file.size());
 
-  Shader vertex_shader(vertex_source, ShaderType::VERTEX);
-  Shader fragment_shader(fragment_source, ShaderType::FRAGMENT);
-  vertex_shader.Init();
-  fragment_shader.Init();
-  shader->AttachShader(vertex_shader);
-  shader->AttachShader(fragment_shader);
-  shader->Link();
+  const uint64_t cache_key =
+      program_cache_.Key({vertex_source, fragment_source});
+  if (program_cache_.Load(cache_key, shader)) {
+    log_.Debug("Loaded {} + {} from the program binary cache.", vertex,
+               fragment);
+    return shader;
+  }
+
+  PendingProgram pending;
+  pending.program = shader;
+  pending.vertex =
+      std::make_shared<Shader>(vertex_source, ShaderType::VERTEX);
+  pending.fragment =
+      std::make_shared<Shader>(fragment_source, ShaderType::FRAGMENT);
+  pending.cache_key = cache_key;
+  pending.name = vertex + " + " + fragment;
 
+  // Only submit the work here, the status is checked once the driver reports
+  // the link as complete or the program is first needed
+  pending.vertex->Compile();
+  pending.fragment->Compile();
+  shader->AttachShader(*pending.vertex);
+  shader->AttachShader(*pending.fragment);
+  shader->LinkAsync();
+  pending_programs_.push_back(std::move(pending));
+  return shader;
+}
+
+void GLRenderer::FinishProgram(PendingProgram& pending) const {
+  // Check every stage before combining so each one logs its own errors
+  const bool vertex_compiled = pending.vertex->CheckCompile();
+  const bool fragment_compiled = pending.fragment->CheckCompile();
+  const bool linked = pending.program->FinishLink();
   /* When all init functions run without errors,
      the glsl_program can initialize the resources */
-  if (!shader->IsValid()) {
+  if (!vertex_compiled || !fragment_compiled || !linked) {
+    log_.Error("Failed to build shader program {}.", pending.name);
     throw EXIT_FAILURE;
   }
-  //	shader->useProgram();
-  return shader;
+  log_.Debug("Shader program {} ready.", pending.name);
+  program_cache_.Store(pending.cache_key, *pending.program);
+}
+
+void GLRenderer::PollShaders() const {
+  for (auto it = pending_programs_.begin(); it != pending_programs_.end();) {
+    if (it->program->IsLinkComplete()) {
+      FinishProgram(*it);
+      it = pending_programs_.erase(it);
+    } else {
+      it++;
+    }
+  }
+}
+
+bool GLRenderer::IsShaderReady(const ShaderPrograms shader_program) const {
+  PollShaders();
+  const ShaderProgram* program = FindShader(shader_program);
+  return std::none_of(
+      pending_programs_.begin(), pending_programs_.end(),
+      [program](const PendingProgram& p) { return p.program == program; });
 }
 
 ShaderProgram* GLRenderer::GetShader(
     const ShaderPrograms shader_program) const {
+  ShaderProgram* program = FindShader(shader_program);
+  if (pending_programs_.empty()) {
+    return program;
+  }
+  // Fall back to blocking if the program is needed before it is ready
+  const auto it =
+      std::find_if(pending_programs_.begin(), pending_programs_.end(),
+                   [program](const PendingProgram& p) {
+                     return p.program == program;
+                   });
+  if (it != pending_programs_.end()) {
+    FinishProgram(*it);
+    pending_programs_.erase(it);
+  }
+  return program;
+}
+
+ShaderProgram* GLRenderer::FindShader(
+    const ShaderPrograms shader_program) const {
   switch (shader_program) {
     case ShaderPrograms::DEFAULT:
       return default_shader_;
@@ -424,12 +867,197 @@ ShaderProgram* GLRenderer::GetShader(
       return skybox_shader_;
     case ShaderPrograms::TEXT:
       return text_shader_;
+    case ShaderPrograms::UPSCALE:
+      return upscale_shader_;
+    case ShaderPrograms::INDIRECT:
+      return indirect_shader_;
+    case ShaderPrograms::SPRITE:
+      return sprite_shader_;
     default:
       return default_shader_;
   }
   return default_shader_;
 }
 
+void GLRenderer::UploadLightClusters(const ShaderPrograms shader_program,
+                                     const _3D::LightClusterData& clusters,
+                                     const glm::vec3 ambient) const {
+  if (light_buffers_[0] == 0) {
+    glCreateBuffers(3, light_buffers_);
+  }
+  const auto upload = [this](const GLuint binding, const std::size_t size,
+                             const void* data) {
+    /*  Orphan last frame's storage rather than waiting for the GPU to finish
+     *  reading it, and never leave a binding empty  */
+    constexpr std::size_t kMinSize = 16;
+    glNamedBufferData(light_buffers_[binding],
+                      static_cast<GLsizeiptr>(std::max(size, kMinSize)),
+                      nullptr, GL_STREAM_DRAW);
+    if (size > 0) {
+      glNamedBufferSubData(light_buffers_[binding], 0,
+                           static_cast<GLsizeiptr>(size), data);
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding,
+                     light_buffers_[binding]);
+  };
+  upload(0, clusters.lights.size() * sizeof(_3D::GpuLight),
+         clusters.lights.data());
+  upload(1, clusters.clusters.size() * sizeof(_3D::LightCluster),
+         clusters.clusters.data());
+  upload(2, clusters.indices.size() * sizeof(std::uint32_t),
+         clusters.indices.data());
+
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  ShaderProgram* program = GetShader(shader_program);
+  program->SetBool("lights_enabled", true);
+  program->SetIVec3("cluster_grid", clusters.grid);
+  program->SetVec2("cluster_depth_scale_bias", clusters.depth_scale_bias);
+  program->SetVec4("cluster_viewport",
+                   glm::vec4(viewport[0], viewport[1], viewport[2],
+                             viewport[3]));
+  program->SetVec3("ambient_light", ambient);
+}
+void GLRenderer::Upscale(const unsigned int texture, const glm::vec2 uv_scale,
+                         const _3D::UpscaleFilter filter,
+                         const float sharpness) const {
+  ShaderProgram* program = GetShader(ShaderPrograms::UPSCALE);
+  program->Use();
+  glBindTextureUnit(0, texture);
+  program->SetInt("source", 0);
+  program->SetVec2("uv_scale", uv_scale);
+  program->SetBool("sharpen", filter == _3D::UpscaleFilter::SHARPEN);
+  program->SetFloat("sharpness", sharpness);
+
+  const GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+  glDisable(GL_DEPTH_TEST);
+  if (empty_vao_ == 0) {
+    glCreateVertexArrays(1, &empty_vao_);
+  }
+  glBindVertexArray(empty_vao_);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glBindVertexArray(0);
+  if (depth_test) {
+    glEnable(GL_DEPTH_TEST);
+  }
+}
+void GLRenderer::DrawSprites(const _2D::SpriteBatch& batch,
+                             const glm::mat4& projection,
+                             const ShaderPrograms shader_program) const {
+  const std::vector<_2D::SpriteInstance>& instances = batch.GetInstances();
+  if (instances.empty()) {
+    return;
+  }
+  const GLintptr offset = sprite_buffer_.Write(
+      instances.data(),
+      static_cast<GLsizeiptr>(instances.size() * sizeof(_2D::SpriteInstance)),
+      sizeof(_2D::SpriteInstance));
+  if (offset < 0) {
+    log_.Error("Failed to map the sprite buffer.");
+    return;
+  }
+
+  if (sprite_vao_ == 0) {
+    glCreateVertexArrays(1, &sprite_vao_);
+    glVertexArrayBindingDivisor(sprite_vao_, 0, 1);
+    const auto attribute = [this](const GLuint location, const GLint size,
+                                  const GLenum type, const GLboolean normalized,
+                                  const std::size_t relative_offset) {
+      glVertexArrayAttribFormat(sprite_vao_, location, size, type, normalized,
+                                static_cast<GLuint>(relative_offset));
+      glVertexArrayAttribBinding(sprite_vao_, location, 0);
+      glEnableVertexArrayAttrib(sprite_vao_, location);
+    };
+    attribute(0, 4, GL_FLOAT, GL_FALSE,
+              offsetof(_2D::SpriteInstance, position_size));
+    attribute(1, 4, GL_FLOAT, GL_FALSE, offsetof(_2D::SpriteInstance, uv_rect));
+    attribute(2, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+              offsetof(_2D::SpriteInstance, color));
+    attribute(3, 1, GL_FLOAT, GL_FALSE,
+              offsetof(_2D::SpriteInstance, rotation));
+    glVertexArrayAttribIFormat(
+        sprite_vao_, 4, 1, GL_UNSIGNED_INT,
+        static_cast<GLuint>(offsetof(_2D::SpriteInstance, texture_layer)));
+    glVertexArrayAttribBinding(sprite_vao_, 4, 0);
+    glEnableVertexArrayAttrib(sprite_vao_, 4);
+  }
+  // The buffer may have been orphaned and grown, so rebind every time
+  glVertexArrayVertexBuffer(sprite_vao_, 0, sprite_buffer_.GetBuffer(), offset,
+                            sizeof(_2D::SpriteInstance));
+
+  ShaderProgram* program = GetShader(shader_program);
+  program->Use();
+  program->SetMat4("projection", projection);
+  program->SetInt("sprite_texture", 0);
+
+  const GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+  const GLboolean blend = glIsEnabled(GL_BLEND);
+  glDisable(GL_DEPTH_TEST);
+  glEnable(GL_BLEND);
+  glBindVertexArray(sprite_vao_);
+  for (const _2D::SpriteDraw& draw : batch.GetDraws()) {
+    glBindTextureUnit(0, draw.texture);
+    glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4,
+                                      static_cast<GLsizei>(draw.count),
+                                      draw.first);
+  }
+  glBindVertexArray(0);
+  if (depth_test) {
+    glEnable(GL_DEPTH_TEST);
+  }
+  if (!blend) {
+    glDisable(GL_BLEND);
+  }
+}
+void GLRenderer::DisableLights(const ShaderPrograms shader_program) const {
+  GetShader(shader_program)->SetBool("lights_enabled", false);
+}
+
+std::uint32_t GLRenderer::AddStaticMesh(
+    const std::vector<Vertex>& vertices,
+    const std::vector<GLuint>& indices) const {
+  if (!static_culler_built_) {
+    static_culler_built_ = true;
+    if (!static_culler_.Init()) {
+      log_.Error("GPU culling is unavailable, static instances are not drawn.");
+    }
+  }
+  return static_culler_.AddMesh(vertices, indices);
+}
+std::uint32_t GLRenderer::AddStaticInstance(const std::uint32_t mesh,
+                                            const glm::mat4& model) const {
+  return static_culler_.AddInstance(mesh, model);
+}
+void GLRenderer::SetStaticInstanceEnabled(const std::uint32_t instance,
+                                          const bool enabled) const {
+  static_culler_.SetEnabled(instance, enabled);
+}
+void GLRenderer::DrawStaticInstances(const glm::mat4& view,
+                                     const glm::mat4& projection) const {
+  if (static_culler_.GetInstanceCount() == 0) {
+    return;
+  }
+  static_culler_.Cull(projection * view);
+
+  if (white_texture_ == 0) {
+    const std::uint8_t white[4] = {255, 255, 255, 255};
+    glCreateTextures(GL_TEXTURE_2D, 1, &white_texture_);
+    glTextureStorage2D(white_texture_, 1, GL_RGBA8, 1, 1);
+    glTextureSubImage2D(white_texture_, 0, 0, 0, 1, 1, GL_RGBA,
+                        GL_UNSIGNED_BYTE, white);
+  }
+  ShaderProgram* program = GetShader(ShaderPrograms::INDIRECT);
+  program->Use();
+  program->SetMat4("view", view);
+  program->SetMat4("projection", projection);
+  glBindTextureUnit(0, white_texture_);
+  program->SetInt("texture_diffuse0", 0);
+  static_culler_.Draw();
+}
+std::uint32_t GLRenderer::ReadStaticVisibleCount() const {
+  return static_culler_.ReadVisibleCount();
+}
+
 void GLRenderer::SetUniform(const ShaderPrograms shader_program,
                             const std::string& name, const bool value) const {
   GetShader(shader_program)->SetBool(name, value);
@@ -20,14 +20,29 @@
 #ifndef SRC_GL_GLRENDERER_HPP_
 #define SRC_GL_GLRENDERER_HPP_
 
+#include <cstddef>
+#include <cstdint>
 #include <map>
+#include <memory>
+#include <string>
 #include <variant>
 #include <vector>
 
+#include "3D/FrameGraph.hpp"
+#include "3D/LightClusterer.hpp"
+#include "3D/MipmapGenerator.hpp"
+#include "3D/RenderTarget.hpp"
+#include "3D/ResolutionController.hpp"
 #include "3D/Texture.hpp"
 #include "GL/GLPrimitive.hpp"
 #include "GL/GLWindowManager.hpp"
+#include "GL/GpuCuller.hpp"
+#include "GL/ProgramBinaryCache.hpp"
+#include "GL/ReadbackRing.hpp"
+#include "GL/RenderTarget.hpp"
+#include "GL/Shader.hpp"
 #include "GL/ShaderProgram.hpp"
+#include "GL/StreamBuffer.hpp"
 #include "GL/Vbo.hpp"
 #include "Renderer.hpp"
 #include "Util/Uuid.hpp"
@@ -38,9 +53,26 @@ namespace game_engine::gl {
 class GLRenderer : public Renderer<GLRenderer, GLWindowManager> {
  public:
   void Init(const std::string program_name);
+  /**
+   * @brief Set up GL state and the shader programs on the current context.
+   *        Init calls it once it has created the window's context; tests
+   *        call it on a context of their own.
+   */
+  void InitContext();
   void UseShader(const ShaderPrograms shader_program) const;
+  /**
+   * @brief Whether a shader program has finished compiling, without blocking
+   */
+  bool IsShaderReady(const ShaderPrograms shader_program) const;
+  /**
+   * @brief Finish every shader program the driver is done compiling
+   */
+  void PollShaders() const;
 
   void Render(const VboHandle vbo_handle, const _3D::Primitive mode) const;
+  void Render(const VboHandle vbo_handle, const _3D::Primitive mode,
+              const std::size_t first_index,
+              const std::size_t index_count) const;
 
   VboHandle GenerateVbo(const ShaderPrograms shader_program,
                         const std::vector<Vertex>& vertices,
@@ -56,6 +88,9 @@ class GLRenderer : public Renderer<GLRenderer, GLWindowManager> {
   void BindTexture(const ShaderPrograms shader_program, const std::string& name,
                    const _3D::Texture& texture,
                    const GLuint texture_unit) const;
+  void BindTextureArray(const ShaderPrograms shader_program,
+                        const std::string& name, const unsigned int id,
+                        const GLuint texture_unit) const;
   void BindCubemap(const ShaderPrograms shader_program, const std::string& name,
                    const _3D::Cubemap& cube_map,
                    const GLuint texture_unit) const;
@@ -68,6 +103,20 @@ class GLRenderer : public Renderer<GLRenderer, GLWindowManager> {
   unsigned int CreateTexture(const ShaderPrograms shader_program,
                              const _3D::PixelFormat format,
                              const glm::ivec2 size, const void* pixels) const;
+  unsigned int CreateTexture(const ShaderPrograms shader_program,
+                             const _3D::PixelFormat format,
+                             const _3D::MipChain& mip_chain) const;
+  unsigned int CreateTextureArray(const ShaderPrograms shader_program,
+                                  const _3D::PixelFormat format,
+                                  const glm::ivec3 size, const int mip_levels,
+                                  const _3D::TextureWrap wrap) const;
+  unsigned int CreateTextureArray(const ShaderPrograms shader_program,
+                                  const _3D::PixelFormat format,
+                                  const std::vector<_3D::MipChain>& layers,
+                                  const _3D::TextureWrap wrap) const;
+  void UpdateTextureArray(const unsigned int id, const _3D::PixelFormat format,
+                          const glm::ivec3 offset, const glm::ivec2 size,
+                          const void* pixels, const int level = 0) const;
   unsigned int CreateCubemap(const ShaderPrograms shader_program,
                              const _3D::PixelFormat format,
                              const glm::ivec2 size,
@@ -79,6 +128,49 @@ class GLRenderer : public Renderer<GLRenderer, GLWindowManager> {
   void Clear(glm::vec4 color) const;
   void Swap() const;
 
+  /*  Offscreen render targets  */
+  unsigned int CreateRenderTarget(const _3D::RenderTargetDesc& desc);
+  void DestroyRenderTarget(const unsigned int target);
+  void BindRenderTarget(const unsigned int target) const;
+  void ResolveRenderTarget(const unsigned int target) const;
+  unsigned int GetRenderTargetTexture(const unsigned int target) const;
+  void ReadRenderTargetAsync(const unsigned int target,
+                             _3D::ReadbackCallback callback) const;
+  std::size_t PollReadbacks() const;
+  void FinishReadbacks() const;
+
+  /*  Frame graph backend  */
+  unsigned int CreateTransientTexture(
+      const _3D::TransientTextureDesc& desc) const;
+  void DestroyTransientTexture(const unsigned int id) const;
+  unsigned int CreateTransientBuffer(
+      const _3D::TransientBufferDesc& desc) const;
+  void DestroyTransientBuffer(const unsigned int id) const;
+  void BindFrameTargets(const _3D::FramePassTargets& targets) const;
+  void InsertFrameBarrier(const _3D::FrameBarrier& barrier) const;
+  void BeginPassTimer(const std::string& name) const;
+  void EndPassTimer(const std::string& name) const;
+  double GetPassGpuTime(const std::string& name) const;
+
+  void UploadLightClusters(const ShaderPrograms shader_program,
+                           const _3D::LightClusterData& clusters,
+                           const glm::vec3 ambient) const;
+  void DisableLights(const ShaderPrograms shader_program) const;
+  void Upscale(const unsigned int texture, const glm::vec2 uv_scale,
+               const _3D::UpscaleFilter filter, const float sharpness) const;
+  void DrawSprites(const _2D::SpriteBatch& batch, const glm::mat4& projection,
+                   const ShaderPrograms shader_program) const;
+
+  std::uint32_t AddStaticMesh(const std::vector<Vertex>& vertices,
+                              const std::vector<GLuint>& indices) const;
+  std::uint32_t AddStaticInstance(const std::uint32_t mesh,
+                                  const glm::mat4& model) const;
+  void SetStaticInstanceEnabled(const std::uint32_t instance,
+                                const bool enabled) const;
+  void DrawStaticInstances(const glm::mat4& view,
+                           const glm::mat4& projection) const;
+  std::uint32_t ReadStaticVisibleCount() const;
+
   void SetUniform(const ShaderPrograms shader_program, const std::string& name,
                   const bool value) const;
   void SetUniform(const ShaderPrograms shader_program, const std::string& name,
@@ -109,16 +201,91 @@ class GLRenderer : public Renderer<GLRenderer, GLWindowManager> {
   ShaderProgram* cube_shader_ = nullptr;
   ShaderProgram* skybox_shader_ = nullptr;
   ShaderProgram* text_shader_ = nullptr;
+  ShaderProgram* upscale_shader_ = nullptr;
+  ShaderProgram* indirect_shader_ = nullptr;
+  ShaderProgram* sprite_shader_ = nullptr;
 
   std::map<VboHandle, Vbo> vbos_;
+  ProgramBinaryCache program_cache_{};
 
  private:
   logging::Log log_ = logging::Log("main");
 
  protected:
+  /**
+   * @brief A program submitted to the driver whose status is not checked yet
+   */
+  struct PendingProgram {
+    ShaderProgram* program = nullptr;
+    std::shared_ptr<Shader> vertex{};
+    std::shared_ptr<Shader> fragment{};
+    uint64_t cache_key = 0;
+    std::string name{};
+  };
+
   ShaderProgram* SetupShader(const std::string& vertex,
-                             const std::string& fragment) const;
+                             const std::string& fragment);
+  void FinishProgram(PendingProgram& pending) const;
+  /**
+   * @brief Get a shader program, waiting for it to finish compiling if needed
+   */
   ShaderProgram* GetShader(const ShaderPrograms shader_program) const;
+  ShaderProgram* FindShader(const ShaderPrograms shader_program) const;
+
+  mutable std::vector<PendingProgram> pending_programs_{};
+
+  /**
+   * @brief Frames a pass timer query is given before its result is read
+   */
+  static constexpr std::size_t kPassTimerLatency = 3;
+  struct PassTimer {
+    GLuint queries[kPassTimerLatency] = {};
+    std::size_t frame = 0;
+    double gpu_ms = -1.0;
+  };
+
+  /**
+   * @brief Framebuffer objects by attachments, the color textures followed
+   *        by the depth texture or 0
+   */
+  mutable std::map<std::vector<unsigned int>, GLuint> framebuffers_{};
+  mutable std::map<std::string, PassTimer> pass_timers_{};
+
+  /**
+   * @brief Render targets by handle.  Handle 0 is the window.
+   */
+  std::map<unsigned int, RenderTarget> render_targets_{};
+  unsigned int next_render_target_ = 1;
+  mutable ReadbackRing readbacks_{};
+  /**
+   * @brief Readbacks of the window, queued by Swap just before it presents
+   *        since the back buffer is undefined afterwards
+   */
+  mutable std::vector<_3D::ReadbackCallback> window_readbacks_{};
+
+  /**
+   * @brief Shader storage buffers holding the lights, clusters and light
+   *        indices, at bindings 0, 1 and 2
+   */
+  mutable GLuint light_buffers_[3] = {};
+  /**
+   * @brief Vertex array for draws that build their vertices in the shader
+   */
+  mutable GLuint empty_vao_ = 0;
+  /**
+   * @brief Sprite instances, streamed every DrawSprites
+   */
+  mutable StreamBuffer sprite_buffer_{};
+  mutable GLuint sprite_vao_ = 0;
+  /**
+   * @brief Static instances, built the first time a mesh is added
+   */
+  mutable GpuCuller static_culler_{};
+  mutable bool static_culler_built_ = false;
+  /**
+   * @brief 1x1 white texture sampled by the untextured static instances
+   */
+  mutable GLuint white_texture_ = 0;
 };
 
 } /* namespace game_engine::gl */
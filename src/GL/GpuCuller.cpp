@@ -0,0 +1,348 @@
+/******************************************************************************
+ * GpuCuller.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "GL/GpuCuller.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <string>
+
+#include <cmrc/cmrc.hpp>
+
+#include "3D/Frustum.hpp"
+#include "GL/GLPrimitive.hpp"
+
+CMRC_DECLARE(gl);
+
+namespace game_engine::gl {
+
+namespace {
+
+constexpr GLuint kWorkGroupSize = 64;
+
+/**
+ * @brief Shader storage bindings, matching cull.comp.glsl and
+ *        indirect.vs.glsl.  0 to 2 hold the clustered lights.
+ */
+enum Binding : GLuint {
+  INSTANCES = 3,
+  COMMANDS = 4,
+  VISIBLE = 5,
+  COMPACTED = 6,
+  DRAW_COUNT = 7
+};
+
+/**
+ * @brief Vertex attribute carrying the index of the instance
+ */
+constexpr GLuint kInstanceAttribute = 1;
+
+glm::mat4 NormalMatrix(const glm::mat4& model) {
+  return glm::mat4(glm::transpose(glm::inverse(glm::mat3(model))));
+}
+
+void AddAttribute(const GLuint vao, const GLuint location, const GLint size,
+                  const std::size_t offset) {
+  glVertexArrayAttribFormat(vao, location, size, GL_FLOAT, GL_FALSE,
+                            static_cast<GLuint>(offset));
+  glVertexArrayAttribBinding(vao, location, 0);
+  glEnableVertexArrayAttrib(vao, location);
+}
+
+}  // namespace
+
+bool GpuCuller::Init() {
+  const cmrc::embedded_filesystem fs = cmrc::gl::get_filesystem();
+  const cmrc::file file = fs.open("cull.comp.glsl");
+  shader_ = Shader(std::string(file.begin(), file.end()), ShaderType::COMPUTE);
+  if (!shader_.Init()) {
+    return false;
+  }
+  program_.Init();
+  program_.AttachShader(shader_);
+  if (!program_.Link()) {
+    log_.Error("Failed to build the GPU culling program.");
+    return false;
+  }
+  const GLuint program = program_.GetProgramHandle();
+  pass_location_ = glGetUniformLocation(program, "pass_index");
+  count_location_ = glGetUniformLocation(program, "item_count");
+  planes_location_ = glGetUniformLocation(program, "planes");
+  draw_count_supported_ = GLEW_ARB_indirect_parameters;
+
+  GLuint buffers[8];
+  glCreateBuffers(8, buffers);
+  vertex_buffer_ = buffers[0];
+  index_buffer_ = buffers[1];
+  instance_buffer_ = buffers[2];
+  command_templates_ = buffers[3];
+  commands_ = buffers[4];
+  visible_ = buffers[5];
+  compacted_ = buffers[6];
+  draw_count_ = buffers[7];
+  glNamedBufferData(draw_count_, sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+
+  // Same attribute locations as Vbo, plus the instance index
+  glCreateVertexArrays(1, &vao_);
+  glVertexArrayVertexBuffer(vao_, 0, vertex_buffer_, 0, sizeof(Vertex));
+  glVertexArrayElementBuffer(vao_, index_buffer_);
+  AddAttribute(vao_, 0, 3, offsetof(Vertex, position));
+  AddAttribute(vao_, 2, 3, offsetof(Vertex, normal));
+  AddAttribute(vao_, 3, 4, offsetof(Vertex, color));
+  AddAttribute(vao_, 4, 4, offsetof(Vertex, secondary_color));
+  AddAttribute(vao_, 5, 3, offsetof(Vertex, tangent));
+  AddAttribute(vao_, 6, 3, offsetof(Vertex, bitangent));
+  AddAttribute(vao_, 7, 2, offsetof(Vertex, tex_coord0));
+  AddAttribute(vao_, 8, 2, offsetof(Vertex, tex_coord1));
+  AddAttribute(vao_, 9, 2, offsetof(Vertex, tex_coord2));
+  AddAttribute(vao_, 10, 2, offsetof(Vertex, tex_coord3));
+  AddAttribute(vao_, 11, 2, offsetof(Vertex, tex_coord4));
+  AddAttribute(vao_, 12, 2, offsetof(Vertex, tex_coord5));
+  AddAttribute(vao_, 13, 2, offsetof(Vertex, tex_coord6));
+  AddAttribute(vao_, 14, 2, offsetof(Vertex, tex_coord7));
+  AddAttribute(vao_, 15, 1, offsetof(Vertex, fog_coord));
+  glVertexArrayVertexBuffer(vao_, 1, visible_, 0, sizeof(GLuint));
+  glVertexArrayBindingDivisor(vao_, 1, 1);
+  glVertexArrayAttribIFormat(vao_, kInstanceAttribute, 1, GL_UNSIGNED_INT, 0);
+  glVertexArrayAttribBinding(vao_, kInstanceAttribute, 1);
+  glEnableVertexArrayAttrib(vao_, kInstanceAttribute);
+
+  log_.Debug("GPU culling ready, {} draw count.",
+             draw_count_supported_ ? "with" : "without");
+  return true;
+}
+
+void GpuCuller::Destroy() {
+  if (vao_ == 0) {
+    return;
+  }
+  const GLuint buffers[] = {vertex_buffer_, index_buffer_, instance_buffer_,
+                            command_templates_, commands_, visible_,
+                            compacted_, draw_count_};
+  glDeleteBuffers(8, buffers);
+  glDeleteVertexArrays(1, &vao_);
+  glDeleteProgram(program_.GetProgramHandle());
+  vao_ = 0;
+  vertices_.clear();
+  indices_.clear();
+  meshes_.clear();
+  instances_.clear();
+}
+
+std::uint32_t GpuCuller::AddMesh(const std::vector<Vertex>& vertices,
+                                 const std::vector<GLuint>& indices) {
+  Mesh mesh{};
+  mesh.count = static_cast<GLuint>(indices.size());
+  mesh.first_index = static_cast<GLuint>(indices_.size());
+  mesh.base_vertex = static_cast<GLint>(vertices_.size());
+  mesh.bounds = _3D::Aabb::FromVertices(vertices);
+  vertices_.insert(vertices_.end(), vertices.begin(), vertices.end());
+  indices_.insert(indices_.end(), indices.begin(), indices.end());
+  meshes_.push_back(mesh);
+  geometry_dirty_ = true;
+  layout_dirty_ = true;
+  return static_cast<std::uint32_t>(meshes_.size() - 1);
+}
+
+std::uint32_t GpuCuller::AddInstance(const std::uint32_t mesh,
+                                     const glm::mat4& model) {
+  GpuInstance instance{};
+  instance.model = model;
+  instance.normal_model = NormalMatrix(model);
+  instance.info = glm::uvec4(mesh, 1u, 0u, 0u);
+  UpdateBounds(instance);
+  instances_.push_back(instance);
+  meshes_[mesh].instances++;
+  layout_dirty_ = true;
+  return static_cast<std::uint32_t>(instances_.size() - 1);
+}
+
+void GpuCuller::SetTransform(const std::uint32_t instance,
+                             const glm::mat4& model) {
+  instances_[instance].model = model;
+  instances_[instance].normal_model = NormalMatrix(model);
+  UpdateBounds(instances_[instance]);
+  MarkDirty(instance);
+}
+
+void GpuCuller::SetEnabled(const std::uint32_t instance, const bool enabled) {
+  instances_[instance].info.y = enabled ? 1u : 0u;
+  MarkDirty(instance);
+}
+
+void GpuCuller::MarkDirty(const std::uint32_t instance) {
+  if (dirty_begin_ == dirty_end_) {
+    dirty_begin_ = instance;
+    dirty_end_ = instance + 1;
+    return;
+  }
+  dirty_begin_ = std::min<std::size_t>(dirty_begin_, instance);
+  dirty_end_ = std::max<std::size_t>(dirty_end_, instance + 1);
+}
+
+void GpuCuller::UpdateBounds(GpuInstance& instance) const {
+  const _3D::Aabb& bounds = meshes_[instance.info.x].bounds;
+  const glm::vec3 center = bounds.Center();
+  const glm::vec3 extents = bounds.Extents();
+  const glm::mat4& m = instance.model;
+  // The world box of a transformed box, as in Aabb::Transform
+  instance.center = m * glm::vec4(center, 1.0f);
+  for (int i = 0; i < 3; i++) {
+    instance.extents[i] = std::abs(m[0][i]) * extents.x +
+                          std::abs(m[1][i]) * extents.y +
+                          std::abs(m[2][i]) * extents.z;
+  }
+}
+
+void GpuCuller::Upload() {
+  if (geometry_dirty_) {
+    glNamedBufferData(
+        vertex_buffer_,
+        static_cast<GLsizeiptr>(vertices_.size() * sizeof(Vertex)),
+        vertices_.data(), GL_STATIC_DRAW);
+    glNamedBufferData(index_buffer_,
+                      static_cast<GLsizeiptr>(indices_.size() * sizeof(GLuint)),
+                      indices_.data(), GL_STATIC_DRAW);
+    geometry_dirty_ = false;
+  }
+
+  const GLsizeiptr instance_bytes =
+      static_cast<GLsizeiptr>(instances_.size() * sizeof(GpuInstance));
+  if (layout_dirty_) {
+    // Give each mesh a range of the visible list large enough for all its
+    // instances
+    std::vector<DrawCommand> commands(meshes_.size());
+    GLuint base_instance = 0;
+    for (std::size_t i = 0; i < meshes_.size(); i++) {
+      commands[i].count = meshes_[i].count;
+      commands[i].first_index = meshes_[i].first_index;
+      commands[i].base_vertex = meshes_[i].base_vertex;
+      commands[i].base_instance = base_instance;
+      base_instance += meshes_[i].instances;
+    }
+    const GLsizeiptr command_bytes =
+        static_cast<GLsizeiptr>(commands.size() * sizeof(DrawCommand));
+    glNamedBufferData(command_templates_, command_bytes, commands.data(),
+                      GL_STATIC_DRAW);
+    glNamedBufferData(commands_, command_bytes, nullptr, GL_DYNAMIC_COPY);
+    glNamedBufferData(compacted_, command_bytes, nullptr, GL_DYNAMIC_COPY);
+    glNamedBufferData(visible_,
+                      static_cast<GLsizeiptr>(instances_.size() *
+                                              sizeof(GLuint)),
+                      nullptr, GL_DYNAMIC_COPY);
+    glNamedBufferData(instance_buffer_, instance_bytes, instances_.data(),
+                      GL_STATIC_DRAW);
+    layout_dirty_ = false;
+    dirty_begin_ = dirty_end_ = 0;
+  } else if (dirty_begin_ != dirty_end_) {
+    glNamedBufferSubData(
+        instance_buffer_,
+        static_cast<GLintptr>(dirty_begin_ * sizeof(GpuInstance)),
+        static_cast<GLsizeiptr>((dirty_end_ - dirty_begin_) *
+                                sizeof(GpuInstance)),
+        instances_.data() + dirty_begin_);
+    dirty_begin_ = dirty_end_ = 0;
+  }
+}
+
+void GpuCuller::Cull(const glm::mat4& view_projection) {
+  if (vao_ == 0) {
+    return;
+  }
+  Upload();
+  if (instances_.empty()) {
+    return;
+  }
+  const GLuint mesh_count = static_cast<GLuint>(meshes_.size());
+  const GLuint instance_count = static_cast<GLuint>(instances_.size());
+  glCopyNamedBufferSubData(
+      command_templates_, commands_, 0, 0,
+      static_cast<GLsizeiptr>(mesh_count * sizeof(DrawCommand)));
+  glClearNamedBufferData(draw_count_, GL_R32UI, GL_RED_INTEGER,
+                         GL_UNSIGNED_INT, nullptr);
+
+  const _3D::Frustum frustum(view_projection);
+  glm::vec4 planes[_3D::Frustum::COUNT];
+  for (int i = 0; i < _3D::Frustum::COUNT; i++) {
+    planes[i] = frustum.GetPlane(static_cast<_3D::Frustum::Plane>(i));
+  }
+  const GLuint program = program_.GetProgramHandle();
+  glProgramUniform4fv(program, planes_location_, _3D::Frustum::COUNT,
+                      &planes[0][0]);
+  glUseProgram(program);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCES, instance_buffer_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMANDS, commands_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VISIBLE, visible_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMPACTED, compacted_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_COUNT, draw_count_);
+
+  glProgramUniform1ui(program, pass_location_, 0);
+  glProgramUniform1ui(program, count_location_, instance_count);
+  glDispatchCompute((instance_count + kWorkGroupSize - 1) / kWorkGroupSize, 1,
+                    1);
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  glProgramUniform1ui(program, pass_location_, 1);
+  glProgramUniform1ui(program, count_location_, mesh_count);
+  glDispatchCompute((mesh_count + kWorkGroupSize - 1) / kWorkGroupSize, 1, 1);
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT |
+                  GL_SHADER_STORAGE_BARRIER_BIT |
+                  GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+void GpuCuller::Draw(const _3D::Primitive mode) const {
+  if (vao_ == 0 || instances_.empty()) {
+    return;
+  }
+  const GLenum primitive = static_cast<GLenum>(Convert(mode));
+  const GLsizei mesh_count = static_cast<GLsizei>(meshes_.size());
+  glBindVertexArray(vao_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCES, instance_buffer_);
+  if (draw_count_supported_) {
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, compacted_);
+    glBindBuffer(GL_PARAMETER_BUFFER_ARB, draw_count_);
+    glMultiDrawElementsIndirectCountARB(primitive, GL_UNSIGNED_INT, nullptr, 0,
+                                        mesh_count, 0);
+    glBindBuffer(GL_PARAMETER_BUFFER_ARB, 0);
+  } else {
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands_);
+    glMultiDrawElementsIndirect(primitive, GL_UNSIGNED_INT, nullptr,
+                                mesh_count, 0);
+  }
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  glBindVertexArray(0);
+}
+
+std::uint32_t GpuCuller::ReadVisibleCount() const {
+  if (vao_ == 0 || instances_.empty()) {
+    return 0;
+  }
+  std::vector<DrawCommand> commands(meshes_.size());
+  glGetNamedBufferSubData(
+      commands_, 0,
+      static_cast<GLsizeiptr>(commands.size() * sizeof(DrawCommand)),
+      commands.data());
+  std::uint32_t visible = 0;
+  for (const DrawCommand& command : commands) {
+    visible += command.instance_count;
+  }
+  return visible;
+}
+
+} /* namespace game_engine::gl */
@@ -0,0 +1,199 @@
+/******************************************************************************
+ * GpuCuller.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_GL_GPUCULLER_HPP_
+#define SRC_GL_GPUCULLER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "3D/BoundingVolume.hpp"
+#include "3D/Primitive.hpp"
+#include "GL/Shader.hpp"
+#include "GL/ShaderProgram.hpp"
+#include "LoggerV2/Log.hpp"
+#include "Vertex.hpp"
+
+namespace game_engine::gl {
+
+/**
+ * @brief GPU-driven frustum culling and drawing of many static instances
+ *
+ * Meshes are appended to one shared vertex and index buffer, and instances
+ * (a mesh and a transform) to a shader storage buffer.  Cull runs a compute
+ * shader that tests every instance against the frustum, writes the visible
+ * ones into the instance range of their mesh, and then compacts the
+ * per-mesh DrawElementsIndirectCommands of meshes with anything visible.
+ * Draw issues all of them with a single glMultiDrawElementsIndirectCount,
+ * with ShaderPrograms::INDIRECT reading each instance's transform from the
+ * storage buffer.  Once uploaded, a static world costs the CPU a handful of
+ * GL calls per frame however many objects it has.
+ *
+ * Without GL_ARB_indirect_parameters (GL 4.5 drivers may lack it) every
+ * mesh's command is drawn, those with no visible instances being empty.
+ * Buffers at shader storage bindings 3 to 7 are replaced by Cull and Draw.
+ */
+class GpuCuller {
+ public:
+  GpuCuller() = default;
+  GpuCuller(const GpuCuller&) = delete;
+  GpuCuller& operator=(const GpuCuller&) = delete;
+
+  /**
+   * @brief Build the compute program and create the buffers.  Needs a
+   *        current GL 4.5 context.
+   * @return Returns false if the compute shader failed to build
+   */
+  bool Init();
+  void Destroy();
+
+  /**
+   * @brief Append a mesh to the shared geometry
+   * @return Returns the id of the mesh
+   */
+  std::uint32_t AddMesh(const std::vector<Vertex>& vertices,
+                        const std::vector<GLuint>& indices);
+  /**
+   * @brief Add an instance of a mesh
+   * @return Returns the id of the instance
+   */
+  std::uint32_t AddInstance(const std::uint32_t mesh, const glm::mat4& model);
+  void SetTransform(const std::uint32_t instance, const glm::mat4& model);
+  /**
+   * @brief Exclude an instance from culling and drawing without changing the
+   *        ids of the others
+   */
+  void SetEnabled(const std::uint32_t instance, const bool enabled);
+
+  /**
+   * @brief Upload what changed and cull every instance on the GPU
+   */
+  void Cull(const glm::mat4& view_projection);
+  /**
+   * @brief Draw the instances that passed the last Cull.  The caller binds
+   *        ShaderPrograms::INDIRECT and sets its view and projection.
+   */
+  void Draw(const _3D::Primitive mode = _3D::Primitive::TRIANGLES) const;
+
+  /**
+   * @brief Number of instances that passed the last Cull.  Waits for the
+   *        GPU, so only meant for tests and debugging.
+   */
+  std::uint32_t ReadVisibleCount() const;
+
+  std::size_t GetMeshCount() const { return meshes_.size(); }
+  std::size_t GetInstanceCount() const { return instances_.size(); }
+  /**
+   * @brief Whether Draw skips the commands of meshes with nothing visible
+   */
+  bool HasDrawCount() const { return draw_count_supported_; }
+
+ protected:
+  struct Mesh {
+    GLuint count = 0;
+    GLuint first_index = 0;
+    GLint base_vertex = 0;
+    _3D::Aabb bounds{};
+    GLuint instances = 0;
+  };
+  /**
+   * @brief Layout of an instance in the storage buffer, see cull.comp.glsl
+   */
+  struct GpuInstance {
+    glm::mat4 model = glm::mat4(1.0f);
+    /**
+     * @brief Inverse transpose of model, padded to a mat4 for std430
+     */
+    glm::mat4 normal_model = glm::mat4(1.0f);
+    glm::vec4 center{0.0f};
+    glm::vec4 extents{0.0f};
+    /**
+     * @brief Mesh and whether the instance is enabled
+     */
+    glm::uvec4 info{0u};
+  };
+  /**
+   * @brief Layout of DrawElementsIndirectCommand
+   */
+  struct DrawCommand {
+    GLuint count = 0;
+    GLuint instance_count = 0;
+    GLuint first_index = 0;
+    GLint base_vertex = 0;
+    GLuint base_instance = 0;
+  };
+
+  /**
+   * @brief Bring the buffers up to date with the CPU copies
+   */
+  void Upload();
+  void UpdateBounds(GpuInstance& instance) const;
+  void MarkDirty(const std::uint32_t instance);
+
+  Shader shader_{};
+  ShaderProgram program_{};
+  GLint pass_location_ = -1;
+  GLint count_location_ = -1;
+  GLint planes_location_ = -1;
+  bool draw_count_supported_ = false;
+
+  GLuint vao_ = 0;
+  GLuint vertex_buffer_ = 0;
+  GLuint index_buffer_ = 0;
+  GLuint instance_buffer_ = 0;
+  /**
+   * @brief The per-mesh commands with no instances, copied over commands_
+   *        before every Cull
+   */
+  GLuint command_templates_ = 0;
+  GLuint commands_ = 0;
+  /**
+   * @brief Indices of the visible instances, grouped by mesh.  Read by the
+   *        vertex shader as an instanced attribute.
+   */
+  GLuint visible_ = 0;
+  GLuint compacted_ = 0;
+  GLuint draw_count_ = 0;
+
+  std::vector<Vertex> vertices_{};
+  std::vector<GLuint> indices_{};
+  std::vector<Mesh> meshes_{};
+  std::vector<GpuInstance> instances_{};
+  bool geometry_dirty_ = false;
+  /**
+   * @brief Instances were added, so the commands and buffer sizes change
+   */
+  bool layout_dirty_ = false;
+  /**
+   * @brief Range of instances changed since the last upload
+   */
+  std::size_t dirty_begin_ = 0;
+  std::size_t dirty_end_ = 0;
+
+ private:
+  logging::Log log_ = logging::Log("main");
+};
+
+} /* namespace game_engine::gl */
+
+#endif /* SRC_GL_GPUCULLER_HPP_ */
@@ -0,0 +1,100 @@
+/******************************************************************************
+ * ProgramBinaryCache.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "GL/ProgramBinaryCache.hpp"
+
+#include <cstring>
+#include <optional>
+
+#include "LoggerV2/Log.hpp"
+
+#include "Util/Hash.hpp"
+
+namespace game_engine::gl {
+
+namespace {
+
+std::string GetGlString(const GLenum name) {
+  const GLubyte* str = glGetString(name);
+  return (str == nullptr) ? "" : reinterpret_cast<const char*>(str);
+}
+
+}  // namespace
+
+void ProgramBinaryCache::Init() {
+  GLint formats = 0;
+  if (GLEW_ARB_get_program_binary) {
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  }
+  supported_ = (formats > 0) && cache_.IsEnabled();
+  driver_ = GetGlString(GL_VENDOR) + "\n" + GetGlString(GL_RENDERER) + "\n" +
+            GetGlString(GL_VERSION);
+  log_.Debug("Program binary cache {} ({} binary formats, directory {}).",
+             supported_ ? "enabled" : "disabled", formats,
+             cache_.GetDirectory().string());
+}
+
+uint64_t ProgramBinaryCache::Key(
+    const std::vector<std::string>& sources) const {
+  util::Hasher hasher;
+  hasher.Add(driver_);
+  for (const auto& source : sources) {
+    hasher.Add(source);
+  }
+  return hasher.Get();
+}
+
+bool ProgramBinaryCache::Load(const uint64_t key,
+                              ShaderProgram* program) const {
+  if (!supported_) {
+    return false;
+  }
+  std::optional<std::vector<uint8_t>> blob = cache_.Load(key);
+  if (!blob || blob->size() <= sizeof(GLenum)) {
+    return false;
+  }
+
+  ShaderProgram::Binary binary;
+  std::memcpy(&binary.format, blob->data(), sizeof(GLenum));
+  binary.data.assign(blob->begin() + sizeof(GLenum), blob->end());
+  if (!program->LoadBinary(binary)) {
+    cache_.Remove(key);
+    return false;
+  }
+  return true;
+}
+
+void ProgramBinaryCache::Store(const uint64_t key,
+                               const ShaderProgram& program) const {
+  if (!supported_) {
+    return;
+  }
+  std::optional<ShaderProgram::Binary> binary = program.GetBinary();
+  if (!binary) {
+    return;
+  }
+  std::vector<uint8_t> blob(sizeof(GLenum) + binary->data.size());
+  std::memcpy(blob.data(), &binary->format, sizeof(GLenum));
+  std::memcpy(blob.data() + sizeof(GLenum), binary->data.data(),
+              binary->data.size());
+  cache_.Store(key, blob);
+}
+
+} /* namespace game_engine::gl */
@@ -0,0 +1,83 @@
+/******************************************************************************
+ * ProgramBinaryCache.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_GL_PROGRAMBINARYCACHE_HPP_
+#define SRC_GL_PROGRAMBINARYCACHE_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "LoggerV2/Log.hpp"
+
+#include "GL/ShaderProgram.hpp"
+#include "Util/BlobCache.hpp"
+
+namespace game_engine::gl {
+
+/**
+ * @brief On-disk cache of linked program binaries
+ *
+ * Entries are keyed by the shader sources together with the driver vendor,
+ * renderer and version strings, so a driver update or a different GPU misses
+ * the cache rather than feeding the driver an incompatible binary.
+ */
+class ProgramBinaryCache {
+ public:
+  ProgramBinaryCache() = default;
+
+  /**
+   * @brief Query driver support and identity.  Needs a current GL context.
+   */
+  void Init();
+
+  /**
+   * @brief Compute the cache key of a program
+   * @param sources Every source (including any defines prepended to it) that
+   *                makes up the program, in a stable order
+   */
+  uint64_t Key(const std::vector<std::string>& sources) const;
+
+  /**
+   * @brief Try to initialize a program from the cache
+   * @return Returns true if the program was loaded and is ready to use
+   */
+  bool Load(const uint64_t key, ShaderProgram* program) const;
+  /**
+   * @brief Save the binary of a freshly linked program
+   */
+  void Store(const uint64_t key, const ShaderProgram& program) const;
+
+  bool IsSupported() const { return supported_; }
+
+ protected:
+  util::BlobCache cache_{util::BlobCache::UserCacheDirectory() / "shaders",
+                         true};
+  bool supported_ = false;
+  std::string driver_{};
+
+ private:
+  logging::Log log_ = logging::Log("main");
+};
+
+} /* namespace game_engine::gl */
+
+#endif /* SRC_GL_PROGRAMBINARYCACHE_HPP_ */
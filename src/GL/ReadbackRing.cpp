@@ -0,0 +1,152 @@
+/******************************************************************************
+ * ReadbackRing.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "GL/ReadbackRing.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include <GL/glew.h>
+
+namespace game_engine::gl {
+
+namespace {
+
+constexpr std::size_t kBytesPerPixel = 4;
+
+}  // namespace
+
+void ReadbackRing::Request(const GLuint framebuffer, const glm::ivec2 size,
+                           _3D::ReadbackCallback callback) {
+  const std::size_t bytes = static_cast<std::size_t>(size.x) *
+                            static_cast<std::size_t>(size.y) * kBytesPerPixel;
+  const std::size_t slot = AcquireSlot(bytes);
+
+  GLint previous_read = 0;
+  glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_read);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+  glReadBuffer(framebuffer == 0 ? GL_BACK : GL_COLOR_ATTACHMENT0);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slots_[slot].pbo);
+  glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(previous_read));
+
+  Pending pending;
+  pending.slot = slot;
+  pending.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  pending.size = size;
+  pending.callback = std::move(callback);
+  pending_.push_back(std::move(pending));
+}
+
+std::size_t ReadbackRing::Poll() {
+  std::size_t delivered = 0;
+  /*  Fences signal in submission order, so stop at the first busy one  */
+  while (!pending_.empty()) {
+    const GLenum status = glClientWaitSync(pending_.front().fence,
+                                           GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) {
+      break;
+    }
+    Pending pending = std::move(pending_.front());
+    pending_.pop_front();
+    Deliver(pending);
+    delivered++;
+  }
+  return delivered;
+}
+
+void ReadbackRing::Finish() {
+  while (!pending_.empty()) {
+    Pending pending = std::move(pending_.front());
+    pending_.pop_front();
+    glClientWaitSync(pending.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                     GL_TIMEOUT_IGNORED);
+    Deliver(pending);
+  }
+}
+
+void ReadbackRing::Destroy() {
+  for (Pending& pending : pending_) {
+    glDeleteSync(pending.fence);
+  }
+  pending_.clear();
+  for (Slot& slot : slots_) {
+    glDeleteBuffers(1, &slot.pbo);
+  }
+  slots_.clear();
+}
+
+std::size_t ReadbackRing::AcquireSlot(const std::size_t bytes) {
+  std::size_t index = slots_.size();
+  for (std::size_t i = 0; i < slots_.size(); i++) {
+    if (!slots_[i].busy) {
+      index = i;
+      break;
+    }
+  }
+  if (index == slots_.size()) {
+    slots_.emplace_back();
+  }
+
+  Slot& slot = slots_[index];
+  if (slot.pbo == 0) {
+    glCreateBuffers(1, &slot.pbo);
+  }
+  if (slot.capacity < bytes) {
+    glNamedBufferData(slot.pbo, static_cast<GLsizeiptr>(bytes), nullptr,
+                      GL_STREAM_READ);
+    slot.capacity = bytes;
+  }
+  slot.busy = true;
+  return index;
+}
+
+void ReadbackRing::Deliver(Pending& pending) {
+  glDeleteSync(pending.fence);
+  Slot& slot = slots_[pending.slot];
+
+  _3D::ReadbackResult result;
+  result.size = pending.size;
+  const std::size_t row = static_cast<std::size_t>(pending.size.x) *
+                          kBytesPerPixel;
+  const std::size_t rows = static_cast<std::size_t>(pending.size.y);
+  result.pixels.resize(row * rows);
+
+  const auto* mapped = static_cast<const std::uint8_t*>(glMapNamedBufferRange(
+      slot.pbo, 0, static_cast<GLsizeiptr>(row * rows), GL_MAP_READ_BIT));
+  if (mapped != nullptr) {
+    /*  GL rows start at the bottom, results start at the top  */
+    for (std::size_t y = 0; y < rows; y++) {
+      std::memcpy(result.pixels.data() + y * row,
+                  mapped + (rows - 1 - y) * row, row);
+    }
+    glUnmapNamedBuffer(slot.pbo);
+  }
+  slot.busy = false;
+
+  if (pending.callback) {
+    pending.callback(result);
+  }
+}
+
+} /* namespace game_engine::gl */
@@ -0,0 +1,99 @@
+/******************************************************************************
+ * ReadbackRing.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_GL_READBACKRING_HPP_
+#define SRC_GL_READBACKRING_HPP_
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "3D/RenderTarget.hpp"
+
+namespace game_engine::gl {
+
+/**
+ * @brief Reads framebuffers back to the CPU without stalling the pipeline
+ *
+ * Each request copies the framebuffer into a pixel buffer object and places a
+ * fence behind the copy.  Poll checks the fences without waiting and hands the
+ * pixels of finished copies to their callbacks, oldest first.  Buffers are
+ * reused once their readback completes, and a new one is only created when
+ * every buffer is still in flight.
+ */
+class ReadbackRing {
+ public:
+  ReadbackRing() = default;
+  ReadbackRing(const ReadbackRing&) = delete;
+  ReadbackRing& operator=(const ReadbackRing&) = delete;
+
+  /**
+   * @brief Queue a copy of the color attachment 0 of a framebuffer
+   * @param framebuffer Framebuffer to read, 0 for the window.  The window's
+   *                    back buffer is copied immediately, so it has to be
+   *                    requested after the frame is drawn and before it is
+   *                    swapped.
+   * @param size Size of the area to read, starting at the origin
+   * @param callback Called by Poll once the pixels are available
+   */
+  void Request(const GLuint framebuffer, const glm::ivec2 size,
+               _3D::ReadbackCallback callback);
+  /**
+   * @brief Deliver every readback the GPU has finished, without blocking
+   * @return Returns the number of callbacks invoked
+   */
+  std::size_t Poll();
+  /**
+   * @brief Wait for and deliver every pending readback
+   */
+  void Finish();
+  /**
+   * @brief Drop pending readbacks and delete every buffer
+   */
+  void Destroy();
+
+  std::size_t GetPendingCount() const { return pending_.size(); }
+  std::size_t GetBufferCount() const { return slots_.size(); }
+
+ protected:
+  struct Slot {
+    GLuint pbo = 0;
+    std::size_t capacity = 0;
+    bool busy = false;
+  };
+  struct Pending {
+    std::size_t slot = 0;
+    GLsync fence = nullptr;
+    glm::ivec2 size{0, 0};
+    _3D::ReadbackCallback callback{};
+  };
+
+  std::size_t AcquireSlot(const std::size_t bytes);
+  void Deliver(Pending& pending);
+
+  std::vector<Slot> slots_{};
+  std::deque<Pending> pending_{};
+};
+
+} /* namespace game_engine::gl */
+
+#endif /* SRC_GL_READBACKRING_HPP_ */
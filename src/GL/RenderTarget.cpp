@@ -0,0 +1,102 @@
+/******************************************************************************
+ * RenderTarget.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "GL/RenderTarget.hpp"
+
+#include <stdexcept>
+
+#include <GL/glew.h>
+
+namespace game_engine::gl {
+
+void RenderTarget::Init(const _3D::RenderTargetDesc& desc) {
+  desc_ = desc;
+  multisampled_ = desc.samples > 1;
+
+  glCreateTextures(GL_TEXTURE_2D, 1, &color_texture_);
+  glTextureParameteri(color_texture_, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTextureParameteri(color_texture_, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTextureParameteri(color_texture_, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTextureParameteri(color_texture_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTextureStorage2D(color_texture_, 1,
+                     static_cast<GLenum>(desc.color_format.i_format),
+                     desc.size.x, desc.size.y);
+
+  glCreateFramebuffers(1, &fbo_);
+  if (multisampled_) {
+    glCreateRenderbuffers(1, &color_renderbuffer_);
+    glNamedRenderbufferStorageMultisample(
+        color_renderbuffer_, desc.samples,
+        static_cast<GLenum>(desc.color_format.i_format), desc.size.x,
+        desc.size.y);
+    glNamedFramebufferRenderbuffer(fbo_, GL_COLOR_ATTACHMENT0,
+                                   GL_RENDERBUFFER, color_renderbuffer_);
+
+    glCreateFramebuffers(1, &resolve_fbo_);
+    glNamedFramebufferTexture(resolve_fbo_, GL_COLOR_ATTACHMENT0,
+                              color_texture_, 0);
+  } else {
+    glNamedFramebufferTexture(fbo_, GL_COLOR_ATTACHMENT0, color_texture_, 0);
+  }
+
+  if (desc.depth) {
+    glCreateRenderbuffers(1, &depth_renderbuffer_);
+    glNamedRenderbufferStorageMultisample(
+        depth_renderbuffer_, multisampled_ ? desc.samples : 0,
+        GL_DEPTH24_STENCIL8, desc.size.x, desc.size.y);
+    glNamedFramebufferRenderbuffer(fbo_, GL_DEPTH_STENCIL_ATTACHMENT,
+                                   GL_RENDERBUFFER, depth_renderbuffer_);
+  }
+
+  if (glCheckNamedFramebufferStatus(fbo_, GL_FRAMEBUFFER) !=
+      GL_FRAMEBUFFER_COMPLETE) {
+    Destroy();
+    throw std::runtime_error("Render target framebuffer is incomplete");
+  }
+}
+
+void RenderTarget::Destroy() {
+  glDeleteFramebuffers(1, &fbo_);
+  glDeleteFramebuffers(1, &resolve_fbo_);
+  glDeleteRenderbuffers(1, &color_renderbuffer_);
+  glDeleteRenderbuffers(1, &depth_renderbuffer_);
+  glDeleteTextures(1, &color_texture_);
+  fbo_ = 0;
+  resolve_fbo_ = 0;
+  color_renderbuffer_ = 0;
+  depth_renderbuffer_ = 0;
+  color_texture_ = 0;
+}
+
+void RenderTarget::Bind() const {
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+  glViewport(0, 0, desc_.size.x, desc_.size.y);
+}
+
+void RenderTarget::Resolve() const {
+  if (!multisampled_) {
+    return;
+  }
+  glBlitNamedFramebuffer(fbo_, resolve_fbo_, 0, 0, desc_.size.x,
+                         desc_.size.y, 0, 0, desc_.size.x, desc_.size.y,
+                         GL_COLOR_BUFFER_BIT, GL_NEAREST);
+}
+
+} /* namespace game_engine::gl */
@@ -0,0 +1,77 @@
+/******************************************************************************
+ * RenderTarget.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_GL_RENDERTARGET_HPP_
+#define SRC_GL_RENDERTARGET_HPP_
+
+#include <ostream>
+
+#include <GL/glew.h>
+
+#include "3D/RenderTarget.hpp"
+
+namespace game_engine::gl {
+
+/**
+ * @brief Framebuffer with a color texture and optional depth attachment
+ *
+ * Multisampled targets render into multisampled renderbuffers and are
+ * resolved into the color texture by Resolve.
+ */
+class RenderTarget {
+ public:
+  void Init(const _3D::RenderTargetDesc& desc);
+  void Destroy();
+  void Bind() const;
+  /**
+   * @brief Resolve the multisampled attachments into the color texture.
+   *        Does nothing for single sampled targets.
+   */
+  void Resolve() const;
+  /**
+   * @brief Framebuffer whose color attachment is the color texture
+   */
+  GLuint GetResolveFramebuffer() const {
+    return multisampled_ ? resolve_fbo_ : fbo_;
+  }
+
+ public:
+  _3D::RenderTargetDesc desc_{};
+  GLuint fbo_ = 0;
+  GLuint color_texture_ = 0;
+  GLuint depth_renderbuffer_ = 0;
+
+ protected:
+  bool multisampled_ = false;
+  GLuint color_renderbuffer_ = 0;
+  GLuint resolve_fbo_ = 0;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const RenderTarget& rt) {
+  return os << "RenderTarget {\n"
+            << "_3D::RenderTargetDesc desc_ = " << rt.desc_ << "\n"
+            << "GLuint fbo_ = " << static_cast<unsigned int>(rt.fbo_) << "\n"
+            << "GLuint color_texture_ = "
+            << static_cast<unsigned int>(rt.color_texture_) << "\n"
+            << "}";
+}
+
+} /* namespace game_engine::gl */
+
+#endif /* SRC_GL_RENDERTARGET_HPP_ */
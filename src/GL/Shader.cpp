@@ -33,22 +33,52 @@ Shader::Shader(std::string _source, ShaderType _type)
     : source(_source), type(_type), shader(0), valid(false) {}
 
 Shader::~Shader() noexcept {
-  if (isValid()) {
+  if (isValid() || compiling) {
     log_.CAPTURE(shader);
     glDeleteShader(shader);
   }
   valid = false;
+  compiling = false;
 }
 
 bool Shader::Init() {
   if (isValid()) {
     return isValid();
   }
+  Compile();
+  return CheckCompile();
+}
+
+bool Shader::Compile() {
+  if (isValid() || compiling) {
+    return true;
+  }
   shader = glCreateShader(static_cast<GLenum>(type));
 
   const char* c_str = source.c_str();
   glShaderSource(shader, 1, &c_str, NULL);
   glCompileShader(shader);
+  return (compiling = true);
+}
+
+bool Shader::IsCompileComplete() const {
+  if (!compiling || !parallel_compile_) {
+    return true;
+  }
+#ifdef GL_KHR_parallel_shader_compile
+  GLint complete = GL_FALSE;
+  glGetShaderiv(shader, GL_COMPLETION_STATUS_KHR, &complete);
+  return (complete == GL_TRUE);
+#else
+  return true;
+#endif
+}
+
+bool Shader::CheckCompile() {
+  if (!compiling) {
+    return isValid();
+  }
+  compiling = false;
 
   GLint isCompiled = 0;
   glGetShaderiv(shader, GL_COMPILE_STATUS, &isCompiled);
@@ -73,6 +103,20 @@ bool Shader::Init() {
   return (valid = true);
 }
 
+void Shader::EnableParallelCompile() {
+#ifdef GL_KHR_parallel_shader_compile
+  if (GLEW_KHR_parallel_shader_compile) {
+    // 0xFFFFFFFF lets the driver pick the number of threads
+    glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    parallel_compile_ = true;
+  } else if (GLEW_ARB_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+    parallel_compile_ = true;
+  }
+#endif
+}
+bool Shader::HasParallelCompile() { return parallel_compile_; }
+
 bool Shader::isValid() const { return valid; }
 ShaderType Shader::getShaderType() { return type; }
 GLuint Shader::getShaderHandle() { return shader; }
@@ -74,8 +74,32 @@ class Shader {
         shader(glCreateShader(static_cast<GLenum>(_type))) {}
   Shader(std::string source, ShaderType type);
   ~Shader() noexcept;
+  /**
+   * @brief Compile the shader, blocking until the compile status is known
+   */
   bool Init();
 
+  /**
+   * @brief Submit the shader for compilation without waiting for the result
+   */
+  bool Compile();
+  /**
+   * @brief Whether the driver has finished compiling.  Always true without
+   *        GL_KHR_parallel_shader_compile, in which case CheckCompile blocks.
+   */
+  bool IsCompileComplete() const;
+  /**
+   * @brief Wait for the compile to finish and log any errors
+   */
+  bool CheckCompile();
+
+  /**
+   * @brief Ask the driver for background compiler threads if it supports
+   *        GL_KHR_parallel_shader_compile.  Needs a current GL context.
+   */
+  static void EnableParallelCompile();
+  static bool HasParallelCompile();
+
  public:
   bool isValid() const;
   ShaderType getShaderType();
@@ -87,6 +111,7 @@ class Shader {
     swap(other.type, type);
     swap(other.shader, shader);
     swap(other.valid, valid);
+    swap(other.compiling, compiling);
   }
 
  protected:
@@ -94,6 +119,9 @@ class Shader {
   ShaderType type{};
   GLuint shader{};
   bool valid{};
+  bool compiling{};
+
+  static inline bool parallel_compile_ = false;
 
  private:
   logging::Log log_ = logging::Log("main");
@@ -28,6 +28,8 @@ namespace game_engine::gl {
 
 bool ShaderProgram::Init() {
   program_ = glCreateProgram();
+  // Must be set before linking for the binary to be retrievable afterwards
+  glProgramParameteri(program_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
   return true;
 }
 void ShaderProgram::AttachShader(Shader& shader) {
@@ -39,7 +41,36 @@ bool ShaderProgram::Link() {
   if (IsValid()) {
     return IsValid();
   }
+  LinkAsync();
+  return FinishLink();
+}
+
+bool ShaderProgram::LinkAsync() {
+  if (IsValid() || linking_) {
+    return true;
+  }
   glLinkProgram(program_);
+  return (linking_ = true);
+}
+
+bool ShaderProgram::IsLinkComplete() const {
+  if (!linking_ || !Shader::HasParallelCompile()) {
+    return true;
+  }
+#ifdef GL_KHR_parallel_shader_compile
+  GLint complete = GL_FALSE;
+  glGetProgramiv(program_, GL_COMPLETION_STATUS_KHR, &complete);
+  return (complete == GL_TRUE);
+#else
+  return true;
+#endif
+}
+
+bool ShaderProgram::FinishLink() {
+  if (!linking_) {
+    return IsValid();
+  }
+  linking_ = false;
 
   GLint isLinked = 0;
   glGetProgramiv(program_, GL_LINK_STATUS, (int*)&isLinked);
@@ -62,6 +93,46 @@ bool ShaderProgram::Link() {
   return (valid_ = true);
 }
 
+std::optional<ShaderProgram::Binary> ShaderProgram::GetBinary() const {
+  if (!IsValid()) {
+    return std::nullopt;
+  }
+  GLint length = 0;
+  glGetProgramiv(program_, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) {
+    return std::nullopt;
+  }
+  Binary binary;
+  binary.data.resize(length);
+  GLsizei written = 0;
+  glGetProgramBinary(program_, length, &written, &binary.format,
+                     binary.data.data());
+  if (written <= 0) {
+    return std::nullopt;
+  }
+  binary.data.resize(written);
+  return binary;
+}
+
+bool ShaderProgram::LoadBinary(const Binary& binary) {
+  glProgramBinary(program_, binary.format, binary.data.data(),
+                  static_cast<GLsizei>(binary.data.size()));
+
+  // A driver update or a different GPU makes old binaries invalid, which is
+  // reported as a link failure
+  GLint isLinked = 0;
+  glGetProgramiv(program_, GL_LINK_STATUS, &isLinked);
+  if (isLinked == GL_FALSE) {
+    log_.Debug("Program binary rejected by the driver.");
+    return (valid_ = false);
+  }
+  for (auto& i : shaders_) {
+    glDetachShader(program_, i->getShaderHandle());
+  }
+  shaders_.clear();
+  return (valid_ = true);
+}
+
 bool ShaderProgram::IsValid() const { return valid_; }
 void ShaderProgram::SetValid(bool validity) { valid_ = validity; }
 
@@ -92,6 +163,14 @@ void ShaderProgram::SetFloat(const std::string& name, float value) const {
   Use();
   glUniform1f(glGetUniformLocation(program_, name.c_str()), value);
 }
+void ShaderProgram::SetIVec3(const std::string& name,
+                             const glm::ivec3& value) const {
+  if (!IsValid()) {
+    return;
+  }
+  Use();
+  glUniform3iv(glGetUniformLocation(program_, name.c_str()), 1, &value[0]);
+}
 void ShaderProgram::SetVec2(const std::string& name,
                             const glm::vec2& value) const {
   if (!IsValid()) {
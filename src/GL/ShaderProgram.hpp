@@ -20,7 +20,9 @@
 #ifndef SRC_GL_SHADERPROGRAM_HPP_
 #define SRC_GL_SHADERPROGRAM_HPP_
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <vector>
 
 #include <GL/glew.h>
@@ -44,9 +46,46 @@ class ShaderProgram {
  public:
   void AttachShader(Shader& shader);
 
+  /**
+   * @brief Link the program, blocking until the link status is known
+   */
   bool Link();
   bool Init();
 
+  /**
+   * @brief Submit the attached shaders for linking without waiting
+   */
+  bool LinkAsync();
+  /**
+   * @brief Whether the driver has finished linking.  Always true without
+   *        GL_KHR_parallel_shader_compile, in which case FinishLink blocks.
+   */
+  bool IsLinkComplete() const;
+  /**
+   * @brief Wait for the link to finish, log any errors and detach the shaders
+   */
+  bool FinishLink();
+
+  /**
+   * @brief Linked program binary in a driver specific format
+   */
+  struct Binary {
+    GLenum format = 0;
+    std::vector<uint8_t> data{};
+  };
+  /**
+   * @brief Retrieve the binary of a linked program
+   * @return Returns the binary, or std::nullopt if the driver cannot provide
+   *         one
+   */
+  std::optional<Binary> GetBinary() const;
+  /**
+   * @brief Initialize the program from a binary instead of linking shaders
+   * @return Returns false if the driver rejected the binary, in which case the
+   *         program must be built from source
+   */
+  bool LoadBinary(const Binary& binary);
+
  public:
   bool IsValid() const;
   void SetValid(bool validity = false);
@@ -60,6 +99,7 @@ class ShaderProgram {
   void SetBool(const std::string& name, bool value) const;
   void SetInt(const std::string& name, int value) const;
   void SetFloat(const std::string& name, float value) const;
+  void SetIVec3(const std::string& name, const glm::ivec3& value) const;
   void SetVec2(const std::string& name, const glm::vec2& value) const;
   void SetVec2(const std::string& name, float x, float y) const;
   void SetVec3(const std::string& name, const glm::vec3& value) const;
@@ -75,12 +115,14 @@ class ShaderProgram {
     using std::swap;
     swap(other.program_, program_);
     swap(other.valid_, valid_);
+    swap(other.linking_, linking_);
     swap(other.shaders_, shaders_);
   }
 
  private:
   GLuint program_ = 0;
   bool valid_ = false;
+  bool linking_ = false;
 
   std::vector<Shader*> shaders_{};
   logging::Log log_ = logging::Log("main");
@@ -0,0 +1,119 @@
+/******************************************************************************
+ * SlangCompiler.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "GL/SlangCompiler.hpp"
+
+#include <slang.h>
+
+#include "LoggerV2/Log.hpp"
+
+namespace game_engine::gl {
+
+namespace {
+
+SlangSession* GetSlangSession() {
+  static SlangSession* const slang_session = spCreateSession(NULL);
+  return slang_session;
+}
+
+::SlangStage Convert(const SlangShaderStage stage) {
+  switch (stage) {
+    case SlangShaderStage::VERTEX:
+      return SLANG_STAGE_VERTEX;
+    case SlangShaderStage::FRAGMENT:
+      return SLANG_STAGE_FRAGMENT;
+    case SlangShaderStage::GEOMETRY:
+      return SLANG_STAGE_GEOMETRY;
+    case SlangShaderStage::COMPUTE:
+      return SLANG_STAGE_COMPUTE;
+  }
+  return SLANG_STAGE_NONE;
+}
+
+}  // namespace
+
+std::string SlangCompiler::Version() { return spGetBuildTagString(); }
+
+std::optional<SlangOutputs> SlangCompiler::Compile(
+    const SlangCompileInput& input) const {
+  SlangCompileRequest* request = spCreateCompileRequest(GetSlangSession());
+
+  const int target_index = spAddCodeGenTarget(request, SLANG_GLSL);
+  spSetTargetProfile(request, target_index,
+                     spFindProfile(GetSlangSession(), input.profile.c_str()));
+  for (const auto& path : input.search_paths) {
+    spAddSearchPath(request, path.string().c_str());
+  }
+
+  const int translation_unit_index =
+      spAddTranslationUnit(request, SLANG_SOURCE_LANGUAGE_SLANG, nullptr);
+  spAddTranslationUnitSourceString(request, translation_unit_index,
+                                   input.name.c_str(), input.source.c_str());
+
+  std::vector<int> entry_point_indices;
+  for (const auto& entry_point : input.entry_points) {
+    entry_point_indices.push_back(
+        spAddEntryPoint(request, translation_unit_index,
+                        entry_point.name.c_str(), Convert(entry_point.stage)));
+  }
+
+  const SlangResult result = spCompile(request);
+  if (auto diagnostics = spGetDiagnosticOutput(request);
+      diagnostics != nullptr && diagnostics[0] != '\0') {
+    log_.Error("Slang output for {}:  {}", input.name, diagnostics);
+  }
+  if (SLANG_FAILED(result)) {
+    spDestroyCompileRequest(request);
+    return std::nullopt;
+  }
+
+  SlangOutputs outputs;
+  for (const int index : entry_point_indices) {
+    ISlangBlob* blob = nullptr;
+    if (SLANG_FAILED(spGetEntryPointCodeBlob(request, index, 0, &blob))) {
+      log_.Error("No code generated for entry point {} of {}.", index,
+                 input.name);
+      spDestroyCompileRequest(request);
+      return std::nullopt;
+    }
+    const char* code = static_cast<const char*>(blob->getBufferPointer());
+    outputs.emplace_back(code, code + blob->getBufferSize());
+    blob->release();
+  }
+  spDestroyCompileRequest(request);
+  return outputs;
+}
+
+std::optional<SlangOutputs> SlangCompiler::Compile(
+    const SlangCompileInput& input, const SlangShaderCache& cache) const {
+  const uint64_t key = SlangShaderCache::Key(input, Version());
+  if (auto outputs = cache.Load(key);
+      outputs && outputs->size() == input.entry_points.size()) {
+    log_.Debug("Slang cache hit for {}.", input.name);
+    return outputs;
+  }
+  std::optional<SlangOutputs> outputs = Compile(input);
+  if (outputs) {
+    cache.Store(key, *outputs);
+  }
+  return outputs;
+}
+
+} /* namespace game_engine::gl */
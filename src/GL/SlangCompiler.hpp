@@ -0,0 +1,61 @@
+/******************************************************************************
+ * SlangCompiler.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_GL_SLANGCOMPILER_HPP_
+#define SRC_GL_SLANGCOMPILER_HPP_
+
+#include <optional>
+#include <string>
+
+#include "LoggerV2/Log.hpp"
+
+#include "GL/SlangShaderCache.hpp"
+
+namespace game_engine::gl {
+
+/**
+ * @brief Compiles Slang sources to the code of each requested entry point
+ *
+ * Kept free of any rendering API so the build-time precompiler can share it.
+ */
+class SlangCompiler {
+ public:
+  /**
+   * @brief Compile without consulting any cache
+   */
+  std::optional<SlangOutputs> Compile(const SlangCompileInput& input) const;
+  /**
+   * @brief Return the cached output if there is one, otherwise compile and
+   *        store the result
+   */
+  std::optional<SlangOutputs> Compile(const SlangCompileInput& input,
+                                      const SlangShaderCache& cache) const;
+
+  /**
+   * @brief Build tag of the linked Slang library, part of every cache key
+   */
+  static std::string Version();
+
+ private:
+  logging::Log log_ = logging::Log("main");
+};
+
+} /* namespace game_engine::gl */
+
+#endif /* SRC_GL_SLANGCOMPILER_HPP_ */
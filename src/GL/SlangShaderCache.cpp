@@ -0,0 +1,232 @@
+/******************************************************************************
+ * SlangShaderCache.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "GL/SlangShaderCache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <regex>
+#include <set>
+#include <sstream>
+
+#include "LoggerV2/Log.hpp"
+
+#include "Util/Hash.hpp"
+
+namespace game_engine::gl {
+
+namespace {
+
+std::string ReadFile(const std::filesystem::path& path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+void HashImports(const std::string_view source,
+                 const std::vector<std::filesystem::path>& search_paths,
+                 std::set<std::string>* visited, util::Hasher* hasher) {
+  for (const auto& module : SlangShaderCache::FindImports(source)) {
+    if (!visited->insert(module).second) {
+      continue;
+    }
+    hasher->Add(module);
+    const auto path = SlangShaderCache::ResolveImport(module, search_paths);
+    if (!path) {
+      // Built-in or unresolvable modules only contribute their name
+      continue;
+    }
+    const std::string contents = ReadFile(*path);
+    hasher->Add(contents);
+    HashImports(contents, search_paths, visited, hasher);
+  }
+}
+
+}  // namespace
+
+SlangShaderCache::SlangShaderCache()
+    : cache_(util::BlobCache::UserCacheDirectory() / "slang", true) {
+#ifdef GAME_ENGINE_SLANG_PREBUILT_CACHE
+  prebuilt_.emplace(std::filesystem::path(GAME_ENGINE_SLANG_PREBUILT_CACHE),
+                    false);
+#endif
+}
+
+SlangShaderCache::SlangShaderCache(const std::filesystem::path& directory)
+    : cache_(directory, true) {}
+
+uint64_t SlangShaderCache::Key(const SlangCompileInput& input,
+                               const std::string_view compiler_version) {
+  util::Hasher hasher;
+  hasher.Add(compiler_version);
+  hasher.Add(input.profile);
+  hasher.Add(static_cast<uint64_t>(input.entry_points.size()));
+  for (const auto& entry_point : input.entry_points) {
+    hasher.Add(entry_point.name);
+    hasher.Add(entry_point.stage);
+  }
+  hasher.Add(input.source);
+
+  std::set<std::string> visited;
+  HashImports(input.source, input.search_paths, &visited, &hasher);
+  return hasher.Get();
+}
+
+std::optional<SlangOutputs> SlangShaderCache::Load(const uint64_t key) const {
+  std::optional<std::vector<uint8_t>> blob = cache_.Load(key);
+  if (!blob && prebuilt_) {
+    blob = prebuilt_->Load(key);
+  }
+  if (!blob) {
+    return std::nullopt;
+  }
+  return Deserialize(*blob);
+}
+
+bool SlangShaderCache::Store(const uint64_t key,
+                             const SlangOutputs& outputs) const {
+  return cache_.Store(key, Serialize(outputs));
+}
+
+std::vector<std::filesystem::path> SlangShaderCache::DefaultSearchPaths() {
+  std::vector<std::filesystem::path> search_paths;
+#ifdef GAME_ENGINE_SLANG_SEARCH_PATHS
+  std::istringstream stream{std::string(GAME_ENGINE_SLANG_SEARCH_PATHS)};
+  std::string path;
+  while (std::getline(stream, path, '|')) {
+    if (!path.empty()) {
+      search_paths.emplace_back(path);
+    }
+  }
+#endif
+  return search_paths;
+}
+
+std::vector<std::string> SlangShaderCache::FindImports(
+    const std::string_view source) {
+  // Matches `import a.b;`, `__import a;` and `import "a/b.slang";`
+  static const std::regex import_regex(
+      R"(^\s*(?:__)?import\s+("[^"]+"|[A-Za-z_][A-Za-z0-9_.]*)\s*;)");
+
+  std::vector<std::string> imports;
+  std::istringstream stream{std::string(source)};
+  std::string line;
+  std::smatch match;
+  while (std::getline(stream, line)) {
+    if (std::regex_search(line, match, import_regex)) {
+      std::string module = match[1].str();
+      if (module.front() == '"') {
+        module = module.substr(1, module.size() - 2);
+      }
+      imports.push_back(module);
+    }
+  }
+  return imports;
+}
+
+std::optional<std::filesystem::path> SlangShaderCache::ResolveImport(
+    const std::string& module,
+    const std::vector<std::filesystem::path>& search_paths) {
+  std::vector<std::string> candidates;
+  if (module.find('/') != std::string::npos ||
+      module.find(".slang") != std::string::npos) {
+    candidates.push_back(module);
+  } else {
+    // Slang maps `a.b_c` to `a/b-c.slang`, but also accepts underscores
+    std::string path = module;
+    std::replace(path.begin(), path.end(), '.', '/');
+    candidates.push_back(path + ".slang");
+    std::replace(path.begin(), path.end(), '_', '-');
+    candidates.push_back(path + ".slang");
+  }
+  for (const auto& directory : search_paths) {
+    for (const auto& candidate : candidates) {
+      std::error_code ec;
+      const std::filesystem::path path = directory / candidate;
+      if (std::filesystem::is_regular_file(path, ec)) {
+        return path;
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+std::vector<uint8_t> SlangShaderCache::Serialize(const SlangOutputs& outputs) {
+  std::vector<uint8_t> data;
+  const auto append = [&data](const void* ptr, const std::size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(ptr);
+    data.insert(data.end(), bytes, bytes + size);
+  };
+  const uint64_t count = outputs.size();
+  append(&count, sizeof(count));
+  for (const auto& output : outputs) {
+    const uint64_t size = output.size();
+    append(&size, sizeof(size));
+    append(output.data(), output.size());
+  }
+  return data;
+}
+
+std::optional<SlangOutputs> SlangShaderCache::Deserialize(
+    const std::vector<uint8_t>& data) {
+  std::size_t offset = 0;
+  const auto read = [&data, &offset](void* ptr, const std::size_t size) {
+    if (data.size() - offset < size) {
+      return false;
+    }
+    std::memcpy(ptr, data.data() + offset, size);
+    offset += size;
+    return true;
+  };
+
+  uint64_t count = 0;
+  if (!read(&count, sizeof(count))) {
+    return std::nullopt;
+  }
+  SlangOutputs outputs;
+  for (uint64_t i = 0; i < count; i++) {
+    uint64_t size = 0;
+    if (!read(&size, sizeof(size)) || data.size() - offset < size) {
+      return std::nullopt;
+    }
+    outputs.emplace_back(reinterpret_cast<const char*>(data.data() + offset),
+                         size);
+    offset += size;
+  }
+  return outputs;
+}
+
+std::ostream& operator<<(std::ostream& os, const SlangShaderStage stage) {
+  switch (stage) {
+    case SlangShaderStage::VERTEX:
+      return os << "SlangShaderStage::VERTEX";
+    case SlangShaderStage::FRAGMENT:
+      return os << "SlangShaderStage::FRAGMENT";
+    case SlangShaderStage::GEOMETRY:
+      return os << "SlangShaderStage::GEOMETRY";
+    case SlangShaderStage::COMPUTE:
+      return os << "SlangShaderStage::COMPUTE";
+  }
+  return os;
+}
+
+} /* namespace game_engine::gl */
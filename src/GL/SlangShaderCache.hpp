@@ -0,0 +1,126 @@
+/******************************************************************************
+ * SlangShaderCache.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_GL_SLANGSHADERCACHE_HPP_
+#define SRC_GL_SLANGSHADERCACHE_HPP_
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LoggerV2/Log.hpp"
+
+#include "Util/BlobCache.hpp"
+
+namespace game_engine::gl {
+
+enum class SlangShaderStage : std::uint8_t { VERTEX, FRAGMENT, GEOMETRY, COMPUTE };
+std::ostream& operator<<(std::ostream& os, const SlangShaderStage stage);
+
+struct SlangEntryPoint {
+  std::string name{};
+  SlangShaderStage stage{};
+};
+
+/**
+ * @brief Everything that determines the output of a Slang compile
+ */
+struct SlangCompileInput {
+  /**
+   * @brief Name used in diagnostics
+   */
+  std::string name{};
+  std::string source{};
+  /**
+   * @brief Directories searched for imported modules
+   */
+  std::vector<std::filesystem::path> search_paths{};
+  std::vector<SlangEntryPoint> entry_points{};
+  std::string profile = "glsl_460";
+};
+
+/**
+ * @brief Code generated for each entry point, in entry point order
+ */
+using SlangOutputs = std::vector<std::string>;
+
+/**
+ * @brief Content addressed on-disk cache of Slang compiler output
+ *
+ * The key covers the source, every module it imports (transitively), the
+ * entry points, the target profile and the compiler version.  Lookups check
+ * the user cache first and then the cache precompiled at build time, if one
+ * was configured.
+ */
+class SlangShaderCache {
+ public:
+  SlangShaderCache();
+  /**
+   * @param directory Directory to read and write entries in
+   */
+  explicit SlangShaderCache(const std::filesystem::path& directory);
+
+  /**
+   * @brief Compute the cache key of a compile
+   * @param compiler_version Build tag of the Slang compiler
+   */
+  static uint64_t Key(const SlangCompileInput& input,
+                      const std::string_view compiler_version);
+
+  std::optional<SlangOutputs> Load(const uint64_t key) const;
+  bool Store(const uint64_t key, const SlangOutputs& outputs) const;
+
+  /**
+   * @brief Directories searched for imported modules, both at runtime and by
+   *        SlangPrecompile unless it is given others.  Imported modules are
+   *        part of the key, so both have to resolve them from the same
+   *        directories for precompiled entries to be found.
+   */
+  static std::vector<std::filesystem::path> DefaultSearchPaths();
+
+  /**
+   * @brief Names of the modules imported by a Slang source
+   */
+  static std::vector<std::string> FindImports(const std::string_view source);
+  /**
+   * @brief Locate the file of an imported module
+   */
+  static std::optional<std::filesystem::path> ResolveImport(
+      const std::string& module,
+      const std::vector<std::filesystem::path>& search_paths);
+
+  static std::vector<uint8_t> Serialize(const SlangOutputs& outputs);
+  static std::optional<SlangOutputs> Deserialize(
+      const std::vector<uint8_t>& data);
+
+ protected:
+  util::BlobCache cache_;
+  std::optional<util::BlobCache> prebuilt_{};
+
+ private:
+  logging::Log log_ = logging::Log("main");
+};
+
+} /* namespace game_engine::gl */
+
+#endif /* SRC_GL_SLANGSHADERCACHE_HPP_ */
@@ -0,0 +1,70 @@
+/******************************************************************************
+ * StreamBuffer.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "GL/StreamBuffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace game_engine::gl {
+
+namespace {
+
+constexpr GLsizeiptr kMinCapacity = 1 << 20;
+
+}  // namespace
+
+GLintptr StreamBuffer::Write(const void* data, const GLsizeiptr size,
+                             const GLsizeiptr alignment) {
+  if (buffer_ == 0) {
+    glCreateBuffers(1, &buffer_);
+  }
+  GLintptr offset = (offset_ + alignment - 1) / alignment * alignment;
+  GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+                      GL_MAP_UNSYNCHRONIZED_BIT;
+  if (offset + size > capacity_) {
+    if (size > capacity_) {
+      capacity_ = std::max({size, capacity_ * 2, kMinCapacity});
+      glNamedBufferData(buffer_, capacity_, nullptr, GL_STREAM_DRAW);
+    } else {
+      access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+    }
+    offset = 0;
+  }
+
+  void* destination = glMapNamedBufferRange(buffer_, offset, size, access);
+  if (destination == nullptr) {
+    return -1;
+  }
+  std::memcpy(destination, data, static_cast<std::size_t>(size));
+  glUnmapNamedBuffer(buffer_);
+  offset_ = offset + size;
+  return offset;
+}
+
+void StreamBuffer::Destroy() {
+  if (buffer_ != 0) {
+    glDeleteBuffers(1, &buffer_);
+  }
+  buffer_ = 0;
+  capacity_ = 0;
+  offset_ = 0;
+}
+
+} /* namespace game_engine::gl */
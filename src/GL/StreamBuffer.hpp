@@ -0,0 +1,62 @@
+/******************************************************************************
+ * StreamBuffer.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_GL_STREAMBUFFER_HPP_
+#define SRC_GL_STREAMBUFFER_HPP_
+
+#include <GL/glew.h>
+
+namespace game_engine::gl {
+
+/**
+ * @brief A buffer for data rewritten every frame, such as sprite instances
+ *
+ * Writes are appended behind each other with unsynchronized maps, so the CPU
+ * never waits for draws still reading earlier data.  When the buffer is full
+ * its storage is orphaned and writing starts over at the front, leaving the
+ * old storage to the driver until the GPU is done with it.
+ */
+class StreamBuffer {
+ public:
+  StreamBuffer() = default;
+  StreamBuffer(const StreamBuffer&) = delete;
+  StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+  /**
+   * @brief Copy data into the buffer, growing it if needed
+   * @param alignment Alignment of the returned offset in bytes
+   * @return Returns the offset of the data in the buffer, or -1 if the
+   *         buffer could not be mapped
+   */
+  GLintptr Write(const void* data, const GLsizeiptr size,
+                 const GLsizeiptr alignment = 16);
+  void Destroy();
+
+  GLuint GetBuffer() const { return buffer_; }
+  GLsizeiptr GetCapacity() const { return capacity_; }
+
+ protected:
+  GLuint buffer_ = 0;
+  GLsizeiptr capacity_ = 0;
+  GLintptr offset_ = 0;
+};
+
+} /* namespace game_engine::gl */
+
+#endif /* SRC_GL_STREAMBUFFER_HPP_ */
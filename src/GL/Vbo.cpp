@@ -20,10 +20,18 @@
 
 #include "GL/Vbo.hpp"
 
+#include <algorithm>
+
 #include <GL/glew.h>
 
 namespace game_engine::gl {
 
+GLenum Vbo::IndexTypeFor(const std::size_t n_vertices) {
+  return (n_vertices != 0 && n_vertices < kMaxShortIndexVertices)
+             ? GL_UNSIGNED_SHORT
+             : GL_UNSIGNED_INT;
+}
+
 void Vbo::Init(ShaderPrograms shader) {
   glGenVertexArrays(1, &vao_);
   glGenBuffers(1, &vbo_);
@@ -46,9 +54,11 @@ void Vbo::Allocate(const std::vector<Vertex>& vertices,
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex),
                  &vertices[0], GL_DYNAMIC_DRAW);
   }
+  index_type_ = IndexTypeFor(n_vertices_);
+  index_size_ =
+      (index_type_ == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
   if (n_indices_ != 0) {
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint),
-                 &indices[0], GL_DYNAMIC_DRAW);
+    UploadIndices(indices, true);
   }
   AddVertexPointers();
 }
@@ -62,8 +72,25 @@ void Vbo::Update(const std::vector<Vertex>& vertices,
                     &vertices[0]);
   }
   if (std::min(n_indices_, indices.size()) != 0) {
-    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0,
-                    std::min(n_indices_, indices.size()), &indices[0]);
+    UploadIndices(indices, false);
+  }
+}
+
+void Vbo::UploadIndices(const std::vector<GLuint>& indices,
+                        const bool allocate) {
+  const size_t count =
+      allocate ? indices.size() : std::min(n_indices_, indices.size());
+  const void* data = &indices[0];
+  std::vector<GLushort> short_indices;
+  if (index_type_ == GL_UNSIGNED_SHORT) {
+    short_indices.assign(indices.begin(), indices.begin() + count);
+    data = &short_indices[0];
+  }
+  if (allocate) {
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * index_size_, data,
+                 GL_DYNAMIC_DRAW);
+  } else {
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, count * index_size_, data);
   }
 }
 void Vbo::AddVertexPointer(GLuint id, size_t vec_size, GLenum type,
@@ -20,6 +20,7 @@
 #ifndef SRC_GL_VBO_HPP_
 #define SRC_GL_VBO_HPP_
 
+#include <cstddef>
 #include <ostream>
 #include <vector>
 
@@ -30,8 +31,32 @@
 
 namespace game_engine::gl {
 
+/**
+ * @brief Vertex array with its vertex and index buffers
+ *
+ * Indices are passed in as 32-bit but stored as 16-bit whenever there are
+ * few enough vertices, halving the index memory and bandwidth of most
+ * meshes.  index_type_ and index_size_ describe what was stored.
+ */
 class Vbo {
  public:
+  /**
+   * @brief Buffers with fewer vertices than this use 16-bit indices
+   */
+  static constexpr std::size_t kMaxShortIndexVertices = 65536;
+
+  /**
+   * @brief Type of the indices stored for a buffer of n_vertices vertices
+   */
+  static GLenum IndexTypeFor(const std::size_t n_vertices);
+  /**
+   * @brief Offset of an index into the element buffer in bytes, as
+   *        glDrawElements takes the start of an index range
+   */
+  std::size_t IndexOffset(const std::size_t first_index) const {
+    return first_index * index_size_;
+  }
+
   void Init(ShaderPrograms shader);
   void Bind();
   void Allocate(const std::vector<Vertex>& vertices,
@@ -42,12 +67,21 @@ class Vbo {
                         size_t offset);
   void AddVertexPointers();
 
+ protected:
+  /**
+   * @brief Upload indices in the width chosen by Allocate
+   * @param allocate Reallocate the buffer instead of overwriting its start
+   */
+  void UploadIndices(const std::vector<GLuint>& indices, const bool allocate);
+
  public:
   GLuint vao_ = 0;
   GLuint vbo_ = 0;
   GLuint ebo_ = 0;
   size_t n_vertices_ = 0;
   size_t n_indices_ = 0;
+  GLenum index_type_ = GL_UNSIGNED_INT;
+  size_t index_size_ = sizeof(GLuint);
   ShaderPrograms shaders_ = ShaderPrograms::NULL_SHADER;
 };
 
@@ -58,6 +92,9 @@ inline std::ostream& operator<<(std::ostream& os, const Vbo vbo) {
             << "GLuint ebo_ = " << static_cast<unsigned int>(vbo.ebo_) << "\n"
             << "size_t n_vertices_" << vbo.n_vertices_ << "\n"
             << "size_t n_indices_" << vbo.n_indices_ << "\n"
+            << "GLenum index_type_ = "
+            << static_cast<unsigned int>(vbo.index_type_) << "\n"
+            << "size_t index_size_ = " << vbo.index_size_ << "\n"
             << "ShaderPrograms shaders_ = " << vbo.shaders_ << "\n"
             << "}";
 }
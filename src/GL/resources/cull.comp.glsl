@@ -0,0 +1,73 @@
+#version 450
+
+// GPU-driven culling, see GpuCuller.  Pass 0 runs once per instance, tests its
+// world space box against the frustum and appends the visible ones to the
+// instance range of their mesh.  Pass 1 runs once per mesh and copies the
+// draws with any visible instances to the front of the compacted draws.
+
+layout(local_size_x = 64) in;
+
+struct Instance {
+  mat4 model;
+  // Inverse transpose of model, only the upper 3x3 is used
+  mat4 normal_model;
+  vec4 center;
+  vec4 extents;
+  // x: mesh, y: 1 if enabled
+  uvec4 info;
+};
+
+struct DrawCommand {
+  uint count;
+  uint instance_count;
+  uint first_index;
+  int base_vertex;
+  uint base_instance;
+};
+
+layout(std430, binding = 3) readonly buffer Instances {
+  Instance instances[];
+};
+layout(std430, binding = 4) buffer Commands { DrawCommand commands[]; };
+layout(std430, binding = 5) writeonly buffer Visible { uint visible[]; };
+layout(std430, binding = 6) writeonly buffer Compacted {
+  DrawCommand compacted[];
+};
+layout(std430, binding = 7) buffer DrawCount { uint draw_count; };
+
+uniform uint pass_index;
+uniform uint item_count;
+// Normalized planes pointing inwards
+uniform vec4 planes[6];
+
+bool IsVisible(vec3 center, vec3 extents) {
+  for (int i = 0; i < 6; i++) {
+    float radius = dot(extents, abs(planes[i].xyz));
+    if (dot(planes[i].xyz, center) + planes[i].w < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void main() {
+  uint index = gl_GlobalInvocationID.x;
+  if (index >= item_count) {
+    return;
+  }
+  if (pass_index == 0u) {
+    Instance instance = instances[index];
+    if (instance.info.y == 0u ||
+        !IsVisible(instance.center.xyz, instance.extents.xyz)) {
+      return;
+    }
+    uint mesh = instance.info.x;
+    uint slot = atomicAdd(commands[mesh].instance_count, 1u);
+    visible[commands[mesh].base_instance + slot] = index;
+  } else {
+    if (commands[index].instance_count == 0u) {
+      return;
+    }
+    compacted[atomicAdd(draw_count, 1u)] = commands[index];
+  }
+}
@@ -2,7 +2,8 @@
 
 out vec4 FragColor;
 
-// in vec3 Normal;
+in vec3 View_position;
+in vec3 View_normal;
 in vec4 Color;
 // in vec4 Secondary_color;
 // in vec3 Tangent;
@@ -22,8 +23,56 @@ uniform sampler2D texture_diffuse0;
 
 uniform vec3 color;
 
+// Clustered lights, see LightClusterer
+struct Light {
+  vec4 position_range;
+  vec4 color_intensity;
+  vec4 direction_type;
+  vec4 cone;
+};
+layout(std430, binding = 0) readonly buffer Lights { Light lights[]; };
+layout(std430, binding = 1) readonly buffer Clusters { uvec2 clusters[]; };
+layout(std430, binding = 2) readonly buffer LightIndices { uint indices[]; };
+
+uniform bool lights_enabled;
+uniform ivec3 cluster_grid;
+uniform vec2 cluster_depth_scale_bias;
+uniform vec4 cluster_viewport;
+uniform vec3 ambient_light;
+
+vec3 ClusterLighting(vec3 position, vec3 normal) {
+  vec2 screen = (gl_FragCoord.xy - cluster_viewport.xy) / cluster_viewport.zw;
+  ivec2 tile = clamp(ivec2(screen * vec2(cluster_grid.xy)), ivec2(0),
+                     cluster_grid.xy - 1);
+  int slice = int(floor(log(-position.z) * cluster_depth_scale_bias.x +
+                        cluster_depth_scale_bias.y));
+  slice = clamp(slice, 0, cluster_grid.z - 1);
+  uvec2 cluster =
+      clusters[(slice * cluster_grid.y + tile.y) * cluster_grid.x + tile.x];
+
+  vec3 total = ambient_light;
+  for (uint i = 0; i < cluster.y; i++) {
+    Light light = lights[indices[cluster.x + i]];
+    vec3 to_light = light.position_range.xyz - position;
+    float distance = length(to_light);
+    vec3 l = to_light / max(distance, 1e-4);
+    float falloff = clamp(1.0 - distance / light.position_range.w, 0.0, 1.0);
+    float attenuation = falloff * falloff;
+    if (light.direction_type.w > 0.5) {
+      float spot = dot(-l, light.direction_type.xyz);
+      attenuation *= clamp((spot - light.cone.x) * light.cone.y, 0.0, 1.0);
+    }
+    total += light.color_intensity.rgb * light.color_intensity.a *
+             attenuation * max(dot(normal, l), 0.0);
+  }
+  return total;
+}
+
 void main() {
   FragColor = texture(texture_diffuse0, Tex_coord0) * Color * vec4(color, 1.0f);
+  if (lights_enabled) {
+    FragColor.rgb *= ClusterLighting(View_position, normalize(View_normal));
+  }
 
   // FragColor = texture(text, TexCoord);
 }
\ No newline at end of file
@@ -16,7 +16,8 @@ layout(location = 13) in vec2 tex_coord6;
 layout(location = 14) in vec2 tex_coord7;
 layout(location = 15) in float fog_coord;
 
-// out vec3 Normal;
+out vec3 View_position;
+out vec3 View_normal;
 out vec4 Color;
 // out vec4 Secondary_color;
 // out vec3 Tangent;
@@ -34,10 +35,16 @@ out vec2 Tex_coord0;
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+// Inverse transpose of view * model, computed on the CPU once per draw
+uniform mat3 normal_matrix;
 
 void main() {
   // note that we read the multiplication from right to left
-  gl_Position = projection * view * model * vec4(position, 1.0);
+  vec4 view_position = view * model * vec4(position, 1.0);
+  gl_Position = projection * view_position;
+
+  View_position = view_position.xyz;
+  View_normal = normal_matrix * normal;
 
   Color = color;
   // Secondary_color = secondary_color;
@@ -0,0 +1,65 @@
+#version 450
+
+layout(location = 0) in vec3 position;
+// Index into instances, from the visible instance list written by GpuCuller
+layout(location = 1) in uint instance;
+layout(location = 2) in vec3 normal;
+layout(location = 3) in vec4 color;
+layout(location = 4) in vec4 secondary_color;
+layout(location = 5) in vec3 tangent;
+layout(location = 6) in vec3 bitangent;
+layout(location = 7) in vec2 tex_coord0;
+layout(location = 8) in vec2 tex_coord1;
+layout(location = 9) in vec2 tex_coord2;
+layout(location = 10) in vec2 tex_coord3;
+layout(location = 11) in vec2 tex_coord4;
+layout(location = 12) in vec2 tex_coord5;
+layout(location = 13) in vec2 tex_coord6;
+layout(location = 14) in vec2 tex_coord7;
+layout(location = 15) in float fog_coord;
+
+out vec3 View_position;
+out vec3 View_normal;
+out vec4 Color;
+// out vec4 Secondary_color;
+// out vec3 Tangent;
+// out vec3 Bitangent;
+out vec2 Tex_coord0;
+// out vec2 Tex_coord1;
+// out vec2 Tex_coord2;
+// out vec2 Tex_coord3;
+// out vec2 Tex_coord4;
+// out vec2 Tex_coord5;
+// out vec2 Tex_coord6;
+// out vec2 Tex_coord7;
+// out float Fog_coord;
+
+struct Instance {
+  mat4 model;
+  // Inverse transpose of model, only the upper 3x3 is used
+  mat4 normal_model;
+  vec4 center;
+  vec4 extents;
+  uvec4 info;
+};
+layout(std430, binding = 3) readonly buffer Instances {
+  Instance instances[];
+};
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main() {
+  mat4 model = instances[instance].model;
+  // note that we read the multiplication from right to left
+  vec4 view_position = view * model * vec4(position, 1.0);
+  gl_Position = projection * view_position;
+
+  View_position = view_position.xyz;
+  // The view matrix is rigid, so it transforms normals as is
+  View_normal = mat3(view) * mat3(instances[instance].normal_model) * normal;
+
+  Color = color;
+  // Secondary_color = secondary_color;
+  Tex_coord0 = tex_coord0;
+}
@@ -0,0 +1,10 @@
+#version 450
+
+out vec4 FragColor;
+
+in vec3 Tex_coord;
+in vec4 Color;
+
+uniform sampler2DArray sprite_texture;
+
+void main() { FragColor = texture(sprite_texture, Tex_coord) * Color; }
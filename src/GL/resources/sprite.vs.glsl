@@ -0,0 +1,28 @@
+#version 450
+
+layout(location = 0) in vec4 position_size;
+layout(location = 1) in vec4 uv_rect;
+layout(location = 2) in vec4 color;
+layout(location = 3) in float rotation;
+layout(location = 4) in uint texture_layer;
+
+out vec3 Tex_coord;
+out vec4 Color;
+
+uniform mat4 projection;
+
+void main() {
+  // One instance per sprite, drawn as a four vertex triangle strip
+  vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+  vec2 local = (corner - 0.5) * position_size.zw;
+  float s = sin(rotation);
+  float c = cos(rotation);
+  vec2 position = position_size.xy +
+                  vec2(c * local.x - s * local.y, s * local.x + c * local.y);
+
+  // Image rows are stored top first, so the top of the sprite gets uv_min.y
+  Tex_coord = vec3(mix(uv_rect.x, uv_rect.z, corner.x),
+                   mix(uv_rect.w, uv_rect.y, corner.y), float(texture_layer));
+  Color = color;
+  gl_Position = projection * vec4(position, 0.0, 1.0);
+}
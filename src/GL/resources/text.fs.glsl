@@ -2,12 +2,17 @@
 
 out vec4 FragColor;
 
-in vec2 TexCoords;
+in vec3 Tex_coord;
+in vec4 Color;
 
-uniform sampler2D glyph;
-
-uniform vec3 color;
+// Glyph signed distance fields in the red channel, 0.5 on the edge, drawn
+// with sprite.vs.glsl
+uniform sampler2DArray sprite_texture;
 
 void main() {
-  FragColor = vec4(1, 1, 1, texture(glyph, TexCoords).r) * vec4(color, 1.0f);
-}
\ No newline at end of file
+  float distance = texture(sprite_texture, Tex_coord).r;
+  // Antialias over about one screen pixel, whatever the scale
+  float width = 0.7 * length(vec2(dFdx(distance), dFdy(distance)));
+  float coverage = smoothstep(0.5 - width, 0.5 + width, distance);
+  FragColor = vec4(Color.rgb, Color.a * coverage);
+}
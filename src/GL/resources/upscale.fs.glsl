@@ -0,0 +1,34 @@
+#version 450
+
+out vec4 FragColor;
+
+in vec2 Tex_coord;
+
+uniform sampler2D source;
+// Fraction of the source covered by the scaled scene
+uniform vec2 uv_scale;
+uniform bool sharpen;
+uniform float sharpness;
+
+void main() {
+  vec2 texel = 1.0 / vec2(textureSize(source, 0));
+  // Keep bilinear taps inside the rendered part of the source
+  vec2 lo = 0.5 * texel;
+  vec2 hi = uv_scale - 0.5 * texel;
+  vec2 uv = clamp(Tex_coord * uv_scale, lo, hi);
+  vec4 center = texture(source, uv);
+  FragColor = center;
+
+  if (sharpen) {
+    vec3 n = texture(source, clamp(uv + vec2(0.0, texel.y), lo, hi)).rgb;
+    vec3 s = texture(source, clamp(uv - vec2(0.0, texel.y), lo, hi)).rgb;
+    vec3 e = texture(source, clamp(uv + vec2(texel.x, 0.0), lo, hi)).rgb;
+    vec3 w = texture(source, clamp(uv - vec2(texel.x, 0.0), lo, hi)).rgb;
+    vec3 blur = (n + s + e + w) * 0.25;
+    // Clamp to the neighbourhood so edges do not ring
+    vec3 low = min(center.rgb, min(min(n, s), min(e, w)));
+    vec3 high = max(center.rgb, max(max(n, s), max(e, w)));
+    FragColor.rgb =
+        clamp(center.rgb + (center.rgb - blur) * 2.0 * sharpness, low, high);
+  }
+}
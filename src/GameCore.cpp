@@ -27,6 +27,13 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "LoggerV2/Log.hpp"
+#include "absl/flags/flag.h"
 #include FT_FREETYPE_H
 
+ABSL_FLAG(bool, dynamic_resolution, false,
+          "Scale the scene resolution to hold --target_fps");
+ABSL_FLAG(int, target_fps, 60, "Frame rate dynamic resolution aims for");
+ABSL_FLAG(bool, sharpen_upscale, false,
+          "Sharpen the scene when upscaling it to the window");
+
 namespace game_engine {} /* namespace game_engine */
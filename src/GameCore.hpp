@@ -20,13 +20,17 @@
 #ifndef SRC_GAMECORE_HPP_
 #define SRC_GAMECORE_HPP_
 
+#include <algorithm>
 #include <limits>
+#include <map>
+#include <optional>
 #include <string>
 #include <string_view>
 
 #include "LoggerV2/Client.hpp"
 #include "LoggerV2/Log.hpp"
 #include "LoggerV2/Telemetry.hpp"
+#include "absl/flags/declare.h"
 #include "absl/flags/flag.h"
 #include "absl/flags/parse.h"
 #include "absl/flags/usage.h"
@@ -34,6 +38,10 @@
 
 #include "2D/FpsRenderer.hpp"
 #include "2D/TextRenderer.hpp"
+#include "3D/FrameGraph.hpp"
+#include "3D/LightClusterer.hpp"
+#include "3D/ResolutionController.hpp"
+#include "3D/Scene.hpp"
 #include "CallbackHandler.hpp"
 #include "GL/GLRenderer.hpp"
 #include "GL/GLWindowManager.hpp"
@@ -41,6 +49,10 @@
 #include "Util/Singleton.hpp"
 #include "WindowManager.hpp"
 
+ABSL_DECLARE_FLAG(bool, dynamic_resolution);
+ABSL_DECLARE_FLAG(int, target_fps);
+ABSL_DECLARE_FLAG(bool, sharpen_upscale);
+
 /**
  * @brief Holds all classes for GameEngine
  */
@@ -61,6 +73,26 @@ inline constexpr double kFpsAlarmMaxVal = std::numeric_limits<double>::max();
 inline constexpr bool kFpsRawEnable = true;
 inline constexpr bool kFpsRollAvgEnable = true;
 
+inline constexpr double kResolutionScaleMinVal = 0.0;
+inline constexpr double kResolutionScaleAlarmMinVal = 0.0;
+inline constexpr double kResolutionScaleMaxVal = 1.0;
+inline constexpr double kResolutionScaleAlarmMaxVal = 1.0;
+inline constexpr bool kResolutionScaleEnable = true;
+/**
+ * @brief Part of the refresh interval dynamic resolution aims to fill
+ */
+inline constexpr double kFrameBudgetFraction = 0.9;
+inline const _3D::PixelFormat kSceneColorFormat{GL_RGBA8, GL_RGBA};
+inline const _3D::PixelFormat kSceneDepthFormat{GL_DEPTH24_STENCIL8,
+                                                GL_DEPTH_STENCIL};
+
+inline constexpr double kLightCountMinVal = 0.0;
+inline constexpr double kLightCountAlarmMinVal = 0.0;
+inline constexpr double kLightCountMaxVal = 4096.0;
+inline constexpr double kLightCountAlarmMaxVal =
+    std::numeric_limits<double>::max();
+inline constexpr bool kLightTelemetryEnable = true;
+
 /**
  * @brief The main class of GameEngine
  *
@@ -131,9 +163,74 @@ class GameCore : public Singleton<Derived>,
    */
   void Render() {
     PreRender();
-    this->Underlying().Render();
+    BuildFrameGraph();
+    frame_graph_.Execute(renderer_);
     PostRender();
   }
+  /**
+   * @brief Declares the passes of the frame
+   *
+   * The derived class's render function draws the scene pass into the
+   * window, then the FPS counter is drawn over it.  With dynamic resolution
+   * the scene is drawn into a scaled part of an offscreen target instead and
+   * stretched over the window, so the FPS counter stays at native resolution.
+   */
+  void BuildFrameGraph() {
+    using _3D::FrameGraphBuilder;
+    using _3D::FrameGraphResources;
+    using _3D::FrameResourceUsage;
+
+    frame_graph_.Reset();
+    const glm::ivec2 window_size = renderer_.GetWindowSize();
+    const _3D::FrameResourceId backbuffer =
+        frame_graph_.ImportBackbuffer("Backbuffer", window_size);
+    if (resolution_.IsEnabled()) {
+      frame_graph_.AddPass(
+          "Scene",
+          [&](FrameGraphBuilder& builder) {
+            scene_color_ = builder.CreateTexture(
+                "Scene color", {window_size, kSceneColorFormat});
+            builder.Write(scene_color_, FrameResourceUsage::COLOR_ATTACHMENT);
+            builder.Write(
+                builder.CreateTexture("Scene depth",
+                                      {window_size, kSceneDepthFormat}),
+                FrameResourceUsage::DEPTH_ATTACHMENT);
+            builder.SetClear(kScreenClearColor);
+          },
+          [this, window_size](const FrameGraphResources&) {
+            renderer_.RedrawWindowBounds(resolution_.ScaledSize(window_size));
+            this->Underlying().Render();
+          });
+      frame_graph_.AddPass(
+          "Upscale",
+          [&](FrameGraphBuilder& builder) {
+            builder.Read(scene_color_, FrameResourceUsage::SAMPLED);
+            builder.Write(backbuffer, FrameResourceUsage::COLOR_ATTACHMENT);
+          },
+          [this, window_size](const FrameGraphResources& resources) {
+            const glm::vec2 uv_scale =
+                glm::vec2(resolution_.ScaledSize(window_size)) /
+                glm::vec2(window_size);
+            renderer_.Upscale(resources.GetTexture(scene_color_), uv_scale,
+                              resolution_.GetOptions().filter,
+                              resolution_.GetOptions().sharpness);
+          });
+    } else {
+      frame_graph_.AddPass(
+          "Scene",
+          [&](FrameGraphBuilder& builder) {
+            builder.Write(backbuffer, FrameResourceUsage::COLOR_ATTACHMENT);
+            builder.SetClear(kScreenClearColor);
+          },
+          [this](const FrameGraphResources&) { this->Underlying().Render(); });
+    }
+    frame_graph_.AddPass(
+        "FPS",
+        [&](FrameGraphBuilder& builder) {
+          builder.Write(backbuffer, FrameResourceUsage::COLOR_ATTACHMENT);
+        },
+        [this](const FrameGraphResources&) { RenderFps(renderer_); });
+  }
   /**
    * @brief Main tick function
    *
@@ -168,6 +265,13 @@ class GameCore : public Singleton<Derived>,
             .Create("Performance/FPS", kFpsMinVal, kFpsAlarmMinVal, kFpsMaxVal,
                     kFpsAlarmMaxVal, kFpsRawEnable)
             .value();
+    resolution_scale_telem_ =
+        log_telem_
+            .Create("Performance/Resolution scale", kResolutionScaleMinVal,
+                    kResolutionScaleAlarmMinVal, kResolutionScaleMaxVal,
+                    kResolutionScaleAlarmMaxVal, kResolutionScaleEnable)
+            .value();
+    SetupDynamicResolution();
     renderer_.Init(std::string(program_name_));
     InitFpsRenderer(renderer_);
     RegisterDefaultCallbacks();
@@ -195,7 +299,6 @@ class GameCore : public Singleton<Derived>,
    * @brief Run prior to main render function
    */
   void PreRender() {
-    renderer_.Clear(kScreenClearColor);
     IncrementFrameCount();
     StartFrameTimer();
   }
@@ -203,13 +306,105 @@ class GameCore : public Singleton<Derived>,
    * @brief Run after main render function
    */
   void PostRender() {
-    RenderFps(renderer_);
     StopFrameTimer();
     CalculateFrameTime();
     renderer_.Swap();
     frame_time_telem_.Add(frame_time_us_);
     fps_raw_telem_.Add(fps_);
     fps_roll_avg_telem_.Add(fps_avg_);
+    AddPassTelemetry();
+    UpdateDynamicResolution();
+  }
+  /**
+   * @brief Configure dynamic resolution from the command line flags
+   */
+  void SetupDynamicResolution() {
+    _3D::DynamicResolutionOptions options;
+    options.enabled = absl::GetFlag(FLAGS_dynamic_resolution);
+    const int target_fps = std::max(absl::GetFlag(FLAGS_target_fps), 1);
+    options.target_ms = kFrameBudgetFraction * 1000.0 / target_fps;
+    options.filter = absl::GetFlag(FLAGS_sharpen_upscale)
+                         ? _3D::UpscaleFilter::SHARPEN
+                         : _3D::UpscaleFilter::BILINEAR;
+    resolution_.SetOptions(options);
+  }
+  /**
+   * @brief Feed the frame time of this frame to the resolution controller
+   *
+   * The GPU time is the sum of the timed passes; their queries lag a few
+   * frames, so it is unknown for the first frames.
+   */
+  void UpdateDynamicResolution() {
+    if (!resolution_.IsEnabled()) {
+      return;
+    }
+    double gpu_ms = -1.0;
+    for (const auto& timing : frame_graph_.GetTimings()) {
+      if (timing.gpu_ms >= 0.0) {
+        gpu_ms = std::max(gpu_ms, 0.0) + timing.gpu_ms;
+      }
+    }
+    resolution_.Update(frame_time_us_ / 1000.0, gpu_ms);
+    resolution_scale_telem_.Add(resolution_.GetScale());
+  }
+  /**
+   * @brief Report the time of each frame graph pass, creating its channels
+   *        the first time it runs
+   */
+  void AddPassTelemetry() {
+    for (const auto& timing : frame_graph_.GetTimings()) {
+      auto it = pass_telem_.find(timing.name);
+      if (it == pass_telem_.end()) {
+        const std::string prefix = "Performance/Passes/" + timing.name;
+        const PassTelemetry telemetry{
+            log_telem_
+                .Create((prefix + "/CPU ms").c_str(), kFrameTimeMinVal,
+                        kFrameTimeAlarmMinVal, kFrameTimeMaxVal,
+                        kFrameTimeAlarmMaxVal, kFrameTimeEnable)
+                .value(),
+            log_telem_
+                .Create((prefix + "/GPU ms").c_str(), kFrameTimeMinVal,
+                        kFrameTimeAlarmMinVal, kFrameTimeMaxVal,
+                        kFrameTimeAlarmMaxVal, kFrameTimeEnable)
+                .value()};
+        it = pass_telem_.emplace(timing.name, telemetry).first;
+      }
+      it->second.cpu.Add(timing.cpu_ms);
+      if (timing.gpu_ms >= 0.0) {
+        it->second.gpu.Add(timing.gpu_ms);
+      }
+    }
+  }
+
+  /**
+   * @brief Report the light binning of a scene, creating its channels the
+   *        first time it runs
+   *
+   * Called by DrawScene after drawing a lit scene.
+   */
+  void AddLightTelemetry(const _3D::LightClusterStats& stats) {
+    if (!light_telem_) {
+      light_telem_ = LightTelemetry{
+          log_telem_
+              .Create("Performance/Lights/Bin ms", kFrameTimeMinVal,
+                      kFrameTimeAlarmMinVal, kFrameTimeMaxVal,
+                      kFrameTimeAlarmMaxVal, kLightTelemetryEnable)
+              .value(),
+          log_telem_
+              .Create("Performance/Lights/Visible", kLightCountMinVal,
+                      kLightCountAlarmMinVal, kLightCountMaxVal,
+                      kLightCountAlarmMaxVal, kLightTelemetryEnable)
+              .value(),
+          log_telem_
+              .Create("Performance/Lights/Max per cluster", kLightCountMinVal,
+                      kLightCountAlarmMinVal, kLightCountMaxVal,
+                      kLightCountAlarmMaxVal, kLightTelemetryEnable)
+              .value()};
+    }
+    light_telem_->bin_ms.Add(stats.bin_ms);
+    light_telem_->visible.Add(static_cast<double>(stats.visible_lights));
+    light_telem_->max_per_cluster.Add(
+        static_cast<double>(stats.max_cluster_lights));
   }
 
   /**
@@ -278,6 +473,20 @@ class GameCore : public Singleton<Derived>,
   void SetProgramName(const std::string_view name) { program_name_ = name; }
 
  protected:
+  /**
+   * @brief Draw a scene from the render function and report its light
+   *        binning
+   * @param scene The scene to draw
+   * @param shaders Shader program to draw the scene with
+   */
+  void DrawScene(_3D::Scene& scene,
+                 const ShaderPrograms shaders = ShaderPrograms::DEFAULT) {
+    scene.Draw(renderer_, shaders);
+    if (!scene.GetLights().empty()) {
+      AddLightTelemetry(scene.GetLightClusterStats());
+    }
+  }
+
   /**
    * @brief Object responsible for actual rendering
    */
@@ -294,6 +503,28 @@ class GameCore : public Singleton<Derived>,
   logging::TelemetryChannelHandle frame_time_telem_{};
   logging::TelemetryChannelHandle fps_roll_avg_telem_{};
   logging::TelemetryChannelHandle fps_raw_telem_{};
+  logging::TelemetryChannelHandle resolution_scale_telem_{};
+
+  struct PassTelemetry {
+    logging::TelemetryChannelHandle cpu;
+    logging::TelemetryChannelHandle gpu;
+  };
+  std::map<std::string, PassTelemetry> pass_telem_{};
+  struct LightTelemetry {
+    logging::TelemetryChannelHandle bin_ms;
+    logging::TelemetryChannelHandle visible;
+    logging::TelemetryChannelHandle max_per_cluster;
+  };
+  std::optional<LightTelemetry> light_telem_{};
+  /**
+   * @brief Passes of the current frame
+   */
+  _3D::FrameGraph frame_graph_{};
+  _3D::ResolutionController resolution_{};
+  /**
+   * @brief Offscreen color of the scene pass when using dynamic resolution
+   */
+  _3D::FrameResourceId scene_color_ = _3D::kNullFrameResource;
 };
 
 } /* namespace game_engine */
@@ -20,15 +20,24 @@
 #ifndef SRC_RENDERER_HPP_
 #define SRC_RENDERER_HPP_
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
+#include "2D/SpriteBatch.hpp"
 #include "3D/Cubemap.hpp"
+#include "3D/FrameGraph.hpp"
+#include "3D/LightClusterer.hpp"
+#include "3D/MipmapGenerator.hpp"
 #include "3D/PixelFormat.hpp"
 #include "3D/Primitive.hpp"
+#include "3D/RenderTarget.hpp"
+#include "3D/ResolutionController.hpp"
 #include "3D/Texture.hpp"
 #include "ShaderPrograms.hpp"
 #include "Util/Crtp.hpp"
@@ -64,6 +73,15 @@ class Renderer : public W_Derived, Crtp<Renderer, R_Derived, W_Derived> {
   void UseShader(const ShaderPrograms shader_program) const {
     this->Underlying().useShader(shader_program);
   }
+  /**
+   * @brief Check whether a shader program can be used without blocking on its
+   *        compilation
+   * @param shader_program Shader program to check
+   * @return Returns true once the program has finished compiling and linking
+   */
+  bool IsShaderReady(const ShaderPrograms shader_program) const {
+    return this->Underlying().IsShaderReady(shader_program);
+  }
   /**
    * @brief Generate a VBO
    * @param shader_program Shader with which to render object with
@@ -104,6 +122,18 @@ class Renderer : public W_Derived, Crtp<Renderer, R_Derived, W_Derived> {
   void Render(const VboHandle vbo_handle, const _3D::Primitive mode) const {
     this->Underlying().Render(vbo_handle, mode);
   }
+  /**
+   * @brief Render a range of the indices of a given VBO
+   * @param vbo_handle Handle of VBO to render
+   * @param mode Primitive type of objects inside VBO
+   * @param first_index First index to draw
+   * @param index_count Number of indices to draw
+   */
+  void Render(const VboHandle vbo_handle, const _3D::Primitive mode,
+              const std::size_t first_index,
+              const std::size_t index_count) const {
+    this->Underlying().Render(vbo_handle, mode, first_index, index_count);
+  }
   /**
    * @brief Set the matrix uniforms
    * @param shader_program Shader to set uniforms for
@@ -127,6 +157,19 @@ class Renderer : public W_Derived, Crtp<Renderer, R_Derived, W_Derived> {
                    const GLuint texture_unit) const {
     this->Underlying().BindTexture(shader_program, name, texture, texture_unit);
   }
+  /**
+   * @brief Bind a 2D texture array
+   * @param shader_program Shader to bind texture to
+   * @param name Name of uniform to bind to
+   * @param id Handle returned by CreateTextureArray
+   * @param texture_unit Texture unit to bind to
+   */
+  void BindTextureArray(const ShaderPrograms shader_program,
+                        const std::string& name, const unsigned int id,
+                        const GLuint texture_unit) const {
+    this->Underlying().BindTextureArray(shader_program, name, id,
+                                        texture_unit);
+  }
   /**
    * @brief Bind a cube map
    * @param shader_program Shader to bind texture to
@@ -178,6 +221,67 @@ class Renderer : public W_Derived, Crtp<Renderer, R_Derived, W_Derived> {
     return this->Underlying().CreateTexture(shader_program, format, size,
                                             pixels);
   }
+  /**
+   * @brief Create a texture from a mip chain generated on the CPU
+   * @param format Format of the pixels in the texture
+   * @param mip_chain Levels to upload, level 0 first
+   * @return Returns a unsigned int handle to the texture
+   */
+  unsigned int CreateTexture(const ShaderPrograms shader_program,
+                             const _3D::PixelFormat format,
+                             const _3D::MipChain& mip_chain) const {
+    return this->Underlying().CreateTexture(shader_program, format,
+                                            mip_chain);
+  }
+  /**
+   * @brief Create a 2D texture array with empty layers, to be filled with
+   *        UpdateTextureArray
+   * @param format Format of the pixels in the texture
+   * @param size Width and height of each layer, and number of layers
+   * @param mip_levels Number of mip levels to allocate, level 0 included
+   * @param wrap Wrap mode of both texture coordinates
+   * @return Returns a unsigned int handle to the texture array
+   */
+  unsigned int CreateTextureArray(const ShaderPrograms shader_program,
+                                  const _3D::PixelFormat format,
+                                  const glm::ivec3 size, const int mip_levels,
+                                  const _3D::TextureWrap wrap) const {
+    return this->Underlying().CreateTextureArray(shader_program, format, size,
+                                                 mip_levels, wrap);
+  }
+  /**
+   * @brief Create a 2D texture array from a mip chain per layer
+   * @param format Format of the pixels in the texture
+   * @param layers Levels of each layer, level 0 first.  Every chain must have
+   *               the same size and number of levels.
+   * @param wrap Wrap mode of both texture coordinates
+   * @return Returns a unsigned int handle to the texture array
+   */
+  unsigned int CreateTextureArray(const ShaderPrograms shader_program,
+                                  const _3D::PixelFormat format,
+                                  const std::vector<_3D::MipChain>& layers,
+                                  const _3D::TextureWrap wrap) const {
+    return this->Underlying().CreateTextureArray(shader_program, format,
+                                                 layers, wrap);
+  }
+  /**
+   * @brief Replace a rectangle of one level of one layer of a 2D texture
+   *        array.  Levels are never generated, so every level has to be
+   *        updated for the change to show at every distance.
+   * @param id Handle returned by CreateTextureArray
+   * @param format Format of the pixels in the texture array
+   * @param offset Position of the rectangle in texels of the level, and its
+   *               layer
+   * @param size Size of the rectangle
+   * @param pixels Tightly packed pixel data of the rectangle
+   * @param level Mip level to update
+   */
+  void UpdateTextureArray(const unsigned int id, const _3D::PixelFormat format,
+                          const glm::ivec3 offset, const glm::ivec2 size,
+                          const void* pixels, const int level = 0) const {
+    this->Underlying().UpdateTextureArray(id, format, offset, size, pixels,
+                                          level);
+  }
   /**
    * @brief Create a cubemap
    * @param format Format of the pixels in the cubemap
@@ -227,6 +331,195 @@ class Renderer : public W_Derived, Crtp<Renderer, R_Derived, W_Derived> {
    */
   void Swap() const { this->Underlying().Swap(); }
 
+  /**
+   * @brief Create an offscreen render target
+   * @return Returns a nonzero unsigned int handle to the render target
+   */
+  unsigned int CreateRenderTarget(const _3D::RenderTargetDesc& desc) {
+    return this->Underlying().CreateRenderTarget(desc);
+  }
+  void DestroyRenderTarget(const unsigned int target) {
+    this->Underlying().DestroyRenderTarget(target);
+  }
+  /**
+   * @brief Render into a render target and set the viewport to its size
+   * @param target Render target to bind, or 0 for the window
+   */
+  void BindRenderTarget(const unsigned int target) const {
+    this->Underlying().BindRenderTarget(target);
+  }
+  /**
+   * @brief Resolve a multisampled render target so its texture can be sampled
+   */
+  void ResolveRenderTarget(const unsigned int target) const {
+    this->Underlying().ResolveRenderTarget(target);
+  }
+  /**
+   * @brief Get the id of the color texture of a render target
+   */
+  unsigned int GetRenderTargetTexture(const unsigned int target) const {
+    return this->Underlying().GetRenderTargetTexture(target);
+  }
+  /**
+   * @brief Copy the color of a render target to the CPU without blocking
+   * @param target Render target to read, or 0 for the window.  The window is
+   *               read as the next Swap presents it, so it may be requested
+   *               at any point of the frame.
+   * @param callback Called from PollReadbacks, normally during Swap, once the
+   *                 pixels have arrived a few frames later
+   */
+  void ReadRenderTargetAsync(const unsigned int target,
+                             _3D::ReadbackCallback callback) const {
+    this->Underlying().ReadRenderTargetAsync(target, std::move(callback));
+  }
+  /**
+   * @brief Deliver the readbacks that have completed
+   * @return Returns the number of callbacks invoked
+   */
+  std::size_t PollReadbacks() const {
+    return this->Underlying().PollReadbacks();
+  }
+  /**
+   * @brief Wait for every pending readback and deliver it
+   */
+  void FinishReadbacks() const { this->Underlying().FinishReadbacks(); }
+
+  /**
+   * @brief Create a texture for a frame graph transient resource
+   * @return Returns a unsigned int handle to the texture
+   */
+  unsigned int CreateTransientTexture(
+      const _3D::TransientTextureDesc& desc) const {
+    return this->Underlying().CreateTransientTexture(desc);
+  }
+  void DestroyTransientTexture(const unsigned int id) const {
+    this->Underlying().DestroyTransientTexture(id);
+  }
+  /**
+   * @brief Create a GPU buffer for a frame graph transient resource
+   * @return Returns a unsigned int handle to the buffer
+   */
+  unsigned int CreateTransientBuffer(
+      const _3D::TransientBufferDesc& desc) const {
+    return this->Underlying().CreateTransientBuffer(desc);
+  }
+  void DestroyTransientBuffer(const unsigned int id) const {
+    this->Underlying().DestroyTransientBuffer(id);
+  }
+  /**
+   * @brief Bind the attachments of a frame graph pass, clearing them if the
+   *        pass asks for it
+   */
+  void BindFrameTargets(const _3D::FramePassTargets& targets) const {
+    this->Underlying().BindFrameTargets(targets);
+  }
+  /**
+   * @brief Make a resource's previous accesses visible to its next one
+   */
+  void InsertFrameBarrier(const _3D::FrameBarrier& barrier) const {
+    this->Underlying().InsertFrameBarrier(barrier);
+  }
+  /**
+   * @brief Time the GPU work submitted between BeginPassTimer and
+   *        EndPassTimer
+   */
+  void BeginPassTimer(const std::string& name) const {
+    this->Underlying().BeginPassTimer(name);
+  }
+  void EndPassTimer(const std::string& name) const {
+    this->Underlying().EndPassTimer(name);
+  }
+  /**
+   * @brief Most recent GPU time of a pass in milliseconds, negative if none
+   *        is available yet
+   */
+  double GetPassGpuTime(const std::string& name) const {
+    return this->Underlying().GetPassGpuTime(name);
+  }
+
+  /**
+   * @brief Upload binned lights and enable clustered lighting in a shader
+   * @param shader_program Shader to light
+   * @param clusters Lights binned by LightClusterer for the current view
+   * @param ambient Light added to every fragment
+   */
+  void UploadLightClusters(const ShaderPrograms shader_program,
+                           const _3D::LightClusterData& clusters,
+                           const glm::vec3 ambient) const {
+    this->Underlying().UploadLightClusters(shader_program, clusters, ambient);
+  }
+  /**
+   * @brief Draw a shader unlit again
+   */
+  void DisableLights(const ShaderPrograms shader_program) const {
+    this->Underlying().DisableLights(shader_program);
+  }
+
+  /**
+   * @brief Stretch the scaled scene over the current framebuffer
+   * @param texture Texture the scene was rendered into
+   * @param uv_scale Fraction of the texture covered by the scene
+   * @param filter Filter used to upscale
+   * @param sharpness Strength of UpscaleFilter::SHARPEN, from 0 to 1
+   */
+  void Upscale(const unsigned int texture, const glm::vec2 uv_scale,
+               const _3D::UpscaleFilter filter, const float sharpness) const {
+    this->Underlying().Upscale(texture, uv_scale, filter, sharpness);
+  }
+  /**
+   * @brief Stream the sprites of a batch to the GPU and draw them over the
+   *        current framebuffer, blended and without depth testing
+   * @param batch Batch after SpriteBatch::End
+   * @param projection Projection from sprite positions to clip space, such as
+   *                   glm::ortho over the window size
+   * @param shader_program Shader taking the sprite instance layout, SPRITE
+   *                       for colored images or TEXT for glyph coverage
+   */
+  void DrawSprites(
+      const _2D::SpriteBatch& batch, const glm::mat4& projection,
+      const ShaderPrograms shader_program = ShaderPrograms::SPRITE) const {
+    this->Underlying().DrawSprites(batch, projection, shader_program);
+  }
+
+  /**
+   * @brief Add a mesh to the static geometry drawn by DrawStaticInstances
+   * @return Returns the id of the mesh
+   */
+  std::uint32_t AddStaticMesh(const std::vector<Vertex>& vertices,
+                              const std::vector<GLuint>& indices) const {
+    return this->Underlying().AddStaticMesh(vertices, indices);
+  }
+  /**
+   * @brief Place a static mesh in the world
+   * @return Returns the id of the instance
+   */
+  std::uint32_t AddStaticInstance(const std::uint32_t mesh,
+                                  const glm::mat4& model) const {
+    return this->Underlying().AddStaticInstance(mesh, model);
+  }
+  void SetStaticInstanceEnabled(const std::uint32_t instance,
+                                const bool enabled) const {
+    this->Underlying().SetStaticInstanceEnabled(instance, enabled);
+  }
+  /**
+   * @brief Frustum cull every static instance and draw the visible ones
+   *
+   * The instances are drawn untextured with ShaderPrograms::INDIRECT, using
+   * its color and lights.  The GL renderer culls and issues the draws on the
+   * GPU, so the cost to the CPU does not grow with the number of instances.
+   */
+  void DrawStaticInstances(const glm::mat4& view,
+                           const glm::mat4& projection) const {
+    this->Underlying().DrawStaticInstances(view, projection);
+  }
+  /**
+   * @brief Number of static instances that passed the last cull.  May wait
+   *        for the GPU, so only meant for tests and debugging.
+   */
+  std::uint32_t ReadStaticVisibleCount() const {
+    return this->Underlying().ReadStaticVisibleCount();
+  }
+
   /**
    * @brief Set a uniform to a bool
    * @param shader_program Shader to set uniform for
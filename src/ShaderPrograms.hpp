@@ -32,7 +32,10 @@ enum class ShaderPrograms : GLuint {
   DEFAULT = (1 << 0),
   CUBE = (1 << 1),
   TEXT = (1 << 2),
-  SKYBOX = (1 << 3)
+  SKYBOX = (1 << 3),
+  UPSCALE = (1 << 4),
+  INDIRECT = (1 << 5),
+  SPRITE = (1 << 6)
 };
 ENABLE_BITMASK_OPERATORS(ShaderPrograms);
 
@@ -65,6 +68,24 @@ inline std::ostream& operator<<(std::ostream& os, const ShaderPrograms sp) {
     }
     out += "SKYBOX";
   }
+  if ((sp & ShaderPrograms::UPSCALE) != ShaderPrograms::NULL_SHADER) {
+    if (out.length() != 0) {
+      out += " | ";
+    }
+    out += "UPSCALE";
+  }
+  if ((sp & ShaderPrograms::INDIRECT) != ShaderPrograms::NULL_SHADER) {
+    if (out.length() != 0) {
+      out += " | ";
+    }
+    out += "INDIRECT";
+  }
+  if ((sp & ShaderPrograms::SPRITE) != ShaderPrograms::NULL_SHADER) {
+    if (out.length() != 0) {
+      out += " | ";
+    }
+    out += "SPRITE";
+  }
   return os << out;
 }
 
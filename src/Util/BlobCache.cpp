@@ -0,0 +1,164 @@
+/******************************************************************************
+ * BlobCache.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "Util/BlobCache.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+
+#include "LoggerV2/Log.hpp"
+
+#include "Util/Hash.hpp"
+#include "Util/Rng.hpp"
+
+namespace game_engine::util {
+
+namespace {
+
+constexpr char kMagic[4] = {'G', 'E', 'B', 'C'};
+constexpr uint32_t kVersion = 1;
+
+struct Header {
+  char magic[4];
+  uint32_t version;
+  uint64_t key;
+  uint64_t size;
+  uint64_t checksum;
+};
+
+}  // namespace
+
+BlobCache::BlobCache(const std::string& name)
+    : BlobCache(UserCacheDirectory() / name, true) {}
+
+BlobCache::BlobCache(const std::filesystem::path& directory, const bool create)
+    : directory_(directory) {
+  std::error_code ec;
+  if (create) {
+    std::filesystem::create_directories(directory_, ec);
+  }
+  enabled_ = !ec && std::filesystem::is_directory(directory_, ec);
+  if (!enabled_) {
+    log_.Warning("Cache directory {} is unavailable, caching disabled.",
+                 directory_.string());
+  }
+}
+
+std::filesystem::path BlobCache::UserCacheDirectory() {
+  if (const char* xdg = std::getenv("XDG_CACHE_HOME");
+      xdg != nullptr && xdg[0] != '\0') {
+    return std::filesystem::path(xdg) / "GameEngine";
+  }
+  if (const char* home = std::getenv("HOME");
+      home != nullptr && home[0] != '\0') {
+    return std::filesystem::path(home) / ".cache" / "GameEngine";
+  }
+  return std::filesystem::temp_directory_path() / "GameEngine";
+}
+
+std::filesystem::path BlobCache::PathFor(const uint64_t key) const {
+  std::ostringstream name;
+  name << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+  return directory_ / name.str();
+}
+
+std::optional<std::vector<uint8_t>> BlobCache::Load(const uint64_t key) const {
+  if (!enabled_) {
+    return std::nullopt;
+  }
+  const std::filesystem::path path = PathFor(key);
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return std::nullopt;
+  }
+
+  Header header{};
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  // The size is checked against the file before allocating, so a corrupted
+  // header cannot ask for an arbitrarily large buffer
+  std::error_code ec;
+  const std::uintmax_t file_size = std::filesystem::file_size(path, ec);
+  if (!file || ec || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion || header.key != key ||
+      file_size < sizeof(header) || header.size != file_size - sizeof(header)) {
+    log_.Warning("Discarding invalid cache entry {}.", path.string());
+    Remove(key);
+    return std::nullopt;
+  }
+
+  std::vector<uint8_t> data(header.size);
+  file.read(reinterpret_cast<char*>(data.data()), data.size());
+  if (!file || Hash(data.data(), data.size()) != header.checksum) {
+    log_.Warning("Discarding corrupted cache entry {}.", path.string());
+    Remove(key);
+    return std::nullopt;
+  }
+  return data;
+}
+
+bool BlobCache::Store(const uint64_t key,
+                      const std::vector<uint8_t>& data) const {
+  if (!enabled_) {
+    return false;
+  }
+  Header header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.key = key;
+  header.size = data.size();
+  header.checksum = Hash(data.data(), data.size());
+
+  // Write to a temporary file and rename it over the entry, so a crash or a
+  // second instance never observes a partially written file
+  const std::filesystem::path path = PathFor(key);
+  std::filesystem::path temporary = path;
+  temporary += "." + std::to_string(Rng::get()) + ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    if (!file) {
+      log_.Warning("Failed to write cache entry {}.", temporary.string());
+      std::error_code ec;
+      std::filesystem::remove(temporary, ec);
+      return false;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(temporary, path, ec);
+  if (ec) {
+    log_.Warning("Failed to commit cache entry {}: {}", path.string(),
+                 ec.message());
+    std::filesystem::remove(temporary, ec);
+    return false;
+  }
+  return true;
+}
+
+void BlobCache::Remove(const uint64_t key) const {
+  std::error_code ec;
+  std::filesystem::remove(PathFor(key), ec);
+}
+
+} /* namespace game_engine::util */
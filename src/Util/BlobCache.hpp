@@ -0,0 +1,73 @@
+/******************************************************************************
+ * BlobCache.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_UTIL_BLOBCACHE_HPP_
+#define SRC_UTIL_BLOBCACHE_HPP_
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "LoggerV2/Log.hpp"
+
+namespace game_engine::util {
+
+/**
+ * @brief Persistent key/value store for opaque binary blobs
+ *
+ * Each blob is a file named after its key inside a per-cache directory.  Files
+ * carry a header with a checksum so truncated or corrupted entries are
+ * detected and dropped instead of being handed back to the caller.
+ */
+class BlobCache {
+ public:
+  /**
+   * @param name Name of the cache, used as the directory name inside the user
+   *             cache directory
+   */
+  explicit BlobCache(const std::string& name);
+  BlobCache(const std::filesystem::path& directory, const bool create);
+
+  std::optional<std::vector<uint8_t>> Load(const uint64_t key) const;
+  bool Store(const uint64_t key, const std::vector<uint8_t>& data) const;
+  void Remove(const uint64_t key) const;
+
+  const std::filesystem::path& GetDirectory() const { return directory_; }
+  bool IsEnabled() const { return enabled_; }
+
+  /**
+   * @brief $XDG_CACHE_HOME/GameEngine, falling back to ~/.cache/GameEngine
+   */
+  static std::filesystem::path UserCacheDirectory();
+
+ protected:
+  std::filesystem::path PathFor(const uint64_t key) const;
+
+  std::filesystem::path directory_{};
+  bool enabled_ = false;
+
+ private:
+  logging::Log log_ = logging::Log("main");
+};
+
+} /* namespace game_engine::util */
+
+#endif /* SRC_UTIL_BLOBCACHE_HPP_ */
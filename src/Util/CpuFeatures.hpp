@@ -0,0 +1,45 @@
+/******************************************************************************
+ * CpuFeatures.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_UTIL_CPUFEATURES_HPP_
+#define SRC_UTIL_CPUFEATURES_HPP_
+
+namespace game_engine::util {
+
+/**
+ * @brief Whether the running CPU supports AVX2
+ *
+ * Kernels built with __attribute__((target("avx2"))) compile whatever the
+ * build flags, and must only be called when this returns true.
+ */
+inline bool HasAvx2() {
+#if defined(__SSE2__) && defined(__GNUC__)
+  static const bool has_avx2 = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+  }();
+  return has_avx2;
+#else
+  return false;
+#endif
+}
+
+} /* namespace game_engine::util */
+
+#endif /* SRC_UTIL_CPUFEATURES_HPP_ */
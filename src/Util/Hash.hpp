@@ -0,0 +1,85 @@
+/******************************************************************************
+ * Hash.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_UTIL_HASH_HPP_
+#define SRC_UTIL_HASH_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace game_engine::util {
+
+/**
+ * @brief Incremental 64-bit FNV-1a hash
+ *
+ * Stable across runs and platforms, so it can key data persisted to disk.
+ * Not suitable where collisions are a security concern.
+ */
+class Hasher {
+ public:
+  static constexpr uint64_t kOffsetBasis = 0xcbf29ce484222325ULL;
+  static constexpr uint64_t kPrime = 0x100000001b3ULL;
+
+  constexpr Hasher() = default;
+
+  constexpr Hasher& Add(const void* data, const std::size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; i++) {
+      hash_ ^= bytes[i];
+      hash_ *= kPrime;
+    }
+    return *this;
+  }
+  /**
+   * @brief Hash a string, including its length so that consecutive strings
+   *        cannot alias each other
+   */
+  constexpr Hasher& Add(const std::string_view str) {
+    Add(static_cast<uint64_t>(str.size()));
+    for (const char c : str) {
+      hash_ ^= static_cast<unsigned char>(c);
+      hash_ *= kPrime;
+    }
+    return *this;
+  }
+  template <typename T,
+            typename = std::enable_if_t<std::is_arithmetic_v<T> ||
+                                        std::is_enum_v<T>>>
+  constexpr Hasher& Add(const T value) {
+    return Add(&value, sizeof(value));
+  }
+
+  constexpr uint64_t Get() const { return hash_; }
+
+ private:
+  uint64_t hash_ = kOffsetBasis;
+};
+
+inline uint64_t Hash(const void* data, const std::size_t size) {
+  return Hasher().Add(data, size).Get();
+}
+inline uint64_t Hash(const std::string_view str) {
+  return Hasher().Add(str).Get();
+}
+
+} /* namespace game_engine::util */
+
+#endif /* SRC_UTIL_HASH_HPP_ */
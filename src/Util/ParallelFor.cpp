@@ -0,0 +1,60 @@
+/******************************************************************************
+ * ParallelFor.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "Util/ParallelFor.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace game_engine::util {
+
+void ParallelFor(const int count, const unsigned int max_threads,
+                 const int min_per_thread,
+                 const std::function<void(int, int)>& fn) {
+  unsigned int threads = max_threads;
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads = std::min<unsigned int>(
+      threads, std::max(1, count / std::max(1, min_per_thread)));
+  if (threads <= 1) {
+    fn(0, count);
+    return;
+  }
+
+  const int chunk = (count + static_cast<int>(threads) - 1) /
+                    static_cast<int>(threads);
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  for (unsigned int i = 1; i < threads; i++) {
+    const int begin = static_cast<int>(i) * chunk;
+    const int end = std::min(count, begin + chunk);
+    if (begin < end) {
+      workers.emplace_back(fn, begin, end);
+    }
+  }
+  fn(0, std::min(count, chunk));
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+} /* namespace game_engine::util */
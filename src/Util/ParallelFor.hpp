@@ -0,0 +1,42 @@
+/******************************************************************************
+ * ParallelFor.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_UTIL_PARALLELFOR_HPP_
+#define SRC_UTIL_PARALLELFOR_HPP_
+
+#include <functional>
+
+namespace game_engine::util {
+
+/**
+ * @brief Split [0, count) into contiguous chunks and run them on worker
+ *        threads, blocking until every chunk is done
+ * @param count Number of items
+ * @param max_threads Maximum number of threads, including the caller's.  0
+ *                    uses every hardware thread.
+ * @param min_per_thread Smallest chunk worth handing to a thread
+ * @param fn Called as fn(begin, end) once per chunk
+ */
+void ParallelFor(const int count, const unsigned int max_threads,
+                 const int min_per_thread,
+                 const std::function<void(int, int)>& fn);
+
+} /* namespace game_engine::util */
+
+#endif /* SRC_UTIL_PARALLELFOR_HPP_ */
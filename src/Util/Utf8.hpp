@@ -0,0 +1,96 @@
+/******************************************************************************
+ * Utf8.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_UTIL_UTF8_HPP_
+#define SRC_UTIL_UTF8_HPP_
+
+#include <cstddef>
+#include <string_view>
+
+namespace game_engine::util {
+
+/**
+ * @brief Code point substituted for malformed UTF-8
+ */
+constexpr char32_t kReplacementCharacter = 0xFFFD;
+
+/**
+ * @brief Decode the code point starting at offset and advance offset past it
+ *
+ * Malformed sequences, overlong encodings, surrogates and values above
+ * U+10FFFF decode to kReplacementCharacter, consuming one byte so decoding
+ * resynchronizes on the next lead byte.
+ * @param text UTF-8 text
+ * @param offset Byte offset of the code point, less than text.size()
+ * @return Returns the code point
+ */
+constexpr char32_t DecodeUtf8(const std::string_view text,
+                              std::size_t& offset) {
+  const auto byte = [&text](const std::size_t i) {
+    return static_cast<unsigned char>(text[i]);
+  };
+  const unsigned char lead = byte(offset);
+  if (lead < 0x80) {
+    offset++;
+    return lead;
+  }
+
+  std::size_t length = 0;
+  char32_t code_point = 0;
+  char32_t minimum = 0;
+  if ((lead & 0xE0) == 0xC0) {
+    length = 2;
+    code_point = lead & 0x1F;
+    minimum = 0x80;
+  } else if ((lead & 0xF0) == 0xE0) {
+    length = 3;
+    code_point = lead & 0x0F;
+    minimum = 0x800;
+  } else if ((lead & 0xF8) == 0xF0) {
+    length = 4;
+    code_point = lead & 0x07;
+    minimum = 0x10000;
+  } else {
+    offset++;
+    return kReplacementCharacter;
+  }
+  if (offset + length > text.size()) {
+    offset++;
+    return kReplacementCharacter;
+  }
+  for (std::size_t i = 1; i < length; i++) {
+    const unsigned char continuation = byte(offset + i);
+    if ((continuation & 0xC0) != 0x80) {
+      offset++;
+      return kReplacementCharacter;
+    }
+    code_point = (code_point << 6) | (continuation & 0x3F);
+  }
+  if (code_point < minimum || code_point > 0x10FFFF ||
+      (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+    offset++;
+    return kReplacementCharacter;
+  }
+  offset += length;
+  return code_point;
+}
+
+} /* namespace game_engine::util */
+
+#endif /* SRC_UTIL_UTF8_HPP_ */
@@ -0,0 +1,276 @@
+/******************************************************************************
+ * TlsfAllocator.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "Vulkan/TlsfAllocator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <optional>
+
+namespace game_engine::vulkan {
+
+void TlsfAllocator::Mapping(const std::uint64_t size, unsigned int& first,
+                            unsigned int& second) {
+  const unsigned int log2 =
+      static_cast<unsigned int>(std::bit_width(size)) - 1;
+  if (log2 < kSecondLevelBits) {
+    // Sizes below kSecondLevels get a bucket each
+    first = 0;
+    second = static_cast<unsigned int>(size);
+    return;
+  }
+  first = log2 - kSecondLevelBits + 1;
+  second = static_cast<unsigned int>(size >> (log2 - kSecondLevelBits)) -
+           kSecondLevels;
+}
+
+bool TlsfAllocator::FindSuitable(const std::uint64_t size,
+                                 unsigned int& first,
+                                 unsigned int& second) const {
+  // Round up to the next bucket boundary, so every block found fits
+  std::uint64_t rounded = size;
+  const unsigned int log2 =
+      static_cast<unsigned int>(std::bit_width(size)) - 1;
+  if (log2 >= kSecondLevelBits) {
+    rounded += (std::uint64_t{1} << (log2 - kSecondLevelBits)) - 1;
+  }
+  Mapping(rounded, first, second);
+  if (first >= kFirstLevels) {
+    return false;
+  }
+
+  std::uint32_t seconds =
+      second < kSecondLevels ? second_bitmaps_[first] & (~0u << second) : 0;
+  if (seconds == 0) {
+    const std::uint64_t firsts =
+        first + 1 < 64 ? first_bitmap_ & (~std::uint64_t{0} << (first + 1))
+                       : 0;
+    if (firsts == 0) {
+      return false;
+    }
+    first = static_cast<unsigned int>(std::countr_zero(firsts));
+    seconds = second_bitmaps_[first];
+  }
+  second = static_cast<unsigned int>(std::countr_zero(seconds));
+  return true;
+}
+
+std::uint32_t TlsfAllocator::NewBlock() {
+  if (!unused_.empty()) {
+    const std::uint32_t index = unused_.back();
+    unused_.pop_back();
+    blocks_[index] = Block{};
+    return index;
+  }
+  blocks_.emplace_back();
+  return static_cast<std::uint32_t>(blocks_.size() - 1);
+}
+
+void TlsfAllocator::InsertFree(const std::uint32_t index) {
+  Block& block = blocks_[index];
+  unsigned int first;
+  unsigned int second;
+  Mapping(block.size, first, second);
+  block.free = true;
+  block.prev_free = kNone;
+  block.next_free = heads_[first][second];
+  if (block.next_free != kNone) {
+    blocks_[block.next_free].prev_free = index;
+  }
+  heads_[first][second] = index;
+  first_bitmap_ |= std::uint64_t{1} << first;
+  second_bitmaps_[first] |= 1u << second;
+}
+
+void TlsfAllocator::RemoveFree(const std::uint32_t index) {
+  Block& block = blocks_[index];
+  unsigned int first;
+  unsigned int second;
+  Mapping(block.size, first, second);
+  if (block.prev_free != kNone) {
+    blocks_[block.prev_free].next_free = block.next_free;
+  } else {
+    heads_[first][second] = block.next_free;
+  }
+  if (block.next_free != kNone) {
+    blocks_[block.next_free].prev_free = block.prev_free;
+  }
+  if (heads_[first][second] == kNone) {
+    second_bitmaps_[first] &= ~(1u << second);
+    if (second_bitmaps_[first] == 0) {
+      first_bitmap_ &= ~(std::uint64_t{1} << first);
+    }
+  }
+  block.free = false;
+  block.prev_free = kNone;
+  block.next_free = kNone;
+}
+
+void TlsfAllocator::SplitTail(const std::uint32_t index,
+                              const std::uint64_t size) {
+  const std::uint32_t tail = NewBlock();
+  // NewBlock may have moved blocks_
+  Block& block = blocks_[index];
+  Block& rest = blocks_[tail];
+  rest.offset = block.offset + size;
+  rest.size = block.size - size;
+  rest.prev = index;
+  rest.next = block.next;
+  if (block.next != kNone) {
+    blocks_[block.next].prev = tail;
+  }
+  block.next = tail;
+  block.size = size;
+  InsertFree(tail);
+}
+
+void TlsfAllocator::MergeIntoPrev(const std::uint32_t index) {
+  Block& block = blocks_[index];
+  Block& prev = blocks_[block.prev];
+  prev.size += block.size;
+  prev.next = block.next;
+  if (block.next != kNone) {
+    blocks_[block.next].prev = block.prev;
+  }
+  unused_.push_back(index);
+}
+
+std::optional<TlsfAllocation> TlsfAllocator::Allocate(
+    const std::uint64_t size, const std::uint64_t alignment) {
+  if (size == 0 || size > size_) {
+    return std::nullopt;
+  }
+  // Any block this large holds an aligned range of size bytes
+  const std::uint64_t padded = size + (alignment > 1 ? alignment - 1 : 0);
+  const auto align = [alignment](const std::uint64_t offset) {
+    return alignment > 1 ? (offset + alignment - 1) / alignment * alignment
+                         : offset;
+  };
+  unsigned int first;
+  unsigned int second;
+  std::uint32_t index = kNone;
+  if (FindSuitable(padded, first, second)) {
+    index = heads_[first][second];
+  } else {
+    // The buckets holding only large enough blocks are empty, but the bucket
+    // the request itself falls in may still have one that fits
+    Mapping(size, first, second);
+    for (std::uint32_t i = heads_[first][second]; i != kNone;
+         i = blocks_[i].next_free) {
+      if (align(blocks_[i].offset) + size <=
+          blocks_[i].offset + blocks_[i].size) {
+        index = i;
+        break;
+      }
+    }
+    if (index == kNone) {
+      return std::nullopt;
+    }
+  }
+  RemoveFree(index);
+
+  const std::uint64_t offset = blocks_[index].offset;
+  const std::uint64_t aligned = align(offset);
+  if (aligned != offset) {
+    // Leave the padding in front free
+    SplitTail(index, aligned - offset);
+    const std::uint32_t padding = index;
+    index = blocks_[padding].next;
+    RemoveFree(index);
+    InsertFree(padding);
+  }
+  if (blocks_[index].size > size) {
+    SplitTail(index, size);
+  }
+
+  used_ += size;
+  allocation_count_++;
+  return TlsfAllocation{aligned, size, index};
+}
+
+void TlsfAllocator::Free(const std::uint32_t handle) {
+  std::uint32_t index = handle;
+  used_ -= blocks_[index].size;
+  allocation_count_--;
+
+  const std::uint32_t next = blocks_[index].next;
+  if (next != kNone && blocks_[next].free) {
+    RemoveFree(next);
+    MergeIntoPrev(next);
+  }
+  const std::uint32_t prev = blocks_[index].prev;
+  if (prev != kNone && blocks_[prev].free) {
+    RemoveFree(prev);
+    MergeIntoPrev(index);
+    index = prev;
+  }
+  InsertFree(index);
+}
+
+void TlsfAllocator::Reset(const std::uint64_t size) {
+  size_ = size;
+  used_ = 0;
+  allocation_count_ = 0;
+  first_bitmap_ = 0;
+  std::fill(std::begin(second_bitmaps_), std::end(second_bitmaps_), 0u);
+  for (auto& heads : heads_) {
+    std::fill(std::begin(heads), std::end(heads), kNone);
+  }
+  blocks_.clear();
+  unused_.clear();
+  first_block_ = kNone;
+  if (size == 0) {
+    return;
+  }
+  first_block_ = NewBlock();
+  blocks_[first_block_].size = size;
+  InsertFree(first_block_);
+}
+
+std::uint64_t TlsfAllocator::GetLargestFree() const {
+  if (first_bitmap_ == 0) {
+    return 0;
+  }
+  // Blocks in the highest bucket are larger than in any other, but not
+  // sorted within it
+  const unsigned int first =
+      static_cast<unsigned int>(std::bit_width(first_bitmap_)) - 1;
+  const unsigned int second =
+      static_cast<unsigned int>(std::bit_width(second_bitmaps_[first])) - 1;
+  std::uint64_t largest = 0;
+  for (std::uint32_t index = heads_[first][second]; index != kNone;
+       index = blocks_[index].next_free) {
+    largest = std::max(largest, blocks_[index].size);
+  }
+  return largest;
+}
+
+void TlsfAllocator::ForEachAllocation(
+    const std::function<void(const TlsfAllocation&)>& fn) const {
+  for (std::uint32_t index = first_block_; index != kNone;
+       index = blocks_[index].next) {
+    const Block& block = blocks_[index];
+    if (!block.free) {
+      fn(TlsfAllocation{block.offset, block.size, index});
+    }
+  }
+}
+
+} /* namespace game_engine::vulkan */
@@ -0,0 +1,149 @@
+/******************************************************************************
+ * TlsfAllocator.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_VULKAN_TLSFALLOCATOR_HPP_
+#define SRC_VULKAN_TLSFALLOCATOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace game_engine::vulkan {
+
+/**
+ * @brief A range handed out by TlsfAllocator
+ */
+struct TlsfAllocation {
+  std::uint64_t offset = 0;
+  std::uint64_t size = 0;
+  /**
+   * @brief Passed back to TlsfAllocator::Free
+   */
+  std::uint32_t handle = 0;
+};
+
+/**
+ * @brief Two-level segregated fit allocator over an abstract range of bytes
+ *
+ * Free ranges are kept in lists bucketed first by the power of two of their
+ * size and then by 2^kSecondLevelBits linear steps within it, with a bitmap
+ * at each level, so allocating and freeing take constant time whatever the
+ * number of allocations.  Freed ranges are merged with free neighbours
+ * immediately.  It only does the bookkeeping; VulkanAllocator uses one per
+ * block of device memory.
+ */
+class TlsfAllocator {
+ public:
+  TlsfAllocator() = default;
+  explicit TlsfAllocator(const std::uint64_t size) { Reset(size); }
+
+  /**
+   * @brief Find a free range
+   * @param alignment Power of two the offset must be a multiple of
+   * @return Returns the range, or std::nullopt if no free range is large
+   *         enough
+   */
+  std::optional<TlsfAllocation> Allocate(const std::uint64_t size,
+                                         const std::uint64_t alignment = 1);
+  void Free(const std::uint32_t handle);
+  /**
+   * @brief Forget every allocation and manage size bytes
+   */
+  void Reset(const std::uint64_t size);
+
+  std::uint64_t GetSize() const { return size_; }
+  std::uint64_t GetUsed() const { return used_; }
+  std::size_t GetAllocationCount() const { return allocation_count_; }
+  bool IsEmpty() const { return allocation_count_ == 0; }
+  /**
+   * @brief Size of the largest free range
+   */
+  std::uint64_t GetLargestFree() const;
+  /**
+   * @brief Call fn for every allocation, in order of offset
+   */
+  void ForEachAllocation(
+      const std::function<void(const TlsfAllocation&)>& fn) const;
+
+  static constexpr unsigned int kSecondLevelBits = 5;
+  static constexpr unsigned int kSecondLevels = 1u << kSecondLevelBits;
+  static constexpr unsigned int kFirstLevels = 64 - kSecondLevelBits + 1;
+
+ protected:
+  static constexpr std::uint32_t kNone = UINT32_MAX;
+
+  struct Block {
+    std::uint64_t offset = 0;
+    std::uint64_t size = 0;
+    bool free = false;
+    /**
+     * @brief Neighbours in memory
+     */
+    std::uint32_t prev = kNone;
+    std::uint32_t next = kNone;
+    /**
+     * @brief Neighbours in the free list of the block's bucket
+     */
+    std::uint32_t prev_free = kNone;
+    std::uint32_t next_free = kNone;
+  };
+
+  /**
+   * @brief Bucket holding free blocks of the given size
+   */
+  static void Mapping(const std::uint64_t size, unsigned int& first,
+                      unsigned int& second);
+  /**
+   * @brief First non-empty bucket whose blocks are all at least size bytes
+   * @return Returns false if there is none
+   */
+  bool FindSuitable(const std::uint64_t size, unsigned int& first,
+                    unsigned int& second) const;
+
+  std::uint32_t NewBlock();
+  void InsertFree(const std::uint32_t index);
+  void RemoveFree(const std::uint32_t index);
+  /**
+   * @brief Split the tail of a block off into a new free block
+   */
+  void SplitTail(const std::uint32_t index, const std::uint64_t size);
+  /**
+   * @brief Merge a block into the block before it in memory
+   */
+  void MergeIntoPrev(const std::uint32_t index);
+
+  std::uint64_t size_ = 0;
+  std::uint64_t used_ = 0;
+  std::size_t allocation_count_ = 0;
+  std::uint64_t first_bitmap_ = 0;
+  std::uint32_t second_bitmaps_[kFirstLevels] = {};
+  std::uint32_t heads_[kFirstLevels][kSecondLevels] = {};
+  std::vector<Block> blocks_{};
+  /**
+   * @brief Indices of blocks_ that can be reused
+   */
+  std::vector<std::uint32_t> unused_{};
+  std::uint32_t first_block_ = kNone;
+};
+
+} /* namespace game_engine::vulkan */
+
+#endif /* SRC_VULKAN_TLSFALLOCATOR_HPP_ */
@@ -0,0 +1,308 @@
+/******************************************************************************
+ * VulkanAllocator.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "Vulkan/VulkanAllocator.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "Vulkan/VulkanDevice.hpp"
+
+namespace game_engine::vulkan {
+
+void VulkanAllocator::Init(const VkPhysicalDevice physical_device,
+                           const VkDevice device,
+                           const VulkanAllocatorOptions& options) {
+  device_ = device;
+  options_ = options;
+  if (options_.dedicated_threshold == 0) {
+    options_.dedicated_threshold = options_.block_size / 2;
+  }
+  vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties_);
+  pools_.resize(memory_properties_.memoryTypeCount * 2);
+  dedicated_.resize(memory_properties_.memoryTypeCount);
+}
+
+void VulkanAllocator::Destroy() {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  for (Pool& pool : pools_) {
+    for (auto& block : pool.blocks) {
+      if (!block->allocator.IsEmpty()) {
+        log_.Warning("Freeing a memory block with {} live allocations.",
+                     block->allocator.GetAllocationCount());
+      }
+      vkFreeMemory(device_, block->memory, nullptr);
+    }
+  }
+  pools_.clear();
+  dedicated_.clear();
+  device_ = VK_NULL_HANDLE;
+}
+
+std::uint32_t VulkanAllocator::FindMemoryType(
+    const std::uint32_t type_bits,
+    const VkMemoryPropertyFlags properties) const {
+  for (std::uint32_t i = 0; i < memory_properties_.memoryTypeCount; i++) {
+    if ((type_bits & (1u << i)) &&
+        (memory_properties_.memoryTypes[i].propertyFlags & properties) ==
+            properties) {
+      return i;
+    }
+  }
+  throw std::runtime_error("No suitable Vulkan memory type");
+}
+
+VkDeviceSize VulkanAllocator::BlockSize(
+    const std::uint32_t memory_type) const {
+  const std::uint32_t heap =
+      memory_properties_.memoryTypes[memory_type].heapIndex;
+  return std::min(options_.block_size,
+                  memory_properties_.memoryHeaps[heap].size / 8);
+}
+
+VkDeviceMemory VulkanAllocator::AllocateMemory(
+    const VkDeviceSize size, const std::uint32_t memory_type,
+    const VulkanAllocationRequest& request, void** mapped) {
+  VkMemoryAllocateInfo info{};
+  info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  info.allocationSize = size;
+  info.memoryTypeIndex = memory_type;
+  VkMemoryDedicatedAllocateInfo dedicated{};
+  if (request.image != VK_NULL_HANDLE || request.buffer != VK_NULL_HANDLE) {
+    dedicated.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dedicated.image = request.image;
+    dedicated.buffer = request.buffer;
+    info.pNext = &dedicated;
+  }
+
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  Check(vkAllocateMemory(device_, &info, nullptr, &memory),
+        "vkAllocateMemory");
+  *mapped = nullptr;
+  if (memory_properties_.memoryTypes[memory_type].propertyFlags &
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+    const VkResult result =
+        vkMapMemory(device_, memory, 0, VK_WHOLE_SIZE, 0, mapped);
+    if (result != VK_SUCCESS) {
+      vkFreeMemory(device_, memory, nullptr);
+      Check(result, "vkMapMemory");
+    }
+  }
+  return memory;
+}
+
+VulkanAllocation VulkanAllocator::Allocate(
+    const VulkanAllocationRequest& request) {
+  const VkMemoryRequirements& requirements = request.requirements;
+  const std::uint32_t memory_type =
+      FindMemoryType(requirements.memoryTypeBits, request.properties);
+  const VkDeviceSize block_size = BlockSize(memory_type);
+
+  VulkanAllocation allocation{};
+  allocation.memory_type = memory_type;
+  allocation.size = requirements.size;
+
+  const std::lock_guard<std::mutex> lock(mutex_);
+  if (request.dedicated || requirements.size >= options_.dedicated_threshold ||
+      requirements.size > block_size) {
+    allocation.memory = AllocateMemory(requirements.size, memory_type, request,
+                                       &allocation.mapped);
+    dedicated_[memory_type].count++;
+    dedicated_[memory_type].bytes += requirements.size;
+    return allocation;
+  }
+
+  Pool& pool = pools_[PoolIndex(memory_type, request.optimal_image)];
+  // Fullest block first, so sparse blocks drain and can be released
+  std::vector<VulkanMemoryBlock*> order;
+  order.reserve(pool.blocks.size());
+  for (auto& block : pool.blocks) {
+    order.push_back(block.get());
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [](const VulkanMemoryBlock* a, const VulkanMemoryBlock* b) {
+                     return a->allocator.GetUsed() > b->allocator.GetUsed();
+                   });
+  for (VulkanMemoryBlock* block : order) {
+    const auto range = block->allocator.Allocate(requirements.size,
+                                                 requirements.alignment);
+    if (range) {
+      allocation.memory = block->memory;
+      allocation.offset = range->offset;
+      allocation.handle = range->handle;
+      allocation.block = block;
+      if (block->mapped != nullptr) {
+        allocation.mapped = static_cast<char*>(block->mapped) + range->offset;
+      }
+      return allocation;
+    }
+  }
+
+  auto block = std::make_unique<VulkanMemoryBlock>();
+  VulkanAllocationRequest shared = request;
+  shared.image = VK_NULL_HANDLE;
+  shared.buffer = VK_NULL_HANDLE;
+  block->memory =
+      AllocateMemory(block_size, memory_type, shared, &block->mapped);
+  block->memory_type = memory_type;
+  block->optimal = request.optimal_image;
+  block->allocator.Reset(block_size);
+  const auto range =
+      block->allocator.Allocate(requirements.size, requirements.alignment);
+  if (!range) {
+    vkFreeMemory(device_, block->memory, nullptr);
+    throw std::runtime_error("Allocation does not fit in a memory block");
+  }
+  allocation.memory = block->memory;
+  allocation.offset = range->offset;
+  allocation.handle = range->handle;
+  allocation.block = block.get();
+  if (block->mapped != nullptr) {
+    allocation.mapped = static_cast<char*>(block->mapped) + range->offset;
+  }
+  pool.blocks.push_back(std::move(block));
+  return allocation;
+}
+
+void VulkanAllocator::Free(VulkanAllocation& allocation) {
+  if (allocation.memory == VK_NULL_HANDLE) {
+    return;
+  }
+  const std::lock_guard<std::mutex> lock(mutex_);
+  if (allocation.block != nullptr) {
+    allocation.block->allocator.Free(allocation.handle);
+  } else {
+    vkFreeMemory(device_, allocation.memory, nullptr);
+    dedicated_[allocation.memory_type].count--;
+    dedicated_[allocation.memory_type].bytes -= allocation.size;
+  }
+  allocation = VulkanAllocation{};
+}
+
+std::vector<VulkanHeapStats> VulkanAllocator::GetHeapStats() const {
+  std::vector<VulkanHeapStats> stats(memory_properties_.memoryHeapCount);
+  for (std::uint32_t i = 0; i < memory_properties_.memoryHeapCount; i++) {
+    stats[i].heap_size = memory_properties_.memoryHeaps[i].size;
+    stats[i].flags = memory_properties_.memoryHeaps[i].flags;
+  }
+
+  const std::lock_guard<std::mutex> lock(mutex_);
+  for (const Pool& pool : pools_) {
+    for (const auto& block : pool.blocks) {
+      VulkanHeapStats& heap =
+          stats[memory_properties_.memoryTypes[block->memory_type].heapIndex];
+      heap.block_bytes += block->allocator.GetSize();
+      heap.used_bytes += block->allocator.GetUsed();
+      heap.largest_free =
+          std::max(heap.largest_free, block->allocator.GetLargestFree());
+      heap.block_count++;
+      heap.allocation_count += block->allocator.GetAllocationCount();
+    }
+  }
+  for (std::uint32_t type = 0; type < dedicated_.size(); type++) {
+    VulkanHeapStats& heap =
+        stats[memory_properties_.memoryTypes[type].heapIndex];
+    heap.dedicated_count += dedicated_[type].count;
+    heap.dedicated_bytes += dedicated_[type].bytes;
+    heap.allocation_count += dedicated_[type].count;
+  }
+  return stats;
+}
+
+std::size_t VulkanAllocator::GetDeviceMemoryCount() const {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  std::size_t count = 0;
+  for (const Pool& pool : pools_) {
+    count += pool.blocks.size();
+  }
+  for (const Dedicated& dedicated : dedicated_) {
+    count += dedicated.count;
+  }
+  return count;
+}
+
+std::vector<VulkanAllocation> VulkanAllocator::GetDefragmentationCandidates(
+    const float max_usage, const VkDeviceSize max_bytes) const {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<VulkanMemoryBlock*> sparse;
+  for (const Pool& pool : pools_) {
+    // A pool with a single block has nowhere to move allocations to
+    if (pool.blocks.size() < 2) {
+      continue;
+    }
+    for (const auto& block : pool.blocks) {
+      const TlsfAllocator& allocator = block->allocator;
+      if (!allocator.IsEmpty() &&
+          static_cast<float>(allocator.GetUsed()) <=
+              max_usage * static_cast<float>(allocator.GetSize())) {
+        sparse.push_back(block.get());
+      }
+    }
+  }
+  std::sort(sparse.begin(), sparse.end(),
+            [](const VulkanMemoryBlock* a, const VulkanMemoryBlock* b) {
+              return a->allocator.GetUsed() < b->allocator.GetUsed();
+            });
+
+  std::vector<VulkanAllocation> candidates;
+  VkDeviceSize bytes = 0;
+  for (VulkanMemoryBlock* block : sparse) {
+    if (bytes >= max_bytes) {
+      break;
+    }
+    block->allocator.ForEachAllocation([&](const TlsfAllocation& range) {
+      VulkanAllocation allocation{};
+      allocation.memory = block->memory;
+      allocation.offset = range.offset;
+      allocation.size = range.size;
+      allocation.memory_type = block->memory_type;
+      allocation.block = block;
+      allocation.handle = range.handle;
+      if (block->mapped != nullptr) {
+        allocation.mapped = static_cast<char*>(block->mapped) + range.offset;
+      }
+      candidates.push_back(allocation);
+      bytes += range.size;
+    });
+  }
+  return candidates;
+}
+
+std::size_t VulkanAllocator::ReleaseEmptyBlocks(const std::size_t keep) {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  std::size_t released = 0;
+  for (Pool& pool : pools_) {
+    std::size_t kept = 0;
+    for (auto it = pool.blocks.begin(); it != pool.blocks.end();) {
+      if (!(*it)->allocator.IsEmpty() || kept++ < keep) {
+        ++it;
+        continue;
+      }
+      vkFreeMemory(device_, (*it)->memory, nullptr);
+      it = pool.blocks.erase(it);
+      released++;
+    }
+  }
+  return released;
+}
+
+} /* namespace game_engine::vulkan */
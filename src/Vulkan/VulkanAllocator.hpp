@@ -0,0 +1,229 @@
+/******************************************************************************
+ * VulkanAllocator.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_VULKAN_VULKANALLOCATOR_HPP_
+#define SRC_VULKAN_VULKANALLOCATOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "LoggerV2/Log.hpp"
+#include "Vulkan/TlsfAllocator.hpp"
+
+namespace game_engine::vulkan {
+
+struct VulkanMemoryBlock;
+
+/**
+ * @brief A range of device memory backing a buffer or image
+ */
+struct VulkanAllocation {
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  VkDeviceSize offset = 0;
+  VkDeviceSize size = 0;
+  /**
+   * @brief Host address of the range if the memory is host visible
+   */
+  void* mapped = nullptr;
+  std::uint32_t memory_type = 0;
+  /**
+   * @brief Block the range was carved from, or nullptr if the allocation owns
+   *        its VkDeviceMemory
+   */
+  VulkanMemoryBlock* block = nullptr;
+  std::uint32_t handle = 0;
+};
+
+/**
+ * @brief One VkDeviceMemory shared by many allocations
+ */
+struct VulkanMemoryBlock {
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  /**
+   * @brief Host address of the whole block if the memory is host visible
+   */
+  void* mapped = nullptr;
+  std::uint32_t memory_type = 0;
+  /**
+   * @brief Whether the block holds optimally tiled images.  Linear and
+   *        optimal resources never share a block, so bufferImageGranularity
+   *        never has to be honoured between neighbours.
+   */
+  bool optimal = false;
+  TlsfAllocator allocator{};
+};
+
+struct VulkanAllocationRequest {
+  VkMemoryRequirements requirements{};
+  VkMemoryPropertyFlags properties = 0;
+  /**
+   * @brief The resource is an image with VK_IMAGE_TILING_OPTIMAL
+   */
+  bool optimal_image = false;
+  /**
+   * @brief Give the resource its own VkDeviceMemory, as reported by
+   *        VkMemoryDedicatedRequirements
+   */
+  bool dedicated = false;
+  /**
+   * @brief Resource a dedicated allocation is for, passed to the driver in
+   *        VkMemoryDedicatedAllocateInfo.  At most one may be set.
+   */
+  VkImage image = VK_NULL_HANDLE;
+  VkBuffer buffer = VK_NULL_HANDLE;
+};
+
+struct VulkanAllocatorOptions {
+  /**
+   * @brief Size of each VkDeviceMemory block.  Capped to an eighth of the
+   *        heap so small heaps are not exhausted by one block.
+   */
+  VkDeviceSize block_size = VkDeviceSize{64} << 20;
+  /**
+   * @brief Requests at least this large get a dedicated allocation.  0 means
+   *        half the block size.
+   */
+  VkDeviceSize dedicated_threshold = 0;
+};
+
+/**
+ * @brief Memory use of one heap
+ */
+struct VulkanHeapStats {
+  VkDeviceSize heap_size = 0;
+  VkMemoryHeapFlags flags = 0;
+  /**
+   * @brief Bytes of VkDeviceMemory allocated from the heap in blocks
+   */
+  VkDeviceSize block_bytes = 0;
+  /**
+   * @brief Bytes of the blocks handed out to resources
+   */
+  VkDeviceSize used_bytes = 0;
+  /**
+   * @brief Largest free range in any block
+   */
+  VkDeviceSize largest_free = 0;
+  std::size_t block_count = 0;
+  std::size_t allocation_count = 0;
+  std::size_t dedicated_count = 0;
+  VkDeviceSize dedicated_bytes = 0;
+};
+
+/**
+ * @brief Sub-allocates device memory
+ *
+ * Drivers limit the number of live VkDeviceMemory objects, often to 4096, and
+ * vkAllocateMemory is slow, so resources are placed in large blocks, one pool
+ * of blocks per memory type, managed with a TlsfAllocator.  Large resources
+ * and those the driver asks to be dedicated get their own VkDeviceMemory.
+ * Safe to call from several threads.
+ */
+class VulkanAllocator {
+ public:
+  VulkanAllocator() = default;
+  VulkanAllocator(const VulkanAllocator&) = delete;
+  VulkanAllocator& operator=(const VulkanAllocator&) = delete;
+
+  void Init(const VkPhysicalDevice physical_device, const VkDevice device,
+            const VulkanAllocatorOptions& options = {});
+  /**
+   * @brief Free every block.  Every allocation must have been freed.
+   */
+  void Destroy();
+
+  /**
+   * @brief Find a memory type allowed by type_bits with the given properties
+   */
+  std::uint32_t FindMemoryType(const std::uint32_t type_bits,
+                               const VkMemoryPropertyFlags properties) const;
+  VulkanAllocation Allocate(const VulkanAllocationRequest& request);
+  void Free(VulkanAllocation& allocation);
+
+  std::vector<VulkanHeapStats> GetHeapStats() const;
+  /**
+   * @brief Number of live VkDeviceMemory objects
+   */
+  std::size_t GetDeviceMemoryCount() const;
+  /**
+   * @brief Allocations worth moving to compact memory
+   *
+   * Allocations are placed in the fullest block they fit in, so moving an
+   * allocation out of a sparsely used block (allocating a new resource,
+   * copying and freeing the old one) tends to empty the block, after which
+   * ReleaseEmptyBlocks returns it to the driver.
+   *
+   * @param max_usage Blocks with at most this fraction of their bytes in use
+   *                  are candidates
+   * @param max_bytes Stop once the allocations returned add up to this many
+   *                  bytes
+   * @return Returns copies of the candidate allocations, emptiest block first
+   */
+  std::vector<VulkanAllocation> GetDefragmentationCandidates(
+      const float max_usage, const VkDeviceSize max_bytes) const;
+  /**
+   * @brief Free blocks with no allocations in them
+   * @param keep Empty blocks to keep per pool, to avoid reallocating them
+   *             when usage fluctuates
+   * @return Returns the number of blocks freed
+   */
+  std::size_t ReleaseEmptyBlocks(const std::size_t keep = 0);
+
+  const VkPhysicalDeviceMemoryProperties& GetMemoryProperties() const {
+    return memory_properties_;
+  }
+
+ protected:
+  struct Pool {
+    std::vector<std::unique_ptr<VulkanMemoryBlock>> blocks{};
+  };
+  struct Dedicated {
+    std::size_t count = 0;
+    VkDeviceSize bytes = 0;
+  };
+
+  VkDeviceMemory AllocateMemory(const VkDeviceSize size,
+                                const std::uint32_t memory_type,
+                                const VulkanAllocationRequest& request,
+                                void** mapped);
+  VkDeviceSize BlockSize(const std::uint32_t memory_type) const;
+  static std::size_t PoolIndex(const std::uint32_t memory_type,
+                               const bool optimal) {
+    return memory_type * 2 + (optimal ? 1 : 0);
+  }
+
+  VkDevice device_ = VK_NULL_HANDLE;
+  VkPhysicalDeviceMemoryProperties memory_properties_{};
+  VulkanAllocatorOptions options_{};
+  mutable std::mutex mutex_{};
+  std::vector<Pool> pools_{};
+  std::vector<Dedicated> dedicated_{};
+
+ private:
+  logging::Log log_ = logging::Log("main");
+};
+
+} /* namespace game_engine::vulkan */
+
+#endif /* SRC_VULKAN_VULKANALLOCATOR_HPP_ */
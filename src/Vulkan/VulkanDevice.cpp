@@ -0,0 +1,638 @@
+/******************************************************************************
+ * VulkanDevice.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "Vulkan/VulkanDevice.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "LoggerV2/Log.hpp"
+
+namespace game_engine::vulkan {
+
+namespace {
+
+constexpr const char* kValidationLayer = "VK_LAYER_KHRONOS_validation";
+
+VKAPI_ATTR VkBool32 VKAPI_CALL
+DebugCallback(const VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+              [[maybe_unused]] const VkDebugUtilsMessageTypeFlagsEXT types,
+              const VkDebugUtilsMessengerCallbackDataEXT* data,
+              void* user_data) {
+  const logging::Log* log = static_cast<const logging::Log*>(user_data);
+  if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) {
+    log->Error("Vulkan: {}", data->pMessage);
+  } else if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) {
+    log->Warning("Vulkan: {}", data->pMessage);
+  } else if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT) {
+    log->Debug("Vulkan: {}", data->pMessage);
+  } else {
+    log->Trace("Vulkan: {}", data->pMessage);
+  }
+  return VK_FALSE;
+}
+
+/**
+ * @brief Whether a physical device has what the renderer needs, Vulkan 1.3
+ *        with dynamic rendering, synchronization2 and a graphics queue
+ */
+bool IsSuitable(const VkPhysicalDevice device,
+                VkPhysicalDeviceProperties& properties) {
+  vkGetPhysicalDeviceProperties(device, &properties);
+  if (properties.apiVersion < VK_API_VERSION_1_3) {
+    return false;
+  }
+  VkPhysicalDeviceVulkan13Features features13{};
+  features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+  VkPhysicalDeviceFeatures2 features{};
+  features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features.pNext = &features13;
+  vkGetPhysicalDeviceFeatures2(device, &features);
+  if (!features13.dynamicRendering || !features13.synchronization2) {
+    return false;
+  }
+  std::uint32_t family_count = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(device, &family_count, nullptr);
+  std::vector<VkQueueFamilyProperties> families(family_count);
+  vkGetPhysicalDeviceQueueFamilyProperties(device, &family_count,
+                                           families.data());
+  return std::any_of(families.begin(), families.end(),
+                     [](const VkQueueFamilyProperties& family) {
+                       return family.queueFlags & VK_QUEUE_GRAPHICS_BIT;
+                     });
+}
+
+/**
+ * @brief Order in which device types are picked, lowest first
+ */
+int DeviceRank(const VkPhysicalDeviceType type, const bool prefer_software) {
+  if (prefer_software && type == VK_PHYSICAL_DEVICE_TYPE_CPU) {
+    return 0;
+  }
+  switch (type) {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+      return 1;
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+      return 2;
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+      return 3;
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:
+      return 4;
+    default:
+      return 5;
+  }
+}
+
+/**
+ * @brief Pipeline stages and accesses that use an image in a layout
+ */
+void LayoutUsage(const VkImageLayout layout, VkPipelineStageFlags2& stages,
+                 VkAccessFlags2& access) {
+  switch (layout) {
+    case VK_IMAGE_LAYOUT_UNDEFINED:
+    case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
+      stages = VK_PIPELINE_STAGE_2_NONE;
+      access = VK_ACCESS_2_NONE;
+      break;
+    case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+      stages = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+      access = VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT |
+               VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+      break;
+    case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+    case VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL:
+      stages = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT |
+               VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+      access = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+               VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+      break;
+    case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+      stages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT |
+               VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+      access = VK_ACCESS_2_SHADER_READ_BIT;
+      break;
+    case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+      stages = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+      access = VK_ACCESS_2_TRANSFER_READ_BIT;
+      break;
+    case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+      stages = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+      access = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+      break;
+    default:
+      stages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+      access = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+      break;
+  }
+}
+
+}  // namespace
+
+void Check(const VkResult result, const char* what) {
+  if (result != VK_SUCCESS) {
+    throw std::runtime_error(std::string(what) + " failed with VkResult " +
+                             std::to_string(static_cast<int>(result)));
+  }
+}
+
+bool VulkanDevice::HasDevice() {
+  std::uint32_t version = VK_API_VERSION_1_0;
+  vkEnumerateInstanceVersion(&version);
+  if (version < VK_API_VERSION_1_3) {
+    return false;
+  }
+  VkApplicationInfo app{};
+  app.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+  app.pEngineName = "GameEngine";
+  app.apiVersion = VK_API_VERSION_1_3;
+  VkInstanceCreateInfo info{};
+  info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+  info.pApplicationInfo = &app;
+  VkInstance instance = VK_NULL_HANDLE;
+  // Fails with VK_ERROR_INCOMPATIBLE_DRIVER when no driver is installed
+  if (vkCreateInstance(&info, nullptr, &instance) != VK_SUCCESS) {
+    return false;
+  }
+
+  std::uint32_t count = 0;
+  vkEnumeratePhysicalDevices(instance, &count, nullptr);
+  std::vector<VkPhysicalDevice> devices(count);
+  vkEnumeratePhysicalDevices(instance, &count, devices.data());
+  const bool found = std::any_of(
+      devices.begin(), devices.end(), [](const VkPhysicalDevice device) {
+        VkPhysicalDeviceProperties properties;
+        return IsSuitable(device, properties);
+      });
+  vkDestroyInstance(instance, nullptr);
+  return found;
+}
+
+void VulkanDevice::CreateInstance(const std::string& application,
+                                  const VulkanDeviceOptions& options) {
+  prefer_software_ = options.prefer_software;
+  allocator_options_ = options.allocator;
+
+  std::uint32_t version = VK_API_VERSION_1_0;
+  vkEnumerateInstanceVersion(&version);
+  if (version < VK_API_VERSION_1_3) {
+    throw std::runtime_error("Vulkan 1.3 is not available");
+  }
+
+  std::vector<const char*> extensions = options.instance_extensions;
+  std::vector<const char*> layers;
+  bool validation = false;
+  if (options.validation) {
+    std::uint32_t count = 0;
+    vkEnumerateInstanceLayerProperties(&count, nullptr);
+    std::vector<VkLayerProperties> available(count);
+    vkEnumerateInstanceLayerProperties(&count, available.data());
+    validation = std::any_of(available.begin(), available.end(),
+                             [](const VkLayerProperties& layer) {
+                               return std::strcmp(layer.layerName,
+                                                  kValidationLayer) == 0;
+                             });
+    if (validation) {
+      layers.push_back(kValidationLayer);
+      extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+    } else {
+      log_.Warning("{} is not installed, running without validation.",
+                   kValidationLayer);
+    }
+  }
+
+  VkApplicationInfo app{};
+  app.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+  app.pApplicationName = application.c_str();
+  app.applicationVersion = 1;
+  app.pEngineName = "GameEngine";
+  app.engineVersion = 1;
+  app.apiVersion = VK_API_VERSION_1_3;
+
+  VkInstanceCreateInfo info{};
+  info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+  info.pApplicationInfo = &app;
+  info.enabledLayerCount = static_cast<std::uint32_t>(layers.size());
+  info.ppEnabledLayerNames = layers.data();
+  info.enabledExtensionCount = static_cast<std::uint32_t>(extensions.size());
+  info.ppEnabledExtensionNames = extensions.data();
+  Check(vkCreateInstance(&info, nullptr, &instance_), "vkCreateInstance");
+
+  if (validation) {
+    VkDebugUtilsMessengerCreateInfoEXT messenger{};
+    messenger.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+    messenger.messageSeverity =
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT |
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT |
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT |
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+    messenger.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT |
+                            VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
+                            VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+    messenger.pfnUserCallback = DebugCallback;
+    messenger.pUserData = &log_;
+    const auto create = reinterpret_cast<PFN_vkCreateDebugUtilsMessengerEXT>(
+        vkGetInstanceProcAddr(instance_, "vkCreateDebugUtilsMessengerEXT"));
+    if (create != nullptr) {
+      Check(create(instance_, &messenger, nullptr, &messenger_),
+            "vkCreateDebugUtilsMessengerEXT");
+    }
+  }
+}
+
+void VulkanDevice::CreateDevice(const VkSurfaceKHR surface) {
+  std::uint32_t count = 0;
+  vkEnumeratePhysicalDevices(instance_, &count, nullptr);
+  std::vector<VkPhysicalDevice> devices(count);
+  vkEnumeratePhysicalDevices(instance_, &count, devices.data());
+
+  int best_rank = -1;
+  for (const VkPhysicalDevice device : devices) {
+    VkPhysicalDeviceProperties properties;
+    if (!IsSuitable(device, properties)) {
+      continue;
+    }
+
+    std::uint32_t family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> families(family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &family_count,
+                                             families.data());
+    for (std::uint32_t i = 0; i < family_count; i++) {
+      if (!(families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+        continue;
+      }
+      if (surface != VK_NULL_HANDLE) {
+        VkBool32 present = VK_FALSE;
+        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &present);
+        if (!present) {
+          continue;
+        }
+      }
+      const int rank = DeviceRank(properties.deviceType, prefer_software_);
+      if (best_rank < 0 || rank < best_rank) {
+        best_rank = rank;
+        physical_device_ = device;
+        queue_family_ = i;
+        properties_ = properties;
+        timestamps_ = families[i].timestampValidBits > 0 &&
+                      properties.limits.timestampPeriod > 0.0f;
+      }
+      break;
+    }
+  }
+  if (physical_device_ == VK_NULL_HANDLE) {
+    throw std::runtime_error(
+        "No Vulkan 1.3 device with dynamic rendering and synchronization2");
+  }
+  log_.Info("Using Vulkan device {}.", properties_.deviceName);
+
+  const float priority = 1.0f;
+  VkDeviceQueueCreateInfo queue{};
+  queue.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+  queue.queueFamilyIndex = queue_family_;
+  queue.queueCount = 1;
+  queue.pQueuePriorities = &priority;
+
+  VkPhysicalDeviceVulkan13Features features13{};
+  features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+  features13.dynamicRendering = VK_TRUE;
+  features13.synchronization2 = VK_TRUE;
+  VkPhysicalDeviceFeatures2 features{};
+  features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features.pNext = &features13;
+
+  std::vector<const char*> extensions;
+  if (surface != VK_NULL_HANDLE) {
+    extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+  }
+
+  VkDeviceCreateInfo info{};
+  info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  info.pNext = &features;
+  info.queueCreateInfoCount = 1;
+  info.pQueueCreateInfos = &queue;
+  info.enabledExtensionCount = static_cast<std::uint32_t>(extensions.size());
+  info.ppEnabledExtensionNames = extensions.data();
+  Check(vkCreateDevice(physical_device_, &info, nullptr, &device_),
+        "vkCreateDevice");
+  vkGetDeviceQueue(device_, queue_family_, 0, &queue_);
+
+  VkCommandPoolCreateInfo pool{};
+  pool.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  pool.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+  pool.queueFamilyIndex = queue_family_;
+  Check(vkCreateCommandPool(device_, &pool, nullptr, &immediate_pool_),
+        "vkCreateCommandPool");
+  VkFenceCreateInfo fence{};
+  fence.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  Check(vkCreateFence(device_, &fence, nullptr, &immediate_fence_),
+        "vkCreateFence");
+  allocator_.Init(physical_device_, device_, allocator_options_);
+}
+
+void VulkanDevice::Destroy() {
+  if (device_ != VK_NULL_HANDLE) {
+    vkDeviceWaitIdle(device_);
+    vkDestroyFence(device_, immediate_fence_, nullptr);
+    vkDestroyCommandPool(device_, immediate_pool_, nullptr);
+    allocator_.Destroy();
+    vkDestroyDevice(device_, nullptr);
+    device_ = VK_NULL_HANDLE;
+  }
+  if (messenger_ != VK_NULL_HANDLE) {
+    const auto destroy =
+        reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>(
+            vkGetInstanceProcAddr(instance_,
+                                  "vkDestroyDebugUtilsMessengerEXT"));
+    if (destroy != nullptr) {
+      destroy(instance_, messenger_, nullptr);
+    }
+    messenger_ = VK_NULL_HANDLE;
+  }
+  if (instance_ != VK_NULL_HANDLE) {
+    vkDestroyInstance(instance_, nullptr);
+    instance_ = VK_NULL_HANDLE;
+  }
+}
+
+std::uint32_t VulkanDevice::FindMemoryType(
+    const std::uint32_t type_bits,
+    const VkMemoryPropertyFlags properties) const {
+  return allocator_.FindMemoryType(type_bits, properties);
+}
+
+VulkanAllocation VulkanDevice::Allocate(
+    const VulkanAllocationRequest& request) const {
+  return allocator_.Allocate(request);
+}
+
+void VulkanDevice::Free(VulkanAllocation& allocation) const {
+  allocator_.Free(allocation);
+}
+
+VulkanBuffer VulkanDevice::CreateBuffer(const VkDeviceSize size,
+                                        const VkBufferUsageFlags usage,
+                                        const bool host_visible) const {
+  VkBufferCreateInfo info{};
+  info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  info.size = size;
+  info.usage = usage;
+  info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+  VulkanBuffer buffer{};
+  buffer.size = size;
+  Check(vkCreateBuffer(device_, &info, nullptr, &buffer.buffer),
+        "vkCreateBuffer");
+  VkBufferMemoryRequirementsInfo2 query{};
+  query.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+  query.buffer = buffer.buffer;
+  VkMemoryDedicatedRequirements dedicated{};
+  dedicated.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+  VkMemoryRequirements2 requirements{};
+  requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+  requirements.pNext = &dedicated;
+  vkGetBufferMemoryRequirements2(device_, &query, &requirements);
+
+  VulkanAllocationRequest request{};
+  request.requirements = requirements.memoryRequirements;
+  request.properties = host_visible ? VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+                                    : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+  if (dedicated.prefersDedicatedAllocation ||
+      dedicated.requiresDedicatedAllocation) {
+    request.dedicated = true;
+    request.buffer = buffer.buffer;
+  }
+  buffer.allocation = Allocate(request);
+  Check(vkBindBufferMemory(device_, buffer.buffer, buffer.allocation.memory,
+                           buffer.allocation.offset),
+        "vkBindBufferMemory");
+  return buffer;
+}
+
+void VulkanDevice::DestroyBuffer(VulkanBuffer& buffer) const {
+  if (buffer.buffer != VK_NULL_HANDLE) {
+    vkDestroyBuffer(device_, buffer.buffer, nullptr);
+  }
+  Free(buffer.allocation);
+  buffer = VulkanBuffer{};
+}
+
+VulkanImage VulkanDevice::CreateImage(const VulkanImageDesc& desc) const {
+  VulkanImage image{};
+  image.format = desc.format;
+  image.extent = desc.extent;
+  image.aspect = AspectOf(desc.format);
+  image.samples = desc.samples;
+  image.mip_levels = desc.mip_levels;
+  image.layers = desc.layers;
+  image.view_type = desc.view_type;
+
+  VkImageCreateInfo info{};
+  info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  if (desc.view_type == VK_IMAGE_VIEW_TYPE_CUBE) {
+    info.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+  }
+  info.imageType = VK_IMAGE_TYPE_2D;
+  info.format = desc.format;
+  info.extent = {desc.extent.width, desc.extent.height, 1};
+  info.mipLevels = desc.mip_levels;
+  info.arrayLayers = desc.layers;
+  info.samples = desc.samples;
+  info.tiling = VK_IMAGE_TILING_OPTIMAL;
+  info.usage = desc.usage;
+  info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  Check(vkCreateImage(device_, &info, nullptr, &image.image), "vkCreateImage");
+
+  VkImageMemoryRequirementsInfo2 query{};
+  query.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+  query.image = image.image;
+  VkMemoryDedicatedRequirements dedicated{};
+  dedicated.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+  VkMemoryRequirements2 requirements{};
+  requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+  requirements.pNext = &dedicated;
+  vkGetImageMemoryRequirements2(device_, &query, &requirements);
+
+  VulkanAllocationRequest request{};
+  request.requirements = requirements.memoryRequirements;
+  request.properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+  request.optimal_image = true;
+  // Render targets are usually the ones drivers want dedicated
+  if (dedicated.prefersDedicatedAllocation ||
+      dedicated.requiresDedicatedAllocation) {
+    request.dedicated = true;
+    request.image = image.image;
+  }
+  image.allocation = Allocate(request);
+  Check(vkBindImageMemory(device_, image.image, image.allocation.memory,
+                          image.allocation.offset),
+        "vkBindImageMemory");
+
+  VkImageViewCreateInfo view{};
+  view.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  view.image = image.image;
+  view.viewType = desc.view_type;
+  view.format = desc.format;
+  view.components = desc.swizzle;
+  view.subresourceRange.aspectMask = image.aspect;
+  view.subresourceRange.baseMipLevel = 0;
+  view.subresourceRange.levelCount = desc.mip_levels;
+  view.subresourceRange.baseArrayLayer = 0;
+  view.subresourceRange.layerCount = desc.layers;
+  Check(vkCreateImageView(device_, &view, nullptr, &image.view),
+        "vkCreateImageView");
+  return image;
+}
+
+void VulkanDevice::DestroyImage(VulkanImage& image) const {
+  if (image.view != VK_NULL_HANDLE) {
+    vkDestroyImageView(device_, image.view, nullptr);
+  }
+  if (image.image != VK_NULL_HANDLE) {
+    vkDestroyImage(device_, image.image, nullptr);
+  }
+  Free(image.allocation);
+  image = VulkanImage{};
+}
+
+void VulkanDevice::SubmitImmediate(
+    const std::function<void(VkCommandBuffer)>& record) const {
+  VkCommandBufferAllocateInfo allocate{};
+  allocate.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  allocate.commandPool = immediate_pool_;
+  allocate.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  allocate.commandBufferCount = 1;
+  VkCommandBuffer cmd;
+  Check(vkAllocateCommandBuffers(device_, &allocate, &cmd),
+        "vkAllocateCommandBuffers");
+
+  VkCommandBufferBeginInfo begin{};
+  begin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  Check(vkBeginCommandBuffer(cmd, &begin), "vkBeginCommandBuffer");
+  record(cmd);
+  Check(vkEndCommandBuffer(cmd), "vkEndCommandBuffer");
+
+  VkSubmitInfo submit{};
+  submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submit.commandBufferCount = 1;
+  submit.pCommandBuffers = &cmd;
+  Check(vkQueueSubmit(queue_, 1, &submit, immediate_fence_), "vkQueueSubmit");
+  Check(vkWaitForFences(device_, 1, &immediate_fence_, VK_TRUE, UINT64_MAX),
+        "vkWaitForFences");
+  vkResetFences(device_, 1, &immediate_fence_);
+  vkFreeCommandBuffers(device_, immediate_pool_, 1, &cmd);
+}
+
+void VulkanDevice::TransitionImage(const VkCommandBuffer cmd,
+                                   VulkanImage& image,
+                                   const VkImageLayout layout) {
+  TransitionImage(cmd, image.image, image.aspect, image.layout, layout);
+  image.layout = layout;
+}
+
+void VulkanDevice::TransitionImage(const VkCommandBuffer cmd,
+                                   const VkImage image,
+                                   const VkImageAspectFlags aspect,
+                                   const VkImageLayout old_layout,
+                                   const VkImageLayout new_layout) {
+  VkImageMemoryBarrier2 barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+  LayoutUsage(old_layout, barrier.srcStageMask, barrier.srcAccessMask);
+  LayoutUsage(new_layout, barrier.dstStageMask, barrier.dstAccessMask);
+  // Only writes need to be made available, reads just need ordering
+  barrier.srcAccessMask &= VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+                           VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                           VK_ACCESS_2_TRANSFER_WRITE_BIT |
+                           VK_ACCESS_2_MEMORY_WRITE_BIT;
+  if (new_layout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR) {
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT;
+  }
+  barrier.oldLayout = old_layout;
+  barrier.newLayout = new_layout;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange.aspectMask = aspect;
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+  VkDependencyInfo dependency{};
+  dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+  dependency.imageMemoryBarrierCount = 1;
+  dependency.pImageMemoryBarriers = &barrier;
+  vkCmdPipelineBarrier2(cmd, &dependency);
+}
+
+VkFormat VulkanDevice::FindDepthFormat(
+    const std::vector<VkFormat>& candidates) const {
+  for (const VkFormat format : candidates) {
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(physical_device_, format,
+                                        &properties);
+    if (properties.optimalTilingFeatures &
+        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+      return format;
+    }
+  }
+  throw std::runtime_error("No supported Vulkan depth format");
+}
+
+bool VulkanDevice::SupportsLinearBlit(const VkFormat format) const {
+  VkFormatProperties properties;
+  vkGetPhysicalDeviceFormatProperties(physical_device_, format, &properties);
+  constexpr VkFormatFeatureFlags kRequired =
+      VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+      VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+  return (properties.optimalTilingFeatures & kRequired) == kRequired;
+}
+
+VkImageAspectFlags VulkanDevice::AspectOf(const VkFormat format) {
+  switch (format) {
+    case VK_FORMAT_D16_UNORM:
+    case VK_FORMAT_X8_D24_UNORM_PACK32:
+    case VK_FORMAT_D32_SFLOAT:
+      return VK_IMAGE_ASPECT_DEPTH_BIT;
+    case VK_FORMAT_D16_UNORM_S8_UINT:
+    case VK_FORMAT_D24_UNORM_S8_UINT:
+    case VK_FORMAT_D32_SFLOAT_S8_UINT:
+      return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    case VK_FORMAT_S8_UINT:
+      return VK_IMAGE_ASPECT_STENCIL_BIT;
+    default:
+      return VK_IMAGE_ASPECT_COLOR_BIT;
+  }
+}
+
+bool VulkanDevice::HasStencil(const VkFormat format) {
+  return (AspectOf(format) & VK_IMAGE_ASPECT_STENCIL_BIT) != 0;
+}
+
+} /* namespace game_engine::vulkan */
@@ -0,0 +1,209 @@
+/******************************************************************************
+ * VulkanDevice.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_VULKAN_VULKANDEVICE_HPP_
+#define SRC_VULKAN_VULKANDEVICE_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "LoggerV2/Log.hpp"
+#include "Vulkan/VulkanAllocator.hpp"
+
+namespace game_engine::vulkan {
+
+/**
+ * @brief Throw a std::runtime_error if a Vulkan call failed
+ * @param result Result returned by the call
+ * @param what Name of the call, for the error message
+ */
+void Check(const VkResult result, const char* what);
+
+/**
+ * @brief Options for creating the instance and device
+ */
+struct VulkanDeviceOptions {
+  /**
+   * @brief Enable VK_LAYER_KHRONOS_validation when it is installed
+   */
+  bool validation = false;
+  /**
+   * @brief Prefer a CPU implementation such as lavapipe over any GPU
+   */
+  bool prefer_software = false;
+  /**
+   * @brief Instance extensions needed by the window system
+   */
+  std::vector<const char*> instance_extensions{};
+  VulkanAllocatorOptions allocator{};
+};
+
+struct VulkanBuffer {
+  VkBuffer buffer = VK_NULL_HANDLE;
+  VulkanAllocation allocation{};
+  VkDeviceSize size = 0;
+};
+
+struct VulkanImageDesc {
+  VkExtent2D extent{0, 0};
+  VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+  VkImageUsageFlags usage = 0;
+  VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+  std::uint32_t mip_levels = 1;
+  /**
+   * @brief Array layers, 6 for cubemaps
+   */
+  std::uint32_t layers = 1;
+  VkImageViewType view_type = VK_IMAGE_VIEW_TYPE_2D;
+  VkComponentMapping swizzle{};
+};
+
+struct VulkanImage {
+  VkImage image = VK_NULL_HANDLE;
+  VkImageView view = VK_NULL_HANDLE;
+  VulkanAllocation allocation{};
+  VkFormat format = VK_FORMAT_UNDEFINED;
+  VkExtent2D extent{0, 0};
+  VkImageAspectFlags aspect = 0;
+  VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+  std::uint32_t mip_levels = 1;
+  std::uint32_t layers = 1;
+  VkImageViewType view_type = VK_IMAGE_VIEW_TYPE_2D;
+  /**
+   * @brief Layout the image will be in once the commands recorded so far
+   *        have executed
+   */
+  VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+};
+
+/**
+ * @brief Owns the instance, the device and its graphics queue
+ *
+ * Requires Vulkan 1.3 for dynamic rendering and synchronization2, which Mesa's
+ * lavapipe provides, so everything also runs without a GPU.
+ */
+class VulkanDevice {
+ public:
+  /**
+   * @brief Whether any device CreateDevice could pick exists, checked with a
+   *        throwaway instance
+   */
+  static bool HasDevice();
+
+  /**
+   * @brief Create the instance.  Call CreateDevice once the window surface,
+   *        if any, exists.
+   */
+  void CreateInstance(const std::string& application,
+                      const VulkanDeviceOptions& options);
+  /**
+   * @brief Pick a physical device and create the logical device
+   * @param surface Surface the queue must be able to present to, or
+   *                VK_NULL_HANDLE when rendering offscreen
+   */
+  void CreateDevice(const VkSurfaceKHR surface);
+  void Destroy();
+
+  /**
+   * @brief Find a memory type allowed by type_bits with the given properties
+   */
+  std::uint32_t FindMemoryType(const std::uint32_t type_bits,
+                               const VkMemoryPropertyFlags properties) const;
+  VulkanAllocation Allocate(const VulkanAllocationRequest& request) const;
+  void Free(VulkanAllocation& allocation) const;
+
+  /**
+   * @brief Create a buffer
+   * @param host_visible Back the buffer with persistently mapped, coherent
+   *                     memory instead of device local memory
+   */
+  VulkanBuffer CreateBuffer(const VkDeviceSize size,
+                            const VkBufferUsageFlags usage,
+                            const bool host_visible) const;
+  void DestroyBuffer(VulkanBuffer& buffer) const;
+  /**
+   * @brief Create a 2D image, array or cubemap in device local memory, and a
+   *        view of all of it
+   */
+  VulkanImage CreateImage(const VulkanImageDesc& desc) const;
+  void DestroyImage(VulkanImage& image) const;
+
+  /**
+   * @brief Record commands into a one-time command buffer, submit it and
+   *        wait for it to finish.  Only meant for loading.
+   */
+  void SubmitImmediate(
+      const std::function<void(VkCommandBuffer)>& record) const;
+
+  /**
+   * @brief Record a barrier moving an image to a new layout, ordered after
+   *        every earlier use of it
+   */
+  static void TransitionImage(const VkCommandBuffer cmd, VulkanImage& image,
+                              const VkImageLayout layout);
+  static void TransitionImage(const VkCommandBuffer cmd, const VkImage image,
+                              const VkImageAspectFlags aspect,
+                              const VkImageLayout old_layout,
+                              const VkImageLayout new_layout);
+
+  /**
+   * @brief First depth format among candidates usable as a depth attachment
+   */
+  VkFormat FindDepthFormat(const std::vector<VkFormat>& candidates) const;
+  bool SupportsLinearBlit(const VkFormat format) const;
+
+  static VkImageAspectFlags AspectOf(const VkFormat format);
+  static bool HasStencil(const VkFormat format);
+
+ public:
+  VkInstance instance_ = VK_NULL_HANDLE;
+  VkPhysicalDevice physical_device_ = VK_NULL_HANDLE;
+  VkDevice device_ = VK_NULL_HANDLE;
+  VkQueue queue_ = VK_NULL_HANDLE;
+  std::uint32_t queue_family_ = 0;
+  VkPhysicalDeviceProperties properties_{};
+  /**
+   * @brief Whether the queue can write timestamps
+   */
+  bool timestamps_ = false;
+  /**
+   * @brief Sub-allocates the memory of every buffer and image created
+   *        through the device
+   */
+  mutable VulkanAllocator allocator_{};
+
+ protected:
+  VulkanAllocatorOptions allocator_options_{};
+  VkDebugUtilsMessengerEXT messenger_ = VK_NULL_HANDLE;
+  VkCommandPool immediate_pool_ = VK_NULL_HANDLE;
+  VkFence immediate_fence_ = VK_NULL_HANDLE;
+  bool prefer_software_ = false;
+
+ private:
+  logging::Log log_ = logging::Log("main");
+};
+
+} /* namespace game_engine::vulkan */
+
+#endif /* SRC_VULKAN_VULKANDEVICE_HPP_ */
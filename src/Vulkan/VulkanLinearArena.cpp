@@ -0,0 +1,86 @@
+/******************************************************************************
+ * VulkanLinearArena.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "Vulkan/VulkanLinearArena.hpp"
+
+#include <algorithm>
+
+namespace game_engine::vulkan {
+
+void VulkanLinearArena::Init(const VulkanDevice* device,
+                             const VkDeviceSize capacity,
+                             const VkBufferUsageFlags usage) {
+  device_ = device;
+  usage_ = usage;
+  AddBuffer(capacity);
+}
+
+void VulkanLinearArena::Destroy() {
+  for (VulkanBuffer& buffer : buffers_) {
+    device_->DestroyBuffer(buffer);
+  }
+  buffers_.clear();
+  offset_ = 0;
+  used_ = 0;
+}
+
+void VulkanLinearArena::AddBuffer(const VkDeviceSize size) {
+  buffers_.push_back(device_->CreateBuffer(size, usage_, true));
+  offset_ = 0;
+}
+
+VulkanArenaSlice VulkanLinearArena::Allocate(const VkDeviceSize size,
+                                             const VkDeviceSize alignment) {
+  VkDeviceSize offset = (offset_ + alignment - 1) / alignment * alignment;
+  if (buffers_.empty() || offset + size > buffers_.back().size) {
+    // Grow geometrically so a frame needs few overflow buffers
+    AddBuffer(std::max(size, GetCapacity()));
+    offset = 0;
+  }
+  VulkanBuffer& buffer = buffers_.back();
+  offset_ = offset + size;
+  used_ += size;
+
+  VulkanArenaSlice slice{};
+  slice.buffer = buffer.buffer;
+  slice.offset = offset;
+  slice.size = size;
+  slice.mapped = static_cast<char*>(buffer.allocation.mapped) + offset;
+  return slice;
+}
+
+void VulkanLinearArena::Reset() {
+  if (buffers_.size() > 1) {
+    const VkDeviceSize capacity = GetCapacity();
+    Destroy();
+    AddBuffer(capacity);
+  }
+  offset_ = 0;
+  used_ = 0;
+}
+
+VkDeviceSize VulkanLinearArena::GetCapacity() const {
+  VkDeviceSize capacity = 0;
+  for (const VulkanBuffer& buffer : buffers_) {
+    capacity += buffer.size;
+  }
+  return capacity;
+}
+
+} /* namespace game_engine::vulkan */
@@ -0,0 +1,100 @@
+/******************************************************************************
+ * VulkanLinearArena.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_VULKAN_VULKANLINEARARENA_HPP_
+#define SRC_VULKAN_VULKANLINEARARENA_HPP_
+
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "Vulkan/VulkanDevice.hpp"
+
+namespace game_engine::vulkan {
+
+/**
+ * @brief A range of a VulkanLinearArena
+ */
+struct VulkanArenaSlice {
+  VkBuffer buffer = VK_NULL_HANDLE;
+  VkDeviceSize offset = 0;
+  VkDeviceSize size = 0;
+  /**
+   * @brief Host address of the range
+   */
+  void* mapped = nullptr;
+};
+
+/**
+ * @brief Bump allocator over host visible buffers, for data that lives for a
+ *        single frame such as uploads and readbacks
+ *
+ * Allocating is a pointer increment and everything is released at once by
+ * Reset, which must only be called once the GPU is done with the frame.  When
+ * the arena runs out it chains another buffer, and the next Reset replaces
+ * the chain with one buffer large enough for the whole frame, so it settles
+ * at the frame's peak use after the first few frames.
+ */
+class VulkanLinearArena {
+ public:
+  VulkanLinearArena() = default;
+
+  /**
+   * @param device Device the buffers are created on.  Must outlive the
+   *               arena.
+   * @param capacity Initial size in bytes
+   * @param usage Usage of the buffers, e.g. VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+   */
+  void Init(const VulkanDevice* device, const VkDeviceSize capacity,
+            const VkBufferUsageFlags usage);
+  void Destroy();
+
+  VulkanArenaSlice Allocate(const VkDeviceSize size,
+                            const VkDeviceSize alignment = 16);
+  /**
+   * @brief Release every slice
+   */
+  void Reset();
+
+  /**
+   * @brief Bytes handed out since the last Reset
+   */
+  VkDeviceSize GetUsed() const { return used_; }
+  /**
+   * @brief Bytes of all the buffers of the arena
+   */
+  VkDeviceSize GetCapacity() const;
+
+ protected:
+  void AddBuffer(const VkDeviceSize size);
+
+  const VulkanDevice* device_ = nullptr;
+  VkBufferUsageFlags usage_ = 0;
+  /**
+   * @brief Buffers in the order they were added.  Only the last one has free
+   *        space.
+   */
+  std::vector<VulkanBuffer> buffers_{};
+  VkDeviceSize offset_ = 0;
+  VkDeviceSize used_ = 0;
+};
+
+} /* namespace game_engine::vulkan */
+
+#endif /* SRC_VULKAN_VULKANLINEARARENA_HPP_ */
@@ -0,0 +1,130 @@
+/******************************************************************************
+ * VulkanPipelineCache.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "Vulkan/VulkanPipelineCache.hpp"
+
+#include <cstring>
+#include <mutex>
+#include <optional>
+
+#include "Util/Hash.hpp"
+#include "Vulkan/VulkanDevice.hpp"
+
+namespace game_engine::vulkan {
+
+bool VulkanPipelineCache::IsCompatible(
+    const std::vector<std::uint8_t>& data,
+    const VkPhysicalDeviceProperties& properties) {
+  VkPipelineCacheHeaderVersionOne header{};
+  if (data.size() < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+  return header.headerSize >= sizeof(header) &&
+         header.headerSize <= data.size() &&
+         header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+         header.vendorID == properties.vendorID &&
+         header.deviceID == properties.deviceID &&
+         std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID,
+                     VK_UUID_SIZE) == 0;
+}
+
+void VulkanPipelineCache::Init(const VkDevice device,
+                               const VkPhysicalDeviceProperties& properties,
+                               const std::filesystem::path& directory) {
+  device_ = device;
+  blobs_ = std::make_unique<util::BlobCache>(
+      directory.empty() ? util::BlobCache::UserCacheDirectory() / "vulkan"
+                        : directory,
+      true);
+  key_ = util::Hasher()
+             .Add("VkPipelineCache")
+             .Add(properties.vendorID)
+             .Add(properties.deviceID)
+             .Get();
+
+  std::vector<std::uint8_t> data;
+  if (blobs_->IsEnabled()) {
+    std::optional<std::vector<std::uint8_t>> blob = blobs_->Load(key_);
+    if (blob && IsCompatible(*blob, properties)) {
+      data = std::move(*blob);
+    } else if (blob) {
+      log_.Info("Discarding a pipeline cache from another driver.");
+      blobs_->Remove(key_);
+    }
+  }
+
+  VkPipelineCacheCreateInfo info{};
+  info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  info.initialDataSize = data.size();
+  info.pInitialData = data.data();
+  VkResult result = vkCreatePipelineCache(device_, &info, nullptr, &cache_);
+  if (result != VK_SUCCESS && !data.empty()) {
+    log_.Warning("The driver rejected the saved pipeline cache.");
+    data.clear();
+    info.initialDataSize = 0;
+    info.pInitialData = nullptr;
+    result = vkCreatePipelineCache(device_, &info, nullptr, &cache_);
+  }
+  Check(result, "vkCreatePipelineCache");
+  loaded_ = !data.empty();
+  saved_size_ = data.size();
+  log_.Debug("Pipeline cache {} ({} bytes, directory {}).",
+             loaded_ ? "loaded" : "created", data.size(),
+             blobs_->GetDirectory().string());
+}
+
+void VulkanPipelineCache::Destroy() {
+  if (cache_ == VK_NULL_HANDLE) {
+    return;
+  }
+  Save();
+  vkDestroyPipelineCache(device_, cache_, nullptr);
+  cache_ = VK_NULL_HANDLE;
+  blobs_.reset();
+}
+
+bool VulkanPipelineCache::Save() {
+  const std::lock_guard<std::mutex> lock(save_mutex_);
+  if (cache_ == VK_NULL_HANDLE || !blobs_->IsEnabled()) {
+    return false;
+  }
+  std::size_t size = 0;
+  if (vkGetPipelineCacheData(device_, cache_, &size, nullptr) != VK_SUCCESS ||
+      size == saved_size_) {
+    return false;
+  }
+  std::vector<std::uint8_t> data(size);
+  // Pipelines created since the size query can make the data grow, in which
+  // case the driver returns VK_INCOMPLETE with what fitted
+  const VkResult result =
+      vkGetPipelineCacheData(device_, cache_, &size, data.data());
+  if (result != VK_SUCCESS && result != VK_INCOMPLETE) {
+    return false;
+  }
+  data.resize(size);
+  if (!blobs_->Store(key_, data)) {
+    return false;
+  }
+  saved_size_ = size;
+  log_.Debug("Saved {} bytes of pipeline cache.", size);
+  return true;
+}
+
+} /* namespace game_engine::vulkan */
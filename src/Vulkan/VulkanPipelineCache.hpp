@@ -0,0 +1,106 @@
+/******************************************************************************
+ * VulkanPipelineCache.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_VULKAN_VULKANPIPELINECACHE_HPP_
+#define SRC_VULKAN_VULKANPIPELINECACHE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "LoggerV2/Log.hpp"
+#include "Util/BlobCache.hpp"
+
+namespace game_engine::vulkan {
+
+/**
+ * @brief A VkPipelineCache persisted across runs
+ *
+ * The data is stored in a BlobCache keyed by the vendor and device ids, so
+ * each GPU of a machine has its own entry and a driver update overwrites the
+ * entry of the old driver.  Loaded data is only handed to the driver if its
+ * header matches the device, vendor and pipeline cache UUID of the device;
+ * drivers are supposed to reject foreign data themselves but not all do.
+ */
+class VulkanPipelineCache {
+ public:
+  VulkanPipelineCache() = default;
+  VulkanPipelineCache(const VulkanPipelineCache&) = delete;
+  VulkanPipelineCache& operator=(const VulkanPipelineCache&) = delete;
+
+  /**
+   * @brief Create the cache, seeded with the data saved by an earlier run
+   * @param directory Directory of the cache files.  Empty uses a vulkan
+   *                  directory in the user cache directory.
+   */
+  void Init(const VkDevice device, const VkPhysicalDeviceProperties& properties,
+            const std::filesystem::path& directory = {});
+  /**
+   * @brief Save and destroy the cache
+   */
+  void Destroy();
+
+  /**
+   * @brief Write the cache to disk if pipelines were added since it was last
+   *        loaded or saved.  Safe to call while pipelines are being created.
+   * @return Returns true if the data was written
+   */
+  bool Save();
+
+  VkPipelineCache Get() const { return cache_; }
+  /**
+   * @brief Whether Init found usable data from an earlier run
+   */
+  bool WasLoaded() const { return loaded_; }
+
+  /**
+   * @brief Whether data starts with a pipeline cache header matching the
+   *        device
+   */
+  static bool IsCompatible(const std::vector<std::uint8_t>& data,
+                           const VkPhysicalDeviceProperties& properties);
+
+ protected:
+  VkDevice device_ = VK_NULL_HANDLE;
+  VkPipelineCache cache_ = VK_NULL_HANDLE;
+  std::unique_ptr<util::BlobCache> blobs_{};
+  std::uint64_t key_ = 0;
+  bool loaded_ = false;
+  /**
+   * @brief Serializes saves, which may come from the pipeline warm-up thread
+   */
+  std::mutex save_mutex_{};
+  /**
+   * @brief Size of the data when it was last loaded or saved.  The cache
+   *        only grows, so a different size means new pipelines.
+   */
+  std::size_t saved_size_ = 0;
+
+ private:
+  logging::Log log_ = logging::Log("main");
+};
+
+} /* namespace game_engine::vulkan */
+
+#endif /* SRC_VULKAN_VULKANPIPELINECACHE_HPP_ */
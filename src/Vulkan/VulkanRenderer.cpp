@@ -17,9 +17,2774 @@
  * You should have received a copy of the GNU General Public License
  * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
  *****************************************************************************/
+#include "Vulkan/VulkanRenderer.hpp"
 
-#include "VulkanRenderer.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
 
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_mixer.h>
+#include <SDL2/SDL_vulkan.h>
+#include <cmrc/cmrc.hpp>
+#include <vulkan/vulkan.h>
 
+#include "3D/Frustum.hpp"
+#include "LoggerV2/Log.hpp"
+#include "Util/ParallelFor.hpp"
+#include "Vertex.hpp"
 
+CMRC_DECLARE(vulkan);
 
+namespace game_engine::vulkan {
+
+namespace {
+
+constexpr std::uint32_t kMaxTextures = 4096;
+/**
+ * @brief Light sets alive at once, one per lit shader and frame in flight
+ */
+constexpr std::uint32_t kMaxLightSets = 64;
+constexpr std::size_t kMaxShortIndexVertices = 65536;
+/**
+ * @brief Initial size of the readback arena of each frame in flight, enough
+ *        for one 1080p readback
+ */
+constexpr VkDeviceSize kReadbackArenaSize = 1920 * 1080 * 4;
+
+/**
+ * @brief A pixel format as stored by Vulkan, and the channels of the pixels
+ *        uploaded into it
+ */
+struct TextureFormat {
+  VkFormat format = VK_FORMAT_UNDEFINED;
+  int source_channels = 4;
+  int channels = 4;
+  bool bgra_source = false;
+};
+
+TextureFormat ToVulkan(const _3D::PixelFormat format,
+                       const VkFormat depth_format) {
+  TextureFormat texture{};
+  switch (format.e_format) {
+    case GL_RED:
+      texture.source_channels = 1;
+      break;
+    case GL_RG:
+      texture.source_channels = 2;
+      break;
+    case GL_RGB:
+      texture.source_channels = 3;
+      break;
+    case GL_BGRA:
+      texture.bgra_source = true;
+      break;
+    default:
+      break;
+  }
+  switch (static_cast<GLenum>(format.i_format)) {
+    case GL_RED:
+    case GL_R8:
+      texture.format = VK_FORMAT_R8_UNORM;
+      texture.channels = 1;
+      break;
+    case GL_RG:
+    case GL_RG8:
+      texture.format = VK_FORMAT_R8G8_UNORM;
+      texture.channels = 2;
+      break;
+    case GL_RGB:
+    case GL_RGB8:
+    case GL_RGBA:
+    case GL_RGBA8:
+      // Three channel formats are rarely supported, pad them instead
+      texture.format = VK_FORMAT_R8G8B8A8_UNORM;
+      break;
+    case GL_SRGB:
+    case GL_SRGB8:
+    case GL_SRGB_ALPHA:
+    case GL_SRGB8_ALPHA8:
+      texture.format = VK_FORMAT_R8G8B8A8_SRGB;
+      break;
+    case GL_R16F:
+      texture.format = VK_FORMAT_R16_SFLOAT;
+      break;
+    case GL_RG16F:
+      texture.format = VK_FORMAT_R16G16_SFLOAT;
+      break;
+    case GL_RGBA16F:
+      texture.format = VK_FORMAT_R16G16B16A16_SFLOAT;
+      break;
+    case GL_R32F:
+      texture.format = VK_FORMAT_R32_SFLOAT;
+      break;
+    case GL_RGBA32F:
+      texture.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+      break;
+    case GL_R11F_G11F_B10F:
+      texture.format = VK_FORMAT_B10G11R11_UFLOAT_PACK32;
+      break;
+    case GL_DEPTH_COMPONENT32F:
+      texture.format = VK_FORMAT_D32_SFLOAT;
+      break;
+    case GL_DEPTH_COMPONENT:
+    case GL_DEPTH_COMPONENT24:
+    case GL_DEPTH_STENCIL:
+    case GL_DEPTH24_STENCIL8:
+    case GL_DEPTH32F_STENCIL8:
+      texture.format = depth_format;
+      break;
+    default:
+      break;
+  }
+  return texture;
+}
+
+/**
+ * @brief Whether pixels can be copied into the format, padding RGB with alpha
+ */
+bool IsUploadable(const TextureFormat& texture) {
+  const bool convertible =
+      texture.source_channels == texture.channels ||
+      (texture.source_channels == 3 && texture.channels == 4);
+  return texture.format != VK_FORMAT_UNDEFINED && convertible &&
+         VulkanDevice::AspectOf(texture.format) == VK_IMAGE_ASPECT_COLOR_BIT;
+}
+
+/**
+ * @brief Bytes between rows padded to the unpack alignment, as glTexImage2D
+ *        expects them
+ */
+std::size_t PaddedRowStride(const int width, const TextureFormat& texture,
+                            const int alignment) {
+  const std::size_t row =
+      static_cast<std::size_t>(width) * texture.source_channels;
+  const std::size_t align = static_cast<std::size_t>(alignment);
+  return (row + align - 1) / align * align;
+}
+
+/**
+ * @brief Copy pixels tightly packed at the channel count of the image,
+ *        padding with opaque alpha and swapping BGRA to RGBA
+ * @param stride Bytes between the rows of pixels
+ * @return Returns the number of bytes written
+ */
+std::size_t Repack(const TextureFormat& texture, const std::uint8_t* pixels,
+                   const glm::ivec2 extent, const std::size_t stride,
+                   std::uint8_t* out) {
+  std::size_t offset = 0;
+  for (int y = 0; y < extent.y; y++) {
+    const std::uint8_t* in = pixels + y * stride;
+    for (int x = 0; x < extent.x; x++) {
+      const std::uint8_t* pixel = in + x * texture.source_channels;
+      for (int c = 0; c < texture.channels; c++) {
+        int source = c;
+        if (texture.bgra_source && c < 3) {
+          source = 2 - c;
+        }
+        out[offset++] = source < texture.source_channels ? pixel[source] : 255;
+      }
+    }
+  }
+  return offset;
+}
+
+/**
+ * @brief Whether a shader draws SpriteBatch instances rather than Vertex
+ */
+bool IsSpriteShader(const ShaderPrograms shader) {
+  return shader == ShaderPrograms::SPRITE || shader == ShaderPrograms::TEXT;
+}
+
+/**
+ * @brief Type of the texture a shader samples
+ */
+VkImageViewType ViewTypeOf(const ShaderPrograms shader) {
+  if (IsSpriteShader(shader)) {
+    return VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+  }
+  if (shader == ShaderPrograms::CUBE || shader == ShaderPrograms::SKYBOX) {
+    return VK_IMAGE_VIEW_TYPE_CUBE;
+  }
+  return VK_IMAGE_VIEW_TYPE_2D;
+}
+
+/**
+ * @brief Cluster parameters of default.frag, std140
+ */
+struct ClusterUniforms {
+  /**
+   * @brief xyz is the cluster grid, w whether lights are enabled
+   */
+  glm::ivec4 grid{0};
+  glm::vec4 depth_scale_bias{0.0f};
+  glm::vec4 ambient{0.0f};
+};
+
+bool ToTopology(const _3D::Primitive mode, VkPrimitiveTopology& topology) {
+  switch (mode) {
+    case _3D::Primitive::POINTS:
+      topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+      return true;
+    case _3D::Primitive::LINES:
+      topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+      return true;
+    case _3D::Primitive::LINE_STRIP:
+      topology = VK_PRIMITIVE_TOPOLOGY_LINE_STRIP;
+      return true;
+    case _3D::Primitive::TRIANGLES:
+      topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+      return true;
+    case _3D::Primitive::TRIANGLE_STRIP:
+      topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+      return true;
+    case _3D::Primitive::TRIANGLE_FAN:
+      topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN;
+      return true;
+    default:
+      return false;
+  }
+}
+
+VkComponentSwizzle ToSwizzle(const GLint swizzle) {
+  switch (swizzle) {
+    case GL_RED:
+      return VK_COMPONENT_SWIZZLE_R;
+    case GL_GREEN:
+      return VK_COMPONENT_SWIZZLE_G;
+    case GL_BLUE:
+      return VK_COMPONENT_SWIZZLE_B;
+    case GL_ALPHA:
+      return VK_COMPONENT_SWIZZLE_A;
+    case GL_ZERO:
+      return VK_COMPONENT_SWIZZLE_ZERO;
+    case GL_ONE:
+      return VK_COMPONENT_SWIZZLE_ONE;
+    default:
+      return VK_COMPONENT_SWIZZLE_IDENTITY;
+  }
+}
+
+/**
+ * @brief Highest sample count supported for both color and depth that does
+ *        not exceed samples
+ */
+VkSampleCountFlagBits ToSampleCount(const int samples,
+                                    const VkPhysicalDeviceLimits& limits) {
+  const VkSampleCountFlags supported = limits.framebufferColorSampleCounts &
+                                       limits.framebufferDepthSampleCounts;
+  VkSampleCountFlagBits count = VK_SAMPLE_COUNT_1_BIT;
+  for (int bit = VK_SAMPLE_COUNT_2_BIT; bit <= VK_SAMPLE_COUNT_64_BIT &&
+                                        bit <= samples;
+       bit <<= 1) {
+    if (supported & static_cast<VkSampleCountFlags>(bit)) {
+      count = static_cast<VkSampleCountFlagBits>(bit);
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief Barrier between transfers on a range of mip levels
+ */
+void LevelBarrier(const VkCommandBuffer cmd, const VkImage image,
+                  const std::uint32_t base, const std::uint32_t count,
+                  const VkImageLayout old_layout,
+                  const VkImageLayout new_layout) {
+  if (count == 0) {
+    return;
+  }
+  VkImageMemoryBarrier2 barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+  barrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+  barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+  if (new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;
+  } else {
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+  }
+  barrier.oldLayout = old_layout;
+  barrier.newLayout = new_layout;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, base, count, 0, 1};
+
+  VkDependencyInfo dependency{};
+  dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+  dependency.imageMemoryBarrierCount = 1;
+  dependency.pImageMemoryBarriers = &barrier;
+  vkCmdPipelineBarrier2(cmd, &dependency);
+}
+
+void MemoryBarrier(const VkCommandBuffer cmd,
+                   const VkPipelineStageFlags2 src_stages,
+                   const VkAccessFlags2 src_access,
+                   const VkPipelineStageFlags2 dst_stages,
+                   const VkAccessFlags2 dst_access) {
+  VkMemoryBarrier2 barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+  barrier.srcStageMask = src_stages;
+  barrier.srcAccessMask = src_access;
+  barrier.dstStageMask = dst_stages;
+  barrier.dstAccessMask = dst_access;
+
+  VkDependencyInfo dependency{};
+  dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+  dependency.memoryBarrierCount = 1;
+  dependency.pMemoryBarriers = &barrier;
+  vkCmdPipelineBarrier2(cmd, &dependency);
+}
+
+}  // namespace
+
+static_assert(sizeof(glm::mat4) + 4 * sizeof(glm::vec4) == 128,
+              "Push constants must match the shaders");
+
+bool VulkanRenderer::PipelineKey::operator<(const PipelineKey& other) const {
+  return std::tie(shader, mode, blend, depth_test, colors, depth, samples) <
+         std::tie(other.shader, other.mode, other.blend, other.depth_test,
+                  other.colors, other.depth, other.samples);
+}
+
+VulkanRenderer::~VulkanRenderer() { Destroy(); }
+
+void VulkanRenderer::Init(const std::string program_name) {
+  Init(program_name, VulkanRendererOptions{});
+}
+
+void VulkanRenderer::Init(const std::string program_name,
+                          const VulkanRendererOptions& options) {
+  options_ = options;
+  workers_ = options.recording_threads;
+  if (workers_ == 0) {
+    workers_ = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  CreateSurfaceAndDevice(program_name, options);
+  depth_format_ = device_.FindDepthFormat({VK_FORMAT_D24_UNORM_S8_UINT,
+                                           VK_FORMAT_D32_SFLOAT_S8_UINT,
+                                           VK_FORMAT_D32_SFLOAT});
+  CreateDescriptors();
+  no_lights_ = CreateLightSet(_3D::LightClusterData{}, glm::vec3(1.0f), false);
+  CreateShaderModules();
+  pipeline_cache_.Init(device_.device_, device_.properties_,
+                       options.pipeline_cache_directory);
+  CreateFrames();
+  CreateSwapchain();
+  initialized_ = true;
+  if (options.warm_up_pipelines) {
+    StartPipelineWarmUp();
+  }
+
+  CreateWhiteTextures();
+  attachments_ = Attachments{};
+  UseShader(ShaderPrograms::DEFAULT);
+}
+
+void VulkanRenderer::CreateSurfaceAndDevice(
+    const std::string& program_name, const VulkanRendererOptions& options) {
+  VulkanDeviceOptions device_options{};
+  device_options.validation = options.validation;
+  device_options.prefer_software = options.prefer_software;
+  if (options.headless) {
+    headless_size_ = options.size;
+    device_.CreateInstance(program_name, device_options);
+    device_.CreateDevice(VK_NULL_HANDLE);
+    return;
+  }
+
+  /* SDL-related initialising functions */
+  if (SDL_Init(SDL_INIT_EVERYTHING) == -1) {
+    log_.Critical("SDL_init:  {}", SDL_GetError());
+    throw EXIT_FAILURE;
+  }
+  const int image_flags = IMG_INIT_JPG | IMG_INIT_PNG;
+  if (!(IMG_Init(image_flags) & image_flags)) {
+    log_.Critical("SDL_image could not initialize! SDL_image Error: {}",
+                  IMG_GetError());
+    throw EXIT_FAILURE;
+  }
+
+  const int mixer_flags =
+      MIX_INIT_FLAC | MIX_INIT_MOD | MIX_INIT_MP3 | MIX_INIT_OGG;
+  if (!(Mix_Init(mixer_flags) & mixer_flags)) {
+    log_.Critical("SDL_mixer could not initialize! SDL_mixer Error: {}",
+                  Mix_GetError());
+    throw EXIT_FAILURE;
+  }
+
+  if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 1024) == -1) {
+    log_.Critical("Mix_OpenAudio:  {}", Mix_GetError());
+    throw EXIT_FAILURE;
+  }
+  Mix_AllocateChannels(1000);
+
+  SetWindow(SDL_CreateWindow(program_name.c_str(), SDL_WINDOWPOS_CENTERED,
+                             SDL_WINDOWPOS_CENTERED, options.size.x,
+                             options.size.y,
+                             SDL_WINDOW_RESIZABLE | SDL_WINDOW_VULKAN));
+  unsigned int count = 0;
+  SDL_Vulkan_GetInstanceExtensions(GetWindow(), &count, nullptr);
+  device_options.instance_extensions.resize(count);
+  SDL_Vulkan_GetInstanceExtensions(GetWindow(), &count,
+                                   device_options.instance_extensions.data());
+
+  device_.CreateInstance(program_name, device_options);
+  if (!SDL_Vulkan_CreateSurface(GetWindow(), device_.instance_, &surface_)) {
+    throw std::runtime_error(std::string("SDL_Vulkan_CreateSurface: ") +
+                             SDL_GetError());
+  }
+  device_.CreateDevice(surface_);
+  EnableVSync();
+}
+
+void VulkanRenderer::CreateSwapchain() const {
+  const VkDevice device = device_.device_;
+  VkExtent2D extent{0, 0};
+  if (window_ == nullptr) {
+    extent = {static_cast<std::uint32_t>(headless_size_.x),
+              static_cast<std::uint32_t>(headless_size_.y)};
+    swapchain_format_ = VK_FORMAT_R8G8B8A8_UNORM;
+    VulkanImageDesc desc{};
+    desc.extent = extent;
+    desc.format = swapchain_format_;
+    desc.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                 VK_IMAGE_USAGE_SAMPLED_BIT |
+                 VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    headless_color_ = device_.CreateImage(desc);
+    swapchain_readable_ = true;
+  } else {
+    VkSurfaceCapabilitiesKHR capabilities;
+    Check(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device_.physical_device_,
+                                                    surface_, &capabilities),
+          "vkGetPhysicalDeviceSurfaceCapabilitiesKHR");
+    extent = capabilities.currentExtent;
+    if (extent.width == UINT32_MAX) {
+      const glm::ivec2 size = GetWindowSize();
+      extent.width = std::clamp(static_cast<std::uint32_t>(size.x),
+                                capabilities.minImageExtent.width,
+                                capabilities.maxImageExtent.width);
+      extent.height = std::clamp(static_cast<std::uint32_t>(size.y),
+                                 capabilities.minImageExtent.height,
+                                 capabilities.maxImageExtent.height);
+    }
+    if (extent.width == 0 || extent.height == 0) {
+      // Minimized, try again on the next Swap
+      return;
+    }
+
+    std::uint32_t count = 0;
+    vkGetPhysicalDeviceSurfaceFormatsKHR(device_.physical_device_, surface_,
+                                         &count, nullptr);
+    std::vector<VkSurfaceFormatKHR> formats(count);
+    vkGetPhysicalDeviceSurfaceFormatsKHR(device_.physical_device_, surface_,
+                                         &count, formats.data());
+    // Match GL's default framebuffer, which is not sRGB
+    VkSurfaceFormatKHR format = formats.front();
+    for (const VkSurfaceFormatKHR& candidate : formats) {
+      if (candidate.format == VK_FORMAT_B8G8R8A8_UNORM ||
+          candidate.format == VK_FORMAT_R8G8B8A8_UNORM) {
+        format = candidate;
+        break;
+      }
+    }
+    swapchain_format_ = format.format;
+
+    vkGetPhysicalDeviceSurfacePresentModesKHR(device_.physical_device_,
+                                              surface_, &count, nullptr);
+    std::vector<VkPresentModeKHR> modes(count);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(device_.physical_device_,
+                                              surface_, &count, modes.data());
+    VkPresentModeKHR mode = VK_PRESENT_MODE_FIFO_KHR;
+    if (!vsync_enabled_) {
+      for (const VkPresentModeKHR candidate :
+           {VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR}) {
+        if (std::find(modes.begin(), modes.end(), candidate) != modes.end()) {
+          mode = candidate;
+          break;
+        }
+      }
+    }
+
+    std::uint32_t image_count = capabilities.minImageCount + 1;
+    if (capabilities.maxImageCount > 0) {
+      image_count = std::min(image_count, capabilities.maxImageCount);
+    }
+    swapchain_readable_ = (capabilities.supportedUsageFlags &
+                           VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+
+    VkSwapchainCreateInfoKHR info{};
+    info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+    info.surface = surface_;
+    info.minImageCount = image_count;
+    info.imageFormat = format.format;
+    info.imageColorSpace = format.colorSpace;
+    info.imageExtent = extent;
+    info.imageArrayLayers = 1;
+    info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    if (swapchain_readable_) {
+      info.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+    info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    info.preTransform = capabilities.currentTransform;
+    info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    info.presentMode = mode;
+    info.clipped = VK_TRUE;
+    Check(vkCreateSwapchainKHR(device, &info, nullptr, &swapchain_),
+          "vkCreateSwapchainKHR");
+
+    vkGetSwapchainImagesKHR(device, swapchain_, &count, nullptr);
+    swapchain_images_.resize(count);
+    vkGetSwapchainImagesKHR(device, swapchain_, &count,
+                            swapchain_images_.data());
+    for (const VkImage image : swapchain_images_) {
+      VkImageViewCreateInfo view{};
+      view.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+      view.image = image;
+      view.viewType = VK_IMAGE_VIEW_TYPE_2D;
+      view.format = swapchain_format_;
+      view.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+      VkImageView image_view;
+      Check(vkCreateImageView(device, &view, nullptr, &image_view),
+            "vkCreateImageView");
+      swapchain_views_.push_back(image_view);
+
+      VkSemaphoreCreateInfo semaphore{};
+      semaphore.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+      VkSemaphore finished;
+      Check(vkCreateSemaphore(device, &semaphore, nullptr, &finished),
+            "vkCreateSemaphore");
+      render_finished_.push_back(finished);
+    }
+  }
+  swapchain_extent_ = extent;
+
+  VulkanImageDesc depth{};
+  depth.extent = extent;
+  depth.format = depth_format_;
+  depth.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+  backbuffer_depth_ = AddTexture(device_.CreateImage(depth), false);
+  swapchain_dirty_ = false;
+}
+
+void VulkanRenderer::DestroySwapchain() const {
+  const VkDevice device = device_.device_;
+  vkDeviceWaitIdle(device);
+  for (const VkImageView view : swapchain_views_) {
+    vkDestroyImageView(device, view, nullptr);
+  }
+  for (const VkSemaphore semaphore : render_finished_) {
+    vkDestroySemaphore(device, semaphore, nullptr);
+  }
+  swapchain_views_.clear();
+  swapchain_images_.clear();
+  render_finished_.clear();
+  if (swapchain_ != VK_NULL_HANDLE) {
+    vkDestroySwapchainKHR(device, swapchain_, nullptr);
+    swapchain_ = VK_NULL_HANDLE;
+  }
+  device_.DestroyImage(headless_color_);
+  const auto it = textures_.find(backbuffer_depth_);
+  if (it != textures_.end()) {
+    device_.DestroyImage(it->second.image);
+    textures_.erase(it);
+  }
+  backbuffer_depth_ = 0;
+}
+
+void VulkanRenderer::CreateFrames() {
+  const VkDevice device = device_.device_;
+  for (FrameSlot& frame : frames_) {
+    VkFenceCreateInfo fence{};
+    fence.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fence.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    Check(vkCreateFence(device, &fence, nullptr, &frame.fence),
+          "vkCreateFence");
+    VkSemaphoreCreateInfo semaphore{};
+    semaphore.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    Check(vkCreateSemaphore(device, &semaphore, nullptr,
+                            &frame.image_available),
+          "vkCreateSemaphore");
+
+    VkCommandPoolCreateInfo pool{};
+    pool.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pool.queueFamilyIndex = device_.queue_family_;
+    Check(vkCreateCommandPool(device, &pool, nullptr, &frame.pool),
+          "vkCreateCommandPool");
+    VkCommandBufferAllocateInfo allocate{};
+    allocate.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocate.commandPool = frame.pool;
+    allocate.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocate.commandBufferCount = 1;
+    Check(vkAllocateCommandBuffers(device, &allocate, &frame.primary),
+          "vkAllocateCommandBuffers");
+    frame.readback_arena.Init(&device_, kReadbackArenaSize,
+                              VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+
+    // Command pools are externally synchronized, so every recording thread
+    // gets its own
+    frame.workers.resize(workers_);
+    for (WorkerPool& worker : frame.workers) {
+      Check(vkCreateCommandPool(device, &pool, nullptr, &worker.pool),
+            "vkCreateCommandPool");
+    }
+
+    if (device_.timestamps_) {
+      VkQueryPoolCreateInfo queries{};
+      queries.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+      queries.queryType = VK_QUERY_TYPE_TIMESTAMP;
+      queries.queryCount = kMaxTimestamps;
+      Check(vkCreateQueryPool(device, &queries, nullptr, &frame.queries),
+            "vkCreateQueryPool");
+    }
+  }
+}
+
+void VulkanRenderer::CreateDescriptors() {
+  const VkDevice device = device_.device_;
+
+  VkDescriptorSetLayoutBinding binding{};
+  binding.binding = 0;
+  binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  binding.descriptorCount = 1;
+  binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+  VkDescriptorSetLayoutCreateInfo layout{};
+  layout.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layout.bindingCount = 1;
+  layout.pBindings = &binding;
+  Check(vkCreateDescriptorSetLayout(device, &layout, nullptr, &set_layout_),
+        "vkCreateDescriptorSetLayout");
+
+  // Lights, clusters and light indices, then the cluster parameters
+  VkDescriptorSetLayoutBinding light_bindings[4] = {};
+  for (std::uint32_t i = 0; i < 4; i++) {
+    light_bindings[i].binding = i;
+    light_bindings[i].descriptorType = i < 3
+                                           ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+                                           : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    light_bindings[i].descriptorCount = 1;
+    light_bindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+  }
+  layout.bindingCount = 4;
+  layout.pBindings = light_bindings;
+  Check(vkCreateDescriptorSetLayout(device, &layout, nullptr,
+                                    &light_set_layout_),
+        "vkCreateDescriptorSetLayout");
+
+  const VkDescriptorPoolSize sizes[] = {
+      {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, kMaxTextures},
+      {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * kMaxLightSets},
+      {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, kMaxLightSets}};
+  VkDescriptorPoolCreateInfo pool{};
+  pool.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  pool.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+  pool.maxSets = kMaxTextures + kMaxLightSets;
+  pool.poolSizeCount = 3;
+  pool.pPoolSizes = sizes;
+  Check(vkCreateDescriptorPool(device, &pool, nullptr, &descriptor_pool_),
+        "vkCreateDescriptorPool");
+
+  VkSamplerCreateInfo sampler{};
+  sampler.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+  sampler.magFilter = VK_FILTER_LINEAR;
+  sampler.minFilter = VK_FILTER_LINEAR;
+  sampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+  sampler.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sampler.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sampler.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sampler.maxLod = VK_LOD_CLAMP_NONE;
+  Check(vkCreateSampler(device, &sampler, nullptr, &sampler_),
+        "vkCreateSampler");
+  sampler.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  sampler.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  sampler.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  Check(vkCreateSampler(device, &sampler, nullptr, &repeat_sampler_),
+        "vkCreateSampler");
+
+  VkPushConstantRange push{};
+  push.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+  push.offset = 0;
+  push.size = sizeof(PushConstants);
+  const VkDescriptorSetLayout set_layouts[] = {set_layout_,
+                                               light_set_layout_};
+  VkPipelineLayoutCreateInfo pipeline{};
+  pipeline.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipeline.setLayoutCount = 2;
+  pipeline.pSetLayouts = set_layouts;
+  pipeline.pushConstantRangeCount = 1;
+  pipeline.pPushConstantRanges = &push;
+  Check(vkCreatePipelineLayout(device, &pipeline, nullptr, &pipeline_layout_),
+        "vkCreatePipelineLayout");
+}
+
+void VulkanRenderer::CreateShaderModules() {
+  shader_modules_[ShaderPrograms::DEFAULT] = {
+      LoadShaderModule("default.vert.spv"),
+      LoadShaderModule("default.frag.spv")};
+  shader_modules_[ShaderPrograms::CUBE] = {LoadShaderModule("cube.vert.spv"),
+                                           LoadShaderModule("cube.frag.spv")};
+  // Glyphs are sprites too, only shaded from a distance field
+  shader_modules_[ShaderPrograms::TEXT] = {LoadShaderModule("sprite.vert.spv"),
+                                           LoadShaderModule("text.frag.spv")};
+  shader_modules_[ShaderPrograms::SKYBOX] = {
+      LoadShaderModule("skybox.vert.spv"),
+      LoadShaderModule("skybox.frag.spv")};
+  shader_modules_[ShaderPrograms::UPSCALE] = {
+      LoadShaderModule("upscale.vert.spv"),
+      LoadShaderModule("upscale.frag.spv")};
+  shader_modules_[ShaderPrograms::SPRITE] = {
+      LoadShaderModule("sprite.vert.spv"),
+      LoadShaderModule("sprite.frag.spv")};
+}
+
+void VulkanRenderer::CreateWhiteTextures() {
+  std::uint8_t white[4] = {255, 255, 255, 255};
+  const _3D::PixelFormat format{GL_RGBA8, GL_RGBA};
+  white_textures_[VK_IMAGE_VIEW_TYPE_2D] =
+      UploadTexture(format, glm::ivec2(1, 1), {white}, 0, false);
+  _3D::CubemapBuffers faces{};
+  faces.positive_x = faces.negative_x = faces.positive_y = white;
+  faces.negative_y = faces.positive_z = faces.negative_z = white;
+  white_textures_[VK_IMAGE_VIEW_TYPE_CUBE] = CreateCubemap(
+      ShaderPrograms::DEFAULT, format, glm::ivec2(1, 1), faces);
+  const unsigned int array = CreateTextureArray(
+      ShaderPrograms::SPRITE, format, glm::ivec3(1, 1, 1), 1,
+      _3D::TextureWrap::CLAMP);
+  UpdateTextureArray(array, format, glm::ivec3(0, 0, 0), glm::ivec2(1, 1),
+                     white);
+  white_textures_[VK_IMAGE_VIEW_TYPE_2D_ARRAY] = array;
+}
+
+VkShaderModule VulkanRenderer::LoadShaderModule(
+    const std::string& name) const {
+  const cmrc::embedded_filesystem fs = cmrc::vulkan::get_filesystem();
+  const cmrc::file file = fs.open(name);
+  // SPIR-V is a stream of words, copy it to make sure it is aligned
+  std::vector<std::uint32_t> code((file.size() + 3) / 4);
+  std::memcpy(code.data(), file.begin(), file.size());
+
+  VkShaderModuleCreateInfo info{};
+  info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  info.codeSize = file.size();
+  info.pCode = code.data();
+  VkShaderModule module;
+  Check(vkCreateShaderModule(device_.device_, &info, nullptr, &module),
+        "vkCreateShaderModule");
+  return module;
+}
+
+void VulkanRenderer::Destroy() {
+  if (!initialized_) {
+    return;
+  }
+  const VkDevice device = device_.device_;
+  stop_warm_up_ = true;
+  WaitForPipelineWarmUp();
+  stop_warm_up_ = false;
+  vkDeviceWaitIdle(device);
+  for (FrameSlot& frame : frames_) {
+    if (frame.submitted) {
+      DeliverFrame(frame);
+    }
+    for (WorkerPool& worker : frame.workers) {
+      vkDestroyCommandPool(device, worker.pool, nullptr);
+    }
+    vkDestroyCommandPool(device, frame.pool, nullptr);
+    vkDestroyQueryPool(device, frame.queries, nullptr);
+    vkDestroySemaphore(device, frame.image_available, nullptr);
+    vkDestroyFence(device, frame.fence, nullptr);
+    frame.readback_arena.Destroy();
+    frame = FrameSlot{};
+  }
+  for (auto& deletion : deletions_) {
+    deletion.second();
+  }
+  deletions_.clear();
+  ops_.clear();
+  for (auto& [shader, state] : shader_states_) {
+    for (VulkanBuffer& buffer : state.lights.buffers) {
+      device_.DestroyBuffer(buffer);
+    }
+    state.lights = LightSet{};
+  }
+  for (VulkanBuffer& buffer : no_lights_.buffers) {
+    device_.DestroyBuffer(buffer);
+  }
+  no_lights_ = LightSet{};
+
+  DestroySwapchain();
+  for (auto& [id, texture] : textures_) {
+    device_.DestroyImage(texture.image);
+  }
+  textures_.clear();
+  white_textures_.clear();
+  for (auto& [id, buffer] : buffers_) {
+    device_.DestroyBuffer(buffer);
+  }
+  buffers_.clear();
+  for (auto& [handle, vbo] : vbos_) {
+    device_.DestroyBuffer(vbo.vertices);
+    device_.DestroyBuffer(vbo.indices);
+  }
+  vbos_.clear();
+  render_targets_.clear();
+
+  for (const auto& [key, pipeline] : pipelines_) {
+    vkDestroyPipeline(device, pipeline, nullptr);
+  }
+  pipelines_.clear();
+  pipeline_cache_.Destroy();
+  for (const auto& [shader, modules] : shader_modules_) {
+    vkDestroyShaderModule(device, modules.first, nullptr);
+    vkDestroyShaderModule(device, modules.second, nullptr);
+  }
+  shader_modules_.clear();
+  vkDestroyPipelineLayout(device, pipeline_layout_, nullptr);
+  vkDestroySampler(device, sampler_, nullptr);
+  vkDestroySampler(device, repeat_sampler_, nullptr);
+  vkDestroyDescriptorPool(device, descriptor_pool_, nullptr);
+  vkDestroyDescriptorSetLayout(device, set_layout_, nullptr);
+  vkDestroyDescriptorSetLayout(device, light_set_layout_, nullptr);
+
+  if (surface_ != VK_NULL_HANDLE) {
+    vkDestroySurfaceKHR(device_.instance_, surface_, nullptr);
+    surface_ = VK_NULL_HANDLE;
+  }
+  device_.Destroy();
+  if (window_ != nullptr) {
+    SDL_DestroyWindow(window_);
+    SetWindow(nullptr);
+  }
+  initialized_ = false;
+}
+
+void VulkanRenderer::UseShader(const ShaderPrograms shader_program) const {
+  log_.Debug("Using shader {}", shader_program);
+  if (shader_modules_.count(shader_program) == 0) {
+    log_.Error("Shader {} is not supported by the Vulkan renderer.",
+               shader_program);
+  }
+}
+
+bool VulkanRenderer::IsShaderReady(const ShaderPrograms shader_program) const {
+  // SPIR-V is compiled with the engine and pipelines are created on first use
+  return shader_modules_.count(shader_program) != 0;
+}
+
+VkPipeline VulkanRenderer::GetPipeline(const PipelineKey& key) const {
+  {
+    const std::lock_guard<std::mutex> lock(pipelines_mutex_);
+    const auto it = pipelines_.find(key);
+    if (it != pipelines_.end()) {
+      return it->second;
+    }
+  }
+  // Create without holding the lock, the warm-up thread may be creating
+  // other pipelines
+  const VkPipeline pipeline = CreatePipeline(key);
+  const std::lock_guard<std::mutex> lock(pipelines_mutex_);
+  const auto [it, inserted] = pipelines_.emplace(key, pipeline);
+  if (!inserted) {
+    vkDestroyPipeline(device_.device_, pipeline, nullptr);
+  }
+  return it->second;
+}
+
+void VulkanRenderer::StartPipelineWarmUp() {
+  PipelineKey base{};
+  base.colors = {window_ != nullptr ? swapchain_format_
+                                    : headless_color_.format};
+  base.depth = depth_format_;
+  if (base.colors[0] == VK_FORMAT_UNDEFINED) {
+    return;
+  }
+  // Most common states first, so they are ready soonest
+  std::vector<PipelineKey> keys;
+  for (const _3D::Primitive mode :
+       {_3D::Primitive::TRIANGLES, _3D::Primitive::TRIANGLE_STRIP,
+        _3D::Primitive::TRIANGLE_FAN, _3D::Primitive::LINES,
+        _3D::Primitive::LINE_STRIP, _3D::Primitive::POINTS}) {
+    for (const auto& [depth_test, blend] :
+         {std::pair{true, false}, std::pair{false, true},
+          std::pair{true, true}, std::pair{false, false}}) {
+      for (const auto& [shader, modules] : shader_modules_) {
+        // Sprites and the upscale pass are always drawn the same way
+        if (IsSpriteShader(shader) &&
+            (mode != _3D::Primitive::TRIANGLE_STRIP || depth_test || !blend)) {
+          continue;
+        }
+        if (shader == ShaderPrograms::UPSCALE &&
+            (mode != _3D::Primitive::TRIANGLES || depth_test)) {
+          continue;
+        }
+        PipelineKey key = base;
+        key.shader = shader;
+        key.mode = mode;
+        key.blend = blend;
+        key.depth_test = depth_test;
+        keys.push_back(key);
+      }
+    }
+  }
+
+  warm_up_thread_ = std::thread([this, keys = std::move(keys)]() {
+    std::size_t created = 0;
+    for (const PipelineKey& key : keys) {
+      if (stop_warm_up_) {
+        break;
+      }
+      {
+        const std::lock_guard<std::mutex> lock(pipelines_mutex_);
+        if (pipelines_.count(key) != 0) {
+          continue;
+        }
+      }
+      try {
+        GetPipeline(key);
+        created++;
+      } catch (const std::exception& e) {
+        log_.Error("Pipeline warm-up failed: {}", e.what());
+        break;
+      }
+    }
+    log_.Debug("Warmed up {} pipelines.", created);
+    pipeline_cache_.Save();
+  });
+}
+
+void VulkanRenderer::WaitForPipelineWarmUp() const {
+  if (warm_up_thread_.joinable()) {
+    warm_up_thread_.join();
+  }
+}
+
+std::size_t VulkanRenderer::GetPipelineCount() const {
+  const std::lock_guard<std::mutex> lock(pipelines_mutex_);
+  return pipelines_.size();
+}
+
+VkPipeline VulkanRenderer::CreatePipeline(const PipelineKey& key) const {
+  const auto& modules = shader_modules_.at(key.shader);
+  VkPipelineShaderStageCreateInfo stages[2] = {};
+  stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+  stages[0].module = modules.first;
+  stages[0].pName = "main";
+  stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+  stages[1].module = modules.second;
+  stages[1].pName = "main";
+
+  // Same attribute locations as Vbo, limited to what the shaders read
+  VkVertexInputBindingDescription binding{};
+  binding.binding = 0;
+  binding.stride = sizeof(Vertex);
+  binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+  std::vector<VkVertexInputAttributeDescription> attributes = {
+      {0, 0, VK_FORMAT_R32G32B32_SFLOAT,
+       static_cast<std::uint32_t>(offsetof(Vertex, position))},
+      {2, 0, VK_FORMAT_R32G32B32_SFLOAT,
+       static_cast<std::uint32_t>(offsetof(Vertex, normal))},
+      {3, 0, VK_FORMAT_R32G32B32A32_SFLOAT,
+       static_cast<std::uint32_t>(offsetof(Vertex, color))},
+      {7, 0, VK_FORMAT_R32G32_SFLOAT,
+       static_cast<std::uint32_t>(offsetof(Vertex, tex_coord0))}};
+  if (IsSpriteShader(key.shader)) {
+    // One SpriteInstance per instance, as GLRenderer::DrawSprites
+    binding.stride = sizeof(_2D::SpriteInstance);
+    binding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    attributes = {
+        {0, 0, VK_FORMAT_R32G32B32A32_SFLOAT,
+         static_cast<std::uint32_t>(
+             offsetof(_2D::SpriteInstance, position_size))},
+        {1, 0, VK_FORMAT_R32G32B32A32_SFLOAT,
+         static_cast<std::uint32_t>(offsetof(_2D::SpriteInstance, uv_rect))},
+        {2, 0, VK_FORMAT_R8G8B8A8_UNORM,
+         static_cast<std::uint32_t>(offsetof(_2D::SpriteInstance, color))},
+        {3, 0, VK_FORMAT_R32_SFLOAT,
+         static_cast<std::uint32_t>(offsetof(_2D::SpriteInstance, rotation))},
+        {4, 0, VK_FORMAT_R32_UINT,
+         static_cast<std::uint32_t>(
+             offsetof(_2D::SpriteInstance, texture_layer))}};
+  }
+  VkPipelineVertexInputStateCreateInfo vertex_input{};
+  vertex_input.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+  // The fullscreen triangle of the upscale pass has no vertex buffer
+  if (key.shader != ShaderPrograms::UPSCALE) {
+    vertex_input.vertexBindingDescriptionCount = 1;
+    vertex_input.pVertexBindingDescriptions = &binding;
+    vertex_input.vertexAttributeDescriptionCount =
+        static_cast<std::uint32_t>(attributes.size());
+    vertex_input.pVertexAttributeDescriptions = attributes.data();
+  }
+
+  VkPipelineInputAssemblyStateCreateInfo input_assembly{};
+  input_assembly.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+  ToTopology(key.mode, input_assembly.topology);
+
+  VkPipelineViewportStateCreateInfo viewport{};
+  viewport.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+  viewport.viewportCount = 1;
+  viewport.scissorCount = 1;
+
+  VkPipelineRasterizationStateCreateInfo rasterization{};
+  rasterization.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+  rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+  rasterization.cullMode = VK_CULL_MODE_NONE;
+  rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+  rasterization.lineWidth = 1.0f;
+
+  VkPipelineMultisampleStateCreateInfo multisample{};
+  multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+  multisample.rasterizationSamples = key.samples;
+
+  // As in GL, depth is only written while it is tested
+  VkPipelineDepthStencilStateCreateInfo depth_stencil{};
+  depth_stencil.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+  depth_stencil.depthTestEnable =
+      key.depth_test && key.depth != VK_FORMAT_UNDEFINED;
+  depth_stencil.depthWriteEnable = depth_stencil.depthTestEnable;
+  depth_stencil.depthCompareOp = VK_COMPARE_OP_LESS;
+
+  VkPipelineColorBlendAttachmentState blend_attachment{};
+  blend_attachment.blendEnable = key.blend;
+  blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+  blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  blend_attachment.colorBlendOp = VK_BLEND_OP_ADD;
+  blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+  blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+  blend_attachment.colorWriteMask =
+      VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+      VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+  const std::vector<VkPipelineColorBlendAttachmentState> blend_attachments(
+      key.colors.size(), blend_attachment);
+  VkPipelineColorBlendStateCreateInfo blend{};
+  blend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+  blend.attachmentCount = static_cast<std::uint32_t>(blend_attachments.size());
+  blend.pAttachments = blend_attachments.data();
+
+  const VkDynamicState dynamic_states[] = {VK_DYNAMIC_STATE_VIEWPORT,
+                                           VK_DYNAMIC_STATE_SCISSOR};
+  VkPipelineDynamicStateCreateInfo dynamic{};
+  dynamic.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+  dynamic.dynamicStateCount = 2;
+  dynamic.pDynamicStates = dynamic_states;
+
+  VkPipelineRenderingCreateInfo rendering{};
+  rendering.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+  rendering.colorAttachmentCount =
+      static_cast<std::uint32_t>(key.colors.size());
+  rendering.pColorAttachmentFormats = key.colors.data();
+  rendering.depthAttachmentFormat = key.depth;
+  rendering.stencilAttachmentFormat = VulkanDevice::HasStencil(key.depth)
+                                          ? key.depth
+                                          : VK_FORMAT_UNDEFINED;
+
+  VkGraphicsPipelineCreateInfo info{};
+  info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  info.pNext = &rendering;
+  info.stageCount = 2;
+  info.pStages = stages;
+  info.pVertexInputState = &vertex_input;
+  info.pInputAssemblyState = &input_assembly;
+  info.pViewportState = &viewport;
+  info.pRasterizationState = &rasterization;
+  info.pMultisampleState = &multisample;
+  info.pDepthStencilState = &depth_stencil;
+  info.pColorBlendState = &blend;
+  info.pDynamicState = &dynamic;
+  info.layout = pipeline_layout_;
+
+  VkPipeline pipeline;
+  Check(vkCreateGraphicsPipelines(device_.device_, pipeline_cache_.Get(), 1,
+                                  &info, nullptr, &pipeline),
+        "vkCreateGraphicsPipelines");
+  log_.Debug("Created a Vulkan pipeline for shader {}, {}.", key.shader,
+             key.mode);
+  return pipeline;
+}
+
+void VulkanRenderer::Render(const VboHandle vbo_handle,
+                            const _3D::Primitive mode) const {
+  const auto it = vbos_.find(vbo_handle);
+  if (it == vbos_.end()) {
+    log_.Error("VBO_handle {} not in map!", vbo_handle);
+    return;
+  }
+  const VulkanVbo& vbo = it->second;
+  Render(vbo_handle, mode, 0,
+         vbo.n_indices != 0 ? vbo.n_indices : vbo.n_vertices);
+}
+
+void VulkanRenderer::Render(const VboHandle vbo_handle,
+                            const _3D::Primitive mode,
+                            const std::size_t first_index,
+                            const std::size_t index_count) const {
+  const auto it = vbos_.find(vbo_handle);
+  if (it == vbos_.end()) {
+    log_.Error("VBO_handle {} not in map!", vbo_handle);
+    return;
+  }
+  const VulkanVbo& vbo = it->second;
+  const std::size_t total = vbo.n_indices != 0 ? vbo.n_indices : vbo.n_vertices;
+  if (first_index + index_count > total) {
+    log_.Error("Index range {}+{} out of bounds of VBO_handle {}!",
+               first_index, index_count, vbo_handle);
+    return;
+  }
+  VkPrimitiveTopology topology;
+  if (!ToTopology(mode, topology)) {
+    log_.Error("{} is not supported by the Vulkan renderer.", mode);
+    return;
+  }
+
+  DrawCommand draw{};
+  draw.shader = vbo.shader;
+  draw.mode = mode;
+  draw.vertices = vbo.vertices.buffer;
+  if (vbo.n_indices != 0) {
+    draw.indices = vbo.indices.buffer;
+    draw.index_type = vbo.index_type;
+  }
+  draw.first = static_cast<std::uint32_t>(first_index);
+  draw.count = static_cast<std::uint32_t>(index_count);
+  AddDraw(draw);
+}
+
+void VulkanRenderer::AddDraw(DrawCommand draw) const {
+  const ShaderState& state = GetState(draw.shader);
+  draw.blend = blend_;
+  draw.depth_test = depth_test_;
+  const glm::mat4 model_view = state.view * state.model;
+  draw.push.mvp = state.projection * model_view;
+  draw.push.color = glm::vec4(state.color, 1.0f);
+  const glm::mat4 rows = glm::transpose(model_view);
+  for (int i = 0; i < 3; i++) {
+    draw.push.model_view[i] = rows[i];
+  }
+  draw.texture = state.texture;
+  draw.lights = state.lights.set;
+  AppendDraw(draw);
+}
+
+void VulkanRenderer::AppendDraw(DrawCommand draw) const {
+  if (shader_modules_.count(draw.shader) == 0) {
+    log_.Error("Shader {} is not supported by the Vulkan renderer.",
+               draw.shader);
+    return;
+  }
+  if (draw.count == 0 || draw.instance_count == 0) {
+    return;
+  }
+  // Sample white when no texture of the type the shader expects is bound
+  const VkImageViewType view_type = ViewTypeOf(draw.shader);
+  const auto texture = textures_.find(draw.texture);
+  if (texture == textures_.end() || texture->second.set == VK_NULL_HANDLE ||
+      texture->second.image.view_type != view_type) {
+    draw.texture = white_textures_.at(view_type);
+  }
+  draw.set = textures_.at(draw.texture).set;
+  if (draw.lights == VK_NULL_HANDLE) {
+    draw.lights = no_lights_.set;
+  }
+  draw.viewport = viewport_;
+  CurrentRenderOp().draws.push_back(draw);
+}
+
+VulkanRenderer::RenderOp& VulkanRenderer::CurrentRenderOp() const {
+  if (!render_op_open_) {
+    RenderOp op{};
+    op.attachments = attachments_;
+    ops_.emplace_back(std::move(op));
+    render_op_open_ = true;
+  }
+  return std::get<RenderOp>(ops_.back());
+}
+
+VulkanRenderer::ShaderState& VulkanRenderer::GetState(
+    const ShaderPrograms shader_program) const {
+  return shader_states_[shader_program];
+}
+
+void VulkanRenderer::AllocateVbo(VulkanVbo& vbo,
+                                 const std::vector<Vertex>& vertices,
+                                 const std::vector<GLuint>& indices) const {
+  vbo.n_vertices = static_cast<std::uint32_t>(vertices.size());
+  vbo.n_indices = static_cast<std::uint32_t>(indices.size());
+  // Vertices are written once per update and read once per draw, so
+  // host visible memory is as good as a staging copy
+  if (!vertices.empty()) {
+    const VkDeviceSize size = vertices.size() * sizeof(Vertex);
+    vbo.vertices = device_.CreateBuffer(
+        size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, true);
+    std::memcpy(vbo.vertices.allocation.mapped, vertices.data(), size);
+  }
+  if (indices.empty()) {
+    return;
+  }
+  if (vertices.size() < kMaxShortIndexVertices) {
+    vbo.index_type = VK_INDEX_TYPE_UINT16;
+    vbo.indices = device_.CreateBuffer(indices.size() * sizeof(std::uint16_t),
+                                       VK_BUFFER_USAGE_INDEX_BUFFER_BIT, true);
+    std::uint16_t* out =
+        static_cast<std::uint16_t*>(vbo.indices.allocation.mapped);
+    for (std::size_t i = 0; i < indices.size(); i++) {
+      out[i] = static_cast<std::uint16_t>(indices[i]);
+    }
+  } else {
+    vbo.index_type = VK_INDEX_TYPE_UINT32;
+    vbo.indices = device_.CreateBuffer(indices.size() * sizeof(std::uint32_t),
+                                       VK_BUFFER_USAGE_INDEX_BUFFER_BIT, true);
+    std::memcpy(vbo.indices.allocation.mapped, indices.data(),
+                indices.size() * sizeof(std::uint32_t));
+  }
+}
+
+VboHandle VulkanRenderer::GenerateVbo(const ShaderPrograms shader_program,
+                                      const std::vector<Vertex>& vertices,
+                                      const std::vector<GLuint>& indices) {
+  VulkanVbo vbo{};
+  vbo.shader = shader_program;
+  AllocateVbo(vbo, vertices, indices);
+  VboHandle vbo_handle;
+  log_.Trace("vbo_handle.uuid = {}", vbo_handle.uuid_);
+  vbos_.emplace(vbo_handle, vbo);
+  return vbo_handle;
+}
+
+VboHandle VulkanRenderer::UpdateVbo(const VboHandle vbo_handle,
+                                    const std::vector<Vertex>& vertices,
+                                    const std::vector<GLuint>& indices) const {
+  const auto it = vbos_.find(vbo_handle);
+  if (it == vbos_.end()) {
+    log_.Error("VBO_handle {} not in map!", vbo_handle);
+    return vbo_handle;
+  }
+  // Frames in flight may still read the old buffers, so replace them
+  VulkanVbo old = it->second;
+  DeferDestroy([this, old]() mutable {
+    device_.DestroyBuffer(old.vertices);
+    device_.DestroyBuffer(old.indices);
+  });
+  it->second.vertices = VulkanBuffer{};
+  it->second.indices = VulkanBuffer{};
+  AllocateVbo(it->second, vertices, indices);
+  return vbo_handle;
+}
+
+bool VulkanRenderer::HasVbo(const VboHandle vbo_handle) const {
+  return (vbos_.count(vbo_handle) != 0);
+}
+
+void VulkanRenderer::SetMatrices(const ShaderPrograms shader_program,
+                                 const glm::mat4& model, const glm::mat4& view,
+                                 const glm::mat4& projection) const {
+  ShaderState& state = GetState(shader_program);
+  state.model = model;
+  state.view = view;
+  state.projection = projection;
+}
+void VulkanRenderer::BindTexture(const ShaderPrograms shader_program,
+                                 const std::string& name,
+                                 const _3D::Texture& texture,
+                                 const GLuint texture_unit) const {
+  log_.Debug("Binding texture id {} to texture unit {} with name {}.",
+             texture.id_, texture_unit, name);
+  // Every shader samples a single texture
+  GetState(shader_program).texture = texture.id_;
+}
+void VulkanRenderer::BindTextureArray(const ShaderPrograms shader_program,
+                                      const std::string& name,
+                                      const unsigned int id,
+                                      const GLuint texture_unit) const {
+  log_.Debug("Binding texture array {} to texture unit {} with name {}.", id,
+             texture_unit, name);
+  GetState(shader_program).texture = id;
+}
+void VulkanRenderer::BindCubemap(const ShaderPrograms shader_program,
+                                 const std::string& name,
+                                 const _3D::Cubemap& cube_map,
+                                 const GLuint texture_unit) const {
+  log_.Debug("Binding cubemap {} to texture unit {} with name {}.",
+             cube_map.id_, texture_unit, name);
+  GetState(shader_program).texture = cube_map.id_;
+}
+void VulkanRenderer::EnableBlending() const { blend_ = true; }
+void VulkanRenderer::DisableBlending() const { blend_ = false; }
+void VulkanRenderer::EnableDepthTesting() const { depth_test_ = true; }
+void VulkanRenderer::DisableDepthTesting() const { depth_test_ = false; }
+
+void VulkanRenderer::SetColor(const ShaderPrograms shader_program,
+                              const glm::vec3 color) const {
+  GetState(shader_program).color = color;
+}
+
+unsigned int VulkanRenderer::CreateTexture(
+    [[maybe_unused]] const ShaderPrograms shader_program,
+    const _3D::PixelFormat format, const glm::ivec2 size,
+    const void* pixels) const {
+  const std::size_t row_stride = PaddedRowStride(
+      size.x, ToVulkan(format, depth_format_), unpack_alignment_);
+  return UploadTexture(format, size,
+                       {static_cast<const std::uint8_t*>(pixels)}, row_stride,
+                       true);
+}
+unsigned int VulkanRenderer::CreateTexture(
+    [[maybe_unused]] const ShaderPrograms shader_program,
+    const _3D::PixelFormat format, const _3D::MipChain& mip_chain) const {
+  if (mip_chain.levels.empty()) {
+    log_.Error("Cannot create a texture from an empty mip chain.");
+    return 0;
+  }
+  std::vector<const std::uint8_t*> levels;
+  for (const _3D::MipLevel& level : mip_chain.levels) {
+    levels.push_back(level.pixels.data());
+  }
+  return UploadTexture(format, mip_chain.levels.front().size, levels, 0,
+                       false);
+}
+unsigned int VulkanRenderer::CreateTextureArray(
+    [[maybe_unused]] const ShaderPrograms shader_program,
+    const _3D::PixelFormat format, const glm::ivec3 size,
+    const int mip_levels, const _3D::TextureWrap wrap) const {
+  const TextureFormat texture = ToVulkan(format, depth_format_);
+  if (!IsUploadable(texture)) {
+    log_.Error("Cannot create a texture array of format {}, {}.",
+               format.i_format, format.e_format);
+    return 0;
+  }
+  VulkanImageDesc desc{};
+  desc.extent = {static_cast<std::uint32_t>(size.x),
+                 static_cast<std::uint32_t>(size.y)};
+  desc.format = texture.format;
+  desc.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+  desc.mip_levels = static_cast<std::uint32_t>(std::max(mip_levels, 1));
+  desc.layers = static_cast<std::uint32_t>(std::max(size.z, 1));
+  desc.view_type = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+  VulkanImage image = device_.CreateImage(desc);
+
+  // Layers are often filled in lazily, so start from zero rather than
+  // undefined contents
+  device_.SubmitImmediate([&](const VkCommandBuffer cmd) {
+    VulkanDevice::TransitionImage(cmd, image,
+                                  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    const VkClearColorValue clear{};
+    const VkImageSubresourceRange range{
+        VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0,
+        VK_REMAINING_ARRAY_LAYERS};
+    vkCmdClearColorImage(cmd, image.image,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clear, 1,
+                         &range);
+    VulkanDevice::TransitionImage(cmd, image,
+                                  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  });
+  return AddTexture(image, true, wrap);
+}
+unsigned int VulkanRenderer::CreateTextureArray(
+    const ShaderPrograms shader_program, const _3D::PixelFormat format,
+    const std::vector<_3D::MipChain>& layers,
+    const _3D::TextureWrap wrap) const {
+  if (layers.empty() || layers.front().levels.empty()) {
+    log_.Error("Cannot create a texture array without layers.");
+    return 0;
+  }
+  const _3D::MipChain& first = layers.front();
+  const unsigned int id = CreateTextureArray(
+      shader_program, format,
+      glm::ivec3(first.levels.front().size, static_cast<int>(layers.size())),
+      static_cast<int>(first.levels.size()), wrap);
+  for (std::size_t layer = 0; layer < layers.size(); layer++) {
+    const std::vector<_3D::MipLevel>& levels = layers[layer].levels;
+    for (std::size_t level = 0; level < levels.size(); level++) {
+      UpdateTextureArray(id, format,
+                         glm::ivec3(0, 0, static_cast<int>(layer)),
+                         levels[level].size, levels[level].pixels.data(),
+                         static_cast<int>(level));
+    }
+  }
+  return id;
+}
+void VulkanRenderer::UpdateTextureArray(const unsigned int id,
+                                        const _3D::PixelFormat format,
+                                        const glm::ivec3 offset,
+                                        const glm::ivec2 size,
+                                        const void* pixels,
+                                        const int level) const {
+  const VulkanImage* image = FindImage(id);
+  if (image == nullptr || image->view_type != VK_IMAGE_VIEW_TYPE_2D_ARRAY) {
+    log_.Error("Texture {} is not a texture array.", id);
+    return;
+  }
+  const TextureFormat texture = ToVulkan(format, depth_format_);
+  if (!IsUploadable(texture) || texture.format != image->format) {
+    log_.Error("Cannot upload pixels of format {}, {} to texture array {}.",
+               format.i_format, format.e_format, id);
+    return;
+  }
+  if (size.x <= 0 || size.y <= 0) {
+    return;
+  }
+
+  // Rows are tightly packed, as GLRenderer uploads them.  Frames in flight
+  // may still sample the texture, so the copy waits for the frame being
+  // built instead of happening now.
+  VulkanBuffer staging = device_.CreateBuffer(
+      static_cast<VkDeviceSize>(size.x) * size.y * texture.channels,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT, true);
+  Repack(texture, static_cast<const std::uint8_t*>(pixels), size,
+         static_cast<std::size_t>(size.x) * texture.source_channels,
+         static_cast<std::uint8_t*>(staging.allocation.mapped));
+  DeferDestroy([this, staging]() mutable { device_.DestroyBuffer(staging); });
+
+  UploadOp upload{};
+  upload.staging = staging.buffer;
+  upload.texture = id;
+  upload.region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT,
+                                    static_cast<std::uint32_t>(level),
+                                    static_cast<std::uint32_t>(offset.z), 1};
+  upload.region.imageOffset = {offset.x, offset.y, 0};
+  upload.region.imageExtent = {static_cast<std::uint32_t>(size.x),
+                               static_cast<std::uint32_t>(size.y), 1};
+  render_op_open_ = false;
+  ops_.emplace_back(upload);
+}
+unsigned int VulkanRenderer::CreateCubemap(
+    [[maybe_unused]] const ShaderPrograms shader_program,
+    const _3D::PixelFormat format, const glm::ivec2 size,
+    const _3D::CubemapBuffers& buffers) const {
+  const TextureFormat texture = ToVulkan(format, depth_format_);
+  if (!IsUploadable(texture)) {
+    log_.Error("Cannot create a cubemap of format {}, {}.", format.i_format,
+               format.e_format);
+    return 0;
+  }
+  // Faces in layer order, which is the order of the GL face targets
+  const std::uint8_t* faces[6] = {buffers.positive_x, buffers.negative_x,
+                                  buffers.positive_y, buffers.negative_y,
+                                  buffers.positive_z, buffers.negative_z};
+  const std::size_t face_bytes =
+      static_cast<std::size_t>(size.x) * size.y * texture.channels;
+  const std::size_t row_stride =
+      PaddedRowStride(size.x, texture, unpack_alignment_);
+  VulkanBuffer staging = device_.CreateBuffer(
+      6 * face_bytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, true);
+  std::uint8_t* out = static_cast<std::uint8_t*>(staging.allocation.mapped);
+  for (std::size_t face = 0; face < 6; face++) {
+    if (faces[face] == nullptr) {
+      std::memset(out + face * face_bytes, 0, face_bytes);
+    } else {
+      Repack(texture, faces[face], size, row_stride, out + face * face_bytes);
+    }
+  }
+
+  VulkanImageDesc desc{};
+  desc.extent = {static_cast<std::uint32_t>(size.x),
+                 static_cast<std::uint32_t>(size.y)};
+  desc.format = texture.format;
+  desc.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+  desc.layers = 6;
+  desc.view_type = VK_IMAGE_VIEW_TYPE_CUBE;
+  desc.swizzle = swizzle_;
+  VulkanImage image = device_.CreateImage(desc);
+  device_.SubmitImmediate([&](const VkCommandBuffer cmd) {
+    VulkanDevice::TransitionImage(cmd, image,
+                                  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    VkBufferImageCopy region{};
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 6};
+    region.imageExtent = {desc.extent.width, desc.extent.height, 1};
+    vkCmdCopyBufferToImage(cmd, staging.buffer, image.image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    VulkanDevice::TransitionImage(cmd, image,
+                                  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  });
+  device_.DestroyBuffer(staging);
+  return AddTexture(image, true);
+}
+
+unsigned int VulkanRenderer::UploadTexture(
+    const _3D::PixelFormat format, const glm::ivec2 size,
+    const std::vector<const std::uint8_t*>& levels,
+    const std::size_t row_stride, const bool generate_mips) const {
+  const TextureFormat texture = ToVulkan(format, depth_format_);
+  if (!IsUploadable(texture)) {
+    log_.Error("Cannot upload pixels of format {}, {} to a Vulkan texture.",
+               format.i_format, format.e_format);
+    return 0;
+  }
+
+  const auto level_size = [size](const std::size_t level) {
+    return glm::ivec2(std::max(1, size.x >> level),
+                      std::max(1, size.y >> level));
+  };
+  std::uint32_t mip_levels = static_cast<std::uint32_t>(levels.size());
+  if (generate_mips && device_.SupportsLinearBlit(texture.format)) {
+    mip_levels =
+        static_cast<std::uint32_t>(_3D::MipmapGenerator::LevelCount(size));
+  }
+
+  // Repack every level tightly at the channel count of the image
+  std::size_t total = 0;
+  for (std::size_t level = 0; level < levels.size(); level++) {
+    const glm::ivec2 extent = level_size(level);
+    total += static_cast<std::size_t>(extent.x) * extent.y * texture.channels;
+  }
+  VulkanBuffer staging =
+      device_.CreateBuffer(total, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, true);
+  std::uint8_t* out = static_cast<std::uint8_t*>(staging.allocation.mapped);
+  std::vector<VkBufferImageCopy> regions;
+  std::size_t offset = 0;
+  for (std::size_t level = 0; level < levels.size(); level++) {
+    const glm::ivec2 extent = level_size(level);
+    const std::size_t source_row =
+        static_cast<std::size_t>(extent.x) * texture.source_channels;
+    const std::size_t stride =
+        level == 0 && row_stride != 0 ? row_stride : source_row;
+
+    VkBufferImageCopy region{};
+    region.bufferOffset = offset;
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT,
+                               static_cast<std::uint32_t>(level), 0, 1};
+    region.imageExtent = {static_cast<std::uint32_t>(extent.x),
+                          static_cast<std::uint32_t>(extent.y), 1};
+    regions.push_back(region);
+    offset += Repack(texture, levels[level], extent, stride, out + offset);
+  }
+
+  VulkanImageDesc desc{};
+  desc.extent = {static_cast<std::uint32_t>(size.x),
+                 static_cast<std::uint32_t>(size.y)};
+  desc.format = texture.format;
+  desc.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+               VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+  desc.mip_levels = mip_levels;
+  desc.swizzle = swizzle_;
+  VulkanImage image = device_.CreateImage(desc);
+
+  const std::uint32_t uploaded = static_cast<std::uint32_t>(levels.size());
+  device_.SubmitImmediate([&](const VkCommandBuffer cmd) {
+    VulkanDevice::TransitionImage(cmd, image,
+                                  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    vkCmdCopyBufferToImage(cmd, staging.buffer, image.image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           static_cast<std::uint32_t>(regions.size()),
+                           regions.data());
+    // Blit each missing level from the one above it, like glGenerateMipmap
+    for (std::uint32_t level = uploaded; level < mip_levels; level++) {
+      LevelBarrier(cmd, image.image, level - 1, 1,
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+      const glm::ivec2 src = level_size(level - 1);
+      const glm::ivec2 dst = level_size(level);
+      VkImageBlit blit{};
+      blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1};
+      blit.srcOffsets[1] = {src.x, src.y, 1};
+      blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+      blit.dstOffsets[1] = {dst.x, dst.y, 1};
+      vkCmdBlitImage(cmd, image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                     image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+                     &blit, VK_FILTER_LINEAR);
+    }
+    if (mip_levels > uploaded) {
+      LevelBarrier(cmd, image.image, 0, uploaded - 1,
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+      LevelBarrier(cmd, image.image, uploaded - 1, mip_levels - uploaded,
+                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+      LevelBarrier(cmd, image.image, mip_levels - 1, 1,
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    } else {
+      LevelBarrier(cmd, image.image, 0, mip_levels,
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+  });
+  image.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  device_.DestroyBuffer(staging);
+  return AddTexture(image, true);
+}
+
+unsigned int VulkanRenderer::AddTexture(const VulkanImage& image,
+                                        const bool sampled,
+                                        const _3D::TextureWrap wrap) const {
+  VulkanTexture texture{};
+  texture.image = image;
+  if (sampled) {
+    VkDescriptorSetAllocateInfo allocate{};
+    allocate.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocate.descriptorPool = descriptor_pool_;
+    allocate.descriptorSetCount = 1;
+    allocate.pSetLayouts = &set_layout_;
+    Check(vkAllocateDescriptorSets(device_.device_, &allocate, &texture.set),
+          "vkAllocateDescriptorSets");
+
+    VkDescriptorImageInfo info{};
+    info.sampler =
+        wrap == _3D::TextureWrap::REPEAT ? repeat_sampler_ : sampler_;
+    info.imageView = image.view;
+    info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = texture.set;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &info;
+    vkUpdateDescriptorSets(device_.device_, 1, &write, 0, nullptr);
+  }
+  const unsigned int id = next_texture_++;
+  textures_.emplace(id, texture);
+  return id;
+}
+
+VulkanImage* VulkanRenderer::FindImage(const unsigned int id) const {
+  const auto it = textures_.find(id);
+  return it == textures_.end() ? nullptr : &it->second.image;
+}
+
+void VulkanRenderer::ReleaseTexture(const unsigned int id) const {
+  DeferDestroy([this, id]() {
+    const auto it = textures_.find(id);
+    if (it == textures_.end()) {
+      return;
+    }
+    if (it->second.set != VK_NULL_HANDLE) {
+      vkFreeDescriptorSets(device_.device_, descriptor_pool_, 1,
+                           &it->second.set);
+    }
+    device_.DestroyImage(it->second.image);
+    textures_.erase(it);
+  });
+}
+
+void VulkanRenderer::SetSwizzleMask(const GLint swizzle_r,
+                                    const GLint swizzle_g,
+                                    const GLint swizzle_b,
+                                    const GLint swizzle_a) const {
+  swizzle_ = {ToSwizzle(swizzle_r), ToSwizzle(swizzle_g), ToSwizzle(swizzle_b),
+              ToSwizzle(swizzle_a)};
+}
+
+void VulkanRenderer::DisableByteAlignementRestriction() const {
+  unpack_alignment_ = 1;
+}
+void VulkanRenderer::EnableByteAlignementRestriction() const {
+  unpack_alignment_ = 4;
+}
+void VulkanRenderer::Clear(const glm::vec4 color) const {
+  if (render_op_open_ && !std::get<RenderOp>(ops_.back()).draws.empty()) {
+    render_op_open_ = false;
+  }
+  RenderOp& op = CurrentRenderOp();
+  op.clear = true;
+  op.clear_color = color;
+}
+
+void VulkanRenderer::DeferDestroy(std::function<void()> destroy) const {
+  deletions_.emplace_back(frame_, std::move(destroy));
+}
+
+void VulkanRenderer::RunDeletions() const {
+  // Everything up to frame_ - kFramesInFlight has finished on the GPU
+  while (!deletions_.empty() &&
+         deletions_.front().first + kFramesInFlight <= frame_) {
+    deletions_.front().second();
+    deletions_.pop_front();
+  }
+}
+
+void VulkanRenderer::WaitFrame(FrameSlot& frame) const {
+  Check(vkWaitForFences(device_.device_, 1, &frame.fence, VK_TRUE, UINT64_MAX),
+        "vkWaitForFences");
+  if (frame.submitted) {
+    DeliverFrame(frame);
+  }
+}
+
+std::size_t VulkanRenderer::DeliverFrame(FrameSlot& frame) const {
+  frame.submitted = false;
+  if (!frame.timers.empty()) {
+    std::uint32_t count = 0;
+    for (const PendingTimer& timer : frame.timers) {
+      count = std::max(count, timer.end + 1);
+    }
+    std::vector<std::uint64_t> stamps(count);
+    if (vkGetQueryPoolResults(device_.device_, frame.queries, 0, count,
+                              count * sizeof(std::uint64_t), stamps.data(),
+                              sizeof(std::uint64_t),
+                              VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+      const double period = device_.properties_.limits.timestampPeriod;
+      for (const PendingTimer& timer : frame.timers) {
+        pass_gpu_ms_[timer.name] =
+            static_cast<double>(stamps[timer.end] - stamps[timer.begin]) *
+            period / 1e6;
+      }
+    }
+    frame.timers.clear();
+  }
+
+  // Callbacks may request more readbacks, so take the list first
+  std::vector<PendingReadback> readbacks;
+  readbacks.swap(frame.readbacks);
+  for (PendingReadback& readback : readbacks) {
+    _3D::ReadbackResult result{};
+    result.size = readback.size;
+    result.pixels.resize(static_cast<std::size_t>(readback.size.x) *
+                         readback.size.y * 4);
+    std::memcpy(result.pixels.data(), readback.slice.mapped,
+                result.pixels.size());
+    if (readback.bgra) {
+      for (std::size_t i = 0; i < result.pixels.size(); i += 4) {
+        std::swap(result.pixels[i], result.pixels[i + 2]);
+      }
+    }
+    readback.callback(result);
+  }
+  return readbacks.size();
+}
+
+void VulkanRenderer::Swap() const {
+  if (!window_readbacks_.empty()) {
+    render_op_open_ = false;
+    for (_3D::ReadbackCallback& callback : window_readbacks_) {
+      ops_.emplace_back(ReadbackOp{0, std::move(callback)});
+    }
+    window_readbacks_.clear();
+  }
+  const VkDevice device = device_.device_;
+  FrameSlot& frame = frames_[frame_ % kFramesInFlight];
+  WaitFrame(frame);
+  frame.readback_arena.Reset();
+  RunDeletions();
+  if (options_.pipeline_cache_save_interval != 0 && frame_ != 0 &&
+      frame_ % options_.pipeline_cache_save_interval == 0) {
+    pipeline_cache_.Save();
+  }
+  // Keep one spare block per pool so churn does not reallocate every frame
+  device_.allocator_.ReleaseEmptyBlocks(1);
+
+  std::uint32_t image_index = 0;
+  if (window_ != nullptr) {
+    VkResult result = VK_ERROR_OUT_OF_DATE_KHR;
+    for (int attempt = 0; attempt < 2 && result == VK_ERROR_OUT_OF_DATE_KHR;
+         attempt++) {
+      if (swapchain_dirty_ || swapchain_ == VK_NULL_HANDLE ||
+          attempt > 0) {
+        DestroySwapchain();
+        CreateSwapchain();
+      }
+      if (swapchain_ == VK_NULL_HANDLE) {
+        break;
+      }
+      result = vkAcquireNextImageKHR(device, swapchain_, UINT64_MAX,
+                                     frame.image_available, VK_NULL_HANDLE,
+                                     &image_index);
+    }
+    if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+      if (swapchain_ != VK_NULL_HANDLE &&
+          result != VK_ERROR_OUT_OF_DATE_KHR) {
+        Check(result, "vkAcquireNextImageKHR");
+      }
+      // Nothing to present to, drop the frame
+      log_.Debug("Dropping a frame without a swapchain image.");
+      // Texture uploads still have to happen, so keep them for the next frame
+      ops_.erase(std::remove_if(ops_.begin(), ops_.end(),
+                                [](const FrameOp& op) {
+                                  return !std::holds_alternative<UploadOp>(op);
+                                }),
+                 ops_.end());
+      render_op_open_ = false;
+      return;
+    }
+    backbuffer_ = VulkanImage{};
+    backbuffer_.image = swapchain_images_[image_index];
+    backbuffer_.view = swapchain_views_[image_index];
+    backbuffer_.format = swapchain_format_;
+    backbuffer_.extent = swapchain_extent_;
+    backbuffer_.aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    // Swapchain images keep nothing from the last time they were presented
+    backbuffer_.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+  } else {
+    backbuffer_ = headless_color_;
+  }
+
+  Check(vkResetFences(device, 1, &frame.fence), "vkResetFences");
+  vkResetCommandPool(device, frame.pool, 0);
+  for (WorkerPool& worker : frame.workers) {
+    vkResetCommandPool(device, worker.pool, 0);
+  }
+  RecordFrame(frame);
+  if (window_ == nullptr) {
+    headless_color_.layout = backbuffer_.layout;
+  }
+
+  VkCommandBufferSubmitInfo command{};
+  command.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+  command.commandBuffer = frame.primary;
+  VkSemaphoreSubmitInfo wait{};
+  wait.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+  wait.semaphore = frame.image_available;
+  wait.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+  VkSemaphoreSubmitInfo signal{};
+  signal.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+  signal.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+  VkSubmitInfo2 submit{};
+  submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+  submit.commandBufferInfoCount = 1;
+  submit.pCommandBufferInfos = &command;
+  if (window_ != nullptr) {
+    signal.semaphore = render_finished_[image_index];
+    submit.waitSemaphoreInfoCount = 1;
+    submit.pWaitSemaphoreInfos = &wait;
+    submit.signalSemaphoreInfoCount = 1;
+    submit.pSignalSemaphoreInfos = &signal;
+  }
+  Check(vkQueueSubmit2(device_.queue_, 1, &submit, frame.fence),
+        "vkQueueSubmit2");
+  frame.submitted = true;
+
+  if (window_ != nullptr) {
+    VkPresentInfoKHR present{};
+    present.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    present.waitSemaphoreCount = 1;
+    present.pWaitSemaphores = &render_finished_[image_index];
+    present.swapchainCount = 1;
+    present.pSwapchains = &swapchain_;
+    present.pImageIndices = &image_index;
+    const VkResult result = vkQueuePresentKHR(device_.queue_, &present);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+      swapchain_dirty_ = true;
+    } else {
+      Check(result, "vkQueuePresentKHR");
+    }
+  }
+
+  ops_.clear();
+  render_op_open_ = false;
+  frame_++;
+}
+
+VulkanRenderer::PassFormats VulkanRenderer::GetPassFormats(
+    const Attachments& attachments) const {
+  PassFormats formats{};
+  if (attachments.backbuffer) {
+    formats.colors.push_back(backbuffer_.format);
+    formats.depth = depth_format_;
+    formats.extent = backbuffer_.extent;
+    return formats;
+  }
+  for (const unsigned int id : attachments.colors) {
+    const VulkanImage* image = FindImage(id);
+    if (image != nullptr) {
+      formats.colors.push_back(image->format);
+      formats.samples = image->samples;
+      formats.extent = image->extent;
+    }
+  }
+  const VulkanImage* depth = FindImage(attachments.depth);
+  if (attachments.depth != 0 && depth != nullptr) {
+    formats.depth = depth->format;
+    formats.samples = depth->samples;
+    formats.extent = depth->extent;
+  }
+  return formats;
+}
+
+void VulkanRenderer::RecordFrame(FrameSlot& frame) const {
+  const VkDevice device = device_.device_;
+  const VkCommandBuffer cmd = frame.primary;
+  VkCommandBufferBeginInfo begin{};
+  begin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  Check(vkBeginCommandBuffer(cmd, &begin), "vkBeginCommandBuffer");
+  if (device_.timestamps_) {
+    vkCmdResetQueryPool(cmd, frame.queries, 0, kMaxTimestamps);
+  }
+
+  // Resolve pipelines and cut the draws into chunks here, so the workers
+  // only record
+  std::vector<PassFormats> formats;
+  std::vector<RecordJob> jobs;
+  std::vector<std::size_t> job_formats;
+  for (FrameOp& op : ops_) {
+    RenderOp* render = std::get_if<RenderOp>(&op);
+    if (render == nullptr) {
+      continue;
+    }
+    formats.push_back(GetPassFormats(render->attachments));
+    const PassFormats& pass = formats.back();
+    for (DrawCommand& draw : render->draws) {
+      PipelineKey key{};
+      key.shader = draw.shader;
+      key.mode = draw.mode;
+      key.blend = draw.blend;
+      key.depth_test = draw.depth_test;
+      key.colors = pass.colors;
+      key.depth = pass.depth;
+      key.samples = pass.samples;
+      draw.pipeline = GetPipeline(key);
+    }
+    const std::size_t count = render->draws.size();
+    const std::size_t chunks =
+        std::clamp<std::size_t>(count / kMinDrawsPerChunk, 1, workers_);
+    for (std::size_t c = 0; count != 0 && c < chunks; c++) {
+      RecordJob job{};
+      job.op = render;
+      job.begin = count * c / chunks;
+      job.end = count * (c + 1) / chunks;
+      jobs.push_back(job);
+      job_formats.push_back(formats.size() - 1);
+    }
+  }
+
+  // Job j is recorded by worker j % workers_ into its (j / workers_)th
+  // secondary
+  for (std::size_t w = 0; w < workers_ && w < jobs.size(); w++) {
+    WorkerPool& worker = frame.workers[w];
+    const std::size_t needed = (jobs.size() - w + workers_ - 1) / workers_;
+    if (worker.secondaries.size() < needed) {
+      const std::size_t first = worker.secondaries.size();
+      worker.secondaries.resize(needed);
+      VkCommandBufferAllocateInfo allocate{};
+      allocate.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+      allocate.commandPool = worker.pool;
+      allocate.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+      allocate.commandBufferCount = static_cast<std::uint32_t>(needed - first);
+      Check(vkAllocateCommandBuffers(device, &allocate,
+                                     worker.secondaries.data() + first),
+            "vkAllocateCommandBuffers");
+    }
+  }
+  for (std::size_t j = 0; j < jobs.size(); j++) {
+    jobs[j].cmd = frame.workers[j % workers_].secondaries[j / workers_];
+  }
+  const int active =
+      static_cast<int>(std::min<std::size_t>(workers_, jobs.size()));
+  util::ParallelFor(active, workers_, 1, [&](const int first,
+                                             const int last) {
+    for (int w = first; w < last; w++) {
+      for (std::size_t j = static_cast<std::size_t>(w); j < jobs.size();
+           j += workers_) {
+        RecordSecondary(jobs[j], formats[job_formats[j]]);
+      }
+    }
+  });
+
+  // Replay the frame in order, executing the secondaries of each pass
+  std::size_t next_job = 0;
+  std::size_t next_pass = 0;
+  std::uint32_t next_query = 0;
+  std::map<std::string, std::uint32_t> open_timers;
+  for (const FrameOp& op : ops_) {
+    if (const RenderOp* render = std::get_if<RenderOp>(&op)) {
+      std::vector<VkCommandBuffer> secondaries;
+      while (next_job < jobs.size() && jobs[next_job].op == render) {
+        secondaries.push_back(jobs[next_job++].cmd);
+      }
+      RecordRenderOp(frame, *render, formats[next_pass++], secondaries);
+    } else if (std::holds_alternative<BarrierOp>(op)) {
+      MemoryBarrier(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                    VK_ACCESS_2_MEMORY_WRITE_BIT,
+                    VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                    VK_ACCESS_2_MEMORY_READ_BIT |
+                        VK_ACCESS_2_MEMORY_WRITE_BIT);
+    } else if (const TimestampOp* stamp = std::get_if<TimestampOp>(&op)) {
+      if (next_query >= kMaxTimestamps) {
+        log_.Warning("Out of timestamp queries, {} is not timed.",
+                     stamp->name);
+        continue;
+      }
+      if (stamp->begin) {
+        open_timers[stamp->name] = next_query;
+      } else {
+        const auto it = open_timers.find(stamp->name);
+        if (it == open_timers.end()) {
+          continue;
+        }
+        frame.timers.push_back({stamp->name, it->second, next_query});
+        open_timers.erase(it);
+      }
+      vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                           frame.queries, next_query++);
+    } else if (const ReadbackOp* readback = std::get_if<ReadbackOp>(&op)) {
+      RecordReadback(frame, *readback);
+    } else if (const UploadOp* upload = std::get_if<UploadOp>(&op)) {
+      RecordUpload(frame, *upload);
+    }
+  }
+
+  if (window_ != nullptr) {
+    VulkanDevice::TransitionImage(cmd, backbuffer_,
+                                  VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+  }
+  Check(vkEndCommandBuffer(cmd), "vkEndCommandBuffer");
+}
+
+void VulkanRenderer::RecordRenderOp(
+    FrameSlot& frame, const RenderOp& op, const PassFormats& formats,
+    const std::vector<VkCommandBuffer>& secondaries) const {
+  if (op.draws.empty() && !op.clear) {
+    return;
+  }
+  const VkCommandBuffer cmd = frame.primary;
+
+  // Layouts can only change outside of rendering, so make the textures the
+  // pass samples readable first
+  for (const DrawCommand& draw : op.draws) {
+    VulkanImage* texture = FindImage(draw.texture);
+    if (texture != nullptr &&
+        texture->layout != VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+      VulkanDevice::TransitionImage(cmd, *texture,
+                                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+  }
+
+  std::vector<VulkanImage*> colors;
+  std::vector<VulkanImage*> resolves;
+  VulkanImage* depth = nullptr;
+  if (op.attachments.backbuffer) {
+    colors.push_back(&backbuffer_);
+    depth = FindImage(backbuffer_depth_);
+  } else {
+    for (const unsigned int id : op.attachments.colors) {
+      if (VulkanImage* image = FindImage(id)) {
+        colors.push_back(image);
+      }
+    }
+    for (const unsigned int id : op.attachments.resolves) {
+      if (VulkanImage* image = FindImage(id)) {
+        resolves.push_back(image);
+      }
+    }
+    if (op.attachments.depth != 0) {
+      depth = FindImage(op.attachments.depth);
+    }
+  }
+
+  std::vector<VkRenderingAttachmentInfo> color_infos;
+  for (std::size_t i = 0; i < colors.size(); i++) {
+    VulkanDevice::TransitionImage(cmd, *colors[i],
+                                  VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    VkRenderingAttachmentInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+    info.imageView = colors[i]->view;
+    info.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    info.loadOp =
+        op.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+    info.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    info.clearValue.color.float32[0] = op.clear_color.r;
+    info.clearValue.color.float32[1] = op.clear_color.g;
+    info.clearValue.color.float32[2] = op.clear_color.b;
+    info.clearValue.color.float32[3] = op.clear_color.a;
+    if (i < resolves.size()) {
+      VulkanDevice::TransitionImage(cmd, *resolves[i],
+                                    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+      info.resolveMode = VK_RESOLVE_MODE_AVERAGE_BIT;
+      info.resolveImageView = resolves[i]->view;
+      info.resolveImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    }
+    color_infos.push_back(info);
+  }
+  VkRenderingAttachmentInfo depth_info{};
+  if (depth != nullptr) {
+    VulkanDevice::TransitionImage(
+        cmd, *depth, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+    depth_info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+    depth_info.imageView = depth->view;
+    depth_info.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depth_info.loadOp =
+        op.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+    depth_info.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    depth_info.clearValue.depthStencil = {1.0f, 0};
+  }
+
+  VkRenderingInfo info{};
+  info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+  if (!secondaries.empty()) {
+    info.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
+  }
+  info.renderArea = {{0, 0}, formats.extent};
+  info.layerCount = 1;
+  info.colorAttachmentCount = static_cast<std::uint32_t>(color_infos.size());
+  info.pColorAttachments = color_infos.data();
+  if (depth != nullptr) {
+    info.pDepthAttachment = &depth_info;
+    if (VulkanDevice::HasStencil(depth->format)) {
+      info.pStencilAttachment = &depth_info;
+    }
+  }
+  vkCmdBeginRendering(cmd, &info);
+  if (!secondaries.empty()) {
+    vkCmdExecuteCommands(cmd, static_cast<std::uint32_t>(secondaries.size()),
+                         secondaries.data());
+  }
+  vkCmdEndRendering(cmd);
+}
+
+void VulkanRenderer::RecordSecondary(const RecordJob& job,
+                                     const PassFormats& formats) const {
+  const VkCommandBuffer cmd = job.cmd;
+  VkCommandBufferInheritanceRenderingInfo rendering{};
+  rendering.sType =
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+  rendering.colorAttachmentCount =
+      static_cast<std::uint32_t>(formats.colors.size());
+  rendering.pColorAttachmentFormats = formats.colors.data();
+  rendering.depthAttachmentFormat = formats.depth;
+  rendering.stencilAttachmentFormat = VulkanDevice::HasStencil(formats.depth)
+                                          ? formats.depth
+                                          : VK_FORMAT_UNDEFINED;
+  rendering.rasterizationSamples = formats.samples;
+  VkCommandBufferInheritanceInfo inheritance{};
+  inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+  inheritance.pNext = &rendering;
+  VkCommandBufferBeginInfo begin{};
+  begin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+  begin.pInheritanceInfo = &inheritance;
+  // Runs on a worker thread, so report failures instead of throwing
+  if (vkBeginCommandBuffer(cmd, &begin) != VK_SUCCESS) {
+    log_.Error("Could not begin a secondary command buffer.");
+    return;
+  }
+
+  const VkRect2D scissor{{0, 0}, formats.extent};
+  vkCmdSetScissor(cmd, 0, 1, &scissor);
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  VkDescriptorSet set = VK_NULL_HANDLE;
+  VkDescriptorSet lights = VK_NULL_HANDLE;
+  VkBuffer vertices = VK_NULL_HANDLE;
+  VkBuffer indices = VK_NULL_HANDLE;
+  glm::ivec2 viewport(-1, -1);
+  for (std::size_t i = job.begin; i < job.end; i++) {
+    const DrawCommand& draw = job.op->draws[i];
+    if (draw.pipeline != pipeline) {
+      pipeline = draw.pipeline;
+      vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    }
+    if (draw.viewport != viewport) {
+      viewport = draw.viewport;
+      const float height = static_cast<float>(formats.extent.height);
+      VkViewport flipped{};
+      flipped.width = static_cast<float>(formats.extent.width);
+      flipped.height = height;
+      if (viewport.x > 0 && viewport.y > 0) {
+        flipped.width = static_cast<float>(viewport.x);
+        flipped.height = static_cast<float>(viewport.y);
+      }
+      // Flip y so NDC matches GL and the bottom left corner is the origin
+      flipped.x = 0.0f;
+      flipped.y = height;
+      flipped.height = -flipped.height;
+      flipped.minDepth = 0.0f;
+      flipped.maxDepth = 1.0f;
+      vkCmdSetViewport(cmd, 0, 1, &flipped);
+    }
+    if (draw.set != set) {
+      set = draw.set;
+      vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              pipeline_layout_, 0, 1, &set, 0, nullptr);
+    }
+    if (draw.lights != lights) {
+      lights = draw.lights;
+      vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              pipeline_layout_, 1, 1, &lights, 0, nullptr);
+    }
+    vkCmdPushConstants(cmd, pipeline_layout_,
+                       VK_SHADER_STAGE_VERTEX_BIT |
+                           VK_SHADER_STAGE_FRAGMENT_BIT,
+                       0, sizeof(PushConstants), &draw.push);
+    if (draw.vertices != VK_NULL_HANDLE && draw.vertices != vertices) {
+      vertices = draw.vertices;
+      const VkDeviceSize offset = 0;
+      vkCmdBindVertexBuffers(cmd, 0, 1, &vertices, &offset);
+    }
+    if (draw.indices != VK_NULL_HANDLE) {
+      if (draw.indices != indices) {
+        indices = draw.indices;
+        vkCmdBindIndexBuffer(cmd, indices, 0, draw.index_type);
+      }
+      vkCmdDrawIndexed(cmd, draw.count, draw.instance_count, draw.first, 0,
+                       draw.first_instance);
+    } else {
+      vkCmdDraw(cmd, draw.count, draw.instance_count, draw.first,
+                draw.first_instance);
+    }
+  }
+  if (vkEndCommandBuffer(cmd) != VK_SUCCESS) {
+    log_.Error("Could not end a secondary command buffer.");
+  }
+}
+
+void VulkanRenderer::RecordUpload(FrameSlot& frame,
+                                  const UploadOp& op) const {
+  VulkanImage* image = FindImage(op.texture);
+  if (image == nullptr) {
+    return;
+  }
+  // RecordRenderOp makes the texture readable again before it is sampled
+  VulkanDevice::TransitionImage(frame.primary, *image,
+                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+  vkCmdCopyBufferToImage(frame.primary, op.staging, image->image,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &op.region);
+}
+
+void VulkanRenderer::RecordReadback(FrameSlot& frame,
+                                    const ReadbackOp& op) const {
+  const VkCommandBuffer cmd = frame.primary;
+  VulkanImage* image = &backbuffer_;
+  if (op.target != 0) {
+    const auto it = render_targets_.find(op.target);
+    image = it == render_targets_.end() ? nullptr : FindImage(it->second.color);
+  } else if (!swapchain_readable_) {
+    image = nullptr;
+  }
+  const bool rgba = image != nullptr &&
+                    (image->format == VK_FORMAT_R8G8B8A8_UNORM ||
+                     image->format == VK_FORMAT_R8G8B8A8_SRGB);
+  const bool bgra = image != nullptr &&
+                    (image->format == VK_FORMAT_B8G8R8A8_UNORM ||
+                     image->format == VK_FORMAT_B8G8R8A8_SRGB);
+  if (!rgba && !bgra) {
+    log_.Error("Render target {} cannot be read back.", op.target);
+    return;
+  }
+
+  PendingReadback readback{};
+  readback.size = glm::ivec2(image->extent.width, image->extent.height);
+  readback.bgra = bgra;
+  readback.callback = op.callback;
+  readback.slice = frame.readback_arena.Allocate(
+      static_cast<VkDeviceSize>(image->extent.width) *
+      image->extent.height * 4);
+
+  VulkanDevice::TransitionImage(cmd, *image,
+                                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+  VkBufferImageCopy region{};
+  region.bufferOffset = readback.slice.offset;
+  region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  region.imageExtent = {image->extent.width, image->extent.height, 1};
+  vkCmdCopyImageToBuffer(cmd, image->image,
+                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                         readback.slice.buffer, 1, &region);
+  MemoryBarrier(cmd, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+                VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_HOST_BIT,
+                VK_ACCESS_2_HOST_READ_BIT);
+  frame.readbacks.push_back(std::move(readback));
+}
+
+unsigned int VulkanRenderer::CreateRenderTarget(
+    const _3D::RenderTargetDesc& desc) {
+  RenderTargetData data{};
+  data.desc = desc;
+  const VkFormat format =
+      ToVulkan(desc.color_format, depth_format_).format;
+  const VkSampleCountFlagBits samples =
+      ToSampleCount(desc.samples, device_.properties_.limits);
+
+  VulkanImageDesc color{};
+  color.extent = {static_cast<std::uint32_t>(desc.size.x),
+                  static_cast<std::uint32_t>(desc.size.y)};
+  color.format = format == VK_FORMAT_UNDEFINED ? VK_FORMAT_R8G8B8A8_UNORM
+                                               : format;
+  color.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+  data.color = AddTexture(device_.CreateImage(color), true);
+  if (samples != VK_SAMPLE_COUNT_1_BIT) {
+    VulkanImageDesc multisampled = color;
+    multisampled.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    multisampled.samples = samples;
+    data.multisampled = AddTexture(device_.CreateImage(multisampled), false);
+  }
+  if (desc.depth) {
+    VulkanImageDesc depth = color;
+    depth.format = depth_format_;
+    depth.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    depth.samples = samples;
+    data.depth = AddTexture(device_.CreateImage(depth), false);
+  }
+
+  const unsigned int handle = next_render_target_++;
+  log_.Trace("render target {} = {}x{}, {} samples", handle, desc.size.x,
+             desc.size.y, desc.samples);
+  render_targets_.emplace(handle, data);
+  return handle;
+}
+
+void VulkanRenderer::DestroyRenderTarget(const unsigned int target) {
+  const auto it = render_targets_.find(target);
+  if (it == render_targets_.end()) {
+    return;
+  }
+  for (const unsigned int id :
+       {it->second.color, it->second.multisampled, it->second.depth}) {
+    if (id != 0) {
+      ReleaseTexture(id);
+    }
+  }
+  render_targets_.erase(it);
+}
+
+void VulkanRenderer::BindRenderTarget(const unsigned int target) const {
+  render_op_open_ = false;
+  if (target == 0) {
+    attachments_ = Attachments{};
+    viewport_ = glm::ivec2(0, 0);
+    return;
+  }
+  const RenderTargetData& data = render_targets_.at(target);
+  Attachments attachments{};
+  attachments.backbuffer = false;
+  if (data.multisampled != 0) {
+    attachments.colors = {data.multisampled};
+    attachments.resolves = {data.color};
+  } else {
+    attachments.colors = {data.color};
+  }
+  attachments.depth = data.depth;
+  attachments_ = attachments;
+  viewport_ = data.desc.size;
+}
+
+void VulkanRenderer::ResolveRenderTarget(
+    [[maybe_unused]] const unsigned int target) const {}
+
+unsigned int VulkanRenderer::GetRenderTargetTexture(
+    const unsigned int target) const {
+  return render_targets_.at(target).color;
+}
+
+void VulkanRenderer::ReadRenderTargetAsync(
+    const unsigned int target, _3D::ReadbackCallback callback) const {
+  if (target == 0) {
+    window_readbacks_.push_back(std::move(callback));
+    return;
+  }
+  render_op_open_ = false;
+  ops_.emplace_back(ReadbackOp{target, std::move(callback)});
+}
+
+std::size_t VulkanRenderer::PollReadbacks() const {
+  std::size_t delivered = 0;
+  for (FrameSlot& frame : frames_) {
+    if (frame.submitted &&
+        vkGetFenceStatus(device_.device_, frame.fence) == VK_SUCCESS) {
+      delivered += DeliverFrame(frame);
+    }
+  }
+  return delivered;
+}
+
+void VulkanRenderer::FinishReadbacks() const {
+  // Oldest frame first, so callbacks run in the order they were requested
+  for (std::size_t i = 1; i <= kFramesInFlight; i++) {
+    WaitFrame(frames_[(frame_ + i) % kFramesInFlight]);
+  }
+}
+
+unsigned int VulkanRenderer::CreateTransientTexture(
+    const _3D::TransientTextureDesc& desc) const {
+  VulkanImageDesc image{};
+  image.extent = {static_cast<std::uint32_t>(desc.size.x),
+                  static_cast<std::uint32_t>(desc.size.y)};
+  image.format = ToVulkan(desc.format, depth_format_).format;
+  if (image.format == VK_FORMAT_UNDEFINED) {
+    log_.Error("Transient texture format {} is not supported, using RGBA8.",
+               desc.format.i_format);
+    image.format = VK_FORMAT_R8G8B8A8_UNORM;
+  }
+  const bool depth = VulkanDevice::AspectOf(image.format) !=
+                     VK_IMAGE_ASPECT_COLOR_BIT;
+  if (depth) {
+    image.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+  } else {
+    image.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                  VK_IMAGE_USAGE_SAMPLED_BIT |
+                  VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                  VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+  }
+  return AddTexture(device_.CreateImage(image), !depth);
+}
+void VulkanRenderer::DestroyTransientTexture(const unsigned int id) const {
+  ReleaseTexture(id);
+}
+unsigned int VulkanRenderer::CreateTransientBuffer(
+    const _3D::TransientBufferDesc& desc) const {
+  constexpr VkDeviceSize kMinSize = 16;
+  const unsigned int id = next_buffer_++;
+  buffers_.emplace(
+      id, device_.CreateBuffer(
+              std::max<VkDeviceSize>(desc.size, kMinSize),
+              VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                  VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+                  VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                  VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                  VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                  VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                  VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+              false));
+  return id;
+}
+void VulkanRenderer::DestroyTransientBuffer(const unsigned int id) const {
+  DeferDestroy([this, id]() {
+    const auto it = buffers_.find(id);
+    if (it != buffers_.end()) {
+      device_.DestroyBuffer(it->second);
+      buffers_.erase(it);
+    }
+  });
+}
+void VulkanRenderer::BindFrameTargets(
+    const _3D::FramePassTargets& targets) const {
+  if (targets.render_target != 0) {
+    BindRenderTarget(targets.render_target);
+  } else {
+    render_op_open_ = false;
+    Attachments attachments{};
+    attachments.backbuffer = targets.backbuffer;
+    if (!targets.backbuffer) {
+      attachments.colors = targets.colors;
+      attachments.depth = targets.has_depth ? targets.depth : 0;
+    }
+    attachments_ = attachments;
+  }
+  if (targets.size.x > 0 && targets.size.y > 0) {
+    viewport_ = targets.size;
+  }
+  if (targets.clear) {
+    RenderOp& op = CurrentRenderOp();
+    op.clear = true;
+    op.clear_color = targets.clear_color;
+  }
+}
+void VulkanRenderer::InsertFrameBarrier(
+    const _3D::FrameBarrier& barrier) const {
+  // Image layouts follow their use when each pass starts, which orders
+  // attachments and sampling; only writes through memory need a barrier
+  if (!barrier.before_write ||
+      (barrier.texture &&
+       barrier.before != _3D::FrameResourceUsage::STORAGE &&
+       barrier.before != _3D::FrameResourceUsage::COPY)) {
+    return;
+  }
+  render_op_open_ = false;
+  ops_.emplace_back(BarrierOp{});
+}
+void VulkanRenderer::BeginPassTimer(const std::string& name) const {
+  if (!device_.timestamps_) {
+    return;
+  }
+  render_op_open_ = false;
+  ops_.emplace_back(TimestampOp{name, true});
+}
+void VulkanRenderer::EndPassTimer(const std::string& name) const {
+  if (!device_.timestamps_) {
+    return;
+  }
+  render_op_open_ = false;
+  ops_.emplace_back(TimestampOp{name, false});
+}
+double VulkanRenderer::GetPassGpuTime(const std::string& name) const {
+  const auto it = pass_gpu_ms_.find(name);
+  return it == pass_gpu_ms_.end() ? -1.0 : it->second;
+}
+
+void VulkanRenderer::UploadLightClusters(
+    const ShaderPrograms shader_program, const _3D::LightClusterData& clusters,
+    const glm::vec3 ambient) const {
+  // Draws already recorded keep the lights they were issued with
+  ShaderState& state = GetState(shader_program);
+  ReleaseLightSet(state.lights);
+  state.lights = CreateLightSet(clusters, ambient, true);
+}
+void VulkanRenderer::DisableLights(const ShaderPrograms shader_program) const {
+  ReleaseLightSet(GetState(shader_program).lights);
+}
+void VulkanRenderer::Upscale(const unsigned int texture,
+                             const glm::vec2 uv_scale,
+                             const _3D::UpscaleFilter filter,
+                             const float sharpness) const {
+  DrawCommand draw{};
+  draw.shader = ShaderPrograms::UPSCALE;
+  draw.mode = _3D::Primitive::TRIANGLES;
+  draw.blend = blend_;
+  draw.depth_test = false;
+  draw.count = 3;
+  draw.texture = texture;
+  // upscale.frag reads its parameters from the color
+  draw.push.color =
+      glm::vec4(uv_scale, filter == _3D::UpscaleFilter::SHARPEN ? 1.0f : 0.0f,
+                sharpness);
+  AppendDraw(draw);
+}
+void VulkanRenderer::DrawSprites(const _2D::SpriteBatch& batch,
+                                 const glm::mat4& projection,
+                                 const ShaderPrograms shader_program) const {
+  if (!IsSpriteShader(shader_program)) {
+    log_.Error("Shader {} cannot draw sprites.", shader_program);
+    return;
+  }
+  const std::vector<_2D::SpriteInstance>& instances = batch.GetInstances();
+  if (instances.empty()) {
+    return;
+  }
+  // A buffer per batch, kept until the frames drawing it have finished
+  const VkDeviceSize size = instances.size() * sizeof(_2D::SpriteInstance);
+  VulkanBuffer buffer =
+      device_.CreateBuffer(size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, true);
+  std::memcpy(buffer.allocation.mapped, instances.data(), size);
+  DeferDestroy([this, buffer]() mutable { device_.DestroyBuffer(buffer); });
+
+  for (const _2D::SpriteDraw& sprite : batch.GetDraws()) {
+    DrawCommand draw{};
+    draw.shader = shader_program;
+    draw.mode = _3D::Primitive::TRIANGLE_STRIP;
+    draw.blend = true;
+    draw.depth_test = false;
+    draw.vertices = buffer.buffer;
+    draw.count = 4;
+    draw.instance_count = sprite.count;
+    draw.first_instance = sprite.first;
+    draw.texture = sprite.texture;
+    draw.push.mvp = projection;
+    AppendDraw(draw);
+  }
+}
+
+std::uint32_t VulkanRenderer::AddStaticMesh(
+    const std::vector<Vertex>& vertices,
+    const std::vector<GLuint>& indices) const {
+  VulkanVbo vbo{};
+  AllocateVbo(vbo, vertices, indices);
+  StaticMesh mesh{};
+  mesh.bounds = _3D::Aabb::FromVertices(vertices);
+  vbos_.emplace(mesh.vbo, vbo);
+  static_meshes_.push_back(mesh);
+  return static_cast<std::uint32_t>(static_meshes_.size() - 1);
+}
+std::uint32_t VulkanRenderer::AddStaticInstance(const std::uint32_t mesh,
+                                                const glm::mat4& model) const {
+  StaticInstance instance{};
+  instance.mesh = mesh;
+  instance.model = model;
+  instance.bounds = static_meshes_[mesh].bounds.Transform(model);
+  static_instances_.push_back(instance);
+  return static_cast<std::uint32_t>(static_instances_.size() - 1);
+}
+void VulkanRenderer::SetStaticInstanceEnabled(const std::uint32_t instance,
+                                              const bool enabled) const {
+  static_instances_[instance].enabled = enabled;
+}
+void VulkanRenderer::DrawStaticInstances(const glm::mat4& view,
+                                         const glm::mat4& projection) const {
+  // Same state as GLRenderer draws them with, minus the texture
+  const ShaderState& state = GetState(ShaderPrograms::INDIRECT);
+  const _3D::Frustum frustum(view, projection);
+  static_visible_ = 0;
+  for (const StaticInstance& instance : static_instances_) {
+    if (!instance.enabled || !frustum.Intersects(instance.bounds)) {
+      continue;
+    }
+    static_visible_++;
+    const VulkanVbo& vbo = vbos_.at(static_meshes_[instance.mesh].vbo);
+    DrawCommand draw{};
+    draw.blend = blend_;
+    draw.depth_test = depth_test_;
+    draw.vertices = vbo.vertices.buffer;
+    if (vbo.n_indices != 0) {
+      draw.indices = vbo.indices.buffer;
+      draw.index_type = vbo.index_type;
+    }
+    draw.count = vbo.n_indices != 0 ? vbo.n_indices : vbo.n_vertices;
+    const glm::mat4 model_view = view * instance.model;
+    draw.push.mvp = projection * model_view;
+    draw.push.color = glm::vec4(state.color, 1.0f);
+    const glm::mat4 rows = glm::transpose(model_view);
+    for (int i = 0; i < 3; i++) {
+      draw.push.model_view[i] = rows[i];
+    }
+    draw.lights = state.lights.set;
+    AppendDraw(draw);
+  }
+}
+std::uint32_t VulkanRenderer::ReadStaticVisibleCount() const {
+  return static_visible_;
+}
+
+VulkanRenderer::LightSet VulkanRenderer::CreateLightSet(
+    const _3D::LightClusterData& clusters, const glm::vec3 ambient,
+    const bool enabled) const {
+  ClusterUniforms uniforms{};
+  uniforms.grid = glm::ivec4(clusters.grid, enabled ? 1 : 0);
+  uniforms.depth_scale_bias = glm::vec4(clusters.depth_scale_bias, 0.0f, 0.0f);
+  uniforms.ambient = glm::vec4(ambient, 0.0f);
+  const std::pair<const void*, std::size_t> data[4] = {
+      {clusters.lights.data(),
+       clusters.lights.size() * sizeof(_3D::GpuLight)},
+      {clusters.clusters.data(),
+       clusters.clusters.size() * sizeof(_3D::LightCluster)},
+      {clusters.indices.data(),
+       clusters.indices.size() * sizeof(std::uint32_t)},
+      {&uniforms, sizeof(uniforms)}};
+
+  LightSet lights{};
+  VkDescriptorSetAllocateInfo allocate{};
+  allocate.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  allocate.descriptorPool = descriptor_pool_;
+  allocate.descriptorSetCount = 1;
+  allocate.pSetLayouts = &light_set_layout_;
+  Check(vkAllocateDescriptorSets(device_.device_, &allocate, &lights.set),
+        "vkAllocateDescriptorSets");
+
+  VkDescriptorBufferInfo infos[4]{};
+  VkWriteDescriptorSet writes[4]{};
+  for (std::uint32_t i = 0; i < 4; i++) {
+    // Never leave a binding empty
+    constexpr std::size_t kMinSize = 16;
+    const bool uniform = i == 3;
+    lights.buffers[i] = device_.CreateBuffer(
+        std::max(data[i].second, kMinSize),
+        uniform ? VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT
+                : VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        true);
+    if (data[i].second > 0) {
+      std::memcpy(lights.buffers[i].allocation.mapped, data[i].first,
+                  data[i].second);
+    }
+    infos[i].buffer = lights.buffers[i].buffer;
+    infos[i].range = VK_WHOLE_SIZE;
+    writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[i].dstSet = lights.set;
+    writes[i].dstBinding = i;
+    writes[i].descriptorCount = 1;
+    writes[i].descriptorType = uniform ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER
+                                       : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writes[i].pBufferInfo = &infos[i];
+  }
+  vkUpdateDescriptorSets(device_.device_, 4, writes, 0, nullptr);
+  return lights;
+}
+
+void VulkanRenderer::ReleaseLightSet(LightSet& lights) const {
+  if (lights.set == VK_NULL_HANDLE) {
+    return;
+  }
+  DeferDestroy([this, old = lights]() mutable {
+    vkFreeDescriptorSets(device_.device_, descriptor_pool_, 1, &old.set);
+    for (VulkanBuffer& buffer : old.buffers) {
+      device_.DestroyBuffer(buffer);
+    }
+  });
+  lights = LightSet{};
+}
+
+void VulkanRenderer::SetUniformMatrix(const ShaderPrograms shader_program,
+                                      const std::string& name,
+                                      const glm::mat4& mat) const {
+  ShaderState& state = GetState(shader_program);
+  if (name == "model") {
+    state.model = mat;
+  } else if (name == "view") {
+    state.view = mat;
+  } else if (name == "projection") {
+    state.projection = mat;
+  } else {
+    log_.Trace("Uniform {} is ignored by the Vulkan renderer.", name);
+  }
+}
+void VulkanRenderer::SetUniformColor(const ShaderPrograms shader_program,
+                                     const std::string& name,
+                                     const glm::vec3& color) const {
+  if (name == "color") {
+    GetState(shader_program).color = color;
+  } else {
+    log_.Trace("Uniform {} is ignored by the Vulkan renderer.", name);
+  }
+}
+
+void VulkanRenderer::SetUniform(
+    [[maybe_unused]] const ShaderPrograms shader_program,
+    const std::string& name, [[maybe_unused]] const bool value) const {
+  log_.Trace("Uniform {} is ignored by the Vulkan renderer.", name);
+}
+void VulkanRenderer::SetUniform(
+    [[maybe_unused]] const ShaderPrograms shader_program,
+    const std::string& name, [[maybe_unused]] const int value) const {
+  log_.Trace("Uniform {} is ignored by the Vulkan renderer.", name);
+}
+void VulkanRenderer::SetUniform(
+    [[maybe_unused]] const ShaderPrograms shader_program,
+    const std::string& name, [[maybe_unused]] const float value) const {
+  log_.Trace("Uniform {} is ignored by the Vulkan renderer.", name);
+}
+void VulkanRenderer::SetUniform(
+    [[maybe_unused]] const ShaderPrograms shader_program,
+    const std::string& name, [[maybe_unused]] const glm::vec2& value) const {
+  log_.Trace("Uniform {} is ignored by the Vulkan renderer.", name);
+}
+void VulkanRenderer::SetUniform(const ShaderPrograms shader_program,
+                                const std::string& name, const float x,
+                                const float y) const {
+  SetUniform(shader_program, name, glm::vec2(x, y));
+}
+void VulkanRenderer::SetUniform(const ShaderPrograms shader_program,
+                                const std::string& name,
+                                const glm::vec3& value) const {
+  SetUniformColor(shader_program, name, value);
+}
+void VulkanRenderer::SetUniform(const ShaderPrograms shader_program,
+                                const std::string& name, const float x,
+                                const float y, const float z) const {
+  SetUniformColor(shader_program, name, glm::vec3(x, y, z));
+}
+void VulkanRenderer::SetUniform(const ShaderPrograms shader_program,
+                                const std::string& name,
+                                const glm::vec4& value) const {
+  SetUniformColor(shader_program, name, glm::vec3(value));
+}
+void VulkanRenderer::SetUniform(const ShaderPrograms shader_program,
+                                const std::string& name, const float x,
+                                const float y, const float z,
+                                [[maybe_unused]] const float w) const {
+  SetUniformColor(shader_program, name, glm::vec3(x, y, z));
+}
+void VulkanRenderer::SetUniform(
+    [[maybe_unused]] const ShaderPrograms shader_program,
+    const std::string& name, [[maybe_unused]] const glm::mat2& mat) const {
+  log_.Trace("Uniform {} is ignored by the Vulkan renderer.", name);
+}
+void VulkanRenderer::SetUniform(
+    [[maybe_unused]] const ShaderPrograms shader_program,
+    const std::string& name, [[maybe_unused]] const glm::mat3& mat) const {
+  log_.Trace("Uniform {} is ignored by the Vulkan renderer.", name);
+}
+void VulkanRenderer::SetUniform(const ShaderPrograms shader_program,
+                                const std::string& name,
+                                const glm::mat4& mat) const {
+  SetUniformMatrix(shader_program, name, mat);
+}
+
+} /* namespace game_engine::vulkan */
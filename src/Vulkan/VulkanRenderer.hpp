@@ -20,8 +20,685 @@
 #ifndef SRC_VULKAN_VULKANRENDERER_HPP_
 #define SRC_VULKAN_VULKANRENDERER_HPP_
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
 
+#include <vulkan/vulkan.h>
 
+#include "3D/BoundingVolume.hpp"
+#include "3D/FrameGraph.hpp"
+#include "3D/LightClusterer.hpp"
+#include "3D/MipmapGenerator.hpp"
+#include "3D/RenderTarget.hpp"
+#include "3D/ResolutionController.hpp"
+#include "3D/Texture.hpp"
+#include "Renderer.hpp"
+#include "Vertex.hpp"
+#include "Vulkan/VulkanDevice.hpp"
+#include "Vulkan/VulkanLinearArena.hpp"
+#include "Vulkan/VulkanPipelineCache.hpp"
+#include "Vulkan/VulkanWindowManager.hpp"
 
+namespace game_engine::vulkan {
+
+/**
+ * @brief Options for VulkanRenderer::Init
+ */
+struct VulkanRendererOptions {
+  /**
+   * @brief Render into an offscreen image of the given size instead of a
+   *        window, for tests and tools
+   */
+  bool headless = false;
+  glm::ivec2 size{1920, 1080};
+  bool validation = false;
+  /**
+   * @brief Pick a CPU implementation such as lavapipe over any GPU
+   */
+  bool prefer_software = false;
+  /**
+   * @brief Threads recording secondary command buffers, including the one
+   *        calling Swap.  0 uses every hardware thread.
+   */
+  unsigned int recording_threads = 0;
+  /**
+   * @brief Directory the pipeline cache is saved to.  Empty uses the user
+   *        cache directory.
+   */
+  std::filesystem::path pipeline_cache_directory{};
+  /**
+   * @brief Save the pipeline cache every this many frames if it grew, as well
+   *        as on Destroy.  0 only saves on Destroy.
+   */
+  unsigned int pipeline_cache_save_interval = 3600;
+  /**
+   * @brief Create the pipelines of every shader for the backbuffer on a
+   *        background thread at Init, so their first draws do not stall
+   */
+  bool warm_up_pipelines = true;
+};
+
+/**
+ * @brief Renderer backed by Vulkan 1.3
+ *
+ * The immediate style calls of the Renderer interface only append draws,
+ * with a snapshot of the state they depend on, to the current frame.  Swap
+ * resolves their pipelines, splits the draws of each render pass into
+ * chunks recorded into secondary command buffers by worker threads, each
+ * with its own command pool, and executes the secondaries from one primary
+ * command buffer.  Up to kFramesInFlight frames are queued on the GPU, each
+ * with its own fence; resources released while a frame may still use them
+ * are destroyed once it has finished.
+ *
+ * Draws use push constants rather than uniforms, so SetMatrices, SetColor
+ * and the model, view, projection and color uniforms are understood, and
+ * other uniforms are ignored.  Clustered lights are bound as a second
+ * descriptor set.  Images are rendered upright with a flipped viewport, so
+ * render targets sampled as textures are upside down compared to GL, which
+ * upscale.frag undoes.  Texture array updates are copied by the frame, in
+ * order with its draws.  Static instances are culled on the CPU and drawn
+ * one by one, since there is no GPU culling path yet.
+ */
+class VulkanRenderer : public Renderer<VulkanRenderer, VulkanWindowManager> {
+ public:
+  VulkanRenderer() = default;
+  VulkanRenderer(const VulkanRenderer&) = delete;
+  VulkanRenderer& operator=(const VulkanRenderer&) = delete;
+  ~VulkanRenderer();
+
+  void Init(const std::string program_name);
+  void Init(const std::string program_name,
+            const VulkanRendererOptions& options);
+  /**
+   * @brief Wait for the GPU and release every Vulkan object
+   */
+  void Destroy();
+
+  void UseShader(const ShaderPrograms shader_program) const;
+  bool IsShaderReady(const ShaderPrograms shader_program) const;
+
+  void Render(const VboHandle vbo_handle, const _3D::Primitive mode) const;
+  void Render(const VboHandle vbo_handle, const _3D::Primitive mode,
+              const std::size_t first_index,
+              const std::size_t index_count) const;
+
+  VboHandle GenerateVbo(const ShaderPrograms shader_program,
+                        const std::vector<Vertex>& vertices,
+                        const std::vector<GLuint>& indices);
+  VboHandle UpdateVbo(const VboHandle vbo_handle,
+                      const std::vector<Vertex>& vertices,
+                      const std::vector<GLuint>& indices) const;
+
+  bool HasVbo(const VboHandle vbo_handle) const;
+
+  void SetMatrices(const ShaderPrograms shader_program, const glm::mat4& model,
+                   const glm::mat4& view, const glm::mat4& projection) const;
+  void BindTexture(const ShaderPrograms shader_program, const std::string& name,
+                   const _3D::Texture& texture,
+                   const GLuint texture_unit) const;
+  void BindTextureArray(const ShaderPrograms shader_program,
+                        const std::string& name, const unsigned int id,
+                        const GLuint texture_unit) const;
+  void BindCubemap(const ShaderPrograms shader_program, const std::string& name,
+                   const _3D::Cubemap& cube_map,
+                   const GLuint texture_unit) const;
+  void EnableBlending() const;
+  void DisableBlending() const;
+  void EnableDepthTesting() const;
+  void DisableDepthTesting() const;
+  void SetColor(const ShaderPrograms shader_program,
+                const glm::vec3 color) const;
+  unsigned int CreateTexture(const ShaderPrograms shader_program,
+                             const _3D::PixelFormat format,
+                             const glm::ivec2 size, const void* pixels) const;
+  unsigned int CreateTexture(const ShaderPrograms shader_program,
+                             const _3D::PixelFormat format,
+                             const _3D::MipChain& mip_chain) const;
+  unsigned int CreateTextureArray(const ShaderPrograms shader_program,
+                                  const _3D::PixelFormat format,
+                                  const glm::ivec3 size, const int mip_levels,
+                                  const _3D::TextureWrap wrap) const;
+  unsigned int CreateTextureArray(const ShaderPrograms shader_program,
+                                  const _3D::PixelFormat format,
+                                  const std::vector<_3D::MipChain>& layers,
+                                  const _3D::TextureWrap wrap) const;
+  void UpdateTextureArray(const unsigned int id, const _3D::PixelFormat format,
+                          const glm::ivec3 offset, const glm::ivec2 size,
+                          const void* pixels, const int level = 0) const;
+  unsigned int CreateCubemap(const ShaderPrograms shader_program,
+                             const _3D::PixelFormat format,
+                             const glm::ivec2 size,
+                             const _3D::CubemapBuffers& buffers) const;
+  /**
+   * @brief Set the swizzle of the textures created afterwards
+   */
+  void SetSwizzleMask(const GLint swizzle_r, const GLint swizzle_g,
+                      const GLint swizzle_b, const GLint swizzle_a) const;
+  void DisableByteAlignementRestriction() const;
+  void EnableByteAlignementRestriction() const;
+  void Clear(glm::vec4 color) const;
+  /**
+   * @brief Record and submit the frame, then present it
+   */
+  void Swap() const;
+
+  /*  Offscreen render targets  */
+  unsigned int CreateRenderTarget(const _3D::RenderTargetDesc& desc);
+  void DestroyRenderTarget(const unsigned int target);
+  void BindRenderTarget(const unsigned int target) const;
+  /**
+   * @brief Multisampled targets are resolved when their pass ends, so this
+   *        does nothing
+   */
+  void ResolveRenderTarget(const unsigned int target) const;
+  unsigned int GetRenderTargetTexture(const unsigned int target) const;
+  /**
+   * @brief Copy a render target to the CPU once the draws before it have
+   *        run.  The copy is submitted with the frame by Swap.
+   */
+  void ReadRenderTargetAsync(const unsigned int target,
+                             _3D::ReadbackCallback callback) const;
+  std::size_t PollReadbacks() const;
+  /**
+   * @brief Wait for every submitted frame and deliver its readbacks
+   */
+  void FinishReadbacks() const;
+
+  /*  Frame graph backend  */
+  unsigned int CreateTransientTexture(
+      const _3D::TransientTextureDesc& desc) const;
+  void DestroyTransientTexture(const unsigned int id) const;
+  unsigned int CreateTransientBuffer(
+      const _3D::TransientBufferDesc& desc) const;
+  void DestroyTransientBuffer(const unsigned int id) const;
+  void BindFrameTargets(const _3D::FramePassTargets& targets) const;
+  void InsertFrameBarrier(const _3D::FrameBarrier& barrier) const;
+  void BeginPassTimer(const std::string& name) const;
+  void EndPassTimer(const std::string& name) const;
+  double GetPassGpuTime(const std::string& name) const;
+
+  void UploadLightClusters(const ShaderPrograms shader_program,
+                           const _3D::LightClusterData& clusters,
+                           const glm::vec3 ambient) const;
+  void DisableLights(const ShaderPrograms shader_program) const;
+  void Upscale(const unsigned int texture, const glm::vec2 uv_scale,
+               const _3D::UpscaleFilter filter, const float sharpness) const;
+  void DrawSprites(const _2D::SpriteBatch& batch, const glm::mat4& projection,
+                   const ShaderPrograms shader_program) const;
+
+  std::uint32_t AddStaticMesh(const std::vector<Vertex>& vertices,
+                              const std::vector<GLuint>& indices) const;
+  std::uint32_t AddStaticInstance(const std::uint32_t mesh,
+                                  const glm::mat4& model) const;
+  void SetStaticInstanceEnabled(const std::uint32_t instance,
+                                const bool enabled) const;
+  void DrawStaticInstances(const glm::mat4& view,
+                           const glm::mat4& projection) const;
+  std::uint32_t ReadStaticVisibleCount() const;
+
+  void SetUniform(const ShaderPrograms shader_program, const std::string& name,
+                  const bool value) const;
+  void SetUniform(const ShaderPrograms shader_program, const std::string& name,
+                  const int value) const;
+  void SetUniform(const ShaderPrograms shader_program, const std::string& name,
+                  const float value) const;
+  void SetUniform(const ShaderPrograms shader_program, const std::string& name,
+                  const glm::vec2& value) const;
+  void SetUniform(const ShaderPrograms shader_program, const std::string& name,
+                  const float x, const float y) const;
+  void SetUniform(const ShaderPrograms shader_program, const std::string& name,
+                  const glm::vec3& value) const;
+  void SetUniform(const ShaderPrograms shader_program, const std::string& name,
+                  const float x, const float y, const float z) const;
+  void SetUniform(const ShaderPrograms shader_program, const std::string& name,
+                  const glm::vec4& value) const;
+  void SetUniform(const ShaderPrograms shader_program, const std::string& name,
+                  const float x, const float y, const float z,
+                  const float w) const;
+  void SetUniform(const ShaderPrograms shader_program, const std::string& name,
+                  const glm::mat2& mat) const;
+  void SetUniform(const ShaderPrograms shader_program, const std::string& name,
+                  const glm::mat3& mat) const;
+  void SetUniform(const ShaderPrograms shader_program, const std::string& name,
+                  const glm::mat4& mat) const;
+
+  /**
+   * @brief Number of threads recording secondary command buffers
+   */
+  unsigned int GetRecordingThreads() const { return workers_; }
+  /**
+   * @brief Block until the pipelines created at Init exist
+   */
+  void WaitForPipelineWarmUp() const;
+  std::size_t GetPipelineCount() const;
+  const VulkanPipelineCache& GetPipelineCache() const {
+    return pipeline_cache_;
+  }
+
+  static constexpr std::size_t kFramesInFlight = 2;
+  /**
+   * @brief Fewest draws worth recording on a separate thread
+   */
+  static constexpr std::size_t kMinDrawsPerChunk = 64;
+  static constexpr std::uint32_t kMaxTimestamps = 128;
+
+  VulkanDevice device_{};
+
+ private:
+  logging::Log log_ = logging::Log("main");
+
+ protected:
+  /**
+   * @brief Push constants shared by every shader, all of the guaranteed 128
+   *        bytes
+   */
+  struct PushConstants {
+    glm::mat4 mvp{1.0f};
+    glm::vec4 color{1.0f, 1.0f, 1.0f, 1.0f};
+    /**
+     * @brief Rows of the top 3x4 of view * model.  There is no room left for
+     *        a normal matrix, so default.vert derives it from them.
+     */
+    glm::vec4 model_view[3] = {glm::vec4(1.0f, 0.0f, 0.0f, 0.0f),
+                               glm::vec4(0.0f, 1.0f, 0.0f, 0.0f),
+                               glm::vec4(0.0f, 0.0f, 1.0f, 0.0f)};
+  };
+  /**
+   * @brief Clustered lights uploaded for a shader, bound as set 1
+   */
+  struct LightSet {
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    /**
+     * @brief Lights, clusters, light indices and the cluster parameters
+     */
+    VulkanBuffer buffers[4] = {};
+  };
+  /**
+   * @brief Uniform state of a shader, captured by every draw using it
+   */
+  struct ShaderState {
+    glm::mat4 model{1.0f};
+    glm::mat4 view{1.0f};
+    glm::mat4 projection{1.0f};
+    glm::vec3 color{1.0f, 1.0f, 1.0f};
+    unsigned int texture = 0;
+    LightSet lights{};
+  };
+  struct VulkanVbo {
+    ShaderPrograms shader = ShaderPrograms::DEFAULT;
+    VulkanBuffer vertices{};
+    VulkanBuffer indices{};
+    VkIndexType index_type = VK_INDEX_TYPE_UINT32;
+    std::uint32_t n_vertices = 0;
+    std::uint32_t n_indices = 0;
+  };
+  struct VulkanTexture {
+    VulkanImage image{};
+    /**
+     * @brief Descriptor set sampling the texture, VK_NULL_HANDLE for depth
+     */
+    VkDescriptorSet set = VK_NULL_HANDLE;
+  };
+  struct StaticMesh {
+    VboHandle vbo{};
+    _3D::Aabb bounds{};
+  };
+  struct StaticInstance {
+    std::uint32_t mesh = 0;
+    glm::mat4 model{1.0f};
+    /**
+     * @brief World space bounds
+     */
+    _3D::Aabb bounds{};
+    bool enabled = true;
+  };
+  struct RenderTargetData {
+    _3D::RenderTargetDesc desc{};
+    /**
+     * @brief Texture holding the single sampled color
+     */
+    unsigned int color = 0;
+    /**
+     * @brief Multisampled color resolved into color, or 0
+     */
+    unsigned int multisampled = 0;
+    unsigned int depth = 0;
+  };
+
+  /**
+   * @brief Images a render pass draws into, by texture id
+   */
+  struct Attachments {
+    /**
+     * @brief Draw into the swapchain image, or the headless backbuffer
+     */
+    bool backbuffer = true;
+    std::vector<unsigned int> colors{};
+    /**
+     * @brief Single sampled images each color is resolved into, if any
+     */
+    std::vector<unsigned int> resolves{};
+    unsigned int depth = 0;
+  };
+  struct PipelineKey {
+    ShaderPrograms shader = ShaderPrograms::DEFAULT;
+    _3D::Primitive mode = _3D::Primitive::TRIANGLES;
+    bool blend = false;
+    bool depth_test = true;
+    std::vector<VkFormat> colors{};
+    VkFormat depth = VK_FORMAT_UNDEFINED;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+
+    bool operator<(const PipelineKey& other) const;
+  };
+  struct DrawCommand {
+    ShaderPrograms shader = ShaderPrograms::DEFAULT;
+    _3D::Primitive mode = _3D::Primitive::TRIANGLES;
+    bool blend = false;
+    bool depth_test = true;
+    /**
+     * @brief Resolved by Swap once the formats of the pass are known
+     */
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkBuffer vertices = VK_NULL_HANDLE;
+    VkBuffer indices = VK_NULL_HANDLE;
+    VkIndexType index_type = VK_INDEX_TYPE_UINT32;
+    std::uint32_t first = 0;
+    std::uint32_t count = 0;
+    std::uint32_t instance_count = 1;
+    std::uint32_t first_instance = 0;
+    unsigned int texture = 0;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    VkDescriptorSet lights = VK_NULL_HANDLE;
+    glm::ivec2 viewport{0, 0};
+    PushConstants push{};
+  };
+  /**
+   * @brief The commands of a frame, in the order they were issued
+   */
+  struct RenderOp {
+    Attachments attachments{};
+    bool clear = false;
+    glm::vec4 clear_color{0.0f, 0.0f, 0.0f, 1.0f};
+    std::vector<DrawCommand> draws{};
+  };
+  struct BarrierOp {};
+  struct TimestampOp {
+    std::string name{};
+    bool begin = true;
+  };
+  struct ReadbackOp {
+    unsigned int target = 0;
+    _3D::ReadbackCallback callback{};
+  };
+  /**
+   * @brief Copy from a staging buffer into part of a texture
+   */
+  struct UploadOp {
+    VkBuffer staging = VK_NULL_HANDLE;
+    unsigned int texture = 0;
+    VkBufferImageCopy region{};
+  };
+  using FrameOp =
+      std::variant<RenderOp, BarrierOp, TimestampOp, ReadbackOp, UploadOp>;
+
+  struct PendingReadback {
+    VulkanArenaSlice slice{};
+    glm::ivec2 size{0, 0};
+    bool bgra = false;
+    _3D::ReadbackCallback callback{};
+  };
+  struct PendingTimer {
+    std::string name{};
+    std::uint32_t begin = 0;
+    std::uint32_t end = 0;
+  };
+  /**
+   * @brief Command pool of one recording thread for one frame in flight
+   */
+  struct WorkerPool {
+    VkCommandPool pool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> secondaries{};
+  };
+  struct FrameSlot {
+    VkFence fence = VK_NULL_HANDLE;
+    VkSemaphore image_available = VK_NULL_HANDLE;
+    VkCommandPool pool = VK_NULL_HANDLE;
+    VkCommandBuffer primary = VK_NULL_HANDLE;
+    VkQueryPool queries = VK_NULL_HANDLE;
+    std::vector<WorkerPool> workers{};
+    std::vector<PendingReadback> readbacks{};
+    std::vector<PendingTimer> timers{};
+    /**
+     * @brief Readback buffers, reset once the frame's readbacks have been
+     *        delivered
+     */
+    VulkanLinearArena readback_arena{};
+    /**
+     * @brief Whether work was submitted that has not been waited on
+     */
+    bool submitted = false;
+  };
+  /**
+   * @brief A chunk of the draws of a render pass, recorded into one
+   *        secondary command buffer
+   */
+  struct RecordJob {
+    const RenderOp* op = nullptr;
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    VkCommandBuffer cmd = VK_NULL_HANDLE;
+  };
+  struct PassFormats {
+    std::vector<VkFormat> colors{};
+    VkFormat depth = VK_FORMAT_UNDEFINED;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+    VkExtent2D extent{0, 0};
+  };
+
+  void CreateSurfaceAndDevice(const std::string& program_name,
+                              const VulkanRendererOptions& options);
+  void CreateSwapchain() const;
+  void DestroySwapchain() const;
+  void CreateFrames();
+  void CreateDescriptors();
+  void CreateShaderModules();
+  /**
+   * @brief Create the textures sampled by draws without a texture of the
+   *        type their shader expects
+   */
+  void CreateWhiteTextures();
+  VkShaderModule LoadShaderModule(const std::string& name) const;
+
+  VkPipeline GetPipeline(const PipelineKey& key) const;
+  VkPipeline CreatePipeline(const PipelineKey& key) const;
+  /**
+   * @brief Start creating, on a background thread, the pipelines draws to
+   *        the backbuffer can need
+   */
+  void StartPipelineWarmUp();
+
+  /**
+   * @brief Add a texture and the descriptor set sampling it
+   * @return Returns the id of the texture
+   */
+  unsigned int AddTexture(
+      const VulkanImage& image, const bool sampled,
+      const _3D::TextureWrap wrap = _3D::TextureWrap::CLAMP) const;
+  /**
+   * @brief Upload tightly packed levels into a new sampled texture
+   * @param generate_mips Generate the remaining levels from the last one
+   */
+  unsigned int UploadTexture(const _3D::PixelFormat format,
+                             const glm::ivec2 size,
+                             const std::vector<const std::uint8_t*>& levels,
+                             const std::size_t row_stride,
+                             const bool generate_mips) const;
+  VulkanImage* FindImage(const unsigned int id) const;
+  /**
+   * @brief Destroy a texture once the GPU is done with it
+   */
+  void ReleaseTexture(const unsigned int id) const;
+  void AllocateVbo(VulkanVbo& vbo, const std::vector<Vertex>& vertices,
+                   const std::vector<GLuint>& indices) const;
+
+  /**
+   * @brief Append a draw using the state of its shader to the render pass
+   *        being built
+   */
+  void AddDraw(DrawCommand draw) const;
+  /**
+   * @brief Append a draw whose texture and push constants are already set
+   */
+  void AppendDraw(DrawCommand draw) const;
+  RenderOp& CurrentRenderOp() const;
+  ShaderState& GetState(const ShaderPrograms shader_program) const;
+  void SetUniformMatrix(const ShaderPrograms shader_program,
+                        const std::string& name, const glm::mat4& mat) const;
+  void SetUniformColor(const ShaderPrograms shader_program,
+                       const std::string& name, const glm::vec3& color) const;
+  LightSet CreateLightSet(const _3D::LightClusterData& clusters,
+                          const glm::vec3 ambient, const bool enabled) const;
+  /**
+   * @brief Destroy a light set once the GPU is done with it
+   */
+  void ReleaseLightSet(LightSet& lights) const;
+
+  /**
+   * @brief Defer destroying something until the frame being built, and every
+   *        frame before it, has finished on the GPU
+   */
+  void DeferDestroy(std::function<void()> destroy) const;
+  /**
+   * @brief Wait for a frame slot, then deliver its readbacks and timers
+   */
+  void WaitFrame(FrameSlot& frame) const;
+  /**
+   * @return Returns the number of readbacks delivered
+   */
+  std::size_t DeliverFrame(FrameSlot& frame) const;
+  void RunDeletions() const;
+
+  void RecordFrame(FrameSlot& frame) const;
+  PassFormats GetPassFormats(const Attachments& attachments) const;
+  void RecordRenderOp(FrameSlot& frame, const RenderOp& op,
+                      const PassFormats& formats,
+                      const std::vector<VkCommandBuffer>& secondaries) const;
+  void RecordReadback(FrameSlot& frame, const ReadbackOp& op) const;
+  void RecordUpload(FrameSlot& frame, const UploadOp& op) const;
+  void RecordSecondary(const RecordJob& job, const PassFormats& formats) const;
+
+  VulkanRendererOptions options_{};
+  bool initialized_ = false;
+  unsigned int workers_ = 1;
+
+  VkSurfaceKHR surface_ = VK_NULL_HANDLE;
+  mutable VkSwapchainKHR swapchain_ = VK_NULL_HANDLE;
+  mutable VkFormat swapchain_format_ = VK_FORMAT_UNDEFINED;
+  mutable VkExtent2D swapchain_extent_{0, 0};
+  mutable std::vector<VkImage> swapchain_images_{};
+  mutable std::vector<VkImageView> swapchain_views_{};
+  /**
+   * @brief Signaled when rendering to each swapchain image is done
+   */
+  mutable std::vector<VkSemaphore> render_finished_{};
+  /**
+   * @brief Whether swapchain images can be copied from, for readbacks
+   */
+  mutable bool swapchain_readable_ = false;
+  /**
+   * @brief Color image of the backbuffer for the frame being recorded
+   */
+  mutable VulkanImage backbuffer_{};
+  /**
+   * @brief Offscreen color when headless, otherwise unused
+   */
+  mutable VulkanImage headless_color_{};
+  /**
+   * @brief Depth of the window or headless backbuffer
+   */
+  mutable unsigned int backbuffer_depth_ = 0;
+  VkFormat depth_format_ = VK_FORMAT_UNDEFINED;
+
+  mutable FrameSlot frames_[kFramesInFlight] = {};
+  mutable std::uint64_t frame_ = 0;
+
+  VkDescriptorSetLayout set_layout_ = VK_NULL_HANDLE;
+  VkDescriptorSetLayout light_set_layout_ = VK_NULL_HANDLE;
+  VkDescriptorPool descriptor_pool_ = VK_NULL_HANDLE;
+  VkSampler sampler_ = VK_NULL_HANDLE;
+  VkSampler repeat_sampler_ = VK_NULL_HANDLE;
+  /**
+   * @brief Bound by draws of shaders without lights
+   */
+  LightSet no_lights_{};
+  VkPipelineLayout pipeline_layout_ = VK_NULL_HANDLE;
+  std::map<ShaderPrograms, std::pair<VkShaderModule, VkShaderModule>>
+      shader_modules_{};
+  /**
+   * @brief Guards pipelines_, which the warm-up thread also fills
+   */
+  mutable std::mutex pipelines_mutex_{};
+  mutable std::map<PipelineKey, VkPipeline> pipelines_{};
+  mutable VulkanPipelineCache pipeline_cache_{};
+  mutable std::thread warm_up_thread_{};
+  std::atomic<bool> stop_warm_up_{false};
+
+  mutable std::map<VboHandle, VulkanVbo> vbos_{};
+  mutable std::vector<StaticMesh> static_meshes_{};
+  mutable std::vector<StaticInstance> static_instances_{};
+  mutable std::uint32_t static_visible_ = 0;
+  mutable std::map<unsigned int, VulkanTexture> textures_{};
+  mutable unsigned int next_texture_ = 1;
+  /**
+   * @brief 1x1 white textures sampled by draws without a texture, by view
+   *        type
+   */
+  std::map<VkImageViewType, unsigned int> white_textures_{};
+  mutable std::map<unsigned int, VulkanBuffer> buffers_{};
+  mutable unsigned int next_buffer_ = 1;
+  /**
+   * @brief Render targets by handle.  Handle 0 is the window.
+   */
+  std::map<unsigned int, RenderTargetData> render_targets_{};
+  unsigned int next_render_target_ = 1;
+
+  /*  State captured by the draws  */
+  mutable std::map<ShaderPrograms, ShaderState> shader_states_{};
+  mutable bool blend_ = false;
+  mutable bool depth_test_ = true;
+  mutable VkComponentMapping swizzle_{};
+  mutable int unpack_alignment_ = 4;
+  mutable Attachments attachments_{};
+
+  /*  The frame being built  */
+  mutable std::vector<FrameOp> ops_{};
+  /**
+   * @brief Readbacks of the backbuffer, appended to ops_ by Swap so they see
+   *        the whole frame
+   */
+  mutable std::vector<_3D::ReadbackCallback> window_readbacks_{};
+  /**
+   * @brief Whether the last op is a render pass draws can be appended to
+   */
+  mutable bool render_op_open_ = false;
+
+  mutable std::deque<std::pair<std::uint64_t, std::function<void()>>>
+      deletions_{};
+  mutable std::map<std::string, double> pass_gpu_ms_{};
+};
+
+} /* namespace game_engine::vulkan */
 
 #endif /* SRC_VULKAN_VULKANRENDERER_HPP_ */
@@ -0,0 +1,110 @@
+/******************************************************************************
+ * VulkanWindowManager.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "Vulkan/VulkanWindowManager.hpp"
+
+#include <SDL2/SDL.h>
+
+#include "LoggerV2/Log.hpp"
+
+namespace game_engine::vulkan {
+
+SDL_Window* VulkanWindowManager::window_ = nullptr;
+glm::ivec2 VulkanWindowManager::headless_size_{0, 0};
+
+void VulkanWindowManager::Init([[maybe_unused]] std::string program_name) {}
+
+SDL_Window* VulkanWindowManager::GetWindow() { return window_; }
+void VulkanWindowManager::SetWindow(SDL_Window* p) { window_ = p; }
+
+glm::ivec2 VulkanWindowManager::GetWindowSize() {
+  if (window_ == nullptr) {
+    return headless_size_;
+  }
+  glm::ivec2 v(0, 0);
+  SDL_GetWindowSize(window_, &v.x, &v.y);
+  return v;
+}
+
+void VulkanWindowManager::SetFullscreen(bool enable) {
+  if (window_ == nullptr) {
+    return;
+  }
+  if (SDL_GetDesktopDisplayMode(SDL_GetWindowDisplayIndex(window_), &native_) !=
+      0) {
+    log_.Error("Could not get display mode for video display #{}: {}",
+               SDL_GetWindowDisplayIndex(window_), SDL_GetError());
+    throw EXIT_FAILURE;
+  } else {
+    log_.Debug("Display #{}: native display mode is {}x{}px @ {}hz.",
+               SDL_GetWindowDisplayIndex(window_), native_.w, native_.h,
+               native_.refresh_rate);
+  }
+  is_screen_fullscreen_ = enable;
+  current_ = native_;
+  if (is_screen_fullscreen_) {
+    SDL_SetWindowFullscreen(window_, SDL_WINDOW_FULLSCREEN);
+    SDL_SetWindowDisplayMode(window_, &current_);
+  } else {
+    SDL_SetWindowFullscreen(window_, 0);
+  }
+}
+bool VulkanWindowManager::IsFullscreen() { return is_screen_fullscreen_; }
+void VulkanWindowManager::ToggleFullscreen() {
+  SetFullscreen(!is_screen_fullscreen_);
+}
+
+void VulkanWindowManager::SetVSyncEnabled(bool enable) {
+  if (enable != vsync_enabled_) {
+    swapchain_dirty_ = true;
+  }
+  vsync_enabled_ = enable;
+}
+bool VulkanWindowManager::IsVSyncEnabled() { return vsync_enabled_; }
+void VulkanWindowManager::EnableVSync() { SetVSyncEnabled(true); }
+void VulkanWindowManager::DisableVSync() { SetVSyncEnabled(false); }
+void VulkanWindowManager::ToggleVSync() { SetVSyncEnabled(!vsync_enabled_); }
+
+void VulkanWindowManager::Quit() {
+  SDL_Event sdlevent;
+  sdlevent.type = SDL_QUIT;
+  SDL_PushEvent(&sdlevent);
+}
+
+bool VulkanWindowManager::IsCursorDisabled() { return cursor_disabled_; }
+void VulkanWindowManager::DisableCursor(bool disabled) {
+  cursor_disabled_ = disabled;
+  if (cursor_disabled_) {
+    SDL_ShowCursor(SDL_DISABLE);
+    SDL_SetRelativeMouseMode(SDL_TRUE);
+  } else {
+    SDL_ShowCursor(SDL_ENABLE);
+    SDL_SetRelativeMouseMode(SDL_FALSE);
+  }
+}
+bool VulkanWindowManager::ToggleCursor() {
+  DisableCursor(!cursor_disabled_);
+  return cursor_disabled_;
+}
+
+void VulkanWindowManager::RedrawWindowBounds(glm::ivec2 size) {
+  viewport_ = size;
+}
+
+} /* namespace game_engine::vulkan */
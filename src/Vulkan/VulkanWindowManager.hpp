@@ -0,0 +1,100 @@
+/******************************************************************************
+ * VulkanWindowManager.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef SRC_VULKAN_VULKANWINDOWMANAGER_HPP_
+#define SRC_VULKAN_VULKANWINDOWMANAGER_HPP_
+
+#include <string>
+
+#include <SDL2/SDL.h>
+#include <glm/glm.hpp>
+
+#include "LoggerV2/Log.hpp"
+
+#include "WindowManager.hpp"
+
+namespace game_engine::vulkan {
+
+class VulkanWindowManager : public WindowManager<VulkanWindowManager> {
+ public:
+  void Init(std::string program_name);
+  SDL_Window* GetWindow();
+  void SetWindow(SDL_Window* p);
+
+  /**
+   * @brief Size of the window, or of the offscreen backbuffer when rendering
+   *        without one
+   */
+  static glm::ivec2 GetWindowSize();
+
+  void SetFullscreen(bool enable = false);
+  bool IsFullscreen();
+  void ToggleFullscreen();
+
+  /**
+   * @brief Choose between FIFO and a tearing present mode.  The swapchain is
+   *        recreated on the next Swap.
+   */
+  void SetVSyncEnabled(bool enable = false);
+  bool IsVSyncEnabled();
+  void EnableVSync();
+  void DisableVSync();
+  void ToggleVSync();
+
+  void Quit();
+  bool IsCursorDisabled();
+  void DisableCursor(bool disabled = true);
+  bool ToggleCursor();
+
+  /**
+   * @brief Set the viewport of the draws that follow, from the bottom left
+   *        corner like glViewport
+   */
+  void RedrawWindowBounds(glm::ivec2 size);
+
+ public:
+  static SDL_Window* window_;
+  /**
+   * @brief Size of the backbuffer when there is no window
+   */
+  static glm::ivec2 headless_size_;
+
+ protected:
+  bool cursor_disabled_ = false;
+  bool is_screen_fullscreen_ = false;
+  bool vsync_enabled_ = false;
+  /**
+   * @brief Set when the present mode changed and the swapchain is stale
+   */
+  mutable bool swapchain_dirty_ = false;
+  /**
+   * @brief Viewport of the following draws.  0x0 covers the whole target.
+   */
+  mutable glm::ivec2 viewport_{0, 0};
+
+  SDL_DisplayMode native_;
+  SDL_DisplayMode current_;
+
+ private:
+  logging::Log log_ = logging::Log("main");
+};
+
+} /* namespace game_engine::vulkan */
+
+#endif /* SRC_VULKAN_VULKANWINDOWMANAGER_HPP_ */
@@ -0,0 +1,17 @@
+#version 450
+
+layout(location = 0) in vec4 Color;
+layout(location = 1) in vec3 TexCoords;
+
+layout(location = 0) out vec4 FragColor;
+
+layout(set = 0, binding = 0) uniform samplerCube cube_map;
+
+layout(push_constant) uniform Constants {
+  mat4 mvp;
+  vec4 color;
+} constants;
+
+void main() {
+  FragColor = texture(cube_map, TexCoords) * Color * constants.color;
+}
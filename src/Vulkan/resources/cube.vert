@@ -0,0 +1,21 @@
+#version 450
+
+layout(location = 0) in vec3 position;
+layout(location = 3) in vec4 color;
+
+layout(location = 0) out vec4 Color;
+layout(location = 1) out vec3 TexCoords;
+
+layout(push_constant) uniform Constants {
+  mat4 mvp;
+  vec4 color;
+} constants;
+
+void main() {
+  gl_Position = constants.mvp * vec4(position, 1.0);
+  // Projections are built for GL's -1 to 1 depth range
+  gl_Position.z = (gl_Position.z + gl_Position.w) * 0.5;
+
+  TexCoords = position;
+  Color = color;
+}
@@ -0,0 +1,76 @@
+#version 450
+
+layout(location = 0) in vec4 Color;
+layout(location = 1) in vec2 Tex_coord0;
+layout(location = 2) in vec3 View_position;
+layout(location = 3) in vec3 View_normal;
+layout(location = 4) in vec3 Clip_position;
+
+layout(location = 0) out vec4 FragColor;
+
+layout(set = 0, binding = 0) uniform sampler2D texture_diffuse0;
+
+layout(push_constant) uniform Constants {
+  mat4 mvp;
+  vec4 color;
+  vec4 model_view[3];
+} constants;
+
+// Clustered lights, see LightClusterer
+struct Light {
+  vec4 position_range;
+  vec4 color_intensity;
+  vec4 direction_type;
+  vec4 cone;
+};
+layout(std430, set = 1, binding = 0) readonly buffer Lights {
+  Light lights[];
+};
+layout(std430, set = 1, binding = 1) readonly buffer Clusters {
+  uvec2 clusters[];
+};
+layout(std430, set = 1, binding = 2) readonly buffer LightIndices {
+  uint indices[];
+};
+// Lights are disabled while grid.w is 0
+layout(set = 1, binding = 3) uniform ClusterParameters {
+  ivec4 grid;
+  vec4 depth_scale_bias;
+  vec4 ambient_light;
+} cluster;
+
+vec3 ClusterLighting(vec3 position, vec3 normal) {
+  // Tiles count from the bottom left corner of the viewport, as in GL
+  vec2 screen = Clip_position.xy / Clip_position.z * 0.5 + 0.5;
+  ivec2 tile = clamp(ivec2(screen * vec2(cluster.grid.xy)), ivec2(0),
+                     cluster.grid.xy - 1);
+  int slice = int(floor(log(-position.z) * cluster.depth_scale_bias.x +
+                        cluster.depth_scale_bias.y));
+  slice = clamp(slice, 0, cluster.grid.z - 1);
+  uvec2 range =
+      clusters[(slice * cluster.grid.y + tile.y) * cluster.grid.x + tile.x];
+
+  vec3 total = cluster.ambient_light.rgb;
+  for (uint i = 0; i < range.y; i++) {
+    Light light = lights[indices[range.x + i]];
+    vec3 to_light = light.position_range.xyz - position;
+    float distance = length(to_light);
+    vec3 l = to_light / max(distance, 1e-4);
+    float falloff = clamp(1.0 - distance / light.position_range.w, 0.0, 1.0);
+    float attenuation = falloff * falloff;
+    if (light.direction_type.w > 0.5) {
+      float spot = dot(-l, light.direction_type.xyz);
+      attenuation *= clamp((spot - light.cone.x) * light.cone.y, 0.0, 1.0);
+    }
+    total += light.color_intensity.rgb * light.color_intensity.a *
+             attenuation * max(dot(normal, l), 0.0);
+  }
+  return total;
+}
+
+void main() {
+  FragColor = texture(texture_diffuse0, Tex_coord0) * Color * constants.color;
+  if (cluster.grid.w != 0) {
+    FragColor.rgb *= ClusterLighting(View_position, normalize(View_normal));
+  }
+}
@@ -0,0 +1,46 @@
+#version 450
+
+layout(location = 0) in vec3 position;
+layout(location = 2) in vec3 normal;
+layout(location = 3) in vec4 color;
+layout(location = 7) in vec2 tex_coord0;
+
+layout(location = 0) out vec4 Color;
+layout(location = 1) out vec2 Tex_coord0;
+layout(location = 2) out vec3 View_position;
+layout(location = 3) out vec3 View_normal;
+layout(location = 4) out vec3 Clip_position;
+
+layout(push_constant) uniform Constants {
+  mat4 mvp;
+  vec4 color;
+  // Rows of the top 3x4 of view * model
+  vec4 model_view[3];
+} constants;
+
+void main() {
+  vec4 object_position = vec4(position, 1.0);
+  gl_Position = constants.mvp * object_position;
+  Clip_position = gl_Position.xyw;
+  // Projections are built for GL's -1 to 1 depth range
+  gl_Position.z = (gl_Position.z + gl_Position.w) * 0.5;
+  gl_PointSize = 1.0;
+
+  vec4 r0 = constants.model_view[0];
+  vec4 r1 = constants.model_view[1];
+  vec4 r2 = constants.model_view[2];
+  View_position = vec3(dot(r0, object_position), dot(r1, object_position),
+                       dot(r2, object_position));
+  // The rows of the inverse transpose are the cross products of the rows,
+  // divided by the determinant, of which only the sign survives normalize
+  vec3 a = r0.xyz;
+  vec3 b = r1.xyz;
+  vec3 c = r2.xyz;
+  float handedness = dot(a, cross(b, c)) < 0.0 ? -1.0 : 1.0;
+  View_normal = handedness * vec3(dot(cross(b, c), normal),
+                                  dot(cross(c, a), normal),
+                                  dot(cross(a, b), normal));
+
+  Color = color;
+  Tex_coord0 = tex_coord0;
+}
@@ -0,0 +1,10 @@
+#version 450
+
+layout(location = 0) in vec3 Tex_coord;
+layout(location = 1) in vec4 Color;
+
+layout(location = 0) out vec4 FragColor;
+
+layout(set = 0, binding = 0) uniform sampler2DArray sprite_texture;
+
+void main() { FragColor = texture(sprite_texture, Tex_coord) * Color; }
@@ -0,0 +1,18 @@
+#version 450
+
+layout(location = 0) in vec3 Tex_coord;
+layout(location = 1) in vec4 Color;
+
+layout(location = 0) out vec4 FragColor;
+
+// Glyph signed distance fields in the red channel, 0.5 on the edge, drawn
+// with sprite.vert
+layout(set = 0, binding = 0) uniform sampler2DArray sprite_texture;
+
+void main() {
+  float distance = texture(sprite_texture, Tex_coord).r;
+  // Antialias over about one screen pixel, whatever the scale
+  float width = 0.7 * length(vec2(dFdx(distance), dFdy(distance)));
+  float coverage = smoothstep(0.5 - width, 0.5 + width, distance);
+  FragColor = vec4(Color.rgb, Color.a * coverage);
+}
@@ -0,0 +1,42 @@
+#version 450
+
+layout(location = 0) in vec2 Tex_coord;
+
+layout(location = 0) out vec4 FragColor;
+
+layout(set = 0, binding = 0) uniform sampler2D source;
+
+// The parameters travel in the color: the fraction of the source covered by
+// the scaled scene in xy, whether to sharpen in z and the sharpness in w
+layout(push_constant) uniform Constants {
+  mat4 mvp;
+  vec4 parameters;
+} constants;
+
+// Render targets are stored top row first, unlike in GL
+vec4 Source(vec2 uv) { return texture(source, vec2(uv.x, 1.0 - uv.y)); }
+
+void main() {
+  vec2 uv_scale = constants.parameters.xy;
+  vec2 texel = 1.0 / vec2(textureSize(source, 0));
+  // Keep bilinear taps inside the rendered part of the source
+  vec2 lo = 0.5 * texel;
+  vec2 hi = uv_scale - 0.5 * texel;
+  vec2 uv = clamp(Tex_coord * uv_scale, lo, hi);
+  vec4 center = Source(uv);
+  FragColor = center;
+
+  if (constants.parameters.z > 0.5) {
+    vec3 n = Source(clamp(uv + vec2(0.0, texel.y), lo, hi)).rgb;
+    vec3 s = Source(clamp(uv - vec2(0.0, texel.y), lo, hi)).rgb;
+    vec3 e = Source(clamp(uv + vec2(texel.x, 0.0), lo, hi)).rgb;
+    vec3 w = Source(clamp(uv - vec2(texel.x, 0.0), lo, hi)).rgb;
+    vec3 blur = (n + s + e + w) * 0.25;
+    // Clamp to the neighbourhood so edges do not ring
+    vec3 low = min(center.rgb, min(min(n, s), min(e, w)));
+    vec3 high = max(center.rgb, max(max(n, s), max(e, w)));
+    FragColor.rgb = clamp(
+        center.rgb + (center.rgb - blur) * 2.0 * constants.parameters.w, low,
+        high);
+  }
+}
@@ -0,0 +1,10 @@
+#version 450
+
+layout(location = 0) out vec2 Tex_coord;
+
+void main() {
+  // A triangle covering the screen, with no vertex buffer
+  vec2 corner = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+  Tex_coord = corner;
+  gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,125 @@
+/******************************************************************************
+ * BakedFont_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "2D/BakedFont.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using game_engine::_2D::BakedFont;
+using game_engine::_2D::BakedFontHeader;
+using game_engine::_2D::BakedGlyph;
+using game_engine::_2D::BakedKerning;
+
+namespace {
+
+std::string WriteFont() {
+  BakedFontHeader header;
+  header.pixel_size = 48;
+  header.page_width = 4;
+  header.page_height = 4;
+  header.cell_size = 2;
+  header.page_count = 2;
+  header.baked_page_count = 1;
+  header.baked_height = 2;
+  std::vector<BakedGlyph> glyphs(3);
+  glyphs[0].code_point = U'b';
+  glyphs[0].slot = 1;
+  glyphs[0].advance = 20.0f;
+  glyphs[1].code_point = U'a';
+  glyphs[1].slot = 0;
+  glyphs[1].advance = 10.0f;
+  glyphs[2].code_point = U' ';
+  glyphs[2].advance = 5.0f;
+  const std::vector<BakedKerning> kerning{{U'b', U'a', -1.5f},
+                                          {U'a', U'b', -2.0f}};
+  const std::vector<std::uint8_t> pixels{0, 1, 2, 3, 4, 5, 6, 7};
+  return BakedFont::Write(header, glyphs, kerning, pixels.data());
+}
+
+}  // namespace
+
+TEST(BakedFont, RoundTrips) {
+  const std::string data = WriteFont();
+  const auto font = BakedFont::Open(data);
+  ASSERT_TRUE(font);
+  EXPECT_EQ(font->GetHeader().pixel_size, 48u);
+  ASSERT_EQ(font->GetGlyphCount(), 3u);
+  // Sorted by code point
+  EXPECT_EQ(font->GetGlyph(0).code_point, static_cast<std::uint32_t>(U' '));
+
+  const auto b = font->FindGlyph(U'b');
+  ASSERT_TRUE(b);
+  EXPECT_EQ(b->slot, 1);
+  EXPECT_FLOAT_EQ(b->advance, 20.0f);
+  EXPECT_FALSE(font->FindGlyph(U'c'));
+
+  EXPECT_FLOAT_EQ(font->GetKerning(U'a', U'b'), -2.0f);
+  EXPECT_FLOAT_EQ(font->GetKerning(U'b', U'a'), -1.5f);
+  EXPECT_FLOAT_EQ(font->GetKerning(U'a', U'a'), 0.0f);
+
+  EXPECT_EQ(font->GetPixels()[5], 5);
+  // The view points into the data rather than copying it
+  EXPECT_EQ(reinterpret_cast<const char*>(font->GetPixels()),
+            data.data() + data.size() - 8);
+}
+
+TEST(BakedFont, RejectsInvalidData) {
+  const std::string data = WriteFont();
+  EXPECT_FALSE(BakedFont::Open(""));
+  EXPECT_FALSE(BakedFont::Open(std::string_view(data).substr(1)));
+  EXPECT_FALSE(
+      BakedFont::Open(std::string_view(data.data(), data.size() - 1)));
+
+  std::string corrupt = data;
+  corrupt[0] = 'X';
+  EXPECT_FALSE(BakedFont::Open(corrupt));
+}
+
+TEST(BakedFont, MipLevels) {
+  BakedFontHeader header;
+  header.page_width = 4;
+  header.page_height = 4;
+  header.cell_size = 2;
+  header.mip_levels = 2;
+  header.page_count = 2;
+  header.baked_page_count = 2;
+  header.baked_height = 2;
+  // 4x4 and 4x2 layers of level 0, then 2x2 and 2x1 layers of level 1
+  std::vector<std::uint8_t> pixels(16 + 8 + 4 + 2);
+  for (std::size_t i = 0; i < pixels.size(); i++) {
+    pixels[i] = static_cast<std::uint8_t>(i);
+  }
+  const std::string data = BakedFont::Write(header, {}, {}, pixels.data());
+  const auto font = BakedFont::Open(data);
+  ASSERT_TRUE(font);
+  EXPECT_EQ(font->GetPixelBytes(), pixels.size());
+  EXPECT_EQ(font->GetPageBytes(1), 4u);
+  EXPECT_EQ(font->GetPixels(1)[0], 24);
+  EXPECT_EQ(font->GetPixels(1)[font->GetPageBytes(1)], 28);
+
+  // The baked rows do not halve evenly
+  header.baked_height = 3;
+  pixels.resize(16 + 12 + 4 + 2);
+  EXPECT_FALSE(BakedFont::Open(
+      BakedFont::Write(header, {}, {}, pixels.data())));
+}
@@ -0,0 +1,98 @@
+/******************************************************************************
+ * GlyphAtlas_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "2D/GlyphAtlas.hpp"
+
+#include <glm/glm.hpp>
+
+#include "gtest/gtest.h"
+
+using game_engine::_2D::GlyphAtlas;
+
+TEST(GlyphAtlas, PlacesCellsOnPages) {
+  GlyphAtlas atlas(glm::ivec2(64, 64), 32, 2);
+  ASSERT_EQ(atlas.GetSlotCount(), 8);
+
+  const auto a = atlas.Allocate(U'a');
+  ASSERT_TRUE(a);
+  EXPECT_EQ(a->slot, 0);
+  EXPECT_FALSE(a->evicted);
+  EXPECT_EQ(atlas.Find(U'a'), 0);
+  EXPECT_FALSE(atlas.Find(U'b'));
+  // Allocating a resident glyph returns its cell
+  EXPECT_EQ(atlas.Allocate(U'a')->slot, 0);
+  EXPECT_EQ(atlas.GetResidentCount(), 1u);
+
+  const auto region = atlas.GetRegion(5, glm::ivec2(16, 8));
+  EXPECT_EQ(region.layer, 1);
+  EXPECT_EQ(region.position, glm::ivec2(32, 0));
+  EXPECT_FLOAT_EQ(region.uv_min.x, 0.5f);
+  EXPECT_FLOAT_EQ(region.uv_max.x, 0.75f);
+  EXPECT_FLOAT_EQ(region.uv_max.y, 0.125f);
+}
+
+TEST(GlyphAtlas, EvictsLeastRecentlyUsed) {
+  GlyphAtlas atlas(glm::ivec2(64, 32), 32, 1);
+  ASSERT_EQ(atlas.GetSlotCount(), 2);
+  const int pinned = atlas.Allocate(U'?', true)->slot;
+  const int first = atlas.Allocate(U'一')->slot;
+
+  // Full, and everything was used this frame
+  EXPECT_FALSE(atlas.Allocate(U'丁'));
+
+  atlas.NextFrame();
+  const auto second = atlas.Allocate(U'丁');
+  ASSERT_TRUE(second);
+  EXPECT_EQ(second->slot, first);
+  EXPECT_EQ(second->evicted, U'一');
+  EXPECT_FALSE(atlas.Find(U'一'));
+  EXPECT_EQ(atlas.Find(U'?'), pinned);
+  EXPECT_EQ(atlas.GetEvictionCount(), 1u);
+
+  // Touching keeps a glyph resident for the frame
+  atlas.NextFrame();
+  atlas.Touch(second->slot);
+  EXPECT_FALSE(atlas.Allocate(U'丂'));
+
+  atlas.Clear();
+  EXPECT_EQ(atlas.GetResidentCount(), 0u);
+  EXPECT_TRUE(atlas.Allocate(U'丂'));
+}
+
+TEST(GlyphAtlas, PlacesInGivenCells) {
+  GlyphAtlas atlas(glm::ivec2(64, 32), 32, 1);
+  EXPECT_TRUE(atlas.Place(U'a', 1, true));
+  EXPECT_FALSE(atlas.Place(U'b', 1));
+  EXPECT_FALSE(atlas.Place(U'a', 0));
+  EXPECT_FALSE(atlas.Place(U'c', 2));
+  EXPECT_EQ(atlas.Find(U'a'), 1);
+
+  // Allocation skips the placed cell, and never evicts it
+  EXPECT_EQ(atlas.Allocate(U'b')->slot, 0);
+  atlas.NextFrame();
+  EXPECT_EQ(atlas.Allocate(U'c')->evicted, U'b');
+}
+
+TEST(GlyphAtlas, MipLevelsStayCellAligned) {
+  // 48, 24, 12, 6 and 3 texel cells
+  EXPECT_EQ(GlyphAtlas(glm::ivec2(1024, 1024), 48, 1).GetMipLevels(), 5);
+  EXPECT_EQ(GlyphAtlas(glm::ivec2(64, 64), 33, 1).GetMipLevels(), 1);
+  // Never past the 1x1 level of the page
+  EXPECT_EQ(GlyphAtlas(glm::ivec2(64, 64), 64, 1).GetMipLevels(), 7);
+}
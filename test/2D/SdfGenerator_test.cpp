@@ -0,0 +1,110 @@
+/******************************************************************************
+ * SdfGenerator_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "2D/SdfGenerator.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gtest/gtest.h"
+
+using game_engine::_2D::SdfBitmap;
+using game_engine::_2D::SdfGenerator;
+using game_engine::_2D::SdfOptions;
+
+namespace {
+
+/**
+ * @brief A size x size image with a filled square from begin to end
+ */
+std::vector<std::uint8_t> Square(const int size, const int begin,
+                                 const int end) {
+  std::vector<std::uint8_t> pixels(size * size, 0);
+  for (int y = begin; y < end; y++) {
+    for (int x = begin; x < end; x++) {
+      pixels[y * size + x] = 255;
+    }
+  }
+  return pixels;
+}
+
+int At(const SdfBitmap& sdf, const int x, const int y) {
+  return sdf.pixels[y * sdf.size.x + x];
+}
+
+}  // namespace
+
+TEST(SdfGenerator, SignedDistances) {
+  SdfOptions options;
+  options.spread = 4;
+  options.supersample = 1;
+  const std::vector<std::uint8_t> image = Square(16, 4, 12);
+  const SdfBitmap sdf = SdfGenerator::Generate(glm::ivec2(16, 16),
+                                               image.data(), 0, options);
+  ASSERT_EQ(sdf.size, glm::ivec2(24, 24));
+  ASSERT_EQ(sdf.pixels.size(), 24u * 24u);
+
+  // The square spans texels 8 to 15 once padded.  The edge sits halfway
+  // between texels 7 and 8, at 0.5.
+  const int row = 12;
+  EXPECT_NEAR(At(sdf, 7, row), 128 - 16, 1);
+  EXPECT_NEAR(At(sdf, 8, row), 128 + 16, 1);
+  EXPECT_EQ(At(sdf, 0, row), 0);
+  EXPECT_NEAR(At(sdf, 11, row), 128 + 16 * 7, 1);
+  // Increasing towards the center, decreasing away from it
+  for (int x = 1; x <= 11; x++) {
+    EXPECT_GE(At(sdf, x, row), At(sdf, x - 1, row)) << x;
+  }
+  // Symmetric
+  for (int x = 0; x < 24; x++) {
+    EXPECT_EQ(At(sdf, x, row), At(sdf, 23 - x, row)) << x;
+    EXPECT_EQ(At(sdf, x, row), At(sdf, row, x)) << x;
+  }
+  // Diagonal distance beyond a corner is Euclidean
+  const float corner = std::sqrt(2.0f * 2.0f + 2.0f * 2.0f) - 0.5f;
+  EXPECT_NEAR(At(sdf, 6, 6), (0.5f - corner / 8.0f) * 255.0f, 1.0f);
+}
+
+TEST(SdfGenerator, Supersamples) {
+  SdfOptions options;
+  options.spread = 2;
+  options.supersample = 4;
+  const std::vector<std::uint8_t> image = Square(30, 8, 24);
+  const SdfBitmap sdf = SdfGenerator::Generate(glm::ivec2(30, 30),
+                                               image.data(), 30, options);
+  // ceil(30 / 4) + 2 * 2
+  ASSERT_EQ(sdf.size, glm::ivec2(12, 12));
+  // The square covers output texels 4 to 7 after the padding of 2
+  EXPECT_GT(At(sdf, 5, 5), 128);
+  EXPECT_GT(At(sdf, 6, 6), 128);
+  EXPECT_LT(At(sdf, 3, 5), 128);
+  EXPECT_EQ(At(sdf, 0, 0), 0);
+}
+
+TEST(SdfGenerator, EmptyShape) {
+  const std::vector<std::uint8_t> image(8 * 8, 0);
+  const SdfBitmap sdf =
+      SdfGenerator::Generate(glm::ivec2(8, 8), image.data(), 0, SdfOptions{});
+  for (const std::uint8_t value : sdf.pixels) {
+    ASSERT_EQ(value, 0);
+  }
+}
@@ -0,0 +1,147 @@
+/******************************************************************************
+ * SpriteBatch_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "2D/SpriteBatch.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gtest/gtest.h"
+
+using game_engine::_2D::Sprite;
+using game_engine::_2D::SpriteBatch;
+using game_engine::_2D::SpriteDraw;
+using game_engine::_2D::SpriteInstance;
+
+namespace {
+
+Sprite MakeSprite(const float x, const int layer, const unsigned int texture) {
+  Sprite sprite;
+  sprite.position = glm::vec2(x, 0.0f);
+  sprite.layer = layer;
+  sprite.texture = texture;
+  return sprite;
+}
+
+}  // namespace
+
+TEST(SpriteBatch, SortsByLayerThenTexture) {
+  SpriteBatch batch;
+  batch.Begin();
+  batch.Draw(MakeSprite(0.0f, 1, 7));
+  batch.Draw(MakeSprite(1.0f, -2, 9));
+  batch.Draw(MakeSprite(2.0f, 1, 3));
+  batch.Draw(MakeSprite(3.0f, 0, 9));
+  batch.Draw(MakeSprite(4.0f, -2, 9));
+  batch.End();
+
+  const std::vector<SpriteInstance>& instances = batch.GetInstances();
+  ASSERT_EQ(instances.size(), 5u);
+  // Submission order is kept between sprites with the same layer and texture
+  const std::vector<float> expected = {1.0f, 4.0f, 3.0f, 2.0f, 0.0f};
+  for (std::size_t i = 0; i < expected.size(); i++) {
+    EXPECT_FLOAT_EQ(instances[i].position_size.x, expected[i]) << i;
+  }
+
+  const std::vector<SpriteDraw>& draws = batch.GetDraws();
+  ASSERT_EQ(draws.size(), 3u);
+  EXPECT_EQ(draws[0].texture, 9u);
+  EXPECT_EQ(draws[0].first, 0u);
+  EXPECT_EQ(draws[0].count, 3u);
+  EXPECT_EQ(draws[1].texture, 3u);
+  EXPECT_EQ(draws[1].count, 1u);
+  EXPECT_EQ(draws[2].texture, 7u);
+  EXPECT_EQ(draws[2].first, 4u);
+}
+
+TEST(SpriteBatch, SharedAtlasIsOneDraw) {
+  SpriteBatch batch;
+  batch.Reserve(100000);
+  batch.Begin();
+  for (int i = 0; i < 100000; i++) {
+    Sprite sprite = MakeSprite(static_cast<float>(i), i % 4, 1);
+    sprite.texture_layer = i % 3;
+    batch.Draw(sprite);
+  }
+  batch.End();
+  ASSERT_EQ(batch.GetDraws().size(), 1u);
+  EXPECT_EQ(batch.GetDraws()[0].count, 100000u);
+
+  const std::vector<SpriteInstance>& instances = batch.GetInstances();
+  for (std::size_t i = 1; i < instances.size(); i++) {
+    const int previous = static_cast<int>(instances[i - 1].position_size.x);
+    const int current = static_cast<int>(instances[i].position_size.x);
+    ASSERT_TRUE(previous % 4 < current % 4 ||
+                (previous % 4 == current % 4 && previous < current))
+        << i;
+  }
+
+  // A new frame starts empty
+  batch.Begin();
+  batch.End();
+  EXPECT_EQ(batch.GetSpriteCount(), 0u);
+  EXPECT_TRUE(batch.GetDraws().empty());
+}
+
+TEST(SpriteBatch, PacksInstances) {
+  EXPECT_EQ(SpriteBatch::PackColor(glm::vec4(1.0f, 0.0f, 0.5f, 2.0f)),
+            0xFF8000FFu);
+
+  game_engine::_3D::TextureRegion region;
+  region.layer = 2;
+  region.uv_min = glm::vec2(0.25f, 0.5f);
+  region.uv_max = glm::vec2(0.5f, 0.75f);
+  Sprite sprite;
+  sprite.SetRegion(region);
+  sprite.rotation = 1.5f;
+
+  SpriteBatch batch;
+  batch.Begin();
+  batch.Draw(sprite);
+  batch.End();
+  const SpriteInstance& instance = batch.GetInstances().front();
+  EXPECT_EQ(instance.texture_layer, 2u);
+  EXPECT_FLOAT_EQ(instance.uv_rect.y, 0.5f);
+  EXPECT_FLOAT_EQ(instance.uv_rect.z, 0.5f);
+  EXPECT_FLOAT_EQ(instance.rotation, 1.5f);
+  EXPECT_EQ(instance.color, 0xFFFFFFFFu);
+}
+
+TEST(SpriteBatch, AppendsPrebuiltInstances) {
+  SpriteInstance glyph;
+  glyph.position_size = glm::vec4(1.0f, 2.0f, 3.0f, 4.0f);
+  const std::vector<SpriteInstance> layout(3, glyph);
+
+  SpriteBatch batch;
+  batch.Begin();
+  batch.Draw(MakeSprite(0.0f, 1, 5));
+  batch.Draw(layout, glm::vec2(10.0f, 20.0f), 0x12345678u, 0, 5);
+  batch.End();
+
+  ASSERT_EQ(batch.GetSpriteCount(), 4u);
+  const SpriteInstance& first = batch.GetInstances().front();
+  EXPECT_FLOAT_EQ(first.position_size.x, 11.0f);
+  EXPECT_FLOAT_EQ(first.position_size.y, 22.0f);
+  EXPECT_FLOAT_EQ(first.position_size.z, 3.0f);
+  EXPECT_EQ(first.color, 0x12345678u);
+  ASSERT_EQ(batch.GetDraws().size(), 1u);
+  EXPECT_EQ(batch.GetDraws()[0].count, 4u);
+}
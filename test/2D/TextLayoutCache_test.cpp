@@ -0,0 +1,92 @@
+/******************************************************************************
+ * TextLayoutCache_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "2D/TextLayoutCache.hpp"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+using game_engine::_2D::TextLayout;
+using game_engine::_2D::TextLayoutCache;
+
+namespace {
+
+TextLayout MakeLayout(const float advance) {
+  TextLayout layout;
+  layout.glyphs.resize(2);
+  layout.advance = advance;
+  return layout;
+}
+
+}  // namespace
+
+TEST(TextLayoutCache, FindsByTextFontAndScale) {
+  TextLayoutCache cache;
+  EXPECT_EQ(cache.Find("60 FPS", 1, 1.0f), nullptr);
+  cache.Insert("60 FPS", 1, 1.0f, MakeLayout(10.0f));
+
+  const TextLayout* layout = cache.Find("60 FPS", 1, 1.0f);
+  ASSERT_NE(layout, nullptr);
+  EXPECT_FLOAT_EQ(layout->advance, 10.0f);
+  EXPECT_EQ(layout->glyphs.size(), 2u);
+
+  EXPECT_EQ(cache.Find("59 FPS", 1, 1.0f), nullptr);
+  EXPECT_EQ(cache.Find("60 FPS", 2, 1.0f), nullptr);
+  EXPECT_EQ(cache.Find("60 FPS", 1, 0.5f), nullptr);
+  EXPECT_EQ(cache.GetHits(), 1u);
+  EXPECT_EQ(cache.GetMisses(), 4u);
+}
+
+TEST(TextLayoutCache, EvictsLeastRecentlyUsed) {
+  TextLayoutCache cache(2);
+  cache.Insert("a", 0, 1.0f, MakeLayout(1.0f));
+  cache.Insert("b", 0, 1.0f, MakeLayout(2.0f));
+  // Using "a" makes "b" the least recently used
+  ASSERT_NE(cache.Find("a", 0, 1.0f), nullptr);
+  cache.Insert("c", 0, 1.0f, MakeLayout(3.0f));
+
+  EXPECT_EQ(cache.GetSize(), 2u);
+  EXPECT_NE(cache.Find("a", 0, 1.0f), nullptr);
+  EXPECT_EQ(cache.Find("b", 0, 1.0f), nullptr);
+  EXPECT_NE(cache.Find("c", 0, 1.0f), nullptr);
+
+  // Inserting an existing key replaces it without growing
+  cache.Insert("c", 0, 1.0f, MakeLayout(4.0f));
+  EXPECT_EQ(cache.GetSize(), 2u);
+  EXPECT_FLOAT_EQ(cache.Find("c", 0, 1.0f)->advance, 4.0f);
+}
+
+TEST(TextLayoutCache, DropsIdleLayouts) {
+  TextLayoutCache cache(16, 2);
+  cache.Insert("static", 0, 1.0f, MakeLayout(1.0f));
+  for (int frame = 0; frame < 10; frame++) {
+    cache.Insert(std::to_string(frame), 0, 1.0f, MakeLayout(1.0f));
+    ASSERT_NE(cache.Find("static", 0, 1.0f), nullptr);
+    cache.NextFrame();
+  }
+  // Only the text used in the last two frames remains
+  EXPECT_EQ(cache.GetSize(), 3u);
+  EXPECT_NE(cache.Find("static", 0, 1.0f), nullptr);
+  EXPECT_EQ(cache.Find("0", 0, 1.0f), nullptr);
+  EXPECT_NE(cache.Find("9", 0, 1.0f), nullptr);
+
+  cache.Clear();
+  EXPECT_EQ(cache.GetSize(), 0u);
+}
@@ -0,0 +1,186 @@
+/******************************************************************************
+ * AabbTree_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/AabbTree.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "3D/BoundingVolume.hpp"
+#include "3D/Frustum.hpp"
+#include "gtest/gtest.h"
+
+using game_engine::_3D::Aabb;
+using game_engine::_3D::AabbTree;
+using game_engine::_3D::AabbTreeOptions;
+using game_engine::_3D::BoundingSphere;
+using game_engine::_3D::Frustum;
+using game_engine::_3D::Ray;
+
+namespace {
+
+Aabb RandomBox(std::mt19937* rng) {
+  std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+  std::uniform_real_distribution<float> size(0.1f, 3.0f);
+  Aabb box;
+  box.min = glm::vec3(position(*rng), position(*rng), position(*rng));
+  box.max = box.min + glm::vec3(size(*rng), size(*rng), size(*rng));
+  return box;
+}
+
+template <typename Volume>
+std::vector<std::uint32_t> QuerySorted(const AabbTree& tree,
+                                       const Volume& volume) {
+  std::vector<std::uint32_t> result;
+  tree.Query(volume, [&](const AabbTree::ProxyId proxy) {
+    result.push_back(tree.GetUserData(proxy));
+    return true;
+  });
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+}  // namespace
+
+TEST(AabbTree, CreateMoveDestroy) {
+  std::mt19937 rng(1234);
+  AabbTree tree(AabbTreeOptions{0.0f, 0.0f});
+  std::vector<Aabb> boxes;
+  std::vector<AabbTree::ProxyId> proxies;
+  for (std::uint32_t i = 0; i < 2000; i++) {
+    boxes.push_back(RandomBox(&rng));
+    proxies.push_back(tree.CreateProxy(boxes.back(), i));
+  }
+  ASSERT_TRUE(tree.Validate());
+  EXPECT_EQ(tree.GetProxyCount(), boxes.size());
+  // A balanced tree of 2000 leaves is far shallower than a list
+  EXPECT_LT(tree.GetHeight(), 30);
+
+  for (std::uint32_t i = 0; i < boxes.size(); i += 3) {
+    const Aabb old_box = boxes[i];
+    boxes[i] = RandomBox(&rng);
+    tree.MoveProxy(proxies[i], boxes[i], boxes[i].Center() - old_box.Center());
+  }
+  for (std::uint32_t i = 1; i < boxes.size(); i += 7) {
+    tree.DestroyProxy(proxies[i]);
+    boxes[i] = Aabb{};
+  }
+  ASSERT_TRUE(tree.Validate());
+
+  // Queries match a brute force scan
+  for (int q = 0; q < 50; q++) {
+    Aabb query = RandomBox(&rng);
+    query.max += glm::vec3(20.0f);
+    std::vector<std::uint32_t> expected;
+    for (std::uint32_t i = 0; i < boxes.size(); i++) {
+      if (!boxes[i].IsEmpty() && boxes[i].Overlaps(query)) {
+        expected.push_back(i);
+      }
+    }
+    ASSERT_EQ(QuerySorted(tree, query), expected);
+
+    const BoundingSphere sphere{query.Center(), 15.0f};
+    expected.clear();
+    for (std::uint32_t i = 0; i < boxes.size(); i++) {
+      if (!boxes[i].IsEmpty() && sphere.Overlaps(boxes[i])) {
+        expected.push_back(i);
+      }
+    }
+    ASSERT_EQ(QuerySorted(tree, sphere), expected);
+  }
+
+  const Frustum frustum(
+      glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f),
+                  glm::vec3(0.0f, 1.0f, 0.0f)),
+      glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 80.0f));
+  std::vector<std::uint32_t> expected;
+  for (std::uint32_t i = 0; i < boxes.size(); i++) {
+    if (!boxes[i].IsEmpty() && frustum.Intersects(boxes[i])) {
+      expected.push_back(i);
+    }
+  }
+  EXPECT_FALSE(expected.empty());
+  EXPECT_EQ(QuerySorted(tree, frustum), expected);
+}
+
+TEST(AabbTree, MoveWithinFatBox) {
+  AabbTree tree(AabbTreeOptions{1.0f, 0.0f});
+  Aabb box;
+  box.min = glm::vec3(0.0f);
+  box.max = glm::vec3(1.0f);
+  const auto proxy = tree.CreateProxy(box, 7);
+  box.min += glm::vec3(0.5f);
+  box.max += glm::vec3(0.5f);
+  EXPECT_FALSE(tree.MoveProxy(proxy, box));
+  box.min += glm::vec3(5.0f);
+  box.max += glm::vec3(5.0f);
+  EXPECT_TRUE(tree.MoveProxy(proxy, box));
+  EXPECT_TRUE(tree.GetFatAabb(proxy).Contains(box));
+  EXPECT_EQ(tree.GetUserData(proxy), 7u);
+}
+
+TEST(AabbTree, RayCastAndNearest) {
+  AabbTree tree(AabbTreeOptions{0.0f, 0.0f});
+  for (std::uint32_t i = 0; i < 100; i++) {
+    Aabb box;
+    box.min = glm::vec3(static_cast<float>(i) * 4.0f, -1.0f, -1.0f);
+    box.max = box.min + glm::vec3(2.0f);
+    tree.CreateProxy(box, i);
+  }
+  ASSERT_TRUE(tree.Validate());
+
+  // A ray along +x reports the closest box first when clipping to each hit
+  Ray ray;
+  ray.origin = glm::vec3(-10.0f, 0.0f, 0.0f);
+  ray.direction = glm::vec3(1.0f, 0.0f, 0.0f);
+  std::int64_t closest = -1;
+  float closest_distance = ray.max_distance;
+  tree.RayCast(ray, [&](const AabbTree::ProxyId proxy, const Ray& clipped) {
+    float distance = 0.0f;
+    const glm::vec3 inverse = 1.0f / clipped.direction;
+    if (clipped.Intersects(tree.GetFatAabb(proxy), inverse, &distance) &&
+        distance < closest_distance) {
+      closest = tree.GetUserData(proxy);
+      closest_distance = distance;
+    }
+    return closest_distance;
+  });
+  EXPECT_EQ(closest, 0);
+  EXPECT_FLOAT_EQ(closest_distance, 10.0f);
+
+  // Missing every box
+  ray.origin = glm::vec3(0.0f, 10.0f, 0.0f);
+  bool hit = false;
+  tree.RayCast(ray, [&](const AabbTree::ProxyId, const Ray& clipped) {
+    hit = true;
+    return clipped.max_distance;
+  });
+  EXPECT_FALSE(hit);
+
+  const auto nearest = tree.Nearest(glm::vec3(201.0f, 0.0f, 5.0f), 100.0f);
+  ASSERT_TRUE(nearest);
+  EXPECT_EQ(tree.GetUserData(*nearest), 50u);
+  EXPECT_FALSE(tree.Nearest(glm::vec3(0.0f, 500.0f, 0.0f), 10.0f));
+}
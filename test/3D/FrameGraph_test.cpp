@@ -0,0 +1,251 @@
+/******************************************************************************
+ * FrameGraph_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/FrameGraph.hpp"
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gtest/gtest.h"
+
+using game_engine::_3D::FrameBarrier;
+using game_engine::_3D::TransientBufferDesc;
+using game_engine::_3D::FrameGraph;
+using game_engine::_3D::FrameGraphBuilder;
+using game_engine::_3D::FrameGraphResources;
+using game_engine::_3D::FramePassTargets;
+using game_engine::_3D::FrameResourceId;
+using game_engine::_3D::FrameResourceUsage;
+using game_engine::_3D::RenderTargetDesc;
+using game_engine::_3D::TransientTextureDesc;
+
+namespace {
+
+/**
+ * @brief Records what the frame graph asks of it
+ */
+struct FakeBackend {
+  unsigned int CreateTransientTexture(const TransientTextureDesc&) {
+    created++;
+    return next_id++;
+  }
+  void DestroyTransientTexture(unsigned int) { destroyed++; }
+  unsigned int CreateTransientBuffer(const TransientBufferDesc&) {
+    created++;
+    return next_id++;
+  }
+  void DestroyTransientBuffer(unsigned int) { destroyed++; }
+  void BindFrameTargets(const FramePassTargets& targets) {
+    bound.push_back(targets);
+  }
+  unsigned int GetRenderTargetTexture(unsigned int target) {
+    return target + 1000;
+  }
+  void ResolveRenderTarget(unsigned int target) { resolved.push_back(target); }
+  void InsertFrameBarrier(const FrameBarrier& barrier) {
+    barriers.push_back(barrier);
+  }
+  void BeginPassTimer(const std::string&) {}
+  void EndPassTimer(const std::string&) {}
+  double GetPassGpuTime(const std::string&) { return -1.0; }
+
+  unsigned int next_id = 1;
+  int created = 0;
+  int destroyed = 0;
+  std::vector<FramePassTargets> bound{};
+  std::vector<FrameBarrier> barriers{};
+  std::vector<unsigned int> resolved{};
+};
+
+const TransientTextureDesc kColorDesc{glm::ivec2(64, 64), {0x8058, 0x1908}};
+
+/**
+ * @brief Scene -> blur -> composite into the backbuffer, plus a debug pass
+ *        nothing reads
+ */
+void BuildFrame(FrameGraph* graph, std::vector<std::string>* executed) {
+  const FrameResourceId backbuffer =
+      graph->ImportBackbuffer("Backbuffer", glm::ivec2(64, 64));
+  FrameResourceId scene = game_engine::_3D::kNullFrameResource;
+  FrameResourceId blur = game_engine::_3D::kNullFrameResource;
+  const auto record = [executed](const std::string& name) {
+    return [executed, name](const FrameGraphResources&) {
+      executed->push_back(name);
+    };
+  };
+
+  graph->AddPass(
+      "Scene",
+      [&](FrameGraphBuilder& builder) {
+        scene = builder.CreateTexture("Scene color", kColorDesc);
+        builder.Write(scene, FrameResourceUsage::COLOR_ATTACHMENT);
+        builder.SetClear(glm::vec4(0.0f));
+      },
+      record("Scene"));
+  graph->AddPass(
+      "Debug",
+      [&](FrameGraphBuilder& builder) {
+        const FrameResourceId debug =
+            builder.CreateTexture("Debug", kColorDesc);
+        builder.Read(scene, FrameResourceUsage::SAMPLED);
+        builder.Write(debug, FrameResourceUsage::COLOR_ATTACHMENT);
+      },
+      record("Debug"));
+  graph->AddPass(
+      "Blur",
+      [&](FrameGraphBuilder& builder) {
+        blur = builder.CreateTexture("Blur", kColorDesc);
+        builder.Read(scene, FrameResourceUsage::SAMPLED);
+        builder.Write(blur, FrameResourceUsage::STORAGE);
+      },
+      record("Blur"));
+  graph->AddPass(
+      "Tonemap",
+      [&](FrameGraphBuilder& builder) {
+        // Same description as Scene color, which is dead by now
+        const FrameResourceId tonemapped =
+            builder.CreateTexture("Tonemapped", kColorDesc);
+        builder.Read(blur, FrameResourceUsage::SAMPLED);
+        builder.Write(tonemapped, FrameResourceUsage::COLOR_ATTACHMENT);
+        graph->MarkOutput(tonemapped);
+      },
+      record("Tonemap"));
+  graph->AddPass(
+      "Composite",
+      [&](FrameGraphBuilder& builder) {
+        builder.Read(blur, FrameResourceUsage::SAMPLED);
+        builder.Write(backbuffer, FrameResourceUsage::COLOR_ATTACHMENT);
+      },
+      record("Composite"));
+}
+
+}  // namespace
+
+TEST(FrameGraph, CullsAndOrdersPasses) {
+  FrameGraph graph;
+  FakeBackend backend;
+  std::vector<std::string> executed;
+  BuildFrame(&graph, &executed);
+  graph.Compile();
+
+  EXPECT_EQ(graph.GetCulledPassCount(), 1u);
+  EXPECT_TRUE(graph.IsPassCulled(1));
+  graph.Execute(backend);
+  EXPECT_EQ(executed, (std::vector<std::string>{"Scene", "Blur", "Tonemap",
+                                                "Composite"}));
+  ASSERT_EQ(graph.GetTimings().size(), 4u);
+  EXPECT_EQ(graph.GetTimings()[3].name, "Composite");
+
+  // Scene, Tonemap and Composite render; Blur only writes storage
+  ASSERT_EQ(backend.bound.size(), 3u);
+  EXPECT_TRUE(backend.bound[0].clear);
+  EXPECT_EQ(backend.bound[0].colors.size(), 1u);
+  EXPECT_TRUE(backend.bound[2].backbuffer);
+  EXPECT_TRUE(backend.bound[2].colors.empty());
+}
+
+TEST(FrameGraph, AliasesAndPoolsTransients) {
+  FrameGraph graph;
+  FakeBackend backend;
+  std::vector<std::string> executed;
+  BuildFrame(&graph, &executed);
+  graph.Compile();
+
+  // Tonemapped reuses Scene color's allocation; Blur overlaps both
+  EXPECT_EQ(graph.GetAllocationCount(), 2u);
+  graph.Execute(backend);
+  EXPECT_EQ(backend.created, 2);
+
+  // The next frame reuses the pooled allocations
+  graph.Reset();
+  BuildFrame(&graph, &executed);
+  graph.Execute(backend);
+  EXPECT_EQ(backend.created, 2);
+  EXPECT_EQ(backend.destroyed, 0);
+
+  // Unused allocations are released after a few frames
+  for (std::uint32_t i = 0; i <= FrameGraph::kPoolFrames; i++) {
+    graph.Reset();
+    graph.Execute(backend);
+  }
+  EXPECT_EQ(backend.destroyed, 2);
+  EXPECT_EQ(graph.GetPooledCount(), 0u);
+}
+
+TEST(FrameGraph, Barriers) {
+  FrameGraph graph;
+  FakeBackend backend;
+  std::vector<std::string> executed;
+  BuildFrame(&graph, &executed);
+  graph.Execute(backend);
+
+  // Scene color: attachment -> sampled.  Blur: storage -> sampled, once even
+  // though two passes sample it.
+  ASSERT_EQ(backend.barriers.size(), 2u);
+  EXPECT_EQ(backend.barriers[0].before, FrameResourceUsage::COLOR_ATTACHMENT);
+  EXPECT_EQ(backend.barriers[0].after, FrameResourceUsage::SAMPLED);
+  EXPECT_TRUE(backend.barriers[0].before_write);
+  EXPECT_EQ(backend.barriers[1].before, FrameResourceUsage::STORAGE);
+  EXPECT_EQ(backend.barriers[1].after, FrameResourceUsage::SAMPLED);
+  EXPECT_NE(backend.barriers[1].id, 0u);
+}
+
+TEST(FrameGraph, ImportsRenderTargets) {
+  FrameGraph graph;
+  FakeBackend backend;
+  RenderTargetDesc desc;
+  desc.size = glm::ivec2(32, 16);
+  desc.samples = 4;
+  const FrameResourceId target = graph.ImportRenderTarget("Target", 7, desc);
+  const FrameResourceId backbuffer =
+      graph.ImportBackbuffer("Backbuffer", glm::ivec2(64, 64));
+  unsigned int sampled = 0;
+  graph.AddPass(
+      "Draw",
+      [&](FrameGraphBuilder& builder) {
+        builder.Write(target, FrameResourceUsage::COLOR_ATTACHMENT);
+        builder.SetClear(glm::vec4(1.0f));
+      },
+      nullptr);
+  graph.AddPass(
+      "Present",
+      [&](FrameGraphBuilder& builder) {
+        builder.Read(target, FrameResourceUsage::SAMPLED);
+        builder.Write(backbuffer, FrameResourceUsage::COLOR_ATTACHMENT);
+      },
+      [&](const FrameGraphResources& resources) {
+        sampled = resources.GetTexture(target);
+      });
+  graph.Execute(backend);
+
+  // The target is bound through its own framebuffer, not as an attachment
+  ASSERT_EQ(backend.bound.size(), 2u);
+  EXPECT_EQ(backend.bound[0].render_target, 7u);
+  EXPECT_TRUE(backend.bound[0].colors.empty());
+  EXPECT_EQ(backend.bound[0].size, glm::ivec2(32, 16));
+  EXPECT_TRUE(backend.bound[0].clear);
+  EXPECT_EQ(backend.bound[1].render_target, 0u);
+  // Resolved before it is sampled, which reads its color texture
+  EXPECT_EQ(backend.resolved, std::vector<unsigned int>{7});
+  EXPECT_EQ(sampled, 1007u);
+  EXPECT_EQ(backend.created, 0);
+}
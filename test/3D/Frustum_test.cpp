@@ -0,0 +1,123 @@
+/******************************************************************************
+ * Frustum_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/Frustum.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "3D/BoundingVolume.hpp"
+#include "gtest/gtest.h"
+
+using game_engine::_3D::Aabb;
+using game_engine::_3D::BoundingSphere;
+using game_engine::_3D::Frustum;
+using game_engine::_3D::FrustumCullBatch;
+
+namespace {
+
+Frustum MakeFrustum() {
+  const glm::mat4 view =
+      glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+                  glm::vec3(0.0f, 1.0f, 0.0f));
+  const glm::mat4 projection =
+      glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f);
+  return Frustum(view, projection);
+}
+
+Aabb MakeBox(const glm::vec3 center, const float half_size) {
+  Aabb box;
+  box.min = center - glm::vec3(half_size);
+  box.max = center + glm::vec3(half_size);
+  return box;
+}
+
+}  // namespace
+
+TEST(Frustum, BoxTransform) {
+  const Aabb box = MakeBox(glm::vec3(0.0f), 1.0f);
+  const glm::mat4 matrix = glm::scale(
+      glm::translate(glm::mat4(1.0f), glm::vec3(5.0f, 0.0f, 0.0f)),
+      glm::vec3(2.0f, 1.0f, 1.0f));
+  const Aabb moved = box.Transform(matrix);
+  EXPECT_FLOAT_EQ(moved.min.x, 3.0f);
+  EXPECT_FLOAT_EQ(moved.max.x, 7.0f);
+  EXPECT_FLOAT_EQ(moved.min.y, -1.0f);
+  EXPECT_FLOAT_EQ(moved.max.z, 1.0f);
+
+  const BoundingSphere sphere{glm::vec3(0.0f), 1.0f};
+  const BoundingSphere moved_sphere = sphere.Transform(matrix);
+  EXPECT_FLOAT_EQ(moved_sphere.center.x, 5.0f);
+  EXPECT_FLOAT_EQ(moved_sphere.radius, 2.0f);
+}
+
+TEST(Frustum, Intersects) {
+  const Frustum frustum = MakeFrustum();
+  EXPECT_TRUE(frustum.Intersects(MakeBox(glm::vec3(0.0f, 0.0f, -10.0f), 1.0f)));
+  // Behind the camera
+  EXPECT_FALSE(frustum.Intersects(MakeBox(glm::vec3(0.0f, 0.0f, 10.0f), 1.0f)));
+  // Beyond the far plane
+  EXPECT_FALSE(
+      frustum.Intersects(MakeBox(glm::vec3(0.0f, 0.0f, -200.0f), 1.0f)));
+  // Outside the 90 degree field of view, then straddling its edge
+  EXPECT_FALSE(
+      frustum.Intersects(MakeBox(glm::vec3(20.0f, 0.0f, -10.0f), 1.0f)));
+  EXPECT_TRUE(
+      frustum.Intersects(MakeBox(glm::vec3(10.5f, 0.0f, -10.0f), 1.0f)));
+  EXPECT_FALSE(frustum.Intersects(Aabb{}));
+
+  EXPECT_TRUE(frustum.Intersects(
+      BoundingSphere{glm::vec3(0.0f, -10.5f, -10.0f), 1.0f}));
+  EXPECT_FALSE(frustum.Intersects(
+      BoundingSphere{glm::vec3(0.0f, -12.0f, -10.0f), 1.0f}));
+}
+
+TEST(Frustum, BatchMatchesScalar) {
+  const Frustum frustum = MakeFrustum();
+  FrustumCullBatch batch;
+  std::vector<Aabb> boxes;
+  // Enough boxes to exercise the wide paths and the scalar tail
+  for (int i = 0; i < 1003; i++) {
+    const glm::vec3 center(static_cast<float>((i * 37) % 101 - 50),
+                           static_cast<float>((i * 53) % 61 - 30),
+                           static_cast<float>((i * 71) % 151 - 120));
+    boxes.push_back(MakeBox(center, 0.5f + static_cast<float>(i % 5)));
+    if (i % 97 == 0) {
+      boxes.back() = Aabb{};
+    }
+    batch.Add(boxes.back());
+  }
+  ASSERT_EQ(batch.Size(), boxes.size());
+
+  std::vector<std::uint32_t> visible;
+  frustum.Cull(batch, &visible);
+  std::vector<std::uint32_t> expected;
+  for (std::uint32_t i = 0; i < boxes.size(); i++) {
+    if (frustum.Intersects(boxes[i])) {
+      expected.push_back(i);
+    }
+  }
+  EXPECT_EQ(visible, expected);
+  EXPECT_GT(visible.size(), 0u);
+  EXPECT_LT(visible.size(), boxes.size());
+}
@@ -0,0 +1,228 @@
+/******************************************************************************
+ * LightClusterer_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/LightClusterer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "3D/BoundingVolume.hpp"
+#include "3D/Light.hpp"
+#include "gtest/gtest.h"
+
+using game_engine::_3D::Aabb;
+using game_engine::_3D::Light;
+using game_engine::_3D::LightClusterData;
+using game_engine::_3D::LightClusterer;
+using game_engine::_3D::LightClusterOptions;
+using game_engine::_3D::LightType;
+
+namespace {
+
+glm::mat4 View() {
+  return glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+                     glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+glm::mat4 Projection() {
+  return glm::perspective(glm::radians(90.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+}
+
+Light PointLight(const glm::vec3 position, const float range) {
+  Light light;
+  light.position = position;
+  light.range = range;
+  return light;
+}
+
+std::vector<std::uint32_t> ClusterLights(const LightClusterer& clusterer,
+                                         const glm::ivec3 cell) {
+  const LightClusterData& data = clusterer.GetData();
+  const auto& cluster = data.clusters[clusterer.ClusterIndex(cell)];
+  std::vector<std::uint32_t> lights(
+      data.indices.begin() + cluster.offset,
+      data.indices.begin() + cluster.offset + cluster.count);
+  std::sort(lights.begin(), lights.end());
+  return lights;
+}
+
+/**
+ * @brief Lights scattered through the view volume, a quarter of them spots
+ */
+std::vector<Light> ScatteredLights(const int count) {
+  std::vector<Light> lights;
+  for (int i = 0; i < count; i++) {
+    Light light = PointLight(
+        glm::vec3(static_cast<float>((i * 37) % 41) - 20.0f,
+                  static_cast<float>((i * 17) % 23) - 11.0f,
+                  -static_cast<float>((i * 29) % 61) - 0.5f),
+        1.0f + static_cast<float>(i % 5));
+    if (i % 4 == 0) {
+      light.type = LightType::SPOT;
+      light.direction = glm::normalize(glm::vec3(0.3f, -0.2f, -1.0f));
+      light.outer_angle = (i % 8 == 0) ? 0.3f : 1.2f;
+      light.inner_angle = light.outer_angle * 0.5f;
+    }
+    lights.push_back(light);
+  }
+  return lights;
+}
+
+}  // namespace
+
+TEST(LightClusterer, SingleLight) {
+  LightClusterOptions options;
+  options.max_threads = 1;
+  LightClusterer clusterer(options);
+  const std::vector<Light> lights = {
+      PointLight(glm::vec3(0.0f, 0.0f, -10.0f), 1.0f),
+      PointLight(glm::vec3(0.0f, 0.0f, 5.0f), 1.0f)};
+  const LightClusterData& data = clusterer.Build(lights, View(), Projection());
+
+  EXPECT_NEAR(data.near, 0.1f, 1e-4f);
+  EXPECT_NEAR(data.far, 100.0f, 1e-1f);
+  // The light behind the camera is dropped
+  ASSERT_EQ(data.lights.size(), 1u);
+  EXPECT_EQ(clusterer.GetStats().visible_lights, 1u);
+
+  // The slice formula used by the shader puts the light's depth in a cluster
+  // that holds it
+  const int slice = static_cast<int>(std::floor(
+      std::log(10.0f) * data.depth_scale_bias.x + data.depth_scale_bias.y));
+  const glm::ivec3 center(options.grid.x / 2, options.grid.y / 2, slice);
+  EXPECT_EQ(ClusterLights(clusterer, center), std::vector<std::uint32_t>{0});
+  const Aabb bounds = clusterer.GetClusterBounds(center);
+  EXPECT_LE(-bounds.max.z, 10.0f);
+  EXPECT_GE(-bounds.min.z, 10.0f);
+
+  // Far away clusters stay empty
+  EXPECT_TRUE(ClusterLights(clusterer, glm::ivec3(0, 0, slice)).empty());
+  EXPECT_TRUE(ClusterLights(clusterer, glm::ivec3(center.x, center.y, 0))
+                  .empty());
+  EXPECT_TRUE(ClusterLights(clusterer,
+                            glm::ivec3(center.x, center.y, options.grid.z - 1))
+                  .empty());
+}
+
+TEST(LightClusterer, MatchesBruteForce) {
+  const std::vector<Light> lights = ScatteredLights(300);
+  const auto build = [&](const unsigned int threads) {
+    LightClusterOptions options;
+    options.grid = glm::ivec3(8, 6, 12);
+    options.max_threads = threads;
+    LightClusterer clusterer(options);
+    clusterer.Build(lights, View(), Projection());
+    return clusterer;
+  };
+  const LightClusterer clusterer = build(1);
+  const LightClusterData& data = clusterer.GetData();
+  const glm::ivec3 grid = data.grid;
+  ASSERT_GT(data.lights.size(), 0u);
+  EXPECT_GT(data.indices.size(), data.lights.size());
+
+  // Every light touching a cluster's bounds, tested one at a time against
+  // the bounding sphere the clusterer derives from the uploaded light
+  for (int z = 0; z < grid.z; z++) {
+    for (int y = 0; y < grid.y; y++) {
+      for (int x = 0; x < grid.x; x++) {
+        const Aabb box = clusterer.GetClusterBounds(glm::ivec3(x, y, z));
+        // Lights surely inside, and lights within rounding of the edge
+        std::vector<std::uint32_t> inside;
+        std::vector<std::uint32_t> touching;
+        for (std::uint32_t i = 0; i < data.lights.size(); i++) {
+          const auto& light = data.lights[i];
+          glm::vec3 center(light.position_range);
+          float radius = light.position_range.w;
+          if (light.direction_type.w > 0.5f) {
+            const float outer = std::acos(light.cone.x);
+            const glm::vec3 dir(light.direction_type);
+            if (outer > 0.78539816f) {
+              center += dir * (std::cos(outer) * radius);
+              radius *= std::sin(outer);
+            } else {
+              radius /= 2.0f * std::cos(outer);
+              center += dir * radius;
+            }
+          }
+          const glm::vec3 d = glm::max(
+              glm::max(box.min - center, center - box.max), glm::vec3(0.0f));
+          if (glm::dot(d, d) <= radius * radius * 0.999f) {
+            inside.push_back(i);
+          }
+          if (glm::dot(d, d) <= radius * radius * 1.001f) {
+            touching.push_back(i);
+          }
+        }
+        const auto actual = ClusterLights(clusterer, glm::ivec3(x, y, z));
+        EXPECT_TRUE(std::includes(actual.begin(), actual.end(),
+                                  inside.begin(), inside.end()));
+        EXPECT_TRUE(std::includes(touching.begin(), touching.end(),
+                                  actual.begin(), actual.end()));
+      }
+    }
+  }
+
+  // Binning does not depend on the number of threads
+  const LightClusterer threaded = build(4);
+  ASSERT_EQ(threaded.GetData().clusters.size(), data.clusters.size());
+  for (std::size_t i = 0; i < data.clusters.size(); i++) {
+    EXPECT_EQ(threaded.GetData().clusters[i].offset, data.clusters[i].offset);
+    EXPECT_EQ(threaded.GetData().clusters[i].count, data.clusters[i].count);
+  }
+  EXPECT_EQ(threaded.GetData().indices, data.indices);
+}
+
+TEST(LightClusterer, OverflowKeepsNearest) {
+  LightClusterOptions options;
+  options.grid = glm::ivec3(1, 1, 1);
+  options.max_lights_per_cluster = 4;
+  LightClusterer clusterer(options);
+  std::vector<Light> lights;
+  for (int i = 0; i < 10; i++) {
+    lights.push_back(PointLight(
+        glm::vec3(0.0f, 0.0f, -50.0f - static_cast<float>(i) * 4.0f), 2.0f));
+  }
+  clusterer.Build(lights, View(), Projection());
+
+  EXPECT_EQ(clusterer.GetStats().max_cluster_lights, 4u);
+  const Aabb box = clusterer.GetClusterBounds(glm::ivec3(0));
+  const float center = box.Center().z;
+  auto kept = ClusterLights(clusterer, glm::ivec3(0));
+  ASSERT_EQ(kept.size(), 4u);
+  // No dropped light is nearer to the cluster than a kept one
+  float farthest_kept = 0.0f;
+  for (const auto i : kept) {
+    farthest_kept = std::max(
+        farthest_kept,
+        std::abs(clusterer.GetData().lights[i].position_range.z - center));
+  }
+  for (std::uint32_t i = 0; i < lights.size(); i++) {
+    if (!std::binary_search(kept.begin(), kept.end(), i)) {
+      EXPECT_GE(
+          std::abs(clusterer.GetData().lights[i].position_range.z - center),
+          farthest_kept);
+    }
+  }
+}
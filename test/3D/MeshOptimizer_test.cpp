@@ -0,0 +1,151 @@
+/******************************************************************************
+ * MeshOptimizer_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Vertex.hpp"
+#include "gtest/gtest.h"
+
+using game_engine::Vertex;
+using game_engine::_3D::MeshOptimizer;
+using game_engine::_3D::VertexCacheStats;
+
+namespace {
+
+constexpr int kGridSize = 32;
+
+/**
+ * @brief Grid in the XY plane with its triangles in random order
+ */
+void MakeShuffledGrid(std::vector<Vertex>* vertices,
+                      std::vector<std::uint32_t>* indices) {
+  const int row = kGridSize + 1;
+  for (int y = 0; y <= kGridSize; y++) {
+    for (int x = 0; x <= kGridSize; x++) {
+      vertices->emplace_back(glm::vec3(x, y, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f),
+                             glm::vec2(x, y));
+    }
+  }
+  std::vector<std::array<std::uint32_t, 3>> triangles;
+  for (int y = 0; y < kGridSize; y++) {
+    for (int x = 0; x < kGridSize; x++) {
+      const std::uint32_t a = y * row + x;
+      triangles.push_back({a, a + 1, a + row + 1});
+      triangles.push_back({a, a + row + 1, a + row});
+    }
+  }
+  std::mt19937 rng(1234);
+  std::shuffle(triangles.begin(), triangles.end(), rng);
+  for (const auto& triangle : triangles) {
+    indices->insert(indices->end(), triangle.begin(), triangle.end());
+  }
+}
+
+/**
+ * @brief Triangles by position, with the winding kept but the starting
+ *        corner normalized, for comparing meshes independent of order
+ */
+std::vector<std::array<float, 9>> Triangles(
+    const std::vector<Vertex>& vertices,
+    const std::vector<std::uint32_t>& indices) {
+  std::vector<std::array<float, 9>> triangles;
+  for (std::size_t i = 0; i < indices.size(); i += 3) {
+    std::array<glm::vec3, 3> p = {vertices[indices[i]].position,
+                                  vertices[indices[i + 1]].position,
+                                  vertices[indices[i + 2]].position};
+    const auto smallest = std::min_element(
+        p.begin(), p.end(), [](const glm::vec3& a, const glm::vec3& b) {
+          return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+        });
+    std::rotate(p.begin(), smallest, p.end());
+    triangles.push_back({p[0].x, p[0].y, p[0].z, p[1].x, p[1].y, p[1].z,
+                         p[2].x, p[2].y, p[2].z});
+  }
+  std::sort(triangles.begin(), triangles.end());
+  return triangles;
+}
+
+}  // namespace
+
+TEST(MeshOptimizer, VertexCache) {
+  std::vector<Vertex> vertices;
+  std::vector<std::uint32_t> indices;
+  MakeShuffledGrid(&vertices, &indices);
+  const auto expected = Triangles(vertices, indices);
+
+  const VertexCacheStats before =
+      MeshOptimizer::AnalyzeVertexCache(indices, vertices.size());
+  std::vector<std::uint32_t> clusters;
+  MeshOptimizer::OptimizeVertexCache(&indices, vertices.size(), &clusters);
+  const VertexCacheStats after =
+      MeshOptimizer::AnalyzeVertexCache(indices, vertices.size());
+
+  EXPECT_EQ(Triangles(vertices, indices), expected);
+  EXPECT_GT(before.acmr, 2.0f);
+  EXPECT_LT(after.acmr, 1.0f);
+  EXPECT_LT(after.atvr, before.atvr);
+  ASSERT_FALSE(clusters.empty());
+  EXPECT_EQ(clusters.front(), 0u);
+  EXPECT_TRUE(std::is_sorted(clusters.begin(), clusters.end()));
+}
+
+TEST(MeshOptimizer, OverdrawKeepsTriangles) {
+  std::vector<Vertex> vertices;
+  std::vector<std::uint32_t> indices;
+  MakeShuffledGrid(&vertices, &indices);
+  const auto expected = Triangles(vertices, indices);
+
+  std::vector<std::uint32_t> clusters;
+  MeshOptimizer::OptimizeVertexCache(&indices, vertices.size(), &clusters);
+  const float acmr =
+      MeshOptimizer::AnalyzeVertexCache(indices, vertices.size()).acmr;
+  MeshOptimizer::OptimizeOverdraw(&indices, vertices, clusters);
+
+  EXPECT_EQ(Triangles(vertices, indices), expected);
+  // Clusters start from a cold cache, so reordering them costs little
+  EXPECT_LT(MeshOptimizer::AnalyzeVertexCache(indices, vertices.size()).acmr,
+            acmr * 1.1f);
+}
+
+TEST(MeshOptimizer, VertexFetch) {
+  std::vector<Vertex> vertices;
+  std::vector<std::uint32_t> indices;
+  MakeShuffledGrid(&vertices, &indices);
+  const auto expected = Triangles(vertices, indices);
+  const auto [before, after] = MeshOptimizer::Optimize(&vertices, &indices);
+
+  EXPECT_EQ(Triangles(vertices, indices), expected);
+  EXPECT_LT(after.acmr, before.acmr);
+  // Vertices are numbered in order of first use
+  std::uint32_t next = 0;
+  for (const auto index : indices) {
+    EXPECT_LE(index, next);
+    next = std::max(next, index + 1);
+  }
+}
@@ -0,0 +1,166 @@
+/******************************************************************************
+ * MeshSimplifier_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/MeshSimplifier.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Vertex.hpp"
+#include "gtest/gtest.h"
+
+using game_engine::Vertex;
+using game_engine::_3D::MeshLodOptions;
+using game_engine::_3D::MeshSimplifier;
+
+namespace {
+
+constexpr int kGridSize = 20;
+
+/**
+ * @brief Flat grid in the XY plane facing +Z.  With a seam, the column at
+ *        seam_column is duplicated and the right half gets its own vertices.
+ */
+void MakeGrid(std::vector<Vertex>* vertices,
+              std::vector<std::uint32_t>* indices, const int seam_column = -1) {
+  const int row = kGridSize + 1;
+  for (int y = 0; y <= kGridSize; y++) {
+    for (int x = 0; x <= kGridSize; x++) {
+      const glm::vec2 uv(static_cast<float>(x) / kGridSize,
+                         static_cast<float>(y) / kGridSize);
+      vertices->emplace_back(glm::vec3(uv, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f),
+                             uv);
+    }
+  }
+  // Wedges of the seam column used by the right half
+  const std::uint32_t seam_base = static_cast<std::uint32_t>(vertices->size());
+  if (seam_column >= 0) {
+    for (int y = 0; y <= kGridSize; y++) {
+      Vertex v = (*vertices)[y * row + seam_column];
+      v.tex_coord0 += glm::vec2(0.5f, 0.0f);
+      vertices->push_back(v);
+    }
+  }
+  // Quads right of the seam use the duplicated wedges
+  const auto index = [&](const int x, const int y, const bool right) {
+    if (right && x == seam_column) {
+      return seam_base + static_cast<std::uint32_t>(y);
+    }
+    return static_cast<std::uint32_t>(y * row + x);
+  };
+  for (int y = 0; y < kGridSize; y++) {
+    for (int x = 0; x < kGridSize; x++) {
+      const bool right = seam_column >= 0 && x >= seam_column;
+      const std::uint32_t a = index(x, y, right);
+      const std::uint32_t b = index(x + 1, y, right);
+      const std::uint32_t c = index(x + 1, y + 1, right);
+      const std::uint32_t d = index(x, y + 1, right);
+      indices->insert(indices->end(), {a, b, c, a, c, d});
+    }
+  }
+}
+
+void ExpectFacingUp(const std::vector<Vertex>& vertices,
+                    const std::vector<std::uint32_t>& indices) {
+  for (std::size_t i = 0; i < indices.size(); i += 3) {
+    const glm::vec3 p0 = vertices[indices[i]].position;
+    const glm::vec3 p1 = vertices[indices[i + 1]].position;
+    const glm::vec3 p2 = vertices[indices[i + 2]].position;
+    EXPECT_GT(glm::cross(p1 - p0, p2 - p0).z, 0.0f);
+  }
+}
+
+}  // namespace
+
+TEST(MeshSimplifier, ReducesFlatGrid) {
+  std::vector<Vertex> vertices;
+  std::vector<std::uint32_t> indices;
+  MakeGrid(&vertices, &indices);
+
+  const std::size_t target = indices.size() / 4 / 3 * 3;
+  float error = 1.0f;
+  const std::vector<std::uint32_t> result =
+      MeshSimplifier::Simplify(vertices, indices, target, 0.01f, &error);
+  ASSERT_FALSE(result.empty());
+  EXPECT_LE(result.size(), target);
+  EXPECT_EQ(result.size() % 3, 0u);
+  EXPECT_LT(error, 1e-3f);
+  ExpectFacingUp(vertices, result);
+
+  // Collapsing along the border must keep the outline, so every corner stays
+  std::vector<bool> used(vertices.size(), false);
+  for (const auto index : result) {
+    used[index] = true;
+  }
+  const int row = kGridSize + 1;
+  EXPECT_TRUE(used[0]);
+  EXPECT_TRUE(used[kGridSize]);
+  EXPECT_TRUE(used[kGridSize * row]);
+  EXPECT_TRUE(used[kGridSize * row + kGridSize]);
+}
+
+TEST(MeshSimplifier, PreservesSeams) {
+  std::vector<Vertex> vertices;
+  std::vector<std::uint32_t> indices;
+  constexpr int kSeam = kGridSize / 2;
+  MakeGrid(&vertices, &indices, kSeam);
+
+  const std::vector<std::uint32_t> result =
+      MeshSimplifier::Simplify(vertices, indices, indices.size() / 4, 0.01f);
+  EXPECT_LT(result.size(), indices.size() / 2);
+  ExpectFacingUp(vertices, result);
+
+  // No triangle may mix texture coordinates from both sides of the seam
+  for (std::size_t i = 0; i < result.size(); i += 3) {
+    int left = 0;
+    int right = 0;
+    for (int k = 0; k < 3; k++) {
+      const Vertex& v = vertices[result[i + k]];
+      const bool on_seam =
+          v.position.x == static_cast<float>(kSeam) / kGridSize;
+      if (on_seam) {
+        (v.tex_coord0.x > v.position.x ? right : left)++;
+      } else {
+        (v.position.x > 0.5f ? right : left)++;
+      }
+    }
+    EXPECT_TRUE(left == 0 || right == 0) << "Triangle " << i / 3;
+  }
+}
+
+TEST(MeshSimplifier, GeneratesLodChain) {
+  std::vector<Vertex> vertices;
+  std::vector<std::uint32_t> indices;
+  MakeGrid(&vertices, &indices);
+
+  MeshLodOptions options;
+  options.max_error = 0.01f;
+  const auto lods = MeshSimplifier::GenerateLods(vertices, indices, options);
+  ASSERT_EQ(lods.size(), options.ratios.size());
+  std::size_t previous = indices.size();
+  for (std::size_t i = 0; i < lods.size(); i++) {
+    EXPECT_LT(lods[i].size(), previous);
+    EXPECT_LE(lods[i].size(), indices.size() * options.ratios[i] + 3);
+    ExpectFacingUp(vertices, lods[i]);
+    previous = lods[i].size();
+  }
+}
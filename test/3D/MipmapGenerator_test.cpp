@@ -0,0 +1,148 @@
+/******************************************************************************
+ * MipmapGenerator_test.cpp
+ * Copyright (C) 2019  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/MipmapGenerator.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gtest/gtest.h"
+
+using game_engine::_3D::MipChain;
+using game_engine::_3D::MipFilter;
+using game_engine::_3D::MipmapGenerator;
+using game_engine::_3D::MipmapOptions;
+
+TEST(MipmapGenerator, LevelCount) {
+  EXPECT_EQ(MipmapGenerator::LevelCount(glm::ivec2(1, 1)), 1);
+  EXPECT_EQ(MipmapGenerator::LevelCount(glm::ivec2(256, 256)), 9);
+  EXPECT_EQ(MipmapGenerator::LevelCount(glm::ivec2(256, 16)), 9);
+  EXPECT_EQ(MipmapGenerator::LevelCount(glm::ivec2(5, 3)), 3);
+
+  std::vector<std::uint8_t> pixels(64 * 16 * 3, 0);
+  const MipChain chain =
+      MipmapGenerator().Generate(glm::ivec2(64, 16), 3, pixels.data());
+  ASSERT_EQ(chain.levels.size(), 7u);
+  EXPECT_EQ(chain.channels, 3);
+  EXPECT_EQ(chain.levels[2].size, glm::ivec2(16, 4));
+  EXPECT_EQ(chain.levels[6].size, glm::ivec2(1, 1));
+  EXPECT_EQ(chain.levels[4].pixels.size(), 4u * 1u * 3u);
+
+  MipmapOptions options;
+  options.max_levels = 3;
+  const MipChain limited =
+      MipmapGenerator(options).Generate(glm::ivec2(64, 16), 3, pixels.data());
+  ASSERT_EQ(limited.levels.size(), 3u);
+  EXPECT_EQ(limited.levels[2].size, glm::ivec2(16, 4));
+}
+
+TEST(MipmapGenerator, ConstantImage) {
+  for (const MipFilter filter : {MipFilter::BOX, MipFilter::KAISER}) {
+    MipmapOptions options;
+    options.filter = filter;
+    options.srgb = true;
+    std::vector<std::uint8_t> pixels(128 * 128 * 4);
+    for (std::size_t i = 0; i < pixels.size(); i += 4) {
+      pixels[i + 0] = 200;
+      pixels[i + 1] = 100;
+      pixels[i + 2] = 17;
+      pixels[i + 3] = 255;
+    }
+    const MipChain chain = MipmapGenerator(options).Generate(
+        glm::ivec2(128, 128), 4, pixels.data());
+    for (const auto& level : chain.levels) {
+      for (std::size_t i = 0; i < level.pixels.size(); i += 4) {
+        EXPECT_NEAR(level.pixels[i + 0], 200, 1);
+        EXPECT_NEAR(level.pixels[i + 1], 100, 1);
+        EXPECT_NEAR(level.pixels[i + 2], 17, 1);
+        EXPECT_EQ(level.pixels[i + 3], 255);
+      }
+    }
+  }
+}
+
+TEST(MipmapGenerator, RowStride) {
+  // 3 pixel wide rows padded to 12 bytes, like an SDL surface
+  std::vector<std::uint8_t> pixels(12 * 2, 0xFF);
+  for (int y = 0; y < 2; y++) {
+    for (int x = 0; x < 9; x++) {
+      pixels[y * 12 + x] = 50;
+    }
+  }
+  const MipChain chain =
+      MipmapGenerator().Generate(glm::ivec2(3, 2), 3, pixels.data(), 12);
+  ASSERT_EQ(chain.levels.size(), 2u);
+  EXPECT_EQ(chain.levels[0].pixels.size(), 18u);
+  for (const auto value : chain.levels[1].pixels) {
+    EXPECT_EQ(value, 50);
+  }
+}
+
+TEST(MipmapGenerator, SrgbAveraging) {
+  // A black and white checkerboard averages to 50% linear intensity, which is
+  // about 188 once encoded back to sRGB
+  std::vector<std::uint8_t> pixels(2 * 2, 0);
+  pixels[0] = 255;
+  pixels[3] = 255;
+
+  MipmapOptions options;
+  options.srgb = true;
+  MipChain chain =
+      MipmapGenerator(options).Generate(glm::ivec2(2, 2), 1, pixels.data());
+  ASSERT_EQ(chain.levels.size(), 2u);
+  EXPECT_NEAR(chain.levels[1].pixels[0], 188, 1);
+
+  options.srgb = false;
+  chain = MipmapGenerator(options).Generate(glm::ivec2(2, 2), 1, pixels.data());
+  EXPECT_NEAR(chain.levels[1].pixels[0], 128, 1);
+}
+
+TEST(MipmapGenerator, AlphaCoverage) {
+  // Sparse alpha tested texels, which plain filtering would wash out
+  const int size = 64;
+  std::vector<std::uint8_t> pixels(size * size * 4, 255);
+  std::size_t passing = 0;
+  for (int i = 0; i < size * size; i++) {
+    const bool opaque = (std::rand() % 4) == 0;
+    pixels[i * 4 + 3] = opaque ? 255 : 0;
+    passing += opaque ? 1 : 0;
+  }
+  const float base_coverage = static_cast<float>(passing) / (size * size);
+
+  MipmapOptions options;
+  options.filter = MipFilter::KAISER;
+  options.preserve_alpha_coverage = true;
+  options.alpha_cutoff = 0.5f;
+  const MipChain chain = MipmapGenerator(options).Generate(
+      glm::ivec2(size, size), 4, pixels.data());
+  for (std::size_t level = 1; level < 4; level++) {
+    const auto& mip = chain.levels[level];
+    std::size_t level_passing = 0;
+    for (std::size_t i = 3; i < mip.pixels.size(); i += 4) {
+      level_passing += (mip.pixels[i] >= 128) ? 1 : 0;
+    }
+    const float coverage = static_cast<float>(level_passing) /
+                           static_cast<float>(mip.pixels.size() / 4);
+    EXPECT_NEAR(coverage, base_coverage, 0.05f) << "level " << level;
+  }
+}
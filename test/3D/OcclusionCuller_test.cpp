@@ -0,0 +1,145 @@
+/******************************************************************************
+ * OcclusionCuller_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/OcclusionCuller.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "3D/BoundingVolume.hpp"
+#include "gtest/gtest.h"
+
+using game_engine::_3D::Aabb;
+using game_engine::_3D::OcclusionCuller;
+using game_engine::_3D::OcclusionCullerOptions;
+
+namespace {
+
+glm::mat4 ViewProjection() {
+  const glm::mat4 view =
+      glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+                  glm::vec3(0.0f, 1.0f, 0.0f));
+  const glm::mat4 projection =
+      glm::perspective(glm::radians(90.0f), 2.0f, 0.1f, 100.0f);
+  return projection * view;
+}
+
+Aabb MakeBox(const glm::vec3 min, const glm::vec3 max) {
+  Aabb box;
+  box.min = min;
+  box.max = max;
+  return box;
+}
+
+/**
+ * @brief A wall covering the left half of the screen, 10 units away
+ */
+void AddWall(OcclusionCuller* culler) {
+  culler->AddOccluder(MakeBox(glm::vec3(-40.0f, -20.0f, -10.5f),
+                              glm::vec3(0.0f, 20.0f, -9.5f)));
+}
+
+}  // namespace
+
+TEST(OcclusionCuller, Rasterize) {
+  OcclusionCullerOptions options;
+  options.resolution = glm::ivec2(64, 32);
+  options.max_threads = 1;
+  OcclusionCuller culler(options);
+  culler.BeginFrame(ViewProjection());
+  AddWall(&culler);
+  culler.Rasterize();
+
+  const auto& depth = culler.GetDepth();
+  const glm::ivec2 size = culler.GetResolution();
+  ASSERT_EQ(depth.size(), static_cast<std::size_t>(size.x * size.y));
+  for (int y = 0; y < size.y; y++) {
+    // The near face of the wall is flat, so every covered texel has the same
+    // depth, and the right half is untouched
+    EXPECT_LT(depth[y * size.x + 4], 1.0f);
+    EXPECT_NEAR(depth[y * size.x + 4], depth[y * size.x + size.x / 2 - 4],
+                1e-5f);
+    EXPECT_EQ(depth[y * size.x + size.x / 2 + 4], 1.0f);
+  }
+  EXPECT_GT(culler.GetLevelCount(), 5);
+}
+
+TEST(OcclusionCuller, Visibility) {
+  OcclusionCuller culler;
+  culler.BeginFrame(ViewProjection());
+  AddWall(&culler);
+  culler.Rasterize();
+
+  // Behind the wall
+  EXPECT_FALSE(culler.IsVisible(MakeBox(glm::vec3(-12.0f, -1.0f, -31.0f),
+                                        glm::vec3(-10.0f, 1.0f, -29.0f))));
+  // Big, but still entirely behind the wall
+  EXPECT_FALSE(culler.IsVisible(MakeBox(glm::vec3(-30.0f, -10.0f, -40.0f),
+                                        glm::vec3(-5.0f, 10.0f, -20.0f))));
+  // Beside the wall
+  EXPECT_TRUE(culler.IsVisible(MakeBox(glm::vec3(10.0f, -1.0f, -31.0f),
+                                       glm::vec3(12.0f, 1.0f, -29.0f))));
+  // Peeking out from behind its edge
+  EXPECT_TRUE(culler.IsVisible(MakeBox(glm::vec3(-5.0f, -1.0f, -31.0f),
+                                       glm::vec3(2.0f, 1.0f, -29.0f))));
+  // In front of the wall
+  EXPECT_TRUE(culler.IsVisible(MakeBox(glm::vec3(-6.0f, -1.0f, -6.0f),
+                                       glm::vec3(-4.0f, 1.0f, -4.0f))));
+  // Around the camera
+  EXPECT_TRUE(culler.IsVisible(MakeBox(glm::vec3(-1.0f), glm::vec3(1.0f))));
+
+  const std::vector<Aabb> boxes = {
+      MakeBox(glm::vec3(-12.0f, -1.0f, -31.0f),
+              glm::vec3(-10.0f, 1.0f, -29.0f)),
+      MakeBox(glm::vec3(10.0f, -1.0f, -31.0f), glm::vec3(12.0f, 1.0f, -29.0f))};
+  std::vector<std::uint32_t> visible;
+  culler.Cull(boxes, &visible);
+  EXPECT_EQ(visible, std::vector<std::uint32_t>{1});
+}
+
+TEST(OcclusionCuller, Deterministic) {
+  const auto render = [](const unsigned int threads, const bool async) {
+    OcclusionCullerOptions options;
+    options.resolution = glm::ivec2(200, 100);
+    options.max_threads = threads;
+    options.cull_back_faces = false;
+    OcclusionCuller culler(options);
+    culler.BeginFrame(ViewProjection());
+    for (int i = 0; i < 50; i++) {
+      const float x = static_cast<float>(i % 10) * 6.0f - 30.0f;
+      const float y = static_cast<float>(i / 10) * 5.0f - 12.0f;
+      const float z = -8.0f - static_cast<float>((i * 7) % 13);
+      culler.AddOccluder(
+          MakeBox(glm::vec3(x, y, z), glm::vec3(x + 3.0f, y + 2.0f, z + 1.0f)));
+    }
+    if (async) {
+      culler.RasterizeAsync();
+    } else {
+      culler.Rasterize();
+    }
+    return culler.GetDepth();
+  };
+  const std::vector<float> reference = render(1, false);
+  EXPECT_EQ(render(4, false), reference);
+  EXPECT_EQ(render(3, true), reference);
+}
@@ -0,0 +1,133 @@
+/******************************************************************************
+ * ResolutionController_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/ResolutionController.hpp"
+
+#include <cmath>
+#include <deque>
+
+#include <glm/glm.hpp>
+
+#include "gtest/gtest.h"
+
+using game_engine::_3D::DynamicResolutionOptions;
+using game_engine::_3D::ResolutionController;
+
+namespace {
+
+DynamicResolutionOptions Enabled() {
+  DynamicResolutionOptions options;
+  options.enabled = true;
+  options.target_ms = 15.0;
+  return options;
+}
+
+/**
+ * @brief Run frames whose GPU time grows with the number of pixels drawn
+ * @return Returns the GPU time of the last frame
+ */
+double Simulate(ResolutionController* controller, const double full_res_ms,
+                const int frames) {
+  double gpu_ms = 0.0;
+  for (int i = 0; i < frames; i++) {
+    const double scale = controller->GetScale();
+    gpu_ms = full_res_ms * scale * scale;
+    controller->Update(2.0, gpu_ms);
+  }
+  return gpu_ms;
+}
+
+}  // namespace
+
+TEST(ResolutionController, Disabled) {
+  ResolutionController controller;
+  controller.Update(40.0, 40.0);
+  EXPECT_EQ(controller.GetScale(), 1.0f);
+  EXPECT_EQ(controller.ScaledSize(glm::ivec2(800, 600)), glm::ivec2(800, 600));
+}
+
+TEST(ResolutionController, ConvergesOnTarget) {
+  ResolutionController controller(Enabled());
+  // Full resolution costs twice the budget, so the scene should settle
+  // around 1 / sqrt(2) of the window along each axis
+  const double gpu_ms = Simulate(&controller, 30.0, 200);
+  EXPECT_NEAR(gpu_ms, 15.0, 1.5);
+  EXPECT_NEAR(controller.GetScale(), 1.0f / std::sqrt(2.0f), 0.05f);
+
+  const glm::ivec2 size = controller.ScaledSize(glm::ivec2(1000, 500));
+  EXPECT_NEAR(size.x, 1000.0f * controller.GetScale(), 1.0f);
+  EXPECT_NEAR(size.y, 500.0f * controller.GetScale(), 1.0f);
+
+  // The load drops, and the scene returns to full resolution
+  Simulate(&controller, 8.0, 200);
+  EXPECT_EQ(controller.GetScale(), 1.0f);
+}
+
+TEST(ResolutionController, Bounds) {
+  DynamicResolutionOptions options = Enabled();
+  options.min_scale = 0.6f;
+  ResolutionController controller(options);
+  Simulate(&controller, 500.0, 100);
+  EXPECT_EQ(controller.GetScale(), 0.6f);
+
+  // Without GPU timings the CPU time is used
+  controller.Reset();
+  EXPECT_EQ(controller.GetScale(), 1.0f);
+  for (int i = 0; i < 100; i++) {
+    controller.Update(100.0, -1.0);
+  }
+  EXPECT_EQ(controller.GetScale(), 0.6f);
+  // Dropping to the bound must not wind up the integral
+  for (int i = 0; i < 20; i++) {
+    controller.Update(5.0, -1.0);
+  }
+  EXPECT_GT(controller.GetScale(), 0.6f);
+}
+
+TEST(ResolutionController, SettlesWithLatentTimers) {
+  // GPU times arrive three frames late, as from GLRenderer's pass timers
+  for (const double full_res_ms : {20.0, 30.0, 60.0}) {
+    ResolutionController controller(Enabled());
+    std::deque<double> in_flight;
+    float settled = 0.0f;
+    for (int i = 0; i < 400; i++) {
+      const double scale = controller.GetScale();
+      const double gpu_ms = full_res_ms * scale * scale;
+      in_flight.push_back(gpu_ms);
+      if (in_flight.size() > 3) {
+        controller.Update(2.0, in_flight.front());
+        in_flight.pop_front();
+      } else {
+        controller.Update(2.0, -1.0);
+      }
+      if (i == 200) {
+        settled = controller.GetScale();
+      } else if (i > 200) {
+        ASSERT_EQ(controller.GetScale(), settled) << full_res_ms << " ms";
+        ASSERT_LE(gpu_ms, 15.0) << full_res_ms << " ms";
+      }
+    }
+    // The largest scale within budget, not one left a step too small
+    const float next = settled + controller.GetOptions().step;
+    EXPECT_TRUE(settled == controller.GetOptions().min_scale ||
+                full_res_ms * next * next > 15.0)
+        << full_res_ms << " ms";
+  }
+}
@@ -0,0 +1,175 @@
+/******************************************************************************
+ * TextureAtlas_test.cpp
+ * Copyright (C) 2019  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "3D/TextureAtlas.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "gtest/gtest.h"
+
+using game_engine::ShaderPrograms;
+using game_engine::_3D::MipChain;
+using game_engine::_3D::PixelFormat;
+using game_engine::_3D::SkylinePacker;
+using game_engine::_3D::TextureArrayBuilder;
+using game_engine::_3D::TextureAtlas;
+using game_engine::_3D::TextureRegion;
+using game_engine::_3D::TextureWrap;
+
+namespace {
+
+/**
+ * @brief Stands in for a renderer, keeping what would have been uploaded
+ */
+struct UploadRecorder {
+  unsigned int CreateTextureArray(const ShaderPrograms,
+                                  const PixelFormat,
+                                  const std::vector<MipChain>& chains,
+                                  const TextureWrap texture_wrap) const {
+    layers = chains;
+    wrap = texture_wrap;
+    return 1;
+  }
+
+  mutable std::vector<MipChain> layers{};
+  mutable TextureWrap wrap = TextureWrap::CLAMP;
+};
+
+}  // namespace
+
+TEST(TextureAtlas, SkylinePackerNoOverlap) {
+  const glm::ivec2 size(256, 256);
+  SkylinePacker packer(size);
+  std::vector<std::uint8_t> used(size.x * size.y, 0);
+  int packed = 0;
+  for (int i = 0; i < 400; i++) {
+    const glm::ivec2 rect(4 + (i * 7) % 23, 4 + (i * 13) % 19);
+    const auto position = packer.Pack(rect);
+    if (!position) {
+      continue;
+    }
+    packed++;
+    ASSERT_GE(position->x, 0);
+    ASSERT_GE(position->y, 0);
+    ASSERT_LE(position->x + rect.x, size.x);
+    ASSERT_LE(position->y + rect.y, size.y);
+    for (int y = position->y; y < position->y + rect.y; y++) {
+      for (int x = position->x; x < position->x + rect.x; x++) {
+        ASSERT_EQ(used[y * size.x + x], 0) << "overlap at " << x << ", " << y;
+        used[y * size.x + x] = 1;
+      }
+    }
+  }
+  EXPECT_GT(packed, 100);
+  EXPECT_GT(packer.GetOccupancy(), 0.7f);
+
+  // Identical tiles should pack perfectly
+  packer.Reset(glm::ivec2(64, 64));
+  for (int i = 0; i < 16; i++) {
+    EXPECT_TRUE(packer.Pack(glm::ivec2(16, 16)));
+  }
+  EXPECT_FALSE(packer.Pack(glm::ivec2(1, 1)));
+  EXPECT_FLOAT_EQ(packer.GetOccupancy(), 1.0f);
+}
+
+TEST(TextureAtlas, AddAndPad) {
+  TextureAtlas atlas(glm::ivec2(16, 16), 1, 1);
+  const std::vector<std::uint8_t> image = {1, 2, 3, 4};
+  const auto region = atlas.Add(glm::ivec2(2, 2), image.data());
+  ASSERT_TRUE(region);
+  EXPECT_EQ(region->layer, 0);
+  EXPECT_EQ(region->position, glm::ivec2(1, 1));
+  EXPECT_FLOAT_EQ(region->uv_min.x, 1.0f / 16.0f);
+  EXPECT_FLOAT_EQ(region->uv_max.y, 3.0f / 16.0f);
+
+  // Border texels are extruded into the padding
+  const auto& pixels = atlas.GetPixels();
+  EXPECT_EQ(pixels[0 * 16 + 0], 1);
+  EXPECT_EQ(pixels[1 * 16 + 1], 1);
+  EXPECT_EQ(pixels[1 * 16 + 3], 2);
+  EXPECT_EQ(pixels[3 * 16 + 0], 3);
+  EXPECT_EQ(pixels[3 * 16 + 3], 4);
+
+  EXPECT_FALSE(atlas.Add(glm::ivec2(15, 15), image.data()));
+}
+
+TEST(TextureAtlas, NewLayerWhenFull) {
+  TextureAtlas atlas(glm::ivec2(32, 32), 4, 0);
+  const std::vector<std::uint8_t> image(16 * 16 * 4, 0xFF);
+  for (int i = 0; i < 4; i++) {
+    const auto region = atlas.Add(glm::ivec2(16, 16), image.data());
+    ASSERT_TRUE(region);
+    EXPECT_EQ(region->layer, 0);
+  }
+  const auto region = atlas.Add(glm::ivec2(16, 16), image.data());
+  ASSERT_TRUE(region);
+  EXPECT_EQ(region->layer, 1);
+  EXPECT_EQ(atlas.GetLayerCount(), 2);
+  EXPECT_EQ(atlas.GetPixels().size(), 2u * 32u * 32u * 4u);
+}
+
+TEST(TextureAtlas, TextureArrayBuilder) {
+  TextureArrayBuilder builder(glm::ivec2(8, 8), 3);
+  const std::vector<std::uint8_t> tile(8 * 8 * 3, 0);
+  EXPECT_EQ(builder.AddLayer(tile.data()).layer, 0);
+  const TextureRegion region = builder.AddLayer(tile.data());
+  EXPECT_EQ(region.layer, 1);
+  EXPECT_EQ(region.uv_min, glm::vec2(0.0f, 0.0f));
+  EXPECT_EQ(region.uv_max, glm::vec2(1.0f, 1.0f));
+  EXPECT_EQ(builder.GetLayerCount(), 2);
+}
+
+TEST(TextureAtlas, MipLevelsKeepPadding) {
+  EXPECT_EQ(TextureAtlas(glm::ivec2(64, 64), 1, 0).GetMipLevels(), 1);
+  EXPECT_EQ(TextureAtlas(glm::ivec2(64, 64), 1, 1).GetMipLevels(), 1);
+  EXPECT_EQ(TextureAtlas(glm::ivec2(64, 64), 1, 2).GetMipLevels(), 2);
+  EXPECT_EQ(TextureAtlas(glm::ivec2(64, 64), 1, 5).GetMipLevels(), 3);
+  EXPECT_EQ(TextureAtlas(glm::ivec2(4, 4), 1, 64).GetMipLevels(), 3);
+  // The default padding leaves room for mip levels
+  EXPECT_EQ(TextureAtlas(glm::ivec2(64, 64), 1).GetMipLevels(), 3);
+
+  TextureAtlas atlas(glm::ivec2(32, 32), 1, 4);
+  const std::vector<std::uint8_t> image(8 * 8, 0x80);
+  ASSERT_TRUE(atlas.Add(glm::ivec2(8, 8), image.data()));
+  const UploadRecorder recorder;
+  atlas.Upload(recorder, ShaderPrograms::DEFAULT, PixelFormat{0, 0});
+  ASSERT_EQ(recorder.layers.size(), 1u);
+  ASSERT_EQ(recorder.layers[0].levels.size(), 3u);
+  EXPECT_EQ(recorder.layers[0].levels[2].size, glm::ivec2(8, 8));
+  EXPECT_EQ(recorder.wrap, TextureWrap::CLAMP);
+}
+
+TEST(TextureAtlas, TextureArrayBuilderRepeats) {
+  TextureArrayBuilder builder(glm::ivec2(8, 8), 3);
+  const std::vector<std::uint8_t> tile(8 * 8 * 3, 0x40);
+  builder.AddLayer(tile.data());
+  builder.AddLayer(tile.data());
+  const UploadRecorder recorder;
+  builder.Upload(recorder, ShaderPrograms::DEFAULT, PixelFormat{0, 0});
+  ASSERT_EQ(recorder.layers.size(), 2u);
+  // Tiles wrap onto themselves, so the whole chain is usable
+  EXPECT_EQ(recorder.layers[1].levels.size(), 4u);
+  EXPECT_EQ(recorder.layers[1].levels[3].pixels,
+            std::vector<std::uint8_t>(3, 0x40));
+  EXPECT_EQ(recorder.wrap, TextureWrap::REPEAT);
+}
@@ -0,0 +1,225 @@
+/******************************************************************************
+ * GLRenderer_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "GL/GLRenderer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "3D/MipmapGenerator.hpp"
+#include "3D/PixelFormat.hpp"
+#include "3D/Primitive.hpp"
+#include "GL/GlContextTest.hpp"
+#include "ShaderPrograms.hpp"
+#include "Vertex.hpp"
+#include "gtest/gtest.h"
+
+using game_engine::ShaderPrograms;
+using game_engine::Vertex;
+using game_engine::VboHandle;
+using game_engine::_3D::Primitive;
+using game_engine::_3D::MipChain;
+using game_engine::_3D::MipmapGenerator;
+using game_engine::_3D::PixelFormat;
+using game_engine::gl::GlContextTest;
+using game_engine::gl::GLRenderer;
+
+namespace {
+
+class GLRendererTest : public GlContextTest {
+ protected:
+  void SetUp() override {
+    GlContextTest::SetUp();
+    if (!HasContext()) {
+      return;
+    }
+    renderer_.InitContext();
+  }
+
+  /**
+   * @brief Read one level of a 2D RGBA texture
+   */
+  static std::vector<std::uint8_t> ReadLevel(const unsigned int id,
+                                             const int level,
+                                             const glm::ivec2 size) {
+    std::vector<std::uint8_t> pixels(static_cast<std::size_t>(size.x) *
+                                     size.y * 4);
+    glBindTexture(GL_TEXTURE_2D, id);
+    glGetTexImage(GL_TEXTURE_2D, level, GL_RGBA, GL_UNSIGNED_BYTE,
+                  pixels.data());
+    return pixels;
+  }
+
+  /**
+   * @brief RGBA8 pixel of the window, counted from its bottom left corner
+   */
+  static std::vector<std::uint8_t> ReadPixel(const int x, const int y) {
+    std::vector<std::uint8_t> pixel(4);
+    glReadPixels(x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel.data());
+    return pixel;
+  }
+
+  GLRenderer renderer_{};
+};
+
+/**
+ * @brief Best time of a few runs of fn, which finishes its GL work itself
+ */
+template <typename Fn>
+double BestMs(const Fn& fn) {
+  double best = 0.0;
+  for (int run = 0; run < 5; run++) {
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best = (run == 0) ? elapsed.count() : std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+}  // namespace
+
+TEST_F(GLRendererTest, MipChainAgainstGlGenerateMipmap) {
+  // Smooth gradients, so both box filters agree to within rounding
+  constexpr int kImageSize = 1024;
+  const glm::ivec2 size(kImageSize, kImageSize);
+  std::vector<std::uint8_t> pixels(kImageSize * kImageSize * 4);
+  for (int y = 0; y < kImageSize; y++) {
+    for (int x = 0; x < kImageSize; x++) {
+      std::uint8_t* texel = &pixels[(y * kImageSize + x) * 4];
+      texel[0] = static_cast<std::uint8_t>(x / 4);
+      texel[1] = static_cast<std::uint8_t>(y / 4);
+      texel[2] = static_cast<std::uint8_t>((x + y) / 8);
+      texel[3] = 255;
+    }
+  }
+  const PixelFormat format{GL_RGBA8, GL_RGBA};
+
+  unsigned int generated = 0;
+  const double cpu_ms = BestMs([&] {
+    glDeleteTextures(1, &generated);
+    const MipChain chain =
+        MipmapGenerator().Generate(size, 4, pixels.data());
+    generated = renderer_.CreateTexture(ShaderPrograms::DEFAULT, format, chain);
+    glFinish();
+  });
+  unsigned int driver = 0;
+  const double gl_ms = BestMs([&] {
+    glDeleteTextures(1, &driver);
+    driver = renderer_.CreateTexture(ShaderPrograms::DEFAULT, format, size,
+                                     pixels.data());
+    glFinish();
+  });
+  RecordProperty("mipmap_generator_ms", std::to_string(cpu_ms));
+  RecordProperty("gl_generate_mipmap_ms", std::to_string(gl_ms));
+  std::cout << "MipmapGenerator and upload: " << cpu_ms
+            << " ms, glGenerateMipmap: " << gl_ms << " ms on "
+            << glGetString(GL_RENDERER) << std::endl;
+
+  for (const int level : {1, 4, 10}) {
+    const glm::ivec2 level_size = glm::max(size / (1 << level), glm::ivec2(1));
+    const std::vector<std::uint8_t> ours =
+        ReadLevel(generated, level, level_size);
+    const std::vector<std::uint8_t> theirs =
+        ReadLevel(driver, level, level_size);
+    ASSERT_EQ(ours.size(), theirs.size());
+    int worst = 0;
+    for (std::size_t i = 0; i < ours.size(); i++) {
+      worst = std::max(worst, std::abs(ours[i] - theirs[i]));
+    }
+    // The driver rounds each level to 8 bits before filtering the next one,
+    // where MipmapGenerator keeps floats, so deeper levels drift a little
+    EXPECT_LE(worst, 2) << "level " << level;
+  }
+  glDeleteTextures(1, &generated);
+  glDeleteTextures(1, &driver);
+}
+
+TEST_F(GLRendererTest, RenderIndexRange) {
+  // A red quad over the left half of the window, then a green one over the
+  // right half.  Padding the vertices past Vbo::kMaxShortIndexVertices
+  // switches the buffer to 32-bit indices.
+  for (const std::size_t padding : {std::size_t{0}, std::size_t{65536}}) {
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    for (int quad = 0; quad < 2; quad++) {
+      const GLuint first = static_cast<GLuint>(vertices.size());
+      for (int corner = 0; corner < 4; corner++) {
+        Vertex vertex;
+        vertex.position = glm::vec3((corner & 1) ? quad : quad - 1.0f,
+                                    (corner & 2) ? 1.0f : -1.0f, 0.0f);
+        vertex.color = (quad == 0) ? glm::vec4(1.0f, 0.0f, 0.0f, 1.0f)
+                                   : glm::vec4(0.0f, 1.0f, 0.0f, 1.0f);
+        vertices.push_back(vertex);
+      }
+      for (const GLuint corner : {0u, 1u, 3u, 0u, 3u, 2u}) {
+        indices.push_back(first + corner);
+      }
+    }
+    vertices.resize(vertices.size() + padding);
+    const VboHandle vbo =
+        renderer_.GenerateVbo(ShaderPrograms::DEFAULT, vertices, indices);
+
+    const std::uint8_t white[4] = {255, 255, 255, 255};
+    const unsigned int texture =
+        renderer_.CreateTexture(ShaderPrograms::DEFAULT,
+                                PixelFormat{GL_RGBA8, GL_RGBA},
+                                glm::ivec2(1, 1), white);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    renderer_.SetUniform(ShaderPrograms::DEFAULT, "texture_diffuse0", 0);
+    renderer_.SetUniform(ShaderPrograms::DEFAULT, "color",
+                         glm::vec3(1.0f, 1.0f, 1.0f));
+    renderer_.SetMatrices(ShaderPrograms::DEFAULT, glm::mat4(1.0f),
+                          glm::mat4(1.0f), glm::mat4(1.0f));
+
+    glViewport(0, 0, kWindowSize, kWindowSize);
+    renderer_.Clear(glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+    // Only the second quad, six indices in
+    renderer_.Render(vbo, Primitive::TRIANGLES, 6, 6);
+
+    GLint element_buffer = 0;
+    glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &element_buffer);
+    GLint index_bytes = 0;
+    glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE,
+                           &index_bytes);
+    const std::size_t index_size =
+        (padding == 0) ? sizeof(GLushort) : sizeof(GLuint);
+    EXPECT_NE(element_buffer, 0);
+    EXPECT_EQ(static_cast<std::size_t>(index_bytes),
+              indices.size() * index_size);
+
+    EXPECT_EQ(ReadPixel(kWindowSize / 4, kWindowSize / 2),
+              (std::vector<std::uint8_t>{0, 0, 255, 255}))
+        << padding;
+    EXPECT_EQ(ReadPixel(kWindowSize * 3 / 4, kWindowSize / 2),
+              (std::vector<std::uint8_t>{0, 255, 0, 255}))
+        << padding;
+    glDeleteTextures(1, &texture);
+  }
+}
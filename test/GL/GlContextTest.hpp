@@ -0,0 +1,93 @@
+/******************************************************************************
+ * GlContextTest.hpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef TEST_GL_GLCONTEXTTEST_HPP_
+#define TEST_GL_GLCONTEXTTEST_HPP_
+
+#include <cstdlib>
+
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+
+#include "gtest/gtest.h"
+
+namespace game_engine::gl {
+
+/**
+ * @brief Runs each test in a hidden window with an OpenGL 4.5 context,
+ *        preferring llvmpipe so the results do not depend on the GPU.  Tests
+ *        are skipped when no such context can be created.
+ *
+ * Fixtures deriving from it return from SetUp when HasContext() is false,
+ * and release their GL objects before calling GlContextTest::TearDown.
+ */
+class GlContextTest : public ::testing::Test {
+ public:
+  static constexpr int kWindowSize = 16;
+
+ protected:
+  void SetUp() override {
+    setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+    if (SDL_InitSubSystem(SDL_INIT_VIDEO) != 0) {
+      GTEST_SKIP() << "No video device: " << SDL_GetError();
+    }
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK,
+                        SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+    window_ = SDL_CreateWindow("GL_test", SDL_WINDOWPOS_UNDEFINED,
+                               SDL_WINDOWPOS_UNDEFINED, kWindowSize,
+                               kWindowSize,
+                               SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    if (window_ == nullptr) {
+      GTEST_SKIP() << "No OpenGL window: " << SDL_GetError();
+    }
+    context_ = SDL_GL_CreateContext(window_);
+    if (context_ == nullptr) {
+      GTEST_SKIP() << "No OpenGL 4.5 context: " << SDL_GetError();
+    }
+    glewExperimental = GL_TRUE;
+    ASSERT_EQ(glewInit(), GLEW_OK);
+  }
+
+  void TearDown() override {
+    if (context_ != nullptr) {
+      SDL_GL_DeleteContext(context_);
+    }
+    if (window_ != nullptr) {
+      SDL_DestroyWindow(window_);
+    }
+    SDL_QuitSubSystem(SDL_INIT_VIDEO);
+  }
+
+  /**
+   * @brief Whether SetUp made a usable context the test can go on with
+   */
+  bool HasContext() const {
+    return context_ != nullptr && !IsSkipped() && !HasFatalFailure();
+  }
+
+  SDL_Window* window_ = nullptr;
+  SDL_GLContext context_ = nullptr;
+};
+
+} /* namespace game_engine::gl */
+
+#endif /* TEST_GL_GLCONTEXTTEST_HPP_ */
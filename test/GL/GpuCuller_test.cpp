@@ -0,0 +1,184 @@
+/******************************************************************************
+ * GpuCuller_test.cpp 
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "GL/GpuCuller.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "3D/BoundingVolume.hpp"
+#include "3D/Frustum.hpp"
+#include "GL/GlContextTest.hpp"
+#include "Vertex.hpp"
+#include "gtest/gtest.h"
+
+using game_engine::Vertex;
+using game_engine::_3D::Aabb;
+using game_engine::_3D::Frustum;
+using game_engine::_3D::FrustumCullBatch;
+using game_engine::gl::GlContextTest;
+using game_engine::gl::GpuCuller;
+
+namespace {
+
+class GpuCullerTest : public GlContextTest {
+ protected:
+  void SetUp() override {
+    GlContextTest::SetUp();
+    if (!HasContext()) {
+      return;
+    }
+    ASSERT_TRUE(culler_.Init());
+  }
+
+  void TearDown() override {
+    if (context_ != nullptr) {
+      culler_.Destroy();
+    }
+    GlContextTest::TearDown();
+  }
+
+  GpuCuller culler_{};
+};
+
+/**
+ * @brief A box from -size to size, as two triangles per face
+ */
+void MakeBox(const glm::vec3 size, std::vector<Vertex>& vertices,
+             std::vector<GLuint>& indices) {
+  for (int i = 0; i < 8; i++) {
+    Vertex vertex;
+    vertex.position = glm::vec3((i & 1) ? size.x : -size.x,
+                                (i & 2) ? size.y : -size.y,
+                                (i & 4) ? size.z : -size.z);
+    vertices.push_back(vertex);
+  }
+  indices = {0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5, 0, 4, 5, 0, 5, 1,
+             2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3};
+}
+
+/**
+ * @brief Mesh bounds and transform of an instance added to the culler
+ */
+struct Instance {
+  Aabb bounds{};
+  glm::mat4 model{1.0f};
+  bool enabled = true;
+};
+
+/**
+ * @brief Scatter instances of two meshes on a grid around the camera, at
+ *        offsets that keep their bounds off the planes of the frustum
+ */
+std::vector<Instance> AddInstances(GpuCuller& culler) {
+  std::vector<Vertex> vertices[2];
+  std::vector<GLuint> indices[2];
+  MakeBox(glm::vec3(0.5f), vertices[0], indices[0]);
+  MakeBox(glm::vec3(1.5f, 0.25f, 0.75f), vertices[1], indices[1]);
+  const std::uint32_t meshes[2] = {culler.AddMesh(vertices[0], indices[0]),
+                                   culler.AddMesh(vertices[1], indices[1])};
+
+  std::vector<Instance> instances;
+  for (int z = -12; z < 12; z++) {
+    for (int x = -12; x < 12; x++) {
+      const int mesh = (x + z) & 1;
+      Instance instance;
+      instance.bounds = Aabb::FromVertices(vertices[mesh]);
+      instance.model = glm::translate(
+          glm::mat4(1.0f),
+          glm::vec3(x * 3.1f + 0.37f, ((x * 7 + z) % 5) - 2.13f,
+                    z * 3.1f + 0.41f));
+      culler.AddInstance(meshes[mesh], instance.model);
+      instances.push_back(instance);
+    }
+  }
+  return instances;
+}
+
+std::uint32_t CpuVisibleCount(const glm::mat4& view,
+                              const glm::mat4& projection,
+                              const std::vector<Instance>& instances) {
+  FrustumCullBatch batch;
+  for (const Instance& instance : instances) {
+    batch.Add(instance.bounds.Transform(instance.model));
+  }
+  std::vector<std::uint32_t> visible;
+  Frustum(view, projection).Cull(batch, &visible);
+  std::uint32_t count = 0;
+  for (const std::uint32_t index : visible) {
+    count += instances[index].enabled ? 1 : 0;
+  }
+  return count;
+}
+
+}  // namespace
+
+TEST_F(GpuCullerTest, MatchesCpuCulling) {
+  const std::vector<Instance> instances = AddInstances(culler_);
+  ASSERT_EQ(culler_.GetInstanceCount(), instances.size());
+
+  const glm::mat4 projection =
+      glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 30.0f);
+  for (const glm::vec3 target :
+       {glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(1.0f, -0.2f, 0.3f),
+        glm::vec3(-0.4f, 0.1f, 1.0f)}) {
+    const glm::mat4 view =
+        glm::lookAt(glm::vec3(0.0f), target, glm::vec3(0.0f, 1.0f, 0.0f));
+    const std::uint32_t expected = CpuVisibleCount(view, projection, instances);
+    ASSERT_GT(expected, 0u);
+    ASSERT_LT(expected, instances.size());
+    culler_.Cull(projection * view);
+    EXPECT_EQ(culler_.ReadVisibleCount(), expected);
+  }
+}
+
+TEST_F(GpuCullerTest, FollowsDisabledAndMovedInstances) {
+  std::vector<Instance> instances = AddInstances(culler_);
+  const glm::mat4 projection =
+      glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 30.0f);
+  const glm::mat4 view =
+      glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+                  glm::vec3(0.0f, 1.0f, 0.0f));
+  culler_.Cull(projection * view);
+  const std::uint32_t all = culler_.ReadVisibleCount();
+
+  for (std::uint32_t i = 0; i < instances.size(); i += 3) {
+    culler_.SetEnabled(i, false);
+    instances[i].enabled = false;
+  }
+  culler_.Cull(projection * view);
+  const std::uint32_t expected = CpuVisibleCount(view, projection, instances);
+  EXPECT_LT(expected, all);
+  EXPECT_EQ(culler_.ReadVisibleCount(), expected);
+
+  // Move one instance of every other row in front of the camera
+  for (std::uint32_t i = 1; i < instances.size(); i += 48) {
+    instances[i].model = glm::translate(glm::mat4(1.0f),
+                                        glm::vec3(0.13f, 0.07f, -5.0f));
+    culler_.SetTransform(i, instances[i].model);
+  }
+  culler_.Cull(projection * view);
+  EXPECT_EQ(culler_.ReadVisibleCount(),
+            CpuVisibleCount(view, projection, instances));
+}
@@ -0,0 +1,163 @@
+/******************************************************************************
+ * ReadbackRing_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "GL/ReadbackRing.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+#include <SDL2/SDL.h>
+#include <glm/glm.hpp>
+
+#include "GL/GlContextTest.hpp"
+#include "GL/RenderTarget.hpp"
+#include "gtest/gtest.h"
+
+using game_engine::_3D::ReadbackResult;
+using game_engine::_3D::RenderTargetDesc;
+using game_engine::gl::GlContextTest;
+using game_engine::gl::ReadbackRing;
+using game_engine::gl::RenderTarget;
+
+namespace {
+
+constexpr int kSize = GlContextTest::kWindowSize;
+
+using Color = std::vector<std::uint8_t>;
+
+class ReadbackRingTest : public GlContextTest {
+ protected:
+  void TearDown() override {
+    if (context_ != nullptr) {
+      ring_.Destroy();
+    }
+    GlContextTest::TearDown();
+  }
+
+  /**
+   * @brief Clear the bound framebuffer to bottom, then its top half to top
+   */
+  static void ClearHalves(const glm::vec4 bottom, const glm::vec4 top) {
+    glViewport(0, 0, kSize, kSize);
+    glClearColor(bottom.r, bottom.g, bottom.b, bottom.a);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, kSize / 2, kSize, kSize / 2);
+    glClearColor(top.r, top.g, top.b, top.a);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+  }
+
+  std::vector<std::uint8_t> Read(const GLuint framebuffer) {
+    std::vector<std::uint8_t> pixels;
+    ring_.Request(framebuffer, glm::ivec2(kSize, kSize),
+                  [&pixels](const ReadbackResult& result) {
+                    EXPECT_EQ(result.size, glm::ivec2(kSize, kSize));
+                    pixels = result.pixels;
+                  });
+    ring_.Finish();
+    return pixels;
+  }
+
+  ReadbackRing ring_{};
+};
+
+Color Pixel(const std::vector<std::uint8_t>& pixels, const int x,
+            const int y) {
+  const auto first = pixels.begin() + (y * kSize + x) * 4;
+  return Color(first, first + 4);
+}
+
+/**
+ * @brief Results start at the top row, so the top half comes first
+ */
+void ExpectHalves(const std::vector<std::uint8_t>& pixels, const Color& top,
+                  const Color& bottom) {
+  ASSERT_EQ(pixels.size(), static_cast<std::size_t>(kSize * kSize * 4));
+  for (const int x : {0, kSize - 1}) {
+    EXPECT_EQ(Pixel(pixels, x, 0), top);
+    EXPECT_EQ(Pixel(pixels, x, kSize / 2 - 1), top);
+    EXPECT_EQ(Pixel(pixels, x, kSize / 2), bottom);
+    EXPECT_EQ(Pixel(pixels, x, kSize - 1), bottom);
+  }
+}
+
+}  // namespace
+
+TEST_F(ReadbackRingTest, ReadsRenderTargets) {
+  for (const int samples : {1, 4}) {
+    RenderTargetDesc desc;
+    desc.size = glm::ivec2(kSize, kSize);
+    desc.color_format = {GL_RGBA8, GL_RGBA};
+    desc.samples = samples;
+    RenderTarget target;
+    target.Init(desc);
+    target.Bind();
+    ClearHalves(glm::vec4(1.0f, 0.0f, 0.0f, 1.0f),
+                glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+    target.Resolve();
+
+    ExpectHalves(Read(target.GetResolveFramebuffer()),
+                 Color{0, 255, 0, 255}, Color{255, 0, 0, 255});
+    target.Destroy();
+  }
+}
+
+TEST_F(ReadbackRingTest, ReadsTheWindowBeforeSwap) {
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  ClearHalves(glm::vec4(0.0f, 0.0f, 1.0f, 1.0f),
+              glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+  const std::vector<std::uint8_t> pixels = Read(0);
+  SDL_GL_SwapWindow(window_);
+
+  ExpectHalves(pixels, Color{255, 255, 255, 255}, Color{0, 0, 255, 255});
+}
+
+TEST_F(ReadbackRingTest, ReusesBuffers) {
+  RenderTargetDesc desc;
+  desc.size = glm::ivec2(kSize, kSize);
+  desc.color_format = {GL_RGBA8, GL_RGBA};
+  RenderTarget target;
+  target.Init(desc);
+  target.Bind();
+
+  int delivered = 0;
+  for (int i = 0; i < 3; i++) {
+    ClearHalves(glm::vec4(static_cast<float>(i) / 2.0f),
+                glm::vec4(static_cast<float>(i) / 2.0f));
+    ring_.Request(target.GetResolveFramebuffer(), desc.size,
+                  [&delivered, i](const ReadbackResult& result) {
+                    // Delivered in request order, each with its own pixels
+                    EXPECT_EQ(delivered, i);
+                    EXPECT_NEAR(result.pixels[0], i * 255 / 2, 1);
+                    delivered++;
+                  });
+  }
+  EXPECT_EQ(ring_.GetPendingCount(), 3u);
+  EXPECT_EQ(ring_.GetBufferCount(), 3u);
+  ring_.Finish();
+  EXPECT_EQ(delivered, 3);
+
+  // Every buffer is free again, so none is created
+  Read(target.GetResolveFramebuffer());
+  EXPECT_EQ(ring_.GetBufferCount(), 3u);
+  target.Destroy();
+}
@@ -0,0 +1,95 @@
+/******************************************************************************
+ * SlangShaderCache_test.cpp
+ * Copyright (C) 2019  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "GL/SlangShaderCache.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "Util/Rng.hpp"
+
+#include "gtest/gtest.h"
+
+using game_engine::gl::SlangCompileInput;
+using game_engine::gl::SlangOutputs;
+using game_engine::gl::SlangShaderCache;
+using game_engine::gl::SlangShaderStage;
+
+TEST(SlangShaderCache, FindImports) {
+  const auto imports = SlangShaderCache::FindImports(
+      "import lighting;\n"
+      "  __import util.math_helpers ;\n"
+      "import \"common/noise.slang\";\n"
+      "// import commented;\n"
+      "float importance = 1.0;\n");
+  ASSERT_EQ(imports.size(), 3u);
+  EXPECT_EQ(imports[0], "lighting");
+  EXPECT_EQ(imports[1], "util.math_helpers");
+  EXPECT_EQ(imports[2], "common/noise.slang");
+}
+
+TEST(SlangShaderCache, Key) {
+  const std::filesystem::path directory =
+      std::filesystem::temp_directory_path() /
+      ("GameEngine_test_" + std::to_string(Rng::get()));
+  std::filesystem::create_directories(directory);
+  std::ofstream(directory / "lighting.slang") << "float3 Light();";
+
+  SlangCompileInput input;
+  input.source = "import lighting;\nvoid vertexMain() {}";
+  input.search_paths = {directory};
+  input.entry_points = {{"vertexMain", SlangShaderStage::VERTEX}};
+  const auto key = SlangShaderCache::Key(input, "v1");
+
+  EXPECT_EQ(key, SlangShaderCache::Key(input, "v1"));
+  EXPECT_NE(key, SlangShaderCache::Key(input, "v2"));
+
+  SlangCompileInput changed = input;
+  changed.profile = "glsl_450";
+  EXPECT_NE(key, SlangShaderCache::Key(changed, "v1"));
+  changed = input;
+  changed.entry_points[0].stage = SlangShaderStage::FRAGMENT;
+  EXPECT_NE(key, SlangShaderCache::Key(changed, "v1"));
+
+  // Editing an imported module invalidates the entry
+  std::ofstream(directory / "lighting.slang") << "float3 Light(float3 n);";
+  EXPECT_NE(key, SlangShaderCache::Key(input, "v1"));
+
+  std::filesystem::remove_all(directory);
+}
+
+TEST(SlangShaderCache, StoreAndLoad) {
+  const std::filesystem::path directory =
+      std::filesystem::temp_directory_path() /
+      ("GameEngine_test_" + std::to_string(Rng::get()));
+  {
+    const SlangShaderCache cache(directory);
+    const SlangOutputs outputs = {"void main() {}", "", "#version 460\n"};
+    EXPECT_FALSE(cache.Load(1));
+    EXPECT_TRUE(cache.Store(1, outputs));
+    const auto loaded = cache.Load(1);
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(*loaded, outputs);
+  }
+  std::filesystem::remove_all(directory);
+
+  EXPECT_FALSE(SlangShaderCache::Deserialize({1, 0, 0, 0, 0, 0, 0, 0, 9}));
+}
@@ -0,0 +1,50 @@
+/******************************************************************************
+ * Vbo_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "GL/Vbo.hpp"
+
+#include <GL/glew.h>
+
+#include "gtest/gtest.h"
+
+using game_engine::gl::Vbo;
+
+TEST(Vbo, IndexTypeFor) {
+  EXPECT_EQ(Vbo::IndexTypeFor(1), GL_UNSIGNED_SHORT);
+  // The last vertex of 65535 is index 65534, clear of the primitive restart
+  // index of 16-bit buffers
+  EXPECT_EQ(Vbo::IndexTypeFor(65535), GL_UNSIGNED_SHORT);
+  EXPECT_EQ(Vbo::IndexTypeFor(Vbo::kMaxShortIndexVertices), GL_UNSIGNED_INT);
+  EXPECT_EQ(Vbo::IndexTypeFor(65536), GL_UNSIGNED_INT);
+  EXPECT_EQ(Vbo::IndexTypeFor(1 << 20), GL_UNSIGNED_INT);
+  // Index-only buffers have no vertex count to go by
+  EXPECT_EQ(Vbo::IndexTypeFor(0), GL_UNSIGNED_INT);
+}
+
+TEST(Vbo, IndexOffset) {
+  Vbo vbo;
+  vbo.index_type_ = GL_UNSIGNED_SHORT;
+  vbo.index_size_ = sizeof(GLushort);
+  EXPECT_EQ(vbo.IndexOffset(0), 0u);
+  EXPECT_EQ(vbo.IndexOffset(6), 12u);
+  vbo.index_type_ = GL_UNSIGNED_INT;
+  vbo.index_size_ = sizeof(GLuint);
+  EXPECT_EQ(vbo.IndexOffset(6), 24u);
+}
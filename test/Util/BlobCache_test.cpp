@@ -0,0 +1,110 @@
+/******************************************************************************
+ * BlobCache_test.cpp
+ * Copyright (C) 2019  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "Util/BlobCache.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "Util/Hash.hpp"
+#include "Util/Rng.hpp"
+
+#include "gtest/gtest.h"
+
+using game_engine::util::BlobCache;
+using game_engine::util::Hash;
+using game_engine::util::Hasher;
+
+namespace {
+
+std::filesystem::path TemporaryDirectory() {
+  return std::filesystem::temp_directory_path() /
+         ("GameEngine_test_" + std::to_string(Rng::get()));
+}
+
+}  // namespace
+
+TEST(Util, Hash) {
+  // Reference values of 64-bit FNV-1a
+  EXPECT_EQ(Hash("", 0), 0xcbf29ce484222325ULL);
+  EXPECT_EQ(Hash("a", 1), 0xaf63dc4c8601ec8cULL);
+  EXPECT_EQ(Hash("foobar", 6), 0x85944171f73967e8ULL);
+
+  // Length prefixing keeps concatenations apart
+  EXPECT_NE(Hasher().Add("ab").Add("c").Get(),
+            Hasher().Add("a").Add("bc").Get());
+}
+
+TEST(Util, BlobCache) {
+  const std::filesystem::path directory = TemporaryDirectory();
+  {
+    const BlobCache cache(directory, true);
+    ASSERT_TRUE(cache.IsEnabled());
+
+    const std::vector<uint8_t> blob = {1, 2, 3, 4, 5};
+    EXPECT_FALSE(cache.Load(42));
+    EXPECT_TRUE(cache.Store(42, blob));
+    const auto loaded = cache.Load(42);
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(*loaded, blob);
+
+    // Flip a payload byte, the entry must be rejected and dropped
+    std::filesystem::path entry;
+    for (const auto& file : std::filesystem::directory_iterator(directory)) {
+      entry = file.path();
+    }
+    {
+      std::fstream file(entry,
+                        std::ios::in | std::ios::out | std::ios::binary);
+      file.seekp(-1, std::ios::end);
+      file.put(static_cast<char>(0xFF));
+    }
+    EXPECT_FALSE(cache.Load(42));
+    EXPECT_FALSE(std::filesystem::exists(entry));
+
+    // A size past the end of the file is a miss, not a huge allocation
+    EXPECT_TRUE(cache.Store(42, blob));
+    {
+      std::fstream file(entry,
+                        std::ios::in | std::ios::out | std::ios::binary);
+      const uint64_t size = uint64_t{1} << 60;
+      file.seekp(16);
+      file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    }
+    EXPECT_FALSE(cache.Load(42));
+    EXPECT_FALSE(std::filesystem::exists(entry));
+
+    // So is a payload cut short
+    EXPECT_TRUE(cache.Store(42, blob));
+    std::filesystem::resize_file(entry, std::filesystem::file_size(entry) - 1);
+    EXPECT_FALSE(cache.Load(42));
+
+    cache.Store(7, blob);
+    cache.Remove(7);
+    EXPECT_FALSE(cache.Load(7));
+  }
+  std::filesystem::remove_all(directory);
+
+  const BlobCache missing(TemporaryDirectory(), false);
+  EXPECT_FALSE(missing.IsEnabled());
+  EXPECT_FALSE(missing.Store(1, {1}));
+}
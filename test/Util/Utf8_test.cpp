@@ -0,0 +1,61 @@
+/******************************************************************************
+ * Utf8_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "Util/Utf8.hpp"
+
+#include <string_view>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using game_engine::util::DecodeUtf8;
+using game_engine::util::kReplacementCharacter;
+
+namespace {
+
+std::vector<char32_t> Decode(const std::string_view text) {
+  std::vector<char32_t> code_points;
+  std::size_t offset = 0;
+  while (offset < text.size()) {
+    code_points.push_back(DecodeUtf8(text, offset));
+  }
+  return code_points;
+}
+
+}  // namespace
+
+TEST(Utf8, DecodesEveryLength) {
+  // A, e acute, the CJK character for "middle" and an emoji
+  const std::vector<char32_t> expected = {0x41, 0xE9, 0x4E2D, 0x1F600};
+  EXPECT_EQ(Decode("A\xC3\xA9\xE4\xB8\xAD\xF0\x9F\x98\x80"), expected);
+}
+
+TEST(Utf8, ReplacesMalformedSequences) {
+  const char32_t r = kReplacementCharacter;
+  // Stray continuation byte
+  EXPECT_EQ(Decode("a\x80z"), (std::vector<char32_t>{'a', r, 'z'}));
+  // Truncated sequence, resynchronizing on the next character
+  EXPECT_EQ(Decode("\xE4\xB8z"), (std::vector<char32_t>{r, r, 'z'}));
+  // Overlong encoding of '/'
+  EXPECT_EQ(Decode("\xC0\xAF"), (std::vector<char32_t>{r, r}));
+  // Surrogate half
+  EXPECT_EQ(Decode("\xED\xA0\x80"), (std::vector<char32_t>{r, r, r}));
+  // Above U+10FFFF
+  EXPECT_EQ(Decode("\xF4\x90\x80\x80"), (std::vector<char32_t>{r, r, r, r}));
+}
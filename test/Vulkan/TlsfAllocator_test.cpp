@@ -0,0 +1,140 @@
+/******************************************************************************
+ * TlsfAllocator_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "Vulkan/TlsfAllocator.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using game_engine::vulkan::TlsfAllocation;
+using game_engine::vulkan::TlsfAllocator;
+
+namespace {
+
+std::vector<TlsfAllocation> Allocations(const TlsfAllocator& allocator) {
+  std::vector<TlsfAllocation> allocations;
+  allocator.ForEachAllocation([&allocations](const TlsfAllocation& range) {
+    allocations.push_back(range);
+  });
+  return allocations;
+}
+
+}  // namespace
+
+TEST(TlsfAllocator, AlignsOffsets) {
+  TlsfAllocator allocator(1 << 20);
+  ASSERT_TRUE(allocator.Allocate(3));
+  for (const std::uint64_t alignment : {4u, 256u, 4096u, 65536u}) {
+    const auto range = allocator.Allocate(100, alignment);
+    ASSERT_TRUE(range);
+    EXPECT_EQ(range->offset % alignment, 0u);
+    EXPECT_EQ(range->size, 100u);
+  }
+  EXPECT_EQ(allocator.GetAllocationCount(), 5u);
+  EXPECT_EQ(allocator.GetUsed(), 403u);
+}
+
+TEST(TlsfAllocator, FreeCoalesces) {
+  constexpr std::uint64_t kSize = 1 << 16;
+  TlsfAllocator allocator(kSize);
+  std::vector<TlsfAllocation> ranges;
+  for (int i = 0; i < 64; i++) {
+    const auto range = allocator.Allocate(kSize / 64);
+    ASSERT_TRUE(range);
+    ranges.push_back(*range);
+  }
+  // Completely full
+  EXPECT_FALSE(allocator.Allocate(1));
+  EXPECT_EQ(allocator.GetLargestFree(), 0u);
+
+  // Free every other range, then the rest, in both directions
+  for (std::size_t i = 0; i < ranges.size(); i += 2) {
+    allocator.Free(ranges[i].handle);
+  }
+  EXPECT_EQ(allocator.GetLargestFree(), kSize / 64);
+  EXPECT_FALSE(allocator.Allocate(kSize / 32));
+  for (std::size_t i = ranges.size() - 1; i < ranges.size(); i -= 2) {
+    allocator.Free(ranges[i].handle);
+  }
+  EXPECT_TRUE(allocator.IsEmpty());
+  EXPECT_EQ(allocator.GetLargestFree(), kSize);
+  const auto whole = allocator.Allocate(kSize);
+  ASSERT_TRUE(whole);
+  EXPECT_EQ(whole->offset, 0u);
+}
+
+TEST(TlsfAllocator, RejectsWhatDoesNotFit) {
+  TlsfAllocator allocator(1000);
+  EXPECT_FALSE(allocator.Allocate(0));
+  EXPECT_FALSE(allocator.Allocate(1001));
+  ASSERT_TRUE(allocator.Allocate(1000));
+  TlsfAllocator empty;
+  EXPECT_FALSE(empty.Allocate(1));
+}
+
+TEST(TlsfAllocator, RandomAllocationsNeverOverlap) {
+  constexpr std::uint64_t kSize = 1 << 24;
+  TlsfAllocator allocator(kSize);
+  std::mt19937 random(42);
+  std::uniform_int_distribution<std::uint64_t> sizes(1, 1 << 16);
+  std::uniform_int_distribution<int> alignments(0, 8);
+  std::vector<TlsfAllocation> live;
+  std::uint64_t used = 0;
+
+  for (int i = 0; i < 20000; i++) {
+    if (live.empty() || random() % 3 != 0) {
+      const std::uint64_t size = sizes(random);
+      const std::uint64_t alignment = std::uint64_t{1} << alignments(random);
+      const auto range = allocator.Allocate(size, alignment);
+      if (!range) {
+        continue;
+      }
+      EXPECT_EQ(range->offset % alignment, 0u);
+      EXPECT_LE(range->offset + range->size, kSize);
+      live.push_back(*range);
+      used += size;
+    } else {
+      const std::size_t index = random() % live.size();
+      allocator.Free(live[index].handle);
+      used -= live[index].size;
+      live[index] = live.back();
+      live.pop_back();
+    }
+  }
+  EXPECT_EQ(allocator.GetUsed(), used);
+  EXPECT_EQ(allocator.GetAllocationCount(), live.size());
+
+  const std::vector<TlsfAllocation> ordered = Allocations(allocator);
+  ASSERT_EQ(ordered.size(), live.size());
+  for (std::size_t i = 1; i < ordered.size(); i++) {
+    EXPECT_LE(ordered[i - 1].offset + ordered[i - 1].size, ordered[i].offset);
+  }
+
+  for (const TlsfAllocation& range : live) {
+    allocator.Free(range.handle);
+  }
+  EXPECT_TRUE(allocator.IsEmpty());
+  EXPECT_EQ(allocator.GetLargestFree(), kSize);
+}
@@ -0,0 +1,195 @@
+/******************************************************************************
+ * VulkanAllocator_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "Vulkan/VulkanAllocator.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "Vulkan/VulkanDevice.hpp"
+#include "Vulkan/VulkanLinearArena.hpp"
+#include "gtest/gtest.h"
+
+using game_engine::vulkan::VulkanAllocation;
+using game_engine::vulkan::VulkanArenaSlice;
+using game_engine::vulkan::VulkanBuffer;
+using game_engine::vulkan::VulkanDevice;
+using game_engine::vulkan::VulkanDeviceOptions;
+using game_engine::vulkan::VulkanHeapStats;
+using game_engine::vulkan::VulkanImage;
+using game_engine::vulkan::VulkanImageDesc;
+using game_engine::vulkan::VulkanLinearArena;
+
+namespace {
+
+constexpr VkDeviceSize kBlockSize = 1 << 20;
+
+/**
+ * @brief Create a device without a surface, preferring lavapipe
+ */
+std::unique_ptr<VulkanDevice> MakeDevice() {
+  VulkanDeviceOptions options;
+  options.prefer_software = true;
+  options.allocator.block_size = kBlockSize;
+  auto device = std::make_unique<VulkanDevice>();
+  device->CreateInstance("VulkanAllocator_test", options);
+  device->CreateDevice(VK_NULL_HANDLE);
+  return device;
+}
+
+std::size_t TotalAllocations(const std::vector<VulkanHeapStats>& stats) {
+  std::size_t count = 0;
+  for (const VulkanHeapStats& heap : stats) {
+    count += heap.allocation_count;
+  }
+  return count;
+}
+
+}  // namespace
+
+TEST(VulkanAllocator, SmallBuffersShareMemory) {
+  if (!VulkanDevice::HasDevice()) {
+    GTEST_SKIP() << "No Vulkan 1.3 device";
+  }
+  auto device = MakeDevice();
+  std::vector<VulkanBuffer> buffers;
+  for (int i = 0; i < 256; i++) {
+    buffers.push_back(device->CreateBuffer(
+        1024, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, i % 2 == 0));
+  }
+  EXPECT_LE(device->allocator_.GetDeviceMemoryCount(), 4u);
+  EXPECT_EQ(TotalAllocations(device->allocator_.GetHeapStats()), 256u);
+
+  // Host visible buffers are mapped and do not overlap
+  for (std::size_t i = 0; i < buffers.size(); i += 2) {
+    ASSERT_NE(buffers[i].allocation.mapped, nullptr);
+    std::memset(buffers[i].allocation.mapped, static_cast<int>(i), 1024);
+  }
+  for (std::size_t i = 0; i < buffers.size(); i += 2) {
+    const auto* bytes =
+        static_cast<const std::uint8_t*>(buffers[i].allocation.mapped);
+    EXPECT_EQ(bytes[0], static_cast<std::uint8_t>(i));
+    EXPECT_EQ(bytes[1023], static_cast<std::uint8_t>(i));
+  }
+
+  for (VulkanBuffer& buffer : buffers) {
+    device->DestroyBuffer(buffer);
+  }
+  EXPECT_EQ(TotalAllocations(device->allocator_.GetHeapStats()), 0u);
+  device->allocator_.ReleaseEmptyBlocks();
+  EXPECT_EQ(device->allocator_.GetDeviceMemoryCount(), 0u);
+  device->Destroy();
+}
+
+TEST(VulkanAllocator, LargeImagesAreDedicated) {
+  if (!VulkanDevice::HasDevice()) {
+    GTEST_SKIP() << "No Vulkan 1.3 device";
+  }
+  auto device = MakeDevice();
+  VulkanImageDesc desc{};
+  desc.extent = {1024, 1024};
+  desc.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+  VulkanImage image = device->CreateImage(desc);
+  EXPECT_EQ(image.allocation.block, nullptr);
+  EXPECT_EQ(image.allocation.offset, 0u);
+
+  std::size_t dedicated = 0;
+  for (const VulkanHeapStats& heap : device->allocator_.GetHeapStats()) {
+    dedicated += heap.dedicated_count;
+  }
+  EXPECT_EQ(dedicated, 1u);
+  device->DestroyImage(image);
+  device->Destroy();
+}
+
+TEST(VulkanAllocator, ReportsDefragmentationCandidates) {
+  if (!VulkanDevice::HasDevice()) {
+    GTEST_SKIP() << "No Vulkan 1.3 device";
+  }
+  auto device = MakeDevice();
+  // Fill several blocks, then free most of the allocations
+  constexpr VkDeviceSize kSize = kBlockSize / 8;
+  std::vector<VulkanBuffer> buffers;
+  for (int i = 0; i < 24; i++) {
+    buffers.push_back(device->CreateBuffer(
+        kSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, true));
+  }
+  for (std::size_t i = 0; i < buffers.size(); i++) {
+    if (i % 6 != 0) {
+      device->DestroyBuffer(buffers[i]);
+    }
+  }
+
+  const std::vector<VulkanAllocation> candidates =
+      device->allocator_.GetDefragmentationCandidates(0.25f, kBlockSize * 4);
+  EXPECT_FALSE(candidates.empty());
+  for (const VulkanAllocation& candidate : candidates) {
+    EXPECT_NE(candidate.block, nullptr);
+    EXPECT_GE(candidate.size, kSize);
+  }
+
+  // Moving every live buffer out and back in packs them together
+  for (VulkanBuffer& buffer : buffers) {
+    if (buffer.buffer == VK_NULL_HANDLE) {
+      continue;
+    }
+    VulkanBuffer moved = device->CreateBuffer(
+        kSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, true);
+    std::memcpy(moved.allocation.mapped, buffer.allocation.mapped, kSize);
+    device->DestroyBuffer(buffer);
+    buffer = moved;
+  }
+  EXPECT_GT(device->allocator_.ReleaseEmptyBlocks(), 0u);
+
+  for (VulkanBuffer& buffer : buffers) {
+    device->DestroyBuffer(buffer);
+  }
+  device->Destroy();
+}
+
+TEST(VulkanLinearArena, AllocatesAndResets) {
+  if (!VulkanDevice::HasDevice()) {
+    GTEST_SKIP() << "No Vulkan 1.3 device";
+  }
+  auto device = MakeDevice();
+  VulkanLinearArena arena;
+  arena.Init(device.get(), 4096, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+  const VulkanArenaSlice first = arena.Allocate(100);
+  const VulkanArenaSlice second = arena.Allocate(100, 256);
+  EXPECT_EQ(first.buffer, second.buffer);
+  EXPECT_EQ(second.offset % 256, 0u);
+  EXPECT_GE(second.offset, first.offset + first.size);
+
+  // Overflowing chains another buffer, which Reset folds into one
+  const VulkanArenaSlice overflow = arena.Allocate(8192);
+  EXPECT_NE(overflow.buffer, first.buffer);
+  std::memset(overflow.mapped, 0xff, 8192);
+  EXPECT_EQ(arena.GetUsed(), 8392u);
+  arena.Reset();
+  EXPECT_EQ(arena.GetUsed(), 0u);
+  EXPECT_GE(arena.GetCapacity(), 4096u + 8192u);
+  const VulkanArenaSlice again = arena.Allocate(8192);
+  EXPECT_EQ(again.offset, 0u);
+
+  arena.Destroy();
+  device->Destroy();
+}
@@ -0,0 +1,117 @@
+/******************************************************************************
+ * VulkanPipelineCache_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "Vulkan/VulkanPipelineCache.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "Vulkan/VulkanDevice.hpp"
+#include "Vulkan/VulkanRenderer.hpp"
+#include "gtest/gtest.h"
+
+using game_engine::vulkan::VulkanDevice;
+using game_engine::vulkan::VulkanPipelineCache;
+using game_engine::vulkan::VulkanRenderer;
+using game_engine::vulkan::VulkanRendererOptions;
+
+namespace {
+
+VkPhysicalDeviceProperties MakeProperties() {
+  VkPhysicalDeviceProperties properties{};
+  properties.vendorID = 0x10005;
+  properties.deviceID = 42;
+  for (std::uint8_t i = 0; i < VK_UUID_SIZE; i++) {
+    properties.pipelineCacheUUID[i] = i;
+  }
+  return properties;
+}
+
+std::vector<std::uint8_t> MakeData(
+    const VkPhysicalDeviceProperties& properties) {
+  VkPipelineCacheHeaderVersionOne header{};
+  header.headerSize = sizeof(header);
+  header.headerVersion = VK_PIPELINE_CACHE_HEADER_VERSION_ONE;
+  header.vendorID = properties.vendorID;
+  header.deviceID = properties.deviceID;
+  std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID,
+              VK_UUID_SIZE);
+  std::vector<std::uint8_t> data(sizeof(header) + 64, 0xab);
+  std::memcpy(data.data(), &header, sizeof(header));
+  return data;
+}
+
+std::unique_ptr<VulkanRenderer> MakeRenderer(
+    const std::filesystem::path& directory) {
+  VulkanRendererOptions options;
+  options.headless = true;
+  options.size = glm::ivec2(16, 16);
+  options.prefer_software = true;
+  options.pipeline_cache_directory = directory;
+  auto renderer = std::make_unique<VulkanRenderer>();
+  renderer->Init("VulkanPipelineCache_test", options);
+  return renderer;
+}
+
+}  // namespace
+
+TEST(VulkanPipelineCache, ChecksHeader) {
+  const VkPhysicalDeviceProperties properties = MakeProperties();
+  EXPECT_TRUE(
+      VulkanPipelineCache::IsCompatible(MakeData(properties), properties));
+
+  VkPhysicalDeviceProperties other = properties;
+  other.pipelineCacheUUID[7] ^= 1;
+  EXPECT_FALSE(VulkanPipelineCache::IsCompatible(MakeData(properties), other));
+  other = properties;
+  other.deviceID++;
+  EXPECT_FALSE(VulkanPipelineCache::IsCompatible(MakeData(properties), other));
+
+  std::vector<std::uint8_t> truncated = MakeData(properties);
+  truncated.resize(16);
+  EXPECT_FALSE(VulkanPipelineCache::IsCompatible(truncated, properties));
+  std::vector<std::uint8_t> version = MakeData(properties);
+  version[4] = 2;
+  EXPECT_FALSE(VulkanPipelineCache::IsCompatible(version, properties));
+}
+
+TEST(VulkanPipelineCache, PersistsWarmedUpPipelines) {
+  const std::filesystem::path directory =
+      std::filesystem::temp_directory_path() / "VulkanPipelineCache_test";
+  std::filesystem::remove_all(directory);
+
+  if (!VulkanDevice::HasDevice()) {
+    GTEST_SKIP() << "No Vulkan 1.3 device";
+  }
+  auto renderer = MakeRenderer(directory);
+  EXPECT_FALSE(renderer->GetPipelineCache().WasLoaded());
+  renderer->WaitForPipelineWarmUp();
+  EXPECT_GT(renderer->GetPipelineCount(), 0u);
+  renderer->Destroy();
+  EXPECT_FALSE(std::filesystem::is_empty(directory));
+
+  renderer = MakeRenderer(directory);
+  EXPECT_TRUE(renderer->GetPipelineCache().WasLoaded());
+  renderer->Destroy();
+  std::filesystem::remove_all(directory);
+}
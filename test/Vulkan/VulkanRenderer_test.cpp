@@ -0,0 +1,254 @@
+/******************************************************************************
+ * VulkanRenderer_test.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "Vulkan/VulkanRenderer.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "2D/SpriteBatch.hpp"
+#include "Vulkan/VulkanDevice.hpp"
+#include "gtest/gtest.h"
+
+using game_engine::ShaderPrograms;
+using game_engine::Vertex;
+using game_engine::VboHandle;
+using game_engine::_2D::Sprite;
+using game_engine::_2D::SpriteBatch;
+using game_engine::_3D::PixelFormat;
+using game_engine::_3D::Primitive;
+using game_engine::_3D::ReadbackResult;
+using game_engine::_3D::TextureWrap;
+using game_engine::vulkan::VulkanDevice;
+using game_engine::vulkan::VulkanRenderer;
+using game_engine::vulkan::VulkanRendererOptions;
+
+namespace {
+
+constexpr int kSize = 64;
+
+/**
+ * @brief Create a headless renderer, preferring lavapipe so the results do
+ *        not depend on the GPU
+ */
+std::unique_ptr<VulkanRenderer> MakeRenderer(const unsigned int threads) {
+  VulkanRendererOptions options;
+  options.headless = true;
+  options.size = glm::ivec2(kSize, kSize);
+  options.prefer_software = true;
+  options.recording_threads = threads;
+  auto renderer = std::make_unique<VulkanRenderer>();
+  renderer->Init("VulkanRenderer_test", options);
+  return renderer;
+}
+
+std::vector<std::uint8_t> ReadBackbuffer(const VulkanRenderer& renderer) {
+  std::vector<std::uint8_t> pixels;
+  renderer.ReadRenderTargetAsync(
+      0, [&pixels](const ReadbackResult& result) { pixels = result.pixels; });
+  renderer.Swap();
+  renderer.FinishReadbacks();
+  return pixels;
+}
+
+std::vector<std::uint8_t> Pixel(const std::vector<std::uint8_t>& pixels,
+                                const int x, const int y) {
+  const auto first = pixels.begin() + (y * kSize + x) * 4;
+  return std::vector<std::uint8_t>(first, first + 4);
+}
+
+/**
+ * @brief Append a quad covering [min, max] in clip space
+ */
+void AddQuad(std::vector<Vertex>& vertices, std::vector<GLuint>& indices,
+             const glm::vec2 min, const glm::vec2 max) {
+  const GLuint first = static_cast<GLuint>(vertices.size());
+  const glm::vec3 normal(0.0f, 0.0f, 1.0f);
+  vertices.emplace_back(glm::vec3(min.x, min.y, 0.0f), normal,
+                        glm::vec2(0.0f, 0.0f));
+  vertices.emplace_back(glm::vec3(max.x, min.y, 0.0f), normal,
+                        glm::vec2(1.0f, 0.0f));
+  vertices.emplace_back(glm::vec3(max.x, max.y, 0.0f), normal,
+                        glm::vec2(1.0f, 1.0f));
+  vertices.emplace_back(glm::vec3(min.x, max.y, 0.0f), normal,
+                        glm::vec2(0.0f, 1.0f));
+  for (const GLuint index : {0u, 1u, 2u, 0u, 2u, 3u}) {
+    indices.push_back(first + index);
+  }
+}
+
+/**
+ * @brief Draw every cell of an 8x8 grid twice, with a different color each
+ *        time, so the result depends on the order of 128 draws
+ */
+std::vector<std::uint8_t> DrawGrid(VulkanRenderer& renderer) {
+  constexpr int kCells = 8;
+  std::vector<Vertex> vertices;
+  std::vector<GLuint> indices;
+  for (int y = 0; y < kCells; y++) {
+    for (int x = 0; x < kCells; x++) {
+      const glm::vec2 min(-1.0f + 2.0f * x / kCells,
+                          -1.0f + 2.0f * y / kCells);
+      AddQuad(vertices, indices, min, min + glm::vec2(2.0f / kCells));
+    }
+  }
+  const VboHandle vbo =
+      renderer.GenerateVbo(ShaderPrograms::DEFAULT, vertices, indices);
+
+  renderer.DisableDepthTesting();
+  renderer.Clear(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+  for (int pass = 0; pass < 2; pass++) {
+    for (int cell = 0; cell < kCells * kCells; cell++) {
+      renderer.SetColor(ShaderPrograms::DEFAULT,
+                        glm::vec3(cell / 64.0f, pass, 1.0f - cell / 64.0f));
+      renderer.Render(vbo, Primitive::TRIANGLES, cell * 6, 6);
+    }
+  }
+  return ReadBackbuffer(renderer);
+}
+
+}  // namespace
+
+TEST(VulkanRenderer, Clear) {
+  if (!VulkanDevice::HasDevice()) {
+    GTEST_SKIP() << "No Vulkan 1.3 device";
+  }
+  const auto renderer = MakeRenderer(1);
+  renderer->Clear(glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+  const auto pixels = ReadBackbuffer(*renderer);
+  ASSERT_EQ(pixels.size(), static_cast<std::size_t>(kSize * kSize * 4));
+  EXPECT_EQ(Pixel(pixels, 0, 0), (std::vector<std::uint8_t>{0, 0, 255, 255}));
+  EXPECT_EQ(Pixel(pixels, kSize - 1, kSize - 1),
+            (std::vector<std::uint8_t>{0, 0, 255, 255}));
+}
+
+TEST(VulkanRenderer, DrawQuad) {
+  if (!VulkanDevice::HasDevice()) {
+    GTEST_SKIP() << "No Vulkan 1.3 device";
+  }
+  const auto renderer = MakeRenderer(1);
+  std::vector<Vertex> vertices;
+  std::vector<GLuint> indices;
+  AddQuad(vertices, indices, glm::vec2(-1.0f, -1.0f), glm::vec2(0.0f, 1.0f));
+  const VboHandle vbo =
+      renderer->GenerateVbo(ShaderPrograms::DEFAULT, vertices, indices);
+  ASSERT_TRUE(renderer->HasVbo(vbo));
+
+  renderer->Clear(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+  renderer->SetColor(ShaderPrograms::DEFAULT, glm::vec3(1.0f, 0.0f, 0.0f));
+  renderer->Render(vbo, Primitive::TRIANGLES);
+  const auto pixels = ReadBackbuffer(*renderer);
+  ASSERT_EQ(pixels.size(), static_cast<std::size_t>(kSize * kSize * 4));
+  EXPECT_EQ(Pixel(pixels, kSize / 4, kSize / 2),
+            (std::vector<std::uint8_t>{255, 0, 0, 255}));
+  EXPECT_EQ(Pixel(pixels, kSize * 3 / 4, kSize / 2),
+            (std::vector<std::uint8_t>{0, 0, 0, 255}));
+}
+
+TEST(VulkanRenderer, ThreadedRecordingKeepsDrawOrder) {
+  if (!VulkanDevice::HasDevice()) {
+    GTEST_SKIP() << "No Vulkan 1.3 device";
+  }
+  const auto single = MakeRenderer(1);
+  const auto threaded = MakeRenderer(4);
+  ASSERT_EQ(threaded->GetRecordingThreads(), 4u);
+  const auto expected = DrawGrid(*single);
+  const auto pixels = DrawGrid(*threaded);
+  ASSERT_EQ(pixels.size(), static_cast<std::size_t>(kSize * kSize * 4));
+  EXPECT_EQ(pixels, expected);
+  // The second color drawn over each cell wins
+  EXPECT_EQ(Pixel(pixels, 4, kSize - 4)[1], 255);
+}
+
+TEST(VulkanRenderer, DrawSprites) {
+  if (!VulkanDevice::HasDevice()) {
+    GTEST_SKIP() << "No Vulkan 1.3 device";
+  }
+  const auto renderer = MakeRenderer(1);
+  const PixelFormat format{GL_RGBA8, GL_RGBA};
+  const unsigned int array = renderer->CreateTextureArray(
+      ShaderPrograms::SPRITE, format, glm::ivec3(1, 1, 2), 1,
+      TextureWrap::CLAMP);
+  ASSERT_NE(array, 0u);
+  const std::uint8_t red[4] = {255, 0, 0, 255};
+  const std::uint8_t green[4] = {0, 255, 0, 255};
+  renderer->UpdateTextureArray(array, format, glm::ivec3(0, 0, 0),
+                               glm::ivec2(1, 1), red);
+  renderer->UpdateTextureArray(array, format, glm::ivec3(0, 0, 1),
+                               glm::ivec2(1, 1), green);
+
+  // Left half from layer 1, right half from layer 0, in clip space
+  SpriteBatch batch;
+  batch.Begin();
+  Sprite sprite;
+  sprite.size = glm::vec2(1.0f, 2.0f);
+  sprite.texture = array;
+  sprite.position = glm::vec2(-0.5f, 0.0f);
+  sprite.texture_layer = 1;
+  batch.Draw(sprite);
+  sprite.position = glm::vec2(0.5f, 0.0f);
+  sprite.texture_layer = 0;
+  batch.Draw(sprite);
+  batch.End();
+
+  renderer->Clear(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+  renderer->DrawSprites(batch, glm::mat4(1.0f), ShaderPrograms::SPRITE);
+  const auto pixels = ReadBackbuffer(*renderer);
+  ASSERT_EQ(pixels.size(), static_cast<std::size_t>(kSize * kSize * 4));
+  EXPECT_EQ(Pixel(pixels, kSize / 4, kSize / 2),
+            (std::vector<std::uint8_t>{0, 255, 0, 255}));
+  EXPECT_EQ(Pixel(pixels, kSize * 3 / 4, kSize / 2),
+            (std::vector<std::uint8_t>{255, 0, 0, 255}));
+}
+
+TEST(VulkanRenderer, DrawText) {
+  if (!VulkanDevice::HasDevice()) {
+    GTEST_SKIP() << "No Vulkan 1.3 device";
+  }
+  const auto renderer = MakeRenderer(1);
+  // A distance field rising left to right, crossing the edge in the middle
+  const PixelFormat format{GL_RED, GL_RED};
+  const unsigned int array = renderer->CreateTextureArray(
+      ShaderPrograms::TEXT, format, glm::ivec3(4, 1, 1), 1,
+      TextureWrap::CLAMP);
+  ASSERT_NE(array, 0u);
+  const std::uint8_t distances[4] = {0, 85, 170, 255};
+  renderer->UpdateTextureArray(array, format, glm::ivec3(0, 0, 0),
+                               glm::ivec2(4, 1), distances);
+
+  SpriteBatch batch;
+  batch.Begin();
+  Sprite glyph;
+  glyph.size = glm::vec2(2.0f, 2.0f);
+  glyph.texture = array;
+  glyph.color = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+  batch.Draw(glyph);
+  batch.End();
+
+  renderer->Clear(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+  renderer->DrawSprites(batch, glm::mat4(1.0f), ShaderPrograms::TEXT);
+  const auto pixels = ReadBackbuffer(*renderer);
+  ASSERT_EQ(pixels.size(), static_cast<std::size_t>(kSize * kSize * 4));
+  EXPECT_EQ(Pixel(pixels, kSize * 3 / 10, kSize / 2),
+            (std::vector<std::uint8_t>{0, 0, 0, 255}));
+  EXPECT_EQ(Pixel(pixels, kSize * 7 / 10, kSize / 2),
+            (std::vector<std::uint8_t>{0, 0, 255, 255}));
+}
@@ -0,0 +1,289 @@
+/******************************************************************************
+ * FontBaker.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+/**
+ * Build-time baker for the fonts embedded in the text renderer.
+ *
+ * Usage:
+ *   FontBaker --output <file> [--pixel-size <px>] [--field-size <texels>]
+ *             [--spread <texels>] [--supersample <n>] [--page-size <texels>]
+ *             [--cell-size <texels>] [--pages <n>]
+ *             [--range <first>-<last>]... <font>
+ *
+ * Rasterizes the code points of every range (printable ASCII and Latin-1 by
+ * default) into distance fields with the same GlyphRasterizer the text
+ * renderer pages glyphs in with, places them in GlyphAtlas cells and writes
+ * the metrics, kerning pairs and atlas layers as a BakedFont.  The defaults
+ * match the atlas geometry TextRenderer expects.
+ */
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "2D/BakedFont.hpp"
+#include "2D/GlyphAtlas.hpp"
+#include "2D/GlyphRasterizer.hpp"
+#include "3D/MipmapGenerator.hpp"
+
+using game_engine::_2D::BakedFont;
+using game_engine::_2D::BakedFontHeader;
+using game_engine::_2D::BakedGlyph;
+using game_engine::_2D::BakedKerning;
+using game_engine::_2D::GlyphAtlas;
+using game_engine::_2D::GlyphRasterizer;
+using game_engine::_3D::MipChain;
+using game_engine::_3D::MipmapGenerator;
+using game_engine::_3D::MipmapOptions;
+using game_engine::_2D::RasterizedGlyph;
+using game_engine::_2D::SdfOptions;
+
+namespace {
+
+int Usage() {
+  std::cerr << "Usage: FontBaker --output <file> [--pixel-size <px>] "
+               "[--field-size <texels>] [--spread <texels>] "
+               "[--supersample <n>] [--page-size <texels>] "
+               "[--cell-size <texels>] [--pages <n>] "
+               "[--range <first>-<last>]... <font>"
+            << std::endl;
+  return EXIT_FAILURE;
+}
+
+/**
+ * @brief Kerning of every pair of baked glyphs from the font's kern table
+ */
+std::vector<BakedKerning> ReadKerning(const std::string& font_path,
+                                      const std::vector<char32_t>& code_points,
+                                      const unsigned int pixel_size) {
+  std::vector<BakedKerning> kerning;
+  FT_Library library;
+  FT_Face face;
+  if (FT_Init_FreeType(&library) != 0) {
+    return kerning;
+  }
+  if (FT_New_Face(library, font_path.c_str(), 0, &face) == 0) {
+    if (FT_HAS_KERNING(face)) {
+      const float to_text = static_cast<float>(pixel_size) /
+                            static_cast<float>(face->units_per_EM);
+      for (const char32_t left : code_points) {
+        const FT_UInt left_index = FT_Get_Char_Index(face, left);
+        for (const char32_t right : code_points) {
+          const FT_UInt right_index = FT_Get_Char_Index(face, right);
+          FT_Vector offset;
+          if (FT_Get_Kerning(face, left_index, right_index,
+                             FT_KERNING_UNSCALED, &offset) == 0 &&
+              offset.x != 0) {
+            kerning.push_back(
+                {left, right, static_cast<float>(offset.x) * to_text});
+          }
+        }
+      }
+    }
+    FT_Done_Face(face);
+  }
+  FT_Done_FreeType(library);
+  return kerning;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::string output;
+  std::string font_path;
+  unsigned int pixel_size = 48;
+  unsigned int field_size = 32;
+  SdfOptions options{4, 4};
+  int page_size = 1024;
+  int cell_size = 48;
+  int page_count = 2;
+  std::vector<std::pair<char32_t, char32_t>> ranges;
+
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    const bool has_value = (i + 1 < argc);
+    if (arg == "--output" && has_value) {
+      output = argv[++i];
+    } else if (arg == "--pixel-size" && has_value) {
+      pixel_size = static_cast<unsigned int>(std::stoul(argv[++i]));
+    } else if (arg == "--field-size" && has_value) {
+      field_size = static_cast<unsigned int>(std::stoul(argv[++i]));
+    } else if (arg == "--spread" && has_value) {
+      options.spread = std::stoi(argv[++i]);
+    } else if (arg == "--supersample" && has_value) {
+      options.supersample = std::stoi(argv[++i]);
+    } else if (arg == "--page-size" && has_value) {
+      page_size = std::stoi(argv[++i]);
+    } else if (arg == "--cell-size" && has_value) {
+      cell_size = std::stoi(argv[++i]);
+    } else if (arg == "--pages" && has_value) {
+      page_count = std::stoi(argv[++i]);
+    } else if (arg == "--range" && has_value) {
+      const std::string range = argv[++i];
+      const auto dash = range.find('-');
+      if (dash == std::string::npos) {
+        std::cerr << "Invalid range " << range << std::endl;
+        return Usage();
+      }
+      ranges.emplace_back(std::stoul(range.substr(0, dash), nullptr, 0),
+                          std::stoul(range.substr(dash + 1), nullptr, 0));
+    } else if (arg.rfind("--", 0) == 0 || !font_path.empty()) {
+      return Usage();
+    } else {
+      font_path = arg;
+    }
+  }
+  if (output.empty() || font_path.empty()) {
+    return Usage();
+  }
+  if (ranges.empty()) {
+    ranges = {{0x20, 0x7E}, {0xA0, 0xFF}};
+  }
+
+  GlyphRasterizer rasterizer;
+  if (!rasterizer.Start(font_path, pixel_size, field_size, options)) {
+    std::cerr << "Cannot load " << font_path << std::endl;
+    return EXIT_FAILURE;
+  }
+  rasterizer.Request(GlyphRasterizer::kFallback);
+  for (const auto& [first, last] : ranges) {
+    for (char32_t c = first; c <= last; c++) {
+      rasterizer.Request(c);
+    }
+  }
+  rasterizer.Wait();
+  const std::vector<RasterizedGlyph> rasterized = rasterizer.Collect();
+  rasterizer.Stop();
+
+  GlyphAtlas atlas(glm::ivec2(page_size, page_size), cell_size, page_count);
+  const std::size_t page_bytes =
+      static_cast<std::size_t>(page_size) * static_cast<std::size_t>(page_size);
+  std::vector<std::uint8_t> pixels(page_bytes * page_count);
+  std::vector<BakedGlyph> glyphs;
+  std::vector<char32_t> code_points;
+  int baked_pages = 0;
+  int baked_height = 0;
+  for (const RasterizedGlyph& glyph : rasterized) {
+    // Code points the font lacks are drawn with the fallback at runtime
+    if (!glyph.found) {
+      continue;
+    }
+    BakedGlyph baked;
+    baked.code_point = static_cast<std::uint32_t>(glyph.code_point);
+    baked.field_size = {glyph.field.size.x, glyph.field.size.y};
+    baked.size = {glyph.size.x, glyph.size.y};
+    baked.bearing = {glyph.bearing.x, glyph.bearing.y};
+    baked.advance = glyph.advance;
+    if (glyph.field.size.x > cell_size || glyph.field.size.y > cell_size) {
+      std::cerr << "Glyph U+" << std::hex
+                << static_cast<std::uint32_t>(glyph.code_point) << std::dec
+                << " does not fit in a " << cell_size << " texel cell"
+                << std::endl;
+      continue;
+    }
+    if (!glyph.field.pixels.empty()) {
+      const auto allocation = atlas.Allocate(glyph.code_point, true);
+      if (!allocation) {
+        std::cerr << "The glyphs do not fit in " << page_count << " pages"
+                  << std::endl;
+        return EXIT_FAILURE;
+      }
+      baked.slot = allocation->slot;
+      const auto region = atlas.GetRegion(allocation->slot, glyph.field.size);
+      if (region.layer + 1 > baked_pages) {
+        baked_pages = region.layer + 1;
+        baked_height = 0;
+      }
+      baked_height = std::max(baked_height, region.position.y + cell_size);
+      std::uint8_t* origin = pixels.data() + page_bytes * region.layer +
+                             region.position.y * page_size + region.position.x;
+      for (int y = 0; y < region.size.y; y++) {
+        std::copy_n(glyph.field.pixels.data() + y * region.size.x,
+                    region.size.x, origin + y * page_size);
+      }
+    }
+    glyphs.push_back(baked);
+    if (glyph.code_point != GlyphRasterizer::kFallback) {
+      code_points.push_back(glyph.code_point);
+    }
+  }
+
+  // Mip levels are baked too, so the text renderer never filters them at
+  // runtime.  Each layer is filtered as a whole, which matches filtering
+  // each cell as long as the cells stay texel aligned.
+  MipmapOptions mip_options;
+  mip_options.max_levels = atlas.GetMipLevels();
+  const MipmapGenerator generator(mip_options);
+  std::vector<MipChain> chains;
+  for (int layer = 0; layer < baked_pages; layer++) {
+    chains.push_back(generator.Generate(glm::ivec2(page_size), 1,
+                                        pixels.data() + page_bytes * layer));
+  }
+  std::vector<std::uint8_t> levels;
+  for (int level = 0; level < mip_options.max_levels; level++) {
+    for (int layer = 0; layer < baked_pages; layer++) {
+      const std::vector<std::uint8_t>& level_pixels =
+          chains[layer].levels[level].pixels;
+      const int rows = (layer + 1 == baked_pages) ? baked_height : page_size;
+      const std::size_t bytes = static_cast<std::size_t>(rows >> level) *
+                                static_cast<std::size_t>(page_size >> level);
+      levels.insert(levels.end(), level_pixels.begin(),
+                    level_pixels.begin() + bytes);
+    }
+  }
+
+  BakedFontHeader header;
+  header.pixel_size = pixel_size;
+  header.field_size = field_size;
+  header.spread = options.spread;
+  header.supersample = options.supersample;
+  header.page_width = page_size;
+  header.page_height = page_size;
+  header.cell_size = cell_size;
+  header.mip_levels = mip_options.max_levels;
+  header.page_count = static_cast<std::uint32_t>(page_count);
+  header.baked_page_count = static_cast<std::uint32_t>(baked_pages);
+  header.baked_height = baked_height;
+  const std::vector<BakedKerning> kerning =
+      ReadKerning(font_path, code_points, pixel_size);
+
+  std::ofstream file(output, std::ios::binary | std::ios::trunc);
+  const std::string data =
+      BakedFont::Write(header, glyphs, kerning, levels.data());
+  file.write(data.data(), static_cast<std::streamsize>(data.size()));
+  if (!file) {
+    std::cerr << "Cannot write " << output << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "Baked " << glyphs.size() << " glyphs, " << kerning.size()
+            << " kerning pairs and " << baked_pages << " atlas pages into "
+            << output << std::endl;
+  return EXIT_SUCCESS;
+}
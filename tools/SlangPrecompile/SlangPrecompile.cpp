@@ -0,0 +1,148 @@
+/******************************************************************************
+ * SlangPrecompile.cpp
+ * Copyright (C) 2020  Mel McCalla <melmccalla@gmail.com>
+ *
+ * This file is part of GameEngine.
+ *
+ * GameEngine is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GameEngine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GameEngine.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+/**
+ * Build-time precompiler for the Slang shader cache.
+ *
+ * Usage:
+ *   SlangPrecompile --output <dir> [--profile <profile>] [--include <dir>]...
+ *                   [--entry <name>:<vertex|fragment|geometry|compute>]...
+ *                   <file.slang>...
+ *
+ * Entry points default to vertexMain, fragmentMain and geometryMain, which is
+ * what SlangShaderProgram requests at runtime.  Imported modules take part in
+ * the cache key, so include directories default to the
+ * GAME_ENGINE_SLANG_SEARCH_PATHS the runtime searches, and any given instead
+ * must resolve imports to the same files.
+ */
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "GL/SlangCompiler.hpp"
+#include "GL/SlangShaderCache.hpp"
+
+using game_engine::gl::SlangCompileInput;
+using game_engine::gl::SlangCompiler;
+using game_engine::gl::SlangEntryPoint;
+using game_engine::gl::SlangShaderCache;
+using game_engine::gl::SlangShaderStage;
+
+namespace {
+
+std::optional<SlangShaderStage> ParseStage(const std::string& stage) {
+  if (stage == "vertex") {
+    return SlangShaderStage::VERTEX;
+  } else if (stage == "fragment") {
+    return SlangShaderStage::FRAGMENT;
+  } else if (stage == "geometry") {
+    return SlangShaderStage::GEOMETRY;
+  } else if (stage == "compute") {
+    return SlangShaderStage::COMPUTE;
+  }
+  return std::nullopt;
+}
+
+int Usage() {
+  std::cerr << "Usage: SlangPrecompile --output <dir> [--profile <profile>] "
+               "[--include <dir>]... [--entry <name>:<stage>]... "
+               "<file.slang>..."
+            << std::endl;
+  return EXIT_FAILURE;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::filesystem::path output;
+  std::string profile = "glsl_460";
+  std::vector<std::filesystem::path> search_paths;
+  std::vector<SlangEntryPoint> entry_points;
+  std::vector<std::filesystem::path> inputs;
+
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    const bool has_value = (i + 1 < argc);
+    if (arg == "--output" && has_value) {
+      output = argv[++i];
+    } else if (arg == "--profile" && has_value) {
+      profile = argv[++i];
+    } else if (arg == "--include" && has_value) {
+      search_paths.emplace_back(argv[++i]);
+    } else if (arg == "--entry" && has_value) {
+      const std::string entry = argv[++i];
+      const auto colon = entry.find(':');
+      const auto stage = (colon == std::string::npos)
+                             ? std::nullopt
+                             : ParseStage(entry.substr(colon + 1));
+      if (!stage) {
+        std::cerr << "Invalid entry point " << entry << std::endl;
+        return Usage();
+      }
+      entry_points.push_back({entry.substr(0, colon), *stage});
+    } else if (arg.rfind("--", 0) == 0) {
+      return Usage();
+    } else {
+      inputs.emplace_back(arg);
+    }
+  }
+  if (output.empty()) {
+    return Usage();
+  }
+  if (search_paths.empty()) {
+    search_paths = SlangShaderCache::DefaultSearchPaths();
+  }
+  if (entry_points.empty()) {
+    entry_points = {{"vertexMain", SlangShaderStage::VERTEX},
+                    {"fragmentMain", SlangShaderStage::FRAGMENT},
+                    {"geometryMain", SlangShaderStage::GEOMETRY}};
+  }
+
+  const SlangShaderCache cache(output);
+  const SlangCompiler compiler;
+  int result = EXIT_SUCCESS;
+  for (const auto& path : inputs) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+      std::cerr << "Cannot open " << path << std::endl;
+      result = EXIT_FAILURE;
+      continue;
+    }
+    SlangCompileInput input;
+    input.name = path.filename().string();
+    input.source = std::string(std::istreambuf_iterator<char>(file),
+                               std::istreambuf_iterator<char>());
+    input.search_paths = search_paths;
+    input.entry_points = entry_points;
+    input.profile = profile;
+
+    if (!compiler.Compile(input, cache)) {
+      std::cerr << "Failed to compile " << path << std::endl;
+      result = EXIT_FAILURE;
+    }
+  }
+  return result;
+}